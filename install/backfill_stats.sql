@@ -0,0 +1,22 @@
+-- ### FILL TABLE dataGroupStats FOR AN EXISTING DATABASE
+-- Data groups saved before table dataGroupStats existed have no statistics, which means
+-- searches have to scan their samples. Run this once after makedb.sql has created the table:
+--    mysql -u root -p < backfill_stats.sql
+-- Groups which already have statistics are left alone, so it can be run again any time.
+-- Groups saved to dataChunks only get N, bounds and rate, since their samples are compressed.
+
+use mavlog_database;
+
+INSERT INTO dataGroupStats (DATAGROUP_ID,N,VALUE_MIN,VALUE_MAX,VALUE_AVG,VALUE_STDDEV,TIME_MIN,TIME_MAX,RATE)
+SELECT d.DATAGROUP_ID, COUNT(*), MIN(d.VALUE), MAX(d.VALUE), AVG(d.VALUE), STDDEV_POP(d.VALUE), MIN(d.TIME), MAX(d.TIME),
+       IF(COUNT(*) > 1 AND MAX(d.TIME) > MIN(d.TIME), (COUNT(*) - 1) / (MAX(d.TIME) - MIN(d.TIME)), NULL)
+FROM data d
+WHERE d.DATAGROUP_ID NOT IN (SELECT DATAGROUP_ID FROM dataGroupStats)
+GROUP BY d.DATAGROUP_ID;
+
+INSERT INTO dataGroupStats (DATAGROUP_ID,N,VALUE_MIN,VALUE_MAX,VALUE_AVG,VALUE_STDDEV,TIME_MIN,TIME_MAX,RATE)
+SELECT c.DATAGROUP_ID, SUM(c.N), MIN(c.VALUE_MIN), MAX(c.VALUE_MAX), NULL, NULL, MIN(c.TIME_MIN), MAX(c.TIME_MAX),
+       IF(SUM(c.N) > 1 AND MAX(c.TIME_MAX) > MIN(c.TIME_MIN), (SUM(c.N) - 1) / (MAX(c.TIME_MAX) - MIN(c.TIME_MIN)), NULL)
+FROM dataChunks c
+WHERE c.DATAGROUP_ID NOT IN (SELECT DATAGROUP_ID FROM dataGroupStats)
+GROUP BY c.DATAGROUP_ID;
@@ -16,6 +16,15 @@ DESCRIPTION longtext,
 FILENAME text(1024)
 );
 
+-- table 'scenarioFingerprints': content fingerprint of each log file a scenario was made from.
+-- Saving a scenario made from the same files again updates that one instead of storing a copy.
+create table if not exists scenarioFingerprints (
+SCENARIO_ID INTEGER UNSIGNED,
+FINGERPRINT CHAR(40),
+INDEX (SCENARIO_ID),
+INDEX (FINGERPRINT)
+);
+
 -- table 'systems'
 create table if not exists systems (
 ID Integer UNSIGNED PRIMARY KEY AUTO_INCREMENT, 
@@ -31,7 +40,8 @@ TIME_VALID TINYINT,
 TIME_MIN DOUBLE,
 TIME_MAX DOUBLE,
 TIME_OFFSET_USEC BIGINT,
-TIME_OFFSET_GUESS_USEC BIGINT
+TIME_OFFSET_GUESS_USEC BIGINT,
+INDEX (SCENARIO_ID)
 );
 
 -- table 'dataGroups'
@@ -44,7 +54,9 @@ FULLPATH text(1024),
 CLASSIFIER INT,
 TIME_EPOCH_DATASTART BIGINT UNSIGNED,
 UNITS CHAR(254),
-TYPE CHAR(254)
+TYPE CHAR(254),
+INDEX (SYSTEM_ID),
+INDEX (FULLPATH(255))
 );
 
 -- table 'data'
@@ -52,7 +64,57 @@ create table if not exists data (
 ID Integer UNSIGNED PRIMARY KEY AUTO_INCREMENT,
 DATAGROUP_ID INTEGER UNSIGNED,
 TIME DOUBLE,
-VALUE DOUBLE
+VALUE DOUBLE,
+INDEX (DATAGROUP_ID, TIME)
+);
+
+-- table 'dataChunks': same as 'data', but up to 64k samples per row. TIMES and VALS are
+-- zlib-compressed (qCompress) arrays of doubles. If this table exists, samples are saved here.
+-- Older groups stay in 'data', so anything reading samples has to look in both tables.
+create table if not exists dataChunks (
+ID Integer UNSIGNED PRIMARY KEY AUTO_INCREMENT,
+DATAGROUP_ID INTEGER UNSIGNED,
+SEQ INTEGER UNSIGNED,
+N INTEGER UNSIGNED,
+TIME_MIN DOUBLE,
+TIME_MAX DOUBLE,
+VALUE_MIN DOUBLE,
+VALUE_MAX DOUBLE,
+TIMES LONGBLOB,
+VALS LONGBLOB,
+INDEX (DATAGROUP_ID, SEQ)
+);
+
+-- table 'dataOverview': about 2000 samples of each numeric data group, the min and max of each
+-- bucket of samples, in the format of 'dataChunks'. The GUI plots them first and fetches all
+-- samples only for the part the user zooms into. Groups with few samples have none.
+create table if not exists dataOverview (
+DATAGROUP_ID INTEGER UNSIGNED PRIMARY KEY,
+N INTEGER UNSIGNED,
+TIMES LONGBLOB,
+VALS LONGBLOB
+);
+
+-- table 'dataGroupStats': statistics of each data group, written when it is saved. Searches use
+-- them to skip groups without scanning their samples. Fill it for older archives with backfill_stats.sql.
+create table if not exists dataGroupStats (
+DATAGROUP_ID INTEGER UNSIGNED PRIMARY KEY,
+N INTEGER UNSIGNED,
+VALUE_MIN DOUBLE,
+VALUE_MAX DOUBLE,
+VALUE_AVG DOUBLE,
+VALUE_STDDEV DOUBLE,
+TIME_MIN DOUBLE,
+TIME_MAX DOUBLE,
+RATE DOUBLE
+);
+
+-- table 'dataGroupHashes': content hash of each data group, written when it is saved. Saving
+-- a scenario again compares them and writes only the groups which changed.
+create table if not exists dataGroupHashes (
+DATAGROUP_ID INTEGER UNSIGNED PRIMARY KEY,
+N INTEGER UNSIGNED,
+HASH CHAR(32)
 );
 
 -- table 'events'
@@ -0,0 +1,10 @@
+-- ### ADD INDEXES TO AN EXISTING DATABASE
+-- Databases made with makedb.sql before the indexes were added there scan whole tables
+-- when loading data groups. Run this once: mysql -u root -p < migrate_indexes.sql
+-- (it fails with "Duplicate key name" if an index is there already).
+
+use mavlog_database;
+
+ALTER TABLE systems ADD INDEX SCENARIO_ID (SCENARIO_ID);
+ALTER TABLE dataGroups ADD INDEX SYSTEM_ID (SYSTEM_ID), ADD INDEX FULLPATH (FULLPATH(255));
+ALTER TABLE data ADD INDEX DATAGROUP_ID (DATAGROUP_ID, TIME);
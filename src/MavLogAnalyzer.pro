@@ -34,13 +34,20 @@ win32 {
 #message("Qwt installation expected at" $$QWT_INSTALLPATH)
 
 ############# HANDS AWAY FROM HERE ###############
-QT       += core gui sql
+QT       += core gui sql network
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets printsupport # because Qt5+ has it in modules now
+# live telemetry from serial ports, if there (see livesource.h)
+greaterThan(QT_MAJOR_VERSION, 4): qtHaveModule(serialport) {
+    QT += serialport
+    DEFINES += WITH_SERIALPORT
+}
 
 # save us trouble with installing the correct version of Qt and Qwt
 CONFIG+=release_and_debug
 CONFIG+=warn_on
 CONFIG+=static
+# 64-bit off_t for fseeko() on 32-bit systems, see fileSeek()
+unix: DEFINES += _FILE_OFFSET_BITS=64
 
 ###########################
 #    GENERAL
@@ -70,7 +77,9 @@ LIBS+= -L $$QWT_LIBPATH
 ###########################
 QMAKE_CXXFLAGS += -Wall -fpermissive -DWITH_DATAREGEX
 QMAKE_CXXFLAGS_RELEASE += -O3
+#QMAKE_CXXFLAGS += -mavx2 # vec_fun.cpp uses AVX2 then, otherwise SSE2 (or scalar code off x86)
 QMAKE_CXXFLAGS_DEBUG += -O0
+# for a timeline of any build, see --trace (Tracer in profiler.h)
 #QMAKE_CXXFLAGS_DEBUG += -pg -p
 #QMAKE_LFLAGS_DEBUG += -pg
 #QMAKE_CXXFLAGS += -Werror
@@ -88,20 +97,27 @@ SOURCES += main.cpp\
     data.cpp \
     datatreeviewmodel.cpp \
     treeitem.cpp \
+    arena.cpp \
+    spillfile.cpp \
+    scenariocache.cpp \
     mavplot.cpp \
     filefun.cpp \
     dialogdatadetails.cpp \
     time_fun.cpp \
+    vec_fun.cpp \
     mavlinkscenario.cpp \
     dialogprogressbar.cpp \
     onboardlogparser_apm.cpp \
     onboarddata.cpp \
     logger.cpp \
     dialogstats.cpp \
+    dialogfleet.cpp \
     dialogscenarioprops.cpp \
     dialogdbsettings.cpp \
     filterwindow.cpp \
     dbconnector.cpp \
+    dbbackend.cpp \
+    dbworker.cpp \
     dialogselectscenario.cpp \
     mavplotdataitemmodel.cpp \
     dialogdatatable.cpp \
@@ -109,7 +125,28 @@ SOURCES += main.cpp\
     onboardlogparser_px4.cpp \
     onboardlogparser.cpp \
     onboardlogparser_ulg.cpp \
-    onboardlogparserfactory.cpp
+    onboardlogparserfactory.cpp \
+    fileimporter.cpp \
+    topicfilter.cpp \
+    pathtable.cpp \
+    eventdict.cpp \
+    mavplotcurve.cpp \
+    mavplotoverview.cpp \
+    mavplotrenderer.cpp \
+    mavplotevents.cpp \
+    datatablemodel.cpp \
+    pathsearch.cpp \
+    csvwriter.cpp \
+    dataexport.cpp \
+    profiler.cpp \
+    batchrunner.cpp \
+    logprescan.cpp \
+    livesource.cpp \
+    resampler.cpp \
+    expression.cpp \
+    conditionsearch.cpp \
+    taskpool.cpp \
+    statscache.cpp
 
 # add CSV parser
 SOURCES += csv_parser/csv_parser.cpp
@@ -120,11 +157,17 @@ HEADERS  += mainwindow.h \
     mavsystem.h \
     SystemTableviewModel.h \
     data_timeseries.h \
+    data_cursor.h \
+    data_window.h \
+    data_compressed.h \
     data.h \
     datagroup.h \
     stringfun.h \
     datatreeviewmodel.h \
     treeitem.h \
+    arena.h \
+    spillfile.h \
+    scenariocache.h \
     mavplot.h \
     Zoomer.h \
     Panner.h \
@@ -134,6 +177,7 @@ HEADERS  += mainwindow.h \
     data_param.h \
     config.h \
     time_fun.h \
+    vec_fun.h \
     mavlinkscenario.h \
     dialogprogressbar.h \
     qwt_compat.h \
@@ -142,10 +186,13 @@ HEADERS  += mainwindow.h \
     mavsystem_macros.h \
     logger.h \
     dialogstats.h \
+    dialogfleet.h \
     dialogscenarioprops.h \
     dialogdbsettings.h \
     filterwindow.h \
     dbconnector.h \
+    dbbackend.h \
+    dbworker.h \
     debugtype.h \
     dialogselectscenario.h \
     mavplotdataitemmodel.h \
@@ -157,7 +204,31 @@ HEADERS  += mainwindow.h \
     data_untimed.h \
     onboardlogparserfactory.h \
     onboardlogparser.h \
-    onboardlogparser_ulg.h
+    onboardlogparser_ulg.h \
+    fileimporter.h \
+    spscring.h \
+    mpscring.h \
+    topicfilter.h \
+    pathtable.h \
+    eventdict.h \
+    mavplotcurve.h \
+    mavplotoverview.h \
+    mavplotrenderer.h \
+    mavplotevents.h \
+    datatablemodel.h \
+    pathsearch.h \
+    csvwriter.h \
+    dataexport.h \
+    profiler.h \
+    memuse.h \
+    batchrunner.h \
+    logprescan.h \
+    livesource.h \
+    resampler.h \
+    expression.h \
+    conditionsearch.h \
+    taskpool.h \
+    statscache.h
 
 FORMS    += mainwindow.ui \
 	filterwindow.ui
@@ -0,0 +1,52 @@
+/**
+ * @file arena.cpp
+ * @brief Bump allocator for many small objects which are freed all at once.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <new>
+#include "arena.h"
+
+void* Arena::alloc(size_t n) {
+    n = (n + ALIGN - 1) & ~((size_t)ALIGN - 1);
+    if (n > CHUNK_SIZE / 4) {
+        // would waste too much of a chunk
+        char*const p = new char[n];
+        _big.push_back(p);
+        _big_bytes += n;
+        return p;
+    }
+    if (_used + n > CHUNK_SIZE) {
+        _chunks.push_back(new char[CHUNK_SIZE]); // operator new[] memory is aligned for any type
+        _used = 0;
+    }
+    char*const p = _chunks.back() + _used;
+    _used += n;
+    return p;
+}
+
+void Arena::clear(void) {
+    for (std::vector<char*>::iterator it = _chunks.begin(); it != _chunks.end(); ++it) delete[] *it;
+    for (std::vector<char*>::iterator it = _big.begin(); it != _big.end(); ++it) delete[] *it;
+    std::vector<char*>().swap(_chunks);
+    std::vector<char*>().swap(_big);
+    _used = CHUNK_SIZE;
+    _big_bytes = 0;
+}
@@ -0,0 +1,74 @@
+/**
+ * @file arena.h
+ * @brief Bump allocator for many small objects which are freed all at once.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <vector>
+#include <stddef.h>
+
+/**
+ * @brief Hands out memory from big chunks. Single objects are never given back,
+ * clear() frees everything at once. Not thread-safe, the owner has to lock.
+ *
+ * Objects derived from TreeItem (Data, DataGroup) can be placed in here with
+ * `new (arena) T(...)`; see treeitem.h. They can still be deleted as usual, which
+ * runs their destructor, but their memory stays until clear().
+ */
+class Arena
+{
+public:
+    enum { CHUNK_SIZE = 64*1024, ALIGN = 16 };
+
+    Arena() : _used(CHUNK_SIZE), _big_bytes(0) {}
+    ~Arena() { clear(); }
+
+    /**
+     * @return memory for n bytes, aligned to ALIGN
+     */
+    void* alloc(size_t n);
+
+    /**
+     * @brief free all memory. Whatever was in there must have been destroyed before.
+     */
+    void clear(void);
+
+    /**
+     * @return bytes taken from the system
+     */
+    size_t get_bytes(void) const { return _chunks.size()*CHUNK_SIZE + _big_bytes; }
+
+private:
+    Arena(const Arena&);
+    Arena& operator=(const Arena&);
+
+    /****************************************
+     *     DATA MEMBERS
+     ****************************************/
+    std::vector<char*> _chunks;    ///< last one is the current one
+    size_t             _used;      ///< bytes used in current chunk
+    std::vector<char*> _big;       ///< allocations larger than a chunk
+    size_t             _big_bytes;
+};
+
+#endif // ARENA_H
@@ -0,0 +1,219 @@
+/**
+ * @file batchrunner.cpp
+ * @brief Headless processing of many log files, each one on its own, by a pool of workers.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <QRunnable>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QRegExp>
+#include <QSettings>
+#include "batchrunner.h"
+#include "fileimporter.h"
+#include "onboardlogparserfactory.h"
+#include "dataexport.h"
+#include "filefun.h"
+#include "logger.h"
+#include "profiler.h"
+#include "taskpool.h"
+
+using namespace std;
+
+#define BATCH_SUMMARY_SUFFIX ".summary.txt"
+#define BATCH_EXPORT_SUFFIX ".mlc"
+
+/**
+ * @brief imports one file of the batch in a worker, writes its results and frees it again
+ */
+class BatchJob : public QRunnable {
+public:
+    BatchJob(BatchRunner*runner, const std::string & fullpath, const std::string & prefix) :
+        _runner(runner), _fullpath(fullpath), _prefix(prefix) {}
+
+    void run(void) {
+        const unsigned long long t0 = Profiler::now_nsec();
+        const CmdlineArgs*const args = _runner->_args;
+        FileImporter imp(_fullpath, args);
+        imp.run();
+        if (!imp.is_parsed()) {
+            _runner->_report("FAILED " + _fullpath + ": " + imp.get_error(), true);
+            return;
+        }
+        const std::vector<MavlinkScenario*> & scenes = imp.get_scenarios();
+        stringstream msg;
+        bool ok = true;
+        const string jumps = imp.get_timejump_summary();
+        if (!jumps.empty()) msg << "; " << jumps;
+
+        // summary
+        const string sumfile = _prefix + BATCH_SUMMARY_SUFFIX;
+        ofstream fsum(sumfile.c_str());
+        for (std::vector<MavlinkScenario*>::const_iterator it = scenes.begin(); it != scenes.end(); ++it) {
+            (*it)->dump_overview(fsum);
+        }
+        fsum.close();
+        if (!fsum.good()) {
+            msg << "; cannot write " << sumfile;
+            ok = false;
+        }
+
+        // export
+        if (args->batch_export) {
+            for (unsigned int k = 0; k < scenes.size(); ++k) {
+                stringstream ss;
+                ss << _prefix;
+                if (k > 0) ss << "_" << (k + 1);
+                ss << BATCH_EXPORT_SUFFIX;
+                if (0 == DataExport::columnar(scenes[k], ss.str())) {
+                    msg << "; cannot export to " << ss.str();
+                    ok = false;
+                }
+            }
+        }
+
+        // database. Pooled connection of this worker thread, which is kept for its next file.
+        if (args->batch_db) {
+            DBConnector con(_runner->_dbprops);
+            for (std::vector<MavlinkScenario*>::const_iterator it = scenes.begin(); it != scenes.end(); ++it) {
+                if (!con.saveScenarioToDB(*it, NULL, DBConnector::SIMILAR_UPDATE)) {
+                    msg << "; cannot save " << (*it)->getName() << " to DB";
+                    ok = false;
+                }
+            }
+        }
+
+        stringstream line;
+        line << (ok ? "ok     " : "FAILED ") << _fullpath << ": " << scenes.size() << " scenario(s), "
+             << fixed << setprecision(1) << (Profiler::now_nsec() - t0) * 1E-9 << " s" << msg.str();
+        _runner->_report(line.str(), !ok);
+    }
+
+private:
+    BatchRunner*      _runner;
+    const std::string _fullpath;
+    const std::string _prefix;
+};
+
+BatchRunner::BatchRunner(const CmdlineArgs*const args) : _args(args), _n_done(0), _n_failed(0) {
+    if (_args->batch_db) {
+        // same as the GUI uses
+        QSettings settings("DE.TUM.EI.RCS", "MavLogAnalyzer");
+        settings.beginGroup("database");
+        _dbprops.dbhost = settings.value("host", QVariant("localhost")).toString().toStdString();
+        _dbprops.dbname = settings.value("database", QVariant("mavlog_database")).toString().toStdString();
+        _dbprops.username = settings.value("user", QVariant("mavlog_user")).toString().toStdString();
+        _dbprops.password= settings.value("pass", QVariant("mavlog_password")).toString().toStdString();
+        _dbprops.backend = settings.value("backend", QVariant(DB_BACKEND_MYSQL)).toString().toStdString();
+        settings.endGroup();
+    }
+}
+
+bool BatchRunner::is_supported(const std::string & filename) {
+    string ext = getExtension(filename);
+    ext = lcase(ext);
+    if (ext.compare("tlog") == 0 || ext.compare("mavlink") == 0) return true;
+    return OnboardLogParserFactory::Instance().Supports(ext);
+}
+
+unsigned int BatchRunner::add_input(const std::string & path) {
+    const unsigned int before = _files.size();
+    const QString qpath = QString::fromStdString(path);
+    const QFileInfo info(qpath);
+
+    if (info.isDir()) {
+        // everything below, in a stable order
+        QStringList found;
+        QDirIterator it(qpath, QDir::Files, QDirIterator::Subdirectories | QDirIterator::FollowSymlinks);
+        while (it.hasNext()) {
+            const QString f = it.next();
+            if (is_supported(f.toStdString())) found.push_back(f);
+        }
+        found.sort();
+        for (int k = 0; k < found.size(); ++k) {
+            _add_file(QFileInfo(found[k]).canonicalFilePath().toStdString());
+        }
+    } else if (qpath.contains(QRegExp("[*?\\[]"))) {
+        // wildcard in the file name
+        const QDir dir = info.dir();
+        const QFileInfoList found = dir.entryInfoList(QStringList(info.fileName()), QDir::Files, QDir::Name);
+        for (int k = 0; k < found.size(); ++k) {
+            _add_file(found[k].canonicalFilePath().toStdString());
+        }
+    } else if (info.isFile()) {
+        _add_file(info.canonicalFilePath().toStdString());
+    } else {
+        cerr << "Cannot open " << path << ", ignored" << endl;
+    }
+    return _files.size() - before;
+}
+
+void BatchRunner::_add_file(const std::string & fullpath) {
+    if (fullpath.empty() || !_seen.insert(fullpath).second) return;
+
+    string prefix;
+    if (_args->batch_outdir.empty()) {
+        prefix = fullpath;
+    } else {
+        // flights in different directories often have the same file name
+        const string base = getBasename(fullpath);
+        const unsigned int n = ++_outnames[base];
+        stringstream ss;
+        ss << _args->batch_outdir << "/" << base;
+        if (n > 1) ss << "_" << n;
+        prefix = ss.str();
+    }
+    _files.push_back(fullpath);
+    _prefixes.push_back(prefix);
+}
+
+void BatchRunner::_report(const std::string & text, bool failed) {
+    QMutexLocker lock(&_mutex);
+    ++_n_done;
+    if (failed) ++_n_failed;
+    cout << "[" << _n_done << "/" << _files.size() << "] " << text << endl;
+}
+
+unsigned int BatchRunner::run(void) {
+    if (_files.empty()) return 0;
+    if (!_args->batch_outdir.empty() && !QDir().mkpath(QString::fromStdString(_args->batch_outdir))) {
+        cerr << "Cannot create " << _args->batch_outdir << endl;
+        return _files.size();
+    }
+    (void) Logger::Instance(); // make sure log model is owned by calling thread, not by a worker
+
+    TaskGroup tasks(_args->threads); // workers keep their DB connection for the next file
+    for (unsigned int k = 0; k < _files.size(); ++k) {
+        tasks.start(new BatchJob(this, _files[k], _prefixes[k])); // auto-deleted
+    }
+    while (!tasks.wait(100)) {
+        Logger::Instance().flush();
+    }
+    Logger::Instance().flush();
+
+    QMutexLocker lock(&_mutex);
+    cout << "Batch done: " << (_n_done - _n_failed) << " ok, " << _n_failed << " failed" << endl;
+    return _n_failed;
+}
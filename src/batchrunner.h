@@ -0,0 +1,93 @@
+/**
+ * @file batchrunner.h
+ * @brief Headless processing of many log files, each one on its own, by a pool of workers.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <QMutex>
+#include "cmdlineargs.h"
+#include "dbconnector.h"
+
+/**
+ * @brief Unlike the usual headless mode, which merges all files into ONE scenario, this
+ * imports each file into scenarios of its own (MavLink and all onboard logs, see FileImporter),
+ * writes the results for that file and forgets about it. Therefore only as many files are held
+ * in memory as there are workers, and thousands of flights can be run through.
+ *
+ * Results of a file, next to it or in CmdlineArgs::batch_outdir:
+ *  - <log>.summary.txt: MavlinkScenario::dump_overview() of each scenario
+ *  - <log>.mlc (CmdlineArgs::batch_export): DataExport::columnar(), "<log>_2.mlc" etc. for more scenarios
+ *  - the database (CmdlineArgs::batch_db), with the settings of the GUI. Existing scenarios are updated.
+ * The ScenarioCache is written as usual.
+ */
+class BatchRunner
+{
+public:
+    BatchRunner(const CmdlineArgs*const args);
+
+    /**
+     * @brief add one file, all logs below a directory, or those matching a wildcard like "logs/ *.ulg".
+     * Files given more than once are taken once.
+     * @return number of files added
+     */
+    unsigned int add_input(const std::string & path);
+
+    /**
+     * @brief process all files with CmdlineArgs::threads workers. Reports one line per file.
+     * @return number of files which failed
+     */
+    unsigned int run(void);
+
+    unsigned int get_num_files(void) const { return _files.size(); }
+
+    /**
+     * @return true if there is a parser for this kind of file
+     */
+    static bool is_supported(const std::string & filename);
+
+private:
+    friend class BatchJob;
+
+    void _add_file(const std::string & fullpath);
+    void _report(const std::string & text, bool failed);
+
+    /****************************************
+     *     DATA MEMBERS
+     ****************************************/
+    const CmdlineArgs*       _args;
+    DBConnector::db_props_t  _dbprops;
+    std::vector<std::string> _files;     ///< full paths, in order of add_input()
+    std::vector<std::string> _prefixes;  ///< output path of each file, without suffix
+    std::set<std::string>    _seen;
+    std::map<std::string, unsigned int> _outnames; ///< how often a name was taken in batch_outdir
+
+    QMutex       _mutex; ///< for the members below and for cout
+    unsigned int _n_done;
+    unsigned int _n_failed;
+};
+
+#endif // BATCHRUNNER_H
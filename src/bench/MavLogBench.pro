@@ -0,0 +1,80 @@
+#-------------------------------------------------
+#
+# Benchmark of parsers and scenario building, see bench.cpp.
+# Needs no Qwt and no widgets. Build next to the application:
+#   cd src/bench && qmake && make
+#
+#-------------------------------------------------
+
+###########################
+#    USER SETTINGS
+###########################
+# adjust the path to the MavLink headers, same as in ../MavLogAnalyzer.pro
+MAVLINK_COMMON=$$_PRO_FILE_PWD_/../../external/mavlink/gen/common
+
+############# HANDS AWAY FROM HERE ###############
+QT       += core gui # gui only for the QStandardItemModel behind the Logger
+QT       -= widgets
+
+CONFIG+=console
+CONFIG-=app_bundle
+CONFIG+=warn_on
+CONFIG+=release
+
+###########################
+#    GENERAL
+###########################
+TARGET = MavLogBench
+TEMPLATE = app
+
+!exists($$MAVLINK_COMMON/mavlink.h) {
+	error("MavLink files not found. Please configure project file correctly.")
+}
+
+###########################
+#    INCLUDE/LIB PATHS
+###########################
+INCLUDEPATH += .. $$MAVLINK_COMMON
+
+###########################
+#    CPPFLAGS/LFLAGS
+###########################
+QMAKE_CXXFLAGS += -Wall -fpermissive -DWITH_DATAREGEX
+QMAKE_CXXFLAGS_RELEASE += -O3
+
+SOURCES += bench.cpp \
+    ../cmdlineargs.cpp \
+    ../mavlinkparser.cpp \
+    ../mavsystem.cpp \
+    ../datagroup.cpp \
+    ../stringfun.cpp \
+    ../data.cpp \
+    ../treeitem.cpp \
+    ../arena.cpp \
+    ../spillfile.cpp \
+    ../scenariocache.cpp \
+    ../filefun.cpp \
+    ../time_fun.cpp \
+    ../vec_fun.cpp \
+    ../mavlinkscenario.cpp \
+    ../onboardlogparser_apm.cpp \
+    ../onboarddata.cpp \
+    ../logger.cpp \
+    ../logtablemodel.cpp \
+    ../onboardlogparser_px4.cpp \
+    ../onboardlogparser.cpp \
+    ../onboardlogparser_ulg.cpp \
+    ../onboardlogparserfactory.cpp \
+    ../fileimporter.cpp \
+    ../topicfilter.cpp \
+    ../pathtable.cpp \
+    ../eventdict.cpp \
+    ../csvwriter.cpp \
+    ../profiler.cpp \
+    ../taskpool.cpp \
+    ../logprescan.cpp \
+    ../resampler.cpp \
+    ../expression.cpp \
+    ../conditionsearch.cpp
+
+HEADERS += ../logtablemodel.h
@@ -0,0 +1,43 @@
+#-------------------------------------------------
+#
+# Generator of synthetic logs for scale tests, see loggen.cpp.
+# Needs only the MavLink headers. Build next to the application:
+#   cd src/bench && qmake MavLogGen.pro && make
+#
+#-------------------------------------------------
+
+###########################
+#    USER SETTINGS
+###########################
+# adjust the path to the MavLink headers, same as in ../MavLogAnalyzer.pro
+MAVLINK_COMMON=$$_PRO_FILE_PWD_/../../external/mavlink/gen/common
+
+############# HANDS AWAY FROM HERE ###############
+CONFIG-=qt
+CONFIG+=console
+CONFIG-=app_bundle
+CONFIG+=warn_on
+CONFIG+=release
+
+###########################
+#    GENERAL
+###########################
+TARGET = MavLogGen
+TEMPLATE = app
+
+!exists($$MAVLINK_COMMON/mavlink.h) {
+	error("MavLink files not found. Please configure project file correctly.")
+}
+
+###########################
+#    INCLUDE/LIB PATHS
+###########################
+INCLUDEPATH += $$MAVLINK_COMMON
+
+###########################
+#    CPPFLAGS/LFLAGS
+###########################
+QMAKE_CXXFLAGS += -Wall
+QMAKE_CXXFLAGS_RELEASE += -O3
+
+SOURCES += loggen.cpp
@@ -0,0 +1,341 @@
+/**
+ * @file bench.cpp
+ * @brief Throughput benchmark of parsers and scenario building, without GUI.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <math.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+#include <QCoreApplication>
+#include "mavlinkparser.h"
+#include "mavlinkscenario.h"
+#include "onboardlogparserfactory.h"
+#include "onboarddata.h"
+#include "fileimporter.h"
+#include "filefun.h"
+#include "logger.h"
+#include "csvwriter.h"
+
+/*
+ * Runs each phase of an import over reference logs and prints one JSON object per file
+ * and repetition (JSON lines), e.g. to compare two versions with a script:
+ *
+ *   MavLogBench -r 3 -l v1.2 -o bench.jsonl ref/flight1.tlog ref/flight2.ulg
+ *
+ * Use -o, since the parsers also talk to stdout. Large inputs can be made with MavLogGen (loggen.cpp).
+ *
+ * Phases:
+ *   decode   parser only: MavlinkParser::get_next_msg(), OnboardLogParser::get_data()
+ *   ingest   decode and MavlinkScenario::add_*_message(), minus decode
+ *   process  MavlinkScenario::process()
+ *   merge    MavlinkScenario::merge_in() into an empty scenario
+ *   import   FileImporter end to end (parse, process; no cache), as the application does it
+ */
+
+using namespace std;
+
+typedef struct {
+    std::string name;
+    double      sec;
+} phase_t;
+
+typedef struct {
+    std::string          file;
+    std::string          parser;
+    unsigned long long   bytes;
+    unsigned long long   messages;
+    std::vector<phase_t> phases;
+    long                 peak_rss_kb;
+    bool                 ok;
+} result_t;
+
+static double now_sec(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1E-6;
+}
+
+static long peak_rss_kb(void) {
+#ifndef _WIN32
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0) return ru.ru_maxrss; // KB on Linux
+#endif
+    return 0;
+}
+
+static unsigned long long file_size(const std::string & fn) {
+    std::ifstream f(fn.c_str(), std::ios::binary | std::ios::ate);
+    if (!f.is_open()) return 0;
+    return (unsigned long long) f.tellg();
+}
+
+static void add_phase(result_t & r, const std::string & name, double sec) {
+    phase_t p;
+    p.name = name;
+    p.sec = sec;
+    r.phases.push_back(p);
+}
+
+static double get_phase(const result_t & r, const std::string & name) {
+    for (std::vector<phase_t>::const_iterator it = r.phases.begin(); it != r.phases.end(); ++it) {
+        if (it->name == name) return it->sec;
+    }
+    return 0.;
+}
+
+/**
+ * @brief decode only; the parser is made again for the next pass, since it cannot rewind
+ */
+static bool decode_mavlink(const std::string & fn, unsigned long long & n) {
+    MavlinkParser mlp(fn);
+    if (!mlp.valid) return false;
+    mavlink_message_t msg;
+    n = 0;
+    while (mlp.get_next_msg(msg)) n++;
+    return true;
+}
+
+static bool ingest_mavlink(const std::string & fn, MavlinkScenario & scene) {
+    MavlinkParser mlp(fn);
+    if (!mlp.valid) return false;
+    mavlink_message_t msg;
+    while (mlp.get_next_msg(msg)) {
+        scene.add_mavlink_message(msg, true); // one scenario, whatever the time does
+    }
+    return true;
+}
+
+static bool decode_onboard(const std::string & fn, const std::string & ext, unsigned long long & n) {
+    OnboardLogParser*olp = OnboardLogParserFactory::Instance().Create(ext);
+    if (!olp) return false;
+    olp->Load(fn);
+    const bool ok = olp->valid;
+    OnboardData d;
+    n = 0;
+    while (ok && olp->has_more_data()) {
+        if (olp->get_data(d)) n++;
+    }
+    delete olp;
+    return ok;
+}
+
+static bool ingest_onboard(const std::string & fn, const std::string & ext, MavlinkScenario & scene, std::string & parser) {
+    OnboardLogParser*olp = OnboardLogParserFactory::Instance().Create(ext);
+    if (!olp) return false;
+    parser = olp->get_parser_name();
+    scene.begin_onboard_log(parser);
+    olp->Load(fn, scene.getLogChannel());
+    const bool ok = olp->valid;
+    OnboardData d;
+    while (ok && olp->has_more_data()) {
+        if (olp->get_data(d)) scene.add_onboard_message(d);
+    }
+    scene.end_onboard_log();
+    delete olp;
+    return ok;
+}
+
+static result_t run_file(const std::string & fn) {
+    result_t r;
+    r.file = fn;
+    r.bytes = file_size(fn);
+    r.messages = 0;
+    r.peak_rss_kb = 0;
+    r.ok = false;
+
+    std::string ext = getExtension(fn);
+    ext = lcase(ext);
+    const bool is_mavlink = (ext == "tlog" || ext == "mavlink");
+    r.parser = is_mavlink ? "MavlinkParser" : ext;
+
+    double t0 = now_sec();
+    const bool decoded = is_mavlink ? decode_mavlink(fn, r.messages) : decode_onboard(fn, ext, r.messages);
+    const double t_decode = now_sec() - t0;
+    if (!decoded) return r;
+    add_phase(r, "decode", t_decode);
+
+    {
+        MavlinkScenario scene(NULL);
+        t0 = now_sec();
+        const bool ingested = is_mavlink ? ingest_mavlink(fn, scene) : ingest_onboard(fn, ext, scene, r.parser);
+        const double t_ingest = now_sec() - t0;
+        if (!ingested) return r;
+        add_phase(r, "ingest", t_ingest > t_decode ? t_ingest - t_decode : 0.);
+        Logger::Instance().flush(); // not part of any phase
+
+        t0 = now_sec();
+        scene.process();
+        add_phase(r, "process", now_sec() - t0);
+        Logger::Instance().flush();
+
+        MavlinkScenario merged(NULL);
+        t0 = now_sec();
+        merged.merge_in(scene);
+        add_phase(r, "merge", now_sec() - t0);
+        Logger::Instance().flush();
+    }
+
+    {
+        FileImporter imp(fn, NULL);
+        t0 = now_sec();
+        imp.run();
+        add_phase(r, "import", now_sec() - t0);
+        Logger::Instance().flush();
+        if (!imp.is_parsed()) return r;
+    }
+
+    r.peak_rss_kb = peak_rss_kb();
+    r.ok = true;
+    return r;
+}
+
+static void json_string(std::ostream & os, const std::string & s) {
+    os << '"';
+    for (std::string::const_iterator it = s.begin(); it != s.end(); ++it) {
+        if (*it == '"' || *it == '\\') os << '\\';
+        if ((unsigned char)*it >= 0x20) os << *it;
+    }
+    os << '"';
+}
+
+static void json_number(std::ostream & os, double v) {
+    char buf[32];
+    if (v != v || v - v != 0) {
+        os << "null";
+        return;
+    }
+    *CsvWriter::format(buf, v) = '\0';
+    os << buf;
+}
+
+static void print_result(std::ostream & os, const result_t & r, const std::string & label, unsigned int rep) {
+    const double mb = r.bytes / 1E6;
+    const double t_parse = get_phase(r, "decode") + get_phase(r, "ingest");
+    os << "{\"label\":";
+    json_string(os, label);
+    os << ",\"file\":";
+    json_string(os, r.file);
+    os << ",\"parser\":";
+    json_string(os, r.parser);
+    os << ",\"repeat\":" << rep << ",\"ok\":" << (r.ok ? "true" : "false");
+    os << ",\"bytes\":" << r.bytes << ",\"messages\":" << r.messages;
+    os << ",\"phases\":{";
+    for (size_t k = 0; k < r.phases.size(); ++k) {
+        if (k > 0) os << ",";
+        json_string(os, r.phases[k].name);
+        os << ":";
+        json_number(os, r.phases[k].sec);
+    }
+    os << "},\"decode_mb_per_sec\":";
+    json_number(os, get_phase(r, "decode") > 0 ? mb / get_phase(r, "decode") : NAN);
+    os << ",\"parse_mb_per_sec\":";
+    json_number(os, t_parse > 0 ? mb / t_parse : NAN);
+    os << ",\"parse_msgs_per_sec\":";
+    json_number(os, t_parse > 0 ? r.messages / t_parse : NAN);
+    os << ",\"import_mb_per_sec\":";
+    json_number(os, get_phase(r, "import") > 0 ? mb / get_phase(r, "import") : NAN);
+    os << ",\"peak_rss_kb\":" << r.peak_rss_kb << "}" << std::endl;
+}
+
+static void print_usage(FILE*stream) {
+    fprintf(stream, "MavLogBench [options] <log> [<log> ...]\n");
+    fprintf(stream, "Options:\n");
+    fprintf(stream,
+            "  -r  --repeat   run each log this many times (default: 1)\n"
+            "  -l  --label    goes into each result, e.g. the version under test\n"
+            "  -o  --output   append results to this file (default: stdout)\n"
+            "  -h  --help     shows this\n"
+            );
+}
+
+int main(int argc, char*argv[]) {
+    QCoreApplication app(argc, argv);
+
+    unsigned int repeat = 1;
+    std::string label;
+    std::string output;
+    const char*const short_options = "hr:l:o:";
+    const struct option long_options[] = {
+        {"help",   0, NULL, 'h'},
+        {"repeat", 1, NULL, 'r'},
+        {"label",  1, NULL, 'l'},
+        {"output", 1, NULL, 'o'},
+        {NULL, 0, NULL, 0}
+    };
+    int next_option;
+    while ((next_option = getopt_long(argc, argv, short_options, long_options, NULL)) != -1) {
+        switch (next_option) {
+        case 'r':
+            repeat = (unsigned int) atoi(optarg);
+            if (repeat < 1) repeat = 1;
+            break;
+        case 'l':
+            label = optarg;
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        case 'h':
+            print_usage(stdout);
+            return 0;
+        default:
+            print_usage(stderr);
+            return 1;
+        }
+    }
+    if (optind >= argc) {
+        print_usage(stderr);
+        return 1;
+    }
+
+    std::ofstream fout;
+    if (!output.empty()) {
+        fout.open(output.c_str(), std::ios::app);
+        if (!fout.is_open()) {
+            std::cerr << "Cannot open " << output << std::endl;
+            return 1;
+        }
+    }
+    std::ostream & os = output.empty() ? std::cout : fout;
+
+    int ret = 0;
+    for (int k = optind; k < argc; ++k) {
+        for (unsigned int rep = 0; rep < repeat; ++rep) {
+            const result_t r = run_file(argv[k]);
+            print_result(os, r, label, rep);
+            if (!r.ok) {
+                std::cerr << "Failed: " << argv[k] << std::endl;
+                ret = 2;
+            }
+        }
+    }
+    return ret;
+}
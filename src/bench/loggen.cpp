@@ -0,0 +1,967 @@
+/**
+ * @file loggen.cpp
+ * @brief Generator of synthetic, arbitrarily large logs (tlog, ulg, px4log) for scale tests.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <math.h>
+#include <string>
+#include <vector>
+#include <queue>
+#include <sstream>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "mavlink.h"
+
+/*
+ * Writes logs which the parsers of MavLogAnalyzer read, with as many topics, samples and
+ * systems as wanted, e.g. for MavLogBench:
+ *
+ *   MavLogGen -f ulg -d 7200 -t 200 -R 250,50,10 -j 2 -c 1e-6 -o big.ulg
+ *   MavLogGen -f tlog -s 4 -m attitude:100,raw_imu:200,gps_raw_int:10 -b 4G -o fleet.tlog
+ *
+ * The same arguments (and seed) always give the same file, byte by byte.
+ *
+ * Formats, as the parsers expect them:
+ *   tlog    8 byte big-endian UTC usec + MAVLink frame, built with the MAVLink headers of the
+ *           application. All systems go into one file; the message mix is given by -m.
+ *   ulg     header, FORMAT, INFO, PARAMETER, ADD_LOGGED_MSG, then DATA. Topics synth_NNN with
+ *           "uint64_t timestamp" and -F float fields, plus vehicle_gps_position for UTC.
+ *   px4log  FMT, TIME, PARM(SYSID_THISMAV), then data. Topics SNNN with TimeUS and -F floats
+ *           (at most 15), plus GPS for UTC.
+ *   For ulg and px4log, each system gets a file of its own, named <out>_<sysid>.<ext>.
+ *
+ * Time jumps (-j) move the clock of the vehicle (boot time) forward by -J seconds and back
+ * again, alternating, at evenly spread points; UTC (GPS, tlog timestamps) goes on steadily.
+ *
+ * Corruption (-c) is the probability per data message to flip a byte, cut the message short,
+ * or put garbage in front of it. Definitions are never damaged. Corruption draws from a
+ * random generator of its own, so the values stay the same with and without it.
+ */
+
+#define GEN_BUFSIZE       (1 << 20)
+#define GEN_BOOT_USEC     5000000ULL          ///< boot time at start of log
+#define GEN_START_UTC     1700000000ULL       ///< default start of log, UTC seconds
+#define GEN_GPS_HZ        5.
+#define GEN_PX4_MAXFIELDS 15                  ///< Format is char[16], one goes to TimeUS
+#define GEN_ULG_MAXFIELDS 1000
+
+// as in onboardlogparser_ulg.cpp
+#define ULG_MAGIC         "ULog\x01\x12\x35"
+#define ULG_VERSION       1
+
+// as in onboardlogparser_px4.cpp
+#define PX4_HEAD1         0xA3
+#define PX4_HEAD2         0x95
+#define PX4_FMT           0x80
+#define PX4_FMT_LEN       89
+
+using namespace std;
+
+typedef std::vector<uint8_t> bytes_t;
+
+/**
+ * @brief one MAVLink message which tlogs can have, with its default rate
+ */
+typedef struct {
+    const char*  name;
+    unsigned int msgid;
+    double       rate_hz;
+} mav_kind_t;
+
+static const mav_kind_t mav_kinds[] = {
+    {"heartbeat",           MAVLINK_MSG_ID_HEARTBEAT,           1.},
+    {"sys_status",          MAVLINK_MSG_ID_SYS_STATUS,          2.},
+    {"system_time",         MAVLINK_MSG_ID_SYSTEM_TIME,         1.},
+    {"gps_raw_int",         MAVLINK_MSG_ID_GPS_RAW_INT,         5.},
+    {"attitude",            MAVLINK_MSG_ID_ATTITUDE,            50.},
+    {"raw_imu",             MAVLINK_MSG_ID_RAW_IMU,             50.},
+    {"global_position_int", MAVLINK_MSG_ID_GLOBAL_POSITION_INT, 10.},
+    {"vfr_hud",             MAVLINK_MSG_ID_VFR_HUD,             10.},
+    {"scaled_pressure",     MAVLINK_MSG_ID_SCALED_PRESSURE,     10.},
+    {"servo_output_raw",    MAVLINK_MSG_ID_SERVO_OUTPUT_RAW,    20.}
+};
+static const unsigned int num_mav_kinds = sizeof(mav_kinds) / sizeof(mav_kinds[0]);
+
+typedef struct {
+    unsigned int kind;    ///< index in mav_kinds
+    double       rate_hz;
+} mix_entry_t;
+
+typedef struct {
+    std::string              format;        ///< tlog, ulg, px4log
+    std::string              output;
+    double                   duration_sec;
+    unsigned long long       max_bytes;     ///< 0=no limit
+    unsigned int             topics;        ///< ulg, px4log
+    unsigned int             fields;        ///< per topic; ulg, px4log
+    std::vector<double>      rates;         ///< cycled over the topics; ulg, px4log
+    std::vector<mix_entry_t> mix;           ///< tlog
+    unsigned int             systems;
+    unsigned int             jumps;
+    double                   jump_sec;
+    double                   corrupt;       ///< probability per data message
+    unsigned long long       seed;
+    unsigned long long       start_utc_usec;
+} gen_args_t;
+
+/**
+ * @brief xorshift64*. Not rand(), to get the same numbers on every platform.
+ */
+class Rng {
+public:
+    Rng(unsigned long long seed) : _s(seed ? seed : 0x9E3779B97F4A7C15ULL) {}
+
+    unsigned long long next(void) {
+        _s ^= _s >> 12;
+        _s ^= _s << 25;
+        _s ^= _s >> 27;
+        return _s * 0x2545F4914F6CDD1DULL;
+    }
+
+    /// in [0,1)
+    double uniform(void) { return (double) (next() >> 11) * (1. / 9007199254740992.); }
+
+    /// in [0,n)
+    unsigned int below(unsigned int n) { return n ? (unsigned int) (next() % n) : 0; }
+
+private:
+    unsigned long long _s;
+};
+
+/********************************************
+ *  LITTLE-ENDIAN ENCODING (ulg, px4log)
+ ********************************************/
+
+static void put_u8(bytes_t & b, uint8_t v) { b.push_back(v); }
+
+static void put_u16(bytes_t & b, uint16_t v) {
+    b.push_back((uint8_t) v);
+    b.push_back((uint8_t) (v >> 8));
+}
+
+static void put_u32(bytes_t & b, uint32_t v) {
+    for (unsigned int k = 0; k < 4; ++k) b.push_back((uint8_t) (v >> (8 * k)));
+}
+
+static void put_u64(bytes_t & b, uint64_t v) {
+    for (unsigned int k = 0; k < 8; ++k) b.push_back((uint8_t) (v >> (8 * k)));
+}
+
+static void put_f32(bytes_t & b, float v) {
+    uint32_t u;
+    memcpy(&u, &v, sizeof(u));
+    put_u32(b, u);
+}
+
+static void put_str(bytes_t & b, const std::string & s) { b.insert(b.end(), s.begin(), s.end()); }
+
+/// zero-padded to n bytes
+static void put_fixstr(bytes_t & b, const std::string & s, unsigned int n) {
+    for (unsigned int k = 0; k < n; ++k) b.push_back(k < s.size() ? (uint8_t) s[k] : 0);
+}
+
+/********************************************
+ *  GENERATORS
+ ********************************************/
+
+/**
+ * @brief writes one file: the header of the format, then the messages of all streams in
+ * the order of time. A stream is one topic (of one system) with a fixed rate.
+ */
+class LogGen {
+public:
+    LogGen(const gen_args_t & args, unsigned int sysid) : _args(args), _sysid(sysid),
+        _rng(args.seed * 31 + sysid), _crng((args.seed * 31 + sysid) ^ 0xC0FFEE),
+        _f(NULL), _bytes(0), _messages(0), _corrupted(0), _jumps(0) {}
+    virtual ~LogGen() { if (_f) fclose(_f); }
+
+    bool run(const std::string & filename);
+
+    unsigned long long get_bytes(void) const { return _bytes; }
+    unsigned long long get_messages(void) const { return _messages; }
+    unsigned long long get_corrupted(void) const { return _corrupted; }
+    unsigned int       get_jumps(void) const { return _jumps; }
+
+protected:
+    typedef struct {
+        double              rate_hz;
+        unsigned int        kind;    ///< up to the subclass
+        uint8_t             sysid;
+        std::vector<double> vals;    ///< random walks
+    } stream_t;
+
+    /// fill _streams. False if the arguments do not fit the format.
+    virtual bool _make_streams(void) = 0;
+    virtual void _write_header(void) = 0;
+    virtual void _write_message(stream_t & s, uint64_t utc_usec, uint64_t boot_usec) = 0;
+
+    void _add_stream(double rate_hz, unsigned int kind, uint8_t sysid, unsigned int nvals);
+
+    /// definitions. Never corrupted.
+    void _put(const bytes_t & b);
+
+    /// data message. May be corrupted.
+    void _emit(bytes_t & b);
+
+    /// next value of random walk k of the stream, kept within [-lim,lim]
+    double _walk(stream_t & s, unsigned int k, double step, double lim);
+
+    const gen_args_t &    _args;
+    const unsigned int    _sysid;
+    Rng                   _rng;
+    Rng                   _crng; ///< corruption only
+    std::vector<stream_t> _streams;
+    bytes_t               _buf;  ///< reused for each message
+
+private:
+    typedef struct {
+        uint64_t     next_usec;
+        uint64_t     period_usec;
+        unsigned int stream;
+    } due_t;
+
+    struct later {
+        bool operator()(const due_t & a, const due_t & b) const {
+            if (a.next_usec != b.next_usec) return a.next_usec > b.next_usec;
+            return a.stream > b.stream;
+        }
+    };
+
+    FILE*              _f;
+    unsigned long long _bytes;
+    unsigned long long _messages;
+    unsigned long long _corrupted;
+    unsigned int       _jumps;
+};
+
+void LogGen::_add_stream(double rate_hz, unsigned int kind, uint8_t sysid, unsigned int nvals) {
+    stream_t s;
+    s.rate_hz = rate_hz;
+    s.kind = kind;
+    s.sysid = sysid;
+    s.vals.assign(nvals, 0.);
+    _streams.push_back(s);
+}
+
+void LogGen::_put(const bytes_t & b) {
+    if (b.empty()) return;
+    fwrite(&b[0], 1, b.size(), _f);
+    _bytes += b.size();
+}
+
+void LogGen::_emit(bytes_t & b) {
+    if (_args.corrupt > 0. && !b.empty() && _crng.uniform() < _args.corrupt) {
+        switch (_crng.below(3)) {
+        case 0: // bit errors
+            b[_crng.below(b.size())] ^= (uint8_t) (1 + _crng.below(255));
+            break;
+        case 1: // cut short, e.g. by a lost packet
+            b.resize(_crng.below(b.size()));
+            break;
+        default: // garbage in between
+        {
+            bytes_t junk(1 + _crng.below(16));
+            for (unsigned int k = 0; k < junk.size(); ++k) junk[k] = (uint8_t) _crng.below(256);
+            b.insert(b.begin(), junk.begin(), junk.end());
+        }
+            break;
+        }
+        _corrupted++;
+    }
+    _put(b);
+}
+
+double LogGen::_walk(stream_t & s, unsigned int k, double step, double lim) {
+    double & v = s.vals[k];
+    v += (_rng.uniform() - .5) * step;
+    if (v > lim) v = 2 * lim - v;
+    if (v < -lim) v = -2 * lim - v;
+    return v;
+}
+
+bool LogGen::run(const std::string & filename) {
+    if (!_make_streams() || _streams.empty()) return false;
+
+    _f = fopen(filename.c_str(), "wb");
+    if (!_f) {
+        fprintf(stderr, "Cannot open %s\n", filename.c_str());
+        return false;
+    }
+    setvbuf(_f, NULL, _IOFBF, GEN_BUFSIZE);
+
+    _write_header();
+
+    // all streams, by time of their next message. Phases are random, so that not all are due at once.
+    std::priority_queue<due_t, std::vector<due_t>, later> q;
+    for (unsigned int k = 0; k < _streams.size(); ++k) {
+        due_t d;
+        d.period_usec = (uint64_t) (1E6 / _streams[k].rate_hz + .5);
+        if (d.period_usec < 1) d.period_usec = 1;
+        d.next_usec = _rng.below((unsigned int) d.period_usec);
+        d.stream = k;
+        q.push(d);
+    }
+
+    const uint64_t end_usec = (uint64_t) (_args.duration_sec * 1E6);
+    const uint64_t jump_usec = (uint64_t) (_args.jump_sec * 1E6);
+    uint64_t boot_offset = 0;
+    unsigned int jump = 0;
+    while (!q.empty()) {
+        due_t d = q.top();
+        q.pop();
+        if (d.next_usec >= end_usec) break; // all others are later
+        if (_args.max_bytes > 0 && _bytes >= _args.max_bytes) break;
+
+        while (jump < _args.jumps && d.next_usec >= end_usec / (_args.jumps + 1) * (jump + 1)) {
+            boot_offset = (jump % 2 == 0) ? jump_usec : 0;
+            jump++;
+            _jumps++;
+        }
+
+        _write_message(_streams[d.stream], _args.start_utc_usec + d.next_usec, GEN_BOOT_USEC + d.next_usec + boot_offset);
+        _messages++;
+
+        d.next_usec += d.period_usec;
+        q.push(d);
+    }
+
+    const bool ok = (ferror(_f) == 0);
+    if (fclose(_f) != 0 || !ok) {
+        fprintf(stderr, "Error writing %s\n", filename.c_str());
+        _f = NULL;
+        return false;
+    }
+    _f = NULL;
+    return true;
+}
+
+/**
+ * @brief MAVLink telemetry log. All systems in one file.
+ */
+class LogGenTlog : public LogGen {
+public:
+    LogGenTlog(const gen_args_t & args) : LogGen(args, 0) {}
+
+protected:
+    bool _make_streams(void) {
+        for (unsigned int s = 0; s < _args.systems; ++s) {
+            for (unsigned int k = 0; k < _args.mix.size(); ++k) {
+                _add_stream(_args.mix[k].rate_hz, _args.mix[k].kind, (uint8_t) (1 + s), 12);
+            }
+        }
+        return true;
+    }
+
+    void _write_header(void) {}
+
+    void _write_message(stream_t & s, uint64_t utc_usec, uint64_t boot_usec);
+};
+
+void LogGenTlog::_write_message(stream_t & s, uint64_t utc_usec, uint64_t boot_usec) {
+    const uint32_t boot_ms = (uint32_t) (boot_usec / 1000);
+    const uint8_t compid = 1;
+    mavlink_message_t msg;
+
+    switch (mav_kinds[s.kind].msgid) {
+    case MAVLINK_MSG_ID_HEARTBEAT:
+    {
+        mavlink_heartbeat_t p;
+        memset(&p, 0, sizeof(p));
+        p.type = MAV_TYPE_QUADROTOR;
+        p.autopilot = MAV_AUTOPILOT_PX4;
+        p.base_mode = MAV_MODE_FLAG_SAFETY_ARMED | MAV_MODE_FLAG_CUSTOM_MODE_ENABLED;
+        p.system_status = MAV_STATE_ACTIVE;
+        p.mavlink_version = 3;
+        mavlink_msg_heartbeat_encode(s.sysid, compid, &msg, &p);
+    }
+        break;
+    case MAVLINK_MSG_ID_SYS_STATUS:
+    {
+        mavlink_sys_status_t p;
+        memset(&p, 0, sizeof(p));
+        p.voltage_battery = (uint16_t) (12000 + _walk(s, 0, 10., 800.));
+        p.current_battery = (int16_t) (1500 + _walk(s, 1, 20., 1000.));
+        p.battery_remaining = (int8_t) (50 + _walk(s, 2, .1, 49.));
+        p.load = (uint16_t) (500 + _walk(s, 3, 5., 400.));
+        mavlink_msg_sys_status_encode(s.sysid, compid, &msg, &p);
+    }
+        break;
+    case MAVLINK_MSG_ID_SYSTEM_TIME:
+    {
+        mavlink_system_time_t p;
+        memset(&p, 0, sizeof(p));
+        p.time_unix_usec = utc_usec;
+        p.time_boot_ms = boot_ms;
+        mavlink_msg_system_time_encode(s.sysid, compid, &msg, &p);
+    }
+        break;
+    case MAVLINK_MSG_ID_GPS_RAW_INT:
+    {
+        mavlink_gps_raw_int_t p;
+        memset(&p, 0, sizeof(p));
+        p.time_usec = boot_usec;
+        p.fix_type = 3;
+        p.lat = (int32_t) ((48.15 + _walk(s, 0, 1E-5, .01)) * 1E7);
+        p.lon = (int32_t) ((11.57 + _walk(s, 1, 1E-5, .01)) * 1E7);
+        p.alt = (int32_t) ((520. + _walk(s, 2, .1, 100.)) * 1E3);
+        p.eph = (uint16_t) (120 + _walk(s, 3, 2., 100.));
+        p.epv = (uint16_t) (180 + _walk(s, 4, 2., 100.));
+        p.vel = (uint16_t) (500 + _walk(s, 5, 10., 500.));
+        p.cog = (uint16_t) (18000 + _walk(s, 6, 50., 17999.));
+        p.satellites_visible = 10;
+        mavlink_msg_gps_raw_int_encode(s.sysid, compid, &msg, &p);
+    }
+        break;
+    case MAVLINK_MSG_ID_ATTITUDE:
+    {
+        mavlink_attitude_t p;
+        memset(&p, 0, sizeof(p));
+        p.time_boot_ms = boot_ms;
+        p.roll = (float) _walk(s, 0, .01, .7);
+        p.pitch = (float) _walk(s, 1, .01, .7);
+        p.yaw = (float) _walk(s, 2, .01, 3.1);
+        p.rollspeed = (float) _walk(s, 3, .05, 2.);
+        p.pitchspeed = (float) _walk(s, 4, .05, 2.);
+        p.yawspeed = (float) _walk(s, 5, .05, 2.);
+        mavlink_msg_attitude_encode(s.sysid, compid, &msg, &p);
+    }
+        break;
+    case MAVLINK_MSG_ID_RAW_IMU:
+    {
+        mavlink_raw_imu_t p;
+        memset(&p, 0, sizeof(p));
+        p.time_usec = boot_usec;
+        p.xacc = (int16_t) _walk(s, 0, 20., 2000.);
+        p.yacc = (int16_t) _walk(s, 1, 20., 2000.);
+        p.zacc = (int16_t) (-1000 + _walk(s, 2, 20., 1000.));
+        p.xgyro = (int16_t) _walk(s, 3, 20., 2000.);
+        p.ygyro = (int16_t) _walk(s, 4, 20., 2000.);
+        p.zgyro = (int16_t) _walk(s, 5, 20., 2000.);
+        p.xmag = (int16_t) _walk(s, 6, 5., 600.);
+        p.ymag = (int16_t) _walk(s, 7, 5., 600.);
+        p.zmag = (int16_t) _walk(s, 8, 5., 600.);
+        mavlink_msg_raw_imu_encode(s.sysid, compid, &msg, &p);
+    }
+        break;
+    case MAVLINK_MSG_ID_GLOBAL_POSITION_INT:
+    {
+        mavlink_global_position_int_t p;
+        memset(&p, 0, sizeof(p));
+        p.time_boot_ms = boot_ms;
+        p.lat = (int32_t) ((48.15 + _walk(s, 0, 1E-5, .01)) * 1E7);
+        p.lon = (int32_t) ((11.57 + _walk(s, 1, 1E-5, .01)) * 1E7);
+        const double relalt = 50. + _walk(s, 2, .1, 50.);
+        p.alt = (int32_t) ((520. + relalt) * 1E3);
+        p.relative_alt = (int32_t) (relalt * 1E3);
+        p.vx = (int16_t) _walk(s, 3, 5., 1500.);
+        p.vy = (int16_t) _walk(s, 4, 5., 1500.);
+        p.vz = (int16_t) _walk(s, 5, 5., 500.);
+        p.hdg = (uint16_t) (18000 + _walk(s, 6, 50., 17999.));
+        mavlink_msg_global_position_int_encode(s.sysid, compid, &msg, &p);
+    }
+        break;
+    case MAVLINK_MSG_ID_VFR_HUD:
+    {
+        mavlink_vfr_hud_t p;
+        memset(&p, 0, sizeof(p));
+        p.airspeed = (float) (10. + _walk(s, 0, .1, 10.));
+        p.groundspeed = (float) (10. + _walk(s, 1, .1, 10.));
+        p.alt = (float) (570. + _walk(s, 2, .1, 50.));
+        p.climb = (float) _walk(s, 3, .05, 5.);
+        p.heading = (int16_t) (180 + _walk(s, 4, .5, 179.));
+        p.throttle = (uint16_t) (50 + _walk(s, 5, .5, 50.));
+        mavlink_msg_vfr_hud_encode(s.sysid, compid, &msg, &p);
+    }
+        break;
+    case MAVLINK_MSG_ID_SCALED_PRESSURE:
+    {
+        mavlink_scaled_pressure_t p;
+        memset(&p, 0, sizeof(p));
+        p.time_boot_ms = boot_ms;
+        p.press_abs = (float) (955. + _walk(s, 0, .05, 10.));
+        p.press_diff = (float) _walk(s, 1, .01, 1.);
+        p.temperature = (int16_t) (2500 + _walk(s, 2, 1., 1000.));
+        mavlink_msg_scaled_pressure_encode(s.sysid, compid, &msg, &p);
+    }
+        break;
+    case MAVLINK_MSG_ID_SERVO_OUTPUT_RAW:
+    default:
+    {
+        mavlink_servo_output_raw_t p;
+        memset(&p, 0, sizeof(p));
+        p.time_usec = (uint32_t) boot_usec;
+        p.servo1_raw = (uint16_t) (1500 + _walk(s, 0, 10., 400.));
+        p.servo2_raw = (uint16_t) (1500 + _walk(s, 1, 10., 400.));
+        p.servo3_raw = (uint16_t) (1500 + _walk(s, 2, 10., 400.));
+        p.servo4_raw = (uint16_t) (1500 + _walk(s, 3, 10., 400.));
+        p.servo5_raw = (uint16_t) (1500 + _walk(s, 4, 10., 400.));
+        p.servo6_raw = (uint16_t) (1500 + _walk(s, 5, 10., 400.));
+        p.servo7_raw = (uint16_t) (1500 + _walk(s, 6, 10., 400.));
+        p.servo8_raw = (uint16_t) (1500 + _walk(s, 7, 10., 400.));
+        mavlink_msg_servo_output_raw_encode(s.sysid, compid, &msg, &p);
+    }
+        break;
+    }
+
+    // record: timestamp big-endian, then the frame
+    uint8_t frame[MAVLINK_MAX_PACKET_LEN];
+    const uint16_t len = mavlink_msg_to_send_buffer(frame, &msg);
+    _buf.clear();
+    for (int k = 7; k >= 0; --k) _buf.push_back((uint8_t) (utc_usec >> (8 * k)));
+    _buf.insert(_buf.end(), frame, frame + len);
+    _emit(_buf);
+}
+
+/**
+ * @brief PX4 ULog
+ */
+class LogGenUlg : public LogGen {
+public:
+    LogGenUlg(const gen_args_t & args, unsigned int sysid) : LogGen(args, sysid) {}
+
+protected:
+    enum { KIND_TOPIC = 0, KIND_GPS = 1 };
+
+    bool _make_streams(void) {
+        if (_args.fields > GEN_ULG_MAXFIELDS) {
+            fprintf(stderr, "ulg: at most %d fields per topic\n", GEN_ULG_MAXFIELDS);
+            return false;
+        }
+        for (unsigned int k = 0; k < _args.topics; ++k) {
+            _add_stream(_args.rates[k % _args.rates.size()], KIND_TOPIC, (uint8_t) _sysid, _args.fields);
+        }
+        _add_stream(GEN_GPS_HZ, KIND_GPS, (uint8_t) _sysid, 3);
+        return true;
+    }
+
+    void _write_header(void);
+    void _write_message(stream_t & s, uint64_t utc_usec, uint64_t boot_usec);
+
+private:
+    void _begin(char type) {
+        _buf.clear();
+        put_u16(_buf, 0);
+        put_u8(_buf, (uint8_t) type);
+    }
+
+    void _end(void) {
+        const uint16_t len = (uint16_t) (_buf.size() - 3);
+        _buf[0] = (uint8_t) len;
+        _buf[1] = (uint8_t) (len >> 8);
+    }
+};
+
+void LogGenUlg::_write_header(void) {
+    // file header
+    _buf.clear();
+    put_str(_buf, std::string(ULG_MAGIC, 7));
+    put_u8(_buf, ULG_VERSION);
+    put_u64(_buf, GEN_BOOT_USEC);
+    _put(_buf);
+
+    // flag bits: nothing incompatible, no appended data
+    _begin('B');
+    for (unsigned int k = 0; k < 40; ++k) put_u8(_buf, 0);
+    _end();
+    _put(_buf);
+
+    // formats
+    const unsigned int gps_id = (unsigned int) _streams.size() - 1;
+    for (unsigned int k = 0; k < _streams.size(); ++k) {
+        std::ostringstream ss;
+        if (k == gps_id) {
+            ss << "vehicle_gps_position:uint64_t timestamp;uint64_t time_utc_usec;int32_t lat;int32_t lon;"
+                  "int32_t alt;float eph;float epv;uint8_t fix_type;uint8_t satellites_used;";
+        } else {
+            char name[16];
+            snprintf(name, sizeof(name), "synth_%03u", k);
+            ss << name << ":uint64_t timestamp;";
+            for (unsigned int f = 0; f < _args.fields; ++f) ss << "float f" << f << ";";
+        }
+        _begin('F');
+        put_str(_buf, ss.str());
+        _end();
+        _put(_buf);
+    }
+
+    // info and parameters
+    const std::string sysname = "MavLogGen";
+    std::ostringstream key;
+    key << "char[" << sysname.size() << "] sys_name";
+    _begin('I');
+    put_u8(_buf, (uint8_t) key.str().size());
+    put_str(_buf, key.str());
+    put_str(_buf, sysname);
+    _end();
+    _put(_buf);
+
+    const std::string pkey = "int32_t MAV_SYS_ID";
+    _begin('P');
+    put_u8(_buf, (uint8_t) pkey.size());
+    put_str(_buf, pkey);
+    put_u32(_buf, _sysid);
+    _end();
+    _put(_buf);
+
+    // subscriptions. The first one ends the definitions.
+    for (unsigned int k = 0; k < _streams.size(); ++k) {
+        char name[32];
+        if (k == gps_id) {
+            snprintf(name, sizeof(name), "vehicle_gps_position");
+        } else {
+            snprintf(name, sizeof(name), "synth_%03u", k);
+        }
+        _begin('A');
+        put_u8(_buf, 0);
+        put_u16(_buf, (uint16_t) k);
+        put_str(_buf, name);
+        _end();
+        _put(_buf);
+    }
+}
+
+void LogGenUlg::_write_message(stream_t & s, uint64_t utc_usec, uint64_t boot_usec) {
+    const unsigned int msg_id = (unsigned int) (&s - &_streams[0]);
+    _begin('D');
+    put_u16(_buf, (uint16_t) msg_id);
+    put_u64(_buf, boot_usec);
+    if (s.kind == KIND_GPS) {
+        put_u64(_buf, utc_usec);
+        put_u32(_buf, (uint32_t) (int32_t) ((48.15 + _walk(s, 0, 1E-5, .01)) * 1E7));
+        put_u32(_buf, (uint32_t) (int32_t) ((11.57 + _walk(s, 1, 1E-5, .01)) * 1E7));
+        put_u32(_buf, (uint32_t) (int32_t) ((520. + _walk(s, 2, .1, 100.)) * 1E3));
+        put_f32(_buf, 1.2f);
+        put_f32(_buf, 1.8f);
+        put_u8(_buf, 3);
+        put_u8(_buf, 10);
+    } else {
+        for (unsigned int f = 0; f < s.vals.size(); ++f) put_f32(_buf, (float) _walk(s, f, .1, 100.));
+    }
+    _end();
+    _emit(_buf);
+}
+
+/**
+ * @brief PX4 sdlog2 (px4log)
+ */
+class LogGenPx4 : public LogGen {
+public:
+    LogGenPx4(const gen_args_t & args, unsigned int sysid) : LogGen(args, sysid) {}
+
+protected:
+    enum { KIND_TOPIC = 0, KIND_GPS = 1 };
+    enum { TYPE_TIME = 1, TYPE_PARM = 2, TYPE_GPS = 3, TYPE_FIRST_TOPIC = 4 };
+
+    bool _make_streams(void) {
+        if (_args.fields > GEN_PX4_MAXFIELDS) {
+            fprintf(stderr, "px4log: at most %d fields per topic\n", GEN_PX4_MAXFIELDS);
+            return false;
+        }
+        for (unsigned int k = 0; k < _args.topics; ++k) {
+            _add_stream(_args.rates[k % _args.rates.size()], KIND_TOPIC, (uint8_t) _sysid, _args.fields);
+            _types.push_back(0);
+        }
+        // message types are one byte, and FMT has one of them
+        unsigned int t = TYPE_FIRST_TOPIC;
+        for (unsigned int k = 0; k < _types.size(); ++k, ++t) {
+            if (t == PX4_FMT) ++t;
+            if (t > 0xFF) {
+                fprintf(stderr, "px4log: at most %d topics\n", 0xFF - TYPE_FIRST_TOPIC);
+                return false;
+            }
+            _types[k] = (uint8_t) t;
+        }
+        _add_stream(GEN_GPS_HZ, KIND_GPS, (uint8_t) _sysid, 3);
+        _types.push_back(TYPE_GPS);
+        return true;
+    }
+
+    void _write_header(void);
+    void _write_message(stream_t & s, uint64_t utc_usec, uint64_t boot_usec);
+
+private:
+    void _begin(uint8_t type) {
+        _buf.clear();
+        put_u8(_buf, PX4_HEAD1);
+        put_u8(_buf, PX4_HEAD2);
+        put_u8(_buf, type);
+    }
+
+    void _fmt(uint8_t type, unsigned int payload, const std::string & name, const std::string & format,
+              const std::string & labels) {
+        _begin(PX4_FMT);
+        put_u8(_buf, type);
+        put_u8(_buf, (uint8_t) (3 + payload));
+        put_fixstr(_buf, name, 4);
+        put_fixstr(_buf, format, 16);
+        put_fixstr(_buf, labels, 64);
+        _put(_buf);
+    }
+
+    std::vector<uint8_t> _types; ///< by stream
+};
+
+void LogGenPx4::_write_header(void) {
+    _fmt(PX4_FMT, PX4_FMT_LEN - 3, "FMT", "BBnNZ", "Type,Length,Name,Format,Labels");
+    _fmt(TYPE_TIME, 8, "TIME", "Q", "StartTime");
+    _fmt(TYPE_PARM, 4, "PARM", "f", "SYSID_THISMAV");
+    _fmt(TYPE_GPS, 8 + 1 + 4 + 4 + 4, "GPS", "QBLLf", "GPSTime,Fix,Lat,Lon,Alt");
+    for (unsigned int k = 0; k + 1 < _streams.size(); ++k) {
+        char name[8];
+        snprintf(name, sizeof(name), "S%03u", k);
+        std::string format = "Q";
+        std::ostringstream labels;
+        labels << "TimeUS";
+        for (unsigned int f = 0; f < _args.fields; ++f) {
+            format += "f";
+            labels << ",F" << std::hex << std::uppercase << f;
+        }
+        _fmt(_types[k], 8 + 4 * _args.fields, name, format, labels.str());
+    }
+
+    _begin(TYPE_TIME);
+    put_u64(_buf, _args.start_utc_usec);
+    _put(_buf);
+
+    _begin(TYPE_PARM);
+    put_f32(_buf, (float) _sysid);
+    _put(_buf);
+}
+
+void LogGenPx4::_write_message(stream_t & s, uint64_t utc_usec, uint64_t boot_usec) {
+    const unsigned int k = (unsigned int) (&s - &_streams[0]);
+    _begin(_types[k]);
+    if (s.kind == KIND_GPS) {
+        put_u64(_buf, utc_usec);
+        put_u8(_buf, 3);
+        put_u32(_buf, (uint32_t) (int32_t) ((48.15 + _walk(s, 0, 1E-5, .01)) * 1E7));
+        put_u32(_buf, (uint32_t) (int32_t) ((11.57 + _walk(s, 1, 1E-5, .01)) * 1E7));
+        put_f32(_buf, (float) (520. + _walk(s, 2, .1, 100.)));
+    } else {
+        put_u64(_buf, boot_usec);
+        for (unsigned int f = 0; f < s.vals.size(); ++f) put_f32(_buf, (float) _walk(s, f, .1, 100.));
+    }
+    _emit(_buf);
+}
+
+/********************************************
+ *  COMMAND LINE
+ ********************************************/
+
+static void print_usage(FILE*stream) {
+    fprintf(stream, "MavLogGen [options] -o <file>\n");
+    fprintf(stream, "  -f  --format FMT      tlog, ulg or px4log (default: from extension of -o)\n");
+    fprintf(stream, "  -o  --output FILE     file to write\n");
+    fprintf(stream, "  -d  --duration SEC    length of the log (default 600)\n");
+    fprintf(stream, "  -b  --bytes SIZE      stop earlier at this size, e.g. 4G, 500M\n");
+    fprintf(stream, "  -t  --topics N        ulg/px4log: number of topics (default 20)\n");
+    fprintf(stream, "  -F  --fields N        ulg/px4log: float fields per topic (default 8)\n");
+    fprintf(stream, "  -R  --rates HZ,...    ulg/px4log: rates, cycled over the topics (default 100,50,10)\n");
+    fprintf(stream, "  -m  --mix MSG[:HZ],.. tlog: MAVLink messages and rates (default: all below)\n");
+    fprintf(stream, "  -s  --systems N       number of systems (default 1)\n");
+    fprintf(stream, "  -j  --jumps N         time jumps of the vehicle clock (default 0)\n");
+    fprintf(stream, "  -J  --jump-size SEC   size of each time jump (default 30)\n");
+    fprintf(stream, "  -c  --corrupt P       probability to damage a data message (default 0)\n");
+    fprintf(stream, "  -S  --seed N          seed of the random values (default 1)\n");
+    fprintf(stream, "  -u  --utc SEC         UTC at start of log (default %llu)\n", GEN_START_UTC);
+    fprintf(stream, "  -h  --help            this text\n");
+    fprintf(stream, "MAVLink messages for -m:");
+    for (unsigned int k = 0; k < num_mav_kinds; ++k) {
+        fprintf(stream, " %s:%g", mav_kinds[k].name, mav_kinds[k].rate_hz);
+    }
+    fprintf(stream, "\n");
+}
+
+/// "4G" -> 4*2^30
+static bool parse_size(const char*str, unsigned long long & bytes) {
+    char*end = NULL;
+    const double v = strtod(str, &end);
+    if (end == str || v < 0) return false;
+    double mult = 1.;
+    switch (*end) {
+    case 'k': case 'K': mult = 1024.; break;
+    case 'm': case 'M': mult = 1024. * 1024.; break;
+    case 'g': case 'G': mult = 1024. * 1024. * 1024.; break;
+    case '\0': break;
+    default: return false;
+    }
+    bytes = (unsigned long long) (v * mult);
+    return true;
+}
+
+static std::vector<std::string> split(const std::string & str, char sep) {
+    std::vector<std::string> parts;
+    std::istringstream ss(str);
+    std::string tok;
+    while (std::getline(ss, tok, sep)) {
+        if (!tok.empty()) parts.push_back(tok);
+    }
+    return parts;
+}
+
+static bool parse_rates(const char*str, std::vector<double> & rates) {
+    rates.clear();
+    const std::vector<std::string> parts = split(str, ',');
+    for (unsigned int k = 0; k < parts.size(); ++k) {
+        const double hz = atof(parts[k].c_str());
+        if (hz <= 0.) return false;
+        rates.push_back(hz);
+    }
+    return !rates.empty();
+}
+
+static bool parse_mix(const char*str, std::vector<mix_entry_t> & mix) {
+    mix.clear();
+    const std::vector<std::string> parts = split(str, ',');
+    for (unsigned int k = 0; k < parts.size(); ++k) {
+        const std::string::size_type colon = parts[k].find(':');
+        const std::string name = parts[k].substr(0, colon);
+        unsigned int kind = 0;
+        while (kind < num_mav_kinds && name != mav_kinds[kind].name) ++kind;
+        if (kind == num_mav_kinds) {
+            fprintf(stderr, "Unknown MAVLink message: %s\n", name.c_str());
+            return false;
+        }
+        mix_entry_t e;
+        e.kind = kind;
+        e.rate_hz = (colon == std::string::npos) ? mav_kinds[kind].rate_hz : atof(parts[k].substr(colon + 1).c_str());
+        if (e.rate_hz <= 0.) return false;
+        mix.push_back(e);
+    }
+    return !mix.empty();
+}
+
+/// out.ulg -> out_2.ulg
+static std::string file_for_system(const std::string & output, unsigned int sysid) {
+    std::ostringstream ss;
+    const std::string::size_type dot = output.rfind('.');
+    const std::string::size_type slash = output.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        ss << output << "_" << sysid;
+    } else {
+        ss << output.substr(0, dot) << "_" << sysid << output.substr(dot);
+    }
+    return ss.str();
+}
+
+int main(int argc, char*argv[]) {
+    gen_args_t args;
+    args.duration_sec = 600.;
+    args.max_bytes = 0;
+    args.topics = 20;
+    args.fields = 8;
+    args.rates.push_back(100.);
+    args.rates.push_back(50.);
+    args.rates.push_back(10.);
+    for (unsigned int k = 0; k < num_mav_kinds; ++k) {
+        mix_entry_t e;
+        e.kind = k;
+        e.rate_hz = mav_kinds[k].rate_hz;
+        args.mix.push_back(e);
+    }
+    args.systems = 1;
+    args.jumps = 0;
+    args.jump_sec = 30.;
+    args.corrupt = 0.;
+    args.seed = 1;
+    args.start_utc_usec = GEN_START_UTC * 1000000ULL;
+
+    const char*const short_options = "hf:o:d:b:t:F:R:m:s:j:J:c:S:u:";
+    const struct option long_options[] = {
+        {"help",      0, NULL, 'h'},
+        {"format",    1, NULL, 'f'},
+        {"output",    1, NULL, 'o'},
+        {"duration",  1, NULL, 'd'},
+        {"bytes",     1, NULL, 'b'},
+        {"topics",    1, NULL, 't'},
+        {"fields",    1, NULL, 'F'},
+        {"rates",     1, NULL, 'R'},
+        {"mix",       1, NULL, 'm'},
+        {"systems",   1, NULL, 's'},
+        {"jumps",     1, NULL, 'j'},
+        {"jump-size", 1, NULL, 'J'},
+        {"corrupt",   1, NULL, 'c'},
+        {"seed",      1, NULL, 'S'},
+        {"utc",       1, NULL, 'u'},
+        {NULL, 0, NULL, 0}
+    };
+    bool args_ok = true;
+    int next_option;
+    while ((next_option = getopt_long(argc, argv, short_options, long_options, NULL)) != -1) {
+        switch (next_option) {
+        case 'f': args.format = optarg; break;
+        case 'o': args.output = optarg; break;
+        case 'd': args.duration_sec = atof(optarg); break;
+        case 'b': args_ok &= parse_size(optarg, args.max_bytes); break;
+        case 't': args.topics = (unsigned int) atoi(optarg); break;
+        case 'F': args.fields = (unsigned int) atoi(optarg); break;
+        case 'R': args_ok &= parse_rates(optarg, args.rates); break;
+        case 'm': args_ok &= parse_mix(optarg, args.mix); break;
+        case 's': args.systems = (unsigned int) atoi(optarg); break;
+        case 'j': args.jumps = (unsigned int) atoi(optarg); break;
+        case 'J': args.jump_sec = atof(optarg); break;
+        case 'c': args.corrupt = atof(optarg); break;
+        case 'S': args.seed = strtoull(optarg, NULL, 10); break;
+        case 'u': args.start_utc_usec = strtoull(optarg, NULL, 10) * 1000000ULL; break;
+        case 'h':
+            print_usage(stdout);
+            return 0;
+        default:
+            print_usage(stderr);
+            return 1;
+        }
+    }
+    if (args.format.empty() && !args.output.empty()) {
+        const std::string::size_type dot = args.output.rfind('.');
+        if (dot != std::string::npos) args.format = args.output.substr(dot + 1);
+    }
+    if (!args_ok || args.output.empty() || args.duration_sec <= 0. || args.systems < 1 || args.systems > 255 ||
+        (args.format != "tlog" && args.format != "ulg" && args.format != "px4log")) {
+        print_usage(stderr);
+        return 1;
+    }
+
+    // tlog: one file for all systems, else one for each
+    const unsigned int nfiles = (args.format == "tlog") ? 1 : args.systems;
+    for (unsigned int k = 0; k < nfiles; ++k) {
+        const unsigned int sysid = k + 1;
+        const std::string fn = (nfiles > 1) ? file_for_system(args.output, sysid) : args.output;
+        LogGen*gen;
+        if (args.format == "tlog") {
+            gen = new LogGenTlog(args);
+        } else if (args.format == "ulg") {
+            gen = new LogGenUlg(args, sysid);
+        } else {
+            gen = new LogGenPx4(args, sysid);
+        }
+        const bool ok = gen->run(fn);
+        if (ok) {
+            fprintf(stderr, "%s: %llu bytes, %llu messages, %llu corrupted, %u time jumps\n", fn.c_str(),
+                    gen->get_bytes(), gen->get_messages(), gen->get_corrupted(), gen->get_jumps());
+        }
+        delete gen;
+        if (!ok) return 2;
+    }
+    return 0;
+}
@@ -35,7 +35,31 @@ void CmdlineArgs::_print_usage(FILE * stream) const {
     fprintf(stream,
             "  -n  --headless        start without GUI\n"
             "  -j  --max-time-jumps  define max. allowed time jumps between messages (in seconds, default: 100)\n"
-            "  -i  --import          Import file to Database\n"
+            "  -T  --time-jumps      at bigger jumps: ask (GUI, default), ignore (headless default), allow,\n"
+            "                        demux, or a threshold in seconds to demux above and allow below\n"
+            "  -i  --import          import files to database, same as -b -D\n"
+            "  -t  --threads         number of files to parse in parallel (default: 0=one per core)\n"
+            "  -k  --cores           worker threads for all parallel work together (default: GUI settings, or 0=one per core)\n"
+            "  -p  --pipeline        decode and analyze each file in two threads\n"
+            "  -c  --chunked         decode large tlogs in parallel chunks\n"
+            "  -s  --topics          only import these, e.g. \"ATT,GPS,IMU.AccX\" (default: all)\n"
+            "  -w  --time-window     only import onboard logs between these times since boot, e.g. \"120:300\" (in seconds)\n"
+            "  -z  --compress        keep data compressed in memory (slower, but for huge logs)\n"
+            "  -m  --mem-budget      move data to disk when it takes more memory than this (in MB, default: 0=no limit)\n"
+            "  -d  --scratch-dir     where to put data that was moved to disk (default: system's temp directory)\n"
+            "  -C  --no-cache        always parse the logs, do not use or write <log>.mlacache\n"
+            "  -e  --export          headless: write all data into this columnar file (*.mlc), for numpy/pandas\n"
+            "  -P  --profile         measure time of each stage and message type, shown with the overview\n"
+            "  -J  --profile-json    same, and write it to this file as JSON\n"
+            "  -R  --trace           record what each thread does when, and write it to this file at the end\n"
+            "                        (Chrome trace JSON, for chrome://tracing or ui.perfetto.dev)\n"
+            "  -b  --batch           headless, each file on its own; also takes directories and wildcards.\n"
+            "                        Writes <log>.summary.txt. Exit code 2 if a file failed.\n"
+            "  -o  --batch-out       batch: write results into this directory (default: next to each log)\n"
+            "  -x  --batch-export    batch: also write <log>.mlc, see --export\n"
+            "  -D  --batch-db        batch: also save each log to the database of the GUI settings\n"
+            "  -X  --derive          compute a series from others, e.g. \"power [W] = a/volt * a/curr\".\n"
+            "                        Repeat for more. Default: those in the GUI settings\n"
             "  -h  --help            shows this\n"
             );
 }
@@ -53,13 +77,33 @@ bool CmdlineArgs::_file_exists(std::string filename) {
 }
 
 int CmdlineArgs::_parse(int argc, char**argv) {
-    const char *const short_options = "hnj:i"; /* A string listing valid short options letters.  */
+    const char *const short_options = "hnj:it:k:pcs:w:zm:d:Ce:PJ:R:bo:xDT:X:"; /* A string listing valid short options letters.  */
     /* An array describing valid long options.  */
     const struct option long_options[] = {
         {"help",           0, NULL, 'h'},
         {"max-time-jumps", 1, NULL, 'j'},
         {"headless",       0, NULL, 'n'},
+        {"time-jumps",     1, NULL, 'T'},
         {"import",         0, NULL, 'i'},   // Bernd
+        {"threads",        1, NULL, 't'},
+        {"cores",          1, NULL, 'k'},
+        {"pipeline",       0, NULL, 'p'},
+        {"chunked",        0, NULL, 'c'},
+        {"topics",         1, NULL, 's'},
+        {"time-window",    1, NULL, 'w'},
+        {"compress",       0, NULL, 'z'},
+        {"mem-budget",     1, NULL, 'm'},
+        {"scratch-dir",    1, NULL, 'd'},
+        {"no-cache",       0, NULL, 'C'},
+        {"export",         1, NULL, 'e'},
+        {"profile",        0, NULL, 'P'},
+        {"profile-json",   1, NULL, 'J'},
+        {"trace",          1, NULL, 'R'},
+        {"batch",          0, NULL, 'b'},
+        {"batch-out",      1, NULL, 'o'},
+        {"batch-export",   0, NULL, 'x'},
+        {"batch-db",       0, NULL, 'D'},
+        {"derive",         1, NULL, 'X'},
         {NULL, 0, NULL, 0}             /* Required at end of array.  */
     };
 
@@ -77,6 +121,103 @@ int CmdlineArgs::_parse(int argc, char**argv) {
 
         case 'i':
             import = true;
+            batch = true;
+            batch_db = true;
+            break;
+
+        case 'b':
+            batch = true;
+            break;
+
+        case 'o':
+            batch_outdir = optarg;
+            printf("batch results to %s\n", optarg);
+            break;
+
+        case 'x':
+            batch_export = true;
+            break;
+
+        case 'D':
+            batch_db = true;
+            break;
+
+        case 'p':
+            pipeline = true;
+            break;
+
+        case 'c':
+            chunked = true;
+            break;
+
+        case 'z':
+            compress = true;
+            break;
+
+        case 'C':
+            cache = false;
+            break;
+
+        case 'm':
+            {
+                int cand = atoi(optarg);
+                if (cand >= 0) {
+                    mem_budget_mb = cand;
+                    printf("memory budget=%lu MB\n", mem_budget_mb);
+                }
+            }
+            break;
+
+        case 'd':
+            scratch_dir = optarg;
+            printf("scratch dir=%s\n", optarg);
+            break;
+
+        case 'e':
+            export_file = optarg;
+            printf("export to %s\n", optarg);
+            break;
+
+        case 'P':
+            profile = true;
+            break;
+
+        case 'J':
+            profile = true;
+            profile_json = optarg;
+            printf("profile to %s\n", optarg);
+            break;
+
+        case 'R':
+            trace_json = optarg;
+            printf("trace to %s\n", optarg);
+            break;
+
+        case 'X':
+            expressions.push_back(optarg);
+            printf("derive %s\n", optarg);
+            break;
+
+        case 's':
+            if (topics.parse(optarg)) {
+                printf("topics=%s\n", optarg);
+            } else {
+                fprintf(stderr, "Malformed topic selection: \"%s\" ignored.\n", optarg);
+            }
+            break;
+
+        case 'w':
+            {
+                double from, to;
+                if (sscanf(optarg, "%lf:%lf", &from, &to) == 2 && from >= 0. && from <= to) {
+                    time_window = true;
+                    window_from_sec = from;
+                    window_to_sec = to;
+                    printf("time window=%.1lf..%.1lf sec\n", from, to);
+                } else {
+                    fprintf(stderr, "Malformed time window: \"%s\" ignored.\n", optarg);
+                }
+            }
             break;
 
         case 'h':
@@ -94,6 +235,34 @@ int CmdlineArgs::_parse(int argc, char**argv) {
             }
             break;
 
+        case 'T':
+            if (parse_jumps(optarg, time_jumps, jumps_demux_sec)) {
+                printf("time jumps=%s\n", jumps_to_string(time_jumps, jumps_demux_sec).c_str());
+            } else {
+                fprintf(stderr, "Malformed time jump policy: \"%s\" ignored.\n", optarg);
+            }
+            break;
+
+        case 't':
+            {
+                int cand = atoi(optarg);
+                if (cand >= 0) {
+                    threads = cand;
+                    printf("threads=%u\n", threads);
+                }
+            }
+            break;
+
+        case 'k':
+            {
+                int cand = atoi(optarg);
+                if (cand >= 0) {
+                    cores = cand;
+                    printf("cores=%u\n", cores);
+                }
+            }
+            break;
+
         default:    // null terminator etc
             printf("Unrecognized option: \"%c\" ignored.\n", next_option);
             break;
@@ -104,7 +273,9 @@ int CmdlineArgs::_parse(int argc, char**argv) {
         for (int k=optind; k<argc; k++) {
             // there is a rest pending...only handle filename
             string fname(argv[k]);
-            if (!_file_exists(fname)) {
+            if (batch) {
+                filenames.push_back(fname); // resolved by BatchRunner
+            } else if (!_file_exists(fname)) {
                 fprintf(stderr, "Cannot open file: %s\n", fname.c_str());
             } else {
                 printf("Logfile=%s\n", fname.c_str());
@@ -115,7 +286,46 @@ int CmdlineArgs::_parse(int argc, char**argv) {
     return 0;
 }
 
-CmdlineArgs::CmdlineArgs(int argc, char **argv) : valid(false), headless(false), time_maxjump_sec(100.), import(false){
+bool CmdlineArgs::parse_jumps(const std::string & str, jumps_e & policy, double & demux_sec) {
+    if (str == "ask") {
+        policy = JUMPS_ASK;
+    } else if (str == "ignore") {
+        policy = JUMPS_IGNORE;
+    } else if (str == "allow") {
+        policy = JUMPS_ALLOW;
+    } else if (str == "demux") {
+        policy = JUMPS_DEMUX;
+    } else {
+        char*end = NULL;
+        const double sec = strtod(str.c_str(), &end);
+        if (end == str.c_str() || *end != '\0' || !(sec > 0.)) return false;
+        policy = JUMPS_THRESHOLD;
+        demux_sec = sec;
+    }
+    return true;
+}
+
+std::string CmdlineArgs::jumps_to_string(jumps_e policy, double demux_sec) {
+    switch (policy) {
+    case JUMPS_IGNORE: return "ignore";
+    case JUMPS_ALLOW: return "allow";
+    case JUMPS_DEMUX: return "demux";
+    case JUMPS_THRESHOLD:
+        {
+            char buf[32];
+            snprintf(buf, sizeof(buf), "%g", demux_sec);
+            return buf;
+        }
+    case JUMPS_ASK:
+    default:
+        return "ask";
+    }
+}
+
+CmdlineArgs::CmdlineArgs(int argc, char **argv) : valid(false), headless(false), time_maxjump_sec(100.),
+    time_jumps(JUMPS_ASK), jumps_demux_sec(3600.), threads(0), cores(0), pipeline(false), chunked(false),
+    time_window(false), window_from_sec(0.), window_to_sec(0.), compress(false), mem_budget_mb(0), cache(true), profile(false),
+    batch(false), batch_export(false), batch_db(false), import(false){
     if (!_parse(argc, argv)) {
         valid=true;
     }
@@ -26,21 +26,63 @@
 
 #include <list>
 #include <string>
+#include "topicfilter.h"
 
 class CmdlineArgs
 {
 public:
     CmdlineArgs(int argc, char**argv);
 
+    /**
+     * @brief what the importer does when MavLink time jumps by more than time_maxjump_sec
+     */
+    typedef enum {
+        JUMPS_ASK,       ///< GUI: demultiplex, and ask the user afterwards. Headless: same as JUMPS_IGNORE
+        JUMPS_IGNORE,    ///< drop the messages with the jump
+        JUMPS_ALLOW,     ///< tolerate the jump, stay in same scenario
+        JUMPS_DEMUX,     ///< start a new scenario at the jump
+        JUMPS_THRESHOLD  ///< demultiplex at jumps bigger than jumps_demux_sec, tolerate smaller ones
+    } jumps_e;
+
+    /**
+     * @brief parse "ask", "ignore", "allow", "demux", or a threshold in seconds
+     * @return true if understood
+     */
+    static bool parse_jumps(const std::string & str, jumps_e & policy, double & demux_sec);
+    static std::string jumps_to_string(jumps_e policy, double demux_sec);
+
     /****************************************
      *   DATA MEMBERS
      ****************************************/
-    std::list<std::string> filenames;
+    std::list<std::string> filenames; ///< in batch mode also directories and wildcards, as given
     bool valid;    ///< indicate whether parsing went well
     bool headless;  ///< start w/o GUI
     double time_maxjump_sec; ///< how much time is allowed to jump between two successive messages
+    jumps_e time_jumps; ///< what happens at bigger jumps
+    double jumps_demux_sec; ///< for JUMPS_THRESHOLD
+    unsigned int threads; ///< number of files parsed in parallel. 0=one per core
+    unsigned int cores; ///< workers of the TaskPool. 0=those of the GUI settings, else one per core
+    bool pipeline; ///< decode in one thread, build data in another
+    bool chunked; ///< decode large tlogs in byte ranges on all cores
+    TopicFilter topics; ///< which topics/fields to import. Default: all
+    bool time_window; ///< only import [window_from_sec, window_to_sec] of onboard logs
+    double window_from_sec; ///< time since boot
+    double window_to_sec; ///< time since boot
+    bool compress; ///< keep time series compressed in memory
+    unsigned long mem_budget_mb; ///< spill data to disk above this. 0=no limit
+    std::string scratch_dir; ///< where to spill. Empty=system's temp directory
+    bool cache; ///< reopen logs from their ScenarioCache, and write one after parsing
+    std::string export_file; ///< headless: write all data there, see DataExport. Empty=no export
+    bool profile; ///< enable the Profiler
+    std::string profile_json; ///< write the Profiler's counters there at the end. Empty=do not
+    std::string trace_json; ///< record with the Tracer, and write it there at the end. Empty=do not
+    bool batch; ///< headless: each file on its own, see BatchRunner
+    std::string batch_outdir; ///< batch: where results go. Empty=next to each log
+    bool batch_export; ///< batch: write a columnar file for each log
+    bool batch_db; ///< batch: save each log to the database
+    std::list<std::string> expressions; ///< user-defined series, see Expression. Empty=those of the GUI settings
 
-    bool import;               ///Bernd: anaylize File to test DB-Import
+    bool import;               ///< batch which saves all files to the database
 private:
     int _parse(int argc, char**argv);
     void _print_usage(FILE * stream) const;
@@ -0,0 +1,407 @@
+/**
+ * @file conditionsearch.cpp
+ * @brief Where in the loaded data conditions on several series hold, and for how long.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <cstdlib>
+#include <cctype>
+#include <algorithm>
+#include "conditionsearch.h"
+#include "data_timeseries.h"
+#include "stringfun.h"
+#include "filefun.h"
+
+using namespace std;
+
+// shorthand for demuxing polymorphic data
+#define TRY_INPUT_DATATIMESERIES(data, typetest) \
+    if (!in) if (const DataTimeseries<typetest>*tmp = dynamic_cast<const DataTimeseries<typetest> *>(data)) { \
+        in = new SearchInputSeries<typetest>(tmp); \
+    }
+
+// one comparison over a whole block
+#define SEARCH_COMPARE(OP, EXPR) \
+    case OP: for (size_t i = 0; i < n; ++i) mask[i] = (EXPR); break;
+
+/**
+ * @brief finds the intervals of one condition in one series, whatever its type
+ */
+class SearchInput {
+public:
+    typedef ConditionSearch::term_t     term_t;
+    typedef ConditionSearch::interval_t interval_t;
+
+    virtual ~SearchInput() {}
+
+    /**
+     * @param out sorted and disjoint
+     */
+    virtual void find(const term_t & term, std::vector<interval_t> & out) const = 0;
+
+protected:
+    /**
+     * @return 1 if all values in [vmin, vmax] fulfill the term, -1 if none does, 0 if they have to be compared
+     */
+    static int _decide(const term_t & term, double vmin, double vmax) {
+        const double v = term.value;
+        switch (term.op) {
+        case ConditionSearch::CMP_GT:
+            if (vmin > v) return 1;
+            if (vmax <= v) return -1;
+            break;
+        case ConditionSearch::CMP_GE:
+            if (vmin >= v) return 1;
+            if (vmax < v) return -1;
+            break;
+        case ConditionSearch::CMP_LT:
+            if (vmax < v) return 1;
+            if (vmin >= v) return -1;
+            break;
+        case ConditionSearch::CMP_LE:
+            if (vmax <= v) return 1;
+            if (vmin > v) return -1;
+            break;
+        case ConditionSearch::CMP_EQ:
+            if (vmin == v && vmax == v) return 1;
+            if (v < vmin || v > vmax) return -1;
+            break;
+        case ConditionSearch::CMP_NE:
+            if (v < vmin || v > vmax) return 1;
+            if (vmin == v && vmax == v) return -1;
+            break;
+        }
+        return 0;
+    }
+
+    template <typename T>
+    static void _compare(const term_t & term, const std::vector<T> & data, std::vector<char> & mask) {
+        const size_t n = data.size();
+        const double v = term.value;
+        mask.resize(n);
+        switch (term.op) {
+        SEARCH_COMPARE(ConditionSearch::CMP_GT, data[i] > v)
+        SEARCH_COMPARE(ConditionSearch::CMP_GE, data[i] >= v)
+        SEARCH_COMPARE(ConditionSearch::CMP_LT, data[i] < v)
+        SEARCH_COMPARE(ConditionSearch::CMP_LE, data[i] <= v)
+        SEARCH_COMPARE(ConditionSearch::CMP_EQ, data[i] == v)
+        SEARCH_COMPARE(ConditionSearch::CMP_NE, data[i] != v)
+        }
+    }
+};
+
+template <typename T>
+class SearchInputSeries : public SearchInput {
+public:
+    SearchInputSeries(const DataTimeseries<T>*d) : _d(d) {}
+
+    void find(const term_t & term, std::vector<interval_t> & out) const {
+        out.clear();
+        const double offset = _d->get_epoch_datastart() / 1E6;
+        bool open = false;
+        double t_open = 0., t_last = 0.;
+        std::vector<double> t;
+        std::vector<T> v;
+        std::vector<char> mask;
+        for (unsigned int b = 0; b < _d->get_num_blocks(); ++b) {
+            double t_first, t_end;
+            T vmin, vmax;
+            const int decided = _d->get_block_summary(b, t_first, t_end, vmin, vmax) ? _decide(term, (double)vmin, (double)vmax) : 0;
+            if (decided > 0) {
+                if (!open) {
+                    open = true;
+                    t_open = t_first;
+                }
+                t_last = t_end;
+                continue;
+            }
+            if (decided < 0) {
+                if (open) {
+                    _add(out, t_open + offset, t_first + offset);
+                    open = false;
+                }
+                t_last = t_end;
+                continue;
+            }
+
+            _d->get_block(b, t, v);
+            if (t.empty()) continue;
+            _compare(term, v, mask);
+            for (size_t i = 0; i < t.size(); ++i) {
+                if (mask[i]) {
+                    if (!open) {
+                        open = true;
+                        t_open = t[i];
+                    }
+                } else if (open) {
+                    _add(out, t_open + offset, t[i] + offset); // held until this sample
+                    open = false;
+                }
+            }
+            t_last = t.back();
+        }
+        if (open) _add(out, t_open + offset, t_last + offset);
+        if (!_d->is_sorted()) {
+            std::vector<interval_t> sorted;
+            ConditionSearch::unite(out, std::vector<interval_t>(), sorted);
+            out.swap(sorted);
+        }
+    }
+
+private:
+    static void _add(std::vector<interval_t> & out, double t_from, double t_to) {
+        interval_t iv;
+        iv.t_from = t_from;
+        iv.t_to = t_to;
+        out.push_back(iv);
+    }
+
+    const DataTimeseries<T>* _d;
+};
+
+static bool by_start(const ConditionSearch::interval_t & a, const ConditionSearch::interval_t & b) {
+    return a.t_from < b.t_from;
+}
+
+std::string ConditionSearch::_next_word(const std::string & s, size_t & pos) {
+    while (pos < s.size() && isspace((unsigned char)s[pos])) ++pos;
+    const size_t begin = pos;
+    while (pos < s.size() && isalpha((unsigned char)s[pos])) ++pos;
+    std::string w = s.substr(begin, pos - begin);
+    return lcase(w);
+}
+
+std::string ConditionSearch::get_result_name(const std::string & query) {
+    std::string name = query;
+    std::replace(name.begin(), name.end(), '/', '.'); // one subgroup per query would be confusing
+    return SEARCH_GROUP + name;
+}
+
+bool ConditionSearch::parse(const std::string & query) {
+    _query = query;
+    _error.clear();
+    _inputs.clear();
+    _terms.clear();
+    _min_duration = 0.;
+
+    size_t pos = 0;
+    bool or_next = false;
+    while (_error.empty()) {
+        // path
+        while (pos < query.size() && isspace((unsigned char)query[pos])) ++pos;
+        string path;
+        if (pos < query.size() && query[pos] == '"') {
+            const size_t close = query.find('"', pos + 1);
+            if (close == string::npos) {
+                _error = "missing closing '\"'";
+                break;
+            }
+            path = query.substr(pos + 1, close - pos - 1);
+            pos = close + 1;
+        } else {
+            const size_t op = query.find_first_of("<>=!", pos);
+            path = query.substr(pos, (op == string::npos ? query.size() : op) - pos);
+            pos = (op == string::npos) ? query.size() : op;
+            string_trim(path);
+        }
+        if (path.empty()) {
+            _error = "missing data path";
+            break;
+        }
+
+        // operator
+        while (pos < query.size() && isspace((unsigned char)query[pos])) ++pos;
+        term_t term;
+        const string rest = query.substr(pos, 2);
+        if (rest == "<=") { term.op = CMP_LE; pos += 2; }
+        else if (rest == ">=") { term.op = CMP_GE; pos += 2; }
+        else if (rest == "==") { term.op = CMP_EQ; pos += 2; }
+        else if (rest == "!=") { term.op = CMP_NE; pos += 2; }
+        else if (!rest.empty() && rest[0] == '<') { term.op = CMP_LT; pos += 1; }
+        else if (!rest.empty() && rest[0] == '>') { term.op = CMP_GT; pos += 1; }
+        else if (!rest.empty() && rest[0] == '=') { term.op = CMP_EQ; pos += 1; }
+        else {
+            _error = "missing comparison after \"" + path + "\"";
+            break;
+        }
+
+        // value
+        const char*const begin = query.c_str() + pos;
+        char*end = NULL;
+        term.value = strtod(begin, &end);
+        if (end == begin) {
+            _error = "missing number after \"" + path + "\"";
+            break;
+        }
+        pos += end - begin;
+
+        term.or_before = or_next;
+        term.input = std::find(_inputs.begin(), _inputs.end(), path) - _inputs.begin();
+        if (term.input == _inputs.size()) _inputs.push_back(path);
+        _terms.push_back(term);
+
+        // what follows
+        while (pos < query.size() && isspace((unsigned char)query[pos])) ++pos;
+        if (pos >= query.size()) break;
+        if (query.compare(pos, 2, "&&") == 0 || query.compare(pos, 2, "||") == 0) {
+            or_next = (query[pos] == '|');
+            pos += 2;
+            continue;
+        }
+        const string word = _next_word(query, pos);
+        if (word == "and" || word == "with") {
+            or_next = false;
+        } else if (word == "or") {
+            or_next = true;
+        } else if (word == "for") {
+            // for [at least] <number> [s|sec|seconds|min]
+            size_t p = pos;
+            if (_next_word(query, p) == "at") {
+                pos = p;
+                p = pos;
+                if (_next_word(query, p) == "least") pos = p;
+            }
+            const char*const b = query.c_str() + pos;
+            char*e = NULL;
+            const double d = strtod(b, &e);
+            if (e == b || !(d >= 0.)) {
+                _error = "missing duration after \"for\"";
+                break;
+            }
+            pos += e - b;
+            const string unit = _next_word(query, pos);
+            if (unit == "min") {
+                _min_duration = d * 60.;
+            } else if (unit.empty() || unit == "s" || unit == "sec" || unit == "secs" || unit == "seconds") {
+                _min_duration = d;
+            } else {
+                _error = "unknown unit \"" + unit + "\"";
+                break;
+            }
+            while (pos < query.size() && isspace((unsigned char)query[pos])) ++pos;
+            if (pos < query.size()) _error = "unexpected \"" + query.substr(pos) + "\" after the duration";
+            break;
+        } else {
+            _error = "expected \"and\", \"or\" or \"for\" before \"" + query.substr(pos - word.size()) + "\"";
+            break;
+        }
+    }
+
+    if (!_error.empty()) {
+        _inputs.clear();
+        _terms.clear();
+        return false;
+    }
+    return true;
+}
+
+bool ConditionSearch::search(const std::vector<const Data*> & inputs, std::vector<interval_t> & out) const {
+    out.clear();
+    if (_terms.empty() || inputs.size() != _inputs.size()) return false;
+
+    std::vector<SearchInput*> in_series;
+    bool ok = true;
+    for (unsigned int k = 0; k < inputs.size(); ++k) {
+        SearchInput*in = NULL;
+        const Data*const d = inputs[k];
+        if (d) {
+            TRY_INPUT_DATATIMESERIES(d, int);
+            TRY_INPUT_DATATIMESERIES(d, long);
+            TRY_INPUT_DATATIMESERIES(d, float);
+            TRY_INPUT_DATATIMESERIES(d, double);
+            TRY_INPUT_DATATIMESERIES(d, unsigned int);
+            TRY_INPUT_DATATIMESERIES(d, unsigned long);
+            TRY_INPUT_DATATIMESERIES(d, bool);
+        }
+        if (!in) ok = false;
+        in_series.push_back(in);
+    }
+
+    if (ok) {
+        // "and" binds first: intersect within a group, unite the groups
+        std::vector<interval_t> any, group, term, tmp;
+        for (unsigned int k = 0; k < _terms.size(); ++k) {
+            in_series[_terms[k].input]->find(_terms[k], term);
+            if (k == 0) {
+                group.swap(term);
+            } else if (_terms[k].or_before) {
+                unite(any, group, tmp);
+                any.swap(tmp);
+                group.swap(term);
+            } else {
+                intersect(group, term, tmp);
+                group.swap(tmp);
+            }
+        }
+        unite(any, group, tmp);
+
+        for (std::vector<interval_t>::const_iterator it = tmp.begin(); it != tmp.end(); ++it) {
+            if (it->t_to - it->t_from >= _min_duration) out.push_back(*it);
+        }
+    }
+
+    for (std::vector<SearchInput*>::iterator it = in_series.begin(); it != in_series.end(); ++it) {
+        delete *it;
+    }
+    return ok;
+}
+
+void ConditionSearch::intersect(const std::vector<interval_t> & a, const std::vector<interval_t> & b, std::vector<interval_t> & out) {
+    out.clear();
+    size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size()) {
+        const double lo = std::max(a[i].t_from, b[j].t_from);
+        const double hi = std::min(a[i].t_to, b[j].t_to);
+        if (lo < hi || (lo == hi && (a[i].t_from == a[i].t_to || b[j].t_from == b[j].t_to))) {
+            interval_t iv;
+            iv.t_from = lo;
+            iv.t_to = hi;
+            out.push_back(iv);
+        }
+        // drop the one which ends first
+        if (a[i].t_to < b[j].t_to) {
+            ++i;
+        } else {
+            ++j;
+        }
+    }
+}
+
+void ConditionSearch::unite(const std::vector<interval_t> & a, const std::vector<interval_t> & b, std::vector<interval_t> & out) {
+    std::vector<interval_t> all(a);
+    all.insert(all.end(), b.begin(), b.end());
+    if (!a.empty() && !b.empty()) {
+        std::inplace_merge(all.begin(), all.begin() + a.size(), all.end(), by_start);
+    }
+    for (size_t k = 1; k < all.size(); ++k) {
+        if (by_start(all[k], all[k-1])) { // only for unsorted series
+            std::sort(all.begin(), all.end(), by_start);
+            break;
+        }
+    }
+    out.clear();
+    for (std::vector<interval_t>::const_iterator it = all.begin(); it != all.end(); ++it) {
+        if (!out.empty() && it->t_from <= out.back().t_to) {
+            if (it->t_to > out.back().t_to) out.back().t_to = it->t_to;
+        } else {
+            out.push_back(*it);
+        }
+    }
+}
@@ -0,0 +1,119 @@
+/**
+ * @file conditionsearch.h
+ * @brief Where in the loaded data conditions on several series hold, and for how long.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef CONDITIONSEARCH_H
+#define CONDITIONSEARCH_H
+
+#include <string>
+#include <vector>
+
+class Data;
+
+#define SEARCH_GROUP "search/" ///< results go below this
+
+/**
+ * @brief A query like
+ *
+ *   vibe/clip > 10 with airspeed < 8 for at least 2 s
+ *
+ * i.e., conditions "path op number" (op one of < <= > >= == !=) joined by "and" (or
+ * "with", "&&") and "or" ("||"), where "and" binds first, optionally followed by a
+ * minimum duration in seconds. The "for" applies to the whole query. See
+ * MavSystem::apply_search(), which finds the paths in one system.
+ *
+ * A sample fulfills a condition from its time until the next sample (sample and hold).
+ * Each condition is turned into time intervals, which are then intersected and united.
+ * Blocks of samples (see DataTimeseries<T>::get_block_summary()) whose value range
+ * decides the condition for all of them are neither decoded nor compared; the others are
+ * compared in a tight loop.
+ */
+class ConditionSearch
+{
+public:
+    ConditionSearch() : _min_duration(0.) {}
+
+    typedef struct interval_s {
+        double t_from; ///< epoch seconds
+        double t_to;
+    } interval_t;
+
+    /**
+     * @brief replace the current query
+     * @return false if malformed, see get_error(). There are no conditions then.
+     */
+    bool parse(const std::string & query);
+
+    bool is_valid(void) const { return !_terms.empty(); }
+    const std::string & get_error(void) const { return _error; }
+    const std::string & get_query(void) const { return _query; }
+    double get_min_duration(void) const { return _min_duration; }
+
+    /**
+     * @brief where MavSystem::apply_search() puts the result of this query
+     */
+    static std::string get_result_name(const std::string & query);
+
+    /**
+     * @brief the paths the conditions are on, each once, in order of appearance
+     */
+    const std::vector<std::string> & get_inputs(void) const { return _inputs; }
+
+    /**
+     * @brief run the query
+     * @param inputs series for get_inputs(), same order
+     * @param out sorted and disjoint, each at least get_min_duration() long
+     * @return false if an input is no numeric time series
+     */
+    bool search(const std::vector<const Data*> & inputs, std::vector<interval_t> & out) const;
+
+    /**
+     * @brief a & b, and a | b. Both sorted and disjoint, like the result
+     */
+    static void intersect(const std::vector<interval_t> & a, const std::vector<interval_t> & b, std::vector<interval_t> & out);
+    static void unite(const std::vector<interval_t> & a, const std::vector<interval_t> & b, std::vector<interval_t> & out);
+
+private:
+    typedef enum { CMP_LT, CMP_LE, CMP_GT, CMP_GE, CMP_EQ, CMP_NE } cmp_e;
+
+    typedef struct term_s {
+        unsigned int input; ///< index in _inputs
+        cmp_e        op;
+        double       value;
+        bool         or_before; ///< "or" between this and the previous term, else "and"
+    } term_t;
+
+    static std::string _next_word(const std::string & s, size_t & pos);
+
+    /****************************************
+     *   DATA MEMBERS
+     ****************************************/
+    std::string              _query;
+    std::string              _error;
+    std::vector<std::string> _inputs;
+    std::vector<term_t>      _terms;
+    double                   _min_duration;
+
+    friend class SearchInput;
+};
+
+#endif // CONDITIONSEARCH_H
@@ -0,0 +1,177 @@
+/**
+ * @file csvwriter.cpp
+ * @brief Buffered writer for text exports, with fast number formatting.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <math.h>
+#include <string.h>
+#include "csvwriter.h"
+
+#define CSV_DIGITS 9 ///< significant digits of floating point values
+#define CSV_MAXNUM 32 ///< longest formatted number
+
+static const double g_pow10[] = { 1E0, 1E1, 1E2, 1E3, 1E4, 1E5, 1E6, 1E7, 1E8, 1E9, 1E10, 1E11, 1E12, 1E13 };
+
+/**
+ * @brief v*10^k rounded to an integer, half to even like printf
+ */
+static inline unsigned long long scale_round(double v, int k) {
+    const double s = v * g_pow10[k];
+    const double f = floor(s);
+    unsigned long long m = (unsigned long long) f;
+    const double r = s - f;
+    if (r > 0.5 || (r == 0.5 && (m & 1))) ++m;
+    return m;
+}
+
+CsvWriter::CsvWriter(const std::string & filename, unsigned int bufsize) :
+    _file(fopen(filename.c_str(), "wb")), _buf(bufsize < 4*CSV_MAXNUM ? 4*CSV_MAXNUM : bufsize), _fill(0), _error(false) {
+    if (_file) setvbuf(_file, NULL, _IONBF, 0); // we have our own buffer
+}
+
+CsvWriter::~CsvWriter() {
+    close();
+}
+
+bool CsvWriter::close(void) {
+    if (!_file) return false;
+    _flush();
+    if (fclose(_file) != 0) _error = true;
+    _file = NULL;
+    return !_error;
+}
+
+void CsvWriter::_flush(void) {
+    if (_fill == 0) return;
+    if (!_file || fwrite(&_buf[0], 1, _fill, _file) != _fill) _error = true;
+    _fill = 0;
+}
+
+void CsvWriter::_put(const char*s, size_t len) {
+    if (len > _buf.size()) {
+        _flush();
+        if (!_file || fwrite(s, 1, len, _file) != len) _error = true;
+        return;
+    }
+    memcpy(_reserve(len), s, len);
+    _fill += len;
+}
+
+CsvWriter & CsvWriter::operator<<(char c) {
+    *_reserve(1) = c;
+    _fill++;
+    return *this;
+}
+
+CsvWriter & CsvWriter::operator<<(const char*s) {
+    _put(s, strlen(s));
+    return *this;
+}
+
+CsvWriter & CsvWriter::operator<<(const std::string & s) {
+    _put(s.data(), s.size());
+    return *this;
+}
+
+CsvWriter & CsvWriter::operator<<(double v) {
+    char*const p = _reserve(CSV_MAXNUM);
+    _fill += format(p, v) - p;
+    return *this;
+}
+
+CsvWriter & CsvWriter::operator<<(unsigned long long v) {
+    char tmp[CSV_MAXNUM];
+    char*q = tmp + CSV_MAXNUM;
+    do {
+        *--q = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    _put(q, tmp + CSV_MAXNUM - q);
+    return *this;
+}
+
+CsvWriter & CsvWriter::operator<<(long long v) {
+    if (v < 0) {
+        operator<<('-');
+        return operator<<(0ULL - (unsigned long long)v);
+    }
+    return operator<<((unsigned long long)v);
+}
+
+char* CsvWriter::format(char*p, double v) {
+    if (v != v) {
+        memcpy(p, "nan", 3);
+        return p + 3;
+    }
+    if (v < 0 || (v == 0 && signbit(v))) {
+        *p++ = '-';
+        v = -v;
+    }
+    if (v == 0) {
+        *p++ = '0';
+        return p;
+    }
+    // printf switches to exponent notation outside of [1E-4, 1E9). Rare in logs, leave it to printf.
+    if (!(v >= 1E-4 && v < 1E9)) {
+        return p + snprintf(p, CSV_MAXNUM, "%.9g", v);
+    }
+
+    // v = m * 10^(e-8), with exactly 9 digits in m
+    int e = (int) floor(log10(v));
+    if (e < -4) e = -4;
+    if (e > 8) e = 8;
+    unsigned long long m = scale_round(v, 8 - e);
+    if (m >= 1000000000ULL) { // log10 too small, or rounding went up to the next power
+        if (e == 8) return p + snprintf(p, CSV_MAXNUM, "%.9g", v);
+        ++e;
+        m = scale_round(v, 8 - e);
+    } else if (m < 100000000ULL && e > -4) { // log10 too large
+        --e;
+        m = scale_round(v, 8 - e);
+        if (m >= 1000000000ULL) m /= 10, ++e; // 9.99999999995 and the like
+    }
+
+    char d[CSV_DIGITS];
+    for (int k = CSV_DIGITS - 1; k >= 0; --k) {
+        d[k] = (char)('0' + m % 10);
+        m /= 10;
+    }
+    int nd = CSV_DIGITS; // without trailing zeros
+    while (nd > 1 && d[nd - 1] == '0') --nd;
+
+    if (e >= 0) {
+        const int nint = e + 1;
+        memcpy(p, d, nint);
+        p += nint;
+        if (nd > nint) {
+            *p++ = '.';
+            memcpy(p, d + nint, nd - nint);
+            p += nd - nint;
+        }
+    } else {
+        *p++ = '0';
+        *p++ = '.';
+        for (int k = 0; k < -e - 1; ++k) *p++ = '0';
+        memcpy(p, d, nd);
+        p += nd;
+    }
+    return p;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file csvwriter.h
+ * @brief Buffered writer for text exports, with fast number formatting.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef CSVWRITER_H
+#define CSVWRITER_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Writes text into a file through a large buffer, so that a line costs no system call.
+ * Numbers are formatted by hand; floating point values like printf("%.9g") (which is what
+ * the exports wrote through std::setprecision(9) before), but mostly without printf.
+ *
+ * CsvWriter w(filename); w << t << "," << v << '\n'; ... ok = w.close();
+ */
+class CsvWriter
+{
+public:
+    explicit CsvWriter(const std::string & filename, unsigned int bufsize = 1 << 20);
+    ~CsvWriter();
+
+    bool is_open(void) const { return _file != NULL; }
+
+    CsvWriter & operator<<(double v);
+    CsvWriter & operator<<(float v) { return operator<<((double)v); }
+    CsvWriter & operator<<(long long v);
+    CsvWriter & operator<<(unsigned long long v);
+    CsvWriter & operator<<(int v) { return operator<<((long long)v); }
+    CsvWriter & operator<<(unsigned int v) { return operator<<((unsigned long long)v); }
+    CsvWriter & operator<<(long v) { return operator<<((long long)v); }
+    CsvWriter & operator<<(unsigned long v) { return operator<<((unsigned long long)v); }
+    CsvWriter & operator<<(bool v) { return operator<<(v ? '1' : '0'); }
+    CsvWriter & operator<<(char c);
+    CsvWriter & operator<<(const char*s);
+    CsvWriter & operator<<(const std::string & s);
+
+    /**
+     * @brief write what is buffered and close the file
+     * @return false if anything could not be written
+     */
+    bool close(void);
+
+    /**
+     * @brief format like printf("%.9g"), without the terminating zero
+     * @param buf at least 32 chars
+     * @return end of the written text
+     */
+    static char* format(char*buf, double v);
+
+private:
+    void _put(const char*s, size_t len);
+    void _flush(void);
+    char* _reserve(size_t len) {
+        if (_fill + len > _buf.size()) _flush();
+        return &_buf[_fill];
+    }
+
+    // forbid copies
+    CsvWriter(const CsvWriter&);
+    CsvWriter& operator=(const CsvWriter&);
+
+    FILE*             _file;
+    std::vector<char> _buf;
+    size_t            _fill;  ///< used part of _buf
+    bool              _error;
+};
+
+#endif // CSVWRITER_H
@@ -23,4 +23,5 @@
 
 #include "data.h"
 
-unsigned int Data::_autoincrement = 0; ///< initial value
+QAtomicInt Data::_autoincrement(0); ///< initial value
+QAtomicInt Data::_viewclock(0);
@@ -25,23 +25,26 @@
 #define DATA_H
 
 #include <string>
+#include <math.h>
+#include <QAtomicInt>
 #include "treeitem.h"
 #include "datagroup.h"
+#include "memuse.h"
 #include "debugtype.h"
 
 class Data : public TreeItem
 {
 public:
     // CTOR
-    Data(std::string name) : _valid (false), _name(name), _class(DATA_RAW), _time_epoch_datastart_usec(0), _deferredLoad(false), _dbid(0) {
-        _id = _autoincrement++;
+    Data(std::string name) : _valid (false), _name(name), _class(DATA_RAW), _time_epoch_datastart_usec(0), _deferredLoad(false), _dbid(0), _overview(false), _detail_from(NAN), _detail_to(NAN), _raw_input(false), _last_viewed(0), _revision(0), _saved_revision(0), _saved_size(0) {
+        _id = _autoincrement.fetchAndAddRelaxed(1);
         itemtype=DATA;
         parent = NULL;
     }
 
     // copy CTOR
     Data(const Data & other) {
-        _id = _autoincrement++; // ID is always unique
+        _id = _autoincrement.fetchAndAddRelaxed(1); // ID is always unique, also when parsing in several threads
         parent = other.parent;
         itemtype = other.itemtype;
         _valid = other._valid;
@@ -51,6 +54,14 @@ public:
         _units = other._units;
         _deferredLoad = other._deferredLoad;
         _dbid = other._dbid;
+        _overview = other._overview;
+        _detail_from = other._detail_from;
+        _detail_to = other._detail_to;
+        _raw_input = other._raw_input;
+        _last_viewed = other._last_viewed;
+        _revision = 0; // another id anyway
+        _saved_revision = 0; // not saved itself
+        _saved_size = 0;
     }
 
     /**
@@ -105,6 +116,12 @@ public:
      */
     virtual Data* Clone() const = 0;
 
+    /**
+     * @brief same as Clone(), but may take the samples away from this instead of copying
+     * them. Afterwards this is empty, as after clear().
+     */
+    virtual Data* Take() { return Clone(); }
+
     /**
      * @brief reset the class to initial state; such as if CTOR was processed,
      * but no data yet added.
@@ -119,6 +136,19 @@ public:
      */
     virtual bool merge_in(const Data * const other) = 0;
 
+    /**
+     * @brief same as calling merge_in() for each of others, in order. Subclasses can do
+     * this in one pass.
+     * @return false if any of them could not be merged
+     */
+    virtual bool merge_in_all(const std::vector<const Data*> & others) {
+        bool ok = true;
+        for (std::vector<const Data*>::const_iterator it = others.begin(); it != others.end(); ++it) {
+            ok = merge_in(*it) && ok;
+        }
+        return ok;
+    }
+
     /**
      * @brief get statistics in a given time window. considering interpolation if t_min or t_max is between samples.
      * @param s holds the statistics.
@@ -178,6 +208,19 @@ public:
      */
     virtual unsigned long get_epoch_dataend() const = 0;
 
+    /**
+     * @brief add the memory taken by this item to m: samples, unused capacity and metadata.
+     * Subclasses count their samples; this only counts the object and its names.
+     */
+    virtual void get_memory(memuse_t & m) const { _count_memory(m, sizeof(*this)); }
+
+    /**
+     * @brief give back capacity which the samples do not use, e.g., when no more samples
+     * will be added. Not while other threads read this.
+     * @return bytes freed
+     */
+    virtual size_t shrink_to_fit(void) { return 0; }
+
     /****************************************************
      *  FUNCTIONS THAT THIS ABSTRACT CLASS PROVIDES
      ****************************************************/
@@ -215,6 +258,29 @@ public:
      */
     unsigned int get_id() const { return _id; }
 
+    /**
+     * @brief counts changes of the samples other than appending, e.g., clear(), merge_in(),
+     * make_periodic(). Together with get_id() and size(), derived views (see StatsCache) can
+     * tell whether they are still up to date.
+     */
+    unsigned int get_revision(void) const { return _revision; }
+
+    /**
+     * @brief content hash of the samples as they are in the DB, see DBConnector. Kept while
+     * the data does not change, so that saving again need not hash it again.
+     * @return false if there is none, or the data changed since (dirty)
+     */
+    bool get_saved_hash(std::string & hash) const {
+        if (_saved_hash.empty() || _saved_revision != _revision || _saved_size != size()) return false;
+        hash = _saved_hash;
+        return true;
+    }
+    void set_saved_hash(const std::string & hash) const {
+        _saved_hash = hash;
+        _saved_revision = _revision;
+        _saved_size = size();
+    }
+
     /**
      * @brief set data to be loaded on demand. the parameter gives the ID in the database
      */    
@@ -223,6 +289,44 @@ public:
     bool is_deferred(void) const { return _deferredLoad; }
     unsigned long long get_dbid(void) const { return _dbid; }
 
+    /**
+     * @brief data holds only the overview from the DB (see DBConnector::loadDataOverview()),
+     * and all samples only between detail_from and detail_to, if given
+     */
+    void set_overview(bool yes, double detail_from = NAN, double detail_to = NAN) {
+        _overview = yes;
+        _detail_from = detail_from;
+        _detail_to = detail_to;
+    }
+    bool is_overview(void) const { return _overview; }
+
+    /**
+     * @return false if there are no details, see set_overview()
+     */
+    bool get_detail_window(double & from, double & to) const {
+        from = _detail_from;
+        to = _detail_to;
+        return _overview && !isnan(_detail_from);
+    }
+
+    /**
+     * @brief marks data which is read by the postprocessors, but hardly looked at itself.
+     * Such data is the first to leave memory when the scenario is over its budget.
+     */
+    void set_raw_input(bool raw_input) { _raw_input = raw_input; }
+    bool is_raw_input(void) const { return _raw_input; }
+
+    /**
+     * @brief the user looks at the data now, e.g., in a plot. Data which was viewed
+     * recently is the last to leave memory.
+     */
+    void mark_viewed(void) const { _last_viewed = _viewclock.fetchAndAddRelaxed(1) + 1; }
+
+    /**
+     * @return when the data was viewed the last time, in arbitrary ascending units. 0=never
+     */
+    unsigned int get_last_viewed(void) const { return _last_viewed; }
+
     /**
      * @brief get the name of the data, including path
      * @param src
@@ -256,17 +360,42 @@ protected:
     bool                _valid;
     std::string         _name;    
     data_classifier_e   _class;
-    static unsigned int _autoincrement; ///< every data class get's a unique ID here.
+    static QAtomicInt _autoincrement; ///< every data class get's a unique ID here.
     unsigned long       _time_epoch_datastart_usec; ///< absolute time when the data starts, expressed in epoch usec
     std::string         _units;
 
     // database
     bool                _deferredLoad; ///< if true, then the class is empty and not yet polulated... (DB)
     unsigned long long  _dbid; ///< ID in table datagroups
+    bool                _overview; ///< see set_overview()
+    double              _detail_from, _detail_to;
+
+    // memory budget
+    bool                _raw_input; ///< see set_raw_input()
+    mutable unsigned int _last_viewed; ///< see mark_viewed()
+    static QAtomicInt   _viewclock;
+
+    unsigned int        _revision; ///< see get_revision()
+    mutable std::string  _saved_hash; ///< see get_saved_hash()
+    mutable unsigned int _saved_revision;
+    mutable unsigned int _saved_size;
 
     /***********************************
      *  FUNCTIONS
      ***********************************/
+    /**
+     * @brief subclasses call this when samples changed other than by appending
+     */
+    void _touch(void) { _revision++; }
+
+    /**
+     * @brief count the object (of size objsize) and its names as metadata
+     */
+    void _count_memory(memuse_t & m, size_t objsize) const {
+        m.meta += objsize + _name.capacity() + _units.capacity();
+        m.items++;
+    }
+
     virtual std::string _verbose_data_class () const {
     switch (_class) {
         case DATA_RAW:
@@ -278,6 +407,7 @@ protected:
         }
     }
     friend class DBConnector;
+    friend class ScenarioCache;
 };
 
 #endif // DATA_H
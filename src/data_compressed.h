@@ -0,0 +1,413 @@
+/**
+ * @file data_compressed.h
+ * @brief Compressed storage for timed samples: delta-of-delta time stamps and XOR values, in blocks.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef DATA_COMPRESSED_H
+#define DATA_COMPRESSED_H
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <inttypes.h>
+#include <math.h>
+
+/**
+ * @brief bit fields of up to 64 bits, MSB first, in a stream of 64-bit words
+ */
+class BitStream
+{
+public:
+    BitStream() : _nbits(0) {}
+
+    void put(uint64_t bits, unsigned int n) {
+        if (n == 0) return;
+        if (n < 64) bits &= (((uint64_t)1) << n) - 1;
+        const unsigned int off = _nbits & 63;
+        if (off == 0) _words.push_back(0);
+        const unsigned int room = 64 - off;
+        if (n <= room) {
+            _words.back() |= bits << (room - n);
+        } else {
+            _words.back() |= bits >> (n - room);
+            _words.push_back(bits << (64 - (n - room)));
+        }
+        _nbits += n;
+    }
+
+    /**
+     * @brief read n bits at pos, and advance pos
+     */
+    uint64_t get(size_t & pos, unsigned int n) const {
+        if (n == 0) return 0;
+        const size_t w = pos >> 6;
+        const unsigned int off = pos & 63;
+        const unsigned int room = 64 - off;
+        uint64_t v = (_words[w] << off) >> (64 - std::min(n, room));
+        if (n > room) {
+            const unsigned int rest = n - room;
+            v = (v << rest) | (_words[w+1] >> (64 - rest));
+        }
+        pos += n;
+        return v;
+    }
+
+    size_t size(void) const { return _nbits; }
+    size_t get_bytes(void) const { return _words.capacity() * sizeof(uint64_t); }
+    void squeeze(void) { std::vector<uint64_t>(_words).swap(_words); }
+    void clear(void) { std::vector<uint64_t>().swap(_words); _nbits = 0; }
+
+private:
+    std::vector<uint64_t> _words;
+    size_t                _nbits;
+};
+
+/**
+ * @brief Samples of a timeseries, compressed like in Facebook's Gorilla:
+ *  - time stamps which are whole microseconds (the usual case, they come from
+ *    integer clocks) are stored as delta of deltas, which is mostly one bit for
+ *    periodic data. Other time stamps are XOR coded like the values.
+ *  - values are XOR coded against their predecessor, which is short for slowly
+ *    changing values.
+ *  - values of blocks with few changes (flags, modes, fix types, ...) are run-length
+ *    coded instead: the length of each run, and its value XOR coded against the previous run.
+ * Both are lossless. Samples are grouped into blocks of BLOCK_LEN, each with a header
+ * carrying time span and min/max, so that single blocks can be decoded.
+ *
+ * T must be at most 8 bytes (bit patterns are handled as uint64_t).
+ * Read-only after encode().
+ */
+template <typename T>
+class CompressedSeries
+{
+public:
+    enum { BLOCK_LEN = 1024 };
+    enum { RUN_BITS = 10 }; ///< run length-1 of the run-length coded values. BLOCK_LEN must fit.
+
+    typedef struct {
+        double       t_first;
+        double       t_last;
+        T            min;
+        T            max;
+        unsigned int n;        ///< number of samples
+        size_t       bitpos;   ///< where the block starts in the stream
+        bool         int_time; ///< time stamps are delta-of-delta microseconds, else XOR coded
+        bool         runs;     ///< values are run-length coded, else XOR coded
+    } block_info;
+
+    CompressedSeries() : _n(0) {}
+
+    /**
+     * @brief replaces contents by given samples
+     * @return false if sizes differ or T cannot be coded
+     */
+    bool encode(const std::vector<double> & time, const std::vector<T> & data) {
+        clear();
+        if (time.size() != data.size() || sizeof(T) > 8) return false;
+        _n = data.size();
+        for (size_t lo = 0; lo < _n; lo += BLOCK_LEN) {
+            _encode_block(time, data, lo, std::min(_n, lo + (size_t)BLOCK_LEN));
+        }
+        _bits.squeeze();
+        return true;
+    }
+
+    /**
+     * @brief samples of block b. Output is resized.
+     */
+    void decode_block(unsigned int b, std::vector<double> & time, std::vector<T> & data) const {
+        const block_info & h = _blocks[b];
+        time.resize(h.n);
+        data.resize(h.n);
+        size_t pos = h.bitpos;
+        _decode_times(h, pos, time);
+        XorState xs;
+        if (h.runs) {
+            for (unsigned int k = 0; k < h.n; ) {
+                const unsigned int len = std::min((unsigned int)_bits.get(pos, RUN_BITS) + 1, h.n - k);
+                const T v = _from_bits(xs.decode(_bits, pos, sizeof(T)*8));
+                for (unsigned int j = 0; j < len; ++j) data[k++] = v;
+            }
+            return;
+        }
+        for (unsigned int k = 0; k < h.n; ++k) {
+            data[k] = _from_bits(xs.decode(_bits, pos, sizeof(T)*8));
+        }
+    }
+
+    /**
+     * @brief all samples. Output is replaced.
+     */
+    void decode_all(std::vector<double> & time, std::vector<T> & data) const {
+        time.clear();
+        data.clear();
+        time.reserve(_n);
+        data.reserve(_n);
+        std::vector<double> bt;
+        std::vector<T> bd;
+        for (unsigned int b = 0; b < _blocks.size(); ++b) {
+            decode_block(b, bt, bd);
+            time.insert(time.end(), bt.begin(), bt.end());
+            data.insert(data.end(), bd.begin(), bd.end());
+        }
+    }
+
+    /**
+     * @return first block which ends at or after t. Only meaningful if times are sorted.
+     * get_num_blocks() if there is none.
+     */
+    unsigned int find_block(double t) const {
+        return std::lower_bound(_blocks.begin(), _blocks.end(), t, &CompressedSeries::_ends_before) - _blocks.begin();
+    }
+
+    unsigned int get_num_blocks(void) const { return _blocks.size(); }
+    const block_info & get_block_info(unsigned int b) const { return _blocks[b]; }
+    size_t size(void) const { return _n; }
+
+    /**
+     * @return approx. memory in use
+     */
+    size_t get_bytes(void) const { return _bits.get_bytes() + _blocks.capacity()*sizeof(block_info); }
+
+    void clear(void) {
+        _bits.clear();
+        std::vector<block_info>().swap(_blocks);
+        _n = 0;
+    }
+
+private:
+    /**
+     * @brief Gorilla XOR coding of a sequence of bit patterns
+     */
+    class XorState {
+    public:
+        XorState() : _first(true), _prev(0), _lead(0), _trail(0), _window(false) {}
+
+        void encode(BitStream & bs, uint64_t v, unsigned int width) {
+            if (_first) {
+                bs.put(v, width);
+                _first = false;
+                _prev = v;
+                return;
+            }
+            const uint64_t x = v ^ _prev;
+            _prev = v;
+            if (x == 0) {
+                bs.put(0, 1);
+                return;
+            }
+            const unsigned int lead = std::min(_clz(x), 63u), trail = _ctz(x);
+            if (_window && lead >= _lead && trail >= _trail) {
+                // meaningful bits fit into the previous window
+                bs.put(2, 2);
+                bs.put(x >> _trail, 64 - _lead - _trail);
+            } else {
+                const unsigned int len = 64 - lead - trail;
+                bs.put(3, 2);
+                bs.put(lead, 6);
+                bs.put(len - 1, 6);
+                bs.put(x >> trail, len);
+                _lead = lead;
+                _trail = trail;
+                _window = true;
+            }
+        }
+
+        uint64_t decode(const BitStream & bs, size_t & pos, unsigned int width) {
+            if (_first) {
+                _first = false;
+                _prev = bs.get(pos, width);
+                return _prev;
+            }
+            if (bs.get(pos, 1) == 0) return _prev;
+            if (bs.get(pos, 1) == 1) {
+                _lead = bs.get(pos, 6);
+                const unsigned int len = bs.get(pos, 6) + 1;
+                _trail = 64 - _lead - len;
+            }
+            _prev ^= bs.get(pos, 64 - _lead - _trail) << _trail;
+            return _prev;
+        }
+
+    private:
+        bool         _first;
+        uint64_t     _prev;
+        unsigned int _lead;
+        unsigned int _trail;
+        bool         _window; ///< _lead and _trail are set
+    };
+
+    static unsigned int _clz(uint64_t x) {
+#ifdef __GNUC__
+        return __builtin_clzll(x);
+#else
+        unsigned int n = 0;
+        while (!(x & (((uint64_t)1) << 63))) { x <<= 1; n++; }
+        return n;
+#endif
+    }
+
+    static unsigned int _ctz(uint64_t x) {
+#ifdef __GNUC__
+        return __builtin_ctzll(x);
+#else
+        unsigned int n = 0;
+        while (!(x & 1)) { x >>= 1; n++; }
+        return n;
+#endif
+    }
+
+    static uint64_t _to_bits(const T & v) {
+        uint64_t b = 0;
+        memcpy(&b, &v, sizeof(T));
+        return b;
+    }
+
+    static T _from_bits(uint64_t b) {
+        T v;
+        memcpy(&v, &b, sizeof(T));
+        return v;
+    }
+
+    static uint64_t _time_to_bits(double v) {
+        uint64_t b;
+        memcpy(&b, &v, sizeof(double));
+        return b;
+    }
+
+    static double _time_from_bits(uint64_t b) {
+        double v;
+        memcpy(&v, &b, sizeof(double));
+        return v;
+    }
+
+    static uint64_t _zigzag(int64_t v) { return (((uint64_t)v) << 1) ^ (uint64_t)(v >> 63); }
+    static int64_t _unzigzag(uint64_t z) { return (int64_t)(z >> 1) ^ -(int64_t)(z & 1); }
+
+    /**
+     * @return true if t is a whole number of microseconds, that converts back exactly
+     */
+    static bool _to_usec(double t, int64_t & us) {
+        if (!(fabs(t) < 1E9)) return false; // also NaN
+        us = (int64_t) floor(t*1E6 + 0.5);
+        return (double)us / 1E6 == t;
+    }
+
+    static bool _ends_before(const block_info & b, double t) { return b.t_last < t; }
+
+    void _encode_block(const std::vector<double> & time, const std::vector<T> & data, size_t lo, size_t hi) {
+        block_info h;
+        h.t_first = time[lo];
+        h.t_last = time[hi-1];
+        h.min = h.max = data[lo];
+        h.n = hi - lo;
+        h.bitpos = _bits.size();
+        h.int_time = true;
+        std::vector<int64_t> us(h.n);
+        for (size_t k = lo; k < hi && h.int_time; ++k) {
+            h.int_time = _to_usec(time[k], us[k - lo]);
+        }
+
+        // time stamps
+        if (h.int_time) {
+            _bits.put(_zigzag(us[0]), 64);
+            int64_t delta = 0;
+            for (unsigned int k = 1; k < h.n; ++k) {
+                const int64_t d = us[k] - us[k-1];
+                const uint64_t z = _zigzag(d - delta);
+                delta = d;
+                if (z == 0) {
+                    _bits.put(0, 1);
+                } else if (z < (1u << 7)) {
+                    _bits.put(2, 2);
+                    _bits.put(z, 7);
+                } else if (z < (1u << 9)) {
+                    _bits.put(6, 3);
+                    _bits.put(z, 9);
+                } else if (z < (1u << 12)) {
+                    _bits.put(14, 4);
+                    _bits.put(z, 12);
+                } else if (z < (((uint64_t)1) << 32)) {
+                    _bits.put(30, 5);
+                    _bits.put(z, 32);
+                } else {
+                    _bits.put(31, 5);
+                    _bits.put(z, 64);
+                }
+            }
+        } else {
+            XorState xs;
+            for (size_t k = lo; k < hi; ++k) xs.encode(_bits, _time_to_bits(time[k]), 64);
+        }
+
+        // values. Repeated ones take a bit each when XOR coded, and one run takes RUN_BITS.
+        unsigned int nruns = 1;
+        for (size_t k = lo; k < hi; ++k) {
+            const T & v = data[k];
+            if (v < h.min) h.min = v;
+            if (v > h.max) h.max = v;
+            if (k > lo && _to_bits(v) != _to_bits(data[k-1])) nruns++;
+        }
+        h.runs = (nruns*(RUN_BITS + 1) < h.n);
+        XorState xs;
+        if (h.runs) {
+            for (size_t k = lo; k < hi; ) {
+                const uint64_t b = _to_bits(data[k]);
+                size_t e = k + 1;
+                while (e < hi && _to_bits(data[e]) == b) e++;
+                _bits.put(e - k - 1, RUN_BITS);
+                xs.encode(_bits, b, sizeof(T)*8);
+                k = e;
+            }
+        } else {
+            for (size_t k = lo; k < hi; ++k) xs.encode(_bits, _to_bits(data[k]), sizeof(T)*8);
+        }
+        _blocks.push_back(h);
+    }
+
+    void _decode_times(const block_info & h, size_t & pos, std::vector<double> & time) const {
+        if (!h.int_time) {
+            XorState xs;
+            for (unsigned int k = 0; k < h.n; ++k) time[k] = _time_from_bits(xs.decode(_bits, pos, 64));
+            return;
+        }
+        int64_t us = _unzigzag(_bits.get(pos, 64));
+        int64_t delta = 0;
+        time[0] = (double)us / 1E6;
+        for (unsigned int k = 1; k < h.n; ++k) {
+            unsigned int tag = 0;
+            while (tag < 5 && _bits.get(pos, 1) == 1) tag++;
+            static const unsigned int widths[] = {0, 7, 9, 12, 32, 64};
+            delta += _unzigzag(_bits.get(pos, widths[tag]));
+            us += delta;
+            time[k] = (double)us / 1E6;
+        }
+    }
+
+    /****************************************
+     *     DATA MEMBERS
+     ****************************************/
+    BitStream               _bits;
+    std::vector<block_info> _blocks;
+    size_t                  _n;
+};
+
+#endif // DATA_COMPRESSED_H
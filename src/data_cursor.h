@@ -0,0 +1,152 @@
+/**
+ * @file data_cursor.h
+ * @brief Forward cursors over DataTimeseries, for aligning several series without searching.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef DATA_CURSOR_H
+#define DATA_CURSOR_H
+
+#include <vector>
+#include <algorithm>
+#include "data_timeseries.h"
+
+/**
+ * @brief Same as DataTimeseries<T>::get_data_at_time(), but remembers where the last
+ * query ended. When the query times are non-decreasing (the usual case: walking along
+ * another series), each query costs O(1) amortized instead of a scan from the start.
+ * Going back in time is allowed, it just costs a binary search. Series that are not
+ * sorted by time fall back to DataTimeseries<T>::get_data_at_time().
+ *
+ * The series must not change while the cursor is used.
+ */
+template <typename T>
+class DataCursor
+{
+public:
+    DataCursor(const DataTimeseries<T>*series) : _series(series), _idx(0) {}
+
+    /**
+     * @brief interpolated value at relative time t
+     * @return false if t is outside the series (no extrapolation), like get_data_at_time()
+     */
+    bool get_data_at_time(double t, T & val) {
+        if (!_series) return false;
+        const std::vector<double> & times = _series->get_time();
+        const std::vector<T> & data = _series->get_data();
+        const unsigned int n = _series->size();
+        if (n == 0 || t > _series->get_max_time() || t < _series->get_min_time()) return false;
+        if (!_series->is_sorted()) return _series->get_data_at_time(t, val); // slow path
+
+        // move to first sample >= t
+        if (_idx > 0 && times[_idx-1] >= t) {
+            _idx = std::lower_bound(times.begin(), times.begin() + _idx, t) - times.begin();
+        }
+        while (_idx < n && times[_idx] < t) ++_idx;
+        if (_idx >= n) return false;
+
+        if (times[_idx] == t) {
+            // hit a sample
+            val = data[_idx];
+            return true;
+        }
+        if (_idx == 0) return false;
+
+        // between samples; need interpolation
+        const double val_pre = data[_idx-1];
+        const double val_post = data[_idx];
+        const double t_pre = times[_idx-1];
+        const double t_post = times[_idx];
+        const double m = (val_post-val_pre)/(t_post-t_pre);
+        val = val_pre + (t - t_pre)*m;
+        return true;
+    }
+
+    void rewind(void) { _idx = 0; }
+
+    const DataTimeseries<T>* get_series(void) const { return _series; }
+
+private:
+    const DataTimeseries<T>* _series;
+    unsigned int             _idx; ///< first sample >= last query
+};
+
+/**
+ * @brief Walks along the samples of a primary series and interpolates any number of
+ * secondary series at the same time instants, the merge-join that postprocessors need:
+ *
+ *   DataAlignedCursor<float> c(data_x);
+ *   c.add(data_y); c.add(data_z);
+ *   while (c.next()) { if (c.valid()) { use c.time(), c.value(0..2) } }
+ *
+ * Value 0 is the primary, then the secondaries in the order they were added.
+ */
+template <typename T>
+class DataAlignedCursor
+{
+public:
+    DataAlignedCursor(const DataTimeseries<T>*primary, unsigned int start = 0) :
+        _primary(primary), _next(start), _t(0.), _valid(false), _values(1) {}
+
+    /**
+     * @return index of the secondary
+     */
+    unsigned int add(const DataTimeseries<T>*secondary) {
+        _secondaries.push_back(DataCursor<T>(secondary));
+        _values.push_back(T());
+        return _secondaries.size();
+    }
+
+    /**
+     * @brief advance to next sample of the primary
+     * @return false at the end
+     */
+    bool next(void) {
+        if (!_primary || _next >= _primary->size()) return false;
+        _valid = _primary->get_data(_next, _t, _values[0]);
+        for (unsigned int k = 0; _valid && k < _secondaries.size(); ++k) {
+            _valid = _secondaries[k].get_data_at_time(_t, _values[k+1]);
+        }
+        _next++;
+        return true;
+    }
+
+    /**
+     * @return true if all series have a value at current time
+     */
+    bool valid(void) const { return _valid; }
+    double time(void) const { return _t; }
+    const T & value(unsigned int k) const { return _values[k]; }
+
+    /**
+     * @return index of the current primary sample
+     */
+    unsigned int index(void) const { return _next - 1; }
+
+private:
+    const DataTimeseries<T>*    _primary;
+    unsigned int                _next;
+    double                      _t;
+    bool                        _valid;
+    std::vector<T>              _values;
+    std::vector<DataCursor<T> > _secondaries;
+};
+
+#endif // DATA_CURSOR_H
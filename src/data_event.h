@@ -34,6 +34,27 @@
 #include <algorithm>
 #include <iomanip>
 #include "data_timed.h"
+#include "eventdict.h"
+#include "csvwriter.h"
+
+/**
+ * @brief how DataEvent stores its items: as they are, but strings as ids of EventDict
+ */
+template <typename T>
+struct event_storage {
+    typedef T stored_t;
+    typedef T ref_t; ///< by value, since std::vector<bool> has no references
+    static stored_t encode(const T & item) { return item; }
+    static ref_t decode(const stored_t & s) { return s; }
+};
+
+template <>
+struct event_storage<std::string> {
+    typedef EventDict::id_t stored_t;
+    typedef const std::string & ref_t;
+    static stored_t encode(const std::string & item) { return EventDict::intern(item); }
+    static ref_t decode(const stored_t & s) { return EventDict::lookup(s); }
+};
 
 /**
  * @brief an event is a series of timed data items, which
@@ -42,12 +63,16 @@
  */
 template <typename T>
 class DataEvent : public DataTimed {
+public:
+    typedef typename event_storage<T>::stored_t stored_t;
+    typedef typename event_storage<T>::ref_t    ref_t;
+
 private:
     /********************************************
      *  MEMBER VARIABLES
      ********************************************/
     unsigned int _n; ///< number of events stored
-    std::vector<T>      _elems_data;    ///< only used if keepitems=true
+    std::vector<stored_t> _elems_data;  ///< only used if keepitems=true. See event_storage.
     std::vector<double> _elems_time;    ///< only used if keepitems=true
 
     T _dummy_item; ///< needed when empty
@@ -69,6 +94,19 @@ public:
         _elems_data.clear();
         _elems_time.clear();
         _time_epoch_datastart_usec = 0;
+        _touch();
+    }
+
+    // implements Data::get_memory()
+    void get_memory(memuse_t & m) const {
+        _count_memory(m, sizeof(*this));
+        m.add_samples(_elems_data);
+        m.add_samples(_elems_time);
+    }
+
+    // implements Data::shrink_to_fit()
+    size_t shrink_to_fit(void) {
+        return shrink_vector(_elems_data) + shrink_vector(_elems_time);
     }
 
     // implements Data::get_typename()
@@ -80,7 +118,14 @@ public:
     }
 
     void add_elem(T const &dataelem, double datatime = NAN) {
-        _elems_data.push_back(dataelem);
+        add_stored(event_storage<T>::encode(dataelem), datatime);
+    }
+
+    /**
+     * @brief add an item as it is stored, e.g., the EventDict id of a string
+     */
+    void add_stored(const stored_t & s, double datatime = NAN) {
+        _elems_data.push_back(s);
         _elems_time.push_back(datatime);
         _n++;
         _valid = true;
@@ -94,13 +139,23 @@ public:
         return _elems_time;
     }
 
-    const std::vector<T>& get_data() const {
+    /**
+     * @brief the items as they are stored; for strings the ids in EventDict
+     */
+    const std::vector<stored_t>& get_stored() const {
         return _elems_data;
     }
 
-    const T& get_latest() const {
+    /**
+     * @brief the k-th item
+     */
+    ref_t get_elem(unsigned int k) const {
+        return event_storage<T>::decode(_elems_data[k]);
+    }
+
+    ref_t get_latest() const {
         if (_n == 0) return _dummy_item;
-        return _elems_data.back();
+        return event_storage<T>::decode(_elems_data.back());
     }
 
     unsigned long get_epoch_dataend() const {
@@ -114,6 +169,9 @@ public:
              "type: " << get_typename() << ", " << _verbose_data_class() << std::endl <<
              "name: " << Data::get_fullname(dynamic_cast<const Data*const>(this)) << std::endl <<
              "#data points: " << _n << std::endl;
+        memuse_t m;
+        get_memory(m);
+        ss << "memory: " << m.describe() << std::endl;
 
         return ss.str();
     }
@@ -132,21 +190,16 @@ public:
 
     // implements Data::export_csv()
     bool export_csv(const std::string & filename, const std::string & sep = std::string(",")) const {
-        std::ofstream fout(filename.c_str());
+        CsvWriter fout(filename);
 
         if (!fout.is_open()) return false;
 
-        fout << "#time, " << _name << "[" << _units << "]" << std::endl;
-        fout << std::setprecision(9);
+        fout << "#time, " << _name << "[" << _units << "]\n";
         for (unsigned int k=0; k<_n; k++) {
-            T d = _elems_data[k];
-            double t = _elems_time[k];
-            // write
-            fout << t << sep << d << std::endl;
+            fout << _elems_time[k] << sep << get_elem(k) << '\n';
         }
 
-        fout.close();
-        return true;
+        return fout.close();
     }
 
     /**
@@ -157,6 +210,19 @@ public:
         return new DataEvent(*this);
     }
 
+    // implements Data::Take()
+    DataEvent* Take() {
+        std::vector<stored_t> data;
+        std::vector<double> time;
+        data.swap(_elems_data);
+        time.swap(_elems_time);
+        DataEvent*const t = new DataEvent(*this);
+        t->_elems_data.swap(data);
+        t->_elems_time.swap(time);
+        clear();
+        return t;
+    }
+
     // implements Data::merge_in() (DONE)
     bool merge_in(const Data * const other) {
         const DataEvent*const src = dynamic_cast<const DataEvent*const>(other);
@@ -164,11 +230,12 @@ public:
         if (!src->_valid) return false;
         //if (_elems_time.empty()) return false;
 
-        const double tmin_src = src->_elems_time.front() + src->_time_epoch_datastart_usec/1E6;
-        const double tmax_src = src->_elems_time.back() + src->_time_epoch_datastart_usec/1E6;
-        const double tmin_me = _elems_time.front() + _time_epoch_datastart_usec/1E6;
-        const double tmax_me = _elems_time.back() + _time_epoch_datastart_usec/1E6;
-        const double dt_sec = (_time_epoch_datastart_usec/1E6 - src->_time_epoch_datastart_usec / 1E6); ///< positive, if my data is more recent
+        // in integer microseconds and relative to my time base, like DataTimeseries::merge_in()
+        const double dt_sec = ((int64_t)_time_epoch_datastart_usec - (int64_t)src->_time_epoch_datastart_usec) / 1E6; ///< positive, if my data is more recent
+        const double tmin_src = src->_elems_time.front() - dt_sec;
+        const double tmax_src = src->_elems_time.back() - dt_sec;
+        const double tmin_me = _elems_time.front();
+        const double tmax_me = _elems_time.back();
 
         /*
          * we want no negative time stamps, so adjust all *my* relative times by
@@ -205,11 +272,11 @@ public:
                     // adjust source's time
                     tsrc = src->_elems_time[k] - dt_sec;
                 }
-                T datasrc = src->_elems_data[k];
+                const stored_t datasrc = src->_elems_data[k];
                 std::vector<double>::iterator first_greater_time = std::upper_bound(_elems_time.begin(), _elems_time.end(), tsrc); // returns iterator to first element t1 where t1 > t holds true
                 if (first_greater_time != _elems_time.end()) {
                     // insert before first_greater
-                    typename std::vector<T>::iterator first_greater_data = _elems_data.begin() + (first_greater_time - _elems_time.begin()); // calc index from iterator
+                    typename std::vector<stored_t>::iterator first_greater_data = _elems_data.begin() + (first_greater_time - _elems_time.begin()); // calc index from iterator
                     _elems_time.insert(first_greater_time, tsrc);
                     _elems_data.insert(first_greater_data, datasrc);
                 } else {
@@ -220,6 +287,7 @@ public:
             }
         }
         _n+= src->_elems_data.size();
+        _touch();
         return true;
     }
 };
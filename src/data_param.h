@@ -30,6 +30,7 @@
 #include <string>
 #include <iomanip>
 #include "data_untimed.h"
+#include "csvwriter.h"
 
 /**
  * @brief class for parameter data
@@ -63,6 +64,9 @@ public:
         return _valid ? 1 : 0;
     }
 
+    // implements Data::get_memory()
+    void get_memory(memuse_t & m) const { _count_memory(m, sizeof(*this)); }
+
     // implements Data::get_typename()
     std::string get_typename(void) const {
         std::string str = "data_untimed:";
@@ -83,6 +87,9 @@ public:
              "name: " << Data::get_fullname(dynamic_cast<const Data*const>(this)) << std::endl <<
              "data: " << _elem << std::endl <<
              "units: " << get_units() << std::endl;
+        memuse_t m;
+        get_memory(m);
+        ss << "memory: " << m.describe() << std::endl;
         return ss.str();
     }
 
@@ -100,15 +107,13 @@ public:
 
     // implements Data::export_csv()
     bool export_csv(const std::string & filename, const std::string & sep ATTR_UNUSED = std::string(",")) const {
-        std::ofstream fout(filename.c_str());
+        CsvWriter fout(filename);
 
         if (!fout.is_open()) return false;
 
-        fout << "# untimed single data point \"" << _name << "\" [" << _units << "]" << std::endl;
-        fout << std::setprecision(9);
-        fout << _elem << std::endl;
-        fout.close();
-        return true;
+        fout << "# untimed single data point \"" << _name << "\" [" << _units << "]\n";
+        fout << _elem << '\n';
+        return fout.close();
     }
 
 
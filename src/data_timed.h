@@ -23,8 +23,49 @@
 #ifndef DATA_TIMED_H
 #define DATA_TIMED_H
 
+#include <vector>
+#include <QAtomicInt>
 #include "data.h"
 
+class SpillFile;
+
+/**
+ * @brief Time stamps that several series can share, e.g., all fields of one log message.
+ * Each series only looks at the first size() of its own values. A series may append to a
+ * shared column when it is at the end; if another series has appended there already,
+ * it just checks that the time is the same. Any other change needs a private copy first.
+ * Series sharing a column must be appended to from the same thread.
+ */
+class TimeColumn
+{
+public:
+    TimeColumn() : _ref(1) {}
+
+    TimeColumn* ref(void) { _ref.ref(); return this; }
+    void unref(void) { if (!_ref.deref()) delete this; }
+    bool is_shared(void) const { return get_refs() != 1; }
+
+    /**
+     * @return number of series using this column
+     */
+    unsigned int get_refs(void) const {
+#if (QT_VERSION >= QT_VERSION_CHECK(5,0,0))
+        return (unsigned int) _ref.load();
+#else
+        return (unsigned int) (int) _ref;
+#endif
+    }
+
+    std::vector<double> t;
+
+private:
+    ~TimeColumn() {}
+    TimeColumn(const TimeColumn&);
+    TimeColumn& operator=(const TimeColumn&);
+
+    QAtomicInt _ref;
+};
+
 /**
  * @brief additional interface for all timed kind of data
  */
@@ -50,6 +91,52 @@ public:
      */
     virtual void make_periodic() = 0;
 
+    /**
+     * @brief keep using the time stamps of other, as long as both get the same ones. Only
+     * works if the time stamps up to now are the same.
+     * @return true if the time column is shared now
+     */
+    virtual bool share_time_column(const DataTimed*const /*other*/) { return false; }
+
+    /**
+     * @return the time column, if this kind of data has one. Still owned by this.
+     */
+    virtual TimeColumn* get_time_column(void) const { return NULL; }
+
+    /**
+     * @brief the writer is done appending, for now. A time column which another series sharing
+     * it has gone ahead in is cut to my samples, in a copy of my own. Readers rely on this,
+     * since they run in parallel and never change the storage.
+     */
+    virtual void seal_times(void) {}
+
+    /**
+     * @brief keep the samples in a compressed format from now on, if supported
+     * @return true if compressed now
+     */
+    virtual bool compress(void) { return false; }
+
+    /**
+     * @brief same as Clone(), but the copy is compressed (see compress()), if supported.
+     * Meant for copies which are only kept for reference, e.g., backups.
+     */
+    virtual DataTimed* CloneCompressed() const {
+        DataTimed*const c = dynamic_cast<DataTimed*>(Clone());
+        if (c) c->compress();
+        return c;
+    }
+
+    /**
+     * @brief move the samples into the given scratch file, if supported
+     * @return true if spilled now
+     */
+    virtual bool spill(SpillFile & /*file*/) { return false; }
+
+    /**
+     * @return approx. memory taken by the samples, which cannot be paged out
+     */
+    virtual size_t get_bytes(void) const { return 0; }
+
 protected:
     bool _bad_timestamps;
 };
@@ -30,14 +30,25 @@
 #include <sstream>
 #include <vector>
 #include <cassert>
+#include <climits>
 #include <algorithm>
+#include <queue>
 #ifndef _GNU_SOURCE
 #define _GNU_SOURCE
 #endif
 #include <math.h>
 #include <iomanip>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QAtomicInt>
+#include <QAtomicPointer>
 #include "data_timed.h"
+#include "data_window.h"
+#include "data_compressed.h"
+#include "spillfile.h"
+#include "vec_fun.h"
 #include "time_fun.h"
+#include "csvwriter.h"
 
 
 /**
@@ -51,69 +62,434 @@ class DataTimeseries : public DataTimed {
 private:
     typedef std::pair<double,T> datapair; ///< one item in the timeline is this
 
+    /**
+     * @brief node of the level-of-detail pyramid: summary of 2^level consecutive samples
+     */
+    typedef struct lod_node_s {
+        T min;
+        T max;
+        T first;
+        T last;
+    } lod_node;
+
     struct TimedSample{
         double time;
         T data;
         bool operator<(const TimedSample& r){ return time < r.time; }
     };
 
+    /**
+     * @brief next sample of one input in merge_in_all()
+     */
+    struct MergeHead {
+        double       time;
+        unsigned int input;
+    };
+    struct MergeHeadLater {
+        bool operator()(const MergeHead & a, const MergeHead & b) const {
+            return a.time > b.time || (a.time == b.time && a.input > b.input); // ties: earlier input first, like std::merge
+        }
+    };
+
 public:
+    /**
+     * @brief summary of the samples in one time bucket, see get_summary()
+     */
+    typedef struct lod_bucket_s {
+        double       t_first; ///< time of first sample
+        double       t_last;  ///< time of last sample
+        T            min;
+        T            max;
+        T            first;
+        T            last;
+        unsigned int n;       ///< number of samples
+    } lod_bucket;
+
     /**
      * @brief Statistics
      * @param keepitems if true then individual items are stored.
      */
-    DataTimeseries(std::string name, bool keepitems=true) : DataTimed(name), _keepitems(keepitems) {
+    DataTimeseries(std::string name, bool keepitems=true) : DataTimed(name), _keepitems(keepitems), _col(new TimeColumn()), _packed_p(NULL), _spill_p(NULL), _spill_n(0) {
         _defaults();
     }
 
+    ~DataTimeseries() {
+        _col->unref();
+        delete _packed();
+        if (_spill()) _spill()->unref();
+    }
+
     void _defaults() {
         _min_valid = false;
         _max_valid = false;
-        _sqsum = _sum = 0.;
+        _m2 = _mean = 0.;
         _n = 0;
         _min_t = INFINITY;
         _max_t = -INFINITY;
         _valid = false;
+        _sorted = true;
+        _warned_unsorted.fetchAndStoreOrdered(0);
+        _idx_valid = false;
+        _lod_valid = false;
+        _lod_n = 0;
+        _cache_block = UINT_MAX;
+    }
+
+    // copy CTOR (DONE). The time stamps are shared until one of both changes them.
+    DataTimeseries(const DataTimeseries & other) : DataTimed(other), _col(other._col->ref()), _packed_p(NULL), _spill_p(NULL), _spill_n(0) {
+        _copy_from(other);
+    }
+
+    /**
+     * @brief copy everything but the samples. Only for CloneCompressed().
+     */
+    DataTimeseries(const DataTimeseries & other, bool with_samples) : DataTimed(other), _col(new TimeColumn()), _packed_p(NULL), _spill_p(NULL), _spill_n(0) {
+        _copy_from(other, with_samples);
+    }
+
+    DataTimeseries & operator=(const DataTimeseries & other) {
+        if (this != &other) {
+            DataTimed::operator=(other);
+            TimeColumn*const col = other._col->ref();
+            _col->unref();
+            _col = col;
+            _copy_from(other);
+        }
+        return *this;
     }
 
-    // copy CTOR (DONE)
-    DataTimeseries(const DataTimeseries & other) : DataTimed(other) {
+    void _copy_from(const DataTimeseries & other, bool with_samples = true) {
         _keepitems = other._keepitems;
         _min_valid = other._min_valid;
         _max_valid = other._max_valid;
         _n = other._n;
-        _sqsum = other._sqsum;
-        _sum = other._sum;
-        _elems_data = other._elems_data; // deep copy by STL
-        _elems_time = other._elems_time;
+        _m2 = other._m2;
+        _mean = other._mean;
+        if (with_samples) _elems_data = other._elems_data; // deep copy by STL
+        CompressedSeries<T>* packed = NULL;
+        SpillRegion* spill = NULL;
+        if (other._packed() || other._spill()) {
+            QMutexLocker lock(&other._storage_mutex()); // other may be unpacking right now
+            packed = other._packed() ? new CompressedSeries<T>(*other._packed()) : NULL;
+            spill = other._spill() ? other._spill()->ref() : NULL; // read-only, so it can be shared
+            _spill_n = other._spill_n;
+        }
+        delete _packed();
+        _set_packed(packed);
+        if (_spill()) _spill()->unref();
+        _set_spill(spill);
+        if (!spill) _spill_n = 0;
+        _cache_block = UINT_MAX;
         _max = other._max;
         _min = other._min;
         _max_t = other._max_t;
         _min_t = other._min_t;
+        _sorted = other._sorted;
+        _warned_unsorted.fetchAndStoreOrdered(0);
+        _idx_valid = false; // rebuilt on demand
+        _lod_valid = false;
+        _touch();
+    }
+
+    /**
+     * @brief implements DataTimed::compress(). Store the samples compressed (see CompressedSeries), which mostly takes a
+     * fraction of the memory. Sample access by index and time lookups then decode single
+     * blocks, and plots can walk through the blocks with get_block(). Anything that needs
+     * all samples at once (get_time(), get_data(), window statistics, changes) unpacks
+     * the series again.
+     * @return true if the series is compressed now
+     */
+    bool compress(void) {
+        if (_packed()) return true;
+        if (_spill()) return false; // no need, and it would need all of it in memory
+        if (!_keepitems || _elems_data.size() < (size_t)CompressedSeries<T>::BLOCK_LEN) return false; // not worth it
+        seal_times();
+        CompressedSeries<T>*const packed = new CompressedSeries<T>();
+        if (!packed->encode(_times(), _elems_data)) {
+            delete packed;
+            return false;
+        }
+        _set_packed(packed);
+        std::vector<T>().swap(_elems_data);
+        _col->unref();
+        _col = new TimeColumn();
+        std::vector<double>().swap(_idx_sum);
+        std::vector<double>().swap(_idx_sqsum);
+        std::vector<std::vector<lod_node> >().swap(_lod);
+        _idx_valid = false;
+        _lod_valid = false;
+        return true;
+    }
+
+    bool is_compressed(void) const { return _packed() != NULL; }
+
+    /**
+     * @brief implements DataTimed::spill(). Move the samples into a region of the given file,
+     * which is mapped, such that the OS pages them in when needed. Sample access, time lookups
+     * and get_block() read from the mapping. Anything that needs the vectors (get_time(),
+     * get_data(), window statistics, changes) reads the series back into memory.
+     * @return true if the series lives in the file now
+     */
+    bool spill(SpillFile & file) {
+        if (_spill()) return true;
+        if (!_keepitems || _packed() || _elems_data.size() < (size_t)get_block_len()) return false; // not worth it
+        seal_times();
+        const std::vector<double> & times = _times();
+        const size_t n = _elems_data.size();
+        file.begin_region();
+        bool ok = file.write(&times[0], n*sizeof(double));
+        // through a buffer, because std::vector<bool> has no array inside
+        T buf[SPILL_BUFLEN];
+        for (size_t lo = 0; ok && lo < n; lo += SPILL_BUFLEN) {
+            const size_t len = std::min(n - lo, (size_t)SPILL_BUFLEN);
+            for (size_t k = 0; k < len; ++k) buf[k] = _elems_data[lo + k];
+            ok = file.write(buf, len*sizeof(T));
+        }
+        SpillRegion*const region = ok ? file.map_region() : NULL;
+        if (!region) return false;
+
+        QMutexLocker lock(&_storage_mutex());
+        _spill_n = n;
+        _set_spill(region);
+        std::vector<T>().swap(_elems_data);
+        _col->unref();
+        _col = new TimeColumn();
+        std::vector<double>().swap(_idx_sum);
+        std::vector<double>().swap(_idx_sqsum);
+        std::vector<std::vector<lod_node> >().swap(_lod);
+        _idx_valid = false;
+        _lod_valid = false;
+        return true;
+    }
+
+    bool is_spilled(void) const { return _spill() != NULL; }
+
+    /**
+     * @return approx. memory taken by the samples. Spilled samples do not count, the OS
+     * can drop them any time.
+     */
+    size_t get_bytes(void) const {
+        if (_spill()) return 0;
+        if (_packed()) {
+            QMutexLocker lock(&_storage_mutex());
+            if (_packed()) return _packed()->get_bytes();
+        }
+        return _elems_data.capacity()*sizeof(T) + (_col->is_shared() ? 0 : _col->t.capacity()*sizeof(double));
+    }
+
+    // implements Data::get_memory(). A shared time column is split among its series.
+    void get_memory(memuse_t & m) const {
+        _count_memory(m, sizeof(*this));
+        QMutexLocker lock(_packed() || _spill() ? &_storage_mutex() : NULL);
+        if (_spill()) {
+            m.spilled += _spill_n * (sizeof(double) + sizeof(T));
+        } else if (_packed()) {
+            m.payload += _packed()->get_bytes();
+        } else {
+            const unsigned int refs = std::max(1u, _col->get_refs());
+            m.add_samples(_elems_data);
+            m.add_samples(_col->t, refs);
+            m.meta += sizeof(TimeColumn) / refs;
+        }
+        m.add_meta(_cache_time);
+        m.add_meta(_cache_data);
+        m.add_meta(_idx_sum);
+        m.add_meta(_idx_sqsum);
+        m.add_meta(_lod);
+        for (unsigned int k = 0; k < _lod.size(); ++k) m.add_meta(_lod[k]);
+    }
+
+    // implements Data::shrink_to_fit(). A shared time column is left alone, others might still append.
+    size_t shrink_to_fit(void) {
+        if (_spill() || _packed()) return 0;
+        seal_times();
+        size_t freed = shrink_vector(_elems_data);
+        if (!_col->is_shared()) freed += shrink_vector(_col->t);
+        return freed;
+    }
+
+    /**
+     * @brief samples come in blocks of this many, except for the last block
+     */
+    static unsigned int get_block_len(void) { return CompressedSeries<T>::BLOCK_LEN; }
+
+    unsigned int get_num_blocks(void) const {
+        const size_t n = _stored();
+        return (n + get_block_len() - 1) / get_block_len();
+    }
+
+    /**
+     * @brief samples of block b, i.e., of indices [b*get_block_len(), (b+1)*get_block_len()).
+     * For walking through the samples without unpacking a compressed series.
+     * @param time resized
+     * @param data resized
+     */
+    void get_block(unsigned int b, std::vector<double> & time, std::vector<T> & data) const {
+        if (_packed()) {
+            QMutexLocker lock(&_storage_mutex());
+            if (_packed()) {
+                _packed()->decode_block(b, time, data);
+                return;
+            }
+        }
+        if (_spill()) {
+            QMutexLocker lock(&_storage_mutex());
+            if (_spill()) {
+                const size_t lo = std::min((size_t)b*get_block_len(), _spill_n);
+                const size_t hi = std::min(lo + get_block_len(), _spill_n);
+                time.assign(_spill_time() + lo, _spill_time() + hi);
+                data.assign(_spill_data() + lo, _spill_data() + hi);
+                return;
+            }
+        }
+        const std::vector<double> & times = _times();
+        const size_t lo = std::min((size_t)b*get_block_len(), _elems_data.size());
+        const size_t hi = std::min(lo + get_block_len(), _elems_data.size());
+        time.assign(times.begin() + lo, times.begin() + hi);
+        data.assign(_elems_data.begin() + lo, _elems_data.begin() + hi);
+    }
+
+    /**
+     * @brief time span and value range of block b (see get_block()), without decoding it.
+     * Compressed series have them in the block headers, series in memory take them from
+     * the pyramid (built on first use).
+     * @return false if they are not known for cheap, i.e., when spilled. Use get_block() then.
+     */
+    bool get_block_summary(unsigned int b, double & t_first, double & t_last, T & vmin, T & vmax) const {
+        if (_packed()) {
+            QMutexLocker lock(&_storage_mutex());
+            if (_packed()) {
+                const typename CompressedSeries<T>::block_info & h = _packed()->get_block_info(b);
+                t_first = h.t_first;
+                t_last = h.t_last;
+                vmin = h.min;
+                vmax = h.max;
+                return true;
+            }
+        }
+        if (_spill()) return false;
+        const size_t lo = (size_t)b*get_block_len();
+        const size_t hi = std::min(lo + get_block_len(), _elems_data.size());
+        if (lo >= hi) return false;
+        const std::vector<double> & times = _times();
+        t_first = times[lo];
+        t_last = times[hi - 1];
+        QMutexLocker lock(&_index_mutex());
+        _build_lod();
+        _index_minmax(lo, hi, vmin, vmax);
+        return true;
+    }
+
+    /**
+     * @brief corners of the polyline through the samples in [t0, t1]: the first and the last
+     * sample, and the samples on both sides of each change of the value. For step signals
+     * (flags, modes, fix types) these are far fewer than all samples, and the line is the same.
+     * Blocks which do not change the value (see get_block_summary()) are not decoded.
+     * @param max give up if there are more corners than this
+     * @param time resized
+     * @param data resized
+     * @return false if given up, or if the time stamps are not sorted
+     */
+    bool get_corners(double t0, double t1, size_t max, std::vector<double> & time, std::vector<T> & data) const {
+        time.clear();
+        data.clear();
+        if (!_sorted) return false;
+        std::vector<double> bt;
+        std::vector<T> bd;
+        bool have = false;    ///< a sample was seen
+        bool pending = false; ///< the last one seen is no corner so far
+        double tlast = NAN;
+        T vlast = T();
+        const unsigned int nb = get_num_blocks();
+        for (unsigned int b = 0; b < nb; ++b) {
+            double tf, tl;
+            T vmin, vmax;
+            if (get_block_summary(b, tf, tl, vmin, vmax)) {
+                if (tl < t0) continue;
+                if (tf > t1) break;
+                if (have && tl <= t1 && vmin == vmax && vmin == vlast) {
+                    // same value all through
+                    tlast = tl;
+                    pending = true;
+                    continue;
+                }
+            }
+            get_block(b, bt, bd);
+            for (size_t k = 0; k < bt.size(); ++k) {
+                const double t = bt[k];
+                if (t < t0) continue;
+                if (t > t1) break;
+                const T v = bd[k];
+                if (!have || !(v == vlast)) {
+                    if (pending) {
+                        time.push_back(tlast);
+                        data.push_back(vlast);
+                    }
+                    time.push_back(t);
+                    data.push_back(v);
+                    pending = false;
+                    if (time.size() > max) return false;
+                } else {
+                    pending = true;
+                }
+                have = true;
+                tlast = t;
+                vlast = v;
+            }
+            if (!bt.empty() && bt.back() > t1) break;
+        }
+        if (pending) {
+            time.push_back(tlast);
+            data.push_back(vlast);
+        }
+        return time.size() <= max;
+    }
+
+    /**
+     * @brief create a new dataseries by applying a sliding window operator to the current one
+     * @param other gets the result, with the same time stamps as this one
+     * @param op see DataWindow
+     * @param halfwidth_sec the window reaches this far into past and future
+     * @return false if the time stamps are not sorted
+     */
+    bool windowed(DataTimeseries<T> & other, typename DataWindow<T>::window_op_e op, double halfwidth_sec) const {
+        other.clear();
+        if (!_sorted) return false;
+
+        std::vector<T> vals;
+        const std::vector<double> & times = _times();
+        if (!DataWindow<T>::apply(times, _elems_data, op, halfwidth_sec, vals)) return false;
+        other.share_time_column(this); // same time stamps, add_elem() only checks them
+        other._elems_data.reserve(vals.size());
+        for (unsigned int k=0; k < vals.size(); ++k) {
+            other.add_elem(vals[k], times[k]);
+        }
+        return true;
     }
 
     /**
      * @brief create a new averaged (moving window) dataseries
      * based on the current one.
      * @param windowlen_sec the window length in seconds
-     * TODO: optimize
      */
     void moving_average(DataTimeseries<T> & other, float windowlen_sec) const {
-        other.clear();
+        if (windowed(other, DataWindow<T>::WINDOW_AVG, windowlen_sec)) return;
 
-        for (unsigned int k=0; k< this->_elems_time.size(); ++k) {
-            const double t = this->_elems_time[k], tmin = t-windowlen_sec, tmax=t+windowlen_sec;
+        // slow path: time is not sorted, scan around each sample
+        const std::vector<double> & times = _times();
+        for (unsigned int k=0; k< times.size(); ++k) {
+            const double t = times[k], tmin = t-windowlen_sec, tmax=t+windowlen_sec;
             unsigned n = 0;
             double sum = 0.;
             // left half
-            for (unsigned left = k; left > 0; left--) {
-                if (this->_elems_time[left] < tmin) break;
+            for (unsigned left = k+1; left-- > 0; ) {
+                if (times[left] < tmin) break;
                 n++;
                 sum+=this->_elems_data[left];
             }
             // right half
             for (unsigned right = k+1; right < this->_elems_data.size(); ++right) {
-                if (this->_elems_time[right] > tmax) break;
+                if (times[right] > tmax) break;
                 n++;
                 sum+=this->_elems_data[right];
             }
@@ -129,8 +505,18 @@ public:
     // implements Data::clear()
     void clear() {
         _defaults();
+        _touch();
         _elems_data.clear();
-        _elems_time.clear();
+        _col->unref();
+        _col = new TimeColumn();
+        delete _packed();
+        _set_packed(NULL);
+        if (_spill()) _spill()->unref();
+        _set_spill(NULL);
+        _spill_n = 0;
+        std::vector<double>().swap(_idx_sum);
+        std::vector<double>().swap(_idx_sqsum);
+        std::vector<std::vector<lod_node> >().swap(_lod);
         _time_epoch_datastart_usec = 0;
     }
 
@@ -143,11 +529,21 @@ public:
     }
 
     void add_elem(T const &dataelem, double datatime = NAN) {
-        _sum += dataelem;
-        _sqsum += pow(dataelem,2);
+        // Welford
+        const double delta = dataelem - _mean;
+        _mean += delta / (_n + 1);
+        _m2 += delta * (dataelem - _mean);
+        // appended: index and pyramid are only extended on their next use
         if (_keepitems) {
+            _unpack();
+            const size_t len = _elems_data.size();
+            // another series sharing the column has gone ahead with a different time
+            if (_col->t.size() > len && !(_col->t[len] == datatime)) _detach();
+            std::vector<double> & times = _col->t;
+            // NaN or going back in time: lookups have to scan
+            if (len == 0 ? (datatime != datatime) : !(datatime >= times[len-1])) _sorted = false;
+            if (times.size() == len) times.push_back(datatime); // otherwise it is there already
             _elems_data.push_back(dataelem);
-            _elems_time.push_back(datatime);
         }
         if (_min_valid) {
             if (dataelem < _min) _min = dataelem;
@@ -169,33 +565,125 @@ public:
         _valid = true;
     }
 
+    /**
+     * @brief append many samples at once. Same as add_elem() for each, but the storage
+     * grows only once and the type is known up front, e.g., when loading from the DB.
+     * @param data n values, converted to T
+     * @param time their n time stamps
+     */
+    template <typename S>
+    void add_elems(const S * data, const double * time, size_t n) {
+        if (n == 0) return;
+        if (!_keepitems) {
+            for (size_t k = 0; k < n; ++k) add_elem(static_cast<T>(data[k]), time[k]);
+            return;
+        }
+        std::vector<double> & times = _times_mut();
+        const size_t len = _elems_data.size();
+        times.reserve(len + n);
+        _elems_data.reserve(len + n);
+        double tprev = (len > 0) ? times[len-1] : NAN;
+        for (size_t k = 0; k < n; ++k) {
+            const T dataelem = static_cast<T>(data[k]);
+            const double datatime = time[k];
+            // Welford
+            const double delta = dataelem - _mean;
+            _mean += delta / (_n + 1);
+            _m2 += delta * (dataelem - _mean);
+            if (len + k == 0 ? (datatime != datatime) : !(datatime >= tprev)) _sorted = false;
+            tprev = datatime;
+            if (_min_valid) {
+                if (dataelem < _min) _min = dataelem;
+                if (datatime < _min_t) _min_t = datatime;
+                if (dataelem > _max) _max = dataelem;
+                if (datatime > _max_t) _max_t = datatime;
+            } else {
+                _min = _max = dataelem;
+                _min_t = _max_t = datatime;
+                _min_valid = _max_valid = true;
+            }
+            _elems_data.push_back(dataelem);
+            _n++;
+        }
+        times.insert(times.end(), time, time + n);
+        _valid = true;
+    }
+
+    /**
+     * @brief same as add_elems(), but a time column shared with other fields of the same
+     * message stays shared, as with add_elem(): the first of them appends the times, the
+     * others find them there already.
+     */
+    template <typename S>
+    void add_elems_shared(const S * data, const double * time, size_t n) {
+        if (n == 0) return;
+        if (!_keepitems) {
+            for (size_t k = 0; k < n; ++k) add_elem(static_cast<T>(data[k]), time[k]);
+            return;
+        }
+        _unpack();
+        const size_t len = _elems_data.size();
+        if (_col->t.size() > len) {
+            // another series went ahead; it must have had the same times
+            bool same = _col->t.size() >= len + n;
+            for (size_t k = 0; same && k < n; ++k) same = (_col->t[len + k] == time[k]);
+            if (!same) _detach();
+        }
+        std::vector<double> & times = _col->t;
+        const bool append_times = (times.size() == len);
+        if (append_times) times.reserve(len + n);
+        _elems_data.reserve(len + n);
+        double tprev = (len > 0) ? times[len-1] : NAN;
+        for (size_t k = 0; k < n; ++k) {
+            const T dataelem = static_cast<T>(data[k]);
+            const double datatime = time[k];
+            // Welford
+            const double delta = dataelem - _mean;
+            _mean += delta / (_n + 1);
+            _m2 += delta * (dataelem - _mean);
+            if (len + k == 0 ? (datatime != datatime) : !(datatime >= tprev)) _sorted = false;
+            tprev = datatime;
+            if (_min_valid) {
+                if (dataelem < _min) _min = dataelem;
+                if (datatime < _min_t) _min_t = datatime;
+                if (dataelem > _max) _max = dataelem;
+                if (datatime > _max_t) _max_t = datatime;
+            } else {
+                _min = _max = dataelem;
+                _min_t = _max_t = datatime;
+                _min_valid = _max_valid = true;
+            }
+            _elems_data.push_back(dataelem);
+            _n++;
+        }
+        if (append_times) times.insert(times.end(), time, time + n);
+        _valid = true;
+    }
+
     double get_stddev() const {        
-        return sqrt(_sqsum/pow(_sum,2));
+        if (_n > 0) {
+            return sqrt(_m2/_n);
+        }
+        return NAN;
     }
 
     double get_average() const {
         if (_n > 0) {
-            return _sum/((double)_n);
+            return _mean;
         }
         return NAN;
     }
 
     datapair get_first() const {
-        if (_keepitems) {
-            if (_n > 0) {
-                return datapair(_elems_time.front(),_elems_data.front());
-            }
-        }
-        return datapair(NAN, 0);
+        datapair p(NAN, 0);
+        if (_stored() > 0) _sample(0, p.first, p.second);
+        return p;
     }
 
     datapair get_last() const {
-        if (_keepitems) {
-            if (_n > 0) {
-                return datapair(_elems_time.back(),_elems_data.back());
-            }
-        }
-        return datapair(NAN, 0);;
+        datapair p(NAN, 0);
+        if (_stored() > 0) _sample(_stored() - 1, p.first, p.second);
+        return p;
     }
 
     /**
@@ -206,40 +694,88 @@ public:
      */
     bool _get_index_of_time(double timeinstant, unsigned int & idx_before, unsigned int & idx_after) const {
         if (timeinstant > _max_t || timeinstant < _min_t) return false; // extrapolation not supported
-
-        // find item which is >= timeinstant
-        double t_pre=0.;
-        bool first = true;
-        for(unsigned int k=0; k< _elems_time.size(); ++k) {
-            const double t = _elems_time[k];
-            // assumption: vector is ordered by time
-            if (first) {
-                t_pre = t;
-                first = false;
+        if (_packed() && _sorted) {
+            // find the block, then the item which is >= timeinstant in there
+            QMutexLocker lock(&_storage_mutex());
+            if (_packed()) {
+                const unsigned int b = _packed()->find_block(timeinstant);
+                if (b >= _packed()->get_num_blocks()) return false;
+                _load_block(b);
+                const unsigned int k = (std::lower_bound(_cache_time.begin(), _cache_time.end(), timeinstant) - _cache_time.begin())
+                        + b*get_block_len();
+                if (_cache_time[k - b*get_block_len()] == timeinstant) {
+                    idx_before = k;
+                    idx_after = k;
+                    return true;
+                }
+                if (k == 0) return false;
+                idx_before = k - 1;
+                idx_after = k;
+                return true;
             }
-            //assert(t >= t_pre);
-            if (!t >= t_pre) {
-                std::cerr << "time is non-monotonic in data " << this->get_fullname(this) << std::endl;
-                return false;
+        }
+        if (_spill() && _sorted) {
+            QMutexLocker lock(&_storage_mutex());
+            if (_spill()) {
+                const double*const times = _spill_time();
+                const double*const it = std::lower_bound(times, times + _spill_n, timeinstant);
+                if (it == times + _spill_n) return false;
+                const unsigned int k = it - times;
+                if (*it == timeinstant) {
+                    idx_before = k;
+                    idx_after = k;
+                    return true;
+                }
+                if (k == 0) return false;
+                idx_before = k - 1;
+                idx_after = k;
+                return true;
             }
-            // --
+        }
+        const std::vector<double> & times = _times();
+        if (times.empty()) return false;
+
+        if (_sorted) {
+            // find item which is >= timeinstant
+            const std::vector<double>::const_iterator it = std::lower_bound(times.begin(), times.end(), timeinstant);
+            if (it == times.end()) return false;
+            const unsigned int k = it - times.begin();
+            if (*it == timeinstant) {
+                idx_before = k;
+                idx_after = k;
+                return true;
+            }
+            // lin. interpolate
+            if (k == 0) return false;
+            idx_before = k - 1;
+            idx_after = k;
+            return true;
+        }
+
+        // slow path: time is non-monotonic, take the first fitting pair
+        if (_warned_unsorted.testAndSetOrdered(0, 1)) { // lookups run in parallel, only one of them tells
+            std::cerr << "time is non-monotonic in data " << this->get_fullname(this) << "; lookups will be slow" << std::endl;
+        }
+        for (unsigned int k=0; k< times.size(); ++k) {
+            const double t = times[k];
             if (t == timeinstant) {
                 idx_before = k;
                 idx_after = k;
                 return true;
-            } else if (t > timeinstant) {
-                // lin. interpolate
-                if (k > 0) {
-                    idx_before = k - 1;
-                    idx_after = k;
-                    return true;
-                }
+            } else if (t > timeinstant && k > 0) {
+                idx_before = k - 1;
+                idx_after = k;
+                return true;
             }
-            t_pre = t;
         }
         return false;
     }
 
+    /**
+     * @return true if the time stamps are non-decreasing, i.e., time lookups are O(log n)
+     */
+    bool is_sorted(void) const { return _sorted; }
+
     /**
      * @brief gets the value of the timeseries that belongs to time instant 'timeinstant'. If there is no data point, it interpolates.
      * @param timeinstant time at which the value shall be retrieved, internal relative time!!
@@ -257,14 +793,17 @@ public:
         assert(idx_before <= idx_after);
         if (idx_before == idx_after) {
             // hit a sample
-            val = _elems_data[idx_before];
+            double t;
+            _sample(idx_before, t, val);
             return true;
         } else {
             // betweem samples; need interpolation
-            const double val_pre = _elems_data[idx_before];
-            const double val_post = _elems_data[idx_after];
-            const double t_post = _elems_time[idx_after];
-            const double t_pre = _elems_time[idx_before];
+            double t_pre, t_post;
+            T pre, post;
+            _sample(idx_before, t_pre, pre);
+            _sample(idx_after, t_post, post);
+            const double val_pre = pre;
+            const double val_post = post;
             const double m = (val_post-val_pre)/(t_post-t_pre);
             val = val_pre + (timeinstant - t_pre)*m;
             return true;
@@ -298,6 +837,7 @@ public:
 
     bool get_stats_timewindow(double tmin, double tmax, data_stats & s) const {
         if (tmax < tmin) return false;
+        _unpack();
 
         // convert the absolute time to time of this series
         const double time_offset = _time_epoch_datastart_usec /1E6;
@@ -318,11 +858,21 @@ public:
         if (!ret) return false;
 
         // we have the limits
-        s.n_samples = idx_max_pre - idx_min_post + 1;
+        const bool have_samples = (idx_min_post <= idx_max_pre);
+        s.n_samples = have_samples ? idx_max_pre - idx_min_post + 1 : 0;
+
+        // short windows on a series without index (e.g., still growing): just scan them
+        QMutexLocker lock(&_index_mutex());
+        const bool direct = (!_idx_valid || !_lod_valid) && s.n_samples <= STATS_DIRECT_MAX;
+        if (!direct) {
+            _build_index();
+            _build_lod();
+        }
+        const double shift = direct ? _mean : _idx_shift; ///< sums are of (value - shift), against cancellation
 
         double sum = 0.;
         double sumsq = 0.;
-        double first = true;
+        bool first = true;
         unsigned int n_samples_int = 0; // internally we may use more samples. The returned struct says "samples in between", but we may interpolate at beginning and end.
 
         // do we need to interpolate at the beginning?
@@ -333,26 +883,36 @@ public:
                 s.min = (double)val;
                 s.max = (double)val;
                 first = false;
-                sum += val;
-                sumsq += (val*val);
+                sum += val - shift;
+                sumsq += (val - shift)*(val - shift);
                 n_samples_int++;
             }
         }
 
-        // run over the samples now
-        for (unsigned int k = idx_min_post; k <= idx_max_pre; k++) {
-            const T val = _elems_data[k];
+        // the samples in between
+        if (have_samples) {
+            const unsigned int lo = idx_min_post, hi = idx_max_pre + 1;
+            T mn, mx;
+            if (direct) {
+                _direct_minmax(_elems_data, lo, hi, mn, mx);
+            } else {
+                _index_minmax(lo, hi, mn, mx);
+            }
             if (first) {
-                s.min = (double)val;
-                s.max = (double)val;
+                s.min = (double)mn;
+                s.max = (double)mx;
                 first = false;
             } else {
-                s.min = (val < s.min) ? val : s.min;
-                s.max = (val > s.max) ? val : s.max;
+                s.min = (mn < s.min) ? mn : s.min;
+                s.max = (mx > s.max) ? mx : s.max;
+            }
+            if (direct) {
+                _direct_sums(_elems_data, lo, hi, shift, sum, sumsq);
+            } else {
+                sum += _idx_sum[hi] - _idx_sum[lo];
+                sumsq += _idx_sqsum[hi] - _idx_sqsum[lo];
             }
-            sum += val;
-            sumsq += (val*val);
-            n_samples_int++;
+            n_samples_int += hi - lo;
         }
 
         // do we need to interpolate at the end?
@@ -368,8 +928,8 @@ public:
                     s.min = (val < s.min) ? val : s.min;
                     s.max = (val > s.max) ? val : s.max;
                 }
-                sum += val;
-                sumsq += (val*val);
+                sum += val - shift;
+                sumsq += (val - shift)*(val - shift);
                 n_samples_int++;
             }
         }
@@ -377,8 +937,8 @@ public:
         // finally: complete stats
         sum /= n_samples_int;
         sumsq /= n_samples_int;
-        s.avg = sum;
-        s.stddev = sqrt(sumsq - sum*sum);
+        s.avg = sum + shift;
+        s.stddev = sqrt(std::max(0., sumsq - sum*sum));
         s.t_min = tmin;
         s.t_max = tmax;
         const double dt = tmax - tmin;
@@ -386,6 +946,153 @@ public:
         return true;
     }
 
+    /**
+     * @brief summary of the samples in [t0, t1] at a given resolution, e.g., for drawing
+     * one min/max bar per pixel. Costs O(N log n) via the pyramid, which is built on first use.
+     * Compressed and spilled series stay so; their blocks in [t0, t1] are decoded one by one.
+     * @param t0 begin, internal relative time
+     * @param t1 end, internal relative time
+     * @param N number of equally long buckets the time span is divided into
+     * @param out summaries of the non-empty buckets, in time order
+     * @return false if time stamps are not sorted or arguments are bad
+     */
+    bool get_summary(double t0, double t1, unsigned int N, std::vector<lod_bucket> & out) const {
+        out.clear();
+        if (!_sorted || N == 0 || !(t1 >= t0)) return false;
+        if (_packed() || _spill()) return _summary_blocks(t0, t1, N, out);
+        QMutexLocker lock(&_index_mutex());
+        _build_lod();
+
+        const double dt = (t1 - t0) / N;
+        const std::vector<double> & times = _times();
+        std::vector<double>::const_iterator it = std::lower_bound(times.begin(), times.end(), t0);
+        for (unsigned int b = 0; b < N && it != times.end(); ++b) {
+            // bucket is [ta, tb), the last one includes t1
+            std::vector<double>::const_iterator end;
+            if (b == N - 1) {
+                end = std::upper_bound(it, times.end(), t1);
+            } else {
+                end = std::lower_bound(it, times.end(), t0 + dt*(b+1));
+            }
+            if (end == it) continue;
+
+            const unsigned int lo = it - times.begin(), hi = end - times.begin();
+            lod_bucket bucket;
+            bucket.t_first = times[lo];
+            bucket.t_last = times[hi-1];
+            bucket.first = _elems_data[lo];
+            bucket.last = _elems_data[hi-1];
+            bucket.n = hi - lo;
+            _index_minmax(lo, hi, bucket.min, bucket.max);
+            out.push_back(bucket);
+            it = end;
+        }
+        return true;
+    }
+
+    /**
+     * @brief index of the first sample after t, e.g., to step a cursor. Binary search if
+     * time stamps are sorted, else the first in storage order.
+     * @param t internal relative time
+     * @return false if there is none
+     */
+    bool get_index_after(double t, unsigned int & idx) const {
+        const unsigned int n = _stored();
+        double ts;
+        T val;
+        if (n == 0) return false;
+        if (!_sorted) {
+            for (idx = 0; idx < n; ++idx) {
+                _sample(idx, ts, val);
+                if (ts > t) return true;
+            }
+            return false;
+        }
+        if (!(t < _max_t)) return false;
+        if (t < _min_t) {
+            idx = 0;
+            return true;
+        }
+        unsigned int before, after;
+        if (!_get_index_of_time(t, before, after)) return false;
+        for (idx = after; idx < n; ++idx) { // those exactly at t
+            _sample(idx, ts, val);
+            if (ts > t) return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief index of the last sample before t, counterpart of get_index_after()
+     */
+    bool get_index_before(double t, unsigned int & idx) const {
+        const unsigned int n = _stored();
+        double ts;
+        T val;
+        if (n == 0) return false;
+        if (!_sorted) {
+            // as if sorted: the last before t, until one after t comes
+            bool found = false;
+            for (unsigned int k = 0; k < n; ++k) {
+                _sample(k, ts, val);
+                if (ts < t) {
+                    idx = k;
+                    found = true;
+                } else if (ts > t) {
+                    break;
+                }
+            }
+            return found;
+        }
+        if (!(t > _min_t)) return false;
+        unsigned int before = n - 1, after;
+        if (!(t > _max_t) && !_get_index_of_time(t, before, after)) return false;
+        for (idx = before + 1; idx-- > 0; ) { // those exactly at t
+            _sample(idx, ts, val);
+            if (ts < t) return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief indices of the smallest and the largest sample in [t0, t1]; the first ones, if
+     * there are several. O(log n) via the pyramid for samples in memory, otherwise a scan
+     * which leaves the storage as it is.
+     * @param t0 begin, internal relative time
+     * @param t1 end, internal relative time
+     * @return false if there are no samples in there
+     */
+    bool get_argminmax(double t0, double t1, unsigned int & imin, unsigned int & imax) const {
+        const unsigned int n = _stored();
+        if (n == 0 || !(t1 >= t0)) return false;
+        if (!_sorted || _packed() || _spill()) {
+            bool found = false;
+            T mn = T(), mx = T();
+            for (unsigned int k = 0; k < n; ++k) {
+                double ts;
+                T val;
+                _sample(k, ts, val);
+                if (ts < t0 || ts > t1) continue;
+                if (!found || val < mn) { mn = val; imin = k; }
+                if (!found || val > mx) { mx = val; imax = k; }
+                found = true;
+            }
+            return found;
+        }
+
+        QMutexLocker lock(&_index_mutex());
+        const std::vector<double> & times = _times();
+        const unsigned int lo = std::lower_bound(times.begin(), times.end(), t0) - times.begin();
+        const unsigned int hi = std::upper_bound(times.begin(), times.end(), t1) - times.begin();
+        if (lo >= hi) return false;
+        _build_lod();
+        T mn, mx;
+        _index_minmax(lo, hi, mn, mx);
+        imin = _index_find(lo, hi, mn, true);
+        imax = _index_find(lo, hi, mx, false);
+        return true;
+    }
+
     /**
      * @brief get_max
      * @return maximum VALUE of data series
@@ -395,26 +1102,52 @@ public:
     }
 
     unsigned long get_epoch_dataend() const {
-        if (_elems_time.empty()) { return get_epoch_datastart(); }
-        return ((unsigned long) _elems_time.back()*1E6) + get_epoch_datastart();
+        if (_stored() == 0) { return get_epoch_datastart(); }
+        return ((unsigned long) get_last().first*1E6) + get_epoch_datastart();
     }
 
     const std::vector<double>& get_time() const {
-        return _elems_time;
+        return _times();
     }
 
     const std::vector<T>& get_data() const {
+        _unpack();
         return _elems_data;
     }
 
+    // implements DataTimed::share_time_column()
+    bool share_time_column(const DataTimed*const other) {
+        if (!other || !_keepitems) return false;
+        TimeColumn*const col = other->get_time_column();
+        if (!col || _packed() || _spill()) return false;
+        if (col == _col) return true;
+        seal_times();
+        const std::vector<double> & times = _times();
+        if (col->t.size() < times.size() || !std::equal(times.begin(), times.end(), col->t.begin())) return false;
+        col->ref();
+        _col->unref();
+        _col = col;
+        return true;
+    }
+
+    // implements DataTimed::seal_times()
+    void seal_times(void) {
+        if (!_keepitems || _packed() || _spill()) return;
+        if (_col->t.size() != _elems_data.size()) _detach();
+    }
+
+    // implements DataTimed::get_time_column()
+    TimeColumn* get_time_column(void) const {
+        return (_keepitems && !_packed() && !_spill()) ? _col : NULL;
+    }
+
     /**
      * @brief fetch data at given index
      * @return true if fetched, else data is invalid
      */
     bool get_data(unsigned int index, double &tval, T &dval) const {
-        if (index > _n) return false;
-        dval = _elems_data[index];
-        tval = _elems_time[index];
+        if (index >= _stored()) return false;
+        _sample(index, tval, dval);
         return true;
     }
 
@@ -450,6 +1183,9 @@ public:
              "avg: " << get_average() << " " << _units  << std::endl <<
              "stddev: " << get_stddev() << " " << _units  << std::endl <<
              "time bad: " << (has_bad_timestamps() ? "true" : "false") << std::endl;
+        memuse_t m;
+        get_memory(m);
+        ss << "memory: " << m.describe() << std::endl;
 
         return ss.str();
     }
@@ -463,9 +1199,13 @@ public:
 
         double dt = 1.0 / get_rate();
         double t0 = get_min_time();
-        for (unsigned int k=0; k<_elems_time.size(); ++k) {
-            _elems_time[k] = t0 + dt*k;
+        std::vector<double> & times = _times_mut();
+        for (unsigned int k=0; k<times.size(); ++k) {
+            times[k] = t0 + dt*k;
         }
+        _sorted = true;
+        // values and their order are unchanged, so the indices are still valid
+        _touch();
 
         _bad_timestamps = false;
         _class = DATA_DERIVED;
@@ -473,21 +1213,19 @@ public:
 
     // implements Data::export_csv()
     bool export_csv(const std::string & filename, const std::string & sep = std::string(",")) const {
-        std::ofstream fout(filename.c_str());
+        CsvWriter fout(filename);
 
         if (!fout.is_open()) return false;
 
-        fout << "#time, " << _name << "[" << _units << "]" << std::endl;
-        fout << std::setprecision(9);
-        for (unsigned int k=0; k<_n; k++) {
-            T d = _elems_data[k];
-            double t = _elems_time[k];
-            // write
-            fout << t << sep << d << std::endl;
+        fout << "#time, " << _name << "[" << _units << "]\n";
+        const std::vector<double> & times = _times();
+        const std::vector<T> & values = get_data();
+        const size_t n = std::min(times.size(), values.size());
+        for (size_t k=0; k<n; k++) {
+            fout << times[k] << sep << (T) values[k] << '\n';
         }
 
-        fout.close();
-        return true;
+        return fout.close();
     }
 
     /**
@@ -498,44 +1236,86 @@ public:
         return new DataTimeseries(*this);
     }
 
+    /**
+     * @brief implements DataTimed::CloneCompressed(). The samples are encoded straight
+     * into the copy, no plain copy of them is made.
+     */
+    DataTimeseries* CloneCompressed() const {
+        if (_packed() || _spill()) return Clone(); // cheap already
+        if (!_keepitems || _elems_data.size() < (size_t)CompressedSeries<T>::BLOCK_LEN) return Clone(); // not worth it
+        CompressedSeries<T>*const packed = new CompressedSeries<T>();
+        if (!packed->encode(_times(), _elems_data)) {
+            delete packed;
+            return Clone();
+        }
+        DataTimeseries*const c = new DataTimeseries(*this, false);
+        c->_set_packed(packed);
+        return c;
+    }
+
+    /**
+     * @brief implements Data::Take(). The time column is shared anyway.
+     */
+    DataTimeseries* Take() {
+        std::vector<T> data;
+        data.swap(_elems_data);
+        CompressedSeries<T>*const packed = _packed();
+        _set_packed(NULL);
+        DataTimeseries*const t = new DataTimeseries(*this); // shares the spill region, if any
+        t->_elems_data.swap(data);
+        t->_set_packed(packed);
+        clear();
+        return t;
+    }
+
     // implements Data::merge_in()
     bool merge_in(const Data * const other) {
         const DataTimeseries*const src = dynamic_cast<const DataTimeseries*const>(other);
         if (!src) return false;
         if (!src->_valid) return false;
-
-        const double tmin_src = src->_elems_time.front() + src->_time_epoch_datastart_usec/1E6;
-        const double tmax_src = src->_elems_time.back() + src->_time_epoch_datastart_usec/1E6;
-        const double tmin_me = _elems_time.front() + _time_epoch_datastart_usec/1E6;
-        const double tmax_me = _elems_time.back() + _time_epoch_datastart_usec/1E6;
-        const double dt_sec = (_time_epoch_datastart_usec/1E6 - src->_time_epoch_datastart_usec / 1E6); ///< positive, if my data is more recent
+        const std::vector<double> & theirs = src->_times();
+        std::vector<double> & mine = _times_mut();
 
         /*
-         * we want no negative time stamps, so adjust all *my* relative times by
-         * applying the offset between src and me to *me*
+         * we want no negative time stamps, so the side with the later time base is moved to
+         * the earlier one. That happens while its samples are copied for merging anyway, not
+         * in a pass of its own. The difference of the bases is taken in integer microseconds,
+         * and ranges are compared in the common base: adding epoch seconds (~1E9) to the
+         * relative times would cost their lowest bits.
          */
-        if (dt_sec > 0.) {
-            _time_epoch_datastart_usec = src->_time_epoch_datastart_usec;
-            for (std::vector<double>::iterator it = _elems_time.begin(); it != _elems_time.end(); ++it) {
-                *it += dt_sec;  ///< correct my relative times
-            }
-        }
+        const double dt_sec = ((int64_t)_time_epoch_datastart_usec - (int64_t)src->_time_epoch_datastart_usec) / 1E6; ///< positive, if my data is more recent
+        const double shift_me = (dt_sec > 0.) ? dt_sec : 0.; ///< what to add to my relative times
+        const double shift_src = (dt_sec > 0.) ? 0. : -dt_sec; ///< what to add to src's relative times
+        if (dt_sec > 0.) _time_epoch_datastart_usec = src->_time_epoch_datastart_usec;
+        const double tmin_src = theirs.front() + shift_src;
+        const double tmax_src = theirs.back() + shift_src;
+        const double tmin_me = mine.front() + shift_me;
+        const double tmax_me = mine.back() + shift_me;
 
         /*****************
          *  MERGING IN
          *****************/
-        _elems_time.reserve(_elems_time.size()+src->_elems_time.size());
-        _elems_data.reserve(_elems_data.size()+src->_elems_data.size());
         const bool do_fast_merge = (tmax_src < tmin_me) || (tmin_src > tmax_me); ///< checks for non-overlapping time ranges
         if (do_fast_merge) {
-            if (dt_sec > 0.) {
-                // PREPEND: my data is later (other earlier). we want no negative time stamps, so adjust all my relative times by adding apply the offset from src
-                _elems_time.insert(_elems_time.begin(), src->_elems_time.begin(), src->_elems_time.end()); ///< prepend time
+            if (tmax_src < tmin_me) {
+                // PREPEND: my data is later (other earlier). Both are copied into the new column once.
+                std::vector<double> merged(theirs.size() + mine.size());
+                size_t k = 0;
+                for (std::vector<double>::const_iterator it = theirs.begin(); it != theirs.end(); ++it) merged[k++] = *it + shift_src;
+                for (std::vector<double>::const_iterator it = mine.begin(); it != mine.end(); ++it) merged[k++] = *it + shift_me;
+                mine.swap(merged);
                 _elems_data.insert(_elems_data.begin(), src->_elems_data.begin(), src->_elems_data.end()); ///< prepend data
             } else {
-                // APPEND: my data is older (other more recent). adjust other data's time relative time stamps by adding the offset to it
-                for (std::vector<double>::const_iterator it = src->_elems_time.begin(); it != src->_elems_time.end(); ++it) {
-                    _elems_time.push_back(*it - dt_sec); ///< correct other's time stamp and append at the same time
+                // APPEND: my data is older (other more recent)
+                if (shift_me != 0.) {
+                    for (std::vector<double>::iterator it = mine.begin(); it != mine.end(); ++it) {
+                        *it += shift_me;  ///< correct my relative times
+                    }
+                }
+                mine.reserve(mine.size()+theirs.size());
+                _elems_data.reserve(_elems_data.size()+src->_elems_data.size());
+                for (std::vector<double>::const_iterator it = theirs.begin(); it != theirs.end(); ++it) {
+                    mine.push_back(*it + shift_src); ///< correct other's time stamp and append at the same time
                 }
                 _elems_data.insert(_elems_data.end(), src->_elems_data.begin(), src->_elems_data.end()); ///< append data
             }
@@ -543,15 +1323,15 @@ public:
             // INSERT: data is overlapping...we have to sort-in every single data item
 
             //merge time and data arrays into one array (SOA to AOS) for both our data and other data
-            std::vector<TimedSample> own(_elems_time.size());
-            for (size_t cnt = 0; cnt < _elems_time.size(); cnt++) {
-                TimedSample s = {_elems_time[cnt], _elems_data[cnt]};
+            std::vector<TimedSample> own(mine.size());
+            for (size_t cnt = 0; cnt < mine.size(); cnt++) {
+                TimedSample s = {mine[cnt] + shift_me, _elems_data[cnt]};
                 own[cnt] = s;
             }
 
-            std::vector<TimedSample> others(src->_elems_time.size());
-            for (size_t cnt = 0; cnt < src->_elems_time.size(); cnt++) {
-                TimedSample s = {src->_elems_time[cnt] - dt_sec, src->_elems_data[cnt]};
+            std::vector<TimedSample> others(theirs.size());
+            for (size_t cnt = 0; cnt < theirs.size(); cnt++) {
+                TimedSample s = {theirs[cnt] + shift_src, src->_elems_data[cnt]};
                 others[cnt] = s;
             }
 
@@ -561,7 +1341,7 @@ public:
             //    assert(std::is_sorted(own.begin(),own.end()),"Other data is not sorted");
             //    assert(std::is_sorted(others.begin(),others.end()),"Other data is not sorted");
 
-            const size_t total_size = _elems_time.size() + src->_elems_time.size();
+            const size_t total_size = mine.size() + theirs.size();
             std::vector<TimedSample> merged(total_size);
             std::merge(
                         own.begin(),
@@ -572,44 +1352,575 @@ public:
                         );
 
             //split array containing time and data back into separate arrays
-            _elems_time.resize(total_size);
+            mine.resize(total_size);
             _elems_data.resize(total_size);
 
             for (std::size_t i = 0; i < total_size; ++i) {
-                _elems_time[i] = merged[i].time;
+                mine[i] = merged[i].time;
                 _elems_data[i] = merged[i].data;
             }
         }
 
-        // correct the other class members
-        _sum+=src->_sum;
-        _sqsum+=src->_sqsum;
+        // correct the other class members (Chan et al. for mean and M2)
+        if (src->_n > 0) {
+            const double na = _n, nb = src->_n;
+            const double delta = src->_mean - _mean;
+            _mean += delta * nb / (na + nb);
+            _m2 += src->_m2 + delta * delta * na * nb / (na + nb);
+        }
+        _idx_valid = false;
+        _lod_valid = false;
         if (src->_max > _max) _max = src->_max;
         if (src->_min < _min) _min = src->_min;
-        _min_t = _elems_time.front();
-        _max_t = _elems_time.back();
+        _min_t = mine.front();
+        _max_t = mine.back();
         _n+= src->_elems_data.size();
+        _sorted = _sorted && src->_sorted; // merging keeps order of both, and ranges are disjoint otherwise
+        _touch();
 
         return true;
     }
 
+    /**
+     * @brief implements Data::merge_in_all(). All inputs are merged in one pass with a
+     * k-way heap merge, directly into the final arrays.
+     */
+    bool merge_in_all(const std::vector<const Data*> & others) {
+        bool ok = true;
+        std::vector<const DataTimeseries*> srcs;
+        for (std::vector<const Data*>::const_iterator it = others.begin(); it != others.end(); ++it) {
+            const DataTimeseries*const src = dynamic_cast<const DataTimeseries*const>(*it);
+            if (!src || !src->_valid) {
+                ok = false;
+                continue;
+            }
+            srcs.push_back(src);
+        }
+
+        // the heap merge needs sorted inputs. Otherwise (or if there is nothing to gain) one by one.
+        bool sorted = _valid && _sorted && _keepitems;
+        for (unsigned int k = 0; k < srcs.size(); ++k) sorted = sorted && srcs[k]->_sorted;
+        if (!sorted || srcs.size() < 2) {
+            for (unsigned int k = 0; k < srcs.size(); ++k) ok = merge_in(srcs[k]) && ok;
+            return ok;
+        }
+
+        // input 0 is me. Everything goes to the earliest time base, to avoid negative time stamps.
+        std::vector<const DataTimeseries*> in(1, this);
+        in.insert(in.end(), srcs.begin(), srcs.end());
+        unsigned long epoch = _time_epoch_datastart_usec;
+        size_t total = 0;
+        for (unsigned int k = 0; k < in.size(); ++k) {
+            epoch = std::min(epoch, in[k]->_time_epoch_datastart_usec);
+            in[k]->_unpack();
+            total += in[k]->_elems_data.size();
+        }
+        std::vector<const std::vector<double>*> times(in.size());
+        std::vector<double> shift(in.size());
+        std::vector<size_t> pos(in.size(), 0);
+        std::priority_queue<MergeHead, std::vector<MergeHead>, MergeHeadLater> heap;
+        for (unsigned int k = 0; k < in.size(); ++k) {
+            times[k] = &in[k]->_times();
+            shift[k] = (in[k]->_time_epoch_datastart_usec - epoch) / 1E6;
+            if (!times[k]->empty()) {
+                const MergeHead h = {(*times[k])[0] + shift[k], k};
+                heap.push(h);
+            }
+        }
+
+        std::vector<double> out_time;
+        std::vector<T> out_data;
+        out_time.reserve(total);
+        out_data.reserve(total);
+        while (!heap.empty()) {
+            const MergeHead h = heap.top();
+            heap.pop();
+            const unsigned int k = h.input;
+            const std::vector<double> & t = *times[k];
+            const std::vector<T> & d = in[k]->_elems_data;
+            if (heap.empty()) {
+                // last one: the rest in one go
+                for (size_t j = pos[k]; j < t.size(); ++j) out_time.push_back(t[j] + shift[k]);
+                out_data.insert(out_data.end(), d.begin() + pos[k], d.end());
+                break;
+            }
+            // take everything of this input up to the next head of the other ones
+            const MergeHead next = heap.top();
+            while (true) {
+                out_time.push_back(t[pos[k]] + shift[k]);
+                out_data.push_back(d[pos[k]]);
+                if (++pos[k] >= t.size()) break;
+                const MergeHead cand = {t[pos[k]] + shift[k], k};
+                if (!MergeHeadLater()(next, cand)) {
+                    heap.push(cand);
+                    break;
+                }
+            }
+        }
+
+        // statistics (Chan et al. for mean and M2)
+        for (unsigned int k = 0; k < srcs.size(); ++k) {
+            const DataTimeseries*const src = srcs[k];
+            if (src->_n > 0) {
+                const double na = _n, nb = src->_n;
+                const double delta = src->_mean - _mean;
+                _mean += delta * nb / (na + nb);
+                _m2 += src->_m2 + delta * delta * na * nb / (na + nb);
+            }
+            if (src->_max > _max) _max = src->_max;
+            if (src->_min < _min) _min = src->_min;
+            _n += src->_elems_data.size();
+        }
+
+        _col->unref();
+        _col = new TimeColumn();
+        _col->t.swap(out_time);
+        _elems_data.swap(out_data);
+        _time_epoch_datastart_usec = epoch;
+        _min_t = _col->t.front();
+        _max_t = _col->t.back();
+        _idx_valid = false;
+        _lod_valid = false;
+        _touch();
+        return ok;
+    }
+
 private:
+    enum { STATS_DIRECT_MAX = 65536 }; ///< window statistics scan up to this many samples instead of building the index
+    enum { INDEX_LOCKS = 64 };         ///< series share this many locks for their index, see _index_mutex()
+    enum { STORAGE_LOCKS = 64 };       ///< same for their storage, see _storage_mutex()
+
+    /**
+     * @brief lock for building and reading the window index of this series. Series share a
+     * few of them by address, so that a mutex per series is not needed, and threads working
+     * on different series rarely wait for each other.
+     */
+    QMutex & _index_mutex(void) const {
+        static QMutex m[INDEX_LOCKS];
+        return m[(reinterpret_cast<size_t>(this) / sizeof(void*)) % INDEX_LOCKS];
+    }
+
+    /**
+     * @brief min/max and shifted sums over values [lo, hi) without the index. The
+     * bool overloads exist because std::vector<bool> is not an array.
+     */
+    template <typename U>
+    static void _direct_minmax(const std::vector<U> & v, unsigned int lo, unsigned int hi, U & mn, U & mx) {
+        vec_minmax(&v[lo], hi - lo, mn, mx);
+    }
+    static void _direct_minmax(const std::vector<bool> & v, unsigned int lo, unsigned int hi, bool & mn, bool & mx) {
+        mn = mx = v[lo];
+        for (unsigned int k = lo + 1; k < hi; ++k) {
+            mn = mn && v[k];
+            mx = mx || v[k];
+        }
+    }
+    template <typename U>
+    static void _direct_sums(const std::vector<U> & v, unsigned int lo, unsigned int hi, double shift, double & sum, double & sumsq) {
+        sum += vec_sum(&v[lo], hi - lo) - (hi - lo)*shift;
+        sumsq += vec_sumsq(&v[lo], hi - lo, shift);
+    }
+    static void _direct_sums(const std::vector<bool> & v, unsigned int lo, unsigned int hi, double shift, double & sum, double & sumsq) {
+        for (unsigned int k = lo; k < hi; ++k) {
+            const double x = v[k] - shift;
+            sum += x;
+            sumsq += x*x;
+        }
+    }
+
+    /**
+     * @brief guards replacing the storage: shared time column by a private one,
+     * compressed samples by plain ones, and the block cache. Striped like _index_mutex().
+     */
+    QMutex & _storage_mutex(void) const {
+        static QMutex m[STORAGE_LOCKS];
+        return m[(reinterpret_cast<size_t>(this) / sizeof(void*)) % STORAGE_LOCKS];
+    }
+
+    /**
+     * @brief compressed resp. spilled samples, NULL if plain. Loaded with acquire, so that a
+     * thread seeing NULL after _unpack() also sees the plain samples stored before.
+     * Dereference only while holding _storage_mutex(), _unpack() may free them any time.
+     */
+    CompressedSeries<T>* _packed(void) const { return _load_acquire(_packed_p); }
+    SpillRegion* _spill(void) const { return _load_acquire(_spill_p); }
+    void _set_packed(CompressedSeries<T>* p) const { _store_release(_packed_p, p); }
+    void _set_spill(SpillRegion* r) const { _store_release(_spill_p, r); }
+
+    template <typename P>
+    static P* _load_acquire(QAtomicPointer<P> & a) {
+#if (QT_VERSION >= QT_VERSION_CHECK(5,0,0))
+        return a.loadAcquire();
+#else
+        return a.fetchAndAddAcquire(0);
+#endif
+    }
+
+    template <typename P>
+    static void _store_release(QAtomicPointer<P> & a, P* v) {
+#if (QT_VERSION >= QT_VERSION_CHECK(5,0,0))
+        a.storeRelease(v);
+#else
+        a.fetchAndStoreRelease(v);
+#endif
+    }
+
+    /**
+     * @brief my time stamps. Exactly as many as samples once the writer called seal_times().
+     */
+    const std::vector<double> & _times(void) const {
+        _unpack();
+        return _col->t;
+    }
+
+    /**
+     * @brief my time stamps, for changing them. Never shared.
+     */
+    std::vector<double> & _times_mut(void) {
+        _unpack();
+        if (_col->is_shared() || _col->t.size() != _elems_data.size()) _detach();
+        return _col->t;
+    }
+
+    /**
+     * @brief make the time column private and exactly as long as the data
+     */
+    void _detach(void) {
+        QMutexLocker lock(&_storage_mutex());
+        const size_t len = std::min(_col->t.size(), _elems_data.size());
+        if (!_col->is_shared()) {
+            _col->t.resize(len);
+            return;
+        }
+        TimeColumn*const col = new TimeColumn();
+        col->t.assign(_col->t.begin(), _col->t.begin() + len);
+        _col->unref();
+        _col = col;
+    }
+
+    /**
+     * @brief number of samples kept, plain or compressed
+     */
+    size_t _stored(void) const {
+        if (_packed() || _spill()) {
+            QMutexLocker lock(&_storage_mutex());
+            if (_packed()) return _packed()->size();
+            if (_spill()) return _spill_n;
+        }
+        return _elems_data.size();
+    }
+
+    /**
+     * @brief get_summary() without the pyramid, from the decoded blocks. Blocks outside of
+     * [t0, t1] are skipped by their summary.
+     */
+    bool _summary_blocks(double t0, double t1, unsigned int N, std::vector<lod_bucket> & out) const {
+        const double dt = (t1 - t0) / N;
+        std::vector<double> bt;
+        std::vector<T> bd;
+        lod_bucket cur;
+        unsigned int cur_b = UINT_MAX; ///< bucket of cur, UINT_MAX=none yet
+        const unsigned int nb = get_num_blocks();
+        for (unsigned int b = 0; b < nb; ++b) {
+            double tf, tl;
+            T vmin, vmax;
+            if (get_block_summary(b, tf, tl, vmin, vmax)) {
+                if (tl < t0) continue;
+                if (tf > t1) break;
+            }
+            get_block(b, bt, bd);
+            if (!bt.empty() && bt.front() > t1) break;
+            for (size_t k = 0; k < bt.size(); ++k) {
+                const double t = bt[k];
+                if (t < t0) continue;
+                if (t > t1) break;
+                const T v = bd[k];
+                // same bucket as lower_bound() on the bucket bounds would give
+                unsigned int bucket = (dt > 0.) ? (unsigned int)std::min((double)(N - 1), (t - t0) / dt) : 0;
+                while (bucket > 0 && t < t0 + dt*bucket) bucket--;
+                while (bucket < N - 1 && t >= t0 + dt*(bucket + 1)) bucket++;
+                if (bucket != cur_b) {
+                    if (cur_b != UINT_MAX) out.push_back(cur);
+                    cur_b = bucket;
+                    cur.t_first = t;
+                    cur.first = v;
+                    cur.min = v;
+                    cur.max = v;
+                    cur.n = 0;
+                }
+                cur.t_last = t;
+                cur.last = v;
+                if (v < cur.min) cur.min = v;
+                if (v > cur.max) cur.max = v;
+                cur.n++;
+            }
+        }
+        if (cur_b != UINT_MAX) out.push_back(cur);
+        return true;
+    }
+
+    /**
+     * @brief turn compressed or spilled samples back into plain ones. Logically const.
+     */
+    void _unpack(void) const {
+        if (!_packed() && !_spill()) return;
+        QMutexLocker lock(&_storage_mutex());
+        DataTimeseries*const self = const_cast<DataTimeseries*>(this);
+        if (_spill()) {
+            TimeColumn*const col = new TimeColumn();
+            col->t.assign(_spill_time(), _spill_time() + _spill_n);
+            self->_elems_data.assign(_spill_data(), _spill_data() + _spill_n);
+            _col->unref();
+            _col = col;
+            SpillRegion*const spill = _spill();
+            _set_spill(NULL); // publishes the plain samples
+            spill->unref();
+            _spill_n = 0;
+            return;
+        }
+        if (!_packed()) return;
+        TimeColumn*const col = new TimeColumn();
+        _packed()->decode_all(col->t, self->_elems_data);
+        _col->unref();
+        _col = col;
+        CompressedSeries<T>*const packed = _packed();
+        _set_packed(NULL); // publishes the plain samples
+        delete packed;
+        _cache_block = UINT_MAX;
+        std::vector<double>().swap(_cache_time);
+        std::vector<T>().swap(_cache_data);
+    }
+
+    /**
+     * @brief spilled time stamps and values. Caller holds _storage_mutex().
+     */
+    const double* _spill_time(void) const {
+        return reinterpret_cast<const double*>(_spill()->data());
+    }
+    const T* _spill_data(void) const {
+        return reinterpret_cast<const T*>(_spill()->data() + _spill_n*sizeof(double));
+    }
+
+    /**
+     * @brief decode a block into the cache, if not there already. Caller holds _storage_mutex().
+     */
+    void _load_block(unsigned int b) const {
+        if (_cache_block == b) return;
+        _packed()->decode_block(b, _cache_time, _cache_data);
+        _cache_block = b;
+    }
+
+    /**
+     * @brief sample at index, from wherever it is stored. Index must be valid.
+     */
+    void _sample(unsigned int idx, double & t, T & val) const {
+        if (_packed()) {
+            QMutexLocker lock(&_storage_mutex());
+            if (_packed()) {
+                _load_block(idx / get_block_len());
+                t = _cache_time[idx % get_block_len()];
+                val = _cache_data[idx % get_block_len()];
+                return;
+            }
+        }
+        if (_spill()) {
+            QMutexLocker lock(&_storage_mutex());
+            if (_spill()) {
+                t = _spill_time()[idx];
+                val = _spill_data()[idx];
+                return;
+            }
+        }
+        t = _times()[idx];
+        val = _elems_data[idx];
+    }
+
+    /**
+     * @brief prefix sums over the samples, for get_stats_timewindow(). Only the samples
+     * appended since the last call are summed up, unless the series changed otherwise.
+     */
+    void _build_index(void) const {
+        const unsigned int n = _elems_data.size();
+        unsigned int k = 0;
+        if (_idx_valid && !_idx_sum.empty() && _idx_sum.size() <= n + 1) {
+            k = _idx_sum.size() - 1; // same shift as before
+        } else {
+            _idx_shift = _mean;
+            _idx_sum.assign(1, 0.);
+            _idx_sqsum.assign(1, 0.);
+        }
+        _idx_sum.resize(n + 1);
+        _idx_sqsum.resize(n + 1);
+        for (; k < n; ++k) {
+            const double x = _elems_data[k] - _idx_shift;
+            _idx_sum[k+1] = _idx_sum[k] + x;
+            _idx_sqsum[k+1] = _idx_sqsum[k] + x*x;
+        }
+        _idx_valid = true;
+    }
+
+    /**
+     * @brief level-of-detail pyramid. Level 0 are the samples themselves (not stored),
+     * node j of level L summarizes samples [j*2^L, (j+1)*2^L). _lod[L-1] is level L.
+     * While samples are only appended, just the nodes above them are (re)computed, which
+     * keeps a growing series cheap to draw.
+     */
+    void _build_lod(void) const {
+        const unsigned int n = _elems_data.size();
+        if (!_lod_valid || _lod_n > n) {
+            _lod.clear();
+            _lod_n = 0;
+        }
+        if (_lod_n == n) {
+            _lod_valid = true;
+            return;
+        }
+        unsigned int j0 = _lod_n / 2; ///< first node of the level with new samples below it
+        if (n > 1) {
+            if (_lod.empty()) _lod.push_back(std::vector<lod_node>());
+            std::vector<lod_node> & level = _lod[0];
+            level.resize((n + 1) / 2);
+            for (unsigned int j = j0; j < level.size(); ++j) {
+                const T & a = _elems_data[2*j];
+                const T & b = _elems_data[std::min(2*j + 1, n - 1)];
+                lod_node & node = level[j];
+                node.min = std::min(a, b);
+                node.max = std::max(a, b);
+                node.first = a;
+                node.last = b;
+            }
+        }
+        for (unsigned int L = 1; !_lod.empty() && _lod[L-1].size() > 1; ++L) {
+            if (_lod.size() == L) _lod.push_back(std::vector<lod_node>());
+            j0 /= 2;
+            const std::vector<lod_node> & below = _lod[L-1];
+            std::vector<lod_node> & level = _lod[L];
+            level.resize((below.size() + 1) / 2);
+            for (unsigned int j = j0; j < level.size(); ++j) {
+                const lod_node & a = below[2*j];
+                if (2*j + 1 < below.size()) {
+                    const lod_node & b = below[2*j + 1];
+                    level[j].min = std::min(a.min, b.min);
+                    level[j].max = std::max(a.max, b.max);
+                    level[j].first = a.first;
+                    level[j].last = b.last;
+                } else {
+                    level[j] = a;
+                }
+            }
+        }
+        _lod_n = n;
+        _lod_valid = true;
+    }
+
+    /**
+     * @brief min and max of samples [lo, hi), hi > lo, in O(log n). Pyramid must be valid.
+     */
+    /**
+     * @brief min or max of pyramid node j at level L. Level 0 are the samples.
+     */
+    T _node_value(unsigned int L, unsigned int j, bool is_min) const {
+        if (L == 0) return _elems_data[j];
+        return is_min ? _lod[L-1][j].min : _lod[L-1][j].max;
+    }
+
+    /**
+     * @brief first index in [lo, hi) with value v, where v is the min (or max) in there,
+     * see _index_minmax(). Takes the covering nodes from left to right, and descends into
+     * the first one which has v. Caller holds _index_mutex().
+     */
+    unsigned int _index_find(unsigned int lo, unsigned int hi, T v, bool is_min) const {
+        std::vector<std::pair<unsigned int, unsigned int> > left, right; ///< (level, node)
+        for (unsigned int L = 0; lo < hi && L <= _lod.size(); ++L, lo >>= 1, hi >>= 1) {
+            if (lo & 1) left.push_back(std::make_pair(L, lo++));
+            if (hi & 1) right.push_back(std::make_pair(L, --hi));
+        }
+        left.insert(left.end(), right.rbegin(), right.rend());
+
+        for (std::vector<std::pair<unsigned int, unsigned int> >::const_iterator it = left.begin(); it != left.end(); ++it) {
+            unsigned int L = it->first, j = it->second;
+            if (!(_node_value(L, j, is_min) == v)) continue;
+            for (; L > 0; --L) {
+                j *= 2;
+                if (!(_node_value(L-1, j, is_min) == v)) j++; // then the right child has it
+            }
+            return j;
+        }
+        return left.empty() ? 0 : left.front().second << left.front().first; // only for NaN
+    }
+
+    void _index_minmax(unsigned int lo, unsigned int hi, T & mn, T & mx) const {
+        mn = mx = _elems_data[lo];
+        // level 0: the samples
+        if (lo & 1) {
+            mn = std::min(mn, _elems_data[lo]);
+            mx = std::max(mx, _elems_data[lo]);
+            lo++;
+        }
+        if (hi & 1) {
+            hi--;
+            mn = std::min(mn, _elems_data[hi]);
+            mx = std::max(mx, _elems_data[hi]);
+        }
+        lo >>= 1; hi >>= 1;
+        // then up the pyramid, taking the nodes at the borders
+        for (unsigned int L = 0; lo < hi && L < _lod.size(); ++L, lo >>= 1, hi >>= 1) {
+            const std::vector<lod_node> & level = _lod[L];
+            if (lo & 1) {
+                mn = std::min(mn, level[lo].min);
+                mx = std::max(mx, level[lo].max);
+                lo++;
+            }
+            if (hi & 1) {
+                hi--;
+                mn = std::min(mn, level[hi].min);
+                mx = std::max(mx, level[hi].max);
+            }
+        }
+    }
+
     unsigned int    _n;
     bool            _keepitems;    
 
     // FIXME: this storage format is not all that good...pairs would be nicer, but are harder to access
     //std::vector< timeseries_elem >  _elems; // better but plotting would be tedious
     std::vector<T>      _elems_data;    ///< only used if keepitems=true
-    std::vector<double> _elems_time;    ///< only used if keepitems=true
+    mutable TimeColumn* _col;           ///< time stamps, maybe with other series. Only used if keepitems=true
 
-    double          _sum;
-    double          _sqsum;
+    // compressed storage, see compress(). Then _elems_data and _col are empty.
+    mutable QAtomicPointer< CompressedSeries<T> > _packed_p; ///< NULL=plain storage, see _packed()
+    mutable unsigned int         _cache_block; ///< block in the cache, UINT_MAX=none
+    mutable std::vector<double>  _cache_time;
+    mutable std::vector<T>       _cache_data;
+
+    // out-of-core storage, see spill(). Then _elems_data and _col are empty.
+    enum { SPILL_BUFLEN = 4096 };
+    mutable QAtomicPointer<SpillRegion> _spill_p; ///< NULL=in memory. Time stamps, then values. See _spill()
+    mutable size_t               _spill_n;     ///< number of samples in there
+
+    double          _mean;  ///< running mean (Welford)
+    double          _m2;    ///< running sum of squared differences from mean (Welford)
     T               _max;
     T               _min;
     double          _max_t;
     double          _min_t;
     bool            _max_valid;
     bool            _min_valid;    
+    bool            _sorted;          ///< time stamps are non-decreasing
+    mutable QAtomicInt _warned_unsorted; ///< told user about slow lookups. Set from const lookups, which can run concurrently
+
+    // prefix sums, built on first get_stats_timewindow() after a change, extended after appends
+    mutable bool                _idx_valid;
+    mutable double              _idx_shift;  ///< subtracted from values before summing
+    mutable std::vector<double> _idx_sum;    ///< _idx_sum[k] = sum of first k values
+    mutable std::vector<double> _idx_sqsum;  ///< same for squares
+
+    // level-of-detail pyramid, built on first use after a change, extended after appends
+    mutable bool                                 _lod_valid;
+    mutable unsigned int                         _lod_n; ///< number of samples it covers
+    mutable std::vector<std::vector<lod_node> >  _lod;
+
+    friend class ScenarioCache;
 };
 
 #endif // DATA_TIMESERIES_H
@@ -0,0 +1,195 @@
+/**
+ * @file data_window.h
+ * @brief Sliding-window operators (average, min, max, stddev, median) over timed samples in O(n) or O(n log w).
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef DATA_WINDOW_H
+#define DATA_WINDOW_H
+
+#include <vector>
+#include <deque>
+#include <set>
+#include <math.h>
+
+/**
+ * @brief For every sample k, computes an operator over all samples j with
+ * |time[j] - time[k]| <= halfwidth. Both window borders only move forward, so each
+ * sample enters and leaves the window once.
+ *
+ * Works on the plain arrays of a DataTimeseries, use DataTimeseries<T>::windowed()
+ * to get a new series. Times must be sorted (non-decreasing).
+ */
+template <typename T>
+class DataWindow
+{
+public:
+    typedef enum {
+        WINDOW_AVG=0,   ///< running sum, O(n)
+        WINDOW_MIN,     ///< monotonic deque, O(n)
+        WINDOW_MAX,     ///< monotonic deque, O(n)
+        WINDOW_STDDEV,  ///< running sum of squares, O(n)
+        WINDOW_MEDIAN   ///< two balanced multisets, O(n log w)
+    } window_op_e;
+
+    static const char* get_opname(window_op_e op) {
+        switch (op) {
+        case WINDOW_AVG: return "avg";
+        case WINDOW_MIN: return "min";
+        case WINDOW_MAX: return "max";
+        case WINDOW_STDDEV: return "stddev";
+        case WINDOW_MEDIAN: return "median";
+        }
+        return "?";
+    }
+
+    /**
+     * @param time sorted time stamps
+     * @param data one value per time stamp
+     * @param op what to compute
+     * @param halfwidth_sec window reaches this far into past and future
+     * @param out one result per sample. Resized.
+     * @return false if sizes do not match or halfwidth is negative
+     */
+    static bool apply(const std::vector<double> & time, const std::vector<T> & data, window_op_e op,
+                      double halfwidth_sec, std::vector<T> & out) {
+        if (time.size() != data.size() || halfwidth_sec < 0.) return false;
+        const unsigned int n = time.size();
+        out.resize(n);
+
+        State s(op);
+        unsigned int lo = 0, hi = 0; ///< window is [lo, hi)
+        for (unsigned int k = 0; k < n; ++k) {
+            const double tmin = time[k] - halfwidth_sec, tmax = time[k] + halfwidth_sec;
+            while (hi < n && time[hi] <= tmax) s.push(data, hi++);
+            while (lo < hi && time[lo] < tmin) s.pop(data, lo++);
+            out[k] = s.result(data);
+        }
+        return true;
+    }
+
+private:
+    /**
+     * @brief the samples currently in the window, in the form the operator needs
+     */
+    class State {
+    public:
+        State(window_op_e op) : _op(op), _n(0), _sum(0.), _sqsum(0.) {}
+
+        void push(const std::vector<T> & data, unsigned int idx) {
+            const T & x = data[idx];
+            _n++;
+            switch (_op) {
+            case WINDOW_AVG:
+            case WINDOW_STDDEV:
+                _sum += x;
+                _sqsum += (double)x*x;
+                break;
+            case WINDOW_MIN:
+                while (!_deque.empty() && !(data[_deque.back()] < x)) _deque.pop_back();
+                _deque.push_back(idx);
+                break;
+            case WINDOW_MAX:
+                while (!_deque.empty() && !(data[_deque.back()] > x)) _deque.pop_back();
+                _deque.push_back(idx);
+                break;
+            case WINDOW_MEDIAN:
+                if (_low.empty() || !(*_low.rbegin() < x)) {
+                    _low.insert(x);
+                } else {
+                    _high.insert(x);
+                }
+                _balance();
+                break;
+            }
+        }
+
+        void pop(const std::vector<T> & data, unsigned int idx) {
+            const T & x = data[idx];
+            _n--;
+            switch (_op) {
+            case WINDOW_AVG:
+            case WINDOW_STDDEV:
+                _sum -= x;
+                _sqsum -= (double)x*x;
+                break;
+            case WINDOW_MIN:
+            case WINDOW_MAX:
+                if (!_deque.empty() && _deque.front() == idx) _deque.pop_front();
+                break;
+            case WINDOW_MEDIAN:
+                // all in _low are <= all in _high
+                if (!(*_low.rbegin() < x)) {
+                    _low.erase(_low.find(x));
+                } else {
+                    _high.erase(_high.find(x));
+                }
+                _balance();
+                break;
+            }
+        }
+
+        T result(const std::vector<T> & data) const {
+            if (_n == 0) return T();
+            switch (_op) {
+            case WINDOW_AVG:
+                return (T) (_sum / _n);
+            case WINDOW_STDDEV: {
+                const double avg = _sum / _n;
+                const double var = _sqsum / _n - avg*avg;
+                return (T) (var > 0. ? sqrt(var) : 0.);
+            }
+            case WINDOW_MIN:
+            case WINDOW_MAX:
+                return data[_deque.front()];
+            case WINDOW_MEDIAN:
+                if (_low.size() > _high.size()) return *_low.rbegin();
+                return (T) (((double)*_low.rbegin() + (double)*_high.begin()) / 2.);
+            }
+            return T();
+        }
+
+    private:
+        /**
+         * @brief keep |_low| == |_high| or |_low| == |_high| + 1, then the median is at the border
+         */
+        void _balance(void) {
+            if (_low.size() > _high.size() + 1) {
+                typename std::multiset<T>::iterator it = --_low.end();
+                _high.insert(*it);
+                _low.erase(it);
+            } else if (_high.size() > _low.size()) {
+                typename std::multiset<T>::iterator it = _high.begin();
+                _low.insert(*it);
+                _high.erase(it);
+            }
+        }
+
+        window_op_e              _op;
+        unsigned int             _n;
+        double                   _sum;
+        double                   _sqsum;
+        std::deque<unsigned int> _deque; ///< min/max: indices of candidates, values monotonic
+        std::multiset<T>         _low;   ///< median: lower half
+        std::multiset<T>         _high;  ///< median: upper half
+    };
+};
+
+#endif // DATA_WINDOW_H
@@ -0,0 +1,385 @@
+/**
+ * @file dataexport.cpp
+ * @brief Exports many data items at once: CSV files in parallel, or one binary columnar file.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <iostream>
+#include <map>
+#include <algorithm>
+#include <cstdio>
+#include <stdint.h>
+#include <QRunnable>
+#include "dataexport.h"
+#include "csvwriter.h"
+#include "data_timeseries.h"
+#include "data_event.h"
+#include "data_param.h"
+#include "mavlinkscenario.h"
+#include "mavsystem.h"
+#include "taskpool.h"
+
+#define MLC_MAGIC "MLACOL1\n"
+#define MLC_MAGIC_LEN 8
+#define MLC_ALIGN 8
+#define MLC_BUFSIZE (4 << 20)
+#define MLC_CHUNK 65536 ///< elements converted at once, where the array cannot be written as it is
+
+// shorthand for demuxing polymorphic data
+#define TRY_COLUMN_DATATIMESERIES(data, typetest) \
+    if (!done) if (const DataTimeseries<typetest>*tmp = dynamic_cast<const DataTimeseries<typetest> *>(data)) { \
+        done = file.timeseries(*tmp, meta); \
+    }
+#define TRY_COLUMN_DATAPARAM(data, typetest) \
+    if (!done) if (const DataParam<typetest>*tmp = dynamic_cast<const DataParam<typetest> *>(data)) { \
+        meta += ",\"kind\":\"param\",\"value\":"; \
+        file.json_number(meta, (double) tmp->get_value()); \
+        done = true; \
+    }
+
+/**
+ * @brief writes one CSV file in the pool of DataExport::csv()
+ */
+class DataExportCsvJob : public QRunnable {
+public:
+    DataExportCsvJob(const Data*d, const std::string & filename, char*ok) : _d(d), _filename(filename), _ok(ok) {}
+    void run() { *_ok = _d->export_csv(_filename) ? 1 : 0; }
+private:
+    const Data*const  _d;
+    const std::string _filename;
+    char*const        _ok;
+};
+
+/**
+ * @brief the arrays and the footer of a columnar file, see dataexport.h
+ */
+class DataExportColumnar {
+public:
+    DataExportColumnar(const std::string & filename) : _pos(0), _error(false) {
+        _f = fopen(filename.c_str(), "wb");
+        if (_f) setvbuf(_f, NULL, _IOFBF, MLC_BUFSIZE);
+        const uint16_t one = 1;
+        _endian = (*(const char*)&one == 1) ? '<' : '>';
+        _write(MLC_MAGIC, MLC_MAGIC_LEN);
+    }
+
+    bool is_open(void) const { return _f != NULL; }
+
+    /**
+     * @brief append the footer and close
+     * @return false if anything could not be written
+     */
+    bool close(const std::string & json) {
+        if (!_f) return false;
+        _write(json.data(), json.size());
+        unsigned char len[8];
+        unsigned long long n = json.size();
+        for (unsigned int k = 0; k < 8; ++k, n >>= 8) len[k] = (unsigned char)(n & 0xFF);
+        _write(len, sizeof(len));
+        _write(MLC_MAGIC, MLC_MAGIC_LEN);
+        if (fclose(_f) != 0) _error = true;
+        _f = NULL;
+        return !_error;
+    }
+
+    ~DataExportColumnar() {
+        if (_f) fclose(_f);
+    }
+
+    template <typename T>
+    bool timeseries(const DataTimeseries<T> & d, std::string & meta) {
+        const std::vector<double> & t = d.get_time();
+        const std::vector<T> & v = d.get_data();
+        meta += ",\"kind\":\"timeseries\"";
+        _times(meta, t, d.get_epoch_datastart());
+        meta += ",\"values\":";
+        _array(meta, v);
+        meta += "}";
+        return true;
+    }
+
+    template <typename T>
+    bool event(const DataEvent<T> & d, std::string & meta) {
+        meta += ",\"kind\":\"event\"";
+        _times(meta, d.get_time(), d.get_epoch_datastart());
+        meta += ",\"values\":";
+        _array(meta, d.get_stored());
+        meta += "}";
+        return true;
+    }
+
+    bool event(const DataEvent<std::string> & d, std::string & meta) {
+        // the ids in EventDict are global; give the file its own codes 0..n-1
+        const std::vector<EventDict::id_t> & ids = d.get_stored();
+        std::map<EventDict::id_t, uint32_t> codes;
+        std::vector<EventDict::id_t> cats;
+        std::vector<uint32_t> v(ids.size());
+        for (size_t k = 0; k < ids.size(); ++k) {
+            std::map<EventDict::id_t, uint32_t>::const_iterator it = codes.find(ids[k]);
+            if (it == codes.end()) {
+                it = codes.insert(std::make_pair(ids[k], (uint32_t) cats.size())).first;
+                cats.push_back(ids[k]);
+            }
+            v[k] = it->second;
+        }
+        meta += ",\"kind\":\"event\"";
+        _times(meta, d.get_time(), d.get_epoch_datastart());
+        meta += ",\"values\":";
+        _array(meta, v);
+        meta += ",\"categories\":[";
+        for (size_t k = 0; k < cats.size(); ++k) {
+            if (k > 0) meta += ",";
+            json_string(meta, EventDict::lookup(cats[k]));
+        }
+        meta += "]}";
+        return true;
+    }
+
+    /**
+     * @brief append as JSON number; JSON has no NaN, so that is null
+     */
+    void json_number(std::string & out, double v) const {
+        if (v != v || v - v != 0) {
+            out += "null";
+            return;
+        }
+        char buf[32];
+        out.append(buf, CsvWriter::format(buf, v) - buf);
+    }
+
+    void json_number(std::string & out, unsigned long long v) const {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%llu", v);
+        out += buf;
+    }
+
+    /**
+     * @brief append as JSON string
+     */
+    static void json_string(std::string & out, const std::string & s) {
+        out += '"';
+        for (std::string::const_iterator it = s.begin(); it != s.end(); ++it) {
+            const unsigned char c = (unsigned char) *it;
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += *it;
+            } else if (c < 0x20) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            } else {
+                out += *it;
+            }
+        }
+        out += '"';
+    }
+
+private:
+    static const char* _dtype(float)        { return "f4"; }
+    static const char* _dtype(double)       { return "f8"; }
+    static const char* _dtype(int)          { return "i4"; }
+    static const char* _dtype(unsigned int) { return "u4"; }
+
+    void _write(const void*p, size_t n) {
+        if (n == 0) return;
+        if (!_f || fwrite(p, 1, n, _f) != n) _error = true;
+        _pos += n;
+    }
+
+    void _align(void) {
+        static const char zeros[MLC_ALIGN] = {0};
+        _write(zeros, (MLC_ALIGN - _pos % MLC_ALIGN) % MLC_ALIGN);
+    }
+
+    void _offset(std::string & meta, const char*dtype, bool endian) {
+        meta += "{\"offset\":";
+        json_number(meta, _pos);
+        meta += ",\"dtype\":\"";
+        meta += endian ? _endian : '|';
+        meta += dtype;
+        meta += "\"";
+    }
+
+    /**
+     * @brief write an array, and append its description without the closing brace
+     */
+    template <typename T>
+    void _array(std::string & meta, const std::vector<T> & v) {
+        _align();
+        _offset(meta, _dtype(T()), true);
+        if (!v.empty()) _write(&v[0], v.size() * sizeof(T));
+    }
+
+    void _array(std::string & meta, const std::vector<bool> & v) {
+        _align();
+        _offset(meta, "b1", false);
+        unsigned char buf[MLC_CHUNK];
+        for (size_t lo = 0; lo < v.size(); lo += MLC_CHUNK) {
+            const size_t len = std::min(v.size() - lo, (size_t) MLC_CHUNK);
+            for (size_t k = 0; k < len; ++k) buf[k] = v[lo + k] ? 1 : 0;
+            _write(buf, len);
+        }
+    }
+
+    /**
+     * @brief write time stamps, unless the same array was written before
+     */
+    void _times(std::string & meta, const std::vector<double> & t, unsigned long long epoch_usec) {
+        meta += ",\"n\":";
+        json_number(meta, (unsigned long long) t.size());
+        meta += ",\"epoch_usec\":";
+        json_number(meta, epoch_usec);
+        meta += ",\"time\":";
+        const std::pair<const double*, size_t> key(t.empty() ? NULL : &t[0], t.size());
+        std::map<std::pair<const double*, size_t>, unsigned long long>::const_iterator it = _written.find(key);
+        if (it != _written.end() && key.first) {
+            meta += "{\"offset\":";
+            json_number(meta, it->second);
+            meta += ",\"dtype\":\"";
+            meta += _endian;
+            meta += "f8\"}";
+            return;
+        }
+        _align();
+        _written[key] = _pos;
+        _array(meta, t);
+        meta += "}";
+    }
+
+    FILE*              _f;
+    unsigned long long _pos;
+    bool               _error;
+    char               _endian;
+    std::map<std::pair<const double*, size_t>, unsigned long long> _written; ///< time arrays, by address
+};
+
+std::string DataExport::csv_filename(const std::string & prefix, const Data*d) {
+    return prefix + "_" + d->get_name() + ".csv";
+}
+
+unsigned int DataExport::csv(const std::vector<const Data*> & data, const std::string & prefix, unsigned int nthreads) {
+    std::vector<char> ok(data.size(), 0);
+    if (1 == nthreads || data.size() < 2) {
+        for (size_t k = 0; k < data.size(); ++k) {
+            if (data[k]) ok[k] = data[k]->export_csv(csv_filename(prefix, data[k])) ? 1 : 0;
+        }
+    } else {
+        // formatting is the bottleneck, not the disk; each file in a thread of its own
+        TaskGroup tasks(nthreads);
+        for (size_t k = 0; k < data.size(); ++k) {
+            if (data[k]) tasks.start(new DataExportCsvJob(data[k], csv_filename(prefix, data[k]), &ok[k]));
+        }
+        tasks.wait();
+    }
+
+    unsigned int n = 0;
+    for (size_t k = 0; k < ok.size(); ++k) {
+        if (ok[k]) {
+            n++;
+        } else if (data[k]) {
+            std::cerr << "Error exporting " << data[k]->get_name() << " to " << csv_filename(prefix, data[k]) << std::endl;
+        }
+    }
+    return n;
+}
+
+unsigned int DataExport::columnar(const std::vector<const Data*> & data, const std::string & filename) {
+    std::vector<column_t> cols;
+    for (std::vector<const Data*>::const_iterator it = data.begin(); it != data.end(); ++it) {
+        column_t c;
+        c.data = *it;
+        c.system = -1;
+        cols.push_back(c);
+    }
+    return _columnar(cols, filename);
+}
+
+unsigned int DataExport::columnar(const MavlinkScenario*scen, const std::string & filename) {
+    if (!scen) return 0;
+    std::vector<column_t> cols;
+    const std::vector<const MavSystem*> systems = scen->getSystems();
+    for (std::vector<const MavSystem*>::const_iterator its = systems.begin(); its != systems.end(); ++its) {
+        std::vector<const Data*> data;
+        (*its)->get_all_data(data);
+        for (std::vector<const Data*>::const_iterator it = data.begin(); it != data.end(); ++it) {
+            column_t c;
+            c.data = *it;
+            c.system = (int) (*its)->get_id();
+            cols.push_back(c);
+        }
+    }
+    return _columnar(cols, filename);
+}
+
+unsigned int DataExport::_columnar(const std::vector<column_t> & cols, const std::string & filename) {
+    DataExportColumnar file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Cannot open " << filename << " for writing" << std::endl;
+        return 0;
+    }
+
+    std::string json = "{\"format\":\"mlacol\",\"version\":1,\"columns\":[";
+    unsigned int n = 0;
+    for (std::vector<column_t>::const_iterator it = cols.begin(); it != cols.end(); ++it) {
+        const Data*const d = it->data;
+        if (!d) continue;
+        std::string meta = "{\"name\":";
+        DataExportColumnar::json_string(meta, Data::get_fullname(d));
+        meta += ",\"units\":";
+        DataExportColumnar::json_string(meta, d->get_units());
+        if (it->system >= 0) {
+            meta += ",\"system\":";
+            file.json_number(meta, (unsigned long long) it->system);
+        }
+
+        bool done = false;
+        TRY_COLUMN_DATATIMESERIES(d, float);
+        TRY_COLUMN_DATATIMESERIES(d, double);
+        TRY_COLUMN_DATATIMESERIES(d, int);
+        TRY_COLUMN_DATATIMESERIES(d, unsigned int);
+        TRY_COLUMN_DATATIMESERIES(d, bool);
+        if (!done) if (const DataEvent<std::string>*tmp = dynamic_cast<const DataEvent<std::string>*>(d)) {
+            done = file.event(*tmp, meta);
+        }
+        if (!done) if (const DataEvent<bool>*tmp = dynamic_cast<const DataEvent<bool>*>(d)) {
+            done = file.event(*tmp, meta);
+        }
+        TRY_COLUMN_DATAPARAM(d, float);
+        TRY_COLUMN_DATAPARAM(d, double);
+        TRY_COLUMN_DATAPARAM(d, int);
+        TRY_COLUMN_DATAPARAM(d, unsigned int);
+        if (!done) {
+            std::cerr << "Columnar export: skipping " << d->get_name() << " of unsupported type " << d->get_typename() << std::endl;
+            continue;
+        }
+
+        if (n > 0) json += ",";
+        json += meta;
+        json += "}";
+        n++;
+    }
+    json += "]}";
+
+    if (!file.close(json)) {
+        std::cerr << "Error writing " << filename << std::endl;
+        return 0;
+    }
+    return n;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file dataexport.h
+ * @brief Exports many data items at once: CSV files in parallel, or one binary columnar file.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef DATAEXPORT_H
+#define DATAEXPORT_H
+
+#include <string>
+#include <vector>
+#include "data.h"
+
+class MavlinkScenario;
+
+/**
+ * @brief The columnar file (*.mlc) holds the raw sample arrays, 8-byte aligned, followed by
+ * a JSON footer which describes them:
+ *
+ *   "MLACOL1\n" | arrays ... | JSON | JSON length (uint64, little endian) | "MLACOL1\n"
+ *
+ * The footer is {"format":"mlacol","version":1,"columns":[...]}, each column like
+ *   {"name":"ATT/Roll","units":"deg","system":1,"kind":"timeseries","n":1000,"epoch_usec":...,
+ *    "time":{"offset":8,"dtype":"<f8"},"values":{"offset":8008,"dtype":"<f4"}}
+ * where offset is from the beginning of the file and dtype is a numpy type string. Times
+ * are seconds relative to epoch_usec. Series which share their time stamps share the array.
+ * String events have "values":{...,"dtype":"<u4","categories":[...]}, i.e., the values are
+ * codes into that list. Parameters have "kind":"param" and their "value" right in the JSON.
+ *
+ * Reading in Python:
+ *   raw = numpy.memmap(fn, mode='r'); n = int(raw[-16:-8].view('<u8')[0])
+ *   meta = json.loads(raw[-16-n:-16].tobytes())
+ *   col = lambda a, n: numpy.frombuffer(raw, a['dtype'], n, a['offset'])
+ */
+class DataExport
+{
+public:
+    /**
+     * @brief write each data into its own CSV file, see csv_filename(), several at once
+     * @param nthreads how many files are written at the same time. 0=one per core
+     * @return number of files written
+     */
+    static unsigned int csv(const std::vector<const Data*> & data, const std::string & prefix, unsigned int nthreads = 0);
+
+    /**
+     * @return the name of the CSV file for d, as written by csv()
+     */
+    static std::string csv_filename(const std::string & prefix, const Data*d);
+
+    /**
+     * @brief write all data into one columnar file, see above
+     * @return number of columns written, 0 on error
+     */
+    static unsigned int columnar(const std::vector<const Data*> & data, const std::string & filename);
+
+    /**
+     * @brief same, for all data of all systems in the scenario
+     */
+    static unsigned int columnar(const MavlinkScenario*scen, const std::string & filename);
+
+private:
+    typedef struct {
+        const Data* data;
+        int         system; ///< <0=unknown
+    } column_t;
+
+    static unsigned int _columnar(const std::vector<column_t> & cols, const std::string & filename);
+};
+
+#endif // DATAEXPORT_H
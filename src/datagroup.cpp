@@ -22,8 +22,19 @@
  */
 
 #include "datagroup.h"
+#include "data.h"
 
 DataGroup::DataGroup(std::string groupname) : groupname(groupname), parent(NULL) {
     //nothing
     itemtype = GROUP;
 }
+
+void DataGroup::get_memory(memuse_t & m) const {
+    m.meta += sizeof(*this) + groupname.capacity();
+    for (datamap::const_iterator it = data.begin(); it != data.end(); ++it) {
+        if (it->second) it->second->get_memory(m);
+    }
+    for (groupmap::const_iterator it = groups.begin(); it != groups.end(); ++it) {
+        if (it->second) it->second->get_memory(m);
+    }
+}
@@ -24,9 +24,91 @@
 #ifndef DATAGROUP_H
 #define DATAGROUP_H
 
-#include <map>
+#include <algorithm>
 #include <string>
+#include <vector>
 #include "treeitem.h"
+#include "memuse.h"
+
+/**
+ * @brief Children of a group by name: one contiguous array, sorted by name, instead of a
+ * tree of heap nodes. Has the interface of the std::map it replaces (iterators point to
+ * pairs of name and item), plus access by index, which is the row in the tree view.
+ * Lookup is a binary search; inserting and erasing move the entries behind, which is cheap
+ * for the number of children a group has.
+ */
+template <class T>
+class SortedChildren {
+public:
+    typedef std::pair<std::string,T*> value_type;
+    typedef typename std::vector<value_type>::iterator iterator;
+    typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+    iterator begin(void) { return _items.begin(); }
+    iterator end(void) { return _items.end(); }
+    const_iterator begin(void) const { return _items.begin(); }
+    const_iterator end(void) const { return _items.end(); }
+    size_t size(void) const { return _items.size(); }
+    bool empty(void) const { return _items.empty(); }
+    void clear(void) { std::vector<value_type>().swap(_items); }
+
+    /**
+     * @brief the k-th child in order of names
+     */
+    const value_type & at(size_t k) const { return _items[k]; }
+
+    /**
+     * @return index of the child with that name, or -1
+     */
+    int index_of(const std::string & name) const {
+        const_iterator it = find(name);
+        return (it == end()) ? -1 : (int)(it - begin());
+    }
+
+    iterator find(const std::string & name) {
+        iterator it = std::lower_bound(_items.begin(), _items.end(), name, _less);
+        return (it != _items.end() && it->first == name) ? it : _items.end();
+    }
+    const_iterator find(const std::string & name) const {
+        const_iterator it = std::lower_bound(_items.begin(), _items.end(), name, _less);
+        return (it != _items.end() && it->first == name) ? it : _items.end();
+    }
+
+    /**
+     * @brief like std::map: the child with that name, added as NULL if there is none
+     */
+    T*& operator[](const std::string & name) {
+        iterator it = std::lower_bound(_items.begin(), _items.end(), name, _less);
+        if (it == _items.end() || it->first != name) it = _items.insert(it, value_type(name, (T*)NULL));
+        return it->second;
+    }
+
+    /**
+     * @brief like std::map, an existing child of that name stays
+     */
+    std::pair<iterator,bool> insert(const value_type & v) {
+        iterator it = std::lower_bound(_items.begin(), _items.end(), v.first, _less);
+        if (it != _items.end() && it->first == v.first) return std::pair<iterator,bool>(it, false);
+        return std::pair<iterator,bool>(_items.insert(it, v), true);
+    }
+    iterator insert(iterator /*hint*/, const value_type & v) { return insert(v).first; }
+
+    void erase(iterator it) { _items.erase(it); }
+    size_t erase(const std::string & name) {
+        iterator it = find(name);
+        if (it == _items.end()) return 0;
+        _items.erase(it);
+        return 1;
+    }
+
+private:
+    static bool _less(const value_type & v, const std::string & name) { return v.first < name; }
+
+    /****************************************
+     *   DATA MEMBERS
+     ****************************************/
+    std::vector<value_type> _items; ///< sorted by name, unique
+};
 
 class Data; ///< forward decl
 class DataGroup : public TreeItem {
@@ -38,11 +120,11 @@ public:
      */
 
 
-    typedef std::map<std::string,Data*> datamap;               ///< associative array: String => Data*
-    typedef std::pair<std::string,Data*> datamap_pair;         ///< needed for inserting
+    typedef SortedChildren<Data> datamap;                      ///< by name: String => Data*
+    typedef datamap::value_type datamap_pair;                  ///< needed for inserting
     datamap data;                                              ///< data within this group
-    typedef std::map<std::string,DataGroup*> groupmap;         ///< associative array: String => DataGroup*
-    typedef std::pair<std::string,DataGroup*> groupmap_pair;   ///< needed for inserting
+    typedef SortedChildren<DataGroup> groupmap;                ///< by name: String => DataGroup*
+    typedef groupmap::value_type groupmap_pair;                ///< needed for inserting
     groupmap groups;                                           ///< subgroups within this group (may again contain data, of course)    
 
     std::string groupname; ///< descriptive name of this group (this is what goes into the map of thir group's parents)
@@ -52,6 +134,11 @@ public:
         parent = p;
     }
 
+    /**
+     * @brief add the memory of all data in here and in the subgroups, see Data::get_memory()
+     */
+    void get_memory(memuse_t & m) const;
+
 };
 
 #endif // DATAGROUP_H
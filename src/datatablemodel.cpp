@@ -0,0 +1,96 @@
+/**
+ * @file datatablemodel.cpp
+ * @brief Table model of the samples of one Data, formatted only when shown
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include "datatablemodel.h"
+
+// shorthand for demuxing polymorphic data
+#define TRY_ROWS_DATATIMESERIES(data, typetest) \
+    if (!rows) if (const DataTimeseries<typetest>*tmp = dynamic_cast<const DataTimeseries<typetest> *>(data)) { \
+        rows = new DataTableTimeseriesRows<typetest>(tmp); \
+    }
+#define TRY_ROWS_DATAEVENT(data, typetest) \
+    if (!rows) if (const DataEvent<typetest>*tmp = dynamic_cast<const DataEvent<typetest> *>(data)) { \
+        rows = new DataTableEventRows<typetest>(tmp); \
+    }
+
+DataTableModel::DataTableModel(QObject *parent) : QAbstractTableModel(parent), _rows(NULL) {}
+
+DataTableModel::~DataTableModel() {
+    delete _rows;
+}
+
+bool DataTableModel::setData(const Data * d) {
+    Rows * rows = NULL;
+    if (d) {
+        TRY_ROWS_DATATIMESERIES(d, int);
+        TRY_ROWS_DATATIMESERIES(d, long);
+        TRY_ROWS_DATATIMESERIES(d, float);
+        TRY_ROWS_DATATIMESERIES(d, double);
+        TRY_ROWS_DATATIMESERIES(d, unsigned int);
+        TRY_ROWS_DATATIMESERIES(d, unsigned long);
+        TRY_ROWS_DATAEVENT(d, bool);
+        TRY_ROWS_DATAEVENT(d, std::string);
+    }
+
+    #if QT_VERSION >= 0x050000
+        beginResetModel();
+    #endif
+    delete _rows;
+    _rows = rows;
+    #if QT_VERSION >= 0x050000
+        endResetModel();
+    #else
+        reset(); // qt4
+    #endif
+    return rows != NULL;
+}
+
+int DataTableModel::rowCount(const QModelIndex &parent) const {
+    if (parent.isValid() || !_rows) return 0;
+    return (int) _rows->size();
+}
+
+int DataTableModel::columnCount(const QModelIndex &parent) const {
+    if (parent.isValid()) return 0;
+    return 2;
+}
+
+QVariant DataTableModel::data(const QModelIndex &index, int role) const {
+    if (role != Qt::DisplayRole || !_rows || !index.isValid()) return QVariant();
+    double t;
+    QString value;
+    if (!_rows->get(index.row(), t, value)) return QVariant();
+    return (index.column() == 0) ? QString::number(t) : value;
+}
+
+QVariant DataTableModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (role == Qt::DisplayRole && orientation == Qt::Horizontal) {
+        return (section == 0) ? QString("Time") : QString("Data");
+    }
+    return QAbstractTableModel::headerData(section, orientation, role);
+}
+
+int DataTableModel::findTime(double t) const {
+    if (!_rows || _rows->size() == 0) return -1;
+    return (int) std::min(_rows->find_time(t), _rows->size() - 1);
+}
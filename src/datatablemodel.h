@@ -0,0 +1,118 @@
+/**
+ * @file datatablemodel.h
+ * @brief Table model of the samples of one Data, formatted only when shown
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef DATATABLEMODEL_H
+#define DATATABLEMODEL_H
+
+#include <string>
+#include <algorithm>
+#include <QAbstractTableModel>
+#include "data.h"
+#include "data_timeseries.h"
+#include "data_event.h"
+
+/**
+ * @brief The samples of a Data as rows of time and value. They are read from the data
+ * only for the rows the view shows, so the table costs nothing per sample.
+ */
+class DataTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief access to the samples of one kind of data
+     */
+    class Rows {
+    public:
+        virtual ~Rows() {}
+        virtual unsigned int size(void) const = 0;
+        virtual bool get(unsigned int k, double & t, QString & value) const = 0;
+        /// @brief first row at or after t
+        virtual unsigned int find_time(double t) const = 0;
+    };
+
+    explicit DataTableModel(QObject *parent = 0);
+    ~DataTableModel();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+
+    /**
+     * @brief show this data
+     * @return false if its type is not supported; then the table is empty
+     */
+    bool setData(const Data * d);
+
+    /**
+     * @brief row of the first sample at or after time t (as in column "Time"), binary search
+     * @return -1 if there are no rows
+     */
+    int findTime(double t) const;
+
+private:
+    Rows * _rows;
+};
+
+template <typename ST>
+class DataTableTimeseriesRows : public DataTableModel::Rows {
+public:
+    explicit DataTableTimeseriesRows(const DataTimeseries<ST> * d) : _d(d) {}
+    unsigned int size(void) const { return _d->size(); }
+    bool get(unsigned int k, double & t, QString & value) const {
+        ST v;
+        if (!_d->get_data(k, t, v)) return false;
+        value = QString::number(v);
+        return true;
+    }
+    unsigned int find_time(double t) const {
+        unsigned int k;
+        return _d->get_index_before(t, k) ? k + 1 : 0;
+    }
+private:
+    const DataTimeseries<ST> * _d;
+};
+
+template <typename ET>
+class DataTableEventRows : public DataTableModel::Rows {
+public:
+    explicit DataTableEventRows(const DataEvent<ET> * d) : _d(d) {}
+    unsigned int size(void) const { return _d->size(); }
+    bool get(unsigned int k, double & t, QString & value) const {
+        if (k >= _d->size()) return false;
+        t = _d->get_time()[k];
+        value = _to_string(_d->get_elem(k));
+        return true;
+    }
+    unsigned int find_time(double t) const {
+        const std::vector<double> & vt = _d->get_time(); // sorted
+        return std::lower_bound(vt.begin(), vt.end(), t) - vt.begin();
+    }
+private:
+    static QString _to_string(const std::string & s) { return QString::fromStdString(s); }
+    static QString _to_string(bool b) { return QString::number(b ? 1 : 0); }
+    const DataEvent<ET> * _d;
+};
+
+#endif // DATATABLEMODEL_H
@@ -25,8 +25,12 @@
 #include "datatreeviewmodel.h"
 #include "treeitem.h"
 
+#define TREE_FETCH_BATCH 256 ///< rows added to a group at once, see fetchMore()
+#define TREE_COL_NAME 0
+#define TREE_COL_MEMORY 1 ///< see Data::get_memory()
+
 /*
- * Some explanation: Our model here has only one column (=0), and multiple rows.
+ * Some explanation: Our model here has two columns (name, memory), and multiple rows.
  * row numbering is alway per level and parent, e.g.;
  *
  *  node A (row 0, col 0)
@@ -45,7 +49,8 @@
  * @param parent
  * @param analyzer
  */
-DataTreeViewModel::DataTreeViewModel(QObject *parent, MavlinkScenario*analyzer) : QAbstractItemModel(parent), _sys(NULL) {
+DataTreeViewModel::DataTreeViewModel(QObject *parent, MavlinkScenario*analyzer) : QAbstractItemModel(parent), _sys(NULL),
+    _lastgroup(NULL), _lastchildren(NULL), _search_valid(false) {
     if (!analyzer) {
         valid = false;
         _analyzer = NULL;        
@@ -55,43 +60,162 @@ DataTreeViewModel::DataTreeViewModel(QObject *parent, MavlinkScenario*analyzer)
     valid = true;
 }
 
+DataTreeViewModel::~DataTreeViewModel() {}
+
+void DataTreeViewModel::_reset(void) {
+    #if QT_VERSION >= 0x050000
+        beginResetModel();
+    #endif
+    _childcache.clear();
+    _lastgroup = NULL;
+    _lastchildren = NULL;
+    _memory.clear();
+    _search.clear();
+    _search_data.clear();
+    _search_valid = false;
+    #if QT_VERSION >= 0x050000
+        endResetModel();
+    #else
+        reset(); // qt4
+    #endif
+}
+
+const DataGroup* DataTreeViewModel::_parent(const TreeItem*item) {
+    if (TreeItem::GROUP == item->itemtype) {
+        const DataGroup*g = dynamic_cast<const DataGroup*>(item);
+        return g ? g->parent : NULL;
+    }
+    const Data*d = dynamic_cast<const Data*>(item);
+    return d ? d->parent : NULL;
+}
+
+DataTreeViewModel::children_t & DataTreeViewModel::_children(const DataGroup*g) const {
+    if (g == _lastgroup && _lastchildren) return *_lastchildren; // the view asks for the same group many times in a row
+    std::map<const DataGroup*, children_t>::iterator it = _childcache.find(g);
+    if (it == _childcache.end()) {
+        children_t & c = _childcache[g];
+        c.fetched = 0;
+        const DataGroup::groupmap & groups = g ? g->groups : _sys->mav_data_groups;
+        c.items.reserve(groups.size() + (g ? g->data.size() : 0));
+        for (DataGroup::groupmap::const_iterator itg = groups.begin(); itg != groups.end(); ++itg) {
+            c.items.push_back(itg->second);
+        }
+        c.ngroups = c.items.size();
+        if (g) {
+            // data cannot be on the top level
+            for (DataGroup::datamap::const_iterator itd = g->data.begin(); itd != g->data.end(); ++itd) {
+                c.items.push_back(itd->second);
+            }
+        }
+        it = _childcache.find(g);
+    }
+    _lastgroup = g;
+    _lastchildren = &it->second; // entries of a std::map stay where they are
+    return it->second;
+}
+
+/**
+ * @brief for the binary search in children_t, which is sorted like the maps of the group
+ */
+static bool _name_less(const TreeItem*item, const std::string & name) {
+    if (TreeItem::GROUP == item->itemtype) return static_cast<const DataGroup*>(item)->groupname < name;
+    return static_cast<const Data*>(item)->get_name() < name;
+}
+
+int DataTreeViewModel::_row(const TreeItem*item) const {
+    const children_t & c = _children(_parent(item)); // groups first, then data, each sorted by name
+    std::vector<TreeItem*>::const_iterator from = c.items.begin();
+    std::vector<TreeItem*>::const_iterator to = c.items.begin() + c.ngroups;
+    std::string name;
+    if (TreeItem::GROUP == item->itemtype) {
+        name = static_cast<const DataGroup*>(item)->groupname;
+    } else {
+        name = static_cast<const Data*>(item)->get_name();
+        from = to;
+        to = c.items.end();
+    }
+    std::vector<TreeItem*>::const_iterator it = std::lower_bound(from, to, name, _name_less);
+    return (it != to && *it == item) ? (int)(it - c.items.begin()) : -1;
+}
+
 int DataTreeViewModel::rowCount(const QModelIndex &parent) const {
     /* simply returns the number of child items for the TreeItem
-     *that corresponds to a given model index, or the number of
-     *top-level items if an invalid index is specified
+     * that corresponds to a given model index, or the number of
+     * top-level items if an invalid index is specified. Only those fetched so far.
      */
     if (!_sys) return 0;
-    if (!parent.isValid()) return _sys->mav_data_groups.size();
+    if (parent.column() > 0) return 0;
+    if (!parent.isValid()) return _children(NULL).fetched;
 
     TreeItem*t = static_cast<TreeItem*>(parent.internalPointer());
     if (TreeItem::DATA == t->itemtype) return 0; // DATA has no children
+    return _children(dynamic_cast<DataGroup*>(t)).fetched;
+}
 
-    // we have a group
-    DataGroup*gparent = dynamic_cast<DataGroup*>(t);
-    unsigned int ngroups = gparent->groups.size();
-    unsigned int ndata = gparent->data.size();
-    return ndata + ngroups;
+bool DataTreeViewModel::hasChildren(const QModelIndex &parent) const {
+    if (!_sys) return false;
+    if (!parent.isValid()) return !_sys->mav_data_groups.empty();
+    TreeItem*t = static_cast<TreeItem*>(parent.internalPointer());
+    if (TreeItem::DATA == t->itemtype) return false;
+    const DataGroup*g = dynamic_cast<DataGroup*>(t);
+    return g && (!g->groups.empty() || !g->data.empty()); // without making the children
+}
+
+bool DataTreeViewModel::canFetchMore(const QModelIndex &parent) const {
+    if (!_sys) return false;
+    const DataGroup*g = NULL;
+    if (parent.isValid()) {
+        TreeItem*t = static_cast<TreeItem*>(parent.internalPointer());
+        if (TreeItem::DATA == t->itemtype) return false;
+        g = dynamic_cast<DataGroup*>(t);
+    }
+    const children_t & c = _children(g);
+    return c.fetched < c.items.size();
+}
+
+void DataTreeViewModel::fetchMore(const QModelIndex &parent) {
+    if (!_sys) return;
+    const DataGroup*g = NULL;
+    if (parent.isValid()) {
+        TreeItem*t = static_cast<TreeItem*>(parent.internalPointer());
+        if (TreeItem::DATA == t->itemtype) return;
+        g = dynamic_cast<DataGroup*>(t);
+    }
+    children_t & c = _children(g);
+    const unsigned int n = std::min((unsigned int)TREE_FETCH_BATCH, (unsigned int)c.items.size() - c.fetched);
+    if (n == 0) return;
+    beginInsertRows(parent, c.fetched, c.fetched + n - 1);
+    c.fetched += n;
+    endInsertRows();
 }
 
 int DataTreeViewModel::columnCount(const QModelIndex &/*parent*/) const {
     if (!_sys) return 0;
-#if 0
-    TreeItem * t = static_cast<TreeItem*>(parent.internalPointer());
+    return 2;
+}
+
+/**
+ * @brief total memory of a data item or group. Groups sum up everything below them,
+ * therefore it is remembered until the next reset.
+ */
+size_t DataTreeViewModel::_get_memory(const TreeItem*t) const {
+    std::map<const TreeItem*, size_t>::const_iterator it = _memory.find(t);
+    if (it != _memory.end()) return it->second;
+    memuse_t m;
     if (TreeItem::GROUP == t->itemtype) {
-        DataGroup*p = dynamic_cast<DataGroup*>(t);
-        return 1;
+        const DataGroup*g = dynamic_cast<const DataGroup*>(t);
+        if (g) g->get_memory(m);
     } else {
-        Data*p = dynamic_cast<Data*>(t);
-        return 2;
+        const Data*d = dynamic_cast<const Data*>(t);
+        if (d) d->get_memory(m);
     }
-#else
-    return 1;
-#endif
+    _memory[t] = m.total();
+    return m.total();
 }
 
 void DataTreeViewModel::set_mav_sys(const MavSystem *const sys) {
     _sys = sys;
-    layoutChanged(); ///< signal redraw
+    _reset(); ///< signal redraw
 }
 
 QVariant DataTreeViewModel::data(const QModelIndex &index, int role) const {
@@ -100,6 +224,9 @@ QVariant DataTreeViewModel::data(const QModelIndex &index, int role) const {
     if (role != Qt::DisplayRole) return QVariant();
 
     TreeItem * t = static_cast<TreeItem*>(index.internalPointer());
+    if (TREE_COL_MEMORY == index.column()) {
+        return QString::fromStdString(memuse_t::format(_get_memory(t)));
+    }
     if (TreeItem::GROUP == t->itemtype) {
         DataGroup*p = dynamic_cast<DataGroup*>(t);
         return QString().fromStdString(p->groupname);
@@ -107,9 +234,6 @@ QVariant DataTreeViewModel::data(const QModelIndex &index, int role) const {
         Data*p = dynamic_cast<Data*>(t);
         return QString().fromStdString(p->get_name());
     }
-
-    // this is a mess...columns need extra indizes.
-
 }
 
 Qt::ItemFlags DataTreeViewModel::flags(const QModelIndex &index) const {    
@@ -117,91 +241,86 @@ Qt::ItemFlags DataTreeViewModel::flags(const QModelIndex &index) const {
     return Qt::ItemIsEnabled | Qt::ItemIsSelectable;
 }
 
-QVariant DataTreeViewModel::headerData(int /*section*/, Qt::Orientation /* orientation */, int /*role*/) const {
+QVariant DataTreeViewModel::headerData(int section, Qt::Orientation /* orientation */, int role) const {
     if (!_sys) return QVariant();
+    if (role != Qt::DisplayRole) return QVariant();
+    if (TREE_COL_MEMORY == section) return QString("Memory");
     return QString("Titel");
 }
 
 QModelIndex DataTreeViewModel::index(int row, int column, const QModelIndex &parent) const {
-    if (!_sys) return QModelIndex();
+    if (!_sys || row < 0) return QModelIndex();
 
     // ignore column. all columns get their information from the same data class...therefore all columns get the same ptr.
-    // return groups
+    const DataGroup*g = NULL;
     if (parent.isValid()) {
         // i am the child of another DataGroup.
         TreeItem * t = static_cast<TreeItem*>(parent.internalPointer());
-        if (!t) return QModelIndex();
-        DataGroup*gparent = dynamic_cast<DataGroup*>(t);
-        if (!gparent) return QModelIndex();
-        if ((unsigned int)row < (gparent->groups.size())) {
-            // -- get 'row'th element in group map
-            DataGroup::groupmap::const_iterator it = gparent->groups.begin();
-            advance(it, row);
-            // -- return pointer to it
-            DataGroup*tmp = it->second;
-            return createIndex(row, column, dynamic_cast<TreeItem*>(tmp)); // internalPointer = DataGroup*
-        } else if ((unsigned int)row >= gparent->groups.size() && (unsigned int)row < (gparent->groups.size() + gparent->data.size())) {
-            // return 'row'th element in data map
-            TreeItem * t = static_cast<TreeItem*>(parent.internalPointer());
-            if (!t) return QModelIndex();
-            DataGroup*gparent = dynamic_cast<DataGroup*>(t);
-            if (!gparent) return QModelIndex();
-            unsigned int newrow = row - gparent->groups.size();
-            if (newrow >= gparent->data.size()) return QModelIndex(); // invalid...do not have that many.
-            DataGroup::datamap::const_iterator it = gparent->data.begin();
-            advance(it, newrow);
-            // -- return pointer to it
-            Data*tmp = it->second;
-            return createIndex(row, column, dynamic_cast<TreeItem*>(tmp)); // internalPointer = Data*
-        } else {
-            return QModelIndex(); // invalid...do not have that many.
-        }
-
-    } else {
-        // no parent == root node. always a group, data cannot be on that level. find the 'row'th DataGroup in selected MavSystem
-        DataGroup::groupmap const *gparent = &_sys->mav_data_groups;
-        if (!gparent) return QModelIndex();
-        if ((unsigned int)row >= gparent->size()) return QModelIndex(); // invalid...do not have that many.
-        DataGroup::groupmap::const_iterator it = gparent->begin();
-        advance(it, row);
-        // -- return pointer to it
-        DataGroup*tmp = it->second;
-        return createIndex(row, column, dynamic_cast<TreeItem*>(tmp)); // internalPointer = DataGroup*
+        if (!t || TreeItem::DATA == t->itemtype) return QModelIndex();
+        g = dynamic_cast<DataGroup*>(t);
+        if (!g) return QModelIndex();
     }
-
-    return QModelIndex();
+    // else: no parent == root node. always a group, data cannot be on that level.
+    const children_t & c = _children(g);
+    if ((unsigned int)row >= c.fetched) return QModelIndex(); // invalid...do not have that many.
+    return createIndex(row, column, c.items[row]); // internalPointer = DataGroup* or Data*
 }
 
 QModelIndex DataTreeViewModel::parent(const QModelIndex &index) const {
     if (!_sys) return QModelIndex();
     if (!index.isValid()) return QModelIndex();
 
-    // hm..if index==data, then it has a parent. but if index==data group, not necessarily.
     TreeItem*item = static_cast<TreeItem*>(index.internalPointer());                
     if (!item) return QModelIndex();
-    if (TreeItem::GROUP == item->itemtype) {
-        DataGroup*tmp = dynamic_cast<DataGroup*>(item);
-        if (!tmp) return QModelIndex();
-        if (tmp->parent) {
-            // again...find the freaking row of parent
-            DataGroup*p = tmp->parent;
-            if (!p) return QModelIndex();
-            unsigned int idx=0;
-            for (DataGroup::groupmap::const_iterator it= p->groups.begin(); it != p->groups.end(); ++it) {
-                if (it->second == tmp) {                    
-                    return createIndex(idx, 0, tmp->parent);
-                }
-                idx++;
-            }
-            return QModelIndex();
-        } else {
-            return QModelIndex(); // root..no parent
+    const DataGroup*p = _parent(item);
+    if (!p) return QModelIndex(); // root..no parent
+    const int row = _row(p);
+    if (row < 0) return QModelIndex();
+    return createIndex(row, 0, const_cast<DataGroup*>(p));
+}
+
+QModelIndex DataTreeViewModel::indexOf(TreeItem*item) {
+    if (!_sys || !item) return QModelIndex();
+
+    // from the top down to the item: each must be fetched in its parent
+    std::vector<TreeItem*> chain;
+    for (TreeItem*t = item; t; t = const_cast<DataGroup*>(_parent(t))) chain.push_back(t);
+    QModelIndex idx;
+    for (std::vector<TreeItem*>::reverse_iterator it = chain.rbegin(); it != chain.rend(); ++it) {
+        const int row = _row(*it);
+        if (row < 0) return QModelIndex();
+        while ((unsigned int)row >= _children(_parent(*it)).fetched) fetchMore(idx);
+        idx = index(row, 0, idx);
+    }
+    return idx;
+}
+
+static void _collect_data(const DataGroup::groupmap & groups, std::vector<Data*> & out) {
+    for (DataGroup::groupmap::const_iterator itg = groups.begin(); itg != groups.end(); ++itg) {
+        const DataGroup*g = itg->second;
+        if (!g) continue;
+        for (DataGroup::datamap::const_iterator itd = g->data.begin(); itd != g->data.end(); ++itd) {
+            if (itd->second) out.push_back(itd->second);
         }
-    } else {
-        Data*tmp = dynamic_cast<Data*>(item);
-        if (!tmp) return QModelIndex();
-        return createIndex(index.row(), 0, tmp->parent);
+        _collect_data(g->groups, out);
     }
+}
 
-    return QModelIndex();
+void DataTreeViewModel::search(const QString & text, std::vector<Data*> & found, unsigned int max) const {
+    found.clear();
+    if (!_sys) return;
+    if (!_search_valid) {
+        _search.clear();
+        _search_data.clear();
+        _collect_data(_sys->mav_data_groups, _search_data);
+        for (std::vector<Data*>::const_iterator it = _search_data.begin(); it != _search_data.end(); ++it) {
+            _search.add(Data::get_fullname(*it));
+        }
+        _search_valid = true;
+    }
+    std::vector<unsigned int> ids;
+    _search.find(text.toStdString(), ids, max);
+    for (std::vector<unsigned int>::const_iterator it = ids.begin(); it != ids.end(); ++it) {
+        found.push_back(_search_data[*it]);
+    }
 }
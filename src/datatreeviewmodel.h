@@ -25,15 +25,23 @@
 #define DATATREEVIEWMODEL_H
 
 #include <QAbstractItemModel>
+#include <map>
+#include <vector>
 #include "mavlinkscenario.h"
+#include "pathsearch.h"
 
 // see http://qt-project.org/doc/qt-4.8/itemviews-simpletreemodel.html
 
+/**
+ * @brief Children of a group are shown in batches as the view asks for them (canFetchMore(),
+ * fetchMore()), so opening a group with thousands of series does not make all rows at once.
+ */
 class DataTreeViewModel : public QAbstractItemModel
 {
     Q_OBJECT
 public:
     DataTreeViewModel(QObject *parent, MavlinkScenario  * analyzer);
+    ~DataTreeViewModel();
 
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
     Qt::ItemFlags flags(const QModelIndex &index) const;
@@ -42,24 +50,21 @@ public:
     QModelIndex parent(const QModelIndex &index) const;
     int rowCount(const QModelIndex &parent = QModelIndex()) const;
     int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const;
+    bool canFetchMore(const QModelIndex &parent) const;
+    void fetchMore(const QModelIndex &parent);
 
     void setScenario(MavlinkScenario  * analyzer) {        
-        #if QT_VERSION >= 0x050000
-            beginResetModel();
-        #endif
-
         _analyzer = analyzer;
         _sys = NULL; // invalidate
-
-        #if QT_VERSION >= 0x050000
-            endResetModel();
-        #else
-            reset(); // qt4
-        #endif
+        _reset();
     }
 
+    /**
+     * @brief the tree of the system may have changed
+     */
     void reload() {
-        layoutChanged();
+        _reset();
     }
 
     /**
@@ -68,15 +73,51 @@ public:
      */
     void set_mav_sys(const MavSystem*const sys);
 
+    /**
+     * @brief data whose full path contains the text, case-insensitive. The index over all
+     * paths of the system is made on the first search after the system changed.
+     * @param max at most this many
+     */
+    void search(const QString & text, std::vector<Data*> & found, unsigned int max = 1000) const;
+
+    /**
+     * @brief index of that item, fetching the rows above it as needed
+     */
+    QModelIndex indexOf(TreeItem*item);
+
     /*************************************
      *    DATA MEMBERS
      *************************************/
     bool valid;
 
 private:
+    /**
+     * @brief children of a group, groups first, then data, as in its sorted arrays. A copy,
+     * such that rows stay the same until the next reset.
+     */
+    typedef struct {
+        std::vector<TreeItem*> items;
+        unsigned int           ngroups; ///< items before are groups, after are data
+        unsigned int           fetched; ///< rows the view knows, see fetchMore()
+    } children_t;
+
+    children_t & _children(const DataGroup*g) const; ///< g=NULL: top level
+    int _row(const TreeItem*item) const;
+    size_t _get_memory(const TreeItem*t) const;
+    static const DataGroup* _parent(const TreeItem*item);
+    void _reset(void);
+
     MavlinkScenario *_analyzer;
     const MavSystem*_sys;
 
+    mutable std::map<const DataGroup*, children_t> _childcache; ///< made on first use
+    mutable const DataGroup* _lastgroup;          ///< of the last _children() call
+    mutable children_t* _lastchildren;             ///< its entry in _childcache
+    mutable std::map<const TreeItem*, size_t> _memory; ///< see _get_memory()
+    mutable PathSearch _search;
+    mutable std::vector<Data*> _search_data;       ///< by id in _search
+    mutable bool _search_valid;
+
 signals:
     
 public slots:
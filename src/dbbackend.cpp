@@ -0,0 +1,147 @@
+/**
+ * @file dbbackend.cpp
+ * @brief What differs between the databases DBConnector can work with: driver, connection
+ *        setup and the few SQL functions which are not standard.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QStringList>
+#include "dbbackend.h"
+
+#define SQLITE_BUSY_MSEC 10000 ///< how long a connection waits while another one writes
+#define SQLITE_CACHE_KB 65536  ///< page cache of each connection
+
+/**
+ * @brief a MySQL or MariaDB server, whose tables are made by install/makedb.sql
+ */
+class DBBackendMySQL : public DBBackend {
+public:
+    const char * name(void) const { return DB_BACKEND_MYSQL; }
+    QString driver(void) const { return "QMYSQL"; }
+
+    void configure(QSqlDatabase & db, const std::string & host, const std::string & dbname,
+                   const std::string & user, const std::string & password) const {
+        db.setHostName(QString::fromStdString(host));
+        db.setDatabaseName(QString::fromStdString(dbname));
+        db.setUserName(QString::fromStdString(user));
+        db.setPassword(QString::fromStdString(password));
+        db.setConnectOptions("CLIENT_COMPRESS=1");
+    }
+
+    bool setup(QSqlDatabase & /*db*/, std::string & /*errmsg*/) const { return true; }
+    bool singleWriter(void) const { return false; }
+    QString lastInsertId(void) const { return "SELECT LAST_INSERT_ID();"; }
+    QString floor(const QString & expr) const { return "FLOOR(" + expr + ")"; }
+    QString clamp(const QString & expr, const QString & lo, const QString & hi) const {
+        return "LEAST(GREATEST(" + expr + ", " + lo + "), " + hi + ")";
+    }
+    QString stddevPop(const QString & expr) const { return "STDDEV_POP(" + expr + ")"; }
+};
+
+/**
+ * @brief tables of install/makedb.sql, in the dialect of SQLite. Samples go to dataChunks.
+ */
+static const char * const SQLITE_SCHEMA[] = {
+    "CREATE TABLE IF NOT EXISTS scenarios (ID INTEGER PRIMARY KEY AUTOINCREMENT, TIME_START DATETIME, DESCRIPTION TEXT, FILENAME TEXT);",
+    "CREATE TABLE IF NOT EXISTS scenarioFingerprints (SCENARIO_ID INTEGER, FINGERPRINT TEXT);",
+    "CREATE INDEX IF NOT EXISTS scenarioFingerprints_scenario ON scenarioFingerprints (SCENARIO_ID);",
+    "CREATE INDEX IF NOT EXISTS scenarioFingerprints_fingerprint ON scenarioFingerprints (FINGERPRINT);",
+    "CREATE TABLE IF NOT EXISTS systems (ID INTEGER PRIMARY KEY AUTOINCREMENT, SCENARIO_ID INTEGER, SYSTEM_ID INTEGER, "
+        "MAVTYPE INTEGER, MAVTYPE_STRING TEXT, APTYPE INTEGER, APTYPE_STRING TEXT, ARMED INTEGER, TIME DOUBLE, TIME_VALID INTEGER, "
+        "TIME_MIN DOUBLE, TIME_MAX DOUBLE, TIME_OFFSET_USEC INTEGER, TIME_OFFSET_GUESS_USEC INTEGER);",
+    "CREATE INDEX IF NOT EXISTS systems_scenario ON systems (SCENARIO_ID);",
+    "CREATE TABLE IF NOT EXISTS dataGroups (ID INTEGER PRIMARY KEY AUTOINCREMENT, SYSTEM_ID INTEGER, VALID INTEGER, NAME TEXT, "
+        "FULLPATH TEXT, CLASSIFIER INTEGER, TIME_EPOCH_DATASTART INTEGER, UNITS TEXT, TYPE TEXT);",
+    "CREATE INDEX IF NOT EXISTS dataGroups_system ON dataGroups (SYSTEM_ID);",
+    "CREATE INDEX IF NOT EXISTS dataGroups_path ON dataGroups (FULLPATH);",
+    "CREATE TABLE IF NOT EXISTS data (ID INTEGER PRIMARY KEY AUTOINCREMENT, DATAGROUP_ID INTEGER, TIME DOUBLE, VALUE DOUBLE);",
+    "CREATE INDEX IF NOT EXISTS data_group_time ON data (DATAGROUP_ID, TIME);",
+    "CREATE TABLE IF NOT EXISTS dataChunks (ID INTEGER PRIMARY KEY AUTOINCREMENT, DATAGROUP_ID INTEGER, SEQ INTEGER, N INTEGER, "
+        "TIME_MIN DOUBLE, TIME_MAX DOUBLE, VALUE_MIN DOUBLE, VALUE_MAX DOUBLE, TIMES BLOB, VALS BLOB);",
+    "CREATE INDEX IF NOT EXISTS dataChunks_group_seq ON dataChunks (DATAGROUP_ID, SEQ);",
+    "CREATE TABLE IF NOT EXISTS dataOverview (DATAGROUP_ID INTEGER PRIMARY KEY, N INTEGER, TIMES BLOB, VALS BLOB);",
+    "CREATE TABLE IF NOT EXISTS dataGroupStats (DATAGROUP_ID INTEGER PRIMARY KEY, N INTEGER, VALUE_MIN DOUBLE, VALUE_MAX DOUBLE, "
+        "VALUE_AVG DOUBLE, VALUE_STDDEV DOUBLE, TIME_MIN DOUBLE, TIME_MAX DOUBLE, RATE DOUBLE);",
+    "CREATE TABLE IF NOT EXISTS dataGroupHashes (DATAGROUP_ID INTEGER PRIMARY KEY, N INTEGER, HASH TEXT);",
+    "CREATE TABLE IF NOT EXISTS events (ID INTEGER PRIMARY KEY AUTOINCREMENT, EVENT TEXT);",
+    "CREATE TABLE IF NOT EXISTS presetsName (ID INTEGER PRIMARY KEY AUTOINCREMENT, PRESET_NAME TEXT);",
+    "CREATE TABLE IF NOT EXISTS presetsData (ID INTEGER PRIMARY KEY AUTOINCREMENT, PRESET_ID INTEGER, filterValues TEXT, "
+        "filterOperator TEXT, filterData TEXT, filterTime TEXT);",
+    NULL
+};
+
+/**
+ * @brief a local file, e.g., an archive on a laptop without access to the server. It is
+ * made when first opened. The journal is written ahead (WAL), so that the GUI can read while
+ * a scenario is being saved, and a scenario is saved in one transaction.
+ */
+class DBBackendSQLite : public DBBackend {
+public:
+    const char * name(void) const { return DB_BACKEND_SQLITE; }
+    QString driver(void) const { return "QSQLITE"; }
+
+    void configure(QSqlDatabase & db, const std::string & /*host*/, const std::string & dbname,
+                   const std::string & /*user*/, const std::string & /*password*/) const {
+        db.setDatabaseName(QString::fromStdString(dbname));
+        db.setConnectOptions(QString("QSQLITE_BUSY_TIMEOUT=%1").arg(SQLITE_BUSY_MSEC));
+    }
+
+    bool setup(QSqlDatabase & db, std::string & errmsg) const {
+        QStringList stmts;
+        stmts << "PRAGMA journal_mode=WAL;"
+              << "PRAGMA synchronous=NORMAL;" // with WAL, a crash loses at most the last transaction
+              << "PRAGMA temp_store=MEMORY;"
+              << QString("PRAGMA cache_size=-%1;").arg(SQLITE_CACHE_KB);
+        if (!db.tables().contains("scenarios", Qt::CaseInsensitive)) {
+            for (unsigned int k = 0; SQLITE_SCHEMA[k]; ++k) stmts << SQLITE_SCHEMA[k];
+        }
+        QSqlQuery qry(db);
+        for (QStringList::const_iterator it = stmts.begin(); it != stmts.end(); ++it) {
+            if (!qry.exec(*it)) {
+                errmsg = "Cannot set up " + db.databaseName().toStdString() + ": " + qry.lastError().text().toStdString();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool singleWriter(void) const { return true; }
+    QString lastInsertId(void) const { return "SELECT last_insert_rowid();"; }
+
+    /**
+     * SQLite is often built without math functions. Truncating is the floor for non-negative
+     * values; callers clamp the others.
+     */
+    QString floor(const QString & expr) const { return "CAST((" + expr + ") AS INTEGER)"; }
+    QString clamp(const QString & expr, const QString & lo, const QString & hi) const {
+        return "MIN(MAX(" + expr + ", " + lo + "), " + hi + ")";
+    }
+    QString stddevPop(const QString & /*expr*/) const { return "NULL"; }
+};
+
+static const DBBackendMySQL g_mysql;
+static const DBBackendSQLite g_sqlite;
+
+const DBBackend * DBBackend::get(const std::string & name) {
+    if (name == DB_BACKEND_SQLITE) return &g_sqlite;
+    return &g_mysql;
+}
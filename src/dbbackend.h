@@ -0,0 +1,92 @@
+/**
+ * @file dbbackend.h
+ * @brief What differs between the databases DBConnector can work with: driver, connection
+ *        setup and the few SQL functions which are not standard.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef DBBACKEND_H
+#define DBBACKEND_H
+
+#include <string>
+#include <QString>
+#include <QSqlDatabase>
+
+#define DB_BACKEND_MYSQL  "mysql"  ///< a MySQL/MariaDB server, see install/makedb.sql
+#define DB_BACKEND_SQLITE "sqlite" ///< a local file, made with the same tables when first opened
+
+/**
+ * @brief One instance per kind of database, see get(). No state, so it can be shared by
+ * all threads.
+ */
+class DBBackend {
+public:
+    virtual ~DBBackend() {}
+
+    /**
+     * @brief the backend of that name, see DB_BACKEND_MYSQL etc. Unknown names give MySQL,
+     * which was the only one before.
+     */
+    static const DBBackend * get(const std::string & name);
+
+    virtual const char * name(void) const = 0;
+
+    /**
+     * @brief name of the Qt SQL driver
+     */
+    virtual QString driver(void) const = 0;
+
+    /**
+     * @brief set login data and options of a connection, before it is opened
+     * @param dbname name of the DB on the server, or the file
+     */
+    virtual void configure(QSqlDatabase & db, const std::string & host, const std::string & dbname,
+                           const std::string & user, const std::string & password) const = 0;
+
+    /**
+     * @brief after the connection was opened, e.g., to make the tables
+     * @return false if the DB cannot be used
+     */
+    virtual bool setup(QSqlDatabase & db, std::string & errmsg) const = 0;
+
+    /**
+     * @brief if true, only one connection can write at a time. Then a scenario is saved over
+     * one connection, in one transaction.
+     */
+    virtual bool singleWriter(void) const = 0;
+
+    /**
+     * @brief SQL which gives the ID of the row inserted last over this connection
+     */
+    virtual QString lastInsertId(void) const = 0;
+
+    /**
+     * @brief SQL for floor(expr), at least where expr is not negative, and for expr limited to [lo, hi]
+     */
+    virtual QString floor(const QString & expr) const = 0;
+    virtual QString clamp(const QString & expr, const QString & lo, const QString & hi) const = 0;
+
+    /**
+     * @brief SQL for the population standard deviation of expr in a group. NULL if there is none.
+     */
+    virtual QString stddevPop(const QString & expr) const = 0;
+};
+
+#endif // DBBACKEND_H
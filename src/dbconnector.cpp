@@ -8,26 +8,206 @@
 #include <vector>
 #include <iostream>
 #include <inttypes.h>
+#include <math.h>
+#include <cstring>
+#include <algorithm>
 #include <QMessageBox>
+#include <QRunnable>
+#include <QAtomicInt>
+#include <QStringList>
+#include <QThread>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QCryptographicHash>
 #include "dbconnector.h"
 #include "time_fun.h"
+#include "vec_fun.h"
+#include "profiler.h"
+#include "taskpool.h"
 
 using namespace std;
 
-DBConnector::DBConnector(const db_props_t & args) : _args(args), _deferredLoad(true)
+#define DB_CHUNK_SAMPLES 65536 ///< samples per row in table dataChunks
+#define DB_OVERVIEW_POINTS 2048 ///< points per group in table dataOverview, min and max of half as many buckets
+#define DB_SAVE_THREADS 4 ///< connections for saving, by default
+#define DB_AGGREGATE_BATCH 1000 ///< data groups per query when aggregating those without statistics
+#define DB_DELETE_BATCH 500 ///< data groups per DELETE when updating a scenario
+#define DB_POOL_IDLE_SEC 600. ///< pooled connections idle for longer are made anew, before the server drops them
+
+/**
+ * @brief the pooled connection of one thread, which stays open between DBConnectors
+ */
+typedef struct {
+    QString                     name;       ///< of the Qt connection
+    std::string                 props;      ///< login data it was made with
+    double                      last_used;  ///< see get_time_secs()
+    std::map<QString,QSqlQuery> statements; ///< prepared ones, by SQL text
+    QStringList                 tables;     ///< remembered result of QSqlDatabase::tables()
+} pooled_connection_t;
+
+static QMutex g_pool_mutex;
+static QAtomicInt g_pool_ids;
+// never freed: the statements must not be destroyed after the SQL drivers at exit
+static std::map<QThread*,pooled_connection_t> * g_pool = NULL;
+
+/**
+ * @brief what we know of table events of one DB. Rows are only ever added there,
+ * which is why it can be synced incrementally.
+ */
+typedef struct {
+    DBConnector::event_ids_t    ids;
+    DBConnector::event_names_t  names;
+    double                      maxid; ///< highest ID seen, <0 if none
+} event_cache_t;
+
+static QMutex g_events_mutex;
+static std::map<std::string,event_cache_t> * g_events = NULL; ///< by host and DB name
+
+/**
+ * @brief the pool entry of the calling thread, if db is its connection
+ */
+static pooled_connection_t * _poolEntry(const QSqlDatabase & db) {
+    QMutexLocker lock(&g_pool_mutex);
+    if (!g_pool) return NULL;
+    std::map<QThread*,pooled_connection_t>::iterator it = g_pool->find(QThread::currentThread());
+    if (it == g_pool->end() || it->second.name != db.connectionName()) return NULL;
+    return &(it->second); // only used by this thread, and entries stay where they are
+}
+
+/**
+ * @brief saves data groups with its own connection. Qt wants each connection to be used
+ * only by the thread which made it, therefore it is made in run(). Several of these
+ * take jobs from the same list until it is empty.
+ */
+class DBSaveWorker : public QRunnable {
+public:
+    DBSaveWorker(DBConnector*con, const DBConnector::db_props_t & props, std::vector<DBConnector::save_job_t> & jobs,
+                 QAtomicInt & next, QAtomicInt & done, QAtomicInt & errors) :
+        _con(con), _props(props), _jobs(jobs), _next(next), _done(done), _errors(errors) {}
+
+    void run() {
+        static QAtomicInt ids;
+        const QString name = QString("mavloganalyzer_save_%1").arg(ids.fetchAndAddOrdered(1));
+        {
+            const DBBackend*const backend = DBBackend::get(_props.backend);
+            QSqlDatabase db = QSqlDatabase::addDatabase(backend->driver(), name);
+            backend->configure(db, _props.dbhost, _props.dbname, _props.username, _props.password);
+            if (!db.open()) {
+                // the others take over the jobs
+                std::cerr << "Could not open DB connection " << name.toStdString() << ": " << db.lastError().text().toStdString() << std::endl;
+            } else {
+                for (;;) {
+                    const int k = _next.fetchAndAddOrdered(1);
+                    if (k >= (int)_jobs.size()) break;
+                    if (_con->_saveJob2DB(db, _jobs[k]) < 0) _errors.ref();
+                    _done.ref();
+                }
+                db.close();
+            }
+        }
+        QSqlDatabase::removeDatabase(name);
+    }
+
+private:
+    DBConnector*                         _con;
+    const DBConnector::db_props_t        _props;
+    std::vector<DBConnector::save_job_t>&_jobs;
+    QAtomicInt&                          _next;
+    QAtomicInt&                          _done;
+    QAtomicInt&                          _errors;
+};
+
+DBConnector::DBConnector(const db_props_t & args, const std::string & connection) : _args(args), _connection(connection),
+    _backend(DBBackend::get(args.backend)), _deferredLoad(true), _useChunks(false), _useStats(false), _useOverview(false), _useHashes(false),
+    _bulk(false), _saveThreads(DB_SAVE_THREADS)
 {
-    _db = QSqlDatabase::addDatabase( "QMYSQL" );
+    if (!_connection.empty()) {
+        _db = QSqlDatabase::addDatabase( _backend->driver(), QString::fromStdString(_connection) );
+    }
     //std::cout << "Verfügbare Treiber: " << QSqlDatabase::drivers().join(" ").toStdString() << std::endl;
 
     setDBProperties(args);
 }
 
+DBConnector::~DBConnector() {
+    if (_connection.empty()) return;
+    _db = QSqlDatabase(); // no more users, otherwise Qt complains
+    QSqlDatabase::removeDatabase(QString::fromStdString(_connection));
+}
+
 void DBConnector::setDBProperties(const db_props_t & props) {
-    _db.setHostName( QString::fromStdString(props.dbhost) );
-    _db.setDatabaseName( QString::fromStdString(props.dbname) );
+    if (_connection.empty()) {
+        _backend = DBBackend::get(props.backend);
+        _db = _pooledConnection(props);
+        return;
+    }
+    // the driver of a named connection stays
+    _backend->configure(_db, props.dbhost, props.dbname, props.username, props.password);
+}
+
+/**
+ * @brief the connection of the calling thread. It is made anew if the login data changed,
+ * or after a long pause; then its statements are prepared again, too.
+ */
+QSqlDatabase DBConnector::_pooledConnection(const db_props_t & props) {
+    pooled_connection_t * pc;
+    {
+        QMutexLocker lock(&g_pool_mutex);
+        if (!g_pool) g_pool = new std::map<QThread*,pooled_connection_t>();
+        pc = &(*g_pool)[QThread::currentThread()];
+    }
+
+    const DBBackend*const backend = DBBackend::get(props.backend);
+    QSqlDatabase db;
+    if (!pc->name.isEmpty()) {
+        db = QSqlDatabase::database(pc->name, false);
+        if (!db.isValid() || db.driverName() != backend->driver()) {
+            // made by an earlier thread, which had the same address, or for another backend
+            pc->statements.clear();
+            pc->tables.clear();
+            db = QSqlDatabase();
+            QSqlDatabase::removeDatabase(pc->name);
+            pc->name.clear();
+        }
+    }
+    if (pc->name.isEmpty()) {
+        pc->name = QString("mavloganalyzer_pool_%1").arg(g_pool_ids.fetchAndAddOrdered(1));
+        db = QSqlDatabase::addDatabase(backend->driver(), pc->name);
+        pc->props.clear();
+    }
+
+    const std::string key = std::string(backend->name()) + "\n" + props.dbhost + "\n" + props.dbname + "\n" +
+                            props.username + "\n" + props.password;
+    const double now = get_time_secs();
+    if (pc->props != key || now - pc->last_used > DB_POOL_IDLE_SEC) {
+        pc->statements.clear();
+        pc->tables.clear();
+        db.close();
+        backend->configure(db, props.dbhost, props.dbname, props.username, props.password);
+        pc->props = key;
+    }
+    pc->last_used = now;
+    return db;
+}
+
+QSqlQuery DBConnector::prepared(const QSqlDatabase & db, const QString & sql) {
+    pooled_connection_t*const pc = _poolEntry(db);
+    if (pc) {
+        std::map<QString,QSqlQuery>::const_iterator it = pc->statements.find(sql);
+        if (it != pc->statements.end()) return it->second;
+    }
+    QSqlQuery qry(db);
+    qry.setForwardOnly(true);
+    if (!qry.prepare(sql)) return qry; // exec() fails and tells why
+    if (pc) pc->statements.insert(std::make_pair(sql, qry));
+    return qry;
+}
 
-    _db.setUserName( QString::fromStdString(props.username) );
-    _db.setPassword( QString::fromStdString(props.password) );
+bool DBConnector::hasTable(const QSqlDatabase & db, const QString & table) {
+    pooled_connection_t*const pc = _poolEntry(db);
+    if (!pc) return db.tables().contains(table, Qt::CaseInsensitive);
+    if (pc->tables.empty()) pc->tables = db.tables();
+    return pc->tables.contains(table, Qt::CaseInsensitive);
 }
 
 DBConnector::db_props_t DBConnector::getDBProperties(void) const {
@@ -37,18 +217,19 @@ DBConnector::db_props_t DBConnector::getDBProperties(void) const {
     ret.dbname = _db.databaseName().toStdString();
     ret.username = _db.userName().toStdString();
     ret.password = _db.password().toStdString();
+    ret.backend = _backend->name();
 
     return ret;
 }
 
 bool DBConnector::selfTest(std::string & errmsg) {
     // FIXME: verify table structure
-    struct dbBinder dbBind(&_db);
+    struct dbBinder dbBind(&_db, _connection.empty(), _backend);
     if( dbBind.error ) {
         errmsg = dbBind.errmsg;
         return false;
     }
-    QSqlQuery qry;
+    QSqlQuery qry(_db);
     QString strQuery = "SELECT * FROM scenarios LIMIT 1;";
     qry.prepare( strQuery );
     if( !qry.exec()) {
@@ -60,16 +241,36 @@ bool DBConnector::selfTest(std::string & errmsg) {
     return true;
 }
 
-bool DBConnector::saveScenarioToDB(const MavlinkScenario*const scen, DialogProgressBar*dlg) {
+bool DBConnector::saveScenarioToDB(const MavlinkScenario*const scen, DialogProgressBar*dlg, similar_e similar) {
     if (!scen) return false;
+    ProfileScope prof("db save");
 
-    struct dbBinder dbBind(&_db);
+    struct dbBinder dbBind(&_db, _connection.empty(), _backend);
     if( dbBind.error ) {
         return false;
     }
 
     double runtime = get_time_secs();
-    save_res_e ret = _saveScenario2DB(*scen, dlg);
+    save_res_e ret;
+    if (_backend->singleWriter()) {
+        // one connection and one transaction for all of it, which is much faster there
+        const unsigned int threads = _saveThreads;
+        _saveThreads = 1;
+        _bulk = _db.transaction();
+        ret = _saveScenario2DB(*scen, dlg, similar);
+        if (_bulk) {
+            if (ret == SAVE_ERROR) {
+                _db.rollback();
+            } else if (!_db.commit()) {
+                std::cerr << "Cannot commit scenario: " << _db.lastError().text().toStdString() << std::endl;
+                ret = SAVE_ERROR;
+            }
+        }
+        _bulk = false;
+        _saveThreads = threads;
+    } else {
+        ret = _saveScenario2DB(*scen, dlg, similar);
+    }
     runtime = get_time_secs() - runtime;
     std::cout << "FINISH SAVING TO DB. Time = " << runtime << "s" << flush;
     switch (ret) {
@@ -124,7 +325,123 @@ int DBConnector::_getScenarioFromFile(const std::string /*fileName*/, MavlinkSce
  * @param fileName just nice to know
  * @return see enum definitions
  */
-DBConnector::save_res_e DBConnector::_saveScenario2DB(const MavlinkScenario &scenario, DialogProgressBar*dlg) {
+/**
+ * @brief look for a scenario in the DB with the same start time, or made from the same log files
+ * @param name filename of the first one found
+ * @param id its ID
+ * @param n number of such scenarios
+ * @return <0 on error<br>0 if there is none<br>1 if there is one<br>2 if one was made from the same files
+ */
+int DBConnector::_findSimilarScenario(const MavlinkScenario &scenario, QString & name, unsigned long long & id, unsigned long & n) {
+    const int identical = _findIdenticalScenario(scenario, name, id);
+    if (identical < 0) return -1;
+    if (identical > 0) {
+        n = 1;
+        return 2;
+    }
+    std::string tstart = epoch_to_datetime(scenario.get_scenario_starttime_sec(), true);
+    QSqlQuery qry = prepared(_db, "SELECT * FROM scenarios WHERE TIME_START=:starttime;");
+    qry.bindValue(":starttime", QString::fromStdString(tstart));
+    if( !qry.exec() ) {
+        std::cerr << "Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
+        return -1;
+    }
+    n = 0; // not every driver knows the size up front
+    while (qry.next()) {
+        if (n++ > 0) continue;
+        id = qry.value(qry.record().indexOf("ID")).toULongLong();
+        name = qry.value(qry.record().indexOf("FILENAME")).toString();
+    }
+    return (n > 0) ? 1 : 0;
+}
+
+/**
+ * @brief look for a scenario in the DB made from exactly the same log files, by their fingerprints
+ * @param name its filename
+ * @param id its ID
+ * @return <0 on error<br>0 if there is none, or the DB has no table scenarioFingerprints<br>1 if there is one
+ */
+int DBConnector::_findIdenticalScenario(const MavlinkScenario &scenario, QString & name, unsigned long long & id) {
+    const std::set<std::string> & fingerprints = scenario.get_fingerprints();
+    if (fingerprints.empty() || !_hasFingerprintTable()) return 0;
+
+    // scenarios having all of ours
+    std::map<unsigned long long, unsigned int> hits;
+    QSqlQuery qry = prepared(_db, "SELECT SCENARIO_ID FROM scenarioFingerprints WHERE FINGERPRINT=:fp;");
+    for (std::set<std::string>::const_iterator it = fingerprints.begin(); it != fingerprints.end(); ++it) {
+        qry.bindValue(":fp", QString::fromStdString(*it));
+        if (!qry.exec()) {
+            std::cerr << "Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
+            return -1;
+        }
+        while (qry.next()) hits[qry.value(0).toULongLong()]++;
+    }
+    // ...and no others
+    QSqlQuery qcount = prepared(_db, "SELECT COUNT(*) FROM scenarioFingerprints WHERE SCENARIO_ID=:id;");
+    for (std::map<unsigned long long, unsigned int>::const_iterator it = hits.begin(); it != hits.end(); ++it) {
+        if (it->second != fingerprints.size()) continue;
+        qcount.bindValue(":id", (qulonglong)it->first);
+        if (!qcount.exec() || !qcount.next()) {
+            std::cerr << "Error occured during execution of Query: "<<qcount.lastError().text().toStdString() << std::endl;
+            return -1;
+        }
+        if (qcount.value(0).toUInt() != fingerprints.size()) continue;
+
+        id = it->first;
+        QSqlQuery qname = prepared(_db, "SELECT FILENAME FROM scenarios WHERE ID=:id;");
+        qname.bindValue(":id", (qulonglong)id);
+        if (!qname.exec()) {
+            std::cerr << "Error occured during execution of Query: "<<qname.lastError().text().toStdString() << std::endl;
+            return -1;
+        }
+        if (!qname.next()) continue; // left over from a scenario deleted by hand
+        name = qname.value(0).toString();
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief replace the fingerprints of the scenario in the DB with the ones it has now
+ * @return 0 on success, or if the DB has no table scenarioFingerprints, else error code
+ */
+int DBConnector::_saveFingerprints2DB(const MavlinkScenario &scenario, unsigned long long scenarioID) {
+    if (!_hasFingerprintTable()) return 0;
+    QSqlQuery qry(_db);
+    qry.prepare("DELETE FROM scenarioFingerprints WHERE SCENARIO_ID=:id;");
+    qry.bindValue(":id", (qulonglong)scenarioID);
+    if (!qry.exec()) {
+        std::cerr << "_saveFingerprints2DB: Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
+        return -1;
+    }
+    const std::set<std::string> & fingerprints = scenario.get_fingerprints();
+    qry.prepare("INSERT INTO scenarioFingerprints (SCENARIO_ID, FINGERPRINT) VALUES (:id, :fp);");
+    for (std::set<std::string>::const_iterator it = fingerprints.begin(); it != fingerprints.end(); ++it) {
+        qry.bindValue(":id", (qulonglong)scenarioID);
+        qry.bindValue(":fp", QString::fromStdString(*it));
+        if (!qry.exec()) {
+            std::cerr << "_saveFingerprints2DB: Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
+            return -2;
+        }
+    }
+    return 0;
+}
+
+int DBConnector::findSimilarScenario(const MavlinkScenario*const scen, std::string & name) {
+    if (!scen) return -1;
+    struct dbBinder dbBind(&_db, _connection.empty(), _backend);
+    if( dbBind.error ) {
+        return -1;
+    }
+    QString strsimilar;
+    unsigned long long id;
+    unsigned long n;
+    const int ret = _findSimilarScenario(*scen, strsimilar, id, n);
+    name = strsimilar.toStdString();
+    return ret;
+}
+
+DBConnector::save_res_e DBConnector::_saveScenario2DB(const MavlinkScenario &scenario, DialogProgressBar*dlg, similar_e similar) {
 
 
     // reject empty scenarios.
@@ -134,45 +451,41 @@ DBConnector::save_res_e DBConnector::_saveScenario2DB(const MavlinkScenario &sce
     }
 
     // make sure the scenario isn't already in DB. Full compare would be nuts, so we use a heuristic: if the starttime is already there, reject.
-    std::string tstart = epoch_to_datetime(scenario.get_scenario_starttime_sec(), true);
-    bool exists = false;
     QString strsimilar;
     unsigned long long existsID;
     unsigned long n_similar = 0;
-    {
-
-        QSqlQuery qry;
-        qry.prepare( "SELECT * FROM scenarios WHERE TIME_START=:starttime;" );
-        qry.bindValue(":starttime", QString::fromStdString(tstart));
-
-
-        if( qry.exec() ) {
-            n_similar = qry.size();
-            if (qry.next()) {
-                exists = true;
-                existsID = qry.value(qry.record().indexOf("ID")).toULongLong();
-                strsimilar = qry.value(qry.record().indexOf("FILENAME")).toString();
-            }
-        } else {
-            std::cerr << "Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
+    const int exists = _findSimilarScenario(scenario, strsimilar, existsID, n_similar);
+    if (exists < 0) return SAVE_ERROR;
+    if (exists == 2) {
+        // the same log files twice would only take space: update that one, or nothing
+        if (similar == SIMILAR_INSERT) {
+            std::cerr << "ERROR: DB already has a scenario made from the same log files with ID=" << existsID << ". Not saving it twice." << endl;
             return SAVE_ERROR;
         }
+        if (similar == SIMILAR_ASK) {
+            QMessageBox msg (QMessageBox::Question, "Scenario already saved", QString("The log files of this scenario are already in the database as '") + strsimilar + QString("'. Do you want to update that scenario with the current one?"), QMessageBox::Yes|QMessageBox::Cancel);
+            msg.setButtonText(QMessageBox::Yes, "Overwrite/update existing scenario");
+            if (QMessageBox::Yes != msg.exec()) return SAVE_ERROR;
+            similar = SIMILAR_UPDATE;
+        }
     }
-    if (exists) {
-        // ask what to do, because a similar scenario seems to exist.
-
-
-        QMessageBox msg (QMessageBox::Question, "Similar Scenario found", QString("A similar scenario with the name '") + strsimilar + QString("' is already in the database. Do you want to update that scenario with the current one (no), or insert the current one anyway (yes)?"), QMessageBox::Yes|QMessageBox::No);
-        msg.setButtonText(QMessageBox::Yes, "Create a new scenario");
-        msg.setButtonText(QMessageBox::No, "Overwrite/update existing scenario");
-
-        const bool updateExisting = QMessageBox::No == msg.exec();
+    if (exists > 0) {
+        bool updateExisting = (similar == SIMILAR_UPDATE);
+        if (similar == SIMILAR_ASK) {
+            // ask what to do, because a similar scenario seems to exist.
+            QMessageBox msg (QMessageBox::Question, "Similar Scenario found", QString("A similar scenario with the name '") + strsimilar + QString("' is already in the database. Do you want to update that scenario with the current one (no), or insert the current one anyway (yes)?"), QMessageBox::Yes|QMessageBox::No);
+            msg.setButtonText(QMessageBox::Yes, "Create a new scenario");
+            msg.setButtonText(QMessageBox::No, "Overwrite/update existing scenario");
+            updateExisting = QMessageBox::No == msg.exec();
+        }
         if (updateExisting) {
             if (n_similar == 1) {
 
-                // we update only the scenario description for now. FIXME: one sunny day, also merge in new data...
-                std::cout << "INFO: DB already has such a scenario with ID=" << existsID << ", starttime=" << tstart << ". Updating ..."<< endl;
+                // description, and the data groups which changed
+                std::cout << "INFO: DB already has such a scenario with ID=" << existsID << ", starttime=" << epoch_to_datetime(scenario.get_scenario_starttime_sec(), true) << ". Updating ..."<< endl;
                 int ret = _updateScenarioInDB(scenario, existsID);
+                if (!ret) ret = _updateScenarioData(scenario, existsID, dlg);
+                if (!ret) ret = _saveFingerprints2DB(scenario, existsID);
                 if (ret) {
                     std::cerr << "ERROR: Updating scenario with ID=" << existsID << ". Ret = " << ret << endl;
                     return SAVE_ERROR;
@@ -188,6 +501,10 @@ DBConnector::save_res_e DBConnector::_saveScenario2DB(const MavlinkScenario &sce
         }
     }
     std::cout << "Scenario will be imported, not a duplicate." << endl;
+    _useChunks = _hasChunkTable();
+    _useStats = _hasStatsTable();
+    _useOverview = _hasOverviewTable();
+    _useHashes = _hasHashTable();
 
     // create a new scenario entry in the DB
     unsigned long long scenarioID = _insertScenarioToDB(scenario);
@@ -195,11 +512,18 @@ DBConnector::save_res_e DBConnector::_saveScenario2DB(const MavlinkScenario &sce
         std::cerr << "Error occured during saving of MavlinkScenario: "<< scenarioID << std::endl;
         return SAVE_ERROR;
     } else {
-        std::map<std::string,double> events;
-        std::map<std::string,double> newEvents;
+        event_ids_t events;
+        event_ids_t newEvents;
         double maxEventID;
         int success;
 
+        success = _saveFingerprints2DB(scenario, scenarioID);
+        if(success < 0) {
+            std::cerr << "Error occured during saving of the fingerprints: "<< success << std::endl;
+            _deleteScenarioFromDB(scenarioID);
+            return SAVE_ERROR;
+        }
+
         success = _getEventsFromDB(events,maxEventID);
         if(success < 0) {
             std::cerr << "Error occured during select of Events from DB: "<< success << std::endl;
@@ -215,9 +539,13 @@ DBConnector::save_res_e DBConnector::_saveScenario2DB(const MavlinkScenario &sce
                 std::stringstream ss;
                 ss << "Save System " << cnt << " of " << TOTAL;
                 dlg->setLabel(QString().fromStdString(ss.str()));
-                dlg->repaint();
             }
             success = DBConnector::_saveSystem2DB(*it->second, scenarioID,events, newEvents,maxEventID, dlg);
+            if (_canceled(dlg)) {
+                std::cerr << "Saving canceled, removing incomplete scenario " << scenarioID << " from DB" << std::endl;
+                _deleteScenarioFromDB(scenarioID);
+                return SAVE_ERROR;
+            }
             if(success < 0) {
                 std::cerr << "Error occured during saving of MavlinkSystem: "<< success << std::endl;
                 return SAVE_ERROR;
@@ -229,6 +557,7 @@ DBConnector::save_res_e DBConnector::_saveScenario2DB(const MavlinkScenario &sce
             std::cerr << "Error occured during saving of Events to DB: "<< success << std::endl;
             return SAVE_ERROR;
         }
+        _addEventsToCache(newEvents);
 
     }
 
@@ -244,7 +573,7 @@ DBConnector::save_res_e DBConnector::_saveScenario2DB(const MavlinkScenario &sce
  * @param maxEventID +1 is the next free eventId
  * @return 0 on success<br><0 on error
  */
-int DBConnector::_saveSystem2DB(const MavSystem &sys, const int scenarioID, std::map<std::string,double> &events, std::map<std::string,double> &newEvents, double &maxEventID, DialogProgressBar*dlg)
+int DBConnector::_saveSystem2DB(const MavSystem &sys, const int scenarioID, event_ids_t &events, event_ids_t &newEvents, double &maxEventID, DialogProgressBar*dlg)
 {
     int systemID = _insertSystemToDB(sys, scenarioID);
     int success = 0;
@@ -255,10 +584,16 @@ int DBConnector::_saveSystem2DB(const MavSystem &sys, const int scenarioID, std:
     }
 
     // this version works flat on the data
-    const unsigned int TOTAL = sys._data_from_path.size();
+    const unsigned int TOTAL = sys._paths.count_data();
+    if (_saveThreads > 1 && TOTAL > 1) {
+        return _saveDataParallel2DB(sys, systemID, events, newEvents, maxEventID, dlg);
+    }
     unsigned int cnt=0;
     unsigned int progress = 0, progress_pre = 0;
-    for (MavSystem::data_accessmap::const_iterator it = sys._data_from_path.begin(); it != sys._data_from_path.end(); ++it) {
+    for (unsigned int id = 0; id < sys._paths.size(); ++id) {
+        const Data*const d = sys._paths.node(id).data;
+        if (!d) continue;
+        if (_canceled(dlg)) return -3;
         // -- progress
         if (dlg) {
             dlg->setValue(cnt, TOTAL);
@@ -271,7 +606,7 @@ int DBConnector::_saveSystem2DB(const MavSystem &sys, const int scenarioID, std:
         }
         cnt++;
         // -- end progress
-        success = _saveData2DB(*it->second, systemID, events, newEvents, maxEventID);
+        success = _saveData2DB(*d, systemID, events, newEvents, maxEventID);
         if(success < 0) {
             std::cerr << "Error occured during saving of DataGroup: " << success << std::endl;
             ret = -2;
@@ -280,6 +615,99 @@ int DBConnector::_saveSystem2DB(const MavSystem &sys, const int scenarioID, std:
     return ret;
 }
 
+/**
+ * @brief same as the loop in _saveSystem2DB(), but the samples are inserted by _saveThreads
+ * connections at once. The group rows are inserted first, which reserves their IDs, and string
+ * events are converted first, because they extend the event map. Each group has its own
+ * transaction, as in the serial version.
+ * @return <0 on error <br>0 on success
+ */
+int DBConnector::_saveDataParallel2DB(const MavSystem &sys, const int systemID, event_ids_t &events,
+                                      event_ids_t &newEvents, double &maxEventID, DialogProgressBar*dlg) {
+    int ret = 0;
+    std::vector<save_job_t> jobs;
+    for (unsigned int id = 0; id < sys._paths.size(); ++id) {
+        const Data*const d = sys._paths.node(id).data;
+        if (!d) continue;
+        save_job_t job;
+        job.data = d;
+        std::string type;
+        if (_convertDataToDoubleVector(d, job.values, job.time, type, events, newEvents, maxEventID, false) < 0) {
+            std::cerr << "Error occured during converting of Data: " << d->get_name() << std::endl;
+            ret = -1;
+        }
+        job.converted = (type == "string_event");
+        job.type = type;
+        if (job.converted) {
+            _convertDataToDoubleVector(d, job.values, job.time, type, events, newEvents, maxEventID);
+        }
+        job.dataGroupID = _insertDataGroupToDB(*d, systemID, type);
+        if (job.dataGroupID < 0) {
+            std::cerr << "Error occured during saving of DataGroup: " << job.dataGroupID << std::endl;
+            ret = -2;
+            continue;
+        }
+        jobs.push_back(job);
+    }
+
+    QAtomicInt next(0), done(0), errors(0);
+    const db_props_t props = getDBProperties();
+    TaskGroup tasks(_saveThreads);
+    for (unsigned int k = 0; k < _saveThreads && k < jobs.size(); ++k) {
+        tasks.start(new DBSaveWorker(this, props, jobs, next, done, errors));
+    }
+    const unsigned int TOTAL = jobs.size();
+    while (!tasks.wait(100)) {
+        if (_canceled(dlg)) {
+            next.fetchAndAddOrdered(TOTAL); // no more jobs for the workers
+        } else if (dlg) {
+            dlg->setValue(done.fetchAndAddOrdered(0), TOTAL);
+        }
+    }
+    if (_canceled(dlg)) return -3;
+    if ((unsigned int)done.fetchAndAddOrdered(0) < TOTAL) {
+        std::cerr << "Could not save all data groups: no connection to the DB" << std::endl;
+        ret = -2;
+    }
+    if (errors.fetchAndAddOrdered(0) > 0) {
+        std::cerr << "Error occured during saving of " << errors.fetchAndAddOrdered(0) << " DataGroups" << std::endl;
+        ret = -2;
+    }
+    return ret;
+}
+
+/**
+ * @brief converts and inserts the samples of one data group. Called by DBSaveWorker.
+ * @return <0 on error <br>0 on success
+ */
+int DBConnector::_saveJob2DB(QSqlDatabase & db, save_job_t & job) {
+    TraceScope trace("db save group");
+    if (!job.converted) {
+        event_ids_t noevents, nonewEvents;
+        double nomaxEventID = 0.;
+        if (_convertDataToDoubleVector(job.data, job.values, job.time, job.type, noevents, nonewEvents, nomaxEventID) < 0) {
+            return -1;
+        }
+    }
+    int success = _useChunks ? _insertDataChunksToDB(db, job.values, job.time, job.dataGroupID)
+                             : _insertDataToDB(db, job.values, job.time, job.dataGroupID);
+    if (success >= 0 && _useOverview && !job.converted) {
+        success = _insertDataOverviewToDB(db, job.values, job.time, job.dataGroupID);
+    }
+    if (success >= 0 && _useHashes) {
+        const std::string hash = _contentHash(*job.data, job.type, job.values, job.time);
+        success = _insertDataGroupHashToDB(db, hash, job.values.size(), job.dataGroupID);
+        if (success >= 0) job.data->set_saved_hash(hash);
+    }
+    std::vector<double>().swap(job.values);
+    std::vector<double>().swap(job.time);
+    if (success < 0) {
+        std::cerr << "Error occured during saving of Data: " << success << std::endl;
+        return -3;
+    }
+    return 0;
+}
+
 /**
  * @brief stores DataGroup with all Data(converted to double) to the Database, only leafs (no nodes) are saved
  * @detail unfortunatly there is an inconsistency in the naming scheme between the c++ data structure and the database:<br>
@@ -304,7 +732,7 @@ int DBConnector::_saveSystem2DB(const MavSystem &sys, const int scenarioID, std:
  * @param maxEventID +1 is the next free eventId
  * @return <0 on error <br>0 on success
  */
-int DBConnector::_saveData2DB(const Data &dat, const int systemID, std::map<std::string,double> &events, std::map<std::string,double> &newEvents, double &maxEventID) {
+int DBConnector::_saveData2DB(const Data &dat, const int systemID, event_ids_t &events, event_ids_t &newEvents, double &maxEventID) {
     int success = 0;
     int dataGroupID;
     std::string type;
@@ -325,7 +753,19 @@ int DBConnector::_saveData2DB(const Data &dat, const int systemID, std::map<std:
         ret = -2;
     }
     // insert the actual data
-    success = _insertDataToDB(data, time, dataGroupID);
+    if (_useChunks) {
+        success = _insertDataChunksToDB(_db, data, time, dataGroupID);
+    } else {
+        success = _insertDataToDB(_db, data, time, dataGroupID);
+    }
+    if (success >= 0 && _useOverview && !dynamic_cast<const DataEvent<std::string>*>(&dat)) {
+        success = _insertDataOverviewToDB(_db, data, time, dataGroupID);
+    }
+    if (success >= 0 && _useHashes) {
+        const std::string hash = _contentHash(dat, type, data, time);
+        success = _insertDataGroupHashToDB(_db, hash, data.size(), dataGroupID);
+        if (success >= 0) dat.set_saved_hash(hash);
+    }
     if(success < 0) {
         std::cerr << "Error occured during saving of Data: " << success << std::endl;
         ret = -3;
@@ -338,21 +778,21 @@ int DBConnector::_saveData2DB(const Data &dat, const int systemID, std::map<std:
  * @param newEvents maps an id to the string of an event
  * @return <0 on error<br>0 on success
  */
-int DBConnector::_saveEvents2DB(const std::map<std::string, double> &newEvents) {
-    QSqlQuery qry;
+int DBConnector::_saveEvents2DB(const event_ids_t &newEvents) {
+    QSqlQuery qry(_db);
     std::stringstream ss;
     ss << std::setprecision(16);
     bool start = true;
 
     ss<<"INSERT INTO events (ID, EVENT) VALUES";
-    for (std::map<std::string, double>::const_iterator it = newEvents.begin(); it != newEvents.end(); ++it) {
+    for (event_ids_t::const_iterator it = newEvents.begin(); it != newEvents.end(); ++it) {
         if(!start)
         {
             ss << ",";
         }
         ss << " ("
            <<it->second<<","
-           <<"'"<<it->first<<"'"
+           <<"'"<<EventDict::lookup(it->first)<<"'"
            <<")";
         start = false;
     }
@@ -374,9 +814,10 @@ int DBConnector::_saveEvents2DB(const std::map<std::string, double> &newEvents)
  * @param data output vector with values
  * @param time output vector with times
  * @param type output type of input object
+ * @param convert if false, only type is determined
  * @return <0 on error 0 on success
  */
-int DBConnector::_convertDataToDoubleVector(const Data *dat,std::vector <double>& data, std::vector <double>& time, std::string &type, std::map<std::string,double> &events, std::map<std::string,double> &newEvents, double &maxEventID)
+int DBConnector::_convertDataToDoubleVector(const Data *dat,std::vector <double>& data, std::vector <double>& time, std::string &type, event_ids_t &events, event_ids_t &newEvents, double &maxEventID, bool convert)
 {
     /** DataTimeseries*/
     {
@@ -384,7 +825,7 @@ int DBConnector::_convertDataToDoubleVector(const Data *dat,std::vector <double>
         if (tsf)
         {
             type = "float_timed";
-            _convertTimeSeriesToDoubleVectorTemplate<float>(*tsf, data,time);
+            if (convert) _convertTimeSeriesToDoubleVectorTemplate<float>(*tsf, data,time);
             return 0;
         }
 
@@ -392,7 +833,7 @@ int DBConnector::_convertDataToDoubleVector(const Data *dat,std::vector <double>
         if (tsd)
         {
             type = "double_timed";
-            _convertTimeSeriesToDoubleVectorTemplate<double>(*tsd, data,time);
+            if (convert) _convertTimeSeriesToDoubleVectorTemplate<double>(*tsd, data,time);
             return 0;
         }
 
@@ -400,7 +841,7 @@ int DBConnector::_convertDataToDoubleVector(const Data *dat,std::vector <double>
         if (tsu)
         {
             type = "uint_timed";
-            _convertTimeSeriesToDoubleVectorTemplate<unsigned int>(*tsu, data,time);
+            if (convert) _convertTimeSeriesToDoubleVectorTemplate<unsigned int>(*tsu, data,time);
             return 0;
         }
 
@@ -408,7 +849,7 @@ int DBConnector::_convertDataToDoubleVector(const Data *dat,std::vector <double>
         if (tsi)
         {
             type = "int_timed";
-            _convertTimeSeriesToDoubleVectorTemplate<int>(*tsi, data,time);
+            if (convert) _convertTimeSeriesToDoubleVectorTemplate<int>(*tsi, data,time);
             return 0;
         }
     }
@@ -419,7 +860,7 @@ int DBConnector::_convertDataToDoubleVector(const Data *dat,std::vector <double>
         if (usf)
         {
             type = "float_untimed";
-            _convertUntimedDataToDoubleVectorTemplate<float>(*usf, data,time);
+            if (convert) _convertUntimedDataToDoubleVectorTemplate<float>(*usf, data,time);
             return 0;
         }
 
@@ -427,7 +868,7 @@ int DBConnector::_convertDataToDoubleVector(const Data *dat,std::vector <double>
         if (usd)
         {
             type = "double_untimed";
-            _convertUntimedDataToDoubleVectorTemplate<double>(*usd, data,time);
+            if (convert) _convertUntimedDataToDoubleVectorTemplate<double>(*usd, data,time);
             return 0;
         }
 
@@ -435,7 +876,7 @@ int DBConnector::_convertDataToDoubleVector(const Data *dat,std::vector <double>
         if (usu)
         {
             type = "uint_untimed";
-            _convertUntimedDataToDoubleVectorTemplate<unsigned int>(*usu, data,time);
+            if (convert) _convertUntimedDataToDoubleVectorTemplate<unsigned int>(*usu, data,time);
             return 0;
         }
 
@@ -443,7 +884,7 @@ int DBConnector::_convertDataToDoubleVector(const Data *dat,std::vector <double>
         if (usi)
         {
             type = "int_untimed";
-            _convertUntimedDataToDoubleVectorTemplate<int>(*usi, data,time);
+            if (convert) _convertUntimedDataToDoubleVectorTemplate<int>(*usi, data,time);
             return 0;
         }
     }
@@ -452,19 +893,21 @@ int DBConnector::_convertDataToDoubleVector(const Data *dat,std::vector <double>
         const DataEvent<std::string> *const ess = dynamic_cast<DataEvent<std::string> const*>(dat);
         if (ess) {
             type = "string_event";
+            if (!convert) return 0;
             //convertDataEventToDoubleVectorTemplate(*ess, data,time );
 
-            std::vector<std::string> dat = ess->get_data();
-            for (std::vector<std::string>::iterator it = dat.begin(); it != dat.end(); ++it) {
-                std::map<std::string,double>::iterator it2 = events.find(*it);
+            const std::vector<EventDict::id_t> & ids = ess->get_stored();
+            data.reserve(data.size() + ids.size());
+            for (std::vector<EventDict::id_t>::const_iterator it = ids.begin(); it != ids.end(); ++it) {
+                event_ids_t::iterator it2 = events.find(*it);
                 if(it2 != events.end()) {
                    //element found;
                    data.push_back(it2->second);
                 } else {
                     maxEventID++;
                     data.push_back(maxEventID);
-                    events.insert(std::pair<std::string,double>(*it,maxEventID));
-                    newEvents.insert(std::pair<std::string,double>(*it,maxEventID));
+                    events.insert(std::make_pair(*it,maxEventID));
+                    newEvents.insert(std::make_pair(*it,maxEventID));
                 }
 
             }
@@ -485,10 +928,10 @@ int DBConnector::_convertDataToDoubleVector(const Data *dat,std::vector <double>
 template <typename TT>
 void DBConnector::_convertTimeSeriesToDoubleVectorTemplate(const DataTimeseries<TT> &dat, std::vector <double> &data,std::vector <double> &time)
 {
-    for (typename std::vector<TT>::const_iterator it = dat.get_data().begin(); it != dat.get_data().end(); ++it)
-    {
-        data.push_back((double)*it);
-    }
+    const std::vector<TT> & values = dat.get_data();
+    const size_t n0 = data.size();
+    data.resize(n0 + values.size());
+    if (!values.empty()) vec_to_double(&values[0], values.size(), &data[n0]);
     time = dat.get_time();
 }
 
@@ -519,7 +962,7 @@ void DBConnector::convertDataEventToDoubleVectorTemplate(const DataEvent<ET> &da
  * @return 0 on success, else error code
  */
 int DBConnector::_updateScenarioInDB(const MavlinkScenario &scenario, unsigned long long existsID) {
-    QSqlQuery qry;
+    QSqlQuery qry(_db);
     qry.prepare("UPDATE scenarios SET DESCRIPTION=:desc, FILENAME=:filename WHERE ID=:id;");
     qry.bindValue(":desc", QString().fromStdString(scenario.getDescription()));
     qry.bindValue(":id", QString().number(existsID));
@@ -531,6 +974,235 @@ int DBConnector::_updateScenarioInDB(const MavlinkScenario &scenario, unsigned l
     return 0;
 }
 
+/**
+ * @brief remove a scenario with all its systems, data groups and samples from the DB, e.g.,
+ * after saving it was canceled
+ * @param scenarioID the database id of the scenario
+ * @return 0 on success, else error code
+ */
+int DBConnector::_deleteScenarioFromDB(unsigned long long scenarioID) {
+    const QString groups = "SELECT g.ID FROM dataGroups g INNER JOIN systems s ON g.SYSTEM_ID=s.ID WHERE s.SCENARIO_ID=:id";
+    QStringList stmts;
+    stmts << "DELETE FROM data WHERE DATAGROUP_ID IN (" + groups + ");";
+    if (_hasChunkTable()) {
+        stmts << "DELETE FROM dataChunks WHERE DATAGROUP_ID IN (" + groups + ");";
+    }
+    if (_hasStatsTable()) {
+        stmts << "DELETE FROM dataGroupStats WHERE DATAGROUP_ID IN (" + groups + ");";
+    }
+    if (_hasOverviewTable()) {
+        stmts << "DELETE FROM dataOverview WHERE DATAGROUP_ID IN (" + groups + ");";
+    }
+    if (_hasHashTable()) {
+        stmts << "DELETE FROM dataGroupHashes WHERE DATAGROUP_ID IN (" + groups + ");";
+    }
+    stmts << "DELETE FROM dataGroups WHERE SYSTEM_ID IN (SELECT ID FROM systems WHERE SCENARIO_ID=:id);";
+    stmts << "DELETE FROM systems WHERE SCENARIO_ID=:id;";
+    if (_hasFingerprintTable()) {
+        stmts << "DELETE FROM scenarioFingerprints WHERE SCENARIO_ID=:id;";
+    }
+    stmts << "DELETE FROM scenarios WHERE ID=:id;";
+
+    _begin(_db);
+    QSqlQuery qry(_db);
+    for (QStringList::const_iterator it = stmts.begin(); it != stmts.end(); ++it) {
+        qry.prepare(*it);
+        qry.bindValue(":id", (qulonglong)scenarioID);
+        if( !qry.exec()) {
+            std::cerr << "_deleteScenarioFromDB: Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
+            _rollback(_db);
+            return -1;
+        }
+    }
+    _commit(_db);
+    return 0;
+}
+
+/**
+ * @brief remove data groups with their samples, statistics, overview and hash
+ * @param ids the database ids of the groups
+ * @return 0 on success, else error code
+ */
+int DBConnector::_deleteDataGroupsFromDB(const std::vector<unsigned long long> & ids) {
+    QStringList tables;
+    tables << "data";
+    if (_hasChunkTable()) tables << "dataChunks";
+    if (_hasStatsTable()) tables << "dataGroupStats";
+    if (_hasOverviewTable()) tables << "dataOverview";
+    if (_hasHashTable()) tables << "dataGroupHashes";
+
+    _begin(_db);
+    QSqlQuery qry(_db);
+    for (size_t from = 0; from < ids.size(); from += DB_DELETE_BATCH) {
+        // numbers only, no need to bind them
+        QStringList list;
+        for (size_t k = from; k < ids.size() && k < from + DB_DELETE_BATCH; ++k) {
+            list << QString::number(ids[k]);
+        }
+        const QString in = "(" + list.join(",") + ")";
+        QStringList stmts;
+        for (QStringList::const_iterator t = tables.begin(); t != tables.end(); ++t) {
+            stmts << "DELETE FROM " + *t + " WHERE DATAGROUP_ID IN " + in + ";";
+        }
+        stmts << "DELETE FROM dataGroups WHERE ID IN " + in + ";";
+        for (QStringList::const_iterator it = stmts.begin(); it != stmts.end(); ++it) {
+            if (!qry.exec(*it)) {
+                std::cerr << "_deleteDataGroupsFromDB: Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
+                _rollback(_db);
+                return -1;
+            }
+        }
+    }
+    _commit(_db);
+    return 0;
+}
+
+/**
+ * @brief the time fields of a system which is in the DB already, since new files and derived
+ * series can change them
+ * @return 0 on success, else error code
+ */
+int DBConnector::_updateSystemInDB(const MavSystem &sys, unsigned long long systemID) {
+    QSqlQuery qry(_db);
+    qry.prepare("UPDATE systems SET ARMED=:armed, TIME=:time, TIME_VALID=:time_valid, TIME_MIN=:time_min, TIME_MAX=:time_max, "
+                "TIME_OFFSET_USEC=:time_off_usec, TIME_OFFSET_GUESS_USEC=:time_off_usec_guess WHERE ID=:id;");
+    qry.bindValue(":armed", sys.has_been_armed);
+    qry.bindValue(":time", sys._time);
+    qry.bindValue(":time_valid", sys._time_valid);
+    qry.bindValue(":time_min", sys._time_min);
+    qry.bindValue(":time_max", sys._time_max);
+    qry.bindValue(":time_off_usec", (qulonglong)sys._time_offset_usec);
+    qry.bindValue(":time_off_usec_guess", (qulonglong)sys._time_offset_guess_usec);
+    qry.bindValue(":id", (qulonglong)systemID);
+    if( !qry.exec()) {
+       std::cerr << "_updateSystemInDB: Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
+       return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief bring the data of a scenario in the DB up to date with the given one. Data groups
+ * with the same content hash (table dataGroupHashes) are kept, changed ones are replaced, new
+ * ones are inserted and those which are gone are deleted. Data that is clean since it was
+ * saved or compared (see Data::get_saved_hash()) is not even converted. Systems which the DB
+ * does not have are inserted with all their data.
+ * @param scenarioID the database id of the scenario
+ * @return 0 on success, else error code
+ */
+int DBConnector::_updateScenarioData(const MavlinkScenario &scenario, unsigned long long scenarioID, DialogProgressBar*dlg) {
+    _useChunks = _hasChunkTable();
+    _useStats = _hasStatsTable();
+    _useOverview = _hasOverviewTable();
+    _useHashes = _hasHashTable();
+
+    event_ids_t events;
+    event_ids_t newEvents;
+    double maxEventID;
+    if (_getEventsFromDB(events, maxEventID) < 0) return -1;
+
+    typedef std::map<std::string, std::pair<unsigned long long, std::string> > stored_t; ///< ID and hash, by path
+    unsigned int kept = 0, replaced = 0, inserted = 0;
+    std::vector<unsigned long long> gone;
+    int ret = 0;
+    QSqlQuery qry(_db);
+    for (MavlinkScenario::systemlist::const_iterator it = scenario._seen_systems.begin(); it != scenario._seen_systems.end(); ++it) {
+        const MavSystem & sys = *it->second;
+        qry.prepare("SELECT ID FROM systems WHERE SCENARIO_ID=:id AND SYSTEM_ID=:sys_id;");
+        qry.bindValue(":id", (qulonglong)scenarioID);
+        qry.bindValue(":sys_id", sys.id);
+        if (!qry.exec()) {
+            std::cerr << "_updateScenarioData: Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
+            return -2;
+        }
+        if (!qry.next()) {
+            if (_saveSystem2DB(sys, (int)scenarioID, events, newEvents, maxEventID, dlg) < 0) ret = -3;
+            inserted += sys._paths.count_data();
+            continue;
+        }
+        const unsigned long long systemID = qry.value(0).toULongLong();
+
+        // what the DB has of this system
+        stored_t stored;
+        qry.prepare(_useHashes ? "SELECT g.ID, g.FULLPATH, h.HASH FROM dataGroups g LEFT JOIN dataGroupHashes h ON h.DATAGROUP_ID=g.ID WHERE g.SYSTEM_ID=:sid;"
+                               : "SELECT g.ID, g.FULLPATH, NULL FROM dataGroups g WHERE g.SYSTEM_ID=:sid;");
+        qry.bindValue(":sid", (qulonglong)systemID);
+        if (!qry.exec()) {
+            std::cerr << "_updateScenarioData: Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
+            return -2;
+        }
+        while (qry.next()) {
+            const std::string hash = qry.value(2).isNull() ? std::string() : qry.value(2).toString().toStdString();
+            stored[qry.value(1).toString().toStdString()] = std::make_pair(qry.value(0).toULongLong(), hash);
+        }
+
+        const unsigned int TOTAL = sys._paths.count_data();
+        unsigned int cnt = 0;
+        for (unsigned int id = 0; id < sys._paths.size(); ++id) {
+            const Data*const d = sys._paths.node(id).data;
+            if (!d) continue;
+            if (_canceled(dlg)) return -4;
+            if (dlg) dlg->setValue(cnt++, TOTAL);
+
+            stored_t::iterator s = stored.find(Data::get_fullname(d));
+            const bool have = (s != stored.end());
+            unsigned long long oldID = 0;
+            std::string oldHash;
+            if (have) {
+                oldID = s->second.first;
+                oldHash = s->second.second;
+                stored.erase(s);
+                if (d->is_deferred() || d->is_overview()) {
+                    kept++; // not all samples are in memory, but the DB has them
+                    continue;
+                }
+            }
+            if (!oldHash.empty()) {
+                std::string hash;
+                if (!d->get_saved_hash(hash)) {
+                    std::vector<double> values, time;
+                    std::string type;
+                    if (_convertDataToDoubleVector(d, values, time, type, events, newEvents, maxEventID) < 0) {
+                        std::cerr << "Error occured during converting of Data: " << d->get_name() << std::endl;
+                        ret = -5;
+                        continue;
+                    }
+                    hash = _contentHash(*d, type, values, time);
+                }
+                if (hash == oldHash) {
+                    d->set_saved_hash(hash);
+                    kept++;
+                    continue;
+                }
+            }
+            if (have) {
+                if (_deleteDataGroupsFromDB(std::vector<unsigned long long>(1, oldID)) < 0) {
+                    ret = -6;
+                    continue;
+                }
+                replaced++;
+            } else {
+                inserted++;
+            }
+            if (_saveData2DB(*d, (int)systemID, events, newEvents, maxEventID) < 0) ret = -7;
+        }
+        for (stored_t::const_iterator s = stored.begin(); s != stored.end(); ++s) {
+            gone.push_back(s->second.first);
+        }
+        if (_updateSystemInDB(sys, systemID) < 0) ret = -8;
+    }
+    if (!gone.empty() && _deleteDataGroupsFromDB(gone) < 0) ret = -6;
+
+    if (_saveEvents2DB(newEvents) < 0) {
+        std::cerr << "Error occured during saving of Events to DB" << std::endl;
+        return -9;
+    }
+    _addEventsToCache(newEvents);
+    std::cout << "DB: kept " << kept << ", replaced " << replaced << ", inserted " << inserted
+              << ", deleted " << gone.size() << " data groups" << std::endl;
+    return ret;
+}
+
 /**
  * @brief inserts Properties of scenario to the DB
  * @param scenario Reference
@@ -559,7 +1231,7 @@ int DBConnector::_insertScenarioToDB(const MavlinkScenario &scenario)
 
     */
 
-    QSqlQuery qry;
+    QSqlQuery qry(_db);
     double scenarioID;
     std::stringstream ss;
     ss << std::setprecision(16);
@@ -575,7 +1247,7 @@ int DBConnector::_insertScenarioToDB(const MavlinkScenario &scenario)
        std::cerr << "_insertScenarioToDB: Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
        return -2;
     }
-    qry.prepare("select LAST_INSERT_ID();");
+    qry.prepare(_backend->lastInsertId());
     if( !qry.exec()) {
        std::cerr << "_insertScenarioToDB: Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
        return -3;
@@ -647,7 +1319,7 @@ unsigned long long DBConnector::_insertSystemToDB(const MavSystem &sys, const in
 
 */
 
-    QSqlQuery qry;
+    QSqlQuery qry(_db);
     qry.prepare("INSERT INTO systems SET "
                 "SCENARIO_ID=:sc_id, SYSTEM_ID=:sys_id, " // 1
                 "APTYPE=:aptype, APTYPE_STRING=:aptypestr, MAVTYPE=:mavtype, MAVTYPE_STRING=:mavtypestr," // 2
@@ -675,7 +1347,7 @@ unsigned long long DBConnector::_insertSystemToDB(const MavSystem &sys, const in
        std::cerr << "Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
        return -2;
     }
-    qry.prepare("select LAST_INSERT_ID();");
+    qry.prepare(_backend->lastInsertId());
     if( !qry.exec() ) {
        std::cerr << "Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
        return -3;
@@ -737,7 +1409,7 @@ DONT SAVE - SHOULD BE GENERATED
 +----------------------+---------------------+------+-----+---------+----------------+
 
 */
-    QSqlQuery qry;
+    QSqlQuery qry(_db);
     std::stringstream ss;
     ss << std::setprecision(16);
     double dataGroupID;
@@ -758,154 +1430,533 @@ DONT SAVE - SHOULD BE GENERATED
        std::cerr << "Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
        return -2;
     }
-    qry.prepare("select LAST_INSERT_ID();");
+    qry.prepare(_backend->lastInsertId());
     if( !qry.exec() ) {
        std::cerr << "Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
        return -3;
     }
     qry.next();
     dataGroupID = qry.value(0).toUInt();
+    if (_useStats && _insertDataGroupStatsToDB(dat, dataGroupID) < 0) {
+        std::cerr << "WARNING: no statistics saved for data group " << dat._name << std::endl; // not needed for loading
+    }
     return dataGroupID;
 }
 
+template <typename T>
+static bool _getSeriesStats(const Data & dat, Data::data_stats & s) {
+    const DataTimeseries<T>*const ts = dynamic_cast<const DataTimeseries<T>*>(&dat);
+    if (!ts) return false;
+    s.n_samples = ts->size();
+    if (s.n_samples == 0) return true;
+    s.min = ts->get_min();
+    s.max = ts->get_max();
+    s.avg = ts->get_average();
+    s.stddev = ts->get_stddev();
+    s.t_min = ts->get_min_time();
+    s.t_max = ts->get_max_time();
+    if (s.n_samples > 1 && s.t_max > s.t_min) {
+        s.freq = (s.n_samples - 1) / (s.t_max - s.t_min);
+    }
+    return true;
+}
+
+template <typename T>
+static bool _getParamStats(const Data & dat, Data::data_stats & s) {
+    const DataParam<T>*const p = dynamic_cast<const DataParam<T>*>(&dat);
+    if (!p) return false;
+    s.n_samples = 1;
+    s.min = s.max = s.avg = p->get_value();
+    s.stddev = 0.;
+    return true;
+}
+
 /**
- * @brief inserts double vector to the DB
- * @param data vector with data to be inserted to the db
- * @param time timestamps for that data
- * @param dataGroupID dataGroupId this data belongs to
- * @return ID if everything was ok<br> <0 if something was wrong
- *
- * This function is highly optimized...don't mess with it!
+ * @brief inserts the statistics which the data keeps anyway into table dataGroupStats, so that
+ * searches can skip groups without looking at their samples. Only numbers; events have none.
+ * @return 0 if everything was ok<br> >0 if there is nothing to save<br> <0 if something was wrong
  */
-int DBConnector::_insertDataToDB(const std::vector <double> &data, const std::vector <double> &time, const int dataGroupID) {
-/*
-+---------+------------------+------+-----+---------+----------------+
-| Field   | Type             | Null | Key | Default | Extra          |
-+---------+------------------+------+-----+---------+----------------+
-| ID      | int(10) unsigned | NO   | PRI | NULL    | auto_increment |
-| DATA_ID | int(10) unsigned | YES  |     | NULL    |                |
-| TIME    | double           | YES  |     | NULL    |                |
-| VALUE   | double           | YES  |     | NULL    |                |
-+---------+------------------+------+-----+---------+----------------+
-
-  */    
-    if( data.size() != time.size() ) {
-        std::cerr << "Fehler: Anzahl an Werten stimmt nicht mit Zeiten überein!" << std::endl;
-        return -2;
+int DBConnector::_insertDataGroupStatsToDB(const Data &dat, const int dataGroupID) {
+    Data::data_stats s;
+    s.n_samples = 0;
+    s.min = s.max = s.avg = s.stddev = NAN;
+    s.t_min = s.t_max = s.freq = NAN;
+    if (!(_getSeriesStats<float>(dat, s) || _getSeriesStats<double>(dat, s) ||
+          _getSeriesStats<unsigned int>(dat, s) || _getSeriesStats<int>(dat, s) ||
+          _getParamStats<float>(dat, s) || _getParamStats<double>(dat, s) ||
+          _getParamStats<unsigned int>(dat, s) || _getParamStats<int>(dat, s))) {
+        return 1;
     }
-    if (data.empty()) return 0; // nothing to do
 
-    _db.transaction(); // also helps speed
-    QSqlQuery qry;
+    QSqlQuery qry(_db);
+    qry.prepare("INSERT INTO dataGroupStats (DATAGROUP_ID,N,VALUE_MIN,VALUE_MAX,VALUE_AVG,VALUE_STDDEV,TIME_MIN,TIME_MAX,RATE) "
+                "VALUES (?,?,?,?,?,?,?,?,?);");
+    qry.addBindValue(dataGroupID);
+    qry.addBindValue(s.n_samples);
+    const double vals[] = {s.min, s.max, s.avg, s.stddev, s.t_min, s.t_max, s.freq};
+    for (unsigned int k = 0; k < sizeof(vals)/sizeof(vals[0]); ++k) {
+        qry.addBindValue(isnan(vals[k]) ? QVariant(QVariant::Double) : QVariant(vals[k])); // NULL
+    }
+    if( !qry.exec() ) {
+       std::cerr << "Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
+       return -1;
+    }
+    return 0;
+}
 
-    std::stringstream ssqry, ssdataGroupID;
-    ssqry << std::setprecision(16);
+/**
+ * @brief inserts the content hash of a data group into table dataGroupHashes
+ * @param db connection to use
+ * @return 0 if everything was ok<br> <0 if something was wrong
+ */
+int DBConnector::_insertDataGroupHashToDB(QSqlDatabase & db, const std::string & hash, unsigned long n, const int dataGroupID) {
+    QSqlQuery qry(db);
+    qry.prepare("INSERT INTO dataGroupHashes (DATAGROUP_ID,N,HASH) VALUES (?,?,?);");
+    qry.addBindValue(dataGroupID);
+    qry.addBindValue((qulonglong)n);
+    qry.addBindValue(QString::fromStdString(hash));
+    if( !qry.exec() ) {
+       std::cerr << "Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
+       return -1;
+    }
+    return 0;
+}
 
-    // speedup: turn datagroup in string exactly once (saves the int-to-string conversion every time)
-    ssdataGroupID << dataGroupID;
-    const std::string strdataGroupID = ssdataGroupID.str();
+static void _hashDoubles(QCryptographicHash & hash, const std::vector<double> & v) {
+    const size_t step = 1 << 24; // addData() takes an int
+    for (size_t k = 0; k < v.size(); k += step) {
+        const size_t n = std::min(step, v.size() - k);
+        hash.addData(reinterpret_cast<const char*>(&v[k]), n*sizeof(double));
+    }
+}
 
-    // value differencing for speedup
-    std::stringstream ssvalue;
-    ssvalue << std::setprecision(16);
-    double lastVal;
-    bool first = true;
-    // ---
+/**
+ * @brief hash of what is saved of a data group: the fields of table dataGroups besides the
+ * path, and the samples as they are written. Same hash, same rows.
+ */
+std::string DBConnector::_contentHash(const Data &dat, const std::string & type, const std::vector<double> &data, const std::vector<double> &time) {
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    std::stringstream ss;
+    ss << type << '\n' << dat._valid << '\n' << dat._class << '\n' << dat._time_epoch_datastart_usec << '\n'
+       << dat._units << '\n' << data.size() << '\n';
+    const std::string head = ss.str();
+    hash.addData(head.data(), head.size());
+    _hashDoubles(hash, time);
+    _hashDoubles(hash, data);
+    return std::string(hash.result().toHex().constData());
+}
 
-    std::vector<double>::const_iterator itd = data.begin();
-    std::vector<double>::const_iterator itt = time.begin();
-    unsigned int chunk = 0;
-    const unsigned int CHUNKSIZE=5000;
-    bool ret;
-    for (/*above*/; itd != data.end(); /* IN LOOP */) {
-        if(chunk == 0) {
-            ssqry.str(std::string()); // CLEAR            
-        }
+/**
+ * @brief inserts double vector to the DB
+ * @param db connection to use
+ * @param data vector with data to be inserted to the db
+ * @param time timestamps for that data
+ * @param dataGroupID dataGroupId this data belongs to
+ * @return ID if everything was ok<br> <0 if something was wrong
+ *
+ * Samples are bound as numbers to a prepared statement, no text is formatted. If the driver
+ * can do batches, each chunk is one execBatch(). Otherwise (e.g., MySQL) each chunk is one
+ * INSERT with many rows, and the statement is prepared once and reused for all full chunks.
+ */
+int DBConnector::_insertDataToDB(QSqlDatabase & db, const std::vector <double> &data, const std::vector <double> &time, const int dataGroupID) {
+/*
++---------+------------------+------+-----+---------+----------------+
+| Field   | Type             | Null | Key | Default | Extra          |
++---------+------------------+------+-----+---------+----------------+
+| ID      | int(10) unsigned | NO   | PRI | NULL    | auto_increment |
+| DATA_ID | int(10) unsigned | YES  |     | NULL    |                |
+| TIME    | double           | YES  |     | NULL    |                |
+| VALUE   | double           | YES  |     | NULL    |                |
++---------+------------------+------+-----+---------+----------------+
 
-        // differencing: only convert value to string, if value changed
-        const double val = *itd;
+  */    
+    if( data.size() != time.size() ) {
+        std::cerr << "Fehler: Anzahl an Werten stimmt nicht mit Zeiten überein!" << std::endl;
+        return -2;
+    }
+    if (data.empty()) return 0; // nothing to do
 
-        if (itd == data.begin() || first || val != lastVal) {
-            ssvalue.str(std::string()); // CLEAR
-            ssvalue << val;
-            lastVal = val;
+    _begin(db); // also helps speed
+    QSqlQuery qry(db);
+
+    const bool batch = db.driver()->hasFeature(QSqlDriver::BatchOperations);
+    const QString strdataGroupID = QString::number(dataGroupID);
+    const QString row = "(" + strdataGroupID + ",?,?)";
+
+    const int CHUNKSIZE=5000;
+    int prepared_rows = 0; ///< how many rows the prepared statement has
+    unsigned int n_nan = 0;
+    QVariantList vtime, vvalue;
+    for (size_t k = 0; k < data.size(); /* IN LOOP */) {
+        // collect next chunk. SKIP NANs!!!
+        vtime.clear();
+        vvalue.clear();
+        for (/*above*/; k < data.size() && vtime.size() < CHUNKSIZE; ++k) {
+            if (isnan(data[k])) {
+                n_nan++;
+                continue;
+            }
+            vtime << time[k];
+            vvalue << data[k];
         }
-        std::string ssval = ssvalue.str();
-
-        // SKIP NANs!!!
-        if (ssval.find("nan") != std::string::npos) {
-            // skip
+        const int rows = vtime.size();
+        if (rows == 0) continue;
+
+        bool ret = true;
+        if (batch) {
+            if (prepared_rows == 0) {
+                ret = qry.prepare("INSERT INTO data (DATAGROUP_ID,TIME,VALUE) VALUES " + row + ";");
+                prepared_rows = 1;
+            }
+            qry.addBindValue(vtime);
+            qry.addBindValue(vvalue);
+            ret = ret && qry.execBatch();
         } else {
-            ssqry << "(" << strdataGroupID << "," << *itt << "," << ssval << "),";
-        }
-
-        // LOOP INCREMENT
-        ++itd; ++itt;
-
-        // we split the INSERT into smaller queries to aid performance and to not overload the DB
-        if (++chunk == CHUNKSIZE || itd == data.end()) {            
-            QString body = QString::fromStdString(ssqry.str());
-            // only non-empty queries are passed
-            if (body.size() > 1) {
-                body.resize (body.size()-1); // remove trailing ","
-                QString qf = "INSERT INTO data (DATAGROUP_ID,TIME,VALUE) VALUES " + body + ";";
-                qry.prepare( qf ); // FIXME: use bindVal()
-                ret = qry.exec();
-                if( !ret ) {
-                   std::cerr << "Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
-                   std::cerr << "Full query: " << qf.toStdString() << endl;
-                   _db.rollback();
-                   return -3;
+            if (rows != prepared_rows) {
+                QString qf = "INSERT INTO data (DATAGROUP_ID,TIME,VALUE) VALUES " + row;
+                for (int r = 1; r < rows; ++r) {
+                    qf += "," + row;
                 }
-            } else {
-                    std::cerr << "Skipped empty (possibly nan-filled) dataGroup chunk for group " << strdataGroupID  << endl;
+                qf += ";";
+                ret = qry.prepare(qf);
+                prepared_rows = rows;
             }
-            chunk = 0;
+            for (int r = 0; r < rows; ++r) {
+                qry.bindValue(2*r, vtime[r]);
+                qry.bindValue(2*r + 1, vvalue[r]);
+            }
+            ret = ret && qry.exec();
         }
-        if (first) {
-            first = false;
+        if( !ret ) {
+            std::cerr << "Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
+            std::cerr << "Query: " << qry.lastQuery().left(200).toStdString() << "..." << endl;
+            _rollback(db);
+            return -3;
         }
-    }    
-    _db.commit(); // also helps speed
+    }
+    if (n_nan > 0) {
+        std::cerr << "Skipped " << n_nan << " nan values in dataGroup " << dataGroupID << endl;
+    }
+    _commit(db); // also helps speed
 
     return 0;
 }
 
 
 /**
-* @brief selects all existing events from the db and stores it to a map
-* @param events maps id of an event to an event string (returned)
+* @brief all existing events of the DB, as a map
+* @param events maps the EventDict id of an event to its id in the DB (returned)
 * @param maxEventID +1 is the next free eventId
 * @return <0 on error<br>0 on success
 */
-int DBConnector::_getEventsFromDB(std::map<std::string, double> &events, double &maxEventID) {
-    QSqlQuery qry;
-    qry.prepare("SELECT * FROM events ORDER BY ID asc;");
-    if( !qry.exec() )
-    {
-       std::cerr << "Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
-       return -2;
+int DBConnector::_getEventsFromDB(event_ids_t &events, double &maxEventID) {
+    return _syncEventsFromDB(&events, NULL, &maxEventID);
+}
+
+/**
+ * @brief bring the process-wide copy of table events up to date, and copy what is asked for.
+ * Only rows which are new since the last time are fetched, in one round trip. The row with
+ * the highest ID always comes along; if it is unknown, the table was made anew.
+ * @param ids, names, maxEventID the copies to fill. NULL=not needed.
+ * @return <0 on error<br>0 on success
+ */
+int DBConnector::_syncEventsFromDB(event_ids_t * ids, event_names_t * names, double * maxEventID) {
+    QMutexLocker lock(&g_events_mutex);
+    if (!g_events) g_events = new std::map<std::string,event_cache_t>();
+    const std::string key = _db.hostName().toStdString() + "\n" + _db.databaseName().toStdString();
+    std::map<std::string,event_cache_t>::iterator itc = g_events->find(key);
+    if (itc == g_events->end()) {
+        itc = g_events->insert(std::make_pair(key, event_cache_t())).first;
+        itc->second.maxid = -1.;
     }
-    else
-    {
-        while(qry.next())
-        {
-            double id = qry.value(qry.record().indexOf("ID")).toDouble();
-            std::string event = qry.value(qry.record().indexOf("EVENT")).toString().toStdString();
-            events[event] = id;
-            maxEventID = id;
+    event_cache_t & cache = itc->second;
+
+    QSqlQuery qry = prepared(_db, "SELECT ID,EVENT FROM events WHERE ID>:max OR ID=(SELECT MAX(ID) FROM events) ORDER BY ID;");
+    for (int pass = 0; pass < 2; ++pass) {
+        qry.bindValue(":max", cache.maxid);
+        if (!qry.exec()) {
+            std::cerr << "Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
+            return -2;
         }
+        bool stale = false;
+        bool first = true;
+        while (!stale && qry.next()) {
+            const double id = qry.value(0).toDouble();
+            if (first && id < cache.maxid) stale = true;
+            first = false;
+            if (stale || id <= cache.maxid) continue;
+            const EventDict::id_t eid = EventDict::intern(qry.value(1).toString().toStdString());
+            cache.ids[eid] = id;
+            cache.names[id] = eid;
+            cache.maxid = id;
+        }
+        if (first && cache.maxid >= 0.) stale = true; // no rows at all
+        if (!stale) break;
+        std::cout << "Table events was made anew, reading it again" << std::endl;
+        qry.finish();
+        cache.ids.clear();
+        cache.names.clear();
+        cache.maxid = -1.;
     }
+
+    if (ids) *ids = cache.ids;
+    if (names) *names = cache.names;
+    if (maxEventID) *maxEventID = (cache.maxid >= 0.) ? cache.maxid : 0.;
     return 0;
 }
 
+/**
+ * @brief remember the events we just saved, so the next sync needs not fetch them
+ */
+void DBConnector::_addEventsToCache(const event_ids_t &newEvents) {
+    QMutexLocker lock(&g_events_mutex);
+    if (!g_events) return;
+    const std::string key = _db.hostName().toStdString() + "\n" + _db.databaseName().toStdString();
+    std::map<std::string,event_cache_t>::iterator itc = g_events->find(key);
+    if (itc == g_events->end()) return;
+    event_cache_t & cache = itc->second;
+    event_names_t byid;
+    for (event_ids_t::const_iterator it = newEvents.begin(); it != newEvents.end(); ++it) {
+        byid[it->second] = it->first;
+    }
+    for (event_names_t::const_iterator it = byid.begin(); it != byid.end(); ++it) {
+        // other clients could have saved events meanwhile, which we have not seen yet
+        if (it->first != cache.maxid + 1.) return;
+        cache.ids[it->second] = it->first;
+        cache.names[it->first] = it->second;
+        cache.maxid = it->first;
+    }
+}
+
+/**
+ * @brief whether the database has table dataChunks (see install/makedb.sql). If so,
+ * samples are saved there; otherwise one row per sample in table data, as always.
+ * Groups saved before the table existed stay in table data, so whatever reads samples
+ * has to look in both: _fetchSamples(), the aggregates, FilterWindow and
+ * install/backfill_stats.sql do.
+ */
+bool DBConnector::_hasChunkTable(void) {
+    return hasTable(_db, "dataChunks");
+}
+
+/**
+ * @brief whether the database has table dataGroupStats (see install/makedb.sql). If so,
+ * the statistics of each data group are saved there, too.
+ */
+bool DBConnector::_hasStatsTable(void) {
+    return hasTable(_db, "dataGroupStats");
+}
+
+/**
+ * @brief whether the database has table dataOverview (see install/makedb.sql). If so, an
+ * overview of each numeric data group is saved there, too.
+ */
+bool DBConnector::_hasOverviewTable(void) {
+    return hasTable(_db, "dataOverview");
+}
+
+/**
+ * @brief whether the database has table dataGroupHashes (see install/makedb.sql). If so, the
+ * content hash of each data group is saved there, and updating a scenario writes only the
+ * groups whose hash changed.
+ */
+bool DBConnector::_hasHashTable(void) {
+    return hasTable(_db, "dataGroupHashes");
+}
+
+/**
+ * @brief whether the database has table scenarioFingerprints (see install/makedb.sql). If so, the
+ * fingerprints of the log files of each scenario are saved there, and a scenario made from the
+ * same files is not saved twice.
+ */
+bool DBConnector::_hasFingerprintTable(void) {
+    return hasTable(_db, "scenarioFingerprints");
+}
+
+/**
+ * @brief whether the samples of the given data group are in table dataChunks
+ */
+bool DBConnector::_hasChunks(unsigned long long datagroupID) {
+    QSqlQuery qry = prepared(_db, "SELECT ID from dataChunks WHERE DATAGROUP_ID=:did LIMIT 1;");
+    qry.bindValue(":did", datagroupID);
+    return qry.exec() && qry.next();
+}
+
+/**
+ * @brief inserts double vector to the DB, in table dataChunks. Each chunk holds up to DB_CHUNK_SAMPLES
+ * samples, times and values each as a zlib-compressed array of doubles (native byte order),
+ * plus its time and value bounds. NaNs are kept, but do not count for the bounds.
+ * @param db connection to use
+ * @param data vector with data to be inserted to the db
+ * @param time timestamps for that data
+ * @param dataGroupID dataGroupId this data belongs to
+ * @return 0 if everything was ok<br> <0 if something was wrong
+ */
+int DBConnector::_insertDataChunksToDB(QSqlDatabase & db, const std::vector <double> &data, const std::vector <double> &time, const int dataGroupID) {
+    if( data.size() != time.size() ) {
+        std::cerr << "Fehler: Anzahl an Werten stimmt nicht mit Zeiten überein!" << std::endl;
+        return -2;
+    }
+    if (data.empty()) return 0; // nothing to do
+
+    _begin(db);
+    QSqlQuery qry(db);
+    if (!qry.prepare("INSERT INTO dataChunks (DATAGROUP_ID,SEQ,N,TIME_MIN,TIME_MAX,VALUE_MIN,VALUE_MAX,TIMES,VALS) VALUES (?,?,?,?,?,?,?,?,?);")) {
+        std::cerr << "Error occured during preparation of Query: "<<qry.lastError().text().toStdString() << std::endl;
+        _rollback(db);
+        return -3;
+    }
+    unsigned int seq = 0;
+    for (size_t lo = 0; lo < data.size(); lo += DB_CHUNK_SAMPLES, ++seq) {
+        const size_t n = std::min(data.size() - lo, (size_t)DB_CHUNK_SAMPLES);
+        double tmin = time[lo], tmax = time[lo];
+        double vmin = INFINITY, vmax = -INFINITY;
+        for (size_t k = lo; k < lo + n; ++k) {
+            tmin = std::min(tmin, time[k]);
+            tmax = std::max(tmax, time[k]);
+            if (isnan(data[k])) continue;
+            vmin = std::min(vmin, data[k]);
+            vmax = std::max(vmax, data[k]);
+        }
+        const int bytes = n*sizeof(double);
+        qry.addBindValue(dataGroupID);
+        qry.addBindValue(seq);
+        qry.addBindValue((unsigned int)n);
+        qry.addBindValue(tmin);
+        qry.addBindValue(tmax);
+        qry.addBindValue(vmin <= vmax ? QVariant(vmin) : QVariant(QVariant::Double)); // all nan => NULL
+        qry.addBindValue(vmin <= vmax ? QVariant(vmax) : QVariant(QVariant::Double));
+        qry.addBindValue(qCompress(QByteArray::fromRawData((const char*) &time[lo], bytes)));
+        qry.addBindValue(qCompress(QByteArray::fromRawData((const char*) &data[lo], bytes)));
+        if (!qry.exec()) {
+            std::cerr << "Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
+            _rollback(db);
+            return -3;
+        }
+    }
+    _commit(db);
+    return 0;
+}
+
+/**
+ * @brief inserts an overview of the samples into table dataOverview: the samples are split
+ * into DB_OVERVIEW_POINTS/2 buckets, and of each the one with the smallest and the one with the
+ * largest value are kept, in time order. Plotted, it looks like all samples until zoomed in.
+ * Groups with fewer samples have no overview, since loading all of them is as quick.
+ * @return 0 if everything was ok<br> <0 if something was wrong
+ */
+int DBConnector::_insertDataOverviewToDB(QSqlDatabase & db, const std::vector<double> &data, const std::vector<double> &time, const int dataGroupID) {
+    const size_t n = std::min(data.size(), time.size());
+    if (n <= DB_OVERVIEW_POINTS) return 0;
+
+    const size_t buckets = DB_OVERVIEW_POINTS/2;
+    std::vector<double> otime, ovalue;
+    otime.reserve(DB_OVERVIEW_POINTS);
+    ovalue.reserve(DB_OVERVIEW_POINTS);
+    for (size_t b = 0; b < buckets; ++b) {
+        const size_t lo = b*n/buckets;
+        const size_t hi = (b + 1)*n/buckets;
+        size_t kmin = n, kmax = n;
+        for (size_t k = lo; k < hi; ++k) {
+            if (isnan(data[k])) continue;
+            if (kmin == n || data[k] < data[kmin]) kmin = k;
+            if (kmax == n || data[k] > data[kmax]) kmax = k;
+        }
+        if (kmin == n) continue; // all NAN
+        const size_t first = std::min(kmin, kmax);
+        const size_t second = std::max(kmin, kmax);
+        otime.push_back(time[first]);
+        ovalue.push_back(data[first]);
+        if (second != first) {
+            otime.push_back(time[second]);
+            ovalue.push_back(data[second]);
+        }
+    }
+    if (otime.empty()) return 0;
+
+    QSqlQuery qry(db);
+    if (!qry.prepare("INSERT INTO dataOverview (DATAGROUP_ID,N,TIMES,VALS) VALUES (?,?,?,?);")) {
+        std::cerr << "Error occured during preparation of Query: "<<qry.lastError().text().toStdString() << std::endl;
+        return -3;
+    }
+    const int bytes = otime.size()*sizeof(double);
+    qry.addBindValue(dataGroupID);
+    qry.addBindValue((unsigned int)otime.size());
+    qry.addBindValue(qCompress(QByteArray::fromRawData((const char*) &otime[0], bytes)));
+    qry.addBindValue(qCompress(QByteArray::fromRawData((const char*) &ovalue[0], bytes)));
+    if (!qry.exec()) {
+        std::cerr << "Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
+        return -3;
+    }
+    return 0;
+}
+
+bool DBConnector::decodeDataChunk(const QByteArray & times, const QByteArray & vals, unsigned int n, std::vector<double> & time,
+                                  std::vector<double> & value, double tmin, double tmax) {
+    const QByteArray t = qUncompress(times);
+    const QByteArray v = qUncompress(vals);
+    const int bytes = n*sizeof(double);
+    if (t.size() != bytes || v.size() != bytes) {
+        return false;
+    }
+    const size_t n0 = time.size();
+    time.resize(n0 + n);
+    value.resize(n0 + n);
+    if (n == 0) return true;
+    memcpy(&time[n0], t.constData(), bytes);
+    memcpy(&value[n0], v.constData(), bytes);
+    if (tmin == -INFINITY && tmax == INFINITY) return true;
+    size_t j = n0;
+    for (size_t k = n0; k < n0 + n; ++k) {
+        if (time[k] < tmin || time[k] > tmax) continue;
+        time[j] = time[k];
+        value[j] = value[k];
+        j++;
+    }
+    time.resize(j);
+    value.resize(j);
+    return true;
+}
+
+template <typename T>
+static bool _appendColumns(Data*data, const double*time, const double*value, size_t n) {
+    DataTimeseries<T>*const ts = dynamic_cast<DataTimeseries<T>*>(data);
+    if (!ts) return false;
+    ts->add_elems(value, time, n);
+    return true;
+}
+
+/**
+ * @brief append samples of one data group to the data class object. The type is resolved
+ * once, and time series take all samples at once.
+ * @return true on success, else false
+ */
+bool DBConnector::_populateDataColumns(const std::vector<double> & time, const std::vector<double> & value,
+                                       const event_names_t & events, Data*data) {
+    if (!data) return false;
+    const size_t n = std::min(time.size(), value.size());
+    if (n == 0) return true;
+    if (_appendColumns<float>(data, &time[0], &value[0], n) ||
+        _appendColumns<double>(data, &time[0], &value[0], n) ||
+        _appendColumns<unsigned int>(data, &time[0], &value[0], n) ||
+        _appendColumns<int>(data, &time[0], &value[0], n)) {
+        return true;
+    }
+    // params and events have few samples
+    bool ok = true;
+    for (size_t k = 0; k < n; ++k) {
+        ok = _populateDataItem(time[k], value[k], events, data) && ok;
+    }
+    return ok;
+}
+
 /**
  * @brief put a single data row from database into the data class object
  * @param sys
  * @param qry already-executed query
  * @return rue on success, else false
  */
-bool DBConnector::_populateDataItem(double time, double value, const std::map<double,std::string> & events, Data*data) {
+bool DBConnector::_populateDataItem(double time, double value, const event_names_t & events, Data*data) {
     if (!data) return false;
 
     // walk through data types
@@ -951,9 +2002,9 @@ bool DBConnector::_populateDataItem(double time, double value, const std::map<do
     }
     DataEvent<std::string> *dataSE = dynamic_cast<DataEvent<std::string> *>(data);
     if (dataSE) {
-        std::map<double, std::string>::const_iterator it = events.find(value);
+        event_names_t::const_iterator it = events.find(value);
         if(it != events.end()) {
-            dataSE->add_elem(it->second,time);
+            dataSE->add_stored(it->second,time);
             return true;
         } else {
             std::cerr << "Error during import of DataEvent: EventID not Found in events Database"<<std::endl;
@@ -1007,7 +2058,8 @@ Data* DBConnector::_fetchDataGroup(MavSystem*sys, const std::string& type, const
 
 
 int DBConnector::loadScenarioFromDB(const int id, MavlinkScenario &scenario, DialogProgressBar*progress) {
-    struct dbBinder dbBind(&_db);
+    ProfileScope prof("db load");
+    struct dbBinder dbBind(&_db, _connection.empty(), _backend);
     if( dbBind.error ) {
         return -1;
     }
@@ -1040,6 +2092,14 @@ bool DBConnector::_populateScenario(MavlinkScenario&scenario, QSqlQuery& qry) {
     scenario.setDescription(qry.value(qry.record().indexOf("DESCRIPTION")).toString().toStdString());
     scenario.setName(qry.value(qry.record().indexOf("FILENAME")).toString().toStdString());
     scenario.setDatabaseID(qry.value(qry.record().indexOf("ID")).toULongLong());
+    if (_hasFingerprintTable()) {
+        // so that the same log is not added again, and saving it again finds this one
+        QSqlQuery qfp = prepared(_db, "SELECT FINGERPRINT FROM scenarioFingerprints WHERE SCENARIO_ID=:id;");
+        qfp.bindValue(":id", qry.value(qry.record().indexOf("ID")).toULongLong());
+        if (qfp.exec()) {
+            while (qfp.next()) scenario.add_fingerprint(qfp.value(0).toString().toStdString());
+        }
+    }
     return true;
 }
 
@@ -1057,7 +2117,7 @@ bool DBConnector::_populateDataGroup_deferred(MavSystem*/*sys*/, Data*d, unsigne
 
 int maybe_later_useful() {
 #if 0
-    QSqlQuery qry;
+    QSqlQuery qry(_db);
     qry.prepare("SELECT * FROM data WHERE DATAGROUP_ID=:did;");
     qry.bindValue(":did", datagroup_id);
     if( !qry.exec() ) {
@@ -1079,19 +2139,29 @@ int maybe_later_useful() {
 
 
 bool DBConnector::loadDataGroup(Data*d, DialogProgressBar*dlgprogress) {
+    return _loadDataGroup(d, false, 0., 0., dlgprogress);
+}
+
+bool DBConnector::loadDataGroup(Data*d, double tmin, double tmax, DialogProgressBar*dlgprogress) {
+    return _loadDataGroup(d, true, tmin, tmax, dlgprogress);
+}
+
+/**
+ * @brief fetch the samples of one data group
+ * @param windowed if true, only those in [tmin, tmax]
+ */
+bool DBConnector::_loadDataGroup(Data*d, bool windowed, double tmin, double tmax, DialogProgressBar*dlgprogress) {
     if (!d) return false;
-    struct dbBinder dbBind(&_db);
+    TraceScope trace("db load group");
+    struct dbBinder dbBind(&_db, _connection.empty(), _backend);
     if( dbBind.error ) {
         return false;
     };
 
-    QSqlQuery qry;
-    qry.setForwardOnly(true);
-
     /***********************************************
      * need the event map only if data type is event
      ***********************************************/
-    std::map<double,std::string> revents;
+    event_names_t revents;
     if (dynamic_cast<DataEvent<std::string> *>(d)) {
         cerr << "Data is of type EVENT...fetching event map." << endl;
         if (_getReverseEventsFromDB(revents)) {
@@ -1100,53 +2170,191 @@ bool DBConnector::loadDataGroup(Data*d, DialogProgressBar*dlgprogress) {
         }
     }
 
-    /*****************************
-     * fetch data of the group
-     *****************************/
+    std::vector<double> time, value;
+    if (!_fetchSamples(d, windowed, tmin, tmax, time, value, dlgprogress)) {
+        return false;
+    }
+    if (windowed || d->is_overview()) _clearKeepingEpoch(d);
+    if (!_populateDataColumns(time, value, revents, d)) {
+        cerr << "ERROR populating data of " << d->get_name() << std::endl;
+    }
+    if (!windowed) d->set_overview(false);
+    return true;
+}
+
+/**
+ * @brief empty the data, which forgets its start time, too. But that comes from table
+ * dataGroups and is not fetched again.
+ */
+void DBConnector::_clearKeepingEpoch(Data*d) {
+    const unsigned long epoch_usec = d->get_epoch_datastart();
+    d->clear();
+    d->set_epoch_datastart(epoch_usec);
+}
+
+/**
+ * @brief fetch the samples of one data group from table dataChunks or table data, into columns
+ * @param windowed if true, only those in [tmin, tmax]
+ */
+bool DBConnector::_fetchSamples(const Data*d, bool windowed, double tmin, double tmax, std::vector<double> & time,
+                                std::vector<double> & value, DialogProgressBar*dlgprogress) {
+    QSqlQuery qry(_db);
     const long long datagroupID = d->_dbid;
     double runtime = get_time_secs();
-    qry.prepare("SELECT * from data WHERE DATAGROUP_ID=:did;");
+    if (!windowed) {
+        tmin = -INFINITY;
+        tmax = INFINITY;
+    }
+    if (_hasChunkTable()) {
+        if (windowed) {
+            qry = prepared(_db, "SELECT N,TIMES,VALS from dataChunks WHERE DATAGROUP_ID=:did AND TIME_MAX>=:tmin AND TIME_MIN<=:tmax ORDER BY SEQ;");
+            qry.bindValue(":tmin", tmin);
+            qry.bindValue(":tmax", tmax);
+        } else {
+            qry = prepared(_db, "SELECT N,TIMES,VALS from dataChunks WHERE DATAGROUP_ID=:did ORDER BY SEQ;");
+        }
+        qry.bindValue(":did", datagroupID);
+        // a window may have no chunk, although the group was saved as chunks. And not every
+        // driver knows the number of rows up front.
+        bool chunked = qry.exec();
+        const int rows = chunked ? qry.size() : 0;
+        chunked = chunked && (rows > 0 || ((windowed || rows < 0) && _hasChunks(datagroupID)));
+        if (chunked) {
+            const unsigned long TOTAL = (rows > 0) ? rows : 1;
+            unsigned long cnt = 0;
+            time.reserve(time.size() + (size_t)TOTAL*DB_CHUNK_SAMPLES);
+            value.reserve(value.size() + (size_t)TOTAL*DB_CHUNK_SAMPLES);
+            while (qry.next()) {
+                if (dlgprogress && rows > 0) dlgprogress->setValue(cnt*100 / TOTAL, 100);
+                cnt++;
+                const unsigned int n = qry.value(0).toUInt();
+                if (!decodeDataChunk(qry.value(1).toByteArray(), qry.value(2).toByteArray(), n, time, value, tmin, tmax)) {
+                    cerr << "ERROR populating data chunk " << cnt << " of " << d->get_name() << std::endl;
+                    continue;
+                }
+            }
+            runtime = get_time_secs() - runtime;
+            cout << d->get_name() << ": " << time.size() << " samples in " << cnt << " chunks fetched in "<< runtime << "s" << endl;
+            return true;
+        }
+        qry.finish(); // saved as rows
+    }
+    if (windowed) {
+        qry = prepared(_db, "SELECT TIME,VALUE from data WHERE DATAGROUP_ID=:did AND TIME BETWEEN :tmin AND :tmax;");
+        qry.bindValue(":tmin", tmin);
+        qry.bindValue(":tmax", tmax);
+    } else {
+        qry = prepared(_db, "SELECT TIME,VALUE from data WHERE DATAGROUP_ID=:did;");
+    }
     qry.bindValue(":did", datagroupID);
     if (!qry.exec()) {
         cerr << "Could not retrieve data for datagroup " << d->get_name() << " from database" << endl;
         return false;
     }
 
-    const unsigned int indexTIME = qry.record().indexOf("TIME");
-    const unsigned int indexVALUE = qry.record().indexOf("VALUE");
-
+    // the driver knows the number of rows up front, so the columns are allocated once
     unsigned long cnt=0;
     unsigned int progress = 0, progress_pre = 0;
-    const unsigned long TOTAL = qry.size();
+    const unsigned long TOTAL = qry.size() > 0 ? qry.size() : 0;
+    time.reserve(time.size() + TOTAL);
+    value.reserve(value.size() + TOTAL);
     while (qry.next()) {
         // update progress
-        progress = (int)(cnt*100 / TOTAL);
-        if ((progress > progress_pre) || (cnt==0)) {
-            if (dlgprogress) {
-                dlgprogress->setValue(progress, 100);
-            } else {
-                cout << "  ..." << progress << "%" << flush << std::endl;
+        if (TOTAL > 0) {
+            progress = (int)(cnt*100 / TOTAL);
+            if ((progress > progress_pre) || (cnt==0)) {
+                if (dlgprogress) {
+                    dlgprogress->setValue(progress, 100);
+                } else {
+                    cout << "  ..." << progress << "%" << flush << std::endl;
+                }
                 progress_pre = progress;
             }
         }
         cnt++;
         // --
-        const double time = qry.value(indexTIME).toDouble();
-        const double value = qry.value(indexVALUE).toDouble();
-        if (!_populateDataItem(time, value, revents, d)) {
-            cerr << "ERROR populating data item " << d->get_name() << std::endl;
-            continue;
-        }
+        time.push_back(qry.value(0).toDouble());
+        value.push_back(qry.value(1).toDouble());
     }
     runtime = get_time_secs() - runtime;
     cout << d->get_name() << ": " << cnt << " rows fetched in "<< runtime << "s" << endl;
+    return true;
+}
 
+/**
+ * @brief the overview of one data group from table dataOverview
+ * @return false if it has none
+ */
+bool DBConnector::_fetchOverview(const Data*d, std::vector<double> & time, std::vector<double> & value) {
+    if (!_hasOverviewTable()) return false;
+    QSqlQuery qry = prepared(_db, "SELECT N,TIMES,VALS from dataOverview WHERE DATAGROUP_ID=:did;");
+    qry.bindValue(":did", d->_dbid);
+    if (!qry.exec() || !qry.next()) return false;
+    const unsigned int n = qry.value(0).toUInt();
+    if (!decodeDataChunk(qry.value(1).toByteArray(), qry.value(2).toByteArray(), n, time, value, -INFINITY, INFINITY)) {
+        cerr << "ERROR decoding overview of " << d->get_name() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool DBConnector::loadDataOverview(Data*d) {
+    if (!d || dynamic_cast<DataEvent<std::string> *>(d)) return false;
+    struct dbBinder dbBind(&_db, _connection.empty(), _backend);
+    if( dbBind.error ) {
+        return false;
+    };
+    std::vector<double> time, value;
+    if (!_fetchOverview(d, time, value)) return false;
+    _clearKeepingEpoch(d);
+    if (!_populateDataColumns(time, value, event_names_t(), d)) {
+        cerr << "ERROR populating overview of " << d->get_name() << std::endl;
+        return false;
+    }
+    d->set_overview(true);
+    return true;
+}
+
+bool DBConnector::loadDataDetail(Data*d, double tmin, double tmax, DialogProgressBar*dlgprogress) {
+    if (!d || !d->is_overview()) return false;
+    struct dbBinder dbBind(&_db, _connection.empty(), _backend);
+    if( dbBind.error ) {
+        return false;
+    };
+    std::vector<double> otime, ovalue, time, value;
+    if (!_fetchOverview(d, otime, ovalue) || !_fetchSamples(d, true, tmin, tmax, time, value, dlgprogress)) {
+        return false;
+    }
+
+    // overview before the window, all samples in it, overview after it
+    std::vector<double> mtime, mvalue;
+    mtime.reserve(otime.size() + time.size());
+    mvalue.reserve(otime.size() + time.size());
+    size_t k = 0;
+    for (; k < otime.size() && otime[k] < tmin; ++k) {
+        mtime.push_back(otime[k]);
+        mvalue.push_back(ovalue[k]);
+    }
+    mtime.insert(mtime.end(), time.begin(), time.end());
+    mvalue.insert(mvalue.end(), value.begin(), value.end());
+    for (; k < otime.size(); ++k) {
+        if (otime[k] <= tmax) continue;
+        mtime.push_back(otime[k]);
+        mvalue.push_back(ovalue[k]);
+    }
+
+    _clearKeepingEpoch(d);
+    if (!_populateDataColumns(mtime, mvalue, event_names_t(), d)) {
+        cerr << "ERROR populating data of " << d->get_name() << std::endl;
+        return false;
+    }
+    d->set_overview(true, tmin, tmax);
     return true;
 }
 
 bool DBConnector::loadDataGroup(MavSystem*sys, unsigned long long datagroupID, DialogProgressBar*dlgprogress) {
     if (!sys) return false;
-    struct dbBinder dbBind(&_db);
+    struct dbBinder dbBind(&_db, _connection.empty(), _backend);
     if( dbBind.error ) {
         return false;
     };
@@ -1154,9 +2362,7 @@ bool DBConnector::loadDataGroup(MavSystem*sys, unsigned long long datagroupID, D
     /********************************************
      * fetch details of the group and create it
      ********************************************/
-    QSqlQuery qry;
-    qry.setForwardOnly(true);
-    qry.prepare("SELECT * from dataGroups WHERE ID=:did LIMIT 1;");
+    QSqlQuery qry = prepared(_db, "SELECT * from dataGroups WHERE ID=:did LIMIT 1;");
     qry.bindValue(":did", datagroupID);
     if (!qry.exec()) {
         return false;
@@ -1193,7 +2399,7 @@ bool DBConnector::loadDataGroup(MavSystem*sys, unsigned long long datagroupID, D
     /***********************************************
      * need the event map only if data type is event
      ***********************************************/
-    std::map<double,std::string> revents;
+    event_names_t revents;
     if (dynamic_cast<DataEvent<std::string> *>(d)) {
         cerr << "Data is of type EVENT...fetching event map." << endl;
         if (_getReverseEventsFromDB(revents)) {
@@ -1250,12 +2456,10 @@ bool DBConnector::loadDataGroup(MavSystem*sys, unsigned long long datagroupID, D
  * @param qry2 already-executed query holding a join of dataGroups and data belonging to sys
  * @return tue on success, else false
  */
-bool DBConnector::_populateAllDataGroups_immediate(MavSystem*sys, const std::map<double,std::string>& events) {
+bool DBConnector::_populateAllDataGroups_immediate(MavSystem*sys, const event_names_t& events) {
     if (!sys) return false;
 
-    QSqlQuery qry;
-    qry.setForwardOnly(true);
-    qry.prepare("SELECT * from dataGroups INNER JOIN data on data.DATAGROUP_ID=dataGroups.ID where dataGroups.SYSTEM_ID=:sid;");
+    QSqlQuery qry = prepared(_db, "SELECT * from dataGroups INNER JOIN data on data.DATAGROUP_ID=dataGroups.ID where dataGroups.SYSTEM_ID=:sid;");
     qry.bindValue(":sid", (qulonglong)sys->_dbid);
     if (!qry.exec()) {
         return false;
@@ -1273,11 +2477,18 @@ bool DBConnector::_populateAllDataGroups_immediate(MavSystem*sys, const std::map
     unsigned long long last_datagroup_id=0;
     unsigned long nrec=0;
 
+    // samples of the current group are collected, and handed over when the group changes
     Data*d = NULL;
+    std::vector<double> time, value;
     while (qry.next()) {
         const unsigned long long datagroup_id = qry.value(idxGROUPID).toULongLong();
-        string path =  qry.value(idxPATH).toString().toStdString();
         if ((nrec==0) || ( datagroup_id != last_datagroup_id)) {
+            if (d && !_populateDataColumns(time, value, events, d)) {
+                cerr << "ERROR populating data of " << d->get_name() << " for MAV system #" << sys->id << std::endl;
+            }
+            time.clear();
+            value.clear();
+            const string path =  qry.value(idxPATH).toString().toStdString();
             const string type =  qry.value(idxTYPE).toString().toStdString();
             const string units =  qry.value(idxUNITS).toString().toStdString();
             const uint64_t timeEpochDatastart = qry.value(idxTIMESTART).toULongLong();
@@ -1292,38 +2503,73 @@ bool DBConnector::_populateAllDataGroups_immediate(MavSystem*sys, const std::map
         }
         if (!d) continue;
 
-        const double time = qry.value(indexTIME).toDouble();
-        const double value = qry.value(indexVALUE).toDouble();
-        if (!_populateDataItem(time, value, events, d)) {
-            cerr << "ERROR populating data item " << path << " for MAV system #" << sys->id << std::endl;
-            continue;
-        }
+        time.push_back(qry.value(indexTIME).toDouble());
+        value.push_back(qry.value(indexVALUE).toDouble());
         nrec++;
     }
+    if (d && !_populateDataColumns(time, value, events, d)) {
+        cerr << "ERROR populating data of " << d->get_name() << " for MAV system #" << sys->id << std::endl;
+    }
     cout << nrec << " records done." << endl << flush;
+
+    // groups saved as chunks have no rows in data
+    if (!_hasChunkTable()) return true;
+    qry = prepared(_db, "SELECT dataGroups.FULLPATH,dataGroups.TYPE,dataGroups.UNITS,dataGroups.TIME_EPOCH_DATASTART,"
+                "dataChunks.DATAGROUP_ID,dataChunks.N,dataChunks.TIMES,dataChunks.VALS "
+                "from dataGroups INNER JOIN dataChunks on dataChunks.DATAGROUP_ID=dataGroups.ID where dataGroups.SYSTEM_ID=:sid "
+                "ORDER BY dataChunks.DATAGROUP_ID,dataChunks.SEQ;");
+    qry.bindValue(":sid", (qulonglong)sys->_dbid);
+    if (!qry.exec()) {
+        return false;
+    }
+    unsigned long nchunks = 0;
+    last_datagroup_id = 0;
+    d = NULL;
+    time.clear();
+    value.clear();
+    while (qry.next()) {
+        const unsigned long long datagroup_id = qry.value(4).toULongLong();
+        const string path = qry.value(0).toString().toStdString();
+        if ((nchunks == 0) || (datagroup_id != last_datagroup_id)) {
+            if (d && !_populateDataColumns(time, value, events, d)) {
+                cerr << "ERROR populating data of " << d->get_name() << " for MAV system #" << sys->id << std::endl;
+            }
+            time.clear();
+            value.clear();
+            cout << "Loading group " << path << "..." << endl;
+            d = _fetchDataGroup(sys, qry.value(1).toString().toStdString(), path, qry.value(2).toString().toStdString());
+            if (d) {
+                d->set_epoch_datastart(qry.value(3).toULongLong());
+            } else {
+                cerr << "ERROR getting/creating data group " << path << " for MAV system #" << sys->id << std::endl;
+            }
+            last_datagroup_id = datagroup_id;
+        }
+        nchunks++;
+        if (!d) continue;
+        if (!decodeDataChunk(qry.value(6).toByteArray(), qry.value(7).toByteArray(), qry.value(5).toUInt(), time, value, -INFINITY, INFINITY)) {
+            cerr << "ERROR populating data chunk of " << path << " for MAV system #" << sys->id << std::endl;
+        }
+    }
+    if (d && !_populateDataColumns(time, value, events, d)) {
+        cerr << "ERROR populating data of " << d->get_name() << " for MAV system #" << sys->id << std::endl;
+    }
+    cout << nchunks << " chunks done." << endl << flush;
     return true;
 }
 
 
 /**
- * @brief get the event table from the databse and reverse it: yields a map double -> string
+ * @brief get the event table from the databse and reverse it: yields a map DB id -> EventDict id
  * @param events
  * @return 0 on success, else error code
  */
-int DBConnector::_getReverseEventsFromDB(std::map<double,std::string> &events) {
-    // need events
-    double maxEventID;
-    std::map<std::string, double> eventsTmp;
-
-    int success = _getEventsFromDB(eventsTmp,maxEventID);
+int DBConnector::_getReverseEventsFromDB(event_names_t &events) {
+    const int success = _syncEventsFromDB(NULL, &events, NULL);
     if(success < 0) {
         std::cerr << "WARNING: error occured during select of Events from DB: "<< success << std::endl;
         return -1;
     }
-    //rebuild map TODO: what is happening here????
-    for(std::map<std::string,double>::const_iterator it = eventsTmp.begin(); it != eventsTmp.end(); ++it) {
-        events.insert(std::pair<double,std::string>(it->second,it->first));
-    }
     return 0;
 }
 
@@ -1337,7 +2583,7 @@ int DBConnector::_getReverseEventsFromDB(std::map<double,std::string> &events) {
 int DBConnector::_populateDataGroups(MavSystem*sys, QSqlQuery& qry2) {
     if (!sys) return -1;
 
-    std::map<double,std::string> events;
+    event_names_t events;
     if (!_deferredLoad) {
         if (_getReverseEventsFromDB(events)) {
             cerr << "ERROR fetching event map from database." << std::endl;
@@ -1387,8 +2633,7 @@ int DBConnector::_loadScenarioFromDB(const int id, MavlinkScenario &scenario, Di
     /*****************************
      * LOAD SCENARIO INFO
      *****************************/    
-    QSqlQuery qry, qry2;
-    qry.prepare("SELECT * FROM scenarios WHERE ID=:id LIMIT 1;");
+    QSqlQuery qry = prepared(_db, "SELECT * FROM scenarios WHERE ID=:id LIMIT 1;");
     qry.bindValue(":id", id);
     if( !qry.exec() ) {
        std::cerr << "Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
@@ -1409,8 +2654,7 @@ int DBConnector::_loadScenarioFromDB(const int id, MavlinkScenario &scenario, Di
     /*******************************
      * FETCH ALL SYSTEMS IN SCENARIO
      *******************************/
-    qry.setForwardOnly(true);
-    qry.prepare("SELECT * FROM systems WHERE SCENARIO_ID=:id;");
+    qry = prepared(_db, "SELECT * FROM systems WHERE SCENARIO_ID=:id;");
     qry.bindValue(":id", id);
     if( !qry.exec() ) {
        std::cerr << "Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
@@ -1420,6 +2664,10 @@ int DBConnector::_loadScenarioFromDB(const int id, MavlinkScenario &scenario, Di
     unsigned int progress = 0, progress_pre = 0;
     const unsigned int TOTAL = qry.size();
     while (qry.next()) {
+        if (_canceled(dlgprogress)) {
+            std::cerr << "Loading canceled" << std::endl;
+            return -5;
+        }
         // update progress
         progress = (int)(cnt*100 / TOTAL);
         if ((progress > progress_pre) || (cnt==0)) {
@@ -1444,8 +2692,7 @@ int DBConnector::_loadScenarioFromDB(const int id, MavlinkScenario &scenario, Di
         /***************************************************
          * fetch datagroups of that MAV system
          ***************************************************/        
-        qry2.setForwardOnly(true);
-        qry2.prepare("SELECT * FROM dataGroups WHERE SYSTEM_ID=:dbid;");
+        QSqlQuery qry2 = prepared(_db, "SELECT * FROM dataGroups WHERE SYSTEM_ID=:dbid;");
         qry2.bindValue(":dbid", dbid);
         if( !qry2.exec() ) {
             std::cerr << "Error obtaining datagroups of system: "<< qry2.lastError().text().toStdString() << std::endl;
@@ -1465,6 +2712,240 @@ int DBConnector::_loadScenarioFromDB(const int id, MavlinkScenario &scenario, Di
     return 0;
 }
 
+/**
+ * @brief SQL NULL is NAN
+ */
+static double _nullable(const QVariant & v) {
+    return v.isNull() ? NAN : v.toDouble();
+}
+
+int DBConnector::aggregateFlights(const std::string & fullpath, std::vector<flight_stats_t> & flights) {
+    flights.clear();
+    struct dbBinder dbBind(&_db, _connection.empty(), _backend);
+    if( dbBind.error ) {
+        return -1;
+    }
+    ProfileScope prof("db aggregate");
+
+    // one row per flight, from the small tables only
+    const bool stats = _hasStatsTable();
+    QString str = "SELECT sys.SCENARIO_ID, g.ID, sys.SYSTEM_ID, sc.TIME_START, sc.FILENAME";
+    if (stats) str += ", st.N, st.VALUE_MIN, st.VALUE_MAX, st.VALUE_AVG, st.VALUE_STDDEV, st.TIME_MIN, st.TIME_MAX";
+    str += " FROM dataGroups g INNER JOIN systems sys ON sys.ID=g.SYSTEM_ID INNER JOIN scenarios sc ON sc.ID=sys.SCENARIO_ID";
+    if (stats) str += " LEFT JOIN dataGroupStats st ON st.DATAGROUP_ID=g.ID";
+    str += " WHERE g.FULLPATH=:datapath AND g.VALID=1 ORDER BY sc.TIME_START, sys.SYSTEM_ID;";
+    QSqlQuery qry = prepared(_db, str);
+    qry.bindValue(":datapath", QString::fromStdString(fullpath));
+    if( !qry.exec() ) {
+        std::cerr << "Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
+        return -1;
+    }
+    while (qry.next()) {
+        flight_stats_t f;
+        f.scenarioID = qry.value(0).toULongLong();
+        f.datagroupID = qry.value(1).toULongLong();
+        f.systemID = qry.value(2).toUInt();
+        f.started = qry.value(3).toString();
+        f.filename = qry.value(4).toString();
+        f.n = 0;
+        f.vmin = f.vmax = f.avg = f.stddev = f.t_min = f.t_max = NAN;
+        if (stats && !qry.value(5).isNull()) {
+            f.n = qry.value(5).toULongLong();
+            f.vmin = _nullable(qry.value(6));
+            f.vmax = _nullable(qry.value(7));
+            f.avg = _nullable(qry.value(8));
+            f.stddev = _nullable(qry.value(9));
+            f.t_min = _nullable(qry.value(10));
+            f.t_max = _nullable(qry.value(11));
+        }
+        flights.push_back(f);
+    }
+    if (_aggregateMissingStats(flights) < 0) return -1;
+
+    // groups without samples, e.g. events, are no flights to compare
+    std::vector<flight_stats_t> valid;
+    valid.reserve(flights.size());
+    for (std::vector<flight_stats_t>::const_iterator it = flights.begin(); it != flights.end(); ++it) {
+        if (it->n > 0) valid.push_back(*it);
+    }
+    flights.swap(valid);
+    return (int)flights.size();
+}
+
+/**
+ * @brief for the groups saved before table dataGroupStats existed: let the DB compute their
+ * statistics like install/backfill_stats.sql does, from the samples in table data or from
+ * the headers of the chunks. Chunks give no average and deviation.
+ */
+int DBConnector::_aggregateMissingStats(std::vector<flight_stats_t> & flights) {
+    std::map<unsigned long long, size_t> missing; // index in flights, by datagroup ID
+    for (size_t k = 0; k < flights.size(); ++k) {
+        if (flights[k].n == 0) missing[flights[k].datagroupID] = k;
+    }
+    if (missing.empty()) return 0;
+
+    const unsigned int passes = _hasChunkTable() ? 2 : 1;
+    std::map<unsigned long long, size_t>::const_iterator it = missing.begin();
+    while (it != missing.end()) {
+        std::vector<unsigned long long> ids;
+        for (; it != missing.end() && ids.size() < DB_AGGREGATE_BATCH; ++it) {
+            ids.push_back(it->first);
+        }
+        QString groups;
+        for (unsigned int k = 0; k < ids.size(); ++k) {
+            if (k > 0) groups += ",";
+            groups += "?";
+        }
+        for (unsigned int pass = 0; pass < passes; ++pass) {
+            const QString str = (pass == 0) ?
+                "SELECT DATAGROUP_ID, COUNT(*), MIN(VALUE), MAX(VALUE), AVG(VALUE), " + _backend->stddevPop("VALUE") + ", MIN(TIME), MAX(TIME) "
+                "FROM data WHERE DATAGROUP_ID IN (" + groups + ") GROUP BY DATAGROUP_ID;" :
+                "SELECT DATAGROUP_ID, SUM(N), MIN(VALUE_MIN), MAX(VALUE_MAX), NULL, NULL, MIN(TIME_MIN), MAX(TIME_MAX) "
+                "FROM dataChunks WHERE DATAGROUP_ID IN (" + groups + ") GROUP BY DATAGROUP_ID;";
+            QSqlQuery qry(_db);
+            qry.setForwardOnly(true);
+            if (!qry.prepare(str)) return -1;
+            for (unsigned int k = 0; k < ids.size(); ++k) {
+                qry.bindValue(k, (qulonglong)ids[k]);
+            }
+            if( !qry.exec() ) {
+                std::cerr << "Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
+                return -1;
+            }
+            while (qry.next()) {
+                std::map<unsigned long long, size_t>::const_iterator m = missing.find(qry.value(0).toULongLong());
+                if (m == missing.end()) continue;
+                flight_stats_t & f = flights[m->second];
+                if (f.n > 0) continue; // has samples in table data
+                f.n = qry.value(1).toULongLong();
+                f.vmin = _nullable(qry.value(2));
+                f.vmax = _nullable(qry.value(3));
+                f.avg = _nullable(qry.value(4));
+                f.stddev = _nullable(qry.value(5));
+                f.t_min = _nullable(qry.value(6));
+                f.t_max = _nullable(qry.value(7));
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief bin of value v, where the first and the last bin extend to infinity
+ */
+static unsigned int _binOf(double v, double lo, double width, unsigned int nbins) {
+    const double b = floor((v - lo) / width);
+    if (!(b > 0.)) return 0;
+    if (b >= nbins - 1) return nbins - 1;
+    return (unsigned int)b;
+}
+
+double DBConnector::aggregateHistogram(const std::string & fullpath, double lo, double hi, unsigned int nbins,
+                                       std::vector<double> & counts, bool & approximate) {
+    counts.assign(nbins, 0.);
+    approximate = false;
+    if (nbins == 0 || !(hi > lo)) return -1;
+    struct dbBinder dbBind(&_db, _connection.empty(), _backend);
+    if( dbBind.error ) {
+        return -1;
+    }
+    ProfileScope prof("db aggregate");
+    const double width = (hi - lo) / nbins;
+    const QString datapath = QString::fromStdString(fullpath);
+    double total = 0.;
+
+    // samples in table data: the DB counts them per bin, only nbins rows come back
+    QSqlQuery qry = prepared(_db, "SELECT " + _backend->clamp(_backend->floor("(d.VALUE - :lo) / :width"), "0", ":last") +
+                                  " AS bin, COUNT(*) FROM data d "
+                                  "INNER JOIN dataGroups g ON g.ID=d.DATAGROUP_ID WHERE g.FULLPATH=:datapath AND g.VALID=1 GROUP BY bin;");
+    qry.bindValue(":lo", lo);
+    qry.bindValue(":width", width);
+    qry.bindValue(":last", nbins - 1);
+    qry.bindValue(":datapath", datapath);
+    if( !qry.exec() ) {
+        std::cerr << "Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
+        return -1;
+    }
+    while (qry.next()) {
+        if (qry.value(0).isNull()) continue;
+        const double c = qry.value(1).toDouble();
+        counts[_binOf(lo + (qry.value(0).toDouble() + .5) * width, lo, width, nbins)] += c;
+        total += c;
+    }
+
+    // compressed samples: only the headers of the chunks are read, and each chunk's count
+    // is spread over its value range
+    if (_hasChunkTable()) {
+        QSqlQuery qry2 = prepared(_db, "SELECT c.N, c.VALUE_MIN, c.VALUE_MAX FROM dataChunks c "
+                                       "INNER JOIN dataGroups g ON g.ID=c.DATAGROUP_ID WHERE g.FULLPATH=:datapath AND g.VALID=1;");
+        qry2.bindValue(":datapath", datapath);
+        if( !qry2.exec() ) {
+            std::cerr << "Error occured during execution of Query: "<<qry2.lastError().text().toStdString() << std::endl;
+            return -1;
+        }
+        while (qry2.next()) {
+            const double n = qry2.value(0).toDouble();
+            const double cmin = _nullable(qry2.value(1));
+            const double cmax = _nullable(qry2.value(2));
+            if (!(n > 0.) || isnan(cmin) || isnan(cmax)) continue;
+            approximate = true;
+            total += n;
+            const unsigned int b0 = _binOf(cmin, lo, width, nbins);
+            const unsigned int b1 = _binOf(cmax, lo, width, nbins);
+            if (b0 == b1 || !(cmax > cmin)) {
+                counts[b0] += n;
+                continue;
+            }
+            for (unsigned int b = b0; b <= b1; ++b) {
+                const double from = (b == 0) ? cmin : std::max(cmin, lo + b*width);
+                const double to = (b == nbins - 1) ? cmax : std::min(cmax, lo + (b + 1)*width);
+                if (to > from) counts[b] += n * (to - from) / (cmax - cmin);
+            }
+        }
+    }
+    return total;
+}
+
+double DBConnector::percentileOfHistogram(const std::vector<double> & counts, double lo, double hi, double p) {
+    double total = 0.;
+    for (unsigned int b = 0; b < counts.size(); ++b) total += counts[b];
+    if (!(total > 0.)) return NAN;
+    const double width = (hi - lo) / counts.size();
+    const double want = p * total;
+    double acc = 0.;
+    for (unsigned int b = 0; b < counts.size(); ++b) {
+        if (counts[b] > 0. && acc + counts[b] >= want) {
+            return lo + (b + (want - acc) / counts[b]) * width;
+        }
+        acc += counts[b];
+    }
+    return hi;
+}
+
+bool DBConnector::open(void) {
+    struct dbBinder dbBind(&_db, true, _backend);
+    return !dbBind.error;
+}
+
+/**
+ * @brief transactions of single steps, which are left out while saveScenarioToDB() has
+ * one for all of them on _db
+ */
+bool DBConnector::_begin(QSqlDatabase & db) {
+    if (_bulk && db.connectionName() == _db.connectionName()) return true;
+    return db.transaction();
+}
+
+bool DBConnector::_commit(QSqlDatabase & db) {
+    if (_bulk && db.connectionName() == _db.connectionName()) return true;
+    return db.commit();
+}
+
+bool DBConnector::_rollback(QSqlDatabase & db) {
+    if (_bulk && db.connectionName() == _db.connectionName()) return true; // all of it is undone in the end
+    return db.rollback();
+}
+
 QSqlDatabase DBConnector::getDB() {
     return _db;
 }
@@ -22,6 +22,8 @@
 #include "data_param.h"
 #include "data_event.h"
 #include "dialogprogressbar.h"
+#include "eventdict.h"
+#include "dbbackend.h"
 
 /// Class to import and export scenarios from and to the db
 class DBConnector {
@@ -34,15 +36,40 @@ public:
         std::string username;
         std::string password;
         std::string dbhost;
-        std::string dbname;
+        std::string dbname;  ///< or the file, for DB_BACKEND_SQLITE
+        std::string backend; ///< see DBBackend::get(). Empty=MySQL
     } db_props_t;
 
+    typedef std::map<EventDict::id_t,double> event_ids_t;   ///< ID in table events, by EventDict id
+    typedef std::map<double,EventDict::id_t> event_names_t; ///< EventDict id, by ID in table events
+
     typedef enum {
         SAVE_ERROR = -1,    ///< error during save
         SAVE_SUCCESS = 0,   ///< saved new entry
         SAVE_UPDATED = 1    ///< updated existing entry
     } save_res_e;
 
+    typedef enum {
+        SIMILAR_ASK,        ///< ask the user with a message box. GUI thread only.
+        SIMILAR_INSERT,     ///< insert as new scenario anyway
+        SIMILAR_UPDATE      ///< update the existing scenario
+    } similar_e;
+
+    /**
+     * @brief summary of one data group, i.e. one path in one flight, see aggregateFlights()
+     */
+    typedef struct flight_stats_s {
+        unsigned long long scenarioID;
+        unsigned long long datagroupID;
+        unsigned int       systemID;   ///< MAV system id
+        QString            started;    ///< TIME_START of the scenario
+        QString            filename;   ///< FILENAME of the scenario
+        unsigned long      n;          ///< number of samples
+        double             vmin, vmax;
+        double             avg, stddev; ///< NAN if unknown, e.g. compressed samples without statistics
+        double             t_min, t_max;
+    } flight_stats_t;
+
     /********************************
      *  METHODS
      ********************************/
@@ -50,15 +77,25 @@ public:
     /**
      * @brief ctor
      * @param args contains login data and maxTimeJump
+     * @param connection name of the Qt connection. Empty=the pooled connection of the calling
+     *        thread, which stays open for the next DBConnector. Only for threads which live long,
+     *        like the GUI thread; others should give a name of their own.
      */
-    DBConnector(const db_props_t& args);
-    ~DBConnector() {}
+    DBConnector(const db_props_t& args, const std::string & connection = "");
+    ~DBConnector();
     /**
      * @brief getter for db object, that contains all login data
      * @return db object, that contains all login data
      */
     QSqlDatabase getDB();
 
+    /**
+     * @brief open the connection (see getDB()) if it is not yet, and keep it open. A new local
+     * DB is set up then.
+     * @return false if it cannot be opened
+     */
+    bool open(void);
+
     /**
      * @brief imports Mavlog file to scenario in Order to save to DB
      * @param fileName with path
@@ -69,14 +106,25 @@ public:
     /**
      * @brief import an existing scenario to the DB
      * @param scen
+     * @param dlg progress. Saving stops if it was canceled, and what was saved so far is removed again.
+     * @param similar what to do if the DB has a similar scenario, see findSimilarScenario()
      * @return true on success, else false
      */
-    bool saveScenarioToDB(const MavlinkScenario*const scen, DialogProgressBar*dlg=NULL);
+    bool saveScenarioToDB(const MavlinkScenario*const scen, DialogProgressBar*dlg=NULL, similar_e similar=SIMILAR_ASK);
+
+    /**
+     * @brief check whether the DB has a scenario with the same start time, or one made from the same
+     * log files (see MavlinkScenario::get_fingerprints()), which saveScenarioToDB() would find
+     * @param name filename of that scenario
+     * @return <0 on error<br>0 if there is none<br>1 if there is one<br>2 if one was made from the same files
+     */
+    int findSimilarScenario(const MavlinkScenario*const scen, std::string & name);
 
     /**
      * @brief Returns scenario with all systems and their data
      * @param id scenario id in database
      * @param scenario this object will be filled with data from the database
+     * @param dlg progress. Loading stops if it was canceled.
      * @return <0: on error <br>0: else
      */
     int loadScenarioFromDB(const int id,MavlinkScenario &scenario, DialogProgressBar*dlg=NULL);
@@ -103,8 +151,31 @@ public:
      * @return true on success
      */
     bool loadDataGroup(Data*d, DialogProgressBar*dlgprogress);
+
+    /**
+     * @brief replace the samples of the given data by those between tmin and tmax, e.g.,
+     * to fetch details for the part of the plot which is shown
+     * @param tmin, tmax in the time of the data (as in the plot)
+     * @return true on success
+     */
+    bool loadDataGroup(Data*d, double tmin, double tmax, DialogProgressBar*dlgprogress = NULL);
     bool loadDataGroup(MavSystem*sys, unsigned long long datagroupID, DialogProgressBar*progress);
 
+    /**
+     * @brief replace the samples of the given data by its overview (table dataOverview), about
+     * 2000 points which keep the min and max of the samples. For a quick first plot.
+     * @return false if it has none, e.g., events, short series or saved before. Data is unchanged then.
+     */
+    bool loadDataOverview(Data*d);
+
+    /**
+     * @brief data which holds its overview gets all samples between tmin and tmax, and keeps
+     * the overview elsewhere, see Data::get_detail_window()
+     * @param tmin, tmax in the time of the data (as in the plot)
+     * @return true on success
+     */
+    bool loadDataDetail(Data*d, double tmin, double tmax, DialogProgressBar*dlgprogress = NULL);
+
     /**
      * @brief if true, then we use a faster but incomplete loading techique, where data may not be postprocessed fully
      * @param yesno
@@ -112,69 +183,188 @@ public:
     void setLazyLoad(bool yesno) { _deferredLoad = yesno; }
     bool getLazyLoad(void) const { return _deferredLoad; }
 
+    /**
+     * @brief how many connections save data groups at the same time
+     * @param n 1=all in calling thread, over one connection
+     */
+    void setSaveThreads(unsigned int n) { _saveThreads = (n > 0) ? n : 1; }
+
+    /**
+     * @brief a prepared statement for this SQL text on the given connection. For pooled
+     * connections it is prepared only once and then reused, saving a round trip each time.
+     * Only for SQL texts which do not change, and not while the same statement is still being read.
+     * @return the query, to be bound and executed. Copies share the prepared statement.
+     */
+    static QSqlQuery prepared(const QSqlDatabase & db, const QString & sql);
+
+    /**
+     * @brief whether the DB of that connection has the table. Remembered for pooled connections.
+     */
+    static bool hasTable(const QSqlDatabase & db, const QString & table);
+
+    /**
+     * @brief decompress one row of table dataChunks and append it to the given columns
+     * @param tmin, tmax only samples within these
+     * @return true on success, else false
+     */
+    static bool decodeDataChunk(const QByteArray & times, const QByteArray & vals, unsigned int n, std::vector<double> & time,
+                                std::vector<double> & value, double tmin, double tmax);
+
+    /**
+     * @brief summaries of the given path in all flights (scenarios and systems) of the DB,
+     * computed by the DB. Taken from table dataGroupStats where it has them, else from the
+     * headers of the chunks, else from the samples in table data. No samples are fetched.
+     * @param fullpath FULLPATH in table dataGroups, e.g. "airstate/airspeed"
+     * @param flights result, in order of scenario start time
+     * @return <0 on error, else the number of flights
+     */
+    int aggregateFlights(const std::string & fullpath, std::vector<flight_stats_t> & flights);
+
+    /**
+     * @brief distribution of the samples of the given path over all flights, counted by the DB
+     * @param lo, hi range of the bins. Samples outside are counted in the first or last bin.
+     * @param counts result: nbins samples counts
+     * @param approximate result: true if some samples are compressed in chunks, whose count is
+     *        spread evenly over the value range of each chunk
+     * @return <0 on error, else the number of samples
+     */
+    double aggregateHistogram(const std::string & fullpath, double lo, double hi, unsigned int nbins,
+                              std::vector<double> & counts, bool & approximate);
+
+    /**
+     * @brief the value below which the fraction p of the counts is, interpolated within the bin
+     * @param p in [0,1], e.g. 0.95
+     */
+    static double percentileOfHistogram(const std::vector<double> & counts, double lo, double hi, double p);
+
+
+
 private:
+    friend class DBSaveWorker;
+
+    /**
+     * @brief one data group to be saved by a DBSaveWorker
+     */
+    typedef struct {
+        const Data*         data;
+        int                 dataGroupID;
+        bool                converted; ///< string events are converted up front, since they need the event map
+        std::string         type;      ///< TYPE in table dataGroups
+        std::vector<double> values;
+        std::vector<double> time;
+    } save_job_t;
 
     /*******************************************
      * METHODS
      *******************************************/
 
+    static QSqlDatabase _pooledConnection(const db_props_t & props);
     int _getScenarioFromFile(const std::string fileName, MavlinkScenario &scenario);  
-    int _dbresult2completescenario(QSqlQuery & qry, MavlinkScenario &scenario, const std::map<double,std::string> & events, DialogProgressBar*dlg=NULL);
-    int _getEventsFromDB(std::map<std::string,double> &events, double &maxEventID);    
-    save_res_e _saveScenario2DB(const MavlinkScenario &scenario, DialogProgressBar *dlg=NULL);
-    int _saveSystem2DB(const MavSystem &sys, const int scenarioID, std::map<std::string, double> &events, std::map<std::string, double> &newEvents, double &maxEventID, DialogProgressBar*dlg=NULL);
-    int _saveData2DB(const Data &dat, const int systemID, std::map<std::string, double> &events, std::map<std::string, double> &newEvents, double &maxEventID);
-    int _saveEvents2DB(const std::map<std::string, double> &newEvents);
+    int _dbresult2completescenario(QSqlQuery & qry, MavlinkScenario &scenario, const event_names_t & events, DialogProgressBar*dlg=NULL);
+    int _getEventsFromDB(event_ids_t &events, double &maxEventID);    
+    save_res_e _saveScenario2DB(const MavlinkScenario &scenario, DialogProgressBar *dlg=NULL, similar_e similar=SIMILAR_ASK);
+    int _findSimilarScenario(const MavlinkScenario &scenario, QString & name, unsigned long long & id, unsigned long & n);
+    int _findIdenticalScenario(const MavlinkScenario &scenario, QString & name, unsigned long long & id);
+    int _saveFingerprints2DB(const MavlinkScenario &scenario, unsigned long long scenarioID);
+    int _deleteScenarioFromDB(unsigned long long scenarioID);
+    static bool _canceled(const DialogProgressBar*dlg) { return dlg && dlg->wasCanceled(); }
+    int _saveSystem2DB(const MavSystem &sys, const int scenarioID, event_ids_t &events, event_ids_t &newEvents, double &maxEventID, DialogProgressBar*dlg=NULL);
+    int _saveData2DB(const Data &dat, const int systemID, event_ids_t &events, event_ids_t &newEvents, double &maxEventID);
+    int _saveDataParallel2DB(const MavSystem &sys, const int systemID, event_ids_t &events, event_ids_t &newEvents, double &maxEventID, DialogProgressBar*dlg);
+    int _saveJob2DB(QSqlDatabase & db, save_job_t & job);
+    int _saveEvents2DB(const event_ids_t &newEvents);
+    int _syncEventsFromDB(event_ids_t * ids, event_names_t * names, double * maxEventID);
+    void _addEventsToCache(const event_ids_t &newEvents);
     int _insertScenarioToDB(const MavlinkScenario &scenario);
     int _updateScenarioInDB(const MavlinkScenario &scenario, unsigned long long existsID);
+    int _updateScenarioData(const MavlinkScenario &scenario, unsigned long long scenarioID, DialogProgressBar*dlg);
+    int _updateSystemInDB(const MavSystem &sys, unsigned long long systemID);
+    int _deleteDataGroupsFromDB(const std::vector<unsigned long long> & ids);
     unsigned long long _insertSystemToDB(const MavSystem &sys, const int scenarioID);
     int _insertDataGroupToDB(const Data &dat, const int systemID, const std::string type);
-    int _insertDataToDB(const std::vector<double> &data, const std::vector<double> &time, const int dataGroupID);
+    int _insertDataToDB(QSqlDatabase & db, const std::vector<double> &data, const std::vector<double> &time, const int dataGroupID);
+    int _insertDataChunksToDB(QSqlDatabase & db, const std::vector<double> &data, const std::vector<double> &time, const int dataGroupID);
+    int _insertDataGroupStatsToDB(const Data &dat, const int dataGroupID);
+    int _insertDataGroupHashToDB(QSqlDatabase & db, const std::string & hash, unsigned long n, const int dataGroupID);
+    static std::string _contentHash(const Data &dat, const std::string & type, const std::vector<double> &data, const std::vector<double> &time);
+    bool _hasChunkTable(void);
+    bool _hasStatsTable(void);
+    bool _hasOverviewTable(void);
+    bool _hasHashTable(void);
+    bool _hasFingerprintTable(void);
+    bool _hasChunks(unsigned long long datagroupID);
+    int _insertDataOverviewToDB(QSqlDatabase & db, const std::vector<double> &data, const std::vector<double> &time, const int dataGroupID);
+    bool _fetchSamples(const Data*d, bool windowed, double tmin, double tmax, std::vector<double> & time,
+                       std::vector<double> & value, DialogProgressBar*dlgprogress);
+    bool _fetchOverview(const Data*d, std::vector<double> & time, std::vector<double> & value);
+    static void _clearKeepingEpoch(Data*d);
+    bool _begin(QSqlDatabase & db);
+    bool _commit(QSqlDatabase & db);
+    bool _rollback(QSqlDatabase & db);
+    int _aggregateMissingStats(std::vector<flight_stats_t> & flights);
+    bool _loadDataGroup(Data*d, bool windowed, double tmin, double tmax, DialogProgressBar*dlgprogress);
     template <typename TT>
     void _convertTimeSeriesToDoubleVectorTemplate(const DataTimeseries<TT> &dat, std::vector<double> &data, std::vector<double> &time);
-    int _convertDataToDoubleVector(const Data *dat,std::vector <double>& data, std::vector <double>& time, std::string &type, std::map<std::string,double> &events, std::map<std::string,double> &newEvents, double &maxEventID);
+    int _convertDataToDoubleVector(const Data *dat,std::vector <double>& data, std::vector <double>& time, std::string &type, event_ids_t &events, event_ids_t &newEvents, double &maxEventID, bool convert = true);
     template <typename UT>
     void _convertUntimedDataToDoubleVectorTemplate(const DataParam<UT> &dat, std::vector<double> &data, std::vector<double> &time);
     int _loadScenarioFromDB(const int id, MavlinkScenario &scenario, DialogProgressBar*progress);
     int _loadCompleteScenarioFromDB(const int id, MavlinkScenario &scenario, DialogProgressBar*progress);
-    int _getReverseEventsFromDB(std::map<double,std::string> &events);
+    int _getReverseEventsFromDB(event_names_t &events);
     Data* _fetchDataGroup(MavSystem*sys, const std::string &type, const std::string &path, const std::string &units);
     bool _populateScenario(MavlinkScenario&scenario, QSqlQuery& qry);
     bool _populateSystem(MavSystem* sys, QSqlQuery& qry);
     int  _populateDataGroups(MavSystem*sys, QSqlQuery& qry2);
-    bool _populateDataItem(double time, double value, const std::map<double,std::string> &events, Data*data);
+    bool _populateDataItem(double time, double value, const event_names_t &events, Data*data);
+    bool _populateDataColumns(const std::vector<double> & time, const std::vector<double> & value,
+                              const event_names_t &events, Data*data);
     bool _populateDataGroup_deferred(MavSystem*sys, Data*d, unsigned long long datagroup_id);
-    bool _populateAllDataGroups_immediate(MavSystem*sys, const std::map<double,std::string>& events);
+    bool _populateAllDataGroups_immediate(MavSystem*sys, const event_names_t& events);
 
     /*******************************************
      * ATTRIBUTES
      *******************************************/
     db_props_t _args;   ///< the database information (hostname etc)
+    std::string _connection; ///< name of the Qt connection, empty=pooled
     QSqlDatabase _db;   ///< Object to connect to Database
+    const DBBackend* _backend; ///< kind of DB, see db_props_t::backend
     bool _deferredLoad; ///< if true, loads only those parts of a scenario which the user requests (lazy loading)
+    bool _useChunks;    ///< if true, samples are saved to table dataChunks, else to table data
+    bool _useStats;     ///< if true, statistics of each group are saved to table dataGroupStats
+    bool _useOverview;  ///< if true, an overview of each group is saved to table dataOverview
+    bool _useHashes;    ///< if true, the content hash of each group is saved to table dataGroupHashes
+    bool _bulk;         ///< if true, saveScenarioToDB() has a transaction on _db, see _begin()
+    unsigned int _saveThreads; ///< see setSaveThreads()
 
     /**
-     * @brief The dbBinder struct ensures db connection is properly opend and closed
+     * @brief The dbBinder struct ensures db connection is properly opend and closed.
+     * Pooled connections are kept open.
      */
     struct dbBinder {
         QSqlDatabase *db;
         bool error;
+        bool keep;
         std::string errmsg;
-        dbBinder(QSqlDatabase *dbPtr)
+        dbBinder(QSqlDatabase *dbPtr, bool keepOpen, const DBBackend*backend)
         {
             error = false;
-            db = dbPtr;            
-            db->setConnectOptions("CLIENT_COMPRESS=1");
+            db = dbPtr;
+            keep = keepOpen;
+            if (db->isOpen()) return;
             if(!db->open())
             {
                 error = true;
                 errmsg = "Could not connect to DB. Reason: " + db->lastError().text().toStdString();
                 std::cout << errmsg << std::endl;
-            }            
+            } else if (!backend->setup(*db, errmsg)) {
+                error = true;
+                std::cout << errmsg << std::endl;
+                db->close();
+            }
         }
         ~dbBinder()
         {
-            db->close();
+            if (!keep) db->close();
         }
     };
 
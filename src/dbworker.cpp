@@ -0,0 +1,164 @@
+/**
+ * @file dbworker.cpp
+ * @brief Runs database jobs (load, save) in the background, one after another.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <iostream>
+#include <QRunnable>
+#include <QMutexLocker>
+#include <QMetaType>
+#include "dbworker.h"
+
+/**
+ * @brief one job in the pool of DBWorker. Uses the pooled DB connection of the worker thread,
+ * since Qt wants each connection to be used only by the thread which made it.
+ */
+class DBJob : public QRunnable {
+public:
+    DBJob(DBWorker*worker, unsigned int id, DBWorker::job_e type, const DBConnector::db_props_t & props,
+          MavlinkScenario*scen, DialogProgressBar*dlg) :
+        _scenarioID(0), _lazy(true), _similar(DBConnector::SIMILAR_INSERT),
+        _worker(worker), _id(id), _type(type), _props(props), _scen(scen), _dlg(dlg) {}
+
+    int                     _scenarioID; ///< for JOB_LOAD
+    bool                    _lazy;       ///< for JOB_LOAD
+    DBConnector::similar_e  _similar;    ///< for JOB_SAVE
+
+    void run() {
+        bool success = false;
+        if (!_dlg || !_dlg->wasCanceled()) {
+            DBConnector con(_props); // pooled connection of this thread, see DBWorker()
+            if (_type == DBWorker::JOB_LOAD) {
+                con.setLazyLoad(_lazy);
+                success = (con.loadScenarioFromDB(_scenarioID, *_scen, _dlg) == 0);
+            } else {
+                success = con.saveScenarioToDB(_scen, _dlg, _similar);
+            }
+        }
+        if (_dlg && _dlg->wasCanceled()) success = false;
+        _worker->_finish(_id, success);
+    }
+
+private:
+    DBWorker*                       _worker;
+    const unsigned int              _id;
+    const DBWorker::job_e           _type;
+    const DBConnector::db_props_t   _props;
+    MavlinkScenario*const           _scen;
+    DialogProgressBar*const         _dlg;
+};
+
+DBWorker::DBWorker(QObject *parent) : QObject(parent), _next_id(0) {
+    qRegisterMetaType<MavlinkScenario*>("MavlinkScenario*");
+    qRegisterMetaType<DialogProgressBar*>("DialogProgressBar*");
+    _pool.setMaxThreadCount(1); // jobs in order; a save can be followed by loading the same scenario
+    _pool.setExpiryTimeout(-1); // the thread keeps its DB connection open for the next job
+}
+
+DBWorker::~DBWorker() {
+    cancel_all();
+    _pool.waitForDone();
+    // nobody will get these
+    for (std::map<unsigned int, job_t>::iterator it = _jobs.begin(); it != _jobs.end(); ++it) {
+        if (it->second.type == JOB_LOAD) delete it->second.scen;
+    }
+}
+
+unsigned int DBWorker::load(const DBConnector::db_props_t & props, int scenarioID, bool lazy,
+                            MavlinkScenario*scen, DialogProgressBar*dlg) {
+    const unsigned int id = _enqueue(JOB_LOAD, scen, dlg);
+    DBJob*const job = new DBJob(this, id, JOB_LOAD, props, scen, dlg);
+    job->_scenarioID = scenarioID;
+    job->_lazy = lazy;
+    _pool.start(job);
+    return id;
+}
+
+unsigned int DBWorker::save(const DBConnector::db_props_t & props, const MavlinkScenario*scen,
+                            DBConnector::similar_e similar, DialogProgressBar*dlg) {
+    // the job only reads it; the pointer is not const, because loading shares the code
+    MavlinkScenario*const s = const_cast<MavlinkScenario*>(scen);
+    const unsigned int id = _enqueue(JOB_SAVE, s, dlg);
+    DBJob*const job = new DBJob(this, id, JOB_SAVE, props, s, dlg);
+    job->_similar = (similar == DBConnector::SIMILAR_ASK) ? DBConnector::SIMILAR_INSERT : similar; // no message boxes outside GUI thread
+    _pool.start(job);
+    return id;
+}
+
+unsigned int DBWorker::_enqueue(job_e type, MavlinkScenario*scen, DialogProgressBar*dlg) {
+    if (dlg) dlg->setCancelable(true);
+    QMutexLocker lock(&_mutex);
+    const unsigned int id = _next_id++;
+    job_t j;
+    j.type = type;
+    j.scen = scen;
+    j.dlg = dlg;
+    j.success = false;
+    _jobs[id] = j;
+    return id;
+}
+
+/**
+ * @brief called by the job in its thread, when it is done
+ */
+void DBWorker::_finish(unsigned int id, bool success) {
+    {
+        QMutexLocker lock(&_mutex);
+        std::map<unsigned int, job_t>::iterator it = _jobs.find(id);
+        if (it != _jobs.end()) it->second.success = success;
+    }
+    QMetaObject::invokeMethod(this, "_jobDone", Qt::QueuedConnection, Q_ARG(unsigned int, id));
+}
+
+/**
+ * @brief in GUI thread, after _finish()
+ */
+void DBWorker::_jobDone(unsigned int id) {
+    job_t j;
+    {
+        QMutexLocker lock(&_mutex);
+        std::map<unsigned int, job_t>::iterator it = _jobs.find(id);
+        if (it == _jobs.end()) return;
+        j = it->second;
+        _jobs.erase(it);
+    }
+    emit jobFinished(id, j.type, j.success, j.scen, j.dlg);
+}
+
+bool DBWorker::is_busy(const MavlinkScenario*scen) const {
+    QMutexLocker lock(&_mutex);
+    for (std::map<unsigned int, job_t>::const_iterator it = _jobs.begin(); it != _jobs.end(); ++it) {
+        if (it->second.scen == scen) return true;
+    }
+    return false;
+}
+
+unsigned int DBWorker::get_num_jobs(void) const {
+    QMutexLocker lock(&_mutex);
+    return _jobs.size();
+}
+
+void DBWorker::cancel_all(void) {
+    QMutexLocker lock(&_mutex);
+    for (std::map<unsigned int, job_t>::iterator it = _jobs.begin(); it != _jobs.end(); ++it) {
+        if (it->second.dlg) it->second.dlg->cancel();
+    }
+}
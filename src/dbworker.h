@@ -0,0 +1,135 @@
+/**
+ * @file dbworker.h
+ * @brief Runs database jobs (load, save) in the background, one after another.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef DBWORKER_H
+#define DBWORKER_H
+
+#include <map>
+#include <QObject>
+#include <QThreadPool>
+#include <QMutex>
+#include "mavlinkscenario.h"
+#include "dbconnector.h"
+#include "dialogprogressbar.h"
+
+class DBJob;
+
+/**
+ * @brief Queue of DB jobs, which are worked off by one background thread in the order they
+ * were added, each with its own DB connection. The GUI stays responsive meanwhile.
+ *
+ * Progress goes to the job's DialogProgressBar (which queues it to the GUI thread), and the
+ * dialog's cancel button stops the job. When a job is done, jobFinished() is emitted in the
+ * GUI thread. A loaded scenario is handed over with it, and then belongs to the receiver.
+ *
+ * While a scenario is being saved, it must neither be changed nor deleted; see is_busy().
+ */
+class DBWorker : public QObject
+{
+    Q_OBJECT
+public:
+    typedef enum {
+        JOB_LOAD,
+        JOB_SAVE
+    } job_e;
+
+    explicit DBWorker(QObject *parent = 0);
+
+    /**
+     * @brief cancels all jobs and waits for them
+     */
+    ~DBWorker();
+
+    /**
+     * @brief load a scenario from the DB into the given, empty one
+     * @param scen is filled in the background, and handed back with jobFinished()
+     * @param dlg progress; made cancelable. Must live until jobFinished().
+     * @return job id
+     */
+    unsigned int load(const DBConnector::db_props_t & props, int scenarioID, bool lazy,
+                      MavlinkScenario*scen, DialogProgressBar*dlg);
+
+    /**
+     * @brief save a scenario to the DB
+     * @param scen is busy until jobFinished()
+     * @param similar must not be SIMILAR_ASK; ask before with DBConnector::findSimilarScenario()
+     * @param dlg progress; made cancelable. Must live until jobFinished().
+     * @return job id
+     */
+    unsigned int save(const DBConnector::db_props_t & props, const MavlinkScenario*scen,
+                      DBConnector::similar_e similar, DialogProgressBar*dlg);
+
+    /**
+     * @return true if a job which is queued or running uses this scenario
+     */
+    bool is_busy(const MavlinkScenario*scen) const;
+
+    /**
+     * @return number of jobs queued or running
+     */
+    unsigned int get_num_jobs(void) const;
+
+    /**
+     * @brief cancel all jobs. They still finish with jobFinished().
+     */
+    void cancel_all(void);
+
+signals:
+    /**
+     * @param id as returned by load() or save()
+     * @param type what the job did
+     * @param success false on error, or when canceled
+     * @param scen the scenario of the job. For JOB_LOAD it is now owned by the receiver.
+     * @param dlg the progress dialog of the job. Not used anymore.
+     */
+    void jobFinished(unsigned int id, int type, bool success, MavlinkScenario*scen, DialogProgressBar*dlg);
+
+private slots:
+    void _jobDone(unsigned int id);
+
+private:
+    friend class DBJob;
+
+    /**
+     * @brief what the GUI thread knows about a job
+     */
+    typedef struct {
+        job_e               type;
+        MavlinkScenario*    scen;
+        DialogProgressBar*  dlg;
+        bool                success; ///< set by the job when done
+    } job_t;
+
+    unsigned int _enqueue(job_e type, MavlinkScenario*scen, DialogProgressBar*dlg);
+    void _finish(unsigned int id, bool success);
+
+    /****************************************
+     *     DATA MEMBERS
+     ****************************************/
+    QThreadPool                           _pool;   ///< one thread, works off the queue in order
+    mutable QMutex                        _mutex;  ///< guards _jobs and _next_id
+    std::map<unsigned int, job_t>         _jobs;   ///< queued or running
+    unsigned int                          _next_id;
+};
+
+#endif // DBWORKER_H
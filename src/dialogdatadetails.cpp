@@ -37,6 +37,8 @@
 #include <QFrame>
 #include <QLineEdit>
 #include "mavplot.h"
+#include "mavplotcurve.h"
+#include "mavplotevents.h"
 
 void DialogDataDetails::_buildDialog(const Data *const d) {
     // build structure
@@ -175,7 +177,7 @@ DialogDataDetails::DialogDataDetails(const Data *const d, std::vector<QwtPlotIte
     /***********************
      *  MARKERS
      ***********************/
-    QwtPlotMarker*mark = dynamic_cast<QwtPlotMarker*>(s->front());
+    MavPlotEvents*mark = dynamic_cast<MavPlotEvents*>(s->front());
 
     // try to get color from marker...default to white
     if (!s->empty()) {
@@ -221,7 +223,7 @@ void DialogDataDetails::on_buttonColor_clicked() {
         }
         if (_items) {
             for (std::vector<QwtPlotItem*>::iterator it = _items->begin(); it != _items->end(); ++it) {
-                QwtPlotMarker*mark = dynamic_cast<QwtPlotMarker*>(*it);
+                MavPlotEvents*mark = dynamic_cast<MavPlotEvents*>(*it);
                 if (mark) {
                     mark->setLinePen(QPen(usercolor, 0, Qt::DashDotLine));
                 }
@@ -314,10 +316,17 @@ void DialogDataDetails::on_cbScale_Changed(int idx) {
             newtxt += _get_suffix_from_scale(scale);
             curve->setTitle(newtxt);
 
-            // re-read original data and scale it
-            QVector<double> xdata, ydata;            
-            MavPlot::data2xyvect(_data, xdata, ydata, 1./scale);
-            curve->setSamples(xdata, ydata); // makes a deep copy
+            // our curves read the samples from the data, and scale them on the fly
+            MavPlotCurve*const mc = dynamic_cast<MavPlotCurve*>(curve);
+            if (mc) {
+                mc->set_scale(1./scale);
+                mc->itemChanged(); // as setSamples() would
+            } else {
+                // re-read original data and scale it
+                QVector<double> xdata, ydata;
+                MavPlot::data2xyvect(_data, xdata, ydata, 1./scale);
+                curve->setSamples(xdata, ydata); // makes a deep copy
+            }
         }
     }    
 }
@@ -344,7 +353,7 @@ void DialogDataDetails::on_txtName_changed(QString newname) {
     // for other annotations, e.g., markers
     if (_items) {
         for (std::vector<QwtPlotItem*>::iterator it = _items->begin(); it != _items->end(); ++it) {
-            QwtPlotMarker*mark = dynamic_cast<QwtPlotMarker*>(*it);
+            MavPlotEvents*mark = dynamic_cast<MavPlotEvents*>(*it);
             if (mark) {
                 mark->setTitle(newname);
             }
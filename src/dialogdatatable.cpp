@@ -26,7 +26,9 @@
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QHeaderView>
+#include <QDoubleValidator>
 #include "dialogdatatable.h"
+#include "profiler.h"
 
 DialogDataTable::DialogDataTable(const Data *d, MavPlot *plot, QWidget *parent) :
     QDialog(parent) , _data(d), _plot(plot) {
@@ -35,90 +37,27 @@ DialogDataTable::DialogDataTable(const Data *d, MavPlot *plot, QWidget *parent)
 }
 
 void DialogDataTable::setData(const Data*d) {    
+    TraceScope trace("data table refresh");
     _data = d;
     _buildTable();
 }
 
-template <typename ST>
-void DialogDataTable::_buildTable_dataevent(const DataEvent<ST>* d) {
-    const std::vector<double> t = d->get_time();
-    const std::vector<ST> s = d->get_data();
-    unsigned int r = 0;
-    for (unsigned int k=0; k<t.size(); k++, r++) {
-        unsigned int c = 0;
-        // time
-        QTableWidgetItem*it = new QTableWidgetItem(QString::number(t[k]));
-        _datatable->setItem(r,c++,it);
-        // data value
-        std::stringstream ss;
-        ss << s[k];
-        it = new QTableWidgetItem(QString::fromStdString(ss.str()));
-        _datatable->setItem(r,c++,it);
-    }
-}
-
-template <typename ST>
-void DialogDataTable::_buildTable_datatimeseries(const DataTimeseries<ST>* d) {
-    const std::vector<double> t = d->get_time();
-    const std::vector<ST> s = d->get_data();
-    unsigned int r = 0;
-    for (unsigned int k=0; k<t.size(); k++, r++) {
-        unsigned int c = 0;
-        // time
-        QTableWidgetItem*it = new QTableWidgetItem(QString::number(t[k]));
-        _datatable->setItem(r,c++,it);
-        // data value
-        std::stringstream ss;
-        ss << s[k];
-        it = new QTableWidgetItem(QString::fromStdString(ss.str()));
-        _datatable->setItem(r,c++,it);
-    }
-}
-
-// shorthand for demuxing polymorphic data
-#define TRY_BUILDTABLE_DATATIMESERIES(data, typetest) \
-    if (const DataTimeseries<typetest>*tmp = dynamic_cast<const DataTimeseries<typetest> *>(data)) { \
-        _buildTable_datatimeseries<typetest>(tmp); \
-    }
-#define TRY_BUILDTABLE_DATAEVENT(data, typetest) \
-    if (const DataEvent<typetest>*tmp = dynamic_cast<const DataEvent<typetest> *>(data)) { \
-        _buildTable_dataevent<typetest>(tmp); \
-    }
-
 /**
  * @brief DialogDataTable::_buildTable
- * fill the tableview based on _data
+ * fill the tableview based on _data. The model formats only the rows which are shown.
  */
 void DialogDataTable::_buildTable(void) {
-    _datatable->clear(); // remove all items; dims stay same
-    _datatable->reset(); // remove internal view state
+    const bool ok = _model->setData(_data);
     if (!_data) {
         _lblsum->setText("no data selected");
         return;
     }
 
-    // header & dim
-    QStringList head = QString("Time;Data").split(";");
-    const int ncols = head.size();
-    _datatable->setColumnCount(ncols);
-    _datatable->setHorizontalHeaderLabels(head);
-    _datatable->setRowCount(_data->size());
     QString summary = QString::fromStdString(Data::get_fullname(_data)) + " (" + QString::number(_data->size()) + " samples)";
-
-    // type-specific tabulation
     if (QString::fromStdString(_data->get_typename()).startsWith("data_timeseries")) {
         summary += " in units of " + QString::fromStdString(_data->get_units());
-        TRY_BUILDTABLE_DATATIMESERIES(_data, int);
-        TRY_BUILDTABLE_DATATIMESERIES(_data, long);
-        TRY_BUILDTABLE_DATATIMESERIES(_data, float);
-        TRY_BUILDTABLE_DATATIMESERIES(_data, double);
-        TRY_BUILDTABLE_DATATIMESERIES(_data, unsigned int);
-        TRY_BUILDTABLE_DATATIMESERIES(_data, unsigned long);
-        // TRY_BUILDTABLE_DATATIMESERIES(_data, std::string); ///< string should not be a timeseries, but an event
-    } else {
-        TRY_BUILDTABLE_DATAEVENT(_data, bool);
-        TRY_BUILDTABLE_DATAEVENT(_data, std::string);
     }
+    if (!ok) summary += ": cannot show this type";
     _lblsum->setText(summary);
 }
 
@@ -127,7 +66,7 @@ void DialogDataTable::on_btnOk_clicked(void) {
 }
 
 void DialogDataTable::on_tableSelectionChanged(void) {
-    // which system within the scenario was selected?
+    // which sample was selected?
     QItemSelectionModel* sel = _datatable->selectionModel();
     QModelIndexList selli  = sel->selectedRows();
     if (selli.empty()) return;
@@ -139,6 +78,17 @@ void DialogDataTable::on_tableSelectionChanged(void) {
     }
 }
 
+void DialogDataTable::on_gotoTime(void) {
+    bool ok;
+    const double t = _txtgoto->text().toDouble(&ok);
+    if (!ok) return;
+    const int row = _model->findTime(t);
+    if (row < 0) return;
+    const QModelIndex idx = _model->index(row, 0);
+    _datatable->scrollTo(idx, QAbstractItemView::PositionAtTop);
+    _datatable->selectRow(row); // moves the marker in the plot, too
+}
+
 void DialogDataTable::on_btnExport_clicked(void) {
 
     QString defaultfilter = "Comma-Separated Values (*.csv)";
@@ -163,10 +113,29 @@ void DialogDataTable::_buildDialog(void) {
     // widgets
     QLabel*lbl = new QLabel(this);
     lbl->setText("Data Points:");
-    _datatable = new QTableWidget(this);
+    _datatable = new QTableView(this);
+    _model = new DataTableModel(this);
+    _datatable->setModel(_model);
     _datatable->setSelectionBehavior(QAbstractItemView::SelectRows); // entire row
     _datatable->setSelectionMode(QAbstractItemView::SingleSelection); // exactly one
     _datatable->horizontalHeader()->setStretchLastSection(true);
+    // same height for all rows, else the view measures each of them
+    #if QT_VERSION >= 0x050000
+        _datatable->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    #else
+        _datatable->verticalHeader()->setResizeMode(QHeaderView::Fixed);
+    #endif
+
+    QHBoxLayout *lgoto = new QHBoxLayout;
+    QLabel*lblgoto = new QLabel(this);
+    lblgoto->setText("Go to time:");
+    _txtgoto = new QLineEdit(this);
+    _txtgoto->setValidator(new QDoubleValidator(_txtgoto));
+    QPushButton*btnGoto = new QPushButton(this);
+    btnGoto->setText("Go");
+    lgoto->addWidget(lblgoto);
+    lgoto->addWidget(_txtgoto);
+    lgoto->addWidget(btnGoto);
 
     QPushButton*btnOk = new QPushButton(this);
     btnOk->setText("Close");
@@ -179,6 +148,7 @@ void DialogDataTable::_buildDialog(void) {
     QVBoxLayout *l = new QVBoxLayout;
     l->addWidget(lbl);
     l->addWidget(_datatable);
+    l->addLayout(lgoto);
     QHBoxLayout *lh = new QHBoxLayout;
     l->addWidget(_lblsum);
     lh->addWidget(btnOk);
@@ -194,5 +164,7 @@ void DialogDataTable::_buildDialog(void) {
     // signals
     connect(btnOk, SIGNAL(clicked()), SLOT(on_btnOk_clicked()));
     connect(btnExport, SIGNAL(clicked()), SLOT(on_btnExport_clicked()));
-    connect(_datatable, SIGNAL(itemSelectionChanged()), SLOT(on_tableSelectionChanged()));
+    connect(_datatable->selectionModel(), SIGNAL(selectionChanged(const QItemSelection&, const QItemSelection&)), SLOT(on_tableSelectionChanged()));
+    connect(btnGoto, SIGNAL(clicked()), SLOT(on_gotoTime()));
+    connect(_txtgoto, SIGNAL(returnPressed()), SLOT(on_gotoTime()));
 }
@@ -25,10 +25,12 @@
 #define DIALOGDATATABLE_H
 
 #include <QDialog>
-#include <QTableWidget>
+#include <QTableView>
 #include <QLabel>
+#include <QLineEdit>
 #include "data.h"
 #include "mavplot.h"
+#include "datatablemodel.h"
 
 class DialogDataTable : public QDialog
 {
@@ -43,6 +45,7 @@ public slots:
     void on_btnOk_clicked(void);
     void on_btnExport_clicked(void);
     void on_tableSelectionChanged(void);
+    void on_gotoTime(void);
 
 private:   
     /******************
@@ -50,18 +53,16 @@ private:
      ******************/
     void _buildDialog(void);
     void _buildTable(void);
-    template <typename ST>
-    void _buildTable_datatimeseries(const DataTimeseries<ST>* d);
-    template <typename ST>
-    void _buildTable_dataevent(const DataEvent<ST>* d);
     
     /******************
      * ATTRIBUTES
      ******************/
     const Data*_data;
     MavPlot*_plot;
-    QTableWidget*_datatable;
+    QTableView*_datatable;
+    DataTableModel*_model;
     QLabel*_lblsum;
+    QLineEdit*_txtgoto;
 
 
 };
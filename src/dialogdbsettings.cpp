@@ -27,6 +27,7 @@
 #include <QPushButton>
 #include <QLineEdit>
 #include <QMessageBox>
+#include <QFileDialog>
 #include "dbconnector.h"
 
 void DialogDBSettings::_buildDialog(void) {
@@ -35,28 +36,40 @@ void DialogDBSettings::_buildDialog(void) {
 
     unsigned int row=0;
 
-    // DB host
+    // kind of DB
     QLabel*lbl = new QLabel(this);
-    lbl->setText("Database host:");
+    lbl->setText("Backend:");
     g->addWidget(lbl, row, 0);
+    cmbBackend = new QComboBox(this);
+    cmbBackend->addItem("MySQL server", QVariant(DB_BACKEND_MYSQL));
+    cmbBackend->addItem("SQLite file (local archive)", QVariant(DB_BACKEND_SQLITE));
+    g->addWidget(cmbBackend, row, 1, 1, 2);
+    cmbBackend->setCurrentIndex(DBBackend::get(_dbprops_tmp.backend)->name() == DB_BACKEND_SQLITE ? 1 : 0);
+
+    // DB host
+    lbl = new QLabel(this);
+    lbl->setText("Database host:");
+    g->addWidget(lbl, ++row, 0);
     txtDbhost = new QLineEdit(this);
-    g->addWidget(txtDbhost,row, 1);
+    g->addWidget(txtDbhost,row, 1, 1, 2);
     txtDbhost->setText(QString().fromStdString(_dbprops_tmp.dbhost));
 
     // DB name
-    lbl = new QLabel(this);
-    lbl->setText("Database name:");
-    g->addWidget(lbl, ++row, 0);
+    lblDbname = new QLabel(this);
+    g->addWidget(lblDbname, ++row, 0);
     txtDbname = new QLineEdit(this);
     g->addWidget(txtDbname, row, 1);
     txtDbname->setText(QString().fromStdString(_dbprops_tmp.dbname));
+    btnBrowse = new QPushButton(this);
+    btnBrowse->setText("...");
+    g->addWidget(btnBrowse, row, 2);
 
     // DB user
     lbl = new QLabel(this);
     lbl->setText("User:");
     g->addWidget(lbl, ++row, 0);
     txtUsername = new QLineEdit(this);
-    g->addWidget(txtUsername, row, 1);
+    g->addWidget(txtUsername, row, 1, 1, 2);
     txtUsername->setText(QString().fromStdString(_dbprops_tmp.username));
 
     // DB passwd
@@ -64,19 +77,19 @@ void DialogDBSettings::_buildDialog(void) {
     lbl->setText("Password:");
     g->addWidget(lbl, ++row, 0);
     txtPassword = new QLineEdit(this);
-    g->addWidget(txtPassword, row, 1);
+    g->addWidget(txtPassword, row, 1, 1, 2);
     txtPassword->setText(QString().fromStdString(_dbprops_tmp.password));
 
     // test button
     QPushButton*btnTest = new QPushButton(this);
     btnTest->setText("Test settings");
-    g->addWidget(btnTest, ++row, 0, 1, 2);
+    g->addWidget(btnTest, ++row, 0, 1, 3);
 
     // -- OK & Co.
     QPushButton*btnOK = new QPushButton(this);
     QPushButton*btnCancel = new QPushButton(this);
     g->addWidget(btnCancel, ++row, 0);
-    g->addWidget(btnOK, row, 1);
+    g->addWidget(btnOK, row, 1, 1, 2);
     btnOK->setText("OK");
     btnCancel->setText("Cancel");
 
@@ -88,6 +101,9 @@ void DialogDBSettings::_buildDialog(void) {
     connect(txtUsername, SIGNAL(textChanged(QString)), SLOT(on_txtUserChanged(QString)));
     connect(txtDbhost, SIGNAL(textChanged(QString)), SLOT(on_txtHostChanged(QString)));
     connect(txtDbname, SIGNAL(textChanged(QString)), SLOT(on_txtDatabaseChanged(QString)));
+    connect(cmbBackend, SIGNAL(currentIndexChanged(int)), SLOT(on_cmbBackendChanged(int)));
+    connect(btnBrowse, SIGNAL(clicked()), SLOT(on_buttonBrowse_clicked()));
+    _updateFields();
 
     //setLayout(v);
     setWindowTitle(QString::fromStdString("Database Settings"));
@@ -102,6 +118,29 @@ DialogDBSettings::DialogDBSettings(DBConnector::db_props_t * arg, QWidget *paren
     _buildDialog();
 }
 
+void DialogDBSettings::_updateFields(void) {
+    const bool file = DBBackend::get(_dbprops_tmp.backend)->name() == DB_BACKEND_SQLITE;
+    lblDbname->setText(file ? "Database file:" : "Database name:");
+    txtDbhost->setEnabled(!file);
+    txtUsername->setEnabled(!file);
+    txtPassword->setEnabled(!file);
+    btnBrowse->setVisible(file);
+}
+
+void DialogDBSettings::on_cmbBackendChanged(int idx) {
+    _dbprops_tmp.backend = cmbBackend->itemData(idx).toString().toStdString();
+    _updateFields();
+}
+
+void DialogDBSettings::on_buttonBrowse_clicked() {
+    // the file need not exist, the schema is created on first use
+    QString fname = QFileDialog::getSaveFileName(this, tr("Archive File"), txtDbname->text(),
+                                                 tr("SQLite Database (*.sqlite *.db);;All Files (*)"),
+                                                 0, QFileDialog::DontConfirmOverwrite);
+    if (fname.isEmpty()) return;
+    txtDbname->setText(fname); // updates _dbprops_tmp
+}
+
 void DialogDBSettings::on_txtPasswordChanged(const QString & s) {
     _dbprops_tmp.password = s.toStdString();
 }
@@ -27,7 +27,9 @@
 #include <QDialog>
 #include <QLabel>
 #include <QLineEdit>
+#include <QPushButton>
 #include <QTextEdit>
+#include <QComboBox>
 #include "dbconnector.h"
 
 class DialogDBSettings : public QDialog
@@ -44,10 +46,13 @@ private slots:
     void on_txtPasswordChanged(const QString &);
     void on_txtDatabaseChanged(const QString & s);
     void on_txtHostChanged(const QString & s);
+    void on_cmbBackendChanged(int idx);
+    void on_buttonBrowse_clicked();
 
 private:
     void _buildDialog(void);
     void _saveProperties(void);
+    void _updateFields(void); ///< enable what the backend needs
 
     /***************************
      *  MEMBER VARIABLES
@@ -56,6 +61,9 @@ private:
     QLineEdit*txtDbname;
     QLineEdit*txtUsername;
     QLineEdit*txtPassword;
+    QComboBox*cmbBackend;
+    QLabel*lblDbname;
+    QPushButton*btnBrowse;
 
     DBConnector::db_props_t*_dbprops_main; // ptr to main windows's store
     DBConnector::db_props_t _dbprops_tmp; // temporary in this dialog
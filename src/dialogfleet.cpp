@@ -0,0 +1,259 @@
+/**
+ * @file dialogfleet.cpp
+ * @brief Trend and distribution of one data path over all flights in the database.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QPushButton>
+#include <QMessageBox>
+#include <QApplication>
+#include <QPen>
+#include <qwt_symbol.h>
+#include <qwt_plot_grid.h>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <math.h>
+#include "dialogfleet.h"
+
+#define FLEET_BINS 100 ///< bins of the distribution of samples
+
+DialogFleet::DialogFleet(const DBConnector::db_props_t & dbprops, QWidget *parent) : QDialog(parent), _dbprops(dbprops) {
+    _buildDialog();
+    _fillPaths();
+}
+
+DialogFleet::~DialogFleet() {
+    // curves belong to the plots, plots to us
+}
+
+void DialogFleet::on_buttonOk_clicked() {
+    this->close();
+}
+
+void DialogFleet::on_buttonQuery_clicked() {
+    const std::string path = _cbpath->currentText().trimmed().toStdString();
+    if (path.empty()) return;
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    DBConnector db(_dbprops);
+    const int nflights = db.aggregateFlights(path, _flights);
+
+    // bins over the range of all flights
+    double lo = NAN, hi = NAN;
+    for (std::vector<DBConnector::flight_stats_t>::const_iterator it = _flights.begin(); it != _flights.end(); ++it) {
+        if (!isnan(it->vmin) && !(it->vmin >= lo)) lo = it->vmin; // also if lo is NAN
+        if (!isnan(it->vmax) && !(it->vmax <= hi)) hi = it->vmax;
+    }
+    if (hi == lo) hi = lo + 1.;
+    bool approximate = false;
+    double nsamples = -1;
+    if (nflights > 0 && !isnan(lo) && !isnan(hi)) {
+        nsamples = db.aggregateHistogram(path, lo, hi, FLEET_BINS, _counts, approximate);
+    } else {
+        _counts.clear();
+    }
+    QApplication::restoreOverrideCursor();
+
+    if (nflights < 0) {
+        QMessageBox::warning(this, "Fleet Trend", "Cannot aggregate this path in the database. See console for details.");
+        return;
+    }
+    _showFlights();
+    _showDistribution(lo, hi, approximate);
+
+    // summary: across flights, and across samples
+    std::vector<double> maxs, avgs;
+    for (std::vector<DBConnector::flight_stats_t>::const_iterator it = _flights.begin(); it != _flights.end(); ++it) {
+        maxs.push_back(it->vmax);
+        avgs.push_back(it->avg);
+    }
+    std::stringstream ss;
+    ss << nflights << " flights";
+    if (nflights > 0) {
+        ss << ". Max per flight: median " << _percentile(maxs, .5) << ", 95% " << _percentile(maxs, .95)
+           << ". Avg per flight: median " << _percentile(avgs, .5) << ".";
+    }
+    if (nsamples > 0) {
+        ss << "\n" << (unsigned long long)nsamples << " samples: 5% " << DBConnector::percentileOfHistogram(_counts, lo, hi, .05)
+           << ", median " << DBConnector::percentileOfHistogram(_counts, lo, hi, .5)
+           << ", 95% " << DBConnector::percentileOfHistogram(_counts, lo, hi, .95);
+        if (approximate) ss << " (approximate, partly from chunk ranges)";
+    }
+    _lblsummary->setText(QString::fromStdString(ss.str()));
+}
+
+double DialogFleet::_percentile(std::vector<double> v, double p) {
+    std::vector<double> w;
+    w.reserve(v.size());
+    for (unsigned int k = 0; k < v.size(); ++k) {
+        if (!isnan(v[k])) w.push_back(v[k]);
+    }
+    if (w.empty()) return NAN;
+    std::sort(w.begin(), w.end());
+    const double pos = p * (w.size() - 1);
+    const unsigned int k = (unsigned int)floor(pos);
+    if (k + 1 >= w.size()) return w.back();
+    return w[k] + (pos - k) * (w[k + 1] - w[k]);
+}
+
+void DialogFleet::_fillPaths(void) {
+    DBConnector db(_dbprops);
+    QSqlDatabase dB = db.getDB();
+    if (!db.open()) {
+        std::cerr << "Cannot open DB connection!" << dB.lastError().text().toStdString() << std::endl;
+        _lblsummary->setText("Cannot open the database.");
+        return;
+    }
+    QSqlQuery qry = DBConnector::prepared(dB, "SELECT DISTINCT FULLPATH FROM dataGroups WHERE VALID=1 ORDER BY FULLPATH;");
+    if( !qry.exec() ) {
+        std::cerr << "Error occured during execution of Query: "<< qry.lastError().text().toStdString() << std::endl;
+        return;
+    }
+    QStringList paths;
+    while (qry.next()) {
+        paths.append(qry.value(0).toString());
+    }
+    _cbpath->clear();
+    _cbpath->addItems(paths);
+}
+
+void DialogFleet::_showFlights(void) {
+    _table->setRowCount(0);
+    _table->setRowCount(_flights.size());
+    QVector<double> x, ymin, ymax, xavg, yavg;
+    for (unsigned int r = 0; r < _flights.size(); ++r) {
+        const DBConnector::flight_stats_t & f = _flights[r];
+        const double duration = f.t_max - f.t_min;
+        _table->setItem(r, 0, new QTableWidgetItem(QString::number(f.scenarioID)));
+        _table->setItem(r, 1, new QTableWidgetItem(f.started));
+        _table->setItem(r, 2, new QTableWidgetItem(QString::number(f.systemID)));
+        _table->setItem(r, 3, new QTableWidgetItem(QString::number(f.n)));
+        _table->setItem(r, 4, new QTableWidgetItem(QString::number(f.vmin)));
+        _table->setItem(r, 5, new QTableWidgetItem(isnan(f.avg) ? QString("-") : QString::number(f.avg)));
+        _table->setItem(r, 6, new QTableWidgetItem(QString::number(f.vmax)));
+        _table->setItem(r, 7, new QTableWidgetItem(isnan(f.stddev) ? QString("-") : QString::number(f.stddev)));
+        _table->setItem(r, 8, new QTableWidgetItem(QString::number(duration)));
+        _table->setItem(r, 9, new QTableWidgetItem(f.filename));
+
+        // one point per flight, in order of time
+        x.push_back(r + 1);
+        ymin.push_back(f.vmin);
+        ymax.push_back(f.vmax);
+        if (!isnan(f.avg)) {
+            xavg.push_back(r + 1);
+            yavg.push_back(f.avg);
+        }
+    }
+    _curveMin->setSamples(x, ymin);
+    _curveAvg->setSamples(xavg, yavg);
+    _curveMax->setSamples(x, ymax);
+    _plotTrend->replot();
+}
+
+void DialogFleet::_showDistribution(double lo, double hi, bool approximate) {
+    QVector<double> x, y;
+    if (!_counts.empty()) {
+        const double width = (hi - lo) / _counts.size();
+        for (unsigned int b = 0; b < _counts.size(); ++b) {
+            x.push_back(lo + b*width);
+            y.push_back(_counts[b]);
+        }
+        x.push_back(hi);
+        y.push_back(_counts.back());
+    }
+    _curveDist->setSamples(x, y);
+    _plotDist->setAxisTitle(QwtPlot::yLeft, approximate ? "samples (approx.)" : "samples");
+    _plotDist->replot();
+}
+
+static QwtPlotCurve* _makeCurve(QwtPlot*plot, const QString & title, const QColor & color, bool symbols) {
+    QwtPlotCurve*c = new QwtPlotCurve(title);
+    c->setPen(QPen(color));
+    if (symbols) {
+        c->setSymbol(new QwtSymbol(QwtSymbol::Ellipse, QBrush(color), QPen(color), QSize(5, 5)));
+    } else {
+        c->setStyle(QwtPlotCurve::Steps);
+    }
+    c->attach(plot);
+    return c;
+}
+
+void DialogFleet::_buildDialog(void) {
+    QVBoxLayout*v = new QVBoxLayout(this);
+
+    // path and query
+    QHBoxLayout*hPath = new QHBoxLayout();
+    v->addLayout(hPath);
+    QLabel*lblPath = new QLabel(this);
+    lblPath->setText("Data path:");
+    hPath->addWidget(lblPath);
+    _cbpath = new QComboBox(this);
+    _cbpath->setEditable(true);
+    _cbpath->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+    hPath->addWidget(_cbpath);
+    QPushButton*btnQuery = new QPushButton(this);
+    btnQuery->setText("Query");
+    hPath->addWidget(btnQuery);
+
+    // plots: per flight, and all samples
+    QHBoxLayout*hPlots = new QHBoxLayout();
+    v->addLayout(hPlots);
+    _plotTrend = new QwtPlot(this);
+    _plotTrend->setAxisTitle(QwtPlot::xBottom, "flight");
+    hPlots->addWidget(_plotTrend);
+    _plotDist = new QwtPlot(this);
+    _plotDist->setAxisTitle(QwtPlot::xBottom, "value");
+    _plotDist->setAxisTitle(QwtPlot::yLeft, "samples");
+    hPlots->addWidget(_plotDist);
+    QwtPlotGrid*grid = new QwtPlotGrid();
+    grid->attach(_plotTrend);
+    _curveMin = _makeCurve(_plotTrend, "min", Qt::blue, true);
+    _curveAvg = _makeCurve(_plotTrend, "avg", Qt::darkGreen, true);
+    _curveMax = _makeCurve(_plotTrend, "max", Qt::red, true);
+    _curveDist = _makeCurve(_plotDist, "samples", Qt::darkBlue, false);
+
+    // table
+    _table = new QTableWidget(this);
+    _table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    QStringList labels;
+    labels << "scenario" << "started" << "system" << "#samples" << "min" << "avg" << "max" << "stddev" << "duration [s]" << "file";
+    _table->setColumnCount(labels.size());
+    _table->setHorizontalHeaderLabels(labels);
+    v->addWidget(_table);
+
+    _lblsummary = new QLabel(this);
+    _lblsummary->setText("Choose a path and query.");
+    v->addWidget(_lblsummary);
+
+    // -- OK
+    QHBoxLayout*hOk = new QHBoxLayout();
+    v->addLayout(hOk);
+    QPushButton*btnOK = new QPushButton(this);
+    hOk->addWidget(btnOK);
+    btnOK->setText("OK");
+
+    connect(btnOK, SIGNAL(clicked()), SLOT(on_buttonOk_clicked()));
+    connect(btnQuery, SIGNAL(clicked()), SLOT(on_buttonQuery_clicked()));
+    setWindowTitle("Fleet Trend");
+    resize(800, 600);
+}
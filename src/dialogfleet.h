@@ -0,0 +1,81 @@
+/**
+ * @file dialogfleet.h
+ * @brief Trend and distribution of one data path over all flights in the database.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef DIALOGFLEET_H
+#define DIALOGFLEET_H
+
+#include <QDialog>
+#include <QComboBox>
+#include <QTableWidget>
+#include <QLabel>
+#include <vector>
+#include <qwt_plot.h>
+#include <qwt_plot_curve.h>
+#include "dbconnector.h"
+
+/**
+ * @brief The database summarizes the chosen path per flight (see DBConnector::aggregateFlights())
+ * and counts its samples into bins (see DBConnector::aggregateHistogram()). Only these few
+ * rows are fetched; no scenario is loaded.
+ */
+class DialogFleet : public QDialog
+{
+    Q_OBJECT
+public:
+    DialogFleet(const DBConnector::db_props_t & dbprops, QWidget *parent = 0);
+    ~DialogFleet();
+
+private slots:
+    void on_buttonQuery_clicked();
+    void on_buttonOk_clicked();
+
+private:
+    void _buildDialog(void);
+    void _fillPaths(void);
+    void _showFlights(void);
+    void _showDistribution(double lo, double hi, bool approximate);
+
+    /**
+     * @brief percentile p in [0,1] of the given values, NANs ignored
+     */
+    static double _percentile(std::vector<double> v, double p);
+
+    /****************************************
+     *   DATA MEMBERS
+     ****************************************/
+    DBConnector::db_props_t                  _dbprops;
+    std::vector<DBConnector::flight_stats_t> _flights;
+    std::vector<double>                      _counts;
+
+    QComboBox*     _cbpath;
+    QTableWidget*  _table;
+    QLabel*        _lblsummary;
+    QwtPlot*       _plotTrend;
+    QwtPlot*       _plotDist;
+    QwtPlotCurve*  _curveMin;
+    QwtPlotCurve*  _curveAvg;
+    QwtPlotCurve*  _curveMax;
+    QwtPlotCurve*  _curveDist;
+};
+
+#endif // DIALOGFLEET_H
@@ -22,10 +22,12 @@
  */
 
 #include <QVBoxLayout>
+#include <QThread>
+#include <QCoreApplication>
 #include "dialogprogressbar.h"
 
 DialogProgressBar::DialogProgressBar(QWidget *parent) :
-    QDialog(parent) {
+    QDialog(parent), _canceled(0) {
 
     QVBoxLayout*v = new QVBoxLayout(this);
     setLayout(v);
@@ -36,15 +38,52 @@ DialogProgressBar::DialogProgressBar(QWidget *parent) :
     _lbl->setText("Progress...");
     _progressbar = new QProgressBar(this);
     _progressbar->setValue(50);
+    _btnCancel = new QPushButton("Cancel", this);
+    _btnCancel->hide();
+    connect(_btnCancel, SIGNAL(clicked()), SLOT(cancel()));
     v->addWidget(_lbl);
     v->addWidget(_progressbar);
+    v->addWidget(_btnCancel);
+}
+
+bool DialogProgressBar::_inGuiThread(void) const {
+    return QThread::currentThread() == thread();
 }
 
 void DialogProgressBar::setLabel(const QString &text) {
-    _lbl->setText(text);
+    if (!_inGuiThread()) {
+        QMetaObject::invokeMethod(this, "_setLabel", Qt::QueuedConnection, Q_ARG(QString, text));
+        return;
+    }
+    _setLabel(text);
 }
 
 void DialogProgressBar::setValue(unsigned int value, unsigned int max) {
+    if (!_inGuiThread()) {
+        QMetaObject::invokeMethod(this, "_setValue", Qt::QueuedConnection, Q_ARG(unsigned int, value), Q_ARG(unsigned int, max));
+        return;
+    }
+    _setValue(value, max);
+}
+
+void DialogProgressBar::_setLabel(const QString &text) {
+    _lbl->setText(text);
+}
+
+void DialogProgressBar::_setValue(unsigned int value, unsigned int max) {
     _progressbar->setValue(value);
     _progressbar->setMaximum(max);
 }
+
+void DialogProgressBar::setCancelable(bool yesno) {
+    _canceled.fetchAndStoreOrdered(0);
+    _btnCancel->setEnabled(true);
+    _btnCancel->setVisible(yesno);
+}
+
+void DialogProgressBar::cancel(void) {
+    if (_canceled.fetchAndStoreOrdered(1) != 0) return;
+    _btnCancel->setEnabled(false);
+    _lbl->setText("Canceling...");
+    emit canceled();
+}
@@ -28,7 +28,14 @@
 #include <QDialog>
 #include <QProgressBar>
 #include <QLabel>
+#include <QPushButton>
+#include <QAtomicInt>
 
+/**
+ * @brief Simple progress dialog. setLabel() and setValue() can also be called from
+ * other threads than the GUI thread (e.g., DBWorker); then the update is queued to the
+ * GUI thread. Optionally has a cancel button, which workers can poll with wasCanceled().
+ */
 class DialogProgressBar : public QDialog
 {
     Q_OBJECT
@@ -37,13 +44,34 @@ public:
     void setLabel(const QString & text);
     void setValue(unsigned int value, unsigned int max);
 
+    /**
+     * @brief show or hide the cancel button. Resets the canceled state.
+     */
+    void setCancelable(bool yesno);
+
+    /**
+     * @brief thread-safe
+     * @return true if the user pressed cancel, or cancel() was called
+     */
+    bool wasCanceled(void) const { return _canceled.fetchAndAddOrdered(0) != 0; }
+
 signals:
-    
+    void canceled(void);
+
 public slots:
-    
+    void cancel(void);
+
+private slots:
+    void _setLabel(const QString & text);
+    void _setValue(unsigned int value, unsigned int max);
+
 private:
+    bool _inGuiThread(void) const;
+
     QProgressBar*_progressbar;
     QLabel*_lbl;
+    QPushButton*_btnCancel;
+    mutable QAtomicInt _canceled;
 };
 
 #endif // DIALOGPROGRESSBAR_H
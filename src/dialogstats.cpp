@@ -26,16 +26,71 @@
 #include <QPushButton>
 #include <QLabel>
 #include <QGroupBox>
+#include <QRunnable>
+#include <QMutexLocker>
 #include <sstream>
+#include <algorithm>
 #include "dialogstats.h"
+#include "statscache.h"
 #include "data.h"
+#include "profiler.h"
 
-DialogStats::DialogStats(const MavPlot * const plot, QWidget *parent) : QDialog(parent), _plot(plot) {
+/**
+ * @brief computes the stats of one row in the pool of DialogStats
+ */
+class DialogStatsJob : public QRunnable {
+public:
+    DialogStatsJob(DialogStats*dlg, unsigned int generation, unsigned int row, const DialogStats::stats_key_t & key) :
+        _dlg(dlg), _generation(generation), _row(row), _key(key) {}
+
+    void run() {
+        {
+            QMutexLocker lock(&_dlg->_mutex);
+            if (_generation != _dlg->_generation) return; // table was refreshed since
+        }
+        DialogStats::stats_result_t res;
+        res.generation = _generation;
+        res.row = _row;
+        res.key = _key;
+        res.entry.ok = StatsCache::Instance().get_stats_timewindow(_key.data, _key.tmin, _key.tmax, res.entry.stats);
+
+        bool first;
+        {
+            QMutexLocker lock(&_dlg->_mutex);
+            first = _dlg->_finished.empty();
+            _dlg->_finished.push_back(res);
+        }
+        // one call collects all which are there by then
+        if (first) QMetaObject::invokeMethod(_dlg, "_collect", Qt::QueuedConnection);
+    }
+
+private:
+    DialogStats*const                  _dlg;
+    const unsigned int                 _generation;
+    const unsigned int                 _row;
+    const DialogStats::stats_key_t     _key;
+};
+
+static bool _by_name(const Data* a, const Data* b) {
+    return a->get_fullname(a) < b->get_fullname(b);
+}
+
+DialogStats::DialogStats(const MavPlot * const plot, QWidget *parent) : QDialog(parent), _plot(plot),
+    _generation(0), _pending(0), _tmin(0.), _tmax(0.) {
     _defineColumns();
     _buildDialog();    
     updateData();
 }
 
+DialogStats::~DialogStats() {
+    {
+        QMutexLocker lock(&_mutex);
+        _generation++; // jobs not yet started do nothing
+    }
+    _tasks.cancel();
+    _tasks.wait();
+}
+
 void DialogStats::on_buttonOk_clicked() {
     this->close();
 }
@@ -84,21 +139,6 @@ void DialogStats::_defineColumns(void) {
     _columns["freq"] = 8;
 }
 
-void DialogStats::_showProgressBar() {
-    _progress.open();
-    _progress.show();
-}
-
-void DialogStats::_updateProgressBarValue(unsigned int val, unsigned int max) {
-    _progress.setValue(val, max);
-    _progress.repaint();
-}
-
-void DialogStats::_hideProgressBar() {
-    // hide it
-    _progress.hide();
-}
-
 void DialogStats::_evalData(void) {
     for (int k=0; k<_table->rowCount(); k++) {
         QTableWidgetItem* row = _table->item(k, _getColByName("name"));
@@ -119,6 +159,7 @@ void DialogStats::_evalData(void) {
 }
 
 void DialogStats::updateData(void) {
+    TraceScope trace("stats refresh");
     _getData();    
     _updateTable();
     _evalData();
@@ -128,52 +169,91 @@ void DialogStats::_updateTable(void) {
     _table->setRowCount(0);// will remove rows
     _table->setRowCount(_data.size());    
 
-    QTableWidgetItem *header1 = new QTableWidgetItem();
-    header1->setText("data series");   
-
     // t from plot
     QwtInterval xax = _plot->axisInterval(QwtPlot::xBottom);
-    const double tmin = xax.minValue();
-    const double tmax = xax.maxValue();
-
-    _showProgressBar();
-    unsigned int r=0;
-    for (std::vector<Data const*>::const_iterator it = _data.begin(); it != _data.end(); ++it) {
-        const Data * const d = *it;
-        if (!d) continue;
+    _tmin = xax.minValue();
+    _tmax = xax.maxValue();
+
+    unsigned int generation;
+    {
+        QMutexLocker lock(&_mutex);
+        generation = ++_generation;
+        _finished.clear();
+    }
+
+    // rows in order of names, which stays so while they fill in
+    _pending = 0;
+    for (unsigned int r = 0; r < _data.size(); ++r) {
+        const Data * const d = _data[r];
         _table->setItem(r, _getColByName("name"), new QTableWidgetItem(d->get_fullname(d).c_str()));
-        d->get_epoch_datastart();
-        Data::data_stats s;
-        if (d->get_stats_timewindow(tmin, tmax, s)) {
-            _table->setItem(r, _getColByName("#samples"), new QTableWidgetItem(QString::number(s.n_samples)));
-            _table->setItem(r, _getColByName("min"), new QTableWidgetItem(QString::number(s.min)));
-            _table->setItem(r, _getColByName("avg"), new QTableWidgetItem(QString::number(s.avg)));
-            _table->setItem(r, _getColByName("stddev"), new QTableWidgetItem(QString::number(s.stddev)));
-            _table->setItem(r, _getColByName("max"), new QTableWidgetItem(QString::number(s.max)));
-            _table->setItem(r, _getColByName("range"), new QTableWidgetItem(QString::number(fabs(s.max - s.min))));
-            _table->setItem(r, _getColByName("freq"), new QTableWidgetItem(QString::number(fabs(s.freq))));
+        _table->setItem(r, _getColByName("units"), new QTableWidgetItem(d->get_units().c_str()));
+
+        stats_key_t key;
+        key.data = d;
+        key.tmin = _tmin;
+        key.tmax = _tmax;
+        stats_entry_t known;
+        if (StatsCache::Instance().lookup(d, _tmin, _tmax, known.ok, known.stats)) {
+            _fillRow(r, known);
         } else {
-            _table->setItem(r, _getColByName("min"), new QTableWidgetItem("stats failed"));
+            _table->setItem(r, _getColByName("min"), new QTableWidgetItem("..."));
+            _pending++;
+            _tasks.start(new DialogStatsJob(this, generation, r, key));
         }
-        _table->setItem(r, _getColByName("units"), new QTableWidgetItem((*it)->get_units().c_str()));        
-        r++;
-        _updateProgressBarValue(r, _data.size());
-    }        
-    _table->sortByColumn(0);
-    _table->sortItems(0);
-    _table->repaint();
+    }
+    _updateSummary();
+    if (_pending == 0) _evalData();
+}
+
+void DialogStats::_fillRow(unsigned int r, const stats_entry_t & e) {
+    const Data::data_stats & s = e.stats;
+    if (e.ok) {
+        _table->setItem(r, _getColByName("#samples"), new QTableWidgetItem(QString::number(s.n_samples)));
+        _table->setItem(r, _getColByName("min"), new QTableWidgetItem(QString::number(s.min)));
+        _table->setItem(r, _getColByName("avg"), new QTableWidgetItem(QString::number(s.avg)));
+        _table->setItem(r, _getColByName("stddev"), new QTableWidgetItem(QString::number(s.stddev)));
+        _table->setItem(r, _getColByName("max"), new QTableWidgetItem(QString::number(s.max)));
+        _table->setItem(r, _getColByName("range"), new QTableWidgetItem(QString::number(fabs(s.max - s.min))));
+        _table->setItem(r, _getColByName("freq"), new QTableWidgetItem(QString::number(fabs(s.freq))));
+    } else {
+        _table->setItem(r, _getColByName("min"), new QTableWidgetItem("stats failed"));
+    }
+}
+
+/**
+ * @brief in GUI thread: fill in the rows which are done
+ */
+void DialogStats::_collect(void) {
+    std::vector<stats_result_t> done;
+    unsigned int generation;
+    {
+        QMutexLocker lock(&_mutex);
+        done.swap(_finished);
+        generation = _generation;
+    }
+    for (std::vector<stats_result_t>::const_iterator it = done.begin(); it != done.end(); ++it) {
+        if (it->generation != generation) continue;
+        _fillRow(it->row, it->entry);
+        if (_pending > 0) _pending--;
+    }
+    _updateSummary();
+    if (_pending == 0) _evalData();
+}
+
+void DialogStats::_updateSummary(void) {
     std::stringstream ss;
-    ss << "time window from " << _plot->getReadableTime(tmin).toStdString() << " to " << _plot->getReadableTime(tmax).toStdString() << ", including " << r << " data series";
+    ss << "time window from " << _plot->getReadableTime(_tmin).toStdString() << " to " << _plot->getReadableTime(_tmax).toStdString() << ", including " << _data.size() << " data series";
+    if (_pending > 0) ss << " (computing " << _pending << ")";
     _lblsummary->setText(ss.str().c_str());
-    _hideProgressBar();
 }
 
 void DialogStats::_getData(void) {
     // first get all data that is in the plot
     _data.clear();
     for (MavPlot::dataplotmap::const_iterator it = _plot->_series.begin(); it != _plot->_series.end(); ++it) {
-        _data.push_back(it->first);
+        if (it->first) _data.push_back(it->first);
     }
+    std::sort(_data.begin(), _data.end(), _by_name);
 }
 
 void DialogStats::_buildDialog(void) {
@@ -232,7 +312,4 @@ void DialogStats::_buildDialog(void) {
     connect(_spevalrange, SIGNAL(valueChanged(double)), SLOT(on_spkeval_range_changed(double)));
     setWindowTitle("Statistics of selection");
     resize(550, 400);
-
-    _progress.setLabel("Calculating stats...");
-    _progress.setParent(this);
 }
@@ -28,18 +28,27 @@
 #include <QTableWidget>
 #include <QCheckBox>
 #include <QDoubleSpinBox>
+#include <QLabel>
+#include "taskpool.h"
+#include <QMutex>
 #include <vector>
+#include <map>
 #include "data.h"
 #include "mavplot.h"
-#include "dialogprogressbar.h"
 
 class MavPlot; ///< forward decl
 
+/**
+ * @brief Rows are computed by a thread pool and filled in as they finish. Results are
+ * remembered per series and time window in the StatsCache, so a refresh, or the dialog
+ * opened again, only computes what changed.
+ */
 class DialogStats : public QDialog
 {
     Q_OBJECT
 public:
     DialogStats(const MavPlot * const plot, QWidget *parent = 0);
+    ~DialogStats();
     void updateData(void);
 
 private slots:
@@ -47,18 +56,37 @@ private slots:
     void on_buttonRefresh_clicked();
     void on_chkeval_range_changed(int state);
     void on_spkeval_range_changed(double val);
+    void _collect(void);
 
 private:
+    friend class DialogStatsJob;
+
+    typedef struct {
+        bool             ok;
+        Data::data_stats stats;
+    } stats_entry_t;
+
+    typedef struct {
+        const Data*  data;
+        double       tmin, tmax;
+    } stats_key_t;
+
+    typedef struct {
+        unsigned int  generation;
+        unsigned int  row;
+        stats_key_t   key;
+        stats_entry_t entry;
+    } stats_result_t;
+
     void _getData(void);
     void _evalData(void);
     void _defineColumns(void);
     void _buildDialog(void);
     void _updateTable(void);
+    void _fillRow(unsigned int row, const stats_entry_t & e);
+    void _updateSummary(void);
     std::string _getColById(unsigned int id);
     int _getColByName(const std::string & s);
-    void _showProgressBar();
-    void _updateProgressBarValue(unsigned int val, unsigned int max);
-    void _hideProgressBar();
 
     // -- Column defs
     std::map<std::string, unsigned int> _columns; // map heading to column index
@@ -68,9 +96,16 @@ private:
     const MavPlot*_plot;
     std::vector<Data const*> _data;
     QTableWidget* _table;
-    DialogProgressBar _progress;
     QLabel*_lblsummary;
 
+    // -- computing rows
+    TaskGroup _tasks;
+    QMutex _mutex;                          ///< for the two below
+    unsigned int _generation;               ///< incremented by each updateData(), older results are dropped
+    std::vector<stats_result_t> _finished;  ///< results of the jobs, until _collect()
+    unsigned int _pending;                  ///< rows still being computed
+    double _tmin, _tmax;                    ///< window of the table
+
     // quick eval
     QCheckBox*_chkevalrange;
     QDoubleSpinBox*_spevalrange;
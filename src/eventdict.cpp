@@ -0,0 +1,69 @@
+/**
+ * @file eventdict.cpp
+ * @brief Process-wide dictionary of event strings, used by DataEvent<std::string>
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <map>
+#include <vector>
+#include <QMutex>
+#include <QMutexLocker>
+#include "eventdict.h"
+
+typedef std::map<std::string, EventDict::id_t> ids_t;
+
+static QMutex g_dict_mutex;
+// never freed, since events may be looked up until the very end
+static ids_t * g_ids = NULL;                               ///< id by string
+static std::vector<const std::string*> * g_strings = NULL; ///< string by id, pointing to the keys of g_ids
+static size_t g_bytes = 0;
+static const std::string g_none;
+
+EventDict::id_t EventDict::intern(const std::string & str) {
+    QMutexLocker lock(&g_dict_mutex);
+    if (!g_ids) {
+        g_ids = new ids_t();
+        g_strings = new std::vector<const std::string*>();
+    }
+    ids_t::iterator it = g_ids->lower_bound(str);
+    if (it != g_ids->end() && it->first == str) return it->second;
+
+    const id_t id = g_strings->size();
+    it = g_ids->insert(it, std::make_pair(str, id));
+    g_strings->push_back(&it->first);
+    g_bytes += str.capacity() + sizeof(ids_t::value_type) + sizeof(const std::string*);
+    return id;
+}
+
+const std::string & EventDict::lookup(id_t id) {
+    QMutexLocker lock(&g_dict_mutex);
+    if (!g_strings || id >= g_strings->size()) return g_none;
+    return *(*g_strings)[id];
+}
+
+unsigned int EventDict::size(void) {
+    QMutexLocker lock(&g_dict_mutex);
+    return g_strings ? g_strings->size() : 0;
+}
+
+size_t EventDict::get_bytes(void) {
+    QMutexLocker lock(&g_dict_mutex);
+    return g_bytes;
+}
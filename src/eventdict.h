@@ -0,0 +1,62 @@
+/**
+ * @file eventdict.h
+ * @brief Process-wide dictionary of event strings, used by DataEvent<std::string>
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef EVENTDICT_H
+#define EVENTDICT_H
+
+#include <string>
+#include <inttypes.h>
+
+/**
+ * @brief Every event string is stored once for the whole process and gets a small
+ * integer id, which stays valid until the program ends. Events repeat a lot
+ * (STATUSTEXT, modes), so DataEvent<std::string> keeps only the ids.
+ * All methods are thread-safe; returned strings stay where they are.
+ */
+class EventDict
+{
+public:
+    typedef uint32_t id_t;
+
+    /**
+     * @return id of the string. Adds it, if not known, yet.
+     */
+    static id_t intern(const std::string & str);
+
+    /**
+     * @return the string with that id, or an empty one if the id is unknown
+     */
+    static const std::string & lookup(id_t id);
+
+    /**
+     * @return number of strings known
+     */
+    static unsigned int size(void);
+
+    /**
+     * @return bytes held by the strings, roughly
+     */
+    static size_t get_bytes(void);
+};
+
+#endif // EVENTDICT_H
@@ -0,0 +1,397 @@
+/**
+ * @file expression.cpp
+ * @brief Formulas over time series, which users define instead of writing postprocessors.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <QRunnable>
+#include "expression.h"
+#include "stringfun.h"
+#include "taskpool.h"
+
+using namespace std;
+
+#define EXPRESSION_CHUNK 4096         ///< points per operation, such that the operands stay in cache
+#define EXPRESSION_JOB_CHUNKS 16      ///< chunks per job of the thread pool
+
+// the operations on a whole chunk, out[] holds the (first) operand
+#define EXPR_UNARY(OP, EXPR) \
+    case OP: for (size_t i = 0; i < n; ++i) { const double x = out[i]; out[i] = (EXPR); } break;
+#define EXPR_BINARY(OP, EXPR) \
+    case OP: for (size_t i = 0; i < n; ++i) { const double x = out[i], y = tmp[i]; out[i] = (EXPR); } break;
+#define EXPR_LOGIC(OP, EXPR) \
+    EXPR_BINARY(OP, (isnan(x) || isnan(y)) ? NAN : ((EXPR) ? 1. : 0.))
+
+/**
+ * @brief evaluates some chunks in the pool of Expression::evaluate()
+ */
+class ExpressionJob : public QRunnable {
+public:
+    ExpressionJob(const Expression*e, const double*const*columns, size_t from, size_t to, double*out) :
+        _e(e), _columns(columns), _from(from), _to(to), _out(out) {}
+    void run() { _e->_eval_range(_columns, _from, _to, _out); }
+private:
+    const Expression*const _e;
+    const double*const*    _columns;
+    const size_t           _from;
+    const size_t           _to;
+    double*                _out;
+};
+
+bool Expression::parse(const std::string & definition) {
+    _definition = definition;
+    _name.clear();
+    _units.clear();
+    _error.clear();
+    _inputs.clear();
+    _nodes.clear();
+    _root = -1;
+
+    // name [units] = formula
+    const size_t eq = definition.find('=');
+    if (eq == string::npos) {
+        _fail("expected \"name = formula\"");
+        return false;
+    }
+    string lhs = definition.substr(0, eq);
+    string_trim(lhs);
+    if (!lhs.empty() && lhs[lhs.size() - 1] == ']') {
+        const size_t bra = lhs.rfind('[');
+        if (bra == string::npos) {
+            _fail("missing '[' before the units");
+            return false;
+        }
+        _units = lhs.substr(bra + 1, lhs.size() - bra - 2);
+        string_trim(_units);
+        lhs = lhs.substr(0, bra);
+        string_trim(lhs);
+    }
+    if (lhs.empty()) {
+        _fail("missing name before '='");
+        return false;
+    }
+    _name = lhs;
+
+    _text = definition.substr(eq + 1);
+    _pos = 0;
+    const int root = _parse_or();
+    if (root >= 0) {
+        _skip_blanks();
+        if (_pos < _text.size()) {
+            _fail("unexpected \"" + _text.substr(_pos) + "\"");
+        } else {
+            _root = root;
+        }
+    }
+    _text.clear();
+    if (_root < 0) {
+        _inputs.clear();
+        _nodes.clear();
+    }
+    return _root >= 0;
+}
+
+int Expression::_fail(const std::string & what) {
+    if (_error.empty()) { // the first problem is the interesting one
+        stringstream ss;
+        ss << what;
+        if (!_text.empty()) ss << " at position " << (_pos + 1) << " of the formula";
+        _error = ss.str();
+    }
+    return -1;
+}
+
+void Expression::_skip_blanks(void) {
+    while (_pos < _text.size() && isspace((unsigned char)_text[_pos])) ++_pos;
+}
+
+bool Expression::_accept(const char*token) {
+    _skip_blanks();
+    const size_t len = strlen(token);
+    if (_text.compare(_pos, len, token) != 0) return false;
+    _pos += len;
+    return true;
+}
+
+int Expression::_add_node(op_e op, int a, int b) {
+    if (a < 0 && op != OP_CONST && op != OP_INPUT) return -1; // operand failed
+    if (b < 0 && op >= OP_ADD && op <= OP_OR) return -1;
+    if (b < 0 && op >= OP_ATAN2) return -1;
+    node_t nd;
+    nd.op = op;
+    nd.value = 0.;
+    nd.input = -1;
+    nd.a = a;
+    nd.b = b;
+    _nodes.push_back(nd);
+    return _nodes.size() - 1;
+}
+
+int Expression::_parse_or(void) {
+    int left = _parse_and();
+    while (left >= 0 && _accept("||")) {
+        left = _add_node(OP_OR, left, _parse_and());
+    }
+    return left;
+}
+
+int Expression::_parse_and(void) {
+    int left = _parse_cmp();
+    while (left >= 0 && _accept("&&")) {
+        left = _add_node(OP_AND, left, _parse_cmp());
+    }
+    return left;
+}
+
+int Expression::_parse_cmp(void) {
+    const int left = _parse_sum();
+    if (left < 0) return -1;
+    // longer tokens first
+    if (_accept("<=")) return _add_node(OP_LE, left, _parse_sum());
+    if (_accept(">=")) return _add_node(OP_GE, left, _parse_sum());
+    if (_accept("==")) return _add_node(OP_EQ, left, _parse_sum());
+    if (_accept("!=")) return _add_node(OP_NE, left, _parse_sum());
+    if (_accept("<")) return _add_node(OP_LT, left, _parse_sum());
+    if (_accept(">")) return _add_node(OP_GT, left, _parse_sum());
+    return left;
+}
+
+int Expression::_parse_sum(void) {
+    int left = _parse_product();
+    while (left >= 0) {
+        if (_accept("+")) {
+            left = _add_node(OP_ADD, left, _parse_product());
+        } else if (_accept("-")) {
+            left = _add_node(OP_SUB, left, _parse_product());
+        } else {
+            break;
+        }
+    }
+    return left;
+}
+
+int Expression::_parse_product(void) {
+    int left = _parse_unary();
+    while (left >= 0) {
+        if (_accept("*")) {
+            left = _add_node(OP_MUL, left, _parse_unary());
+        } else if (_accept("/")) {
+            left = _add_node(OP_DIV, left, _parse_unary());
+        } else {
+            break;
+        }
+    }
+    return left;
+}
+
+int Expression::_parse_unary(void) {
+    if (_accept("-")) return _add_node(OP_NEG, _parse_unary());
+    if (_accept("+")) return _parse_unary();
+    _skip_blanks();
+    if (_pos + 1 < _text.size() && _text[_pos] == '!' && _text[_pos + 1] != '=') {
+        ++_pos;
+        return _add_node(OP_NOT, _parse_unary());
+    }
+    return _parse_power();
+}
+
+int Expression::_parse_power(void) {
+    const int base = _parse_primary();
+    if (base >= 0 && _accept("^")) {
+        return _add_node(OP_POW, base, _parse_unary()); // right-associative, binds -2^2 as -(2^2)
+    }
+    return base;
+}
+
+int Expression::_parse_primary(void) {
+    _skip_blanks();
+    if (_pos >= _text.size()) return _fail("unexpected end");
+    const char c = _text[_pos];
+
+    // number
+    if (isdigit((unsigned char)c) || (c == '.' && _pos + 1 < _text.size() && isdigit((unsigned char)_text[_pos + 1]))) {
+        const char*const begin = _text.c_str() + _pos;
+        char*end = NULL;
+        const double v = strtod(begin, &end);
+        _pos += end - begin;
+        const int k = _add_node(OP_CONST);
+        _nodes[k].value = v;
+        return k;
+    }
+
+    // parentheses
+    if (c == '(') {
+        ++_pos;
+        const int inner = _parse_or();
+        if (inner < 0) return -1;
+        if (!_accept(")")) return _fail("missing ')'");
+        return inner;
+    }
+
+    // path or function
+    string name;
+    if (c == '"') {
+        const size_t close = _text.find('"', _pos + 1);
+        if (close == string::npos) return _fail("missing closing '\"'");
+        name = _text.substr(_pos + 1, close - _pos - 1);
+        _pos = close + 1;
+        if (name.empty()) return _fail("empty path");
+    } else if (isalpha((unsigned char)c) || c == '_') {
+        const size_t begin = _pos;
+        while (_pos < _text.size() && (isalnum((unsigned char)_text[_pos]) || strchr("_./", _text[_pos]))) ++_pos;
+        name = _text.substr(begin, _pos - begin);
+
+        op_e op;
+        unsigned int nargs;
+        if (_accept("(")) {
+            if (!_lookup_function(name, op, nargs)) return _fail("unknown function \"" + name + "\"");
+            const int a = _parse_or();
+            if (a < 0) return -1;
+            int b = -1;
+            if (nargs == 2) {
+                if (!_accept(",")) return _fail("\"" + name + "\" needs two arguments");
+                b = _parse_or();
+                if (b < 0) return -1;
+            }
+            if (!_accept(")")) return _fail("missing ')' after the arguments of \"" + name + "\"");
+            return _add_node(op, a, b);
+        }
+    } else {
+        return _fail(string("unexpected '") + c + "'");
+    }
+
+    // input; each path only once
+    int input = -1;
+    for (unsigned int k = 0; k < _inputs.size(); ++k) {
+        if (_inputs[k] == name) input = k;
+    }
+    if (input < 0) {
+        input = _inputs.size();
+        _inputs.push_back(name);
+    }
+    const int k = _add_node(OP_INPUT);
+    _nodes[k].input = input;
+    return k;
+}
+
+bool Expression::_lookup_function(const std::string & name, op_e & op, unsigned int & nargs) {
+    static const struct { const char*name; op_e op; unsigned int nargs; } functions[] = {
+        {"abs", OP_ABS, 1}, {"sqrt", OP_SQRT, 1}, {"exp", OP_EXP, 1}, {"log", OP_LOG, 1},
+        {"log10", OP_LOG10, 1}, {"sin", OP_SIN, 1}, {"cos", OP_COS, 1}, {"tan", OP_TAN, 1},
+        {"asin", OP_ASIN, 1}, {"acos", OP_ACOS, 1}, {"atan", OP_ATAN, 1}, {"floor", OP_FLOOR, 1},
+        {"ceil", OP_CEIL, 1}, {"deg", OP_DEG, 1}, {"rad", OP_RAD, 1},
+        {"atan2", OP_ATAN2, 2}, {"min", OP_MIN, 2}, {"max", OP_MAX, 2}, {"pow", OP_POW, 2},
+    };
+    for (unsigned int k = 0; k < sizeof(functions) / sizeof(functions[0]); ++k) {
+        if (name == functions[k].name) {
+            op = functions[k].op;
+            nargs = functions[k].nargs;
+            return true;
+        }
+    }
+    return false;
+}
+
+void Expression::_eval(int node, const double*const*columns, size_t from, size_t n, double*out) const {
+    const node_t & nd = _nodes[node];
+    switch (nd.op) {
+    case OP_CONST:
+        for (size_t i = 0; i < n; ++i) out[i] = nd.value;
+        return;
+    case OP_INPUT:
+        memcpy(out, columns[nd.input] + from, n * sizeof(double));
+        return;
+    default:
+        break;
+    }
+
+    _eval(nd.a, columns, from, n, out);
+    std::vector<double> operand;
+    const double*tmp = NULL;
+    if (nd.b >= 0) {
+        operand.resize(n);
+        _eval(nd.b, columns, from, n, &operand[0]);
+        tmp = &operand[0];
+    }
+
+    switch (nd.op) {
+    EXPR_UNARY(OP_NEG, -x)
+    EXPR_UNARY(OP_NOT, isnan(x) ? NAN : (x == 0. ? 1. : 0.))
+    EXPR_UNARY(OP_ABS, fabs(x))
+    EXPR_UNARY(OP_SQRT, sqrt(x))
+    EXPR_UNARY(OP_EXP, exp(x))
+    EXPR_UNARY(OP_LOG, log(x))
+    EXPR_UNARY(OP_LOG10, log10(x))
+    EXPR_UNARY(OP_SIN, sin(x))
+    EXPR_UNARY(OP_COS, cos(x))
+    EXPR_UNARY(OP_TAN, tan(x))
+    EXPR_UNARY(OP_ASIN, asin(x))
+    EXPR_UNARY(OP_ACOS, acos(x))
+    EXPR_UNARY(OP_ATAN, atan(x))
+    EXPR_UNARY(OP_FLOOR, floor(x))
+    EXPR_UNARY(OP_CEIL, ceil(x))
+    EXPR_UNARY(OP_DEG, x * (180. / M_PI))
+    EXPR_UNARY(OP_RAD, x * (M_PI / 180.))
+    EXPR_BINARY(OP_ADD, x + y)
+    EXPR_BINARY(OP_SUB, x - y)
+    EXPR_BINARY(OP_MUL, x * y)
+    EXPR_BINARY(OP_DIV, x / y)
+    EXPR_BINARY(OP_POW, pow(x, y))
+    EXPR_BINARY(OP_ATAN2, atan2(x, y))
+    EXPR_BINARY(OP_MIN, (isnan(x) || isnan(y)) ? NAN : (y < x ? y : x))
+    EXPR_BINARY(OP_MAX, (isnan(x) || isnan(y)) ? NAN : (y > x ? y : x))
+    EXPR_LOGIC(OP_LT, x < y)
+    EXPR_LOGIC(OP_LE, x <= y)
+    EXPR_LOGIC(OP_GT, x > y)
+    EXPR_LOGIC(OP_GE, x >= y)
+    EXPR_LOGIC(OP_EQ, x == y)
+    EXPR_LOGIC(OP_NE, x != y)
+    EXPR_LOGIC(OP_AND, x != 0. && y != 0.)
+    EXPR_LOGIC(OP_OR, x != 0. || y != 0.)
+    default:
+        break;
+    }
+}
+
+void Expression::_eval_range(const double*const*columns, size_t from, size_t to, double*out) const {
+    for (size_t k = from; k < to; k += EXPRESSION_CHUNK) {
+        const size_t n = (to - k < EXPRESSION_CHUNK) ? (to - k) : EXPRESSION_CHUNK;
+        _eval(_root, columns, k, n, out + k);
+    }
+}
+
+void Expression::evaluate(const std::vector<const double*> & columns, size_t n, double*out, unsigned int nthreads) const {
+    if (_root < 0 || n == 0) return;
+    const double*const*cols = columns.empty() ? NULL : &columns[0];
+    const size_t per_job = EXPRESSION_CHUNK * EXPRESSION_JOB_CHUNKS;
+    if (1 == nthreads || n <= per_job) {
+        _eval_range(cols, 0, n, out);
+        return;
+    }
+    TaskGroup tasks(nthreads);
+    for (size_t k = 0; k < n; k += per_job) {
+        tasks.start(new ExpressionJob(this, cols, k, (n - k < per_job) ? n : k + per_job, out)); // auto-deleted
+    }
+    tasks.wait();
+}
@@ -0,0 +1,144 @@
+/**
+ * @file expression.h
+ * @brief Formulas over time series, which users define instead of writing postprocessors.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+#include <string>
+#include <vector>
+
+#define EXPRESSION_GROUP "derived/" ///< outputs go below this
+
+/**
+ * @brief A definition like
+ *
+ *   power [W] = airstate/airspeed * power/battery_current
+ *
+ * i.e., name, optional units in brackets, and a formula over data paths of one system.
+ * The output is the series EXPRESSION_GROUP + name. See MavSystem::apply_expression().
+ *
+ * Formulas know + - * / ^, comparisons (< <= > >= == !=, giving 1 or 0), && || !,
+ * parentheses, numbers and the functions abs, sqrt, exp, log, log10, sin, cos, tan, asin,
+ * acos, atan, floor, ceil, deg, rad (one argument), and atan2, min, max, pow (two).
+ * Paths are written as they are, "/" within a path belongs to it. Division needs
+ * blanks then, as in "a / b". Paths with other characters go in quotes, like
+ * "power/cum. charge".
+ *
+ * The definition is parsed once into a tree of operations. Each operation works on a
+ * whole chunk of points at a time, in a tight loop, and chunks are evaluated in parallel.
+ */
+class Expression
+{
+public:
+    Expression() : _root(-1) {}
+
+    /**
+     * @brief replace the current definition
+     * @return false if it is malformed, see get_error(). Expression is empty then.
+     */
+    bool parse(const std::string & definition);
+
+    bool is_valid(void) const { return _root >= 0; }
+    const std::string & get_error(void) const { return _error; }
+    const std::string & get_definition(void) const { return _definition; }
+
+    /**
+     * @brief name of the output, without EXPRESSION_GROUP
+     */
+    const std::string & get_name(void) const { return _name; }
+    const std::string & get_units(void) const { return _units; }
+
+    /**
+     * @brief the paths the formula reads, each once, in order of appearance
+     */
+    const std::vector<std::string> & get_inputs(void) const { return _inputs; }
+
+    /**
+     * @brief compute the formula at n points
+     * @param columns values of get_inputs() at the points, each with n elements
+     * @param out n values. NAN wherever an input is NAN.
+     * @param nthreads how many chunks are computed at the same time. 0=one per core
+     */
+    void evaluate(const std::vector<const double*> & columns, size_t n, double*out, unsigned int nthreads = 0) const;
+
+private:
+    friend class ExpressionJob;
+
+    typedef enum {
+        OP_CONST, OP_INPUT, OP_NEG, OP_NOT,
+        OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_POW,
+        OP_LT, OP_LE, OP_GT, OP_GE, OP_EQ, OP_NE, OP_AND, OP_OR,
+        OP_ABS, OP_SQRT, OP_EXP, OP_LOG, OP_LOG10, OP_SIN, OP_COS, OP_TAN,
+        OP_ASIN, OP_ACOS, OP_ATAN, OP_FLOOR, OP_CEIL, OP_DEG, OP_RAD,
+        OP_ATAN2, OP_MIN, OP_MAX
+    } op_e;
+
+    typedef struct node_s {
+        op_e   op;
+        double value; ///< OP_CONST
+        int    input; ///< OP_INPUT: index in _inputs
+        int    a;     ///< first operand, index in _nodes
+        int    b;     ///< second operand
+    } node_t;
+
+    /**
+     * @brief recursive descent; each returns the index of the new node, or -1 on error
+     */
+    int _parse_or(void);
+    int _parse_and(void);
+    int _parse_cmp(void);
+    int _parse_sum(void);
+    int _parse_product(void);
+    int _parse_unary(void);
+    int _parse_power(void);
+    int _parse_primary(void);
+
+    void _skip_blanks(void);
+    bool _accept(const char*token);
+    int _add_node(op_e op, int a = -1, int b = -1);
+    int _fail(const std::string & what);
+    static bool _lookup_function(const std::string & name, op_e & op, unsigned int & nargs);
+
+    /**
+     * @brief computes node on points [from, from+n) into out
+     */
+    void _eval(int node, const double*const*columns, size_t from, size_t n, double*out) const;
+    void _eval_range(const double*const*columns, size_t from, size_t to, double*out) const;
+
+    /****************************************
+     *   DATA MEMBERS
+     ****************************************/
+    std::string              _definition;
+    std::string              _name;
+    std::string              _units;
+    std::string              _error;
+    std::vector<std::string> _inputs;
+    std::vector<node_t>      _nodes;
+    int                      _root;
+
+    // while parsing
+    std::string _text;
+    size_t      _pos;
+};
+
+#endif // EXPRESSION_H
@@ -89,3 +89,11 @@ string getBasename(const string & fullpath) {
 bool fileExists(std::string &path) {
     return (access(path.c_str(), F_OK ) != -1);
 }
+
+bool fileSeek(FILE*fp, uint64_t offset) {
+#if defined(WIN32) || defined(__WIN32) || defined(__WIN32__)
+    return _fseeki64(fp, (__int64) offset, SEEK_SET) == 0;
+#else
+    return fseeko(fp, (off_t) offset, SEEK_SET) == 0;
+#endif
+}
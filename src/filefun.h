@@ -25,6 +25,8 @@
 #define FILEFUN_H
 
 #include <string>
+#include <stdio.h>
+#include <inttypes.h>
 
 std::string getFullPath(const std::string & filename);
 std::string getBasename(const std::string & fullpath); ///< strip directory; return only filename
@@ -32,5 +34,6 @@ std::string getExtension(const std::string & filename);
 std::string getDirname(const std::string & filename);
 std::string &lcase(std::string &s);
 bool fileExists(std::string &path);
+bool fileSeek(FILE*fp, uint64_t offset); ///< fseek() from the start, also beyond 2GB
 
 #endif // FILEFUN_H
@@ -0,0 +1,769 @@
+/**
+ * @file fileimporter.cpp
+ * @brief Parses and processes one log file into its own scenario. Can run in a worker
+ * thread, so that several files are imported in parallel.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <sstream>
+#include <cstddef>
+#include <algorithm>
+#include <cmath>
+#include <QThread>
+#include <QRegExp>
+#include <QString>
+#include <QFileInfo>
+#include "fileimporter.h"
+#include "mavlinkparser.h"
+#include "onboardlogparserfactory.h"
+#include "filefun.h"
+#include "time_fun.h"
+#include "spscring.h"
+#include "scenariocache.h"
+#include "profiler.h"
+#include "taskpool.h"
+
+using namespace std;
+
+#define PIPELINE_MAVLINK_SLOTS 4096
+#define PIPELINE_ONBOARD_SLOTS 1024
+#define CHUNK_MIN_BYTES (4*1024*1024) ///< smallest chunk. Tlogs smaller than two of them are not split
+#define CHUNK_OVERLAP_BYTES (256*1024) ///< each chunk decodes this far into the next one
+
+/**
+ * @brief runs the decoding side of a pipelined import
+ */
+class PipelineThread : public QThread {
+public:
+    typedef void (*Work_Function)(void*ctx);
+    PipelineThread(Work_Function f, void*ctx) : _f(f), _ctx(ctx) {}
+    void run() { _f(_ctx); }
+private:
+    Work_Function _f;
+    void*         _ctx;
+};
+
+typedef struct {
+    MavlinkParser*                mlp;
+    SpscRing<mavlink_message_t>*  ring;
+} mavlink_producer_t;
+
+static void _produce_mavlink(void*ctx) {
+    mavlink_producer_t*const p = (mavlink_producer_t*) ctx;
+    for (;;) {
+        mavlink_message_t*const slot = p->ring->wait_push();
+        if (!p->mlp->get_next_msg(*slot)) break;
+        p->ring->end_push();
+    }
+    p->ring->close();
+}
+
+typedef struct {
+    OnboardLogParser*       olp;
+    SpscRing<OnboardData>*  ring;
+} onboard_producer_t;
+
+static void _produce_onboard(void*ctx) {
+    onboard_producer_t*const p = (onboard_producer_t*) ctx;
+    OnboardData*slot = p->ring->wait_push();
+    while (p->olp->has_more_data()) {
+        if (p->olp->get_data(*slot)) {
+            p->ring->end_push();
+            slot = p->ring->wait_push();
+        }
+    }
+    p->ring->close();
+}
+
+/**
+ * @brief counters of one import. They go to the Profiler when this is destroyed,
+ * so that the workers do not take its lock for each message.
+ */
+class ImportProfile {
+public:
+    ImportProfile() : on(Profiler::Instance().is_enabled()), _mark(0), _track(NULL), _n_decoded(0), _decode_nsec(0) {
+        if (on) {
+            _mark = Profiler::now_nsec();
+            _track = &_c["track"];
+        }
+    }
+
+    ~ImportProfile() {
+        if (!on) return;
+        if (_decode_nsec > 0) {
+            // the parts include reading, the total does not. Without times, the parts are summed up.
+            const unsigned long long read_nsec = _c["read"].nsec;
+            Profiler::count(_c["decode"], _decode_nsec > read_nsec ? _decode_nsec - read_nsec : 0, _n_decoded);
+        }
+        Profiler::Instance().add(_c);
+    }
+
+    /**
+     * @return time since the last call
+     */
+    unsigned long long lap(void) {
+        const unsigned long long now = Profiler::now_nsec();
+        const unsigned long long dt = now - _mark;
+        _mark = now;
+        return dt;
+    }
+
+    void decoded(unsigned int msgid, unsigned long long nsec) {
+        if (msgid >= _mavlink.size()) _mavlink.resize(msgid + 1, NULL);
+        if (!_mavlink[msgid]) _mavlink[msgid] = &_c["decode/" + MavlinkParser::get_msg_name(msgid)];
+        _decoded(*_mavlink[msgid], nsec);
+    }
+
+    void decoded(const OnboardData & d, unsigned long long nsec) {
+        Profiler::counter_t*& c = _onboard[d.get_schema()];
+        if (!c) c = &_c["decode/" + d.get_message_name()];
+        _decoded(*c, nsec);
+    }
+
+    void tracked(unsigned long long nsec) { Profiler::count(*_track, nsec); }
+
+    void read(unsigned long long nsec, unsigned long long bytes) { Profiler::count(_c["read"], nsec, 1, bytes); }
+
+    const bool on;
+
+private:
+    void _decoded(Profiler::counter_t & c, unsigned long long nsec) {
+        Profiler::count(c, nsec);
+        _n_decoded++;
+        _decode_nsec += nsec;
+    }
+
+    Profiler::counters_t _c;
+    unsigned long long   _mark;
+    Profiler::counter_t* _track;
+    unsigned long long   _n_decoded;
+    unsigned long long   _decode_nsec;
+    std::vector<Profiler::counter_t*> _mavlink; ///< by msgid, into _c
+    std::map<const OnboardSchema*, Profiler::counter_t*> _onboard;
+};
+
+/**
+ * @brief decodes one byte range of a tlog. Keeps all messages that start before
+ * limit in packed form (header and used part of payload only), together with
+ * the file position where they start.
+ */
+class ChunkDecoder : public QRunnable {
+public:
+    typedef struct {
+        uint64_t start;  ///< file position
+        size_t   pos;    ///< in data
+    } record_t;
+
+    ChunkDecoder(const std::string & filename, const TopicFilter*filter, uint64_t from, uint64_t limit) :
+        from(from), limit(limit), n_skipped(0), starved(false), begin(0), end(0), _filename(filename), _filter(filter)
+    {
+        memset(&stats, 0, sizeof(stats));
+        setAutoDelete(false);
+    }
+
+    void run() {
+        TraceScope trace("parse mavlink chunk");
+        const bool prof = Profiler::Instance().is_enabled();
+        const unsigned long long t0 = prof ? Profiler::now_nsec() : 0;
+        MavlinkParser mlp(_filename);
+        if (!mlp.valid || !mlp.seek(from)) return;
+        if (!mlp.claim_channel(0)) {
+            starved = true; // the importer decodes serially then
+            return;
+        }
+        mlp.set_filter(_filter);
+        mavlink_message_t msg;
+        while (mlp.get_next_msg(msg)) {
+            const uint64_t start = mlp.get_msg_offset();
+            if (start >= limit) break;
+            const record_t r = { start, data.size() };
+            records.push_back(r);
+            const char*const p = (const char*) &msg;
+            data.insert(data.end(), p, p + HEADER + msg.len);
+        }
+        stats = *mlp.get_linkstats();
+        n_skipped = mlp.get_num_skipped();
+        end = records.size();
+        if (prof) {
+            // chunks run in parallel, so this is CPU time rather than wall time
+            const unsigned long long dt = Profiler::now_nsec() - t0;
+            Profiler::Instance().add("read", mlp.get_read_nsec(), 1, mlp.get_read_bytes());
+            Profiler::Instance().add("decode", dt - std::min(dt, mlp.get_read_nsec()), records.size());
+        }
+    }
+
+    void unpack(size_t k, mavlink_message_t & msg) const {
+        const char*const p = &data[records[k].pos];
+        memcpy(&msg, p, HEADER);
+        memcpy(((char*)&msg) + HEADER, p + HEADER, msg.len);
+    }
+
+    /**
+     * @return index of first record starting at or after offset
+     */
+    size_t find(uint64_t offset) const {
+        size_t lo = 0, hi = records.size();
+        while (lo < hi) {
+            const size_t mid = (lo + hi) / 2;
+            if (records[mid].start < offset) lo = mid + 1; else hi = mid;
+        }
+        return lo;
+    }
+
+    static const size_t HEADER = offsetof(mavlink_message_t, payload64);
+
+    const uint64_t        from;
+    const uint64_t        limit;
+    std::vector<char>     data;
+    std::vector<record_t> records;
+    mavlink_status_t      stats;
+    unsigned int          n_skipped;
+    bool                  starved; ///< got no MavLink channel, nothing decoded
+    size_t                begin; ///< first record that is used after stitching
+    size_t                end;   ///< one past last record that is used after stitching
+
+private:
+    const std::string  _filename;
+    const TopicFilter* _filter;
+};
+
+FileImporter::FileImporter(const std::string &fullpath, const CmdlineArgs * const args, double delay_sec) :
+    _fullpath(fullpath), _args(args), _delay_sec(delay_sec),
+    _policy_fwd(TIMEJUMP_IGNORE), _policy_back(TIMEJUMP_IGNORE), _demux_sec(0.), _finished(NULL), _filter(NULL),
+    _parsed(false), _n_jumps_fwd(0), _n_jumps_back(0), _n_jumps_allowed(0), _n_jumps_demuxed(0)
+{
+    _basename = getBasename(_fullpath);
+    if (_args) {
+        timejump_policy_e policy = TIMEJUMP_IGNORE; // also for JUMPS_ASK; the GUI overrides it
+        switch (_args->time_jumps) {
+        case CmdlineArgs::JUMPS_ALLOW: policy = TIMEJUMP_ALLOW; break;
+        case CmdlineArgs::JUMPS_DEMUX: policy = TIMEJUMP_DEMUX; break;
+        case CmdlineArgs::JUMPS_THRESHOLD: policy = TIMEJUMP_THRESHOLD; break;
+        default: break;
+        }
+        set_timejump_policy(policy, policy, _args->jumps_demux_sec);
+    }
+    if (_args && _args->topics.is_active()) {
+        _filter = &_args->topics;
+    }
+    setAutoDelete(false); // caller collects the results
+}
+
+FileImporter::~FileImporter() {
+    _clear();
+}
+
+void FileImporter::set_timejump_policy(timejump_policy_e fwd, timejump_policy_e back, double demux_sec) {
+    _policy_fwd = fwd;
+    _policy_back = back;
+    if (demux_sec > 0.) _demux_sec = demux_sec;
+}
+
+void FileImporter::_clear(void) {
+    for (std::vector<MavlinkScenario*>::iterator it = _scenarios.begin(); it != _scenarios.end(); ++it) {
+        delete *it;
+    }
+    _scenarios.clear();
+    _parsed = false;
+    _error.clear();
+    _n_jumps_fwd = 0;
+    _n_jumps_back = 0;
+    _n_jumps_allowed = 0;
+    _n_jumps_demuxed = 0;
+}
+
+MavlinkScenario* FileImporter::_new_scenario(void) {
+    MavlinkScenario*scene = new MavlinkScenario(_args);
+    scene->set_topic_filter(_filter);
+    _scenarios.push_back(scene);
+    if (_scenarios.size() == 1) {
+        scene->setName(_basename);
+    } else {
+        stringstream ss;
+        ss << _basename << "_" << _scenarios.size();
+        scene->setName(ss.str());
+    }
+    return scene;
+}
+
+/**
+ * @brief whether the result only depends on the file and on what _cache_key() says
+ */
+bool FileImporter::_cacheable(void) const {
+    if (!_args || !_args->cache) return false;
+    return _delay_sec == 0.0 && !_filter && !_args->time_window;
+}
+
+std::string FileImporter::_cache_key(void) const {
+    stringstream ss;
+    ss << "jumps=" << _policy_fwd << "," << _policy_back << ";maxjump=" << _args->time_maxjump_sec;
+    if (TIMEJUMP_THRESHOLD == _policy_fwd || TIMEJUMP_THRESHOLD == _policy_back) {
+        ss << ";demux=" << _demux_sec;
+    }
+    return ss.str();
+}
+
+void FileImporter::run(void) {
+    TraceScope trace("import");
+    _clear();
+    if (_fingerprint.empty()) {
+        ProfileScope prof("fingerprint");
+        _fingerprint = ScenarioCache::get_fingerprint(_fullpath);
+    }
+
+    ScenarioCache::info_t cacheinfo;
+    cacheinfo.fingerprint = _fingerprint;
+    const bool cacheable = _cacheable();
+    if (cacheable) {
+        cacheinfo.key = _cache_key();
+        bool hit;
+        {
+            ProfileScope prof("cache load");
+            hit = ScenarioCache::load(_fullpath, cacheinfo, _scenarios, _args);
+        }
+        if (hit) {
+            _n_jumps_fwd = cacheinfo.n_jumps_fwd;
+            _n_jumps_back = cacheinfo.n_jumps_back;
+            // not in the cache, but follows from the policy, which is part of the key
+            _n_jumps_demuxed = _scenarios.empty() ? 0 : _scenarios.size() - 1;
+            if (TIMEJUMP_IGNORE != _policy_fwd || TIMEJUMP_IGNORE != _policy_back) {
+                _n_jumps_allowed = _n_jumps_fwd + _n_jumps_back - _n_jumps_demuxed;
+            }
+            _add_fingerprints();
+            for (std::vector<MavlinkScenario*>::iterator it = _scenarios.begin(); it != _scenarios.end(); ++it) {
+                (*it)->process_cached(); // the cache has the result of process(), but not of the settings
+            }
+            _parsed = true;
+            if (_finished) {
+                _finished->fetchAndAddOrdered(1);
+            }
+            return;
+        }
+    }
+
+    // decide which parser to take and do it
+    string ext = getExtension(_fullpath);
+    ext = lcase(ext);
+    if (ext.compare("tlog") == 0 || ext.compare("mavlink") == 0) {
+        _parsed = _import_mavlink();
+    } else {
+        _parsed = _import_onboard(ext);
+    }
+
+    if (_parsed) {
+        _add_fingerprints();
+        uint64_t time_epoch_usec = 0;
+        const bool have_guess = guess_starttime(_basename, time_epoch_usec);
+        for (std::vector<MavlinkScenario*>::iterator it = _scenarios.begin(); it != _scenarios.end(); ++it) {
+            MavlinkScenario*scene = *it;
+            if (have_guess) {
+                scene->set_starttime_guess(time_epoch_usec);
+            }
+            // apply delay if any
+            if (_delay_sec != 0.0) {
+                scene->shift_time(_delay_sec);
+            }
+            // analyze
+            scene->process();
+        }
+        if (cacheable) {
+            cacheinfo.n_jumps_fwd = _n_jumps_fwd;
+            cacheinfo.n_jumps_back = _n_jumps_back;
+            ProfileScope prof("cache save");
+            ScenarioCache::save(_fullpath, cacheinfo, _scenarios);
+        }
+    }
+
+    if (_finished) {
+        _finished->fetchAndAddOrdered(1);
+    }
+}
+
+/**
+ * @brief tell the scenarios which file they are from. Demultiplexed ones are each only a
+ * part of it, so they get "<fingerprint>#<segment>". Otherwise saving the second segment
+ * to the DB would find the first one as made from exactly the same files.
+ */
+void FileImporter::_add_fingerprints(void) {
+    if (_fingerprint.empty()) return;
+    for (size_t k = 0; k < _scenarios.size(); k++) {
+        if (_scenarios.size() > 1) {
+            _scenarios[k]->add_fingerprint(stringbuilder() << _fingerprint << "#" << k);
+        } else {
+            _scenarios[k]->add_fingerprint(_fingerprint);
+        }
+    }
+}
+
+bool FileImporter::_pipelined(void) const {
+    return _args && _args->pipeline;
+}
+
+/**
+ * @brief feed one message into the scenario and handle time jumps
+ * @return scenario for the next message
+ */
+MavlinkScenario* FileImporter::_add_mavlink(MavlinkScenario*scene, const mavlink_message_t & msg) {
+    const int upd = scene->add_mavlink_message(msg);
+    if (0 == upd) return scene;
+
+    // time jump: fwd (+1) or back (-1)
+    timejump_policy_e policy;
+    if (upd > 0) {
+        _n_jumps_fwd++;
+        policy = _policy_fwd;
+    } else {
+        _n_jumps_back++;
+        policy = _policy_back;
+    }
+    if (TIMEJUMP_THRESHOLD == policy) {
+        const MavSystem*sys = scene->get_system_byid(msg.sysid);
+        const double jump = sys ? fabs(sys->get_last_timejump()) : 0.;
+        policy = (jump > _demux_sec) ? TIMEJUMP_DEMUX : TIMEJUMP_ALLOW;
+    }
+    if (TIMEJUMP_IGNORE == policy) return scene;
+    if (TIMEJUMP_DEMUX == policy) {
+        _n_jumps_demuxed++;
+        scene = _new_scenario();
+    } else {
+        _n_jumps_allowed++;
+    }
+    scene->add_mavlink_message(msg, true);
+    return scene;
+}
+
+std::string FileImporter::get_timejump_summary(void) const {
+    const unsigned int total = _n_jumps_fwd + _n_jumps_back;
+    if (0 == total) return "";
+    stringstream ss;
+    ss << _basename << ": " << _n_jumps_fwd << " forward and " << _n_jumps_back << " backward time jump(s)";
+    if (_n_jumps_demuxed > 0) ss << ", " << _n_jumps_demuxed << " demultiplexed";
+    if (_n_jumps_allowed > 0) ss << ", " << _n_jumps_allowed << " allowed";
+    const unsigned int dropped = total - _n_jumps_demuxed - _n_jumps_allowed;
+    if (dropped > 0) ss << ", " << dropped << " message(s) dropped";
+    ss << " -> " << _scenarios.size() << " scenario(s)";
+    return ss.str();
+}
+
+bool FileImporter::_chunked(void) const {
+    if (!_args || !_args->chunked) return false;
+    return QFileInfo(QString::fromStdString(_fullpath)).size() >= 2*CHUNK_MIN_BYTES;
+}
+
+void FileImporter::_log_mavlink_stats(MavlinkScenario*scene, const mavlink_status_t & stats, unsigned int n_skipped, bool with_rx) {
+    stringbuilder sb;
+    sb << "Mavlink parser stats: ";
+    if (with_rx) sb << "#rx=" << (unsigned int)stats.msg_received << ", ";
+    scene->log(MSG_INFO, sb <<
+               "#rx ok=" << stats.packet_rx_success_count <<
+               ", #rx drop=" << stats.packet_rx_drop_count <<
+               ", #buffer ovf=" << (unsigned int)stats.buffer_overrun <<
+               ", #parser err=" << (unsigned int)stats.parse_error <<
+               ", #not selected=" << n_skipped);
+}
+
+/**
+ * @brief split the tlog into one byte range per core and decode them in parallel.
+ * Neighbouring chunks are stitched at the first message start both have seen,
+ * which is a true frame boundary, since the earlier chunk is in sync there.
+ * Each chunk needs its own MavLink channel, and does not wait for one.
+ * @return false if there were not enough channels. Nothing was imported then.
+ */
+bool FileImporter::_import_mavlink_chunked(void) {
+    const uint64_t filesize = QFileInfo(QString::fromStdString(_fullpath)).size();
+    unsigned int nchunks = TaskPool::get_max_threads();
+    if (nchunks > MavlinkParser::get_num_free_channels()) nchunks = MavlinkParser::get_num_free_channels();
+    if (filesize / CHUNK_MIN_BYTES < nchunks) nchunks = filesize / CHUNK_MIN_BYTES;
+    if (nchunks < 2) return false;
+
+    std::vector<ChunkDecoder*> chunks;
+    TaskGroup tasks;
+    for (unsigned int k = 0; k < nchunks; k++) {
+        const uint64_t from = (filesize * k) / nchunks;
+        const uint64_t limit = (k + 1 == nchunks) ? filesize + 1 : (filesize * (k + 1)) / nchunks + CHUNK_OVERLAP_BYTES;
+        chunks.push_back(new ChunkDecoder(_fullpath, _filter, from, limit));
+        tasks.start(chunks.back());
+    }
+    tasks.wait();
+    for (std::vector<ChunkDecoder*>::iterator it = chunks.begin(); it != chunks.end(); ++it) {
+        if ((*it)->starved) {
+            // others took the channels meanwhile
+            for (it = chunks.begin(); it != chunks.end(); ++it) delete *it;
+            return false;
+        }
+    }
+
+    MavlinkScenario*scene = _new_scenario();
+
+    // stitch
+    for (unsigned int k = 1; k < nchunks; k++) {
+        ChunkDecoder*const prev = chunks[k-1];
+        ChunkDecoder*const cur = chunks[k];
+        uint64_t cut = cur->from;
+        bool found = false;
+        for (size_t i = 0; i < cur->records.size() && cur->records[i].start < prev->limit; i++) {
+            const size_t j = prev->find(cur->records[i].start);
+            if (j < prev->records.size() && prev->records[j].start == cur->records[i].start) {
+                cut = cur->records[i].start;
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            scene->log(MSG_WARN, stringbuilder() << "Chunks " << (k-1) << " and " << k << " do not overlap. Messages around offset " << cut << " might be lost or doubled");
+        }
+        prev->end = std::max(prev->begin, prev->find(cut));
+        cur->begin = cur->find(cut);
+    }
+
+    // feed in file order and sum up stats. Overlapping parts are not counted twice.
+    mavlink_status_t stats;
+    memset(&stats, 0, sizeof(stats));
+    unsigned int n_skipped = 0;
+    mavlink_message_t msg;
+    ImportProfile prof; // decode was timed by the chunks; here only counts by type
+    for (std::vector<ChunkDecoder*>::iterator it = chunks.begin(); it != chunks.end(); ++it) {
+        ChunkDecoder*const c = *it;
+        TraceScope trace("add mavlink chunk");
+        for (size_t i = c->begin; i < c->end; i++) {
+            c->unpack(i, msg);
+            if (prof.on) {
+                prof.lap();
+                scene = _add_mavlink(scene, msg);
+                prof.tracked(prof.lap());
+                prof.decoded(msg.msgid, 0);
+            } else {
+                scene = _add_mavlink(scene, msg);
+            }
+        }
+        stats.packet_rx_success_count += c->end - c->begin; // exactly the messages fed in
+        stats.packet_rx_drop_count += c->stats.packet_rx_drop_count;
+        stats.buffer_overrun += c->stats.buffer_overrun;
+        stats.parse_error += c->stats.parse_error;
+        n_skipped += c->n_skipped;
+        delete c;
+    }
+
+    _log_mavlink_stats(scene, stats, n_skipped, false);
+    scene->log(MSG_INFO, stringbuilder() << "Decoded tlog in " << nchunks << " chunks");
+    return true;
+}
+
+bool FileImporter::_import_mavlink(void) {
+    if (_chunked() && _import_mavlink_chunked()) return true;
+    TraceScope trace("parse mavlink");
+
+    MavlinkParser mlp(_fullpath);
+    if (!mlp.valid) {
+        _error = "Cannot open file";
+        return false;
+    }
+    mlp.set_filter(_filter);
+
+    MavlinkScenario*scene = _new_scenario();
+    ImportProfile prof;
+
+    // run it, feed it into scenario
+    if (_pipelined()) {
+        // decode in another thread, while this one builds the data. The decoder also
+        // waits for the ring, therefore its time is not counted, only its messages.
+        SpscRing<mavlink_message_t> ring(PIPELINE_MAVLINK_SLOTS);
+        mavlink_producer_t ctx = { &mlp, &ring };
+        PipelineThread producer(_produce_mavlink, &ctx);
+        producer.start();
+        const mavlink_message_t*msg;
+        while ((msg = ring.wait_pop()) != NULL) {
+            if (prof.on) {
+                prof.lap();
+                scene = _add_mavlink(scene, *msg);
+                prof.tracked(prof.lap());
+                prof.decoded(msg->msgid, 0);
+            } else {
+                scene = _add_mavlink(scene, *msg);
+            }
+            ring.end_pop();
+        }
+        producer.wait();
+    } else if (prof.on) {
+        mavlink_message_t msg;
+        prof.lap();
+        while (mlp.get_next_msg(msg)) {
+            prof.decoded(msg.msgid, prof.lap());
+            scene = _add_mavlink(scene, msg);
+            prof.tracked(prof.lap());
+        }
+    } else {
+        mavlink_message_t msg;
+        while (mlp.get_next_msg(msg)) {
+            scene = _add_mavlink(scene, msg);
+        }
+    }
+    if (prof.on) {
+        prof.read(mlp.get_read_nsec(), mlp.get_read_bytes());
+    }
+    if (mlp.is_starved()) {
+        _error = "No free MavLink channel, too many imports at once";
+        return false;
+    }
+
+    _log_mavlink_stats(scene, *mlp.get_linkstats(), mlp.get_num_skipped());
+    return true;
+}
+
+bool FileImporter::_import_onboard(const std::string & ext) {
+    TraceScope trace("parse onboard");
+    OnboardLogParser*olp = OnboardLogParserFactory::Instance().Create(ext, _filter);
+    if (!olp)  {
+        _error = "No parser for extension " + ext;
+        return false;
+    }
+
+    MavlinkScenario*scene = _new_scenario();
+
+    // send parser info to scene
+    scene->begin_onboard_log(olp->get_parser_name());
+
+    // now go ahead with actual data. Most parsers read or map the file here.
+    ImportProfile prof;
+    prof.lap();
+    {
+        TraceScope trace_load("onboard load");
+        olp->Load(_fullpath, scene->getLogChannel());
+    }
+    if (prof.on) {
+        prof.read(prof.lap(), QFileInfo(QString::fromStdString(_fullpath)).size());
+    }
+    if (!olp->valid) {
+        _error = "Cannot open file";
+        scene->end_onboard_log();
+        delete olp;
+        return false;
+    }
+    if (_args && _args->time_window) {
+        const uint64_t from = (uint64_t)(_args->window_from_sec * 1E6);
+        const uint64_t to = (uint64_t)(_args->window_to_sec * 1E6);
+        if (!olp->set_time_window(from, to)) {
+            scene->log(MSG_WARN, stringbuilder() << "Parser " << olp->get_parser_name() << " does not support time windows, importing everything");
+        }
+    }
+
+    // - do the parsing into the scenario. Same record(s) for all messages.
+    if (_pipelined()) {
+        // decode in another thread, while this one builds the data
+        SpscRing<OnboardData> ring(PIPELINE_ONBOARD_SLOTS);
+        onboard_producer_t ctx = { olp, &ring };
+        PipelineThread producer(_produce_onboard, &ctx);
+        producer.start();
+        const OnboardData*d;
+        while ((d = ring.wait_pop()) != NULL) {
+            if (prof.on) {
+                prof.lap();
+                scene->add_onboard_message(*d);
+                prof.tracked(prof.lap());
+                prof.decoded(*d, 0);
+            } else {
+                scene->add_onboard_message(*d);
+            }
+            ring.end_pop();
+        }
+        producer.wait();
+    } else if (prof.on) {
+        OnboardData d;
+        prof.lap();
+        while (olp->has_more_data()) {
+            if (olp->get_data(d)) {
+                prof.decoded(d, prof.lap());
+                scene->add_onboard_message(d);
+                prof.tracked(prof.lap());
+            }
+        }
+    } else if (olp->supports_batch()) {
+        // runs of the same message go to the series column by column
+        OnboardBatch b;
+        while (olp->has_more_data()) {
+            if (olp->get_batch(b)) {
+                scene->add_onboard_batch(b);
+            }
+        }
+    } else {
+        OnboardData d;
+        while (olp->has_more_data()) {
+            if (olp->get_data(d)) {
+                scene->add_onboard_message(d);
+            }
+        }
+    }
+    scene->end_onboard_log();
+    delete olp;
+    return true;
+}
+
+void FileImporter::run_all(const std::vector<FileImporter*> & jobs, unsigned int nthreads,
+                           Progress_Function progress, void*ctx) {
+    if (jobs.empty()) return;
+    const unsigned int total = jobs.size();
+    (void) Logger::Instance(); // make sure log model is owned by calling thread, not by a worker
+
+    QAtomicInt finished(0);
+    for (std::vector<FileImporter*>::const_iterator it = jobs.begin(); it != jobs.end(); ++it) {
+        (*it)->_finished = &finished;
+    }
+
+    if (1 == nthreads || 1 == total) {
+        // serial, in calling thread
+        unsigned int done = 0;
+        for (std::vector<FileImporter*>::const_iterator it = jobs.begin(); it != jobs.end(); ++it) {
+            (*it)->run();
+            if (progress) progress(ctx, ++done, total);
+        }
+    } else {
+        TaskGroup tasks(nthreads);
+        for (std::vector<FileImporter*>::const_iterator it = jobs.begin(); it != jobs.end(); ++it) {
+            tasks.start(*it);
+        }
+        unsigned int reported = 0;
+        while (!tasks.wait(100)) {
+            const unsigned int done = finished.fetchAndAddRelaxed(0);
+            if (progress && done != reported) {
+                reported = done;
+                progress(ctx, done, total);
+            }
+            Logger::Instance().flush();
+        }
+        if (progress) progress(ctx, total, total);
+    }
+
+    for (std::vector<FileImporter*>::const_iterator it = jobs.begin(); it != jobs.end(); ++it) {
+        (*it)->_finished = NULL;
+    }
+    Logger::Instance().flush();
+}
+
+bool FileImporter::guess_starttime(const std::string & basename, uint64_t & time_epoch_usec) {
+    QRegExp rex("\\d{4}-\\d{2}-\\d{2}[- ]\\d{2}-\\d{2}(-\\d{2})?");
+    if (rex.indexIn(QString::fromStdString(basename)) == -1) return false;
+
+    QString str_datetime = rex.cap(0);
+    // remove hyphen between date and time, if there is one
+    if (str_datetime.length()>10) {
+        str_datetime[10] = ' ';
+    }
+    return string_to_epoch_usec(str_datetime.toStdString(), time_epoch_usec);
+}
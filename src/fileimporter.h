@@ -0,0 +1,161 @@
+/**
+ * @file fileimporter.h
+ * @brief Parses and processes one log file into its own scenario. Can run in a worker
+ * thread, so that several files are imported in parallel.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef FILEIMPORTER_H
+#define FILEIMPORTER_H
+
+#include <string>
+#include <vector>
+#include <inttypes.h>
+#include <QRunnable>
+#include <QAtomicInt>
+#include "mavlinkscenario.h"
+#include "cmdlineargs.h"
+
+/**
+ * @brief Imports one file (MavLink or onboard log) into one or more temporary
+ * scenarios and runs MavlinkScenario::process() on them. Nothing here touches
+ * the GUI, therefore it can be handed to a TaskGroup. The caller merges the
+ * results in file order afterwards, which keeps the outcome deterministic.
+ *
+ * If nothing but the time jump settings influences the result, it is taken from
+ * the file's ScenarioCache, and one is written after parsing.
+ */
+class FileImporter : public QRunnable
+{
+public:
+    /**
+     * @brief what to do when add_mavlink_message() reports a time jump
+     */
+    typedef enum {
+        TIMEJUMP_IGNORE, ///< drop the message (as headless mode always did)
+        TIMEJUMP_ALLOW,  ///< tolerate the jump, stay in same scenario
+        TIMEJUMP_DEMUX,  ///< start a new scenario at the jump
+        TIMEJUMP_THRESHOLD ///< demux at jumps bigger than the threshold, allow smaller ones
+    } timejump_policy_e;
+
+    /**
+     * @brief called from run_all() in the calling thread while the workers are busy
+     */
+    typedef void (*Progress_Function)(void*ctx, unsigned int done, unsigned int total);
+
+    /**
+     * @param args also gives the time jump policy, see CmdlineArgs::time_jumps
+     */
+    FileImporter(const std::string & fullpath, const CmdlineArgs*const args, double delay_sec = 0.0);
+    ~FileImporter();
+
+    /**
+     * @param demux_sec for TIMEJUMP_THRESHOLD. <=0: keep the current one
+     */
+    void set_timejump_policy(timejump_policy_e fwd, timejump_policy_e back, double demux_sec = 0.);
+
+    /**
+     * @brief import only these topics. Default is what the command line says.
+     * @param filter NULL=all. Must outlive run().
+     */
+    void set_topic_filter(const TopicFilter*filter) { _filter = filter; }
+
+    /**
+     * @brief the content fingerprint of the file, if the caller has it already,
+     * see ScenarioCache::get_fingerprint(). Otherwise run() computes it.
+     */
+    void set_fingerprint(const std::string & fp) { _fingerprint = fp; }
+    const std::string & get_fingerprint(void) const { return _fingerprint; }
+
+    // implement QRunnable. Can be called again, e.g., with another time jump policy.
+    void run(void);
+
+    /**
+     * @brief wait for all given importers to complete, using at most nthreads workers
+     * @param jobs the importers. They are not deleted.
+     * @param nthreads number of workers. 0=one per core, 1=do it in calling thread.
+     * @param progress if not NULL, this is called whenever another file is done
+     * @param ctx handed to progress
+     */
+    static void run_all(const std::vector<FileImporter*> & jobs, unsigned int nthreads,
+                        Progress_Function progress = NULL, void*ctx = NULL);
+
+    /**
+     * @brief guess the start time of the logfile by looking at the file name.
+     * Basename usually looks like "2014-04-10 15-41-26".
+     * @return true if a date was found
+     */
+    static bool guess_starttime(const std::string & basename, uint64_t & time_epoch_usec);
+
+    bool is_parsed(void) const { return _parsed; }
+    const std::string & get_filename(void) const { return _fullpath; }
+    const std::string & get_error(void) const { return _error; }
+    unsigned int get_num_timejumps_fwd(void) const { return _n_jumps_fwd; }
+    unsigned int get_num_timejumps_back(void) const { return _n_jumps_back; }
+
+    /**
+     * @brief what was done with the time jumps, for the user. Empty if there were none.
+     */
+    std::string get_timejump_summary(void) const;
+
+    /**
+     * @brief the resulting scenarios. Still owned by this class.
+     */
+    const std::vector<MavlinkScenario*> & get_scenarios(void) const { return _scenarios; }
+
+private:
+    bool _import_mavlink(void);
+    bool _import_mavlink_chunked(void);
+    bool _chunked(void) const;
+    static void _log_mavlink_stats(MavlinkScenario*scene, const mavlink_status_t & stats, unsigned int n_skipped, bool with_rx = true); ///< with_rx=false: chunks have no msg_received
+    MavlinkScenario* _add_mavlink(MavlinkScenario*scene, const mavlink_message_t & msg);
+    bool _pipelined(void) const;
+    bool _cacheable(void) const;
+    std::string _cache_key(void) const;
+    bool _import_onboard(const std::string & ext);
+    MavlinkScenario* _new_scenario(void);
+    void _add_fingerprints(void);
+    void _clear(void);
+
+    /****************************************
+     *     DATA MEMBERS
+     ****************************************/
+    std::string        _fullpath;
+    std::string        _basename;
+    const CmdlineArgs* _args;
+    double             _delay_sec;
+    timejump_policy_e  _policy_fwd;
+    timejump_policy_e  _policy_back;
+    double             _demux_sec;
+    QAtomicInt*        _finished;
+    const TopicFilter* _filter;
+    std::string        _fingerprint;
+
+    // results
+    bool         _parsed;
+    std::string  _error;
+    unsigned int _n_jumps_fwd;
+    unsigned int _n_jumps_back;
+    unsigned int _n_jumps_allowed;
+    unsigned int _n_jumps_demuxed;
+    std::vector<MavlinkScenario*> _scenarios;
+};
+
+#endif // FILEIMPORTER_H
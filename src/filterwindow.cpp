@@ -1,6 +1,8 @@
 #include "filterwindow.h"
 #include "ui_filterwindow.h"
 #include <iostream>
+#include <vector>
+#include <math.h>
 #include <QStringListModel>
 #include <QStandardItemModel>
 #include <QMessageBox>
@@ -17,12 +19,11 @@ FilterWindow::FilterWindow(const DBConnector::db_props_t & dbprops, MainWindow *
     QDialog(parent),
     ui(new Ui::FilterWindow),
     _dbResultModel(NULL),
+    _dbprops(dbprops),
     _mw(parent)
 {
     ui->setupUi(this);
     _init();
-    DBConnector dbcon(dbprops);
-    dB=dbcon.getDB();
     ui->tableResults->horizontalHeader()->setStretchLastSection(true);
     ui->tableResults->setSortingEnabled(true);
 }
@@ -59,8 +60,7 @@ void FilterWindow::on_buttonCancel_clicked() {
 
 // TODO: escape!
 void FilterWindow::on_buttonApplyFilters_clicked() {
-    if(!dB.open()) {
-        cerr << "Cannot open DB connection!" <<   dB.lastError().text().toStdString() << endl;
+    if(!_openDB()) {
         return;
     }
 
@@ -70,10 +70,7 @@ void FilterWindow::on_buttonApplyFilters_clicked() {
 
     if (max == 0) { // if there are no filters, then list all
         QMessageBox msgbox(QMessageBox::Information, "Whoops", QString("No filter added...showing all database entries."));  msgbox.exec();
-        QSqlQuery qry;
-        QString strQueryAll;
-        strQueryAll="select ID from scenarios;";
-        qry.prepare(strQueryAll);
+        QSqlQuery qry = DBConnector::prepared(dB, "select ID from scenarios;");
         if(!qry.exec()) {
            cerr << "Error occured during execution of Query: "<< qry.lastError().text().toStdString() << endl;
            return;
@@ -90,20 +87,30 @@ void FilterWindow::on_buttonApplyFilters_clicked() {
             _mw->updateProgressBarValue(0,max);
         }
 
+        // see DBConnector: table dataGroupStats
+        const bool hasStats = DBConnector::hasTable(dB, "dataGroupStats");
+        const bool hasChunks = DBConnector::hasTable(dB, "dataChunks");
+        bool useServer = true;
+
         // ## for each Filter
         for (int i=0; i<max; i++) {            
 
             QStringList DATA_GROUP_ID;
             QString strQueryGroups;
-            QSqlQuery qry;
 
             const QString thisFilter_operator = filterComp[i];
             const QString thisFilter_value = filterValues[i];
             const double thisFilter_time = filterTime[i].toDouble();
 
-            //get DATA_GROUP_ID of current condition
-            strQueryGroups="select ID from dataGroups where FULLPATH=:datapath && VALID=1;";
-            qry.prepare(strQueryGroups);            
+            //get DATA_GROUP_ID of current condition. With statistics, many groups are decided right here.
+            QStringList dataGroup_IDs_timefiltered;
+            if (hasStats) {
+                strQueryGroups="select g.ID, s.VALUE_MIN, s.VALUE_MAX, s.TIME_MIN, s.TIME_MAX from dataGroups g "
+                               "LEFT JOIN dataGroupStats s ON s.DATAGROUP_ID=g.ID where g.FULLPATH=:datapath AND g.VALID=1;";
+            } else {
+                strQueryGroups="select ID from dataGroups where FULLPATH=:datapath AND VALID=1;";
+            }
+            QSqlQuery qry = DBConnector::prepared(dB, strQueryGroups);
             qry.bindValue(":datapath", filterData[i]);
 
             if(!qry.exec()) {
@@ -112,10 +119,35 @@ void FilterWindow::on_buttonApplyFilters_clicked() {
                return;
             }
             while(qry.next()) {
+                if (hasStats && !qry.value(1).isNull()) {
+                    const int decided = _decideByStats(thisFilter_operator, thisFilter_value.toDouble(), qry.value(1).toDouble(), qry.value(2).toDouble());
+                    if (decided < 0) continue; // never
+                    const double duration = qry.value(4).toDouble() - qry.value(3).toDouble();
+                    if (decided > 0 && (thisFilter_time <= 0 || duration >= thisFilter_time/1000)) {
+                        dataGroup_IDs_timefiltered.append(qry.value(0).toString()); // always, and long enough
+                        continue;
+                    }
+                }
                 DATA_GROUP_ID.append(qry.value(0).toString());
             }
 
-            // ## now get all data that fulfills the condition of current filter
+            // groups saved to table dataChunks have no rows in table data, they are decided here
+            if (hasChunks && !DATA_GROUP_ID.empty() &&
+                !_filterChunks(DATA_GROUP_ID, thisFilter_operator, thisFilter_value.toDouble(), thisFilter_time, dataGroup_IDs_timefiltered)) {
+                if (_mw) _mw->hideProgressBar();
+                return;
+            }
+
+            // ## now get all data that fulfills the condition of current filter. Preferably the DB does it all.
+            QStringList ScenarioIDsServer;
+            if (DATA_GROUP_ID.empty() ||
+                (useServer && _filterOnServer(DATA_GROUP_ID, thisFilter_operator, thisFilter_value, thisFilter_time, ScenarioIDsServer))) {
+                ScenarioIDsResult.append(dataGroupIDs_to_ScenarioIDs(dataGroup_IDs_timefiltered));
+                ScenarioIDsResult.append(ScenarioIDsServer.toSet().toList());
+                if (_mw) _mw->updateProgressBarValue(i+1,max);
+                continue;
+            }
+            useServer = false; // e.g., the DB has no window functions
             stringQry="select * from data where (";
             for(int a=0; a<DATA_GROUP_ID.size(); a++) {
                 if (a>0) {
@@ -125,7 +157,7 @@ void FilterWindow::on_buttonApplyFilters_clicked() {
             }
             // FIXME: sanitize thisFilter_operator. we cannot bind it, unfortunately
             stringQry+=") AND (VALUE " + thisFilter_operator +" ?);";
-            QSqlQuery qry2;
+            QSqlQuery qry2(dB);
             qry2.prepare(stringQry);
             // positional bindings
             for(int a=0; a<DATA_GROUP_ID.size(); a++) {
@@ -155,7 +187,7 @@ void FilterWindow::on_buttonApplyFilters_clicked() {
 
             // filter duplicates by building a set, then check whether time criterion applies
             QStringList dataGroup_IDs_notimefilter_set = data_dataGroupIDs.toSet().toList();
-            QStringList dataGroup_IDs_timefiltered = _filterTime(data_dataGroupIDs, dataGroup_IDs_notimefilter_set, data_IDs, data_timestamp, thisFilter_time);
+            dataGroup_IDs_timefiltered.append(_filterTime(data_dataGroupIDs, dataGroup_IDs_notimefilter_set, data_IDs, data_timestamp, thisFilter_time));
 
             // finally...as search result only store the scenario IDs
             QStringList ScenarioIDs;
@@ -185,7 +217,6 @@ void FilterWindow::on_buttonApplyFilters_clicked() {
     }
 
     _showResultsTable(ScenarioIDsResult);
-    dB.close();
     if (_mw) _mw->hideProgressBar();
 }
 
@@ -236,17 +267,16 @@ void FilterWindow::on_buttonSavePreset_clicked()
         QString text = QInputDialog::getText(this, tr("QInputDialog::getText()"), tr("Preset-Name:"), QLineEdit::Normal, "", &ok);
 
         if (ok && !text.isEmpty()) {
-            if( !dB.open() ) {
-                std::cerr << "Error: Could not open DB connection!" <<   dB.lastError().text().toStdString() << std::endl;
+            if( !_openDB() ) {
                 return;
             }
 
             // save preset name
             QString presetID;
             {
-                QSqlQuery qry;
+                QSqlQuery qry(dB);
                 QString str;
-                str= "insert into presetsName (PRESET_NAME) value (:text);";
+                str= "insert into presetsName (PRESET_NAME) values (:text);";
                 qry.prepare(str);
                 qry.bindValue(":text", text);
                 if( !qry.exec() ) {
@@ -255,10 +285,9 @@ void FilterWindow::on_buttonSavePreset_clicked()
                 }
 
                 // get ID of the new preset
-                qry.prepare("select LAST_INSERT_ID();");
+                qry.prepare(DBBackend::get(_dbprops.backend)->lastInsertId());
                 if( !qry.exec() ) {
                    std::cerr << "Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
-                   dB.close();
                    return;
                 }
                 qry.next();
@@ -267,7 +296,7 @@ void FilterWindow::on_buttonSavePreset_clicked()
 
             // save filters for the new preset
             for (int i=0; i<filterData.size(); i++) {
-                QSqlQuery qry;
+                QSqlQuery qry(dB);
                 QString str;
                 str = "INSERT INTO presetsData (PRESET_ID, filterValues, filterOperator, filterData, filterTime) values ";
                 str+= "(:presetID, :filterValues, :filterComp, :filterData, :filterTime);";
@@ -279,13 +308,11 @@ void FilterWindow::on_buttonSavePreset_clicked()
                 qry.bindValue(":filterTime", filterTime[i]);
                 if( !qry.exec() ) {
                    std::cerr << "Error occured during execution of Query: "<<qry.lastError().text().toStdString() << std::endl;
-                   dB.close();
                    return;
                 }
             }
             ui->comboBoxPresets->addItem(text);
             QMessageBox::information( NULL, "OK","Preset saved", QMessageBox::Ok);
-            dB.close();
         } else {
             QMessageBox::warning( NULL, "Warning","No Preset Name", QMessageBox::Ok);
         }
@@ -296,8 +323,7 @@ void FilterWindow::on_buttonSavePreset_clicked()
 
 void FilterWindow::on_buttonPreset_clicked()
 {    
-    if( !dB.open()) {
-        std::cerr << "Error: Could not open DB connection!" << dB.lastError().text().toStdString() << std::endl;
+    if( !_openDB() ) {
         return;
     }
 
@@ -307,9 +333,7 @@ void FilterWindow::on_buttonPreset_clicked()
     // get preset ID: FIXME: use JOIN
     QString ID;
     {
-        QSqlQuery qry;
-        QString str="SELECT ID FROM presetsName WHERE PRESET_NAME=:name;";
-        qry.prepare(str);
+        QSqlQuery qry = DBConnector::prepared(dB, "SELECT ID FROM presetsName WHERE PRESET_NAME=:name;");
         qry.bindValue(":name", preset);
         if( !qry.exec() )  {
             cerr << "Error occured during execution of Query: "<< qry.lastError().text().toStdString() << endl;
@@ -321,9 +345,7 @@ void FilterWindow::on_buttonPreset_clicked()
 
     // get preset filters
     {
-        QSqlQuery qry;
-        QString str ="SELECT * FROM presetsData WHERE PRESET_ID = :ID;";
-        qry.prepare(str);
+        QSqlQuery qry = DBConnector::prepared(dB, "SELECT * FROM presetsData WHERE PRESET_ID = :ID;");
         qry.bindValue(":ID", ID);
         if( !qry.exec() ) {
             cerr << "Error occured during execution of Query: "<< qry.lastError().text().toStdString() << endl;
@@ -359,7 +381,6 @@ void FilterWindow::on_buttonPreset_clicked()
         _checkSize(); //check size of arrays
     }
 
-    dB.close();
 }
 
 
@@ -410,16 +431,14 @@ void FilterWindow::_init() {
 
 void FilterWindow::setUpComboBox() {
     //get datagroups from DB to fill ComboBox
-    if( !dB.open() ) {
-        std::cerr << "Error: No DB connection!" <<   dB.lastError().text().toStdString() << std::endl;
+    if( !_openDB() ) {
         return;
     }
 
     QStringList boxData;
     {
-        QString s="SELECT FULLPATH FROM dataGroups;";
-        QSqlQuery qry;
-        qry.prepare(s);
+        QString s;
+        QSqlQuery qry = DBConnector::prepared(dB, "SELECT FULLPATH FROM dataGroups;");
         if( !qry.exec() ) {
            cerr << "Error occured during execution of Query: "<< qry.lastError().text().toStdString() << endl;
            return;
@@ -434,9 +453,8 @@ void FilterWindow::setUpComboBox() {
 
     QStringList presetNames;
     {
-        QSqlQuery qry;
-        QString s="select PRESET_NAME from presetsName";
-        qry.prepare(s);
+        QString s;
+        QSqlQuery qry = DBConnector::prepared(dB, "select PRESET_NAME from presetsName");
         if( !qry.exec() ) {
             cerr << "Error occured during execution of Query: "<< qry.lastError().text().toStdString() << endl;
             return;
@@ -452,7 +470,6 @@ void FilterWindow::setUpComboBox() {
     presetNames.sort();
     ui->comboBoxData->addItems(boxData);
     ui->comboBoxPresets->addItems(presetNames);
-    dB.close();
 }
 
 QStringList FilterWindow::dataGroupIDs_to_ScenarioIDs(QStringList const &dataGroup_IDs) {
@@ -462,9 +479,7 @@ QStringList FilterWindow::dataGroupIDs_to_ScenarioIDs(QStringList const &dataGro
         //get System_ID from dataGroup_IDs // FIXME: use JOIN
         QString sys_id;
         {
-            QSqlQuery qry1;
-            QString str1 = "SELECT SYSTEM_ID FROM dataGroups WHERE ID =:ID;";
-            qry1.prepare(str1);
+            QSqlQuery qry1 = DBConnector::prepared(dB, "SELECT SYSTEM_ID FROM dataGroups WHERE ID =:ID;");
             qry1.bindValue(":ID", dataGroup_IDs[i]);
             if( !qry1.exec()) {
                cerr << "Error occured during execution of Query: "<< qry1.lastError().text().toStdString() << endl;
@@ -476,9 +491,7 @@ QStringList FilterWindow::dataGroupIDs_to_ScenarioIDs(QStringList const &dataGro
 
         //get Scenario_ID from System_ID
         {
-            QSqlQuery qry2;
-            QString str2 = "select SCENARIO_ID FROM systems WHERE ID=:ID;";
-            qry2.prepare(str2);
+            QSqlQuery qry2 = DBConnector::prepared(dB, "select SCENARIO_ID FROM systems WHERE ID=:ID;");
             qry2.bindValue(":ID", sys_id);
             if( !qry2.exec() ) {
                cerr << "Error occured during execution of Query: "<< qry2.lastError().text().toStdString() << endl;
@@ -517,10 +530,9 @@ void FilterWindow::_getScenarioDetails(const QStringList & ID, QStringList & Sce
     ScenarioDates.clear(); ScenarioDescs.clear(); ScenarioNames.clear();
     if (ID.size()==0) return;
 
-    QString strQry="SELECT TIME_START, DESCRIPTION, FILENAME FROM scenarios WHERE ID=:id;";
+    const QString strQry="SELECT TIME_START, DESCRIPTION, FILENAME FROM scenarios WHERE ID=:id;";
     for (int i=0; i<ID.size(); i++) {
-        QSqlQuery qry;
-        qry.prepare(strQry);
+        QSqlQuery qry = DBConnector::prepared(dB, strQry);
         qry.bindValue(":id", ID[i]);
 
         if( !qry.exec() ) {
@@ -542,6 +554,171 @@ void FilterWindow::_getScenarioDetails(const QStringList & ID, QStringList & Sce
     }
 }
 
+bool FilterWindow::_openDB(void) {
+    // cheap: the connection stays open in the pool, unless it was idle for long
+    DBConnector dbcon(_dbprops);
+    dB = dbcon.getDB();
+    if (!dbcon.open()) {
+        cerr << "Cannot open DB connection!" << dB.lastError().text().toStdString() << endl;
+        return false;
+    }
+    return true;
+}
+
+bool FilterWindow::_filterOnServer(const QStringList & dataGroupIDs, const QString & op, const QString & value, double fTime,
+                                   QStringList & scenarioIDs) {
+    // operators cannot be bound, therefore only known ones
+    if (op != ">" && op != ">=" && op != "<" && op != "<=" && op != "=") return false;
+    const double time_sec = fTime/1000;
+
+    QString groups;
+    for (int a=0; a<dataGroupIDs.size(); a++) {
+        if (a>0) groups += ",";
+        groups += "?";
+    }
+    QString str;
+    if (time_sec <= 0) {
+        // any sample will do
+        str = "SELECT DISTINCT sys.SCENARIO_ID FROM (SELECT DISTINCT DATAGROUP_ID FROM data WHERE DATAGROUP_ID IN (" + groups + ") "
+              "AND VALUE " + op + " ?) hits "
+              "INNER JOIN dataGroups g ON g.ID=hits.DATAGROUP_ID INNER JOIN systems sys ON sys.ID=g.SYSTEM_ID;";
+    } else {
+        /*
+         * gaps and islands: in time order, the difference of the row number among all samples
+         * and among those with the same outcome is constant for a run of samples with the same
+         * outcome. A run which fulfills the condition is an island, and it must be long enough.
+         */
+        str = "SELECT DISTINCT sys.SCENARIO_ID FROM ("
+              " SELECT DATAGROUP_ID FROM ("
+              "  SELECT DATAGROUP_ID, TIME, ok,"
+              "   CAST(ROW_NUMBER() OVER (PARTITION BY DATAGROUP_ID ORDER BY TIME, ID) AS SIGNED) -"
+              "   CAST(ROW_NUMBER() OVER (PARTITION BY DATAGROUP_ID, ok ORDER BY TIME, ID) AS SIGNED) AS island"
+              "  FROM (SELECT DATAGROUP_ID, TIME, ID, (VALUE " + op + " ?) AS ok FROM data WHERE DATAGROUP_ID IN (" + groups + ")) samples"
+              " ) runs WHERE ok=1 GROUP BY DATAGROUP_ID, island HAVING MAX(TIME) - MIN(TIME) >= ?"
+              ") islands "
+              "INNER JOIN dataGroups g ON g.ID=islands.DATAGROUP_ID INNER JOIN systems sys ON sys.ID=g.SYSTEM_ID;";
+    }
+    QSqlQuery qry(dB);
+    qry.setForwardOnly(true);
+    if (!qry.prepare(str)) return false;
+    int pos = 0;
+    if (time_sec > 0) qry.bindValue(pos++, value.toDouble());
+    for (int a=0; a<dataGroupIDs.size(); a++) {
+        qry.bindValue(pos++, dataGroupIDs[a].toULongLong());
+    }
+    if (time_sec <= 0) {
+        qry.bindValue(pos++, value.toDouble());
+    } else {
+        qry.bindValue(pos++, time_sec);
+    }
+    if (!qry.exec()) {
+        cerr << "Cannot evaluate filter in the database, doing it here: " << qry.lastError().text().toStdString() << endl;
+        return false;
+    }
+    while (qry.next()) {
+        scenarioIDs.append(qry.value(0).toString());
+    }
+    return true;
+}
+
+bool FilterWindow::_filterChunks(QStringList & dataGroupIDs, const QString & op, double value, double fTime, QStringList & hits) {
+    const double time_sec = fTime/1000;
+    QStringList plain;
+    QSqlQuery qry = DBConnector::prepared(dB, "SELECT SEQ, TIME_MIN, TIME_MAX, VALUE_MIN, VALUE_MAX FROM dataChunks WHERE DATAGROUP_ID=:did ORDER BY SEQ;");
+    QSqlQuery qsamples = DBConnector::prepared(dB, "SELECT N, TIMES, VALS FROM dataChunks WHERE DATAGROUP_ID=:did AND SEQ=:seq;");
+    for (int i=0; i<dataGroupIDs.size(); i++) {
+        qry.bindValue(":did", dataGroupIDs[i]);
+        if (!qry.exec()) {
+            cerr << "Error occured during execution of Query: "<< qry.lastError().text().toStdString() << endl;
+            return false;
+        }
+        // bounds first, such that the samples are not fetched while the query is being read
+        std::vector<unsigned long long> seq;
+        std::vector<double> tmin, tmax, vmin, vmax;
+        while (qry.next()) {
+            seq.push_back(qry.value(0).toULongLong());
+            tmin.push_back(qry.value(1).toDouble());
+            tmax.push_back(qry.value(2).toDouble());
+            vmin.push_back(qry.value(3).isNull() ? NAN : qry.value(3).toDouble());
+            vmax.push_back(qry.value(4).isNull() ? NAN : qry.value(4).toDouble());
+        }
+        if (seq.empty()) {
+            plain.append(dataGroupIDs[i]); // samples are in table data
+            continue;
+        }
+
+        // runs of samples which fulfill it, in time order. A chunk decided by its bounds continues or ends one as a whole.
+        bool inRun = false, hit = false;
+        double runStart = 0.;
+        for (size_t c = 0; c < seq.size() && !hit; ++c) {
+            const int decided = (isnan(vmin[c]) || isnan(vmax[c])) ? 0 : _decideByStats(op, value, vmin[c], vmax[c]);
+            if (decided < 0) {
+                inRun = false;
+                continue;
+            }
+            if (decided > 0) {
+                if (!inRun) runStart = tmin[c];
+                inRun = true;
+                hit = (time_sec <= 0 || tmax[c] - runStart >= time_sec);
+                continue;
+            }
+            qsamples.bindValue(":did", dataGroupIDs[i]);
+            qsamples.bindValue(":seq", (qulonglong)seq[c]);
+            if (!qsamples.exec() || !qsamples.next()) {
+                cerr << "Error occured during execution of Query: "<< qsamples.lastError().text().toStdString() << endl;
+                return false;
+            }
+            std::vector<double> time, val;
+            if (!DBConnector::decodeDataChunk(qsamples.value(1).toByteArray(), qsamples.value(2).toByteArray(), qsamples.value(0).toUInt(),
+                                              time, val, -INFINITY, INFINITY)) {
+                cerr << "Corrupt chunk " << seq[c] << " of data group " << dataGroupIDs[i].toStdString() << endl;
+                return false;
+            }
+            for (size_t k = 0; k < time.size() && !hit; ++k) {
+                if (!_compare(op, val[k], value)) {
+                    inRun = false;
+                    continue;
+                }
+                if (!inRun) runStart = time[k];
+                inRun = true;
+                hit = (time_sec <= 0 || time[k] - runStart >= time_sec);
+            }
+        }
+        if (hit) hits.append(dataGroupIDs[i]);
+    }
+    dataGroupIDs = plain;
+    return true;
+}
+
+bool FilterWindow::_compare(const QString & op, double v, double value) {
+    if (op == ">") return v > value;
+    if (op == ">=") return v >= value;
+    if (op == "<") return v < value;
+    if (op == "<=") return v <= value;
+    if (op == "=") return v == value;
+    return false;
+}
+
+int FilterWindow::_decideByStats(const QString & op, double value, double vmin, double vmax) {
+    if (op == ">") {
+        if (vmin > value) return 1;
+        if (vmax <= value) return -1;
+    } else if (op == ">=") {
+        if (vmin >= value) return 1;
+        if (vmax < value) return -1;
+    } else if (op == "<") {
+        if (vmax < value) return 1;
+        if (vmin >= value) return -1;
+    } else if (op == "<=") {
+        if (vmax <= value) return 1;
+        if (vmin > value) return -1;
+    } else if (op == "=") {
+        if (vmin == value && vmax == value) return 1;
+        if (value < vmin || value > vmax) return -1;
+    }
+    return 0;
+}
+
 QStringList FilterWindow::_filterTime(QStringList const &data_datagroup_IDs, const QStringList &data_datagroup_IDs_nodouble, QStringList const &data_IDs,
                                       QStringList const &Times, double const &fTime) {
     int startidx=0;
@@ -575,7 +752,7 @@ QStringList FilterWindow::_filterTime(QStringList const &data_datagroup_IDs, con
                     // if IDs are still ascending w/o gaps...
                     if (data_IDs[dataidx-1].toInt() == data_IDs[dataidx].toInt()-1) {
                         // check if that has been going on for long enough...
-                        if (Times[dataidx-1].toDouble() - Times[startidx].toDouble() > time_sec) {
+                        if (Times[dataidx-1].toDouble() - Times[startidx].toDouble() >= time_sec) {
                             dataGroup_IDs_compliant.append(data_datagroup_IDs_nodouble[currentGroup]);
                             break; // finish with this datagroup, it is compliant
                         }
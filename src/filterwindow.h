@@ -82,6 +82,50 @@ private:
     QStringList _filterTime(const QStringList &datagroupIDs, const QStringList & datagroupIDs_nodouble, const QStringList &data_IDs,
                             const QStringList &Times, const double &fTime);
 
+    /**
+     * @brief evaluate a filter completely in the DB, which needs window functions (MySQL 8, MariaDB 10.2)
+     * @param dataGroupIDs the groups to look at
+     * @param op operator of the filter, e.g. ">"
+     * @param value value of the filter
+     * @param fTime the condition has to hold for this long, in ms. <=0: one sample is enough
+     * @param scenarioIDs result: scenarios with a group that fulfills the filter
+     * @return false if the DB cannot do it
+     */
+    bool _filterOnServer(const QStringList & dataGroupIDs, const QString & op, const QString & value, double fTime,
+                         QStringList & scenarioIDs);
+
+    /**
+     * @brief evaluate a filter for the groups whose samples are in table dataChunks, which have
+     * no rows in table data. Chunks are decided by their bounds where possible, only the others
+     * are fetched and decoded here.
+     * @param dataGroupIDs in: the groups to look at, out: those which are not in table dataChunks
+     * @param op operator of the filter, e.g. ">"
+     * @param value value of the filter
+     * @param fTime the condition has to hold for this long, in ms. <=0: one sample is enough
+     * @param hits result: groups that fulfill the filter
+     * @return false on error
+     */
+    bool _filterChunks(QStringList & dataGroupIDs, const QString & op, double value, double fTime, QStringList & hits);
+
+    /**
+     * @return true if sample v fulfills the filter
+     */
+    static bool _compare(const QString & op, double v, double value);
+
+    /**
+     * @brief decide a filter from the min/max of a data group (table dataGroupStats)
+     * @param op operator of the filter, e.g. ">"
+     * @param value value of the filter
+     * @return 1 if all samples fulfill it<br>-1 if none does<br>0 if the samples have to be checked
+     */
+    static int _decideByStats(const QString & op, double value, double vmin, double vmax);
+
+    /**
+     * @brief fetch the pooled connection into dB, and open it if it is not yet
+     * @return false if it cannot be opened
+     */
+    bool _openDB(void);
+
      /** @brief Model for table view*/
     QStandardItemModel *filterModel;
 
@@ -116,6 +160,9 @@ private:
     /** @brief Object to connect to Database */
     QSqlDatabase dB;
 
+    /** @brief login data of the database */
+    DBConnector::db_props_t _dbprops;
+
     MainWindow*_mw;
 
 private slots:
@@ -0,0 +1,341 @@
+/**
+ * @file livesource.cpp
+ * @brief Receives MavLink from a network or serial link and feeds it into a scenario as it arrives.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <string.h>
+#include <sstream>
+#include <iomanip>
+#include <QUdpSocket>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QTimer>
+#include <QFileInfo>
+#ifdef WITH_SERIALPORT
+    #include <QSerialPort>
+#endif
+#include "livesource.h"
+#include "mavlinkparser.h"
+#include "onboardlogparserfactory.h"
+#include "filefun.h"
+#include "stringfun.h"
+#include "profiler.h"
+
+using namespace std;
+
+#define LIVE_READ_BUFLEN (64*1024)     ///< bytes taken from a stream per read
+#define LIVE_TCP_TIMEOUT_MSEC 3000     ///< for connecting
+#define LIVE_SERIAL_DEFAULT_BAUD 57600 ///< usual for telemetry radios
+#define LIVE_FILE_POLL_MSEC 500        ///< how often a followed file is looked at
+#define LIVE_FILE_MAX_MSGS 20000       ///< read per poll at most, such that the GUI stays responsive
+#define LIVE_NO_CHANNEL "all MavLink channels are in use by imports, try again when they are done"
+
+LiveSource::LiveSource(QObject *parent) : QObject(parent), _udp(NULL), _stream(NULL), _tlog(NULL), _olp(NULL), _poll(NULL), _scen(NULL),
+    _allow_jumps(true), _chan(-1), _n_msgs(0), _n_jumps(0), _n_bytes(0), _t_open_nsec(0) {
+    memset(&_status, 0, sizeof(_status));
+}
+
+LiveSource::~LiveSource() {
+    close();
+}
+
+bool LiveSource::open(const std::string & spec, MavlinkScenario*scen, bool allow_jumps) {
+    close();
+    _error.clear();
+    if (!scen) {
+        _error = "no scenario";
+        return false;
+    }
+    const size_t colon = spec.find(':');
+    if (string::npos == colon) {
+        _error = "source must be udp:..., tcp:..., serial:... or file:...";
+        return false;
+    }
+    string kind = spec.substr(0, colon);
+    kind = lcase(kind);
+    const string args = spec.substr(colon + 1);
+
+    bool ok;
+    if (kind.compare("udp") == 0) {
+        ok = _open_udp(args);
+    } else if (kind.compare("tcp") == 0) {
+        ok = _open_tcp(args);
+    } else if (kind.compare("serial") == 0) {
+        ok = _open_serial(args);
+    } else if (kind.compare("file") == 0) {
+        _scen = scen; // the onboard log is begun in there
+        ok = _open_file(args);
+    } else {
+        _error = "unknown kind of source \"" + kind + "\"";
+        ok = false;
+    }
+    if (!ok) {
+        close();
+        return false;
+    }
+
+    _spec = spec;
+    _scen = scen;
+    _allow_jumps = allow_jumps;
+    if (!_tlog && !_olp) {
+        // files have their parser. Do not make the GUI wait for background imports to give one back
+        _chan = MavlinkParser::_acquire_channel(0);
+        if (_chan < 0) {
+            _error = LIVE_NO_CHANNEL;
+            close();
+            return false;
+        }
+    }
+    memset(&_status, 0, sizeof(_status));
+    _n_msgs = 0;
+    _n_jumps = 0;
+    _n_bytes = 0;
+    _t_open_nsec = Profiler::now_nsec();
+    return true;
+}
+
+bool LiveSource::_open_udp(const std::string & args) {
+    // [ADDRESS:]PORT
+    QHostAddress addr = QHostAddress::Any;
+    string portstr = args;
+    const size_t colon = args.rfind(':');
+    if (string::npos != colon) {
+        if (!addr.setAddress(QString::fromStdString(args.substr(0, colon)))) {
+            _error = "bad address " + args.substr(0, colon);
+            return false;
+        }
+        portstr = args.substr(colon + 1);
+    }
+    bool isnum;
+    const unsigned int port = QString::fromStdString(portstr).toUInt(&isnum);
+    if (!isnum || port == 0 || port > 65535) {
+        _error = "bad port " + portstr;
+        return false;
+    }
+    _udp = new QUdpSocket(this);
+    if (!_udp->bind(addr, port)) {
+        _error = "cannot listen on " + args + ": " + _udp->errorString().toStdString();
+        return false;
+    }
+    connect(_udp, SIGNAL(readyRead()), this, SLOT(_readDatagrams()));
+    return true;
+}
+
+bool LiveSource::_open_tcp(const std::string & args) {
+    // HOST:PORT
+    const size_t colon = args.rfind(':');
+    bool isnum = false;
+    const unsigned int port = (string::npos == colon) ? 0 : QString::fromStdString(args.substr(colon + 1)).toUInt(&isnum);
+    if (!isnum || port == 0 || port > 65535) {
+        _error = "need HOST:PORT, got " + args;
+        return false;
+    }
+    QTcpSocket*const sock = new QTcpSocket(this);
+    _stream = sock;
+    sock->connectToHost(QString::fromStdString(args.substr(0, colon)), port);
+    if (!sock->waitForConnected(LIVE_TCP_TIMEOUT_MSEC)) {
+        _error = "cannot connect to " + args + ": " + sock->errorString().toStdString();
+        return false;
+    }
+    connect(sock, SIGNAL(readyRead()), this, SLOT(_readStream()));
+    connect(sock, SIGNAL(disconnected()), this, SLOT(_streamClosed()));
+    return true;
+}
+
+bool LiveSource::_open_serial(const std::string & args) {
+#ifdef WITH_SERIALPORT
+    // DEVICE[:BAUD]. Device names on Windows have no colon, those on Linux neither.
+    string device = args;
+    unsigned int baud = LIVE_SERIAL_DEFAULT_BAUD;
+    const size_t colon = args.rfind(':');
+    if (string::npos != colon) {
+        bool isnum;
+        baud = QString::fromStdString(args.substr(colon + 1)).toUInt(&isnum);
+        if (!isnum || baud == 0) {
+            _error = "bad baud rate " + args.substr(colon + 1);
+            return false;
+        }
+        device = args.substr(0, colon);
+    }
+    QSerialPort*const port = new QSerialPort(QString::fromStdString(device), this);
+    _stream = port;
+    if (!port->open(QIODevice::ReadOnly) || !port->setBaudRate(baud)) {
+        _error = "cannot open " + device + ": " + port->errorString().toStdString();
+        return false;
+    }
+    connect(port, SIGNAL(readyRead()), this, SLOT(_readStream()));
+    return true;
+#else
+    (void) args;
+    _error = "built without serial port support (needs QtSerialPort)";
+    return false;
+#endif
+}
+
+bool LiveSource::_open_file(const std::string & path) {
+    if (!QFileInfo(QString::fromStdString(path)).isFile()) {
+        _error = "cannot open " + path;
+        return false;
+    }
+    string ext = getExtension(path);
+    ext = lcase(ext);
+    if (ext.compare("tlog") == 0 || ext.compare("mavlink") == 0) {
+        _tlog = new MavlinkParser(path);
+        if (!_tlog->valid) {
+            _error = "cannot open " + path;
+            return false;
+        }
+        if (!_tlog->claim_channel(0)) {
+            _error = LIVE_NO_CHANNEL;
+            return false;
+        }
+        _tlog->set_follow(true);
+    } else {
+        _olp = OnboardLogParserFactory::Instance().Create(ext);
+        if (!_olp || !_olp->set_follow(true)) {
+            delete _olp;
+            _olp = NULL;
+            _error = "cannot follow files of type \"" + ext + "\", only tlog and ulg";
+            return false;
+        }
+        _scen->begin_onboard_log(_olp->get_parser_name());
+        if (!_olp->Load(path, _scen->getLogChannel())) {
+            _error = "cannot open " + path;
+            return false;
+        }
+    }
+    _poll = new QTimer(this);
+    connect(_poll, SIGNAL(timeout()), this, SLOT(_pollFile()));
+    _poll->start(0); // what is there already, right away
+    return true;
+}
+
+void LiveSource::close(void) {
+    if (_udp) {
+        _udp->disconnect(this);
+        _udp->close();
+        _udp->deleteLater();
+        _udp = NULL;
+    }
+    if (_stream) {
+        _stream->disconnect(this);
+        _stream->close();
+        _stream->deleteLater();
+        _stream = NULL;
+    }
+    if (_poll) {
+        _poll->stop();
+        _poll->deleteLater();
+        _poll = NULL;
+    }
+    delete _tlog;
+    _tlog = NULL;
+    if (_olp) {
+        if (_scen) _scen->end_onboard_log();
+        delete _olp;
+        _olp = NULL;
+    }
+    if (_chan >= 0) {
+        MavlinkParser::_release_channel(_chan);
+        _chan = -1;
+    }
+    _scen = NULL;
+}
+
+void LiveSource::_readDatagrams(void) {
+    if (!_udp) return;
+    QByteArray buf;
+    while (_udp->hasPendingDatagrams()) {
+        buf.resize(_udp->pendingDatagramSize());
+        const qint64 n = _udp->readDatagram(buf.data(), buf.size());
+        if (n > 0) _feed(buf.constData(), n);
+    }
+}
+
+void LiveSource::_readStream(void) {
+    if (!_stream) return;
+    while (_stream && _stream->bytesAvailable() > 0) {
+        const QByteArray buf = _stream->read(LIVE_READ_BUFLEN);
+        if (buf.isEmpty()) break;
+        _feed(buf.constData(), buf.size());
+    }
+}
+
+void LiveSource::_streamClosed(void) {
+    const QString reason = _stream ? _stream->errorString() : QString();
+    close();
+    emit disconnected(reason);
+}
+
+void LiveSource::_pollFile(void) {
+    if (!_scen) return;
+    unsigned int n = 0;
+    if (_tlog) {
+        const uint64_t before = _tlog->get_read_bytes();
+        while (n < LIVE_FILE_MAX_MSGS && _tlog->get_next_msg(_msg)) {
+            _add(_msg);
+            ++n;
+        }
+        _n_bytes += _tlog->get_read_bytes() - before;
+    } else if (_olp) {
+        OnboardData d;
+        while (n < LIVE_FILE_MAX_MSGS && _olp->has_more_data()) {
+            if (_olp->get_data(d)) {
+                _scen->add_onboard_message(d);
+                ++_n_msgs;
+            }
+            ++n;
+        }
+    }
+    // behind: go on right away, otherwise wait for more
+    _poll->setInterval(n >= LIVE_FILE_MAX_MSGS ? 0 : LIVE_FILE_POLL_MSEC);
+}
+
+void LiveSource::_feed(const char*data, unsigned int len) {
+    if (!_scen || _chan < 0) return;
+    _n_bytes += len;
+    for (unsigned int k = 0; k < len; ++k) {
+        if (mavlink_parse_char(_chan, (uint8_t) data[k], &_msg, &_status)) _add(_msg);
+    }
+}
+
+void LiveSource::_add(const mavlink_message_t & msg) {
+    ++_n_msgs;
+    if (0 != _scen->add_mavlink_message(msg)) {
+        // time jump. Cannot be demultiplexed here, the data is already on screen
+        ++_n_jumps;
+        if (_allow_jumps) _scen->add_mavlink_message(msg, true);
+    }
+}
+
+std::string LiveSource::get_status(void) const {
+    if (!_scen) return "";
+    const double sec = (Profiler::now_nsec() - _t_open_nsec) * 1E-9;
+    stringstream ss;
+    ss << _spec << ": " << _n_msgs << " messages";
+    if (sec > 0.) {
+        ss << ", " << fixed << setprecision(0) << _n_msgs / sec << " msg/s, "
+           << setprecision(1) << _n_bytes / sec / 1024. << " kB/s";
+    }
+    if (_status.packet_rx_drop_count > 0) ss << ", " << _status.packet_rx_drop_count << " broken";
+    if (_n_jumps > 0) ss << ", " << _n_jumps << " time jumps";
+    return ss.str();
+}
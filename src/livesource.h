@@ -0,0 +1,129 @@
+/**
+ * @file livesource.h
+ * @brief Receives MavLink from a network or serial link and feeds it into a scenario as it arrives.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef LIVESOURCE_H
+#define LIVESOURCE_H
+
+#include <string>
+#include <QObject>
+#include <QString>
+#include "mavlink.h"
+#include "mavlinkscenario.h"
+
+class QUdpSocket;
+class QIODevice;
+class QTimer;
+class MavlinkParser;
+class OnboardLogParser;
+
+/**
+ * @brief A MavLink link which is read in the thread of the receiver, usually the GUI thread,
+ * whenever data arrives. Each message goes to MavlinkScenario::add_mavlink_message() right
+ * away, so the time series of the scenario grow while the link is open. Curves which show them
+ * are redrawn with MavPlot::dataAppended(); nothing is copied or rebuilt for that.
+ *
+ * Sources:
+ *  - "udp:[ADDRESS:]PORT" listens, e.g. "udp:14550" as a ground station does
+ *  - "tcp:HOST:PORT" connects, e.g. "tcp:localhost:5760" for SITL
+ *  - "serial:DEVICE[:BAUD]", e.g. "serial:/dev/ttyUSB0:57600". Only when built with QtSerialPort.
+ *  - "file:PATH" follows a tlog or ulg which is still being written, e.g., by a ground station.
+ *    What is there already is read first, then the file is polled for more. See
+ *    MavlinkParser::set_follow() and OnboardLogParser::set_follow().
+ */
+class LiveSource : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LiveSource(QObject *parent = 0);
+    ~LiveSource();
+
+    /**
+     * @brief start receiving into scen
+     * @param spec see above
+     * @param scen must stay until close()
+     * @param allow_jumps time jumps (e.g., a reboot of the vehicle) are tolerated. Otherwise
+     *        the messages after it are dropped until the clock is consistent again.
+     * @return false if the source cannot be opened, see get_error()
+     */
+    bool open(const std::string & spec, MavlinkScenario*scen, bool allow_jumps);
+
+    /**
+     * @brief stop receiving. The scenario is not touched anymore afterwards.
+     */
+    void close(void);
+
+    bool is_open(void) const { return _scen != NULL; }
+    const std::string & get_error(void) const { return _error; }
+    const std::string & get_spec(void) const { return _spec; }
+
+    /**
+     * @brief one line for the status bar: messages, rate, drops
+     */
+    std::string get_status(void) const;
+
+    unsigned long get_num_msgs(void) const { return _n_msgs; }
+    unsigned long get_num_jumps(void) const { return _n_jumps; }
+
+signals:
+    /**
+     * @brief the link went away by itself, e.g., the TCP peer closed it. It is closed now.
+     */
+    void disconnected(const QString & reason);
+
+private slots:
+    void _readDatagrams(void);
+    void _readStream(void);
+    void _streamClosed(void);
+    void _pollFile(void);
+
+private:
+    bool _open_udp(const std::string & args);
+    bool _open_tcp(const std::string & args);
+    bool _open_serial(const std::string & args);
+    bool _open_file(const std::string & args);
+    void _feed(const char*data, unsigned int len);
+    void _add(const mavlink_message_t & msg);
+
+    /****************************************
+     *     DATA MEMBERS
+     ****************************************/
+    std::string      _spec;
+    std::string      _error;
+    QUdpSocket*      _udp;
+    QIODevice*       _stream; ///< TCP socket or serial port
+    MavlinkParser*   _tlog;   ///< followed file...
+    OnboardLogParser*_olp;    ///< ...or this one
+    QTimer*          _poll;   ///< for either
+    MavlinkScenario* _scen;   ///< NULL=closed
+    bool             _allow_jumps;
+    int              _chan;   ///< MavLink channel, see MavlinkParser
+    mavlink_message_t _msg;
+    mavlink_status_t  _status;
+    // stats
+    unsigned long      _n_msgs;
+    unsigned long      _n_jumps;
+    unsigned long long _n_bytes;
+    unsigned long long _t_open_nsec;
+};
+
+#endif // LIVESOURCE_H
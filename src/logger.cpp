@@ -26,17 +26,57 @@
 //#include <stdlib.h>
 #include <iostream>
 #include <unistd.h>
+#include <QThread>
+#include <QMutexLocker>
+#include <QCoreApplication>
+#include <QTimerEvent>
 #include "logger.h"
 #include "filefun.h"
 
+#define LOG_RING_SIZE 4096      ///< messages which can wait for the drain
+#define LOG_DRAIN_MS 100        ///< period of the drain
+#define LOG_RATE_DEFAULT 50     ///< messages per channel and second
+#define LOG_RATE_WINDOW_MS 1000
+#define LOG_REPEAT_FLUSH_MS 1000 ///< pending repeats are reported after this
+
 using namespace std;
 
-Logger::Logger() : _nextid(0) {
+/**
+ * @brief calls the drain of the logger periodically, in the thread owning the model
+ */
+class LoggerPump : public QObject {
+public:
+    LoggerPump(Logger*log) : _log(log) { startTimer(LOG_DRAIN_MS); }
+protected:
+    void timerEvent(QTimerEvent*) { _log->_drain(); }
+private:
+    Logger*_log;
+};
+
+Logger::Logger() : _nextid(0), _ring(LOG_RING_SIZE), _dropped(0), _floor(MSG_DBG), _ratelimit(LOG_RATE_DEFAULT) {
     // create default channel
     channelprops_t props;
     props.name = "general";
     props.has_file = false;
     (void) _create_channel(props);
+    _ensure_pump();
+}
+
+/**
+ * @brief start the periodic drain, once there is an application whose thread owns the model.
+ * Timers need its event loop, so before that only flush() moves messages.
+ */
+void Logger::_ensure_pump(void) {
+    if (_pump) return;
+    QCoreApplication*app = QCoreApplication::instance();
+    if (!app || app->thread() != _model.thread() || QThread::currentThread() != _model.thread()) return;
+    _pump = new LoggerPump(this);
+    _pump->setParent(app); // goes away before the event loop does
+}
+
+LogTableModel* Logger::getModel(void) {
+    _ensure_pump();
+    return &_model;
 }
 
 Logger::logchannel Logger::createChannel(const std::string & chname, bool to_file) {
@@ -46,6 +86,30 @@ Logger::logchannel Logger::createChannel(const std::string & chname, bool to_fil
     return _create_channel(props);
 }
 
+void Logger::setMinLevel(logchannel ch, logmsgtype_e typ) {
+    QMutexLocker lock(&_mutex);
+    channelmap_t::iterator it = _channels.find(ch);
+    if (it == _channels.end()) return;
+    it->second.minlevel = typ;
+    _update_floor();
+}
+
+void Logger::setRateLimit(unsigned int per_second) {
+    QMutexLocker lock(&_mutex);
+    _ratelimit = per_second;
+}
+
+/**
+ * @brief recompute _floor. Caller must hold _mutex.
+ */
+void Logger::_update_floor(void) {
+    int lowest = MSG_ERR;
+    for (channelmap_t::const_iterator it = _channels.begin(); it != _channels.end(); ++it) {
+        if ((int)it->second.minlevel < lowest) lowest = (int)it->second.minlevel;
+    }
+    _floor.fetchAndStoreOrdered(lowest);
+}
+
 void Logger::deleteMessages(const QModelIndexList &lid) {
     if (lid.empty()) return;
 
@@ -68,6 +132,7 @@ void Logger::deleteMessage(const QModelIndex &id) {
 }
 
 void Logger::deleteChannel(Logger::logchannel ch) {
+    QMutexLocker lock(&_mutex);
     // find channel, and remove
     channelmap_t::iterator it = _channels.find(ch);
     if (it != _channels.end()) {
@@ -78,7 +143,9 @@ void Logger::deleteChannel(Logger::logchannel ch) {
         }
         // TODO: update model: remove channel.
         _channels.erase(it);
+        _update_floor();
     }
+    // messages still in the ring go to the default channel
 }
 
 Logger::logchannel Logger::_create_channel(Logger::channelprops_t & p) {
@@ -87,12 +154,23 @@ Logger::logchannel Logger::_create_channel(Logger::channelprops_t & p) {
     } else {
         p.ofile = NULL;
     }
+    p.minlevel = MSG_DBG;
+    p.has_last = false;
+    p.last_typ = MSG_DBG;
+    p.repeats = 0;
+    p.last_ms = 0;
+    p.window_ms = 0;
+    p.window_count = 0;
+    p.suppressed = 0;
+    QMutexLocker lock(&_mutex);
     logchannel ch = _nextid++;
     _channels[ch] = p;
+    _update_floor();
     return ch;
 }
 
 Logger::~Logger() {
+    delete _pump; // NULL if the application already took it down
     _cleanup();
 }
 
@@ -110,17 +188,112 @@ void Logger::deleteLogfile(std::ofstream*stream) {
 #endif
 
 void Logger::write(logmsgtype_e typ, const std::string & msg, logchannel ch) {
-    // find channel, then write to there
-    // if not found, revert to default channel
-    channelmap_t::const_iterator it = _channels.find(ch);
-    channelprops_t props;
-    if (it != _channels.end()) {
-        props = it->second;
-    } else {
-        props = _channels[0]; // default channel
+    if ((int)typ < _floor.fetchAndAddRelaxed(0)) return; // no channel wants it
+
+    unsigned int ticket;
+    record_t*r = _ring.begin_push(ticket);
+    if (!r) {
+        _dropped.fetchAndAddRelaxed(1);
+        return;
+    }
+    r->ch = ch;
+    r->typ = typ;
+    r->msg = msg;
+    _ring.end_push(ticket);
+}
+
+void Logger::flush(void) {
+    if (QThread::currentThread() != _model.thread()) return;
+    _ensure_pump();
+    _drain();
+}
+
+long long Logger::_now_ms(void) {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return (long long)now.tv_sec * 1000 + now.tv_usec / 1000;
+}
+
+/**
+ * @brief move the messages from the ring into the model. Only in the thread owning the model,
+ * which is the only consumer of the ring.
+ */
+void Logger::_drain(void) {
+    const long long now = _now_ms();
+    QMutexLocker lock(&_mutex);
+    if (_channels.empty()) return; // shutting down
+
+    record_t*r;
+    while ((r = _ring.begin_pop())) {
+        channelmap_t::iterator it = _channels.find(r->ch);
+        if (it == _channels.end()) it = _channels.find(0); // default channel
+        if (it != _channels.end()) {
+            _process(it->second, r->typ, r->msg, now);
+        }
+        r->msg.clear(); // keeps its capacity for the next one
+        _ring.end_pop();
+    }
+
+    for (channelmap_t::iterator it = _channels.begin(); it != _channels.end(); ++it) {
+        _emit_notes(it->second, now, false);
+    }
+
+    const int dropped = _dropped.fetchAndStoreRelaxed(0);
+    if (dropped > 0) {
+        channelmap_t::iterator it = _channels.find(0);
+        if (it != _channels.end()) {
+            _model.add_message(it->second.name, MSG_WARN, stringbuilder() << dropped << " messages lost, log buffer was full");
+        }
+    }
+}
+
+/**
+ * @brief filter one message of channel p. Caller must hold _mutex.
+ */
+void Logger::_process(channelprops_t & p, logmsgtype_e typ, const std::string & msg, long long now) {
+    if (typ < p.minlevel) return;
+    if (p.has_last && typ == p.last_typ && msg == p.last_msg) {
+        p.repeats++;
+        return;
+    }
+    _emit_notes(p, now, true);
+    _emit(p, typ, msg, now);
+}
+
+/**
+ * @brief hand a message to the model, unless channel p is above its rate. Caller must hold _mutex.
+ */
+void Logger::_emit(channelprops_t & p, logmsgtype_e typ, const std::string & msg, long long now) {
+    if (now - p.window_ms >= LOG_RATE_WINDOW_MS) {
+        p.window_ms = now;
+        p.window_count = 0;
+    }
+    if (_ratelimit > 0 && p.window_count >= _ratelimit) {
+        p.suppressed++;
+        return;
+    }
+    p.window_count++;
+    p.has_last = true;
+    p.last_typ = typ;
+    p.last_msg = msg;
+    p.last_ms = now;
+    _model.add_message(p.name, typ, msg);
+}
+
+/**
+ * @brief report repeated and suppressed messages of channel p. Caller must hold _mutex.
+ * @param force report repeats now, because a different message follows
+ */
+void Logger::_emit_notes(channelprops_t & p, long long now, bool force) {
+    if (p.repeats > 0 && (force || now - p.last_ms >= LOG_REPEAT_FLUSH_MS)) {
+        _model.add_message(p.name, p.last_typ, stringbuilder() << "last message repeated " << p.repeats << " times");
+        p.repeats = 0;
+        p.last_ms = now;
+    }
+    if (p.suppressed > 0 && now - p.window_ms >= LOG_RATE_WINDOW_MS) {
+        _model.add_message(p.name, MSG_WARN, stringbuilder() << p.suppressed << " messages suppressed, more than " << _ratelimit << " per second");
+        p.suppressed = 0;
     }
-    std::string emitter = props.name;
-    _model.add_message(emitter, typ, msg);
 }
 
 /**
@@ -176,8 +349,7 @@ void Logger::_cleanup_stream(ofstream*ofs) {
 }
 
 void Logger::_cleanup(void) {
-    for (channelmap_t::iterator it = _channels.begin(); it != _channels.end(); ++it) {
-        deleteChannel(it->first);
+    while (!_channels.empty()) {
+        deleteChannel(_channels.begin()->first);
     }
-    _channels.clear();
 }
@@ -30,8 +30,14 @@
 #include <sstream>
 #include <vector>
 #include <map>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QPointer>
 #include "logtablemodel.h"
 #include "logmsg.h"
+#include "mpscring.h"
+
+class QObject;
 
 class Logger {
 public:
@@ -55,13 +61,26 @@ public:
     logchannel createChannel(const std::string & chname, bool keep=false);
 
     /**
-     * @brief add a new log message
+     * @brief add a new log message. Safe from any thread, and does not touch the model:
+     * the message goes into a lock-free ring, which the thread owning the model drains
+     * periodically. Messages below the level of the channel are dropped right away.
      * @param typ type of message
      * @param msg content of message
      * @param ch channel from chreateChannel, or 0 (default) for generic channel     
      */
     void write(logmsgtype_e typ, const std::string & msg, logchannel ch = 0);
 
+    /**
+     * @brief messages of this channel with a lower type are dropped. Default MSG_DBG (all).
+     */
+    void setMinLevel(logchannel ch, logmsgtype_e typ);
+
+    /**
+     * @brief at most this many messages per channel and second go into the model; the
+     * rest is counted and reported as one message. 0=no limit.
+     */
+    void setRateLimit(unsigned int per_second);
+
     /**
      * @brief drop all messages from given channel
      * @param ch
@@ -75,6 +94,13 @@ public:
     void deleteMessage(const QModelIndex &id);
     void deleteMessages(const QModelIndexList &lid);
 
+    /**
+     * @brief move all queued messages into the model now. Only has an effect when called
+     * from the thread owning the model; that thread also does it periodically by itself,
+     * as long as it runs an event loop.
+     */
+    void flush(void);
+
     /************************************
      * FOR THOSE WHO ARE DISPLAYING LOGS
      ************************************/
@@ -82,7 +108,7 @@ public:
      * @brief widgets can obtain the model to show the log messages
      * @return
      */
-    LogTableModel*getModel(void) { return &_model; }
+    LogTableModel*getModel(void);
 
 private:
 
@@ -96,10 +122,29 @@ private:
         std::string name;
         bool has_file;
         std::ofstream*ofile;
+        logmsgtype_e minlevel;
+        // state of the drain, see _drain()
+        bool         has_last;      ///< last_* are valid
+        logmsgtype_e last_typ;      ///< last message which went to the model
+        std::string  last_msg;
+        unsigned int repeats;       ///< how often last_msg came again since
+        long long    last_ms;       ///< when last_msg went to the model
+        long long    window_ms;     ///< start of the current rate window
+        unsigned int window_count;  ///< messages in the current rate window
+        unsigned int suppressed;    ///< messages dropped in the current rate window
     } channelprops_t;
 
     typedef std::map<logchannel, channelprops_t> channelmap_t;
 
+    /**
+     * @brief a message waiting in the ring to go into the model
+     */
+    typedef struct record_s {
+        logchannel   ch;
+        logmsgtype_e typ;
+        std::string  msg;
+    } record_t;
+
     /***********************************
      * METHODS
      ***********************************/
@@ -113,7 +158,16 @@ private:
     std::ofstream* _createLogfile(std::string filename);
     logchannel _create_channel(channelprops_t & p);
     void _cleanup_stream(std::ofstream*ofs);
+    void _ensure_pump(void);
+    void _drain(void);
+    void _process(channelprops_t & p, logmsgtype_e typ, const std::string & msg, long long now);
+    void _emit(channelprops_t & p, logmsgtype_e typ, const std::string & msg, long long now);
+    void _emit_notes(channelprops_t & p, long long now, bool force);
+    void _update_floor(void);
     void _cleanup(void);
+    static long long _now_ms(void);
+
+    friend class LoggerPump;
 
     /************************************
      * ATTRIBUTES
@@ -123,6 +177,13 @@ private:
     logchannel _nextid;
     channelmap_t _channels;
 
+    QMutex _mutex; ///< guards _channels and _nextid
+    MpscRing<record_t> _ring; ///< messages on their way to the model
+    QAtomicInt _dropped;      ///< messages which did not fit into _ring
+    QAtomicInt _floor;        ///< lowest minlevel of all channels, checked without lock
+    unsigned int _ratelimit;  ///< see setRateLimit()
+    QPointer<QObject> _pump;  ///< drains _ring in the model's thread
+
     std::vector<std::string> _files;
     std::vector<std::ofstream*> _streams;
 };
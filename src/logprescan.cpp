@@ -0,0 +1,160 @@
+/**
+ * @file logprescan.cpp
+ * @brief What a quick look at a log file tells, before committing to parse all of it.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <QFileInfo>
+#include "logprescan.h"
+#include "mavlinkparser.h"
+#include "onboardlogparserfactory.h"
+#include "filefun.h"
+#include "memuse.h"
+
+using namespace std;
+
+#define PRESCAN_LIST_TOPICS 40 ///< describe() names at most that many
+
+void LogPrescan::clear(void) {
+    parser.clear();
+    filesize = 0;
+    topics.clear();
+    counts.clear();
+    n_sampled = 0;
+    systems.clear();
+    has_time = false;
+    time_exact = false;
+    time_epoch = false;
+    time_min_usec = 0;
+    time_max_usec = 0;
+}
+
+bool LogPrescan::scan(const std::string & filename) {
+    clear();
+    const QFileInfo info(QString::fromStdString(filename));
+    if (!info.isFile()) return false;
+    filesize = info.size();
+
+    string ext = getExtension(filename);
+    ext = lcase(ext);
+    if (ext.compare("tlog") == 0 || ext.compare("mavlink") == 0) {
+        MavlinkParser p(filename);
+        return p.valid && p.prescan(*this);
+    }
+    OnboardLogParser*olp = OnboardLogParserFactory::Instance().Create(ext);
+    if (!olp) return false;
+    const bool ok = olp->Load(filename) && olp->prescan(*this);
+    delete olp;
+    return ok;
+}
+
+void LogPrescan::add_topic(const std::string & topic, const std::vector<std::string> & fields) {
+    std::vector<std::string> & known = topics[topic];
+    if (known.empty()) known = fields;
+}
+
+void LogPrescan::add_message(const std::string & topic) {
+    ++counts[topic];
+    ++n_sampled;
+    topics[topic]; // known, maybe without fields
+}
+
+void LogPrescan::add_time(uint64_t usec) {
+    if (!has_time) {
+        time_min_usec = time_max_usec = usec;
+        has_time = true;
+        return;
+    }
+    if (usec < time_min_usec) time_min_usec = usec;
+    if (usec > time_max_usec) time_max_usec = usec;
+}
+
+double LogPrescan::get_duration_sec(void) const {
+    if (!has_time) return 0.;
+    return (time_max_usec - time_min_usec) / 1E6;
+}
+
+static bool by_count_desc(const std::pair<unsigned int, std::string> & a, const std::pair<unsigned int, std::string> & b) {
+    if (a.first != b.first) return a.first > b.first;
+    return a.second < b.second;
+}
+
+std::vector<std::string> LogPrescan::get_topic_names(void) const {
+    std::vector<std::pair<unsigned int, std::string> > order;
+    for (topics_t::const_iterator it = topics.begin(); it != topics.end(); ++it) {
+        std::map<std::string, unsigned int>::const_iterator c = counts.find(it->first);
+        order.push_back(std::make_pair(c == counts.end() ? 0u : c->second, it->first));
+    }
+    std::sort(order.begin(), order.end(), by_count_desc);
+    std::vector<std::string> ret;
+    for (unsigned int k = 0; k < order.size(); ++k) ret.push_back(order[k].second);
+    return ret;
+}
+
+std::string LogPrescan::describe(void) const {
+    stringstream ss;
+    ss << parser << " log, " << memuse_t::format(filesize) << endl;
+    if (!systems.empty()) {
+        ss << "Systems:";
+        for (std::set<unsigned int>::const_iterator it = systems.begin(); it != systems.end(); ++it) {
+            ss << " " << *it;
+        }
+        ss << endl;
+    }
+    if (has_time) {
+        const double dur = get_duration_sec();
+        ss << "Duration: " << (time_exact ? "" : "about ") << fixed << setprecision(1);
+        if (dur >= 120.) {
+            ss << dur / 60. << " min";
+        } else {
+            ss << dur << " s";
+        }
+        if (!time_epoch) {
+            ss << " (" << time_min_usec / 1E6 << " to " << time_max_usec / 1E6 << " s since boot)";
+        }
+        ss << endl;
+    } else {
+        ss << "Duration: unknown" << endl;
+    }
+
+    const std::vector<std::string> names = get_topic_names();
+    ss << "Topics: " << names.size();
+    if (n_sampled > 0) ss << ", share in " << n_sampled << " sampled messages";
+    ss << endl;
+    for (unsigned int k = 0; k < names.size() && k < PRESCAN_LIST_TOPICS; ++k) {
+        ss << "  " << names[k];
+        std::map<std::string, unsigned int>::const_iterator c = counts.find(names[k]);
+        if (c != counts.end() && n_sampled > 0) {
+            ss << " (" << setprecision(1) << (100. * c->second / n_sampled) << "%)";
+        }
+        const topics_t::const_iterator t = topics.find(names[k]);
+        if (t != topics.end() && !t->second.empty()) {
+            ss << ": " << t->second.size() << " fields";
+        }
+        ss << endl;
+    }
+    if (names.size() > PRESCAN_LIST_TOPICS) {
+        ss << "  ... and " << (names.size() - PRESCAN_LIST_TOPICS) << " more" << endl;
+    }
+    return ss.str();
+}
@@ -0,0 +1,91 @@
+/**
+ * @file logprescan.h
+ * @brief What a quick look at a log file tells, before committing to parse all of it.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef LOGPRESCAN_H
+#define LOGPRESCAN_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <inttypes.h>
+
+#define PRESCAN_HEAD_MESSAGES 2000  ///< decoded from the beginning, after the definitions
+#define PRESCAN_SAMPLES 8           ///< places further into the file which are looked at
+#define PRESCAN_SAMPLE_MESSAGES 200 ///< decoded at each of those
+#define PRESCAN_TAIL_BYTES (64*1024) ///< last sample: read until end of file from here
+
+/**
+ * @brief Filled by OnboardLogParser::prescan() and MavlinkParser::prescan(), which read the
+ * definitions at the beginning of a log and sample messages at a few places. That takes
+ * milliseconds, while the time span and message mix are only estimated.
+ */
+class LogPrescan
+{
+public:
+    LogPrescan() { clear(); }
+
+    typedef std::map<std::string, std::vector<std::string> > topics_t; ///< fields of each topic
+
+    /**
+     * @brief look at the file with the parser for its extension
+     * @return false if there is no such parser or the file cannot be read
+     */
+    bool scan(const std::string & filename);
+
+    void clear(void);
+
+    // for the parsers
+    void add_topic(const std::string & topic, const std::vector<std::string> & fields);
+    void add_message(const std::string & topic);
+    void add_time(uint64_t usec);
+
+    double get_duration_sec(void) const;
+
+    /**
+     * @brief all topics, most frequent ones first
+     */
+    std::vector<std::string> get_topic_names(void) const;
+
+    /**
+     * @brief text for the user, several lines
+     */
+    std::string describe(void) const;
+
+    /****************************************
+     *   DATA MEMBERS
+     ****************************************/
+    std::string parser;   ///< see OnboardLogParser::get_parser_name(), "mavlink" for tlogs
+    uint64_t    filesize;
+    topics_t    topics;   ///< defined in the log or seen in samples. Fields may be unknown
+    std::map<std::string, unsigned int> counts; ///< sampled messages of each topic
+    unsigned int n_sampled;
+    std::set<unsigned int> systems; ///< MavLink system IDs seen
+    bool        has_time;
+    bool        time_exact; ///< time span is known, not estimated from samples
+    bool        time_epoch; ///< times are since 1970 (tlogs), else since boot
+    uint64_t    time_min_usec;
+    uint64_t    time_max_usec;
+};
+
+#endif // LOGPRESCAN_H
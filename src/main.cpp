@@ -24,18 +24,39 @@
 #include <iostream>
 #include <list>
 #include <string>
+#include <vector>
+#include <fstream>
 #include <QApplication>
+#include <QCoreApplication>
 #include <QFile>
 #include <QTextStream>
+#include <QSettings>
 #include "filefun.h"
 #include "mainwindow.h"
 #include "cmdlineargs.h"
 #include "mavlinkparser.h"
 #include "mavlinkscenario.h"
+#include "fileimporter.h"
 #include "dbconnector.h"
+#include "dataexport.h"
+#include "profiler.h"
+#include "batchrunner.h"
+#include "taskpool.h"
 
 using namespace std;
 
+/**
+ * @brief what the Tracer recorded, to the file given with --trace
+ */
+static void _write_trace(const CmdlineArgs & args) {
+    if (args.trace_json.empty()) return;
+    if (Tracer::Instance().write_json(args.trace_json)) {
+        cout << "Wrote " << Tracer::Instance().get_num_events() << " trace events to " << args.trace_json << endl;
+    } else {
+        cout << "Cannot write trace to " << args.trace_json << endl;
+    }
+}
+
 int main(int argc, char *argv[]) {
     cout << "****************************************************************" << endl <<
             "*        MAV Log Analyzer for apm:copter                       *" << endl <<
@@ -50,34 +71,41 @@ int main(int argc, char *argv[]) {
         cout << "Error parsing command line" << endl;
         exit(1);
     }
+    Profiler::Instance().set_enabled(args.profile);
+    Tracer::Instance().set_enabled(!args.trace_json.empty());
+    if (args.cores == 0) {
+        QSettings settings("DE.TUM.EI.RCS", "MavLogAnalyzer");
+        args.cores = settings.value("performance/cores", QVariant(0)).toUInt();
+    }
+    TaskPool::set_max_threads(args.cores); // before anything runs in parallel
+    if (args.expressions.empty() && (args.batch || args.headless)) {
+        // headless, too, unless given on the command line. The GUI does this itself.
+        QSettings settings("DE.TUM.EI.RCS", "MavLogAnalyzer");
+        const QStringList defs = settings.value("derived/expressions").toStringList();
+        for (QStringList::const_iterator it = defs.begin(); it != defs.end(); ++it) {
+            args.expressions.push_back(it->toStdString());
+        }
+    }
 
-	if(args.import) {
-        // FIXME: that assumes we have only mavlog files. but there are also onboard logs.
-        printf("Import\n");
-        std::string filename;
-        DBConnector::db_props_t dbprops; // FIXME: from command line??
-        filename = *args.filenames.begin();
-        DBConnector* dbCon = new DBConnector(dbprops);
-        //dbCon->importFromFile(filename);
-        printf("NOT SUPPORTED");
-        delete (dbCon);
+    if (args.batch) {
+        // each file on its own, e.g., for nightly runs over many flights
+        QCoreApplication a(argc, argv);
+        BatchRunner batch(&args);
+        for (list<string>::iterator it = args.filenames.begin(); it != args.filenames.end(); ++it) {
+            batch.add_input(*it);
+        }
+        cout << "Batch of " << batch.get_num_files() << " files" << endl;
+        const unsigned int n_failed = batch.run();
+        if (!args.profile_json.empty()) {
+            std::ofstream fjson(args.profile_json.c_str());
+            Profiler::Instance().dump_json(fjson);
+        }
+        _write_trace(args);
+        cout << endl << "BYE!" << endl;
+        return (n_failed > 0) ? 2 : 0;
     } else {
-		// instantiate parsers for all files
-		list<MavlinkParser*> parsers;
-		for (list<string>::iterator it = args.filenames.begin(); it != args.filenames.end(); ++it) {
-		    // TODO: check that no file is added twice...
-		    MavlinkParser*tmp = new MavlinkParser(*it);
-		    if (tmp->valid) {
-		        parsers.push_back(tmp);
-		        cout << "Opened file " << *it << "..." <<endl;
-		    } else {
-		        cout << "Skipping file " << *it << " due to errors" <<endl;
-		        delete tmp;
-		    }
-		}
-
 		if (!args.headless) {
-		    // start GUI
+		    // start GUI. It reads the files one at a time
 		    QApplication a(argc, argv);
 		    QFile stylesheet(":/darkorange.stylesheet");
             if (!stylesheet.open(QIODevice::ReadOnly | QIODevice::Text)) {
@@ -87,60 +115,63 @@ int main(int argc, char *argv[]) {
                 a.setStyleSheet(ts.readAll());
                 stylesheet.close();
             }
-		    MainWindow w(parsers, &args);
+		    MainWindow w(args.filenames, &args);
 		    w.show();
-		    return a.exec();
+		    const int ret = a.exec();
+		    _write_trace(args);
+		    return ret;
 		} else {
-		    /* give a rudimentary overview by putting all mavlink logs into
-		     * ONE scenario and then let it dump an overview
+		    /* give a rudimentary overview by putting all logs into
+		     * ONE scenario and then let it dump an overview. Files
+		     * are parsed and processed in parallel, each into its
+		     * own scenario, and then merged in the given order.
 		     */
-		    MavlinkScenario onescenario(&args);            
-		    for (list<MavlinkParser*>::iterator it=parsers.begin(); it != parsers.end(); ++it) {
-		        // for each parser, start a new scenario
-		        MavlinkScenario*curscenario = new MavlinkScenario(&args);
-		        if (curscenario) {
-		            mavlink_message_t msg;
-		            while ((*it)->get_next_msg(msg)) {
-		                curscenario->add_mavlink_message(msg);
-		            }
-		            // guess the start time of the logfile by looking at the file name
-		            //  - basename usually looks like "2014-04-10 15-41-26".
-		            {
-		                string f_basename = getBasename((*it)->get_filename());
-		                string str_datetime = f_basename;
-		                // cut off extension from basename if there is one
-		                size_t pos = f_basename.rfind('.');
-		                if (pos != f_basename.npos) {
-		                    str_datetime = str_datetime.substr(0,pos);
-		                }
-		                uint64_t time_epoch_usec = 0;
-		                if (string_to_epoch_usec(str_datetime, time_epoch_usec)) {
-		                    curscenario->set_starttime_guess(time_epoch_usec);
-		                }
-                        if (onescenario.getName().empty()) {
-                            onescenario.setName(f_basename);
-                        }
-                        curscenario->setName(f_basename);
-		            }
-		            // process scneario from that file
-		            curscenario->process();
-		            // now merge the current scenario into the ONE
-		            onescenario.merge_in(*curscenario);
-		            // can forget about current scenario now
-		            delete curscenario;
+		    QCoreApplication a(argc, argv);
+		    MavlinkScenario onescenario(&args);
+		    std::vector<FileImporter*> jobs;
+		    for (list<string>::iterator it = args.filenames.begin(); it != args.filenames.end(); ++it) {
+		        jobs.push_back(new FileImporter(*it, &args));
+		    }
+		    FileImporter::run_all(jobs, args.threads);
+
+		    std::vector<MavlinkScenario*> allscenes;
+		    for (std::vector<FileImporter*>::iterator it = jobs.begin(); it != jobs.end(); ++it) {
+		        FileImporter*job = *it;
+		        if (!job->is_parsed()) {
+		            cout << "Skipping file " << job->get_filename() << " due to errors: " << job->get_error() << endl;
 		        } else {
-		            cerr << "ERROR allocating a scenario...running out of memory?" << endl;
+		            cout << "Opened file " << job->get_filename() << "..." <<endl;
+		            const std::string jumps = job->get_timejump_summary();
+		            if (!jumps.empty()) cout << jumps << endl;
+		            if (onescenario.getName().empty()) {
+		                onescenario.setName(getBasename(job->get_filename()));
+		            }
+		            // the scenarios of the file are merged into the ONE below
+		            const std::vector<MavlinkScenario*> & scenes = job->get_scenarios();
+		            allscenes.insert(allscenes.end(), scenes.begin(), scenes.end());
 		        }
-		    } // for parser
+		    }
+		    onescenario.take_in_all(allscenes);
+		    // can forget about scenarios of the files now
+		    for (std::vector<FileImporter*>::iterator it = jobs.begin(); it != jobs.end(); ++it) {
+		        delete *it;
+		    }
+		    jobs.clear();
 		    onescenario.process();
 		    onescenario.dump_overview(cout);
+		    if (!args.export_file.empty()) {
+		        const unsigned int n = DataExport::columnar(&onescenario, args.export_file);
+		        cout << "Exported " << n << " data series to " << args.export_file << endl;
+		    }
+		    if (!args.profile_json.empty()) {
+		        std::ofstream fjson(args.profile_json.c_str());
+		        Profiler::Instance().dump_json(fjson);
+		        if (!fjson.good()) {
+		            cout << "Cannot write profile to " << args.profile_json << endl;
+		        }
+		    }
+		    _write_trace(args);
 		}
-
-		// clean parsers
-		for (list<MavlinkParser*>::iterator it=parsers.begin(); it != parsers.end(); ++it) {
-		    delete *it;
-		}
-		parsers.clear();
 	}
     cout << endl << "BYE!" << endl;
     return 0;
@@ -28,6 +28,12 @@
 #include <QInputDialog>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
+#include <QGridLayout>
+#include <QDialogButtonBox>
+#include <QListWidget>
+#include <QLineEdit>
+#include <QPlainTextEdit>
+#include <QDateTime>
 #include <qfiledialog.h>
 #include <qfileinfo.h>
 #include <qimagewriter.h>
@@ -52,8 +58,15 @@
 #include <qwt_legend.h>
 #include <qwt_plot_curve.h>
 #include "qwt_compat.h"
+#include "mavplotrenderer.h"
+#include "mavplotcurve.h"
 #include "mainwindow.h"
+#include "fileimporter.h"
+#include "scenariocache.h"
+#include "expression.h"
+#include "conditionsearch.h"
 #include "dialogstats.h"
+#include "statscache.h"
 #include "dialogscenarioprops.h"
 #include "dialogdbsettings.h"
 #include "dialogdatatable.h"
@@ -61,17 +74,22 @@
 #include "ui_mainwindow.h"
 #include "filefun.h"
 #include "filterwindow.h"
+#include "dialogfleet.h"
 #include "dbconnector.h"
 #include "logger.h"
+#include "logprescan.h"
+#include "profiler.h"
 #include <qstringlistmodel.h>
 #include <qstandarditemmodel.h>
 #include "dialogselectscenario.h"
-#include "onboardlogparserfactory.h"
 
 //#include <qtconcurrentrun.h>
 
 using namespace std;
 
+#define LIVE_REFRESH_MSEC 100 ///< how often live data is drawn
+#define DETAIL_MIN_POINTS 400 ///< if an overview from the DB has fewer points in view, all samples there are fetched
+
 
 void MainWindow::_updateHScroll (void) {
 
@@ -98,6 +116,7 @@ void MainWindow::_updateHScroll (void) {
 
 void MainWindow::on_plotZoomed (float /*viewmin*/, float /*viewmax*/) {
     _updateHScroll();
+    _loadDetails();
     if (_dlgstats) {
         if (_dlgstats->isVisible())
         _dlgstats->updateData();
@@ -106,6 +125,7 @@ void MainWindow::on_plotZoomed (float /*viewmin*/, float /*viewmax*/) {
 
 void MainWindow::on_plotPanned(int /*dx*/, int /*dy*/) {
     _updateHScroll();
+    _loadDetails();
     if (_dlgstats) {
         if (_dlgstats->isVisible())
         _dlgstats->updateData();
@@ -125,6 +145,27 @@ void MainWindow::_save_windows_settings(void) {
     _settings.setValue("database", QVariant(QString::fromStdString(_dbprops.dbname)));
     _settings.setValue("user", QVariant(QString::fromStdString(_dbprops.username)));
     _settings.setValue("pass", QVariant(QString::fromStdString(_dbprops.password)));
+    _settings.setValue("backend", QVariant(QString::fromStdString(_dbprops.backend)));
+    _settings.endGroup();
+
+    _settings.beginGroup("memory");
+    _settings.setValue("budget_mb", QVariant((unsigned int)_mem_budget_mb));
+    _settings.setValue("scratch_dir", QVariant(QString::fromStdString(_scratch_dir)));
+    _settings.endGroup();
+
+    _settings.beginGroup("import");
+    _settings.setValue("time_jumps", QVariant(QString::fromStdString(_time_jumps)));
+    _settings.endGroup();
+
+    _settings.beginGroup("plot");
+    _settings.setValue("background_render", QVariant(d_plot->get_background_render()));
+    _settings.setValue("export_raster", QVariant(_export_raster == MavPlotRenderer::RASTER_NEVER ? "never" :
+                                                 _export_raster == MavPlotRenderer::RASTER_ALWAYS ? "always" : "dense"));
+    _settings.setValue("export_dpi", QVariant(_export_dpi));
+    _settings.endGroup();
+
+    _settings.beginGroup("derived");
+    _settings.setValue("expressions", QVariant(_expressions));
     _settings.endGroup();
 }
 
@@ -164,7 +205,47 @@ void MainWindow::_load_windows_settings(void) {
     _dbprops.dbname = _settings.value("database", QVariant("mavlog_database")).toString().toStdString();
     _dbprops.username = _settings.value("user", QVariant("mavlog_user")).toString().toStdString();
     _dbprops.password= _settings.value("pass", QVariant("mavlog_password")).toString().toStdString();
+    _dbprops.backend = _settings.value("backend", QVariant(DB_BACKEND_MYSQL)).toString().toStdString();
+    _settings.endGroup();
+
+    _settings.beginGroup("memory");
+    _mem_budget_mb = _settings.value("budget_mb", QVariant(0)).toUInt();
+    _scratch_dir = _settings.value("scratch_dir", QVariant("")).toString().toStdString();
+    _settings.endGroup();
+
+    _settings.beginGroup("import");
+    _time_jumps = _settings.value("time_jumps", QVariant("ask")).toString().toStdString();
+    _settings.endGroup();
+
+    _settings.beginGroup("plot");
+    d_plot->set_background_render(_settings.value("background_render", QVariant(true)).toBool());
+    if (!MavPlotRenderer::parse_raster(_settings.value("export_raster", QVariant("dense")).toString().toStdString(), _export_raster)) {
+        _export_raster = MavPlotRenderer::RASTER_DENSE;
+    }
+    _export_dpi = _settings.value("export_dpi", QVariant(PRINT_MAX_DPI)).toUInt();
+    _settings.endGroup();
+
+    _settings.beginGroup("derived");
+    _expressions = _settings.value("expressions", QVariant(QStringList())).toStringList();
     _settings.endGroup();
+    // command line wins. Importers get the budget through the args, too.
+    if (_args && _args->mem_budget_mb == 0 && _mem_budget_mb > 0) {
+        _args->mem_budget_mb = _mem_budget_mb;
+        if (_args->scratch_dir.empty()) _args->scratch_dir = _scratch_dir;
+    }
+    if (_args && _args->expressions.empty()) {
+        for (QStringList::const_iterator it = _expressions.begin(); it != _expressions.end(); ++it) {
+            _args->expressions.push_back(it->toStdString());
+        }
+    }
+    if (_args && _args->time_jumps == CmdlineArgs::JUMPS_ASK) {
+        if (!CmdlineArgs::parse_jumps(_time_jumps, _args->time_jumps, _args->jumps_demux_sec)) {
+            qDebug() << "Ignoring malformed time jump policy in settings: " << QString::fromStdString(_time_jumps);
+        }
+    }
+    if (_args && _analyzer) {
+        _analyzer->set_memory_budget((size_t)_args->mem_budget_mb*1024*1024, _args->scratch_dir);
+    }
 }
 
 /**
@@ -206,9 +287,11 @@ void MainWindow::on_datarowSelectionChangedSlot(const QItemSelection &, const QI
 
 void MainWindow::_updateTreeData(const MavSystem*const sys) {
     if (!sys) return;
+    TraceScope trace("tree refresh");
 
     ui->treeData->clearSelection();
     _dtvm->set_mav_sys(sys);
+    on_txtSearchData_textChanged(ui->txtSearchData->text()); // results of the new system
 }
 
 void MainWindow::_updateTextInfo(const MavSystem*const sys) {
@@ -236,6 +319,9 @@ void MainWindow::_setupSignalsAndSlots(void) {
     connect(d_picker, SIGNAL(selected(const QPolygon &)), SLOT(selected(const QPolygon &)));    
     connect(d_panner, SIGNAL(panned(int,int)), this, SLOT(on_plotPanned(int,int)));
     connect(d_zoomer, SIGNAL(plotMoved(float,float)), this, SLOT(on_plotZoomed(float,float)));
+    connect(d_overview, SIGNAL(viewSelected(double,double)), this, SLOT(overviewSelected(double,double)));
+    connect(_dbworker, SIGNAL(jobFinished(unsigned int,int,bool,MavlinkScenario*,DialogProgressBar*)),
+            this, SLOT(dbJobFinished(unsigned int,int,bool,MavlinkScenario*,DialogProgressBar*)));
 
     // commented connections are automatic, because naming convention is followed:
     //connect(ui->buttonAddData, SIGNAL(clicked()), SLOT(on_buttonAddData_clicked()));
@@ -280,7 +366,7 @@ void MainWindow::print() {
 
     QPrintDialog dialog(&printer);
     if ( dialog.exec() )  {
-        QwtPlotRenderer renderer;
+        MavPlotRenderer renderer(_export_raster, _export_dpi);
 
 
         if ( printer.colorMode() == QPrinter::GrayScale ) {
@@ -310,14 +396,29 @@ void MainWindow::exportCsv() {
     if (!d_plot) return;
 
     QString defaultfilter = "Comma-Separated Values (*.csv)";
+    const QString columnarfilter = "Binary columns, for numpy/pandas (*.mlc)";
+    const QString resampledfilter = "One table on a common time grid (*.csv)";
     QStringList filter;
     filter += defaultfilter;
+    filter += columnarfilter;
+    filter += resampledfilter;
 
     QString fileName = "data.csv";
     fileName = QFileDialog::getSaveFileName(this, "Export File Name", fileName, filter.join(";;"), &defaultfilter, QFileDialog::DontConfirmOverwrite);
     if ( fileName.isEmpty() ) return;
 
-    unsigned int n_written = d_plot->exportCsv(fileName.toStdString());
+    const bool columnar = (defaultfilter == columnarfilter) || fileName.endsWith(".mlc");
+    unsigned int n_written;
+    if (columnar) {
+        n_written = d_plot->exportColumnar(fileName.toStdString());
+    } else if (defaultfilter == resampledfilter) {
+        bool ok;
+        const double rate = QInputDialog::getDouble(this, "Export CSV", "Points per second (0=all time stamps):", 10., 0., 10000., 3, &ok);
+        if (!ok) return;
+        n_written = d_plot->exportResampled(fileName.toStdString(), rate);
+    } else {
+        n_written = d_plot->exportCsv(fileName.toStdString());
+    }
     if (n_written == 0) {
         QMessageBox msgbox(QMessageBox::Critical, "Export CSV", QString("Sorry, but the export failed. See console."));
         msgbox.exec();
@@ -359,7 +460,7 @@ void MainWindow::exportDocument() {
 #endif
 
     if ( !fileName.isEmpty() ) {
-        QwtPlotRenderer renderer;
+        MavPlotRenderer renderer(_export_raster, _export_dpi);
 
         // flags to make the document readable when exported (no dark background and so on)
         renderer.setDiscardFlag(QwtPlotRenderer::DiscardBackground, true);
@@ -488,6 +589,8 @@ void MainWindow::selected(const QPolygon &pos) {
 void MainWindow::_setupPlotWidget(void) {
     d_plot = new MavPlot(this);
     ui->vlPlot->insertWidget(0, d_plot);
+    d_overview = new MavPlotOverview(d_plot, this);
+    ui->vlPlot->insertWidget(1, d_overview);
 
     const int margin = 5;
     d_plot->setContentsMargins( margin, margin, margin, 0 );
@@ -550,7 +653,16 @@ void MainWindow::_buildDialog(void) {
     ui->tableDB->setSelectionBehavior(QAbstractItemView::SelectRows);
     ui->tableSystems->show();
     ui->tableSystems->horizontalHeader()->setStretchLastSection(true);
+    ui->treeData->header()->setStretchLastSection(false); // name takes the space, memory what it needs
+    #if (QT_VERSION < QT_VERSION_CHECK(5,0,0))
+        ui->treeData->header()->setResizeMode(0, QHeaderView::Stretch);
+        ui->treeData->header()->setResizeMode(1, QHeaderView::ResizeToContents);
+    #else
+        ui->treeData->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+        ui->treeData->header()->setSectionResizeMode(1, QHeaderView::ResizeToContents);
+    #endif
     ui->treeData->show();
+    ui->listSearchData->hide(); // until something is searched
     _lastsys = NULL;
 
     // add logview at the bottom
@@ -572,16 +684,23 @@ void MainWindow::_buildDialog(void) {
     btnCollapseAll->setText("Collapse All");
     QPushButton*btnRemoveLog = new QPushButton;
     btnRemoveLog->setText("Remove Selected");
+    QPushButton*btnTrace = new QPushButton;
+    btnTrace->setCheckable(true);
+    btnTrace->setChecked(Tracer::Instance().is_enabled()); // e.g., --trace
+    btnTrace->setText(btnTrace->isChecked() ? "Stop Trace..." : "Record Trace");
+    btnTrace->setToolTip("Record what each thread does when, for chrome://tracing or ui.perfetto.dev");
     hbox->addWidget(l);
     hbox->addSpacerItem(sp1);
     hbox->addWidget(btnExpandAll);
     hbox->addWidget(btnCollapseAll);
     hbox->addWidget(btnRemoveLog);
+    hbox->addWidget(btnTrace);
     hbox->addSpacerItem(sp2);
 
     connect(btnExpandAll, SIGNAL(clicked()), SLOT(on_buttonLogExpand_clicked()));
     connect(btnCollapseAll, SIGNAL(clicked()), SLOT(on_buttonLogCollapse_clicked()));
     connect(btnRemoveLog, SIGNAL(clicked()), SLOT(on_buttonLogRemove_clicked()));
+    connect(btnTrace, SIGNAL(toggled(bool)), SLOT(on_buttonTrace_toggled(bool)));
 
     vbox->addLayout(hbox);
     _logmsg = new QTreeView;
@@ -652,39 +771,54 @@ void MainWindow::_buildDialog(void) {
     //ui->centralWidget->setStyleSheet("background-color: red");
 }
 
-void MainWindow::_setupFilelist(void) {
-    for (list<MavlinkParser*>::const_iterator it = _parsers->begin(); it != _parsers->end(); ++it) {
-        QString fname = QString().fromStdString((*it)->get_filename());
-        ui->listFiles->addItem(fname);
+void MainWindow::_setupFilelist(const QStringList & files) {
+    for (QStringList::const_iterator it = files.begin(); it != files.end(); ++it) {
+        ui->listFiles->addItem(*it);
     }
 }
 
-MainWindow::MainWindow(list<MavlinkParser*> &parsers, CmdlineArgs *const args, QWidget *parent) :
+MainWindow::MainWindow(const list<string> &filenames, CmdlineArgs *const args, QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::MainWindow), _settings("DE.TUM.EI.RCS", "MavLogAnalyzer"), _dataSelected(NULL), _datagroupSelected(NULL),
     _markerA(false), _markerB(false), _markerData(false),
-    _dlgprogress(NULL), _dlgstats(NULL), _dlgdatatable(NULL) {
+    _dlgprogress(NULL), _dlgstats(NULL), _dlgdatatable(NULL), _dbworker(NULL), _reclaimer(1), _mem_budget_mb(0),
+    _export_raster(MavPlotRenderer::RASTER_DENSE), _export_dpi(PRINT_MAX_DPI), _prescanView(NULL),
+    _live(NULL), _liveTimer(NULL), _liveStructure(0), _liveBgRender(false) {
 
     ui->setupUi(this);    
     _args = args;
+    _dbworker = new DBWorker(this);
 
-    cout << "GUI got " << parsers.size() << " parsers from cmdline" << endl;
+    cout << "GUI got " << filenames.size() << " files from cmdline" << endl;
     _analyzer = new MavlinkScenario(args);
-    _parsers = &parsers;
 
-    // parse all in the one analyzer for the time being
+    // parse all in the one analyzer for the time being. One after the other, so that only one holds a file and a MavLink channel
+    QStringList files;
     mavlink_message_t msg;
-    for (list<MavlinkParser*>::iterator it = parsers.begin(); it!= parsers.end(); ++it) {
-        while ((*it)->get_next_msg(msg)) {
+    for (list<string>::const_iterator it = filenames.begin(); it != filenames.end(); ++it) {
+        // TODO: check that no file is added twice...
+        MavlinkParser parser(*it);
+        if (!parser.valid) {
+            cout << "Skipping file " << *it << " due to errors" << endl;
+            continue;
+        }
+        cout << "Opened file " << *it << "..." << endl;
+        while (parser.get_next_msg(msg)) {
             _analyzer->add_mavlink_message(msg);
         }
+        if (parser.is_starved()) {
+            cout << "Skipping file " << *it << ", no free MavLink channel" << endl;
+            continue;
+        }
+        files.push_back(QString::fromStdString(*it));
+        _analyzer->add_fingerprint(ScenarioCache::get_fingerprint(*it));
     }
     _analyzer->process();
     _analyzer->dump_overview();
 
     _buildDialog();
 
-    _setupFilelist();
+    _setupFilelist(files);
 
     _setupToolbar();
 
@@ -698,9 +832,14 @@ MainWindow::MainWindow(list<MavlinkParser*> &parsers, CmdlineArgs *const args, Q
 }
 
 MainWindow::~MainWindow() {
+    _stopLive();
     _save_windows_settings();
+    delete _dbworker; // waits for running jobs
+    _dbworker = NULL;
+    _deleteOrphans();
     delete ui;
     delete _analyzer;
+    _reclaimer.wait(); // scenarios replaced before
 }
 
 /**
@@ -725,13 +864,19 @@ void MainWindow::_addDataToPlot(TreeItem * const item) { // FIXME: this should i
     if (d) {
         // no group -> single item. just add it.
 
-        if (d->is_deferred()) {
+        if (d->is_deferred() && !d->is_overview()) {
+            if (_scenarioBusy("Load from DB")) return;
             DBConnector* dbCon = new DBConnector(_dbprops);
-            showProgressBar();
-            if (!dbCon->loadDataGroup(d, _dlgprogress)) {
-                cerr << "ERROR loading data group from database.";
+            // the overview is plotted at once. All samples follow where the user zooms in, see _loadDetails()
+            if (dbCon->loadDataOverview(d)) {
+                _previews.push_back(d);
+            } else {
+                showProgressBar();
+                if (!dbCon->loadDataGroup(d, _dlgprogress)) {
+                    cerr << "ERROR loading data group from database.";
+                }
+                hideProgressBar();
             }
-            hideProgressBar();
             delete dbCon;
             //d->unset_deferred(); // cuz now its loaded // TODO
         }
@@ -750,6 +895,48 @@ void MainWindow::_addDataToPlot(TreeItem * const item) { // FIXME: this should i
     }
 }
 
+/**
+ * @brief data in the plot which holds only its overview from the DB gets all samples of the
+ * part that is shown, once the overview has too few points there. A bit around the view is
+ * fetched as well, so that panning does not fetch again right away.
+ */
+void MainWindow::_loadDetails(void) {
+    if (_previews.empty()) return;
+    TraceScope trace("load details");
+    const QwtInterval i = d_plot->axisInterval(QwtPlot::xBottom);
+    const double margin = .5*(i.maxValue() - i.minValue());
+    const double vmin = i.minValue() - margin;
+    const double vmax = i.maxValue() + margin;
+
+    std::vector<Data*> todo;
+    for (std::vector<Data*>::const_iterator it = _previews.begin(); it != _previews.end(); ++it) {
+        Data*const d = *it;
+        if (!d->is_overview() || !d_plot->hasData(d)) continue;
+        const double t0 = d->get_epoch_datastart()/1E6;
+        double from, to;
+        if (d->get_detail_window(from, to) && from <= i.minValue() - t0 && to >= i.maxValue() - t0) continue; // has them
+        Data::data_stats s;
+        if (StatsCache::Instance().get_stats_timewindow(d, i.minValue(), i.maxValue(), s) && s.n_samples >= DETAIL_MIN_POINTS) continue;
+        todo.push_back(d);
+    }
+    if (todo.empty()) return;
+    // no message box on every pan. Tried again on the next one.
+    if ((_liveTimer && _liveTimer->isActive()) || (_dbworker && _dbworker->is_busy(_analyzer))) return;
+
+    // the curves must not be drawn by other threads while their data is replaced
+    const bool bgrender = d_plot->get_background_render();
+    d_plot->set_background_render(false);
+    DBConnector dbCon(_dbprops);
+    for (std::vector<Data*>::const_iterator it = todo.begin(); it != todo.end(); ++it) {
+        const double t0 = (*it)->get_epoch_datastart()/1E6;
+        if (!dbCon.loadDataDetail(*it, vmin - t0, vmax - t0)) {
+            cerr << "ERROR loading details of " << (*it)->get_name() << " from database." << endl;
+        }
+    }
+    d_plot->set_background_render(bgrender);
+    d_plot->dataAppended(false);
+}
+
 void MainWindow::on_buttonAddData_clicked() {
     bool set_zoom_base = (d_plot->get_num_data() == 0);
 
@@ -773,7 +960,30 @@ void MainWindow::on_scrollHPlot_sliderMoved(int position) {
     double viewmin = i.minValue();
     double viewmax = i.maxValue();
     double range = viewmax-viewmin;
-    d_plot->setAxisScale(QwtPlot::xBottom, position, position+range);
+    // only the overview follows while dragging. The plot is drawn once, where it is released.
+    d_overview->set_preview(position, position+range);
+}
+
+void MainWindow::on_scrollHPlot_sliderReleased() {
+    QwtInterval i =  d_plot->axisInterval(QwtPlot::xBottom);
+    const double position = ui->scrollHPlot->value();
+    d_overview->clear_preview();
+    _setViewX(position, position + i.maxValue() - i.minValue());
+}
+
+void MainWindow::overviewSelected(double x0, double x1) {
+    _setViewX(x0, x1);
+}
+
+void MainWindow::_setViewX(double x0, double x1) {
+    if (!(x1 > x0)) return;
+    d_plot->setAxisScale(QwtPlot::xBottom, x0, x1);
+    _updateHScroll();
+    _loadDetails();
+    if (_dlgstats) {
+        if (_dlgstats->isVisible())
+        _dlgstats->updateData();
+    }
 }
 
 void MainWindow::on_buttonAutoFit_clicked() {
@@ -785,22 +995,27 @@ void MainWindow::on_buttonAutoFit_clicked() {
 }
 
 /**
- * @brief check if a specific file is already loaded
+ * @brief check if a specific file is already loaded, either by name or under another name
  * @param fname
+ * @param fingerprint its contents, see ScenarioCache::get_fingerprint()
+ * @param pending fingerprints of the files about to be loaded with this one
  * @return true if loaded
  */
-bool MainWindow::_fileLoaded(const QString& f_fullpath) const {
-    bool found=false;
+bool MainWindow::_fileLoaded(const QString& f_fullpath, const std::string & fingerprint, const std::set<std::string> & pending) const {
     for(int i = 0; i < ui->listFiles->count(); ++i) {
         QListWidgetItem* item = ui->listFiles->item(i);
         if (item->text() == f_fullpath) {
-            found = true;
             QMessageBox msgbox(QMessageBox::Warning, QString("Nope"), QString("File %1 already in list.").arg(f_fullpath));
             msgbox.exec();
             return true;
         }
     }
-    return found;
+    if (!fingerprint.empty() && ((_analyzer && _analyzer->has_fingerprint(fingerprint)) || pending.count(fingerprint) > 0)) {
+        QMessageBox msgbox(QMessageBox::Warning, QString("Nope"), QString("File %1 has the same contents as a file already in list.").arg(f_fullpath));
+        msgbox.exec();
+        return true;
+    }
+    return false;
 }
 
 /**
@@ -821,257 +1036,251 @@ MavlinkScenario* MainWindow::_forceChooseScenario(const std::vector<MavlinkScena
     return ret;
 }
 
-void MainWindow::_addFile(double delay) {
-    // TODO: check whether currently a DB scenario is loaded. Ask user whether to clear or merge in.
-
+/**
+ * @brief file dialog which shows what a quick look at the current file tells, see LogPrescan
+ * @return selected files, empty if canceled
+ */
+QStringList MainWindow::_askLogFiles(void) {
     // start in last path
     _settings.beginGroup("fileDialog");
     QString startDir = _settings.value("last_directory","").toString();
     _settings.endGroup();
 
-    QStringList fileNames = QFileDialog::getOpenFileNames
-            (NULL,
-             "Add Files to scenario", startDir,
-             "MavLink or onboard log (*.tlog *.log *.mavlink *.px4log *.ulg);;All files (*.*)");
-    if (fileNames.empty()) return;
+    QFileDialog dlg(this, "Add Files to scenario", startDir,
+                    "MavLink or onboard log (*.tlog *.log *.mavlink *.px4log *.ulg);;All files (*.*)");
+    dlg.setFileMode(QFileDialog::ExistingFiles);
+    dlg.setOption(QFileDialog::DontUseNativeDialog); // a native one cannot take the preview
+    QLabel preview;
+    preview.setTextFormat(Qt::PlainText);
+    preview.setAlignment(Qt::AlignLeft | Qt::AlignTop);
+    preview.setMinimumWidth(280);
+    QGridLayout*grid = qobject_cast<QGridLayout*>(dlg.layout());
+    if (grid) {
+        grid->addWidget(&preview, 0, grid->columnCount(), grid->rowCount(), 1);
+    }
+    _prescanView = &preview;
+    connect(&dlg, SIGNAL(currentChanged(QString)), this, SLOT(showPrescan(QString)));
+    const bool accepted = (dlg.exec() == QDialog::Accepted);
+    _prescanView = NULL;
+    if (!accepted) return QStringList();
+
+    QStringList fileNames = dlg.selectedFiles();
+    if (fileNames.empty()) return fileNames;
 
     // save last path
     QString dirname = QString::fromStdString(getDirname(fileNames.first().toStdString()));
     _settings.beginGroup("fileDialog");
     _settings.setValue("last_directory",dirname);
     _settings.endGroup();
+    return fileNames;
+}
+
+/**
+ * @brief called by the file dialog of _askLogFiles() when another file is selected
+ */
+void MainWindow::showPrescan(const QString & path) {
+    if (!_prescanView) return;
+    LogPrescan scan;
+    if (QFileInfo(path).isFile() && scan.scan(path.toStdString())) {
+        _prescanView->setText(QString::fromStdString(scan.describe()));
+    } else {
+        _prescanView->clear();
+    }
+}
+
+/**
+ * @brief let the user pick among the topics which a prescan of the files found
+ * @param selection in: the last one, out: the new one. Both for TopicFilter::parse(), empty=all
+ * @return false if canceled
+ */
+bool MainWindow::_askTopics(const QStringList & files, QString & selection) {
+    std::vector<std::string> names;
+    std::set<std::string> known;
+    for (QStringList::const_iterator it = files.begin(); it != files.end(); ++it) {
+        LogPrescan scan;
+        if (!scan.scan(it->toStdString())) continue;
+        const std::vector<std::string> found = scan.get_topic_names();
+        for (std::vector<std::string>::const_iterator n = found.begin(); n != found.end(); ++n) {
+            if (known.insert(*n).second) names.push_back(*n);
+        }
+    }
+
+    const QString help = "Comma-separated list of topics or topic.field to import (names as in the log, '*' at the end matches anything; empty=all):";
+    if (names.empty()) {
+        // nothing to choose from
+        bool dlgresult;
+        const QString inp = QInputDialog::getText(this, "Select topics", help, QLineEdit::Normal, selection, &dlgresult);
+        if (!dlgresult) return false;
+        selection = inp;
+        return true;
+    }
+
+    TopicFilter last;
+    last.parse(selection.toStdString());
+
+    QDialog dlg(this);
+    dlg.setWindowTitle("Select topics");
+    QVBoxLayout*layout = new QVBoxLayout(&dlg);
+    layout->addWidget(new QLabel("Topics in the files, most frequent first:"));
+    QListWidget*list = new QListWidget;
+    for (std::vector<std::string>::const_iterator n = names.begin(); n != names.end(); ++n) {
+        QListWidgetItem*item = new QListWidgetItem(QString::fromStdString(*n), list);
+        item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+        item->setCheckState((!last.is_active() || last.accepts_topic(*n)) ? Qt::Checked : Qt::Unchecked);
+    }
+    layout->addWidget(list);
+    layout->addWidget(new QLabel("More, e.g. single fields like \"GPS.Alt\":"));
+    QLineEdit*more = new QLineEdit;
+    layout->addWidget(more);
+    QDialogButtonBox*buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    connect(buttons, SIGNAL(accepted()), &dlg, SLOT(accept()));
+    connect(buttons, SIGNAL(rejected()), &dlg, SLOT(reject()));
+    layout->addWidget(buttons);
+    if (dlg.exec() != QDialog::Accepted) return false;
+
+    QStringList chosen;
+    bool all = true;
+    for (int k = 0; k < list->count(); ++k) {
+        if (list->item(k)->checkState() == Qt::Checked) {
+            chosen.push_back(list->item(k)->text());
+        } else {
+            all = false;
+        }
+    }
+    if (!more->text().trimmed().isEmpty()) {
+        chosen.push_back(more->text().trimmed());
+    } else if (all) {
+        selection = "";
+        return true;
+    }
+    if (chosen.empty()) {
+        QMessageBox::warning(this, "Select topics", "Nothing selected.");
+        return false;
+    }
+    selection = chosen.join(",");
+    return true;
+}
+
+/**
+ * @param delay time offset for the new data
+ * @param filter which topics to import. NULL=as given on command line.
+ * @param files which files. Empty=ask the user
+ */
+void MainWindow::_addFile(double delay, const TopicFilter*filter, const QStringList & files) {
+    // TODO: check whether currently a DB scenario is loaded. Ask user whether to clear or merge in.
+    if (_scenarioBusy("Add Files")) return;
+
+    QStringList fileNames = files.empty() ? _askLogFiles() : files;
+    if (fileNames.empty()) return;
 
     // do it
     showProgressBar();
-    updateProgressBarTitle("Merging in data...");
+    updateProgressBarTitle("Parsing files...");
     updateProgressBarValue(0, fileNames.size());
 
     bool timeJumpsBack_yesToAll = false;
     bool timeJumpsBack_noToAll = false;    
     bool timeJumpsFwd_yesToAll = false;
     bool timeJumpsFwd_noToAll = false;    
+    const bool askTimeJumps = !_args || _args->time_jumps == CmdlineArgs::JUMPS_ASK;
+    QStringList timeJumpDecisions; ///< shown afterwards, when the policy decided without asking
 
-    unsigned int progress=0;
+    // parse and process every file into its own scenarios, on all cores
+    std::vector<FileImporter*> jobs;
+    std::set<std::string> fingerprints; ///< of the jobs, so that a file given twice is parsed once
     for (QStringList::Iterator itf = fileNames.begin(); itf != fileNames.end(); ++itf) {
         QString f = *itf;
         QString f_fullpath = QString::fromStdString(getFullPath(f.toStdString()));
-        string f_basename = getBasename(f_fullpath.toStdString());
         if(f_fullpath.compare("")==0) continue;       
-        if (!_fileLoaded(f_fullpath)) {
-
-            // use a new temporary scene for this file
-            std::vector<MavlinkScenario*> fileScenarios;
-            MavlinkScenario*tmp_scene = new MavlinkScenario(_args); fileScenarios.push_back(tmp_scene);
-            tmp_scene->setName(getBasename(f_fullpath.toStdString()));
-
-            // decide which parser to take and do it
-            string ext = getExtension(f_fullpath.toStdString());
-            ext = lcase(ext);            
-            bool parsed = false;
-            if (ext.compare("tlog") == 0 || ext.compare("mavlink") == 0) {
-                /*****************
-                 * MavLink Log
-                 *****************/
-                MavlinkParser*mlp = new MavlinkParser(f_fullpath.toStdString());
-                if (!mlp) {
-                    qDebug() << "Could not allocate memory for new MavlinkParser";
-                    continue; // skip file
-                }
-                if (!mlp->valid) {continue;}
-                _parsers->push_back(mlp); ///< FIXME: why do we keep that thing?
-
-                // run it, feed it into analyzer
-                mavlink_message_t msg;
-                while (mlp->get_next_msg(msg)) {
-                    int upd = tmp_scene->add_mavlink_message(msg);
-
-                    // ERROR HANDLING:
-                    if (1 == upd) {
-                        /************************
-                         * fwd jump in time base
-                         ************************/
-                        bool tolerate = false;
-                        if (!timeJumpsFwd_noToAll) {
-                            tolerate = timeJumpsFwd_yesToAll;
-                            if (!tolerate) {
-                                // ask whether to do this. FIXME: give more context to the user
-                                QMessageBox msg (QMessageBox::Question, "Time jump detected", "There is a rapid forward time jump in the data. Allow jump and make one scenario or demultiplex into separate scenarios?", QMessageBox::Yes|QMessageBox::No|QMessageBox::YesToAll|QMessageBox::NoToAll);
-                                msg.setButtonText(QMessageBox::Yes, "Allow");
-                                msg.setButtonText(QMessageBox::No, "Demux");
-                                msg.setButtonText(QMessageBox::YesToAll, "Allow all");
-                                msg.setButtonText(QMessageBox::NoToAll, "Demux all");
-                                switch (msg.exec()) {
-                                    case QMessageBox::YesToAll:
-                                        timeJumpsFwd_yesToAll = true;
-                                        // fallthrough;
-                                    case QMessageBox::Yes:
-                                        tolerate = true;
-                                        break;
-                                    case QMessageBox::NoToAll:
-                                        timeJumpsFwd_noToAll = true;
-                                        // fallthrough
-                                    case QMessageBox::No:
-                                        // nothing to do
-                                        break;
-                                    default:
-                                        break;
-                                }
-                            }                        
-                        }
-                        if (!tolerate) {
-                            // demux into new scenario
-                            tmp_scene = new MavlinkScenario(_args); fileScenarios.push_back(tmp_scene);
-                            tmp_scene->setName(getBasename(f_fullpath.toStdString()) + "_" + QString::number(fileScenarios.size()).toStdString());
-                        }
-                        tmp_scene->add_mavlink_message(msg, true);
-
-                    } else if (-1 == upd) {
-                        /*************************
-                         * back jump in time base
-                         *************************/
-                        bool tolerate = false;
-                        if (!timeJumpsBack_noToAll) {
-                            tolerate = timeJumpsBack_yesToAll;
-                            if (!tolerate) {
-                                // ask whether to do this. FIXME: give more context to the user
-                                QMessageBox msg(QMessageBox::Question, "Time jump detected", "There is a rapid backward time jump in the data. Allow jump and make one scenario (yes) or demultiplex into separate scenarios (no)?",  QMessageBox::Yes|QMessageBox::No|QMessageBox::YesToAll|QMessageBox::NoToAll);
-                                msg.setButtonText(QMessageBox::Yes, "Allow");
-                                msg.setButtonText(QMessageBox::No, "Demux");
-                                msg.setButtonText(QMessageBox::YesToAll, "Allow all");
-                                msg.setButtonText(QMessageBox::NoToAll, "Demux all");
-                                switch (msg.exec()) {
-                                    case QMessageBox::YesToAll:
-                                        timeJumpsBack_yesToAll = true;
-                                        // fallthrough;
-                                    case QMessageBox::Yes:
-                                        tolerate = true;
-                                        break;
-                                    case QMessageBox::NoToAll:
-                                        timeJumpsBack_noToAll = true;
-                                        // fallthrough
-                                    case QMessageBox::No:
-                                        // nothing to do
-                                        break;
-                                    default:
-                                        break;
-                                }
-                            }
-                        }
-                        if (!tolerate) {
-                            // demux into new scenario
-                            tmp_scene = new MavlinkScenario(_args); fileScenarios.push_back(tmp_scene);
-                            tmp_scene->setName(getBasename(f_fullpath.toStdString()) + "_" + QString::number(fileScenarios.size()).toStdString());
-                        }
-                        tmp_scene->add_mavlink_message(msg, true);
-                    }
+        // reads only a few MB, much less than parsing a copy of a log we already have
+        const std::string fingerprint = ScenarioCache::get_fingerprint(f_fullpath.toStdString());
+        if (_fileLoaded(f_fullpath, fingerprint, fingerprints)) continue;
+        if (!fingerprint.empty()) fingerprints.insert(fingerprint);
+        FileImporter*job = new FileImporter(f_fullpath.toStdString(), _args, delay);
+        job->set_fingerprint(fingerprint);
+        if (askTimeJumps) {
+            // cannot ask the user from a worker thread: demux at every jump, ask afterwards
+            job->set_timejump_policy(FileImporter::TIMEJUMP_DEMUX, FileImporter::TIMEJUMP_DEMUX);
+        } // else the importer takes the policy from the args
+        if (filter) job->set_topic_filter(filter);
+        jobs.push_back(job);
+    }
+    FileImporter::run_all(jobs, _args ? _args->threads : 0, &MainWindow::_importProgress, this);
 
+    // merge results in the order the files were given
+    updateProgressBarTitle("Merging in data...");
+    unsigned int progress=0;
+    std::vector<MavlinkScenario*> chosen; ///< one scene per file, merged in one go below
+    for (std::vector<FileImporter*>::iterator itj = jobs.begin(); itj != jobs.end(); ++itj) {
+        FileImporter*job = *itj;
+        const QString f_fullpath = QString::fromStdString(job->get_filename());
+        const string f_basename = getBasename(job->get_filename());
+        if (!job->is_parsed()) {
+            qDebug() << "Skipping file " << f_fullpath << ": " << QString::fromStdString(job->get_error());
+        } else {
+            /* the file had time jumps. Ask the user what to do with them. If any shall be
+             * tolerated, then we have to parse it again (rare case).
+             */
+            if (!askTimeJumps) {
+                const std::string decision = job->get_timejump_summary();
+                if (!decision.empty()) timeJumpDecisions.push_back(QString::fromStdString(decision));
+            } else if (job->get_num_timejumps_fwd() > 0 || job->get_num_timejumps_back() > 0) {
+                bool tolerate_fwd = false;
+                bool tolerate_back = false;
+                if (job->get_num_timejumps_fwd() > 0) {
+                    tolerate_fwd = _askTolerateTimeJump(true, timeJumpsFwd_yesToAll, timeJumpsFwd_noToAll);
                 }
-                const mavlink_status_t*stats = mlp->get_linkstats();
-                qDebug() << "Mavlink parser stats: "
-                            "#rx=" << stats->msg_received <<
-                            ", #rx ok=" << stats->packet_rx_success_count <<
-                            ", #rx drop" << stats->packet_rx_drop_count <<
-                            ", #buffer ovf=" << stats->buffer_overrun <<
-                            ", #parser err=" << stats->parse_error;
-
-                parsed = true;
-            } else {
-                OnboardLogParser*olp = OnboardLogParserFactory::Instance().Create(ext);
-                if (!olp)  {
-                    qDebug() << "Could not find/allocate parser for extension " << QString::fromStdString(ext);
-                    continue; // skip file
+                if (job->get_num_timejumps_back() > 0) {
+                    tolerate_back = _askTolerateTimeJump(false, timeJumpsBack_yesToAll, timeJumpsBack_noToAll);
                 }
-                // send parser info to scene
-                const std::string parsername = olp->get_parser_name();
-                OnboardData parser_id;
-                parser_id._string_data["_parser_name"] = parsername;
-                parser_id._msgname_orig = "_parser_name";
-                parser_id._valid = false;
-                tmp_scene->add_onboard_message (parser_id);
-
-                // now go ahead with actual data
-                olp->Load (f_fullpath.toStdString(), tmp_scene->getLogChannel());
-                if (!olp->valid) {continue;}
-
-                // - do the parsing into the scenario
-                while (olp->has_more_data()) {
-                    OnboardData d = olp->get_data();
-                    if (d.is_valid()) {
-                        tmp_scene->add_onboard_message(d);
-                    }
+                if (tolerate_fwd || tolerate_back) {
+                    updateProgressBarTitle("Reparsing " + f_fullpath);
+                    job->set_timejump_policy(tolerate_fwd ? FileImporter::TIMEJUMP_ALLOW : FileImporter::TIMEJUMP_DEMUX,
+                                             tolerate_back ? FileImporter::TIMEJUMP_ALLOW : FileImporter::TIMEJUMP_DEMUX);
+                    job->run();
+                    updateProgressBarTitle("Merging in data...");
                 }
-                delete olp;
-                parsed = true;
             }
 
-
-            // we tried all parsers at this point
-
-            if (parsed) {
-                /****************
-                 * GOT NEW DATA
-                 ****************/
-
+            /****************
+             * GOT NEW DATA
+             ****************/
+            std::vector<MavlinkScenario*> fileScenarios = job->get_scenarios();
+            if (!fileScenarios.empty()) {
                 /* first of all, if we have multiple scenes for this file, force user to
                  * select one (because MLA can only handle one at a time currently...)
                  */
-
-                // at this point, we have only one scene left. work on this.
+                MavlinkScenario*tmp_scene = fileScenarios.front();
                 if (fileScenarios.size() > 1) {
                     tmp_scene = _forceChooseScenario(fileScenarios);
                 }
-                // guess the start time of the logfile by looking at the file name                
-                QRegExp rex("\\d{4}-\\d{2}-\\d{2}[- ]\\d{2}-\\d{2}(-\\d{2})?");
-                if (rex.indexIn(QString::fromStdString(f_basename)) != -1) {
-                    QString str_datetime = rex.cap(0);
-
-                    // remove hyphen between date and time, if there is one
-                    if (str_datetime.length()>10) {
-                        #if (QT_VERSION > QT_VERSION_CHECK(5,0,0))
-                            char pos10 = str_datetime[10].toLatin1();
-                        #else
-                            char pos10 = str_datetime[10].toAscii();
-                        #endif
-                        if (pos10 != ' ') {
-                            str_datetime[10] = ' ';
-                        }
-                    }
-                    qDebug() << "GUESS DATE:" << str_datetime;
-                    uint64_t time_epoch_usec = 0;
-                    if (string_to_epoch_usec(str_datetime.toStdString(), time_epoch_usec)) {
-                        tmp_scene->set_starttime_guess(time_epoch_usec);
-                    }
-                }
 
                 ui->listFiles->addItem(f_fullpath);
-
-                // apply delay if any
-                if (delay != 0.0) {
-                    tmp_scene->shift_time(delay);
-                }
-
-                // analyze
-                tmp_scene->process();
                 tmp_scene->dump_overview();
 
-                // merge in the analyzer
-                _analyzer->merge_in(*tmp_scene);
+                // merged in the analyzer below. The scene is deleted with the job, so we can take its data
+                chosen.push_back(tmp_scene);
 
                 // set scenario name if empty
                 if (_analyzer->getName().empty()) {
                     _analyzer->setName(f_basename);
                 }
-
-                // remove all temporary scenes
-                for (std::vector<MavlinkScenario*>::iterator fit = fileScenarios.begin(); fit != fileScenarios.end(); ++fit) {
-                    delete *fit;
-                }
-                fileScenarios.clear();
             }
         }
-        updateProgressBarValue(++progress, fileNames.size());
+        updateProgressBarValue(++progress, jobs.size());
     }
+    _analyzer->take_in_all(chosen);
+    // removes all temporary scenes. Those not chosen still have all their data
+    for (std::vector<FileImporter*>::iterator itj = jobs.begin(); itj != jobs.end(); ++itj) {
+        _reclaimer.start(new DeleteTask<FileImporter>(*itj));
+    }
+    jobs.clear();
     hideProgressBar();
+    if (!timeJumpDecisions.empty()) {
+        QMessageBox::information(this, "Time jumps", "Time jumps were handled by the policy \"" +
+                                 QString::fromStdString(CmdlineArgs::jumps_to_string(_args->time_jumps, _args->jumps_demux_sec)) +
+                                 "\":\n" + timeJumpDecisions.join("\n"));
+    }
     _stvm->reload(); // update everything;
     _dtvm->reload();
 
@@ -1082,6 +1291,54 @@ void MainWindow::_addFile(double delay) {
     }
 }
 
+/**
+ * @brief ask the user whether a time jump shall be tolerated, or the data be demultiplexed
+ * @param forward direction of the jump
+ * @param yesToAll remembers "allow all" over several calls
+ * @param noToAll remembers "demux all" over several calls
+ * @return true if the jump shall be tolerated
+ */
+bool MainWindow::_askTolerateTimeJump(bool forward, bool & yesToAll, bool & noToAll) {
+    if (noToAll) return false;
+    if (yesToAll) return true;
+
+    bool tolerate = false;
+    // FIXME: give more context to the user
+    QString text = forward ?
+                "There is a rapid forward time jump in the data. Allow jump and make one scenario or demultiplex into separate scenarios?" :
+                "There is a rapid backward time jump in the data. Allow jump and make one scenario (yes) or demultiplex into separate scenarios (no)?";
+    QMessageBox msg (QMessageBox::Question, "Time jump detected", text, QMessageBox::Yes|QMessageBox::No|QMessageBox::YesToAll|QMessageBox::NoToAll);
+    msg.setButtonText(QMessageBox::Yes, "Allow");
+    msg.setButtonText(QMessageBox::No, "Demux");
+    msg.setButtonText(QMessageBox::YesToAll, "Allow all");
+    msg.setButtonText(QMessageBox::NoToAll, "Demux all");
+    switch (msg.exec()) {
+        case QMessageBox::YesToAll:
+            yesToAll = true;
+            // fallthrough;
+        case QMessageBox::Yes:
+            tolerate = true;
+            break;
+        case QMessageBox::NoToAll:
+            noToAll = true;
+            // fallthrough
+        case QMessageBox::No:
+            // nothing to do
+            break;
+        default:
+            break;
+    }
+    return tolerate;
+}
+
+/**
+ * @brief progress callback for FileImporter::run_all
+ */
+void MainWindow::_importProgress(void*ctx, unsigned int done, unsigned int total) {
+    MainWindow*const self = (MainWindow*)ctx;
+    self->updateProgressBarValue(done, total);
+}
+
 void MainWindow::on_buttonAddFile_clicked() {
     _addFile();
 }
@@ -1175,6 +1432,35 @@ void MainWindow::on_treeData_doubleClicked(const QModelIndex &/*index*/) {
     on_buttonAddData_clicked(); // delegate
 }
 
+void MainWindow::on_txtSearchData_textChanged(const QString & text) {
+    ui->listSearchData->clear();
+    _searchResults.clear();
+    if (text.isEmpty()) {
+        ui->listSearchData->hide();
+        return;
+    }
+    _dtvm->search(text, _searchResults);
+    for (std::vector<Data*>::const_iterator it = _searchResults.begin(); it != _searchResults.end(); ++it) {
+        ui->listSearchData->addItem(QString::fromStdString(Data::get_fullname(*it)));
+    }
+    ui->listSearchData->show();
+}
+
+void MainWindow::on_listSearchData_itemClicked(QListWidgetItem*item) {
+    const int row = ui->listSearchData->row(item);
+    if (row < 0 || (unsigned int)row >= _searchResults.size()) return;
+    // select it in the tree, which makes it the selected data
+    const QModelIndex idx = _dtvm->indexOf(_searchResults[row]);
+    if (!idx.isValid()) return;
+    ui->treeData->scrollTo(idx);
+    ui->treeData->setCurrentIndex(idx);
+}
+
+void MainWindow::on_listSearchData_itemDoubleClicked(QListWidgetItem*item) {
+    on_listSearchData_itemClicked(item);
+    on_buttonAddData_clicked(); // delegate
+}
+
 void MainWindow::on_buttonSearchDB_clicked() {
     //Open FilterWindow
     FilterWindow filterwindow(_dbprops, this);
@@ -1184,6 +1470,12 @@ void MainWindow::on_buttonSearchDB_clicked() {
     filterwindow.exec();
 }
 
+void MainWindow::on_buttonFleetDB_clicked() {
+    DialogFleet dlg(_dbprops, this);
+    dlg.setModal(true);
+    dlg.exec();
+}
+
 QStringList MainWindow::_getFileNames(void)
 {
     QFileDialog *diag=new QFileDialog;
@@ -1218,27 +1510,79 @@ void MainWindow::on_buttonImport_clicked()
 #endif
 
 void MainWindow::_clearScenario(void) {    
+    MavlinkScenario*const scen = new MavlinkScenario(_args);
+    if (_args) {
+        scen->set_memory_budget((size_t)_args->mem_budget_mb*1024*1024, _args->scratch_dir);
+    }
+    _setScenario(scen);
+}
+
+/**
+ * @brief replace the current scenario by the given one, which then belongs to us
+ */
+void MainWindow::_setScenario(MavlinkScenario*scen) {
+    _stopLive(); // it feeds the one which goes now
     // clear GUI
     if (d_plot) d_plot->removeAllData();
     ui->txtDetails->clear();
     ui->listFiles->clear();
     // FIXME: qtableview has a model, and this is invalid now
 
-    // FIXME: would be better to have a clear() instead of making new object
     MavlinkScenario*_killme = _analyzer;
     _analyzer = NULL;
+    _previews.clear();
     _lastsys = NULL;
-    _analyzer = new MavlinkScenario(_args);
+    _analyzer = scen;
     // before we free memory, remove all refs
     _stvm->setScenario(_analyzer);        
     _dtvm->setScenario(_analyzer);
     ui->tableSystems->reset();
-    delete _killme;
+    if (_dbworker && _dbworker->is_busy(_killme)) {
+        _orphans.push_back(_killme); // deleted when saving is done
+    } else {
+        _reclaim(_killme);
+    }
+    _stvm->reload();
+    _dtvm->reload();
+}
+
+/**
+ * @brief tell the user if the current scenario cannot be changed now
+ * @return true if it is being saved in the background
+ */
+bool MainWindow::_scenarioBusy(const QString & title) {
+    if (_liveTimer && _liveTimer->isActive()) {
+        QMessageBox::information(this, title, "The current scenario is receiving live data. Please stop that first.", QMessageBox::Ok);
+        return true;
+    }
+    if (!_dbworker || !_dbworker->is_busy(_analyzer)) return false;
+    QMessageBox::information(this, title, "The current scenario is being saved to the DB. Please wait until that is done.", QMessageBox::Ok);
+    return true;
+}
+
+/**
+ * @brief delete a scenario nobody refers to anymore in the background. Freeing the samples,
+ * unmapping spilled data and closing files can take seconds for large logs.
+ */
+void MainWindow::_reclaim(MavlinkScenario*scen) {
+    if (!scen) return;
+    _reclaimer.start(new DeleteTask<MavlinkScenario>(scen));
+}
+
+void MainWindow::_deleteOrphans(void) {
+    for (std::list<MavlinkScenario*>::iterator it = _orphans.begin(); it != _orphans.end();) {
+        if (!_dbworker || !_dbworker->is_busy(*it)) {
+            _reclaim(*it);
+            it = _orphans.erase(it);
+        } else {
+            ++it;
+        }
+    }
 }
 
 void MainWindow::on_DBSelectionChangedSlot(const QItemSelection &, const QItemSelection & desel) {
 
-    // if plot is non-empty, reset it
+    // if plot is non-empty, it will be reset
     if (d_plot->get_num_data() > 0) {
         QMessageBox::StandardButton reply;
         reply = QMessageBox::question(this, "Remove all Data", "You are about to change the scenario. This will clear the plot. Do you want to continue?", QMessageBox::Yes|QMessageBox::No);
@@ -1252,32 +1596,57 @@ void MainWindow::on_DBSelectionChangedSlot(const QItemSelection &, const QItemSe
             ui->tableDB->blockSignals(false);
             return;
         }
-        d_plot->removeAllData();
     }
 
-    // FIXME: let user decide whether be merged in or cleared
-    _clearScenario();
-
-    showProgressBar();
-    updateProgressBarTitle("Loading from DB...");    
-
     //get ID of selected Data
     int id, row;
     const QModelIndex index = ui->tableDB->selectionModel()->currentIndex();
     row=index.row();
     id = ui->tableDB->model()->data(ui->tableDB->model()->index(row, 0)).toInt();
 
-    //get Scenario from DB    
-    DBConnector* dbCon = new DBConnector(_dbprops);
-    dbCon->setLazyLoad(ui->chkLazy->isChecked());
-    std::cout << dbCon->loadScenarioFromDB(id,*_analyzer, _dlgprogress) <<std::endl;
-    std::cout << "FINISHED"<<std::endl;    
-    // update everything;
-    _stvm->reload();
-    _dtvm->reload();
-    delete dbCon;
+    // load into a new scenario in the background. The current one stays until that is done.
+    // FIXME: let user decide whether be merged in or cleared
+    MavlinkScenario*const scen = new MavlinkScenario(_args);
+    if (_args) {
+        scen->set_memory_budget((size_t)_args->mem_budget_mb*1024*1024, _args->scratch_dir);
+    }
+    DialogProgressBar*const dlg = new DialogProgressBar(this);
+    dlg->setLabel("Loading from DB...");
+    dlg->setValue(0, 100);
+    dlg->show();
+    _dbworker->load(_dbprops, id, ui->chkLazy->isChecked(), scen, dlg);
+}
 
-    hideProgressBar();
+/**
+ * @brief a background job of _dbworker is done
+ */
+void MainWindow::dbJobFinished(unsigned int /*id*/, int type, bool success, MavlinkScenario*scen, DialogProgressBar*dlg) {
+    const bool canceled = dlg && dlg->wasCanceled();
+    if (dlg) {
+        dlg->hide();
+        dlg->deleteLater();
+    }
+    if (type == DBWorker::JOB_LOAD) {
+        if (success) {
+            _setScenario(scen);
+            std::cout << "FINISHED"<<std::endl;
+        } else {
+            delete scen;
+            if (!canceled) {
+                QMessageBox::warning(this, "Load from DB", "Errors while loading scenario from DB, see command line.", QMessageBox::Ok);
+            }
+        }
+    } else {
+        _deleteOrphans();
+        if (success) {
+            QMessageBox::information(this, "Save to DB", "Successfully saved current scenario to DB.", QMessageBox::Ok);
+        } else if (!canceled) {
+            QMessageBox::warning(this, "Save to DB", "Errors while saving current scenario to DB, see command line.", QMessageBox::Ok);
+        }
+    }
+    if (canceled) {
+        statusBar()->showMessage(type == DBWorker::JOB_LOAD ? "Loading from DB canceled" : "Saving to DB canceled", 5000);
+    }
 }
 
 void MainWindow::on_buttonCalcStats_clicked() {
@@ -1287,6 +1656,126 @@ void MainWindow::on_buttonCalcStats_clicked() {
     _dlgstats->show();
 }
 
+void MainWindow::on_buttonLive_toggled(bool checked) {
+    if (checked) {
+        if (!_startLive()) {
+            ui->buttonLive->blockSignals(true);
+            ui->buttonLive->setChecked(false);
+            ui->buttonLive->blockSignals(false);
+        }
+    } else {
+        _stopLive();
+    }
+}
+
+/**
+ * @brief ask for a source and feed it into the scenario, see LiveSource
+ * @return false if canceled or the source cannot be opened
+ */
+bool MainWindow::_startLive(void) {
+    if (_scenarioBusy("Live")) return false;
+
+    _settings.beginGroup("live");
+    const QString last = _settings.value("source", "udp:14550").toString();
+    _settings.endGroup();
+    bool dlgresult;
+    const QString spec = QInputDialog::getText(this, "Live", "Source: udp:[ADDRESS:]PORT, tcp:HOST:PORT, serial:DEVICE[:BAUD],\nor file:PATH to follow a tlog or ulg which is still being written",
+                                               QLineEdit::Normal, last, &dlgresult).trimmed();
+    if (!dlgresult || spec.isEmpty()) return false;
+
+    // live data would mix with what is there
+    if (_analyzer && (ui->listFiles->count() > 0 || _analyzer->get_structure_version() > 0)) {
+        if (QMessageBox::question(this, "Live", "Live data goes into a new scenario. Clear the current one?",
+                                  QMessageBox::Yes|QMessageBox::No) != QMessageBox::Yes) {
+            return false;
+        }
+        _clearScenario();
+    }
+
+    if (!_live) {
+        _live = new LiveSource(this);
+        connect(_live, SIGNAL(disconnected(QString)), this, SLOT(liveDisconnected(QString)));
+        _liveTimer = new QTimer(this);
+        _liveTimer->setInterval(LIVE_REFRESH_MSEC);
+        connect(_liveTimer, SIGNAL(timeout()), this, SLOT(liveRefresh()));
+    }
+    const bool allow_jumps = !_args || _args->time_jumps != CmdlineArgs::JUMPS_IGNORE; // cannot demux data on screen
+    if (!_live->open(spec.toStdString(), _analyzer, allow_jumps)) {
+        QMessageBox::warning(this, "Live", QString::fromStdString(_live->get_error()));
+        return false;
+    }
+    _settings.beginGroup("live");
+    _settings.setValue("source", spec);
+    _settings.endGroup();
+
+    _analyzer->set_starttime_guess((uint64_t)QDateTime::currentMSecsSinceEpoch()*1000);
+    if (_analyzer->getName().empty()) {
+        _analyzer->setName("live " + spec.toStdString());
+    }
+    ui->listFiles->addItem(spec);
+
+    // tiles would be drawn by other threads while the series grow
+    _liveBgRender = d_plot->get_background_render();
+    d_plot->set_background_render(false);
+    _liveStructure = _analyzer->get_structure_version();
+    _liveTimer->start();
+    return true;
+}
+
+/**
+ * @brief stop receiving, if live. Then the data is processed like that of a file.
+ */
+void MainWindow::_stopLive(void) {
+    if (!_liveTimer || !_liveTimer->isActive()) return;
+    _liveTimer->stop();
+    const std::string status = _live->get_status();
+    _live->close();
+    if (!status.empty()) statusBar()->showMessage(QString::fromStdString(status), 10000);
+
+    ui->buttonLive->blockSignals(true);
+    ui->buttonLive->setChecked(false);
+    ui->buttonLive->blockSignals(false);
+    d_plot->set_background_render(_liveBgRender);
+
+    // now that it is complete, derive the rest as after an import
+    if (_analyzer) {
+        _analyzer->process();
+        _analyzer->dump_overview();
+    }
+    _stvm->reload();
+    _dtvm->reload();
+    if (_lastsys) {
+        _updateTextInfo(_lastsys);
+        _updateTreeData(_lastsys);
+    }
+    d_plot->dataAppended(false);
+}
+
+/**
+ * @brief called periodically while live: draws the new samples and shows new data in the tree
+ */
+void MainWindow::liveRefresh(void) {
+    if (!_analyzer || !_live) return;
+    _analyzer->seal_data(); // the series are read from here on
+    const unsigned int v = _analyzer->get_structure_version();
+    if (v != _liveStructure) {
+        _liveStructure = v;
+        _stvm->reload();
+        _dtvm->reload();
+        if (_lastsys) _updateTreeData(_lastsys);
+    }
+    if (d_plot->get_num_data() > 0) {
+        d_plot->dataAppended(true);
+        _updateHScroll();
+    }
+    statusBar()->showMessage(QString::fromStdString(_live->get_status()));
+}
+
+void MainWindow::liveDisconnected(const QString & reason) {
+    _stopLive();
+    QMessageBox::warning(this, "Live", "The link was closed: " + reason);
+}
+
 void MainWindow::on_buttonClearScenario_clicked()
 {
     QMessageBox::StandardButton reply;
@@ -1299,24 +1788,154 @@ void MainWindow::on_buttonClearScenario_clicked()
 
 void MainWindow::on_buttonSaveDB_clicked() {
     if (!_analyzer) return;
+    _stopLive(); // the worker must not read it while it grows
+    if (_dbworker->is_busy(_analyzer)) {
+        QMessageBox::information(this, "Save to DB", "The current scenario is already being saved.", QMessageBox::Ok);
+        return;
+    }
 
-    DBConnector* dbCon = new DBConnector(_dbprops);
-    if (!dbCon) return;
+    // data which holds only its overview would be saved as if that were all of it
+    if (!_previews.empty()) {
+        DBConnector dbCon(_dbprops);
+        const bool bgrender = d_plot->get_background_render();
+        d_plot->set_background_render(false);
+        for (std::vector<Data*>::const_iterator it = _previews.begin(); it != _previews.end(); ++it) {
+            if ((*it)->is_overview() && !dbCon.loadDataGroup(*it, NULL)) {
+                QMessageBox::warning(this, "Save to DB", "Cannot fetch all samples of " + QString::fromStdString((*it)->get_name()) + ", see command line.", QMessageBox::Ok);
+                d_plot->set_background_render(bgrender);
+                return;
+            }
+        }
+        d_plot->set_background_render(bgrender);
+        d_plot->dataAppended(false);
+        _previews.clear();
+    }
 
-    showProgressBar();
-    updateProgressBarTitle("Loading from DB...");
+    // asking is done here, because the job runs in the background
+    DBConnector::similar_e similar = DBConnector::SIMILAR_INSERT;
+    {
+        DBConnector dbCon(_dbprops);
+        std::string strsimilar;
+        const int found = dbCon.findSimilarScenario(_analyzer, strsimilar);
+        if (found < 0) {
+            QMessageBox::warning(this, "Save to DB", "Cannot access the DB, see command line.", QMessageBox::Ok);
+            return;
+        }
+        if (found == 2) {
+            // same log files: no second copy, only an update
+            QMessageBox msg (QMessageBox::Question, "Scenario already saved", QString("The log files of this scenario are already in the database as '") + QString::fromStdString(strsimilar) + QString("'. Do you want to update that scenario with the current one?"), QMessageBox::Yes|QMessageBox::Cancel);
+            msg.setButtonText(QMessageBox::Yes, "Overwrite/update existing scenario");
+            if (QMessageBox::Yes != msg.exec()) return;
+            similar = DBConnector::SIMILAR_UPDATE;
+        } else if (found > 0) {
+            QMessageBox msg (QMessageBox::Question, "Similar Scenario found", QString("A similar scenario with the name '") + QString::fromStdString(strsimilar) + QString("' is already in the database. Do you want to update that scenario with the current one (no), or insert the current one anyway (yes)?"), QMessageBox::Yes|QMessageBox::No);
+            msg.setButtonText(QMessageBox::Yes, "Create a new scenario");
+            msg.setButtonText(QMessageBox::No, "Overwrite/update existing scenario");
+            if (QMessageBox::No == msg.exec()) similar = DBConnector::SIMILAR_UPDATE;
+        }
+    }
 
-    if (dbCon->saveScenarioToDB(_analyzer, _dlgprogress)) {
-        QMessageBox::information(this, "Save to DB", "Successfully saved current scenario to DB.", QMessageBox::Ok);
-    } else {
-        QMessageBox::warning(this, "Save to DB", "Errors while saving current scenario to DB, see command line.", QMessageBox::Ok);
+    DialogProgressBar*const dlg = new DialogProgressBar(this);
+    dlg->setLabel("Saving to DB...");
+    dlg->setValue(0, 100);
+    dlg->show();
+    _dbworker->save(_dbprops, _analyzer, similar, dlg);
+}
+
+/**
+ * @brief let the user edit the definitions of derived series, see Expression. They are
+ * computed for each import from now on, and right away for the current scenario.
+ */
+void MainWindow::on_buttonDerived_clicked() {
+    if (_scenarioBusy("Derived Series")) return;
+    QString text;
+    if (_args) {
+        for (std::list<std::string>::const_iterator it = _args->expressions.begin(); it != _args->expressions.end(); ++it) {
+            text += QString::fromStdString(*it) + "\n";
+        }
     }
-    delete (dbCon);
-    hideProgressBar();
+
+    QStringList defs;
+    for (;;) {
+        QDialog dlg(this);
+        dlg.setWindowTitle("Derived Series");
+        QVBoxLayout*layout = new QVBoxLayout(&dlg);
+        layout->addWidget(new QLabel("One per line, \"name [units] = formula\" over data paths, e.g.\n"
+                                     "  power [W] = power/battery_voltage * power/battery_current\n"
+                                     "Division next to a path needs blanks (a / b). Results go to \"" EXPRESSION_GROUP "\"."));
+        QPlainTextEdit*edit = new QPlainTextEdit(text);
+        layout->addWidget(edit);
+        QDialogButtonBox*buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+        connect(buttons, SIGNAL(accepted()), &dlg, SLOT(accept()));
+        connect(buttons, SIGNAL(rejected()), &dlg, SLOT(reject()));
+        layout->addWidget(buttons);
+        if (dlg.exec() != QDialog::Accepted) return;
+        text = edit->toPlainText();
+
+        // check all before taking any
+        defs.clear();
+        QString errors;
+        const QStringList lines = text.split("\n");
+        for (QStringList::const_iterator it = lines.begin(); it != lines.end(); ++it) {
+            const QString line = it->trimmed();
+            if (line.isEmpty()) continue;
+            Expression e;
+            if (!e.parse(line.toStdString())) {
+                errors += line + ": " + QString::fromStdString(e.get_error()) + "\n";
+            }
+            defs.push_back(line);
+        }
+        if (errors.isEmpty()) break;
+        QMessageBox msgbox(QMessageBox::Warning, "Derived Series", "Please correct these:\n" + errors);
+        msgbox.exec();
+    }
+
+    _expressions = defs;
+    std::list<std::string> definitions;
+    for (QStringList::const_iterator it = defs.begin(); it != defs.end(); ++it) {
+        definitions.push_back(it->toStdString());
+    }
+    if (_args) _args->expressions = definitions;
+    if (_analyzer) {
+        const unsigned int n = _analyzer->apply_expressions(definitions);
+        showInfo(QString::number(n) + " derived series computed");
+    }
+    _dtvm->reload();
+    if (_lastsys) _updateTreeData(_lastsys);
+}
+
+/**
+ * @brief find where conditions hold in the loaded data, see ConditionSearch. The result
+ * of the current system is added to the plot, such that Prev/Next jump through it.
+ */
+void MainWindow::on_buttonSearchData_clicked() {
+    if (!_analyzer || _scenarioBusy("Search")) return;
+    bool ok;
+    const QString query = QInputDialog::getText(this, "Search in loaded data",
+        "Conditions joined by \"and\"/\"or\", and a duration, e.g.\n"
+        "  vibe/clip > 10 with airspeed < 8 for at least 2 s", QLineEdit::Normal, _lastSearch, &ok);
+    if (!ok || query.trimmed().isEmpty()) return;
+    _lastSearch = query.trimmed();
+
+    std::string error;
+    const int n = _analyzer->search(_lastSearch.toStdString(), error);
+    if (n < 0) {
+        QMessageBox msgbox(QMessageBox::Warning, "Search", "Cannot understand the query: " + QString::fromStdString(error));
+        msgbox.exec();
+        return;
+    }
+    _dtvm->reload();
+    if (_lastsys) {
+        _updateTreeData(_lastsys);
+        const Data*const d = _lastsys->get_data<Data>(ConditionSearch::get_result_name(_lastSearch.toStdString()));
+        if (d && d_plot->addData(d)) _updateHScroll();
+    }
+    showInfo(QString::number(n) + " matches of \"" + _lastSearch + "\"");
 }
 
 void MainWindow::on_buttonScenarioProps_clicked()
 {
+   if (_scenarioBusy("Scenario Properties")) return;
    DialogScenarioProps dlg(_analyzer);
    dlg.setModal(true);
    dlg.exec(); // blocking until closed
@@ -1340,6 +1959,28 @@ void MainWindow::on_buttonAddFileWithDelay_clicked() {
     _addFile(delay);
 }
 
+void MainWindow::on_buttonAddFileSelectTopics_clicked() {
+    if (_scenarioBusy("Add Files")) return;
+    const QStringList files = _askLogFiles();
+    if (files.empty()) return;
+
+    // remember the last selection
+    _settings.beginGroup("fileDialog");
+    QString inp = _settings.value("topics","").toString();
+    _settings.endGroup();
+    if (!_askTopics(files, inp)) return;
+
+    TopicFilter filter;
+    if (!filter.parse(inp.toStdString())) {
+        QMessageBox::warning(this, "Select topics", "Malformed topic selection.");
+        return;
+    }
+    _settings.beginGroup("fileDialog");
+    _settings.setValue("topics", inp);
+    _settings.endGroup();
+    _addFile(0., &filter, files); // keeps filter alive until import is done
+}
+
 void MainWindow::on_buttonDataPrev_clicked() {
     // get combobox item, then request plot to reverse to last data item
     int idx = ui->cboDataSel->currentIndex();
@@ -1405,6 +2046,31 @@ void MainWindow::on_buttonLogCollapse_clicked() {
     _logmsg->collapseAll();
 }
 
+/**
+ * @brief start recording a timeline with the Tracer, or stop and save it
+ */
+void MainWindow::on_buttonTrace_toggled(bool on) {
+    QPushButton*const btn = qobject_cast<QPushButton*>(sender());
+    if (on) {
+        Tracer::Instance().reset();
+        Tracer::Instance().set_enabled(true);
+        if (btn) btn->setText("Stop Trace...");
+        return;
+    }
+    Tracer::Instance().set_enabled(false);
+    if (btn) btn->setText("Record Trace");
+
+    _settings.beginGroup("trace");
+    const QString last = _settings.value("file", QVariant("mavloganalyzer.trace.json")).toString();
+    const QString fileName = QFileDialog::getSaveFileName(this, "Save Trace", last, "Chrome trace (*.json)");
+    if (!fileName.isEmpty()) _settings.setValue("file", fileName);
+    _settings.endGroup();
+    if (fileName.isEmpty()) return;
+    if (!Tracer::Instance().write_json(fileName.toStdString())) {
+        QMessageBox::warning(this, "Trace", "Cannot write " + fileName);
+    }
+}
+
 void MainWindow::on_buttonLogRemove_clicked() {
     // get selection of _logmsg
     QItemSelectionModel * mdl = _logmsg->selectionModel();
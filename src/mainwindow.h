@@ -24,11 +24,15 @@
 #define MAINWINDOW_H
 
 #include <list>
+#include <set>
 #include <QMainWindow>
 #include <QSettings>
 #include <QItemSelectionModel>
 #include <QPolygon>
 #include <QTreeView>
+#include <QListWidget>
+#include <QLabel>
+#include <QTimer>
 #include <qwt_plot_panner.h>
 #include <qwt_plot_picker.h>
 #include <qwt_plot_zoomer.h>
@@ -44,10 +48,15 @@
 #include "dialogscenarioprops.h"
 #include "dialogdatatable.h"
 #include "mavplot.h"
+#include "mavplotoverview.h"
+#include "mavplotrenderer.h"
 #include "Zoomer.h"
 #include "Panner.h"
 #include "cmdlineargs.h"
 #include "dbconnector.h"
+#include "dbworker.h"
+#include "livesource.h"
+#include "taskpool.h"
 
 namespace Ui {
 class MainWindow;
@@ -58,7 +67,10 @@ class MainWindow : public QMainWindow
     Q_OBJECT
     friend class FilterWindow;
 public:
-    explicit MainWindow(std::list<MavlinkParser*> &parsers, CmdlineArgs *const args, QWidget *parent = 0);
+    /**
+     * @param parsers of the files given on the command line. Read into the scenario and deleted, list is cleared.
+     */
+    explicit MainWindow(const std::list<std::string> &filenames, CmdlineArgs *const args, QWidget *parent = 0);
     ~MainWindow();
 
     void showProgressBar();
@@ -85,6 +97,8 @@ private slots:
     void enableHLockMode(bool on);
     void showInfo(QString text = "");
     void on_scrollHPlot_sliderMoved(int position);
+    void on_scrollHPlot_sliderReleased();
+    void overviewSelected(double x0, double x1);
     void on_buttonAddData_clicked();
     void on_buttonAutoFit_clicked();
     void on_buttonAddFile_clicked();
@@ -95,13 +109,20 @@ private slots:
     void on_buttonSetYZoom(bool on);
     void on_buttonClear_clicked();
     void on_treeData_doubleClicked(const QModelIndex &index);
+    void on_txtSearchData_textChanged(const QString & text);
+    void on_listSearchData_itemClicked(QListWidgetItem*item);
+    void on_listSearchData_itemDoubleClicked(QListWidgetItem*item);
     void on_buttonCalcStats_clicked();
 	void on_buttonSearchDB_clicked();
+	void on_buttonFleetDB_clicked();
     void on_buttonClearScenario_clicked();
     void on_buttonSaveDB_clicked();
     void on_buttonScenarioProps_clicked();
+    void on_buttonDerived_clicked();
+    void on_buttonSearchData_clicked();
     void on_buttonSetupDB_clicked();     
     void on_buttonAddFileWithDelay_clicked();
+    void on_buttonAddFileSelectTopics_clicked();
     void on_buttonDataPrev_clicked();
     void on_buttonDataNext_clicked();
     void on_cboDataSel_currentIndexChanged(int index);
@@ -111,27 +132,49 @@ private slots:
     void on_buttonLogExpand_clicked();
     void on_buttonLogCollapse_clicked();
     void on_buttonLogRemove_clicked();
+    void on_buttonTrace_toggled(bool on);
+    void dbJobFinished(unsigned int id, int type, bool success, MavlinkScenario*scen, DialogProgressBar*dlg);
+    void showPrescan(const QString & path);
+    void on_buttonLive_toggled(bool checked);
+    void liveRefresh(void);
+    void liveDisconnected(const QString & reason);
 
 signals:
     void systemSelectionChangedSignal(); ///< indicate that someone clicked on another system -> we need to reload TreeView and the info box
 
 private:
     void _addDataToPlot(TreeItem * const item);
-    void _addFile(double delay = 0.0);
-    bool _fileLoaded(const QString &fname) const;
+    void _loadDetails(void);
+    void _addFile(double delay = 0.0, const TopicFilter*filter = NULL, const QStringList & files = QStringList());
+    QStringList _askLogFiles(void);
+    bool _askTopics(const QStringList & files, QString & selection);
+    bool _fileLoaded(const QString &fname, const std::string & fingerprint, const std::set<std::string> & pending) const;
+    bool _askTolerateTimeJump(bool forward, bool & yesToAll, bool & noToAll);
+    static void _importProgress(void*ctx, unsigned int done, unsigned int total);
     MavlinkScenario* _forceChooseScenario(const std::vector<MavlinkScenario*>& items) const ;
     void _load_windows_settings(void);
     void _save_windows_settings(void);
     void _setupSignalsAndSlots(void);
     void _setupPlotWidget(void);
     void _setupToolbar(void);
-    void _setupFilelist(void);
+    void _setupFilelist(const QStringList & files);
     void _buildDialog(void);
     void _styling(void);
     void _updateHScroll(void);
+
+    /**
+     * @brief show [x0, x1] on the time axis, and update what depends on the view
+     */
+    void _setViewX(double x0, double x1);
     void _updateTreeData(const MavSystem*const sys);
     void _updateTextInfo(const MavSystem*const sys);
     void _clearScenario(void);
+    void _setScenario(MavlinkScenario*scen);
+    bool _scenarioBusy(const QString & title);
+    void _deleteOrphans(void);
+    void _reclaim(MavlinkScenario*scen);
+    bool _startLive(void);
+    void _stopLive(void);
     const Data*_get_cboDataSel(void);
     QStringList _getFileNames(void);
 
@@ -147,15 +190,16 @@ private:
 
     const MavSystem*_lastsys;
     MavlinkScenario*_analyzer;
-    std::list<MavlinkParser*>*_parsers;
     SystemTableViewModel*_stvm;
     DataTreeViewModel *_dtvm;
+    std::vector<Data*> _searchResults; ///< rows of listSearchData
 
     // for plot
     MavPlot         *d_plot;
     Zoomer          *d_zoomer;
     QwtPlotPicker   *d_picker;
     Panner          *d_panner;
+    MavPlotOverview *d_overview;
 
     // for A-B marker & data cursor
     bool _markerA;
@@ -175,6 +219,27 @@ private:
     // for database
 	QStandardItemModel *_DBResultModel;
     DBConnector::db_props_t _dbprops;
+    DBWorker*_dbworker;                     ///< loads and saves in the background
+    std::list<MavlinkScenario*> _orphans;   ///< replaced scenarios which were still being saved
+    TaskGroup _reclaimer;                   ///< deletes replaced scenarios in the background, one at a time
+    std::vector<Data*> _previews;           ///< data of the scenario which was loaded as overview from the DB
+
+    // for memory, see MavlinkScenario::set_memory_budget(). Used if not given on command line
+    unsigned long _mem_budget_mb;
+    std::string _scratch_dir;
+    std::string _time_jumps; ///< policy from the settings, see CmdlineArgs::parse_jumps()
+    MavPlotRenderer::raster_e _export_raster; ///< for print and export, from the settings
+    unsigned int _export_dpi; ///< of the image, see MavPlotRenderer
+    QStringList _expressions; ///< derived series from the settings, see Expression. Used if none on command line
+    QString _lastSearch; ///< see on_buttonSearchData_clicked()
+
+    QLabel*_prescanView; ///< in the file dialog of _askLogFiles(), while it is open
+
+    // for live telemetry
+    LiveSource*  _live;
+    QTimer*      _liveTimer;     ///< shows what arrived, while live
+    unsigned int _liveStructure; ///< MavlinkScenario::get_structure_version() the views show
+    bool         _liveBgRender;  ///< plot setting from before; it is off while live
 };
 
 #endif // MAINWINDOW_H
@@ -21,34 +21,267 @@
     
  */
 
+#include <string.h>
+#include <sstream>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <QElapsedTimer>
 #include "mavlinkparser.h"
+#include "profiler.h"
+#include "filefun.h"
 
-MavlinkParser::MavlinkParser(std::string filename) : _fp(NULL), _filename(filename), _n_msg(0) {
+#define TLOG_TIME_MIN_USEC 946684800000000ULL  ///< 2000-01-01. Time stamps of a tlog must be after...
+#define TLOG_TIME_MAX_USEC 4102444800000000ULL ///< ...and before 2100-01-01
+
+static QMutex         channel_mutex;
+static QWaitCondition channel_freed;
+static bool           channel_used[MAVLINK_COMM_NUM_BUFFERS] = {false};
+
+MavlinkParser::MavlinkParser(std::string filename) : _fp(NULL), _filename(filename), _chan(-1), _buf_pos(0), _buf_len(0),
+    _buf_base(0), _msg_start(0), _filter(NULL), _n_msg(0), _n_skipped(0), _follow(false),
+    _at_end(false), _starved(false), _profile(Profiler::Instance().is_enabled()), _read_bytes(0), _read_nsec(0) {
+    memset(&_r_mavlink_status, 0, sizeof(_r_mavlink_status));
     valid = _file_open();
+    // the channel is taken by the first get_next_msg(), so that parsers which wait for their turn do not hold one
 }
 
 MavlinkParser::~MavlinkParser() {
+    _release_channel(_chan);
     if (_fp) {
         fclose(_fp);
         valid = false;
     }
 }
 
+/**
+ * @brief get a MavLink channel which no other parser is using
+ * @param wait_msec how long to wait for one to become free. 0=do not wait
+ * @return channel number, or -1 if none got free in time
+ */
+int MavlinkParser::_acquire_channel(unsigned long wait_msec) {
+    QMutexLocker lock(&channel_mutex);
+    QElapsedTimer waited;
+    waited.start();
+    for (;;) {
+        for (int c = 0; c < MAVLINK_COMM_NUM_BUFFERS; c++) {
+            if (!channel_used[c]) {
+                channel_used[c] = true;
+                // start from scratch; the previous user might have left in the middle of a message
+                memset(mavlink_get_channel_status(c), 0, sizeof(mavlink_status_t));
+                return c;
+            }
+        }
+        const qint64 left = (qint64) wait_msec - waited.elapsed();
+        if (left <= 0 || !channel_freed.wait(&channel_mutex, (unsigned long) left)) return -1;
+    }
+}
+
+unsigned int MavlinkParser::get_num_free_channels(void) {
+    QMutexLocker lock(&channel_mutex);
+    unsigned int n = 0;
+    for (int c = 0; c < MAVLINK_COMM_NUM_BUFFERS; c++) {
+        if (!channel_used[c]) n++;
+    }
+    return n;
+}
+
+bool MavlinkParser::claim_channel(unsigned long wait_msec) {
+    if (_chan < 0 && !_at_end) _chan = _acquire_channel(wait_msec);
+    _starved = (_chan < 0 && !_at_end);
+    return !_starved;
+}
+
+void MavlinkParser::_release_channel(int chan) {
+    if (chan < 0) return;
+    QMutexLocker lock(&channel_mutex);
+    channel_used[chan] = false;
+    channel_freed.wakeOne();
+}
+
 bool MavlinkParser::get_next_msg(mavlink_message_t &buf) {
     if (!valid) return false;    
 
-    // read byte by byte and ask whether it can be parsed...    
-    uint8_t bytebuf;
-    int chan=0;
-    while(fread(&bytebuf, 1, 1, _fp) > 0) { // argh...inefficient
-        if (mavlink_parse_char(chan, bytebuf, &buf, &_r_mavlink_status)) {
-            _n_msg++;
-            return true;
+    if (_at_end) return false;
+    if (_chan < 0 && !claim_channel(MAVLINKPARSER_CHANNEL_WAIT_MSEC)) return false;
+
+    // feed the parser byte by byte from the block buffer and ask whether it can be parsed...
+    const mavlink_status_t*const chan_status = mavlink_get_channel_status(_chan);
+    for (;;) {
+        if (_buf_pos >= _buf_len && !_fill_buffer()) break;
+        while (_buf_pos < _buf_len) {
+            if (_filter && _buf[_buf_pos] == MAVLINK_STX && _try_skip()) continue;
+            const uint8_t bytebuf = _buf[_buf_pos++];
+            if (mavlink_parse_char(_chan, bytebuf, &buf, &_r_mavlink_status)) {
+                _n_msg++;
+                return true;
+            }
+            if (bytebuf == MAVLINK_STX && chan_status->parse_state == MAVLINK_PARSE_STATE_GOT_STX) {
+                _msg_start = _buf_base + _buf_pos - 1; // parser (re)started a frame here
+            }
         }
     }
+    if (_follow) return false; // more may come, keep the channel and its state
+
+    // end of file: hand channel to other parsers
+    _release_channel(_chan);
+    _chan = -1;
+    _at_end = true;
     return false; // nothing found
 }
 
+void MavlinkParser::set_filter(const TopicFilter*filter) {
+    _filter = (filter && filter->is_active()) ? filter : NULL;
+    _selected.clear();
+}
+
+/**
+ * @brief ask the filter about the name of this message id. The answer is cached.
+ */
+bool MavlinkParser::_is_selected(unsigned int msgid) {
+    if (msgid >= _selected.size()) {
+        _selected.resize(msgid + 1, 0);
+    }
+    if (0 == _selected[msgid]) {
+        bool sel = true;
+#if defined(MAVLINK_MESSAGE_INFO) && !defined(MAVLINK_STX_MAVLINK1)
+        static const mavlink_message_info_t info[256] = MAVLINK_MESSAGE_INFO;
+        if (msgid < 256 && info[msgid].name) {
+            sel = _filter->accepts_topic(info[msgid].name);
+        }
+#endif
+        _selected[msgid] = sel ? 1 : 2;
+    }
+    return 1 == _selected[msgid];
+}
+
+/**
+ * @brief _buf_pos is at a start sign. If the parser is idle and this is the header of an
+ * unselected message which is completely in the buffer, jump over it.
+ * To not mistake data for a header, the next message must start right behind it
+ * (raw stream) or after the 8-byte timestamp (tlog).
+ * @return true if skipped
+ */
+bool MavlinkParser::_try_skip(void) {
+#if defined(MAVLINK_STX_MAVLINK1)
+    return false; // FIXME: MavLink 2 frames have another header
+#else
+    mavlink_status_t*const st = mavlink_get_channel_status(_chan);
+    if (st->parse_state != MAVLINK_PARSE_STATE_IDLE && st->parse_state != MAVLINK_PARSE_STATE_UNINIT) return false;
+
+    const size_t HEADER = 6; // stx, len, seq, sysid, compid, msgid
+    if (_buf_pos + HEADER > _buf_len) return false;
+    const size_t framelen = _buf[_buf_pos + 1] + MAVLINK_NUM_NON_PAYLOAD_BYTES;
+    const unsigned int msgid = _buf[_buf_pos + 5];
+    if (_is_selected(msgid)) return false;
+
+    const size_t next = _buf_pos + framelen;
+    const size_t TLOG_TIMESTAMP = 8;
+    bool plausible;
+    if (next == _buf_len) {
+        plausible = feof(_fp); // last one
+    } else if (next + TLOG_TIMESTAMP < _buf_len) {
+        plausible = (_buf[next] == MAVLINK_STX || _buf[next + TLOG_TIMESTAMP] == MAVLINK_STX);
+    } else {
+        plausible = false; // let the parser do it
+    }
+    if (!plausible) return false;
+
+    // the parser never sees this frame. Tell it the sequence number, else it counts a drop
+    st->current_rx_seq = (uint8_t) (_buf[_buf_pos + 2] + 1);
+    _r_mavlink_status.current_rx_seq = st->current_rx_seq;
+    _buf_pos = next;
+    _n_skipped++;
+    return true;
+#endif
+}
+
+/**
+ * @brief reads the next block of the file into _buf. Parser state is kept
+ * in _r_mavlink_status, therefore messages spanning two blocks are no problem.
+ * @return false if there is nothing more to read
+ */
+bool MavlinkParser::_fill_buffer() {
+    _buf_base += _buf_len;
+    _buf_pos = 0;
+    if (_follow) clearerr(_fp); // end of file is not sticky then
+    if (_profile) {
+        const unsigned long long t0 = Profiler::now_nsec();
+        _buf_len = fread(_buf, 1, sizeof(_buf), _fp);
+        _read_nsec += Profiler::now_nsec() - t0;
+    } else {
+        _buf_len = fread(_buf, 1, sizeof(_buf), _fp);
+    }
+    _read_bytes += _buf_len;
+    return _buf_len > 0;
+}
+
+bool MavlinkParser::seek(uint64_t offset) {
+    if (!valid) return false;
+    if (!fileSeek(_fp, offset)) return false;
+    _buf_base = offset;
+    _buf_pos = 0;
+    _buf_len = 0;
+    _msg_start = offset;
+    // a frame begun before does not continue here
+    if (_chan >= 0) memset(mavlink_get_channel_status(_chan), 0, sizeof(mavlink_status_t));
+    memset(&_r_mavlink_status, 0, sizeof(_r_mavlink_status));
+    return true;
+}
+
+std::string MavlinkParser::get_msg_name(unsigned int msgid) {
+#if defined(MAVLINK_MESSAGE_INFO) && !defined(MAVLINK_STX_MAVLINK1)
+    static const mavlink_message_info_t info[256] = MAVLINK_MESSAGE_INFO;
+    if (msgid < 256 && info[msgid].name) return info[msgid].name;
+#endif
+    std::stringstream ss;
+    ss << "#" << msgid;
+    return ss.str();
+}
+
+/**
+ * @brief a tlog has the time of reception (usec since 1970, big endian) in front of each frame
+ * @return false if it is not in the buffer, or not plausible
+ */
+bool MavlinkParser::_get_tlog_time(uint64_t & usec) const {
+    if (_msg_start < _buf_base + 8 || _msg_start > _buf_base + _buf_len) return false;
+    const uint8_t*p = &_buf[_msg_start - _buf_base - 8];
+    usec = 0;
+    for (unsigned int k = 0; k < 8; ++k) {
+        usec = (usec << 8) | p[k];
+    }
+    return usec > TLOG_TIME_MIN_USEC && usec < TLOG_TIME_MAX_USEC;
+}
+
+bool MavlinkParser::prescan(LogPrescan & info) {
+    // only a preview, rather none than waiting for the imports to give back a channel
+    if (!valid || !claim_channel(0)) return false;
+    info.parser = "mavlink";
+    info.time_epoch = true;
+
+    mavlink_message_t msg;
+    for (unsigned int k = 0; k <= PRESCAN_SAMPLES; ++k) {
+        unsigned int limit = PRESCAN_SAMPLE_MESSAGES;
+        if (0 == k) {
+            limit = PRESCAN_HEAD_MESSAGES;
+        } else {
+            uint64_t offset = info.filesize * k / (PRESCAN_SAMPLES + 1);
+            if (k == PRESCAN_SAMPLES) {
+                offset = (info.filesize > PRESCAN_TAIL_BYTES) ? info.filesize - PRESCAN_TAIL_BYTES : 0;
+                limit = (unsigned int) -1;
+            }
+            if (_at_end || !seek(offset)) break; // end of file was reached already
+        }
+        for (unsigned int n = 0; n < limit && get_next_msg(msg); ++n) {
+            info.add_message(get_msg_name(msg.msgid));
+            info.systems.insert(msg.sysid);
+            uint64_t t;
+            if (_get_tlog_time(t)) info.add_time(t);
+        }
+    }
+    return true;
+}
+
 const mavlink_status_t * MavlinkParser::get_linkstats() const {
     return &_r_mavlink_status;
 }
@@ -27,8 +27,13 @@
 #include <stdio.h>
 #include <inttypes.h>
 #include <string>
+#include <vector>
 #include "mavlink.h" // generated by mavgenerate.py from https://github.com/mavlink/mavlink.git
+#include "topicfilter.h"
+#include "logprescan.h"
 
+#define MAVLINKPARSER_BUFLEN (64*1024) ///< read block size for tlog files
+#define MAVLINKPARSER_CHANNEL_WAIT_MSEC 60000 ///< how long get_next_msg() waits for a free MavLink channel
 
 class MavlinkParser {
 public:
@@ -38,13 +43,92 @@ public:
     const mavlink_status_t* get_linkstats(void) const;
     const std::string& get_filename(void) const;
 
+    /**
+     * @brief start reading at this file position instead of the beginning. The parser
+     * resynchronizes on the next start sign whose frame has a valid checksum.
+     * A message read halfway is dropped, and the link statistics start over.
+     * @return false if position cannot be reached
+     */
+    bool seek(uint64_t offset);
+
+    /**
+     * @return file position where the message from the last get_next_msg() starts
+     */
+    uint64_t get_msg_offset(void) const { return _msg_start; }
+
+    /**
+     * @brief sample messages at a few places for the message mix, systems and time span.
+     * Use instead of get_next_msg(); the parser cannot be used for more afterwards.
+     * @param info filled. info.filesize must be set.
+     * @return false if the file cannot be read
+     */
+    bool prescan(LogPrescan & info);
+
+    /**
+     * @return name of the message, e.g. "ATTITUDE", or "#<msgid>" if unknown
+     */
+    static std::string get_msg_name(unsigned int msgid);
+
+    /**
+     * @brief only return messages selected by filter. The others are jumped over
+     * using the length in their header, without running the parser over them.
+     * @param filter NULL=everything. Must outlive the parser.
+     */
+    void set_filter(const TopicFilter*filter);
+
+    /**
+     * @brief for files which are still being written: at the end, get_next_msg() returns
+     * false but keeps its position and the state of a message which is only partly there.
+     * The next call reads what was appended meanwhile.
+     */
+    void set_follow(bool yes) { _follow = yes; }
+
+    /**
+     * @brief take a MavLink channel now instead of in the first get_next_msg(). It is
+     * given back at the end of the file, or when the parser is destroyed.
+     * @param wait_msec how long to wait if all are in use. 0=do not wait
+     * @return false if none got free in time; then is_starved() is true
+     */
+    bool claim_channel(unsigned long wait_msec);
+
+    /**
+     * @brief true if the last get_next_msg() or claim_channel() failed because all
+     * MavLink channels were in use, rather than at the end of the file
+     */
+    bool is_starved(void) const { return _starved; }
+
+    /**
+     * @brief number of MavLink channels no parser is using right now. Only a hint,
+     * since others might take them any time.
+     */
+    static unsigned int get_num_free_channels(void);
+
+    /**
+     * @brief number of messages that were not selected by the filter
+     */
+    unsigned int get_num_skipped(void) const { return _n_skipped; }
+
+    /**
+     * @brief bytes read from the file so far, and the time it took if the Profiler is enabled
+     */
+    uint64_t get_read_bytes(void) const { return _read_bytes; }
+    unsigned long long get_read_nsec(void) const { return _read_nsec; }
+
     /****************************************
      *     DATA MEMBERS
      ****************************************/
     bool  valid; //< indicates error
 
 private:
+    friend class LiveSource; // shares the channels
+
     bool _file_open(void);
+    bool _fill_buffer(void);
+    static int _acquire_channel(unsigned long wait_msec);
+    static void _release_channel(int chan);
+    bool _is_selected(unsigned int msgid);
+    bool _try_skip(void);
+    bool _get_tlog_time(uint64_t & usec) const;
 
     /****************************************
      *     DATA MEMBERS
@@ -52,8 +136,25 @@ private:
     // general
     FILE*       _fp;
     std::string _filename;
+    int         _chan; ///< MavLink keeps parser state per channel, so parsers running in parallel need their own
+    // read buffer
+    uint8_t      _buf[MAVLINKPARSER_BUFLEN];
+    size_t       _buf_pos; ///< next unparsed byte in _buf
+    size_t       _buf_len; ///< number of valid bytes in _buf
+    uint64_t     _buf_base; ///< file position of _buf[0]
+    uint64_t     _msg_start; ///< file position of the start sign of the current message
+    // filtering
+    const TopicFilter* _filter;
+    std::vector<char>  _selected; ///< by msgid: 0=not yet known, 1=selected, 2=not selected
     // stats
     unsigned int     _n_msg;
+    unsigned int     _n_skipped;
+    bool             _follow; ///< see set_follow()
+    bool             _at_end; ///< end of file was reached and the channel given back
+    bool             _starved; ///< see is_starved()
+    bool               _profile;
+    uint64_t           _read_bytes;
+    unsigned long long _read_nsec;
     mavlink_status_t _r_mavlink_status;
 };
 
@@ -25,13 +25,23 @@
 #include <iostream>
 #include <inttypes.h>
 #include <stdio.h>
+#include <algorithm>
+#include <QRunnable>
 #include "mavlinkscenario.h"
+#include "spillfile.h"
 #include "logger.h"
+#include "profiler.h"
+#include "mavlinkparser.h"
+#include "expression.h"
+#include "conditionsearch.h"
+#include "taskpool.h"
 
 using namespace std;
 
 MavlinkScenario::MavlinkScenario(const CmdlineArgs *const args) : _args(args), _n_msgs(0), _n_ignored(0),
-    _time_guess_epoch_usec(0), _onboard_sysid(-1), _havedb(false), _dbid(0) {
+    _time_guess_epoch_usec(0), _onboard_sysid(-1), _topic_filter(NULL), _compress_data(args ? args->compress : false),
+    _mem_budget(args ? (size_t)args->mem_budget_mb*1024*1024 : 0), _spill_file(NULL), _havedb(false), _dbid(0) {
+    if (args) _scratch_dir = args->scratch_dir;
 
     _onboard_gps_time.have_last = false;
 
@@ -44,6 +54,7 @@ MavlinkScenario::~MavlinkScenario() {
         if (s) delete s;
     }
     _seen_systems.clear();
+    if (_spill_file) _spill_file->unref(); // removed when no data lives in there anymore
     Logger::Instance().deleteChannel(_logchannel);
 }
 
@@ -71,25 +82,86 @@ void MavlinkScenario::log(logmsgtype_e t, const std::string & str) {
     Logger::Instance().write(t, str, _logchannel);
 }
 
-// FIXME: refactor similar to add_mavlink_message (int return) and make polymorphic
-bool MavlinkScenario::add_onboard_message(const OnboardData &msg) {
+void MavlinkScenario::begin_onboard_log(const std::string & parsername) {
+    _last_onboard_parser = parsername;
+    _onboard_schemas.clear(); // schema ids restart with every parser
+}
 
-    // check for parser id
-    if (msg._msgname_orig == "_parser_name") {
-        const OnboardData::stringdata_t::const_iterator it = msg.get_stringdata().find("_parser_name");
-        if (it == msg.get_stringdata().end()) return true;
-        _last_onboard_parser = it->second;
-        return true;
+void MavlinkScenario::end_onboard_log(void) {
+    _onboard_schemas.clear();
+}
+
+/**
+ * @brief look up which fields of the schema are of interest, and which names the data gets
+ */
+MavlinkScenario::onboard_schema_info_t & MavlinkScenario::_get_onboard_schema_info(const OnboardSchema*schema) {
+    const unsigned int idx = schema->get_id();
+    if (idx >= _onboard_schemas.size()) {
+        onboard_schema_info_t empty;
+        empty.schema = NULL;
+        empty.kind = ONBOARD_GENERIC;
+        empty.id_sysid = empty.id_fix = empty.id_week_ms = empty.id_week = empty.id_time = -1;
+        empty.handles_sys = NULL;
+        _onboard_schemas.resize(idx + 1, empty);
+    }
+    onboard_schema_info_t & info = _onboard_schemas[idx];
+    if (info.schema == schema) return info;
+
+    info.schema = schema;
+    info.kind = ONBOARD_GENERIC;
+    info.id_sysid = info.id_fix = info.id_week_ms = info.id_week = info.id_time = -1;
+    info.handles_sys = NULL;
+    info.handles.clear();
+
+    const std::string & origname = schema->get_message_origname();
+    if (origname == "PARM") {
+        info.kind = ONBOARD_PARM;
+        info.id_sysid = schema->find_field("SYSID_THISMAV", OnboardSchema::FIELD_FLOAT);
+    } else if (origname == "GPS" || origname == "vehicle_gps_position") {
+        info.kind = ONBOARD_GPS;
+        if (_last_onboard_parser == "apm") {
+            info.id_fix = schema->find_field("Status", OnboardSchema::FIELD_UINT);
+            info.id_week_ms = schema->find_field("TimeMS", OnboardSchema::FIELD_UINT);
+            info.id_week = schema->find_field("Week", OnboardSchema::FIELD_UINT);
+        } else if (_last_onboard_parser == "px4") {
+            info.id_fix = schema->find_field("Fix", OnboardSchema::FIELD_UINT);
+            info.id_time = schema->find_field("GPSTime", OnboardSchema::FIELD_UINT);
+        } else if (_last_onboard_parser == "ulg") {
+            info.id_fix = schema->find_field("fix_type", OnboardSchema::FIELD_UINT);
+            info.id_time = schema->find_field("time_utc_usec", OnboardSchema::FIELD_UINT);
+        }
+    } else if (origname == "TIME") {
+        info.kind = ONBOARD_TIME;
+        info.id_time = schema->find_field("StartTime", OnboardSchema::FIELD_UINT);
+    } else {
+        info.id_time = schema->find_field("TimeUS", OnboardSchema::FIELD_UINT);
+        if (info.id_time < 0) info.id_time = schema->find_field("t", OnboardSchema::FIELD_UINT);
+        if (info.id_time < 0) info.id_time = schema->find_field("timestamp", OnboardSchema::FIELD_UINT);
     }
 
+    // timeseries names
+    const std::string stem = "onboard log/" + schema->get_message_name() + "/";
+    info.fullnames.assign(schema->get_num_fields(), std::string());
+    for (unsigned int k=0; k<schema->get_num_fields(); k++) {
+        const OnboardSchema::field_t & f = schema->get_field(k);
+        if (f.name == "t") continue;
+        if (_topic_filter && !_topic_filter->accepts_field(origname, f.name)) continue;
+        info.fullnames[k] = stem + f.name;
+    }
+    return info;
+}
+
+// FIXME: refactor similar to add_mavlink_message (int return) and make polymorphic
+bool MavlinkScenario::add_onboard_message(const OnboardData &msg) {
+
     if (!msg.is_valid()) return true;
 
+    onboard_schema_info_t & info = _get_onboard_schema_info(msg.get_schema());
+
     // find MAV system ID and cache it
-    if (msg.get_message_origname().compare("PARM")==0) {
-        const OnboardData::floatdata_t d = msg.get_floatdata();
-        OnboardData::floatdata_t::const_iterator ir = d.find("SYSID_THISMAV");
-        if (ir != d.end()) {
-            _onboard_sysid = ((int) ir->second);                        
+    if (info.kind == ONBOARD_PARM) {
+        if (msg.is_set(info.id_sysid)) {
+            _onboard_sysid = ((int) msg.get_float(info.id_sysid));
             log(MSG_INFO, stringbuilder() << "Onboard Log: Sysid=" << _onboard_sysid);
         }
     }
@@ -120,9 +192,7 @@ bool MavlinkScenario::add_onboard_message(const OnboardData &msg) {
     /****************************
      *  ABSOLUTE TIMESTAMPS
      ****************************/
-    if (msg.get_message_origname().compare("GPS")==0 ||
-        msg.get_message_origname().compare("vehicle_gps_position")==0) {
-        const OnboardData::uintdata_t d = msg.get_uintdata();                
+    if (info.kind == ONBOARD_GPS) {
         /**
          * Get GPS time and use it as time reference. Unfortunately
          * gps_week_ms can have huge jumps. Namely, this happens when the GPS gots from no fix to fix.
@@ -133,24 +203,14 @@ bool MavlinkScenario::add_onboard_message(const OnboardData &msg) {
         bool valid = true;
         uint16_t gps_week;
         uint32_t gps_week_ms;
-        OnboardData::uintdata_t::const_iterator ir;
 
         // check if we have a fix
         bool has_gps_fix = false;
         {
-            std::string field_fix;
-            if (_last_onboard_parser == "apm") {
-                field_fix = "Status";
-            } else if (_last_onboard_parser == "px4") {
-                field_fix = "Fix";
-            } else if (_last_onboard_parser == "ulg") {
-                field_fix = "fix_type";
-            }
-            ir = d.find(field_fix);
-            if (ir == d.end()) {
+            if (!msg.is_set(info.id_fix)) {
                 valid = false;
             } else {
-                unsigned int gpsfix = ir->second;
+                unsigned int gpsfix = msg.get_uint(info.id_fix);
                 const unsigned int GPS_HAS_FIX_CONSTANT = 2; // true for all known parsers so far
                 has_gps_fix = (gpsfix >= GPS_HAS_FIX_CONSTANT);
             }
@@ -163,15 +223,13 @@ bool MavlinkScenario::add_onboard_message(const OnboardData &msg) {
                 /**************************
                  * APM time reference
                  **************************/
-                ir = d.find("TimeMS");
-                valid = valid && (ir != d.end());
+                valid = valid && msg.is_set(info.id_week_ms);
                 if (valid) {
-                    gps_week_ms = ir->second;
+                    gps_week_ms = msg.get_uint(info.id_week_ms);
                 }
-                ir = d.find("Week");
-                valid = valid && (ir != d.end());
+                valid = valid && msg.is_set(info.id_week);
                 if (valid) {
-                    gps_week = ir->second;
+                    gps_week = msg.get_uint(info.id_week);
                 }
                 if (valid) {
                     if (_onboard_gps_time.have_last) {
@@ -198,15 +256,10 @@ bool MavlinkScenario::add_onboard_message(const OnboardData &msg) {
                 /******************************
                  * PX4 and ULOG time reference
                  ******************************/
-                if (_last_onboard_parser == "px4") {
-                    ir = d.find("GPSTime");
-                } else {
-                    ir = d.find("time_utc_usec");
-                }
-                valid = valid && (ir != d.end());
+                valid = valid && msg.is_set(info.id_time);
 
                 if (valid) {
-                    uint64_t gps_time_usec = ir->second; // microseconds UTC time
+                    uint64_t gps_time_usec = msg.get_uint(info.id_time); // microseconds UTC time
                     uint64_t reltime_us = 0;
                     if (_onboard_gps_time.have_last) {
                         // update rel. time based on the time lapsed since last GPS message
@@ -232,13 +285,11 @@ bool MavlinkScenario::add_onboard_message(const OnboardData &msg) {
             }
         }
 
-    } else if (msg.get_message_origname().compare("TIME")==0) {
+    } else if (info.kind == ONBOARD_TIME) {
         // PX4: uint64_t hrt_absolute_time
-        const OnboardData::uintdata_t d = msg.get_uintdata();
-        OnboardData::uintdata_t::const_iterator ir = d.find("StartTime");
-        bool valid = ir != d.end();
+        bool valid = msg.is_set(info.id_time);
         if (valid) {
-            uint64_t gps_time_usec = ir->second; // microseconds UTC time
+            uint64_t gps_time_usec = msg.get_uint(info.id_time); // microseconds UTC time
             uint64_t reltime_us = 0;
             if (_onboard_time_time.have_last) {
                 // update rel. time based on the time lapsed since last GPS message
@@ -256,15 +307,8 @@ bool MavlinkScenario::add_onboard_message(const OnboardData &msg) {
         }      
     } else {
         //cout << "generic onboard message: " <<  msg.get_message_origname() << endl;
-        const OnboardData::uintdata_t d = msg.get_uintdata();
-        OnboardData::uintdata_t::const_iterator ir;
-        ir = d.find("TimeUS"); if (ir != d.end()) goto stopsearch;
-        ir = d.find("t"); if (ir != d.end()) goto stopsearch;
-        ir = d.find("timestamp"); if (ir != d.end()) goto stopsearch;
-
-stopsearch:
-        if (ir != d.end()) {
-            uint64_t tnow = ir->second;
+        if (msg.is_set(info.id_time)) {
+            uint64_t tnow = msg.get_uint(info.id_time);
             if (sys->is_absolute_time(tnow)) {
                 sys->update_time_offset(sys->get_rel_time(), tnow);
             } else {
@@ -284,830 +328,925 @@ stopsearch:
      *  RELATIVE TIMESTAMPS
      ****************************/    
 
-    // timeseries
-    const std::string stem = "onboard log/" + msg.get_message_name() + "/";
-    const std::size_t stem_len = stem.size();
-
-    /*
-     * Full name will consist of two parts:
-     * - The stem as created above - which is the same through the rest of the function
-     * - The data name that will be appended and which might be differen for each data sample
-     *
-     * => For performance reasons the same string variable will be reused to avoid repeated memeory allocations
-     */
-    std::string fullname = stem;
-    for (OnboardData::booldata_t::const_iterator dit = msg.get_booldata().begin(); dit != msg.get_booldata().end(); ++dit) {
-        if (dit->first == "t") continue;
-        fullname.erase(stem_len); //trim down to stem
-        fullname.append(dit->first); //append name of data sample
-        DataTimed *series = sys->track_generic_timeseries<bool>(fullname, dit->second);
-        if (untimed_message) { series->set_has_bad_timestamps(); }
-    }
-    for (OnboardData::intdata_t::const_iterator dit = msg.get_intdata().begin(); dit != msg.get_intdata().end(); ++dit) {
-        if (dit->first == "t") continue;
-        fullname.erase(stem_len); //trim down to stem
-        fullname.append(dit->first); //append name of data sample
-        DataTimed *series = sys->track_generic_timeseries<int>(fullname, dit->second);
-        if (untimed_message) { series->set_has_bad_timestamps(); }
-    }
-    for (OnboardData::uintdata_t::const_iterator dit = msg.get_uintdata().begin(); dit != msg.get_uintdata().end(); ++dit) {
-        if (dit->first == "t") continue;
-        fullname.erase(stem_len); //trim down to stem
-        fullname.append(dit->first); //append name of data sample
-        DataTimed *series = sys->track_generic_timeseries<unsigned int>(fullname, dit->second);
-        if (untimed_message) { series->set_has_bad_timestamps(); }
-    }
-    for (OnboardData::floatdata_t::const_iterator dit = msg.get_floatdata().begin(); dit != msg.get_floatdata().end(); ++dit) {
-        if (dit->first == "t") continue;
-        fullname.erase(stem_len); //trim down to stem
-        fullname.append(dit->first); //append name of data sample
-        DataTimed *series = sys->track_generic_timeseries<float>(fullname, dit->second);
-        if (untimed_message) { series->set_has_bad_timestamps(); }
-    }
-    // events
-    for (OnboardData::stringdata_t::const_iterator dit = msg.get_stringdata().begin(); dit != msg.get_stringdata().end(); ++dit) {
-        if (dit->first == "t") continue;
-        fullname.erase(stem_len); //trim down to stem
-        fullname.append(dit->first); //append name of data sample
-        sys->track_generic_event<std::string>(fullname, dit->second);        
+    // timeseries and events. Names were built once per schema, data is looked up once per system.
+    if (info.handles_sys != sys) {
+        info.handles.assign(info.fullnames.size(), NULL);
+        info.handles_sys = sys;
+    }
+    const OnboardSchema*const schema = info.schema;
+    for (unsigned int k=0; k<msg.get_num_set(); k++) {
+        DataTimed*& handle = info.handles[k];
+        if (!handle) {
+            // first sample of this field
+            const std::string & fullname = info.fullnames[k];
+            if (fullname.empty()) continue;
+            switch (schema->get_field(k).kind) {
+            case OnboardSchema::FIELD_BOOL:
+                handle = sys->track_generic_timeseries<bool>(fullname, msg.get_bool(k));
+                break;
+            case OnboardSchema::FIELD_INT:
+                handle = sys->track_generic_timeseries<int>(fullname, msg.get_int(k));
+                break;
+            case OnboardSchema::FIELD_UINT:
+                handle = sys->track_generic_timeseries<unsigned int>(fullname, msg.get_uint(k));
+                break;
+            case OnboardSchema::FIELD_FLOAT:
+                handle = sys->track_generic_timeseries<float>(fullname, msg.get_float(k));
+                break;
+            case OnboardSchema::FIELD_STRING:
+                handle = sys->track_generic_event<std::string>(fullname, msg.get_string(k));
+                break;
+            }
+            // all fields of a message get the same time stamps, so store them once
+            for (unsigned int j=0; handle && schema->get_field(k).kind != OnboardSchema::FIELD_STRING && j<info.handles.size(); j++) {
+                DataTimed*const anchor = info.handles[j];
+                if (j != k && anchor && schema->get_field(j).kind != OnboardSchema::FIELD_STRING) {
+                    handle->share_time_column(anchor);
+                    break;
+                }
+            }
+        } else {
+            // the kind of a field never changes, hence the cast is safe
+            switch (schema->get_field(k).kind) {
+            case OnboardSchema::FIELD_BOOL:
+                sys->track_generic_timeseries(static_cast<DataTimeseries<bool>*>(handle), msg.get_bool(k));
+                break;
+            case OnboardSchema::FIELD_INT:
+                sys->track_generic_timeseries(static_cast<DataTimeseries<int>*>(handle), (int) msg.get_int(k));
+                break;
+            case OnboardSchema::FIELD_UINT:
+                sys->track_generic_timeseries(static_cast<DataTimeseries<unsigned int>*>(handle), (unsigned int) msg.get_uint(k));
+                break;
+            case OnboardSchema::FIELD_FLOAT:
+                sys->track_generic_timeseries(static_cast<DataTimeseries<float>*>(handle), (float) msg.get_float(k));
+                break;
+            case OnboardSchema::FIELD_STRING:
+                sys->track_generic_event(static_cast<DataEvent<std::string>*>(handle), msg.get_string(k));
+                break;
+            }
+        }
+        if (handle && untimed_message && schema->get_field(k).kind != OnboardSchema::FIELD_STRING) {
+            handle->set_has_bad_timestamps();
+        }
     }
 
     return true;
 }
 
-int MavlinkScenario::add_mavlink_message(const mavlink_message_t &msg, bool allow_time_jumps) {
-    /**********************************************************
-     * This is a gateway function. It translates Mavlink to
-     * internal formats and forwards the data for processing
-     * to the individual systems. For a description of the in-
-     * dividual packets see https://pixhawk.ethz.ch/mavlink/
-     **********************************************************/
-    int ret = 0;
-
-    /****************************
-     *  ADD/FIND SYSTEM
-     ****************************/
-    MavSystem* const sys = _get_or_add_system_byid(msg.sysid);    
-    if (!sys) return 0; // ignore; internal error because we could neither find nor add system
+bool MavlinkScenario::add_onboard_batch(const OnboardBatch & batch) {
+    const unsigned int n = batch.size();
+    if (0 == n) return true;
+
+    // the first row creates the series and possibly the system. Messages which set the
+    // time basis or the system id are looked at row by row.
+    batch.get_row(0, _onboard_row);
+    bool ret = add_onboard_message(_onboard_row);
+    onboard_schema_info_t & info = _get_onboard_schema_info(batch.get_schema());
+    if (info.kind != ONBOARD_GENERIC || !info.handles_sys || 1 == n) {
+        for (unsigned int r=1; r<n; r++) {
+            batch.get_row(r, _onboard_row);
+            ret = add_onboard_message(_onboard_row) && ret;
+        }
+        return ret;
+    }
+    MavSystem*const sys = _get_or_add_system_byid((uint8_t)_onboard_sysid);
+    if (sys != info.handles_sys) return ret;
+
+    // time stamps, same as add_onboard_message() does per message
+    _onboard_times.resize(n);
+    if (info.id_time >= 0) {
+        const std::vector<uint64_t> & tcol = batch.get_column(info.id_time).u;
+        for (unsigned int r=1; r<n; r++) {
+            const uint64_t tnow = tcol[r];
+            if (sys->is_absolute_time(tnow)) {
+                sys->update_time_offset(sys->get_rel_time(), tnow);
+            } else {
+                sys->update_rel_time(tnow, true);
+            }
+            _onboard_times[r] = sys->get_time();
+        }
+    } else {
+        // untimed: all at the current time. add_onboard_message() has flagged the series
+        for (unsigned int r=1; r<n; r++) _onboard_times[r] = sys->get_time();
+    }
 
-    // FIXME: messages have no timestamps in their header...we need to be creative here
-    uint64_t nowtime_us = sys->get_rel_time() + 1; // to preserve order when no time is given  FIXME: estimate from link rate?
-    sys->update_rel_time(nowtime_us, allow_time_jumps); // if someone knows better below, it can update just again
+    // all fields are set in every row; the first row is done already
+    const OnboardSchema*const schema = info.schema;
+    const double*const times = &_onboard_times[1];
+    for (unsigned int k=0; k<schema->get_num_fields() && k<info.handles.size(); k++) {
+        DataTimed*const handle = info.handles[k];
+        if (!handle) continue;
+        const OnboardBatch::column_t & col = batch.get_column(k);
+        // the kind of a field never changes, hence the cast is safe
+        switch (schema->get_field(k).kind) {
+        case OnboardSchema::FIELD_BOOL:
+            sys->track_generic_timeseries(static_cast<DataTimeseries<bool>*>(handle), &col.u[1], times, n - 1);
+            break;
+        case OnboardSchema::FIELD_INT:
+            sys->track_generic_timeseries(static_cast<DataTimeseries<int>*>(handle), &col.i[1], times, n - 1);
+            break;
+        case OnboardSchema::FIELD_UINT:
+            sys->track_generic_timeseries(static_cast<DataTimeseries<unsigned int>*>(handle), &col.u[1], times, n - 1);
+            break;
+        case OnboardSchema::FIELD_FLOAT:
+            sys->track_generic_timeseries(static_cast<DataTimeseries<float>*>(handle), &col.f[1], times, n - 1);
+            break;
+        case OnboardSchema::FIELD_STRING:
+            sys->track_generic_event(static_cast<DataEvent<std::string>*>(handle), &col.s[1], times, n - 1);
+            break;
+        }
+    }
+    return ret;
+}
 
-    // that is a boundary that helps analyzing
-    sys->nextmsg();
+/*********************************************************
+ * MavLink handlers. Each one translates one message type
+ * to internal formats and forwards the data to the system.
+ * For a description of the individual packets see
+ * https://pixhawk.ethz.ch/mavlink/
+ *********************************************************/
 
-    // translate and forward begins here
-    bool ignored = false;
-    switch (msg.msgid) {
-    case MAVLINK_MSG_ID_HEARTBEAT: // #0
-    {
-        uint8_t stype = mavlink_msg_heartbeat_get_type(&msg);
-        uint8_t status = mavlink_msg_heartbeat_get_system_status(&msg);
-        uint8_t basemode = mavlink_msg_heartbeat_get_base_mode(&msg);
-        uint8_t custmode = mavlink_msg_heartbeat_get_base_mode(&msg);
-        uint8_t autopilot = mavlink_msg_heartbeat_get_autopilot(&msg);
+/**
+ * @brief signature of all handlers
+ * @param nowtime_us time of the message since boot, as far as known. Handlers may set it.
+ * @param ret handlers set it to what update_rel_time() said, if that refused the time
+ */
+typedef void (*mavlink_handler_f)(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret);
 
-        // --
-        sys->track_system(stype, status, autopilot, basemode, custmode);
-    }
-        break;
+static void handle_heartbeat(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #0
+    uint8_t stype = mavlink_msg_heartbeat_get_type(&msg);
+    uint8_t status = mavlink_msg_heartbeat_get_system_status(&msg);
+    uint8_t basemode = mavlink_msg_heartbeat_get_base_mode(&msg);
+    uint8_t custmode = mavlink_msg_heartbeat_get_base_mode(&msg);
+    uint8_t autopilot = mavlink_msg_heartbeat_get_autopilot(&msg);
 
-    case MAVLINK_MSG_ID_SYS_STATUS: // #1
-    {
-        uint16_t bat_voltage_mV = mavlink_msg_sys_status_get_voltage_battery(&msg);
-        uint16_t bat_current_10mA = mavlink_msg_sys_status_get_current_battery(&msg);
-        uint16_t load_promille =  mavlink_msg_sys_status_get_load(&msg);
-        uint16_t drop_rate_comm = mavlink_msg_sys_status_get_drop_rate_comm(&msg);
-        uint32_t enabled= mavlink_msg_sys_status_get_onboard_control_sensors_enabled(&msg);
-        uint32_t present = mavlink_msg_sys_status_get_onboard_control_sensors_present(&msg);
-        uint32_t health = mavlink_msg_sys_status_get_onboard_control_sensors_health(&msg);
-        uint16_t errors_count[4];
-        errors_count[0] = mavlink_msg_sys_status_get_errors_count1(&msg);
-        errors_count[1] = mavlink_msg_sys_status_get_errors_count2(&msg);
-        errors_count[2] = mavlink_msg_sys_status_get_errors_count3(&msg);
-        errors_count[3] = mavlink_msg_sys_status_get_errors_count4(&msg);
-        // --
-        sys->track_sysperf(load_promille/10.f, bat_voltage_mV/1000.f, bat_current_10mA/100.f);
-        sys->track_radio_droprate(drop_rate_comm/10.);
-        sys->track_system_sensors(present, enabled, health);
-        sys->track_system_errors(errors_count);
-    }
-        break;
+    // --
+    sys->track_system(stype, status, autopilot, basemode, custmode);
+}
 
-    case MAVLINK_MSG_ID_SYSTEM_TIME: // #2
-    {
-        uint64_t time_unix_usec = mavlink_msg_system_time_get_time_unix_usec(&msg);
-        uint32_t time_boot_ms = mavlink_msg_system_time_get_time_boot_ms(&msg);
-        nowtime_us = time_boot_ms * 1000;        
-        sys->update_time_offset(nowtime_us, time_unix_usec, allow_time_jumps); // OK -- here we establish a reference between boot time and /absolute time
-    }
-        break;
+static void handle_sys_status(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #1
+    uint16_t bat_voltage_mV = mavlink_msg_sys_status_get_voltage_battery(&msg);
+    uint16_t bat_current_10mA = mavlink_msg_sys_status_get_current_battery(&msg);
+    uint16_t load_promille =  mavlink_msg_sys_status_get_load(&msg);
+    uint16_t drop_rate_comm = mavlink_msg_sys_status_get_drop_rate_comm(&msg);
+    uint32_t enabled= mavlink_msg_sys_status_get_onboard_control_sensors_enabled(&msg);
+    uint32_t present = mavlink_msg_sys_status_get_onboard_control_sensors_present(&msg);
+    uint32_t health = mavlink_msg_sys_status_get_onboard_control_sensors_health(&msg);
+    uint16_t errors_count[4];
+    errors_count[0] = mavlink_msg_sys_status_get_errors_count1(&msg);
+    errors_count[1] = mavlink_msg_sys_status_get_errors_count2(&msg);
+    errors_count[2] = mavlink_msg_sys_status_get_errors_count3(&msg);
+    errors_count[3] = mavlink_msg_sys_status_get_errors_count4(&msg);
+    // --
+    sys->track_sysperf(load_promille/10.f, bat_voltage_mV/1000.f, bat_current_10mA/100.f);
+    sys->track_radio_droprate(drop_rate_comm/10.);
+    sys->track_system_sensors(present, enabled, health);
+    sys->track_system_errors(errors_count);
+}
 
-    case MAVLINK_MSG_ID_SET_MODE: // #11
-    {
-        const string fullname = "mission/set mode/";
-        unsigned int target = mavlink_msg_set_mode_get_target_system(&msg);
-        unsigned int base = mavlink_msg_set_mode_get_base_mode(&msg);
-        unsigned int custom = mavlink_msg_set_mode_get_custom_mode(&msg);
-        sys->track_generic_timeseries<unsigned int>(fullname + "target", target);
-        sys->track_generic_timeseries<unsigned int>(fullname + "base", base);
-        sys->track_generic_timeseries<unsigned int>(fullname + "custom", custom);
-    }
-        break;
+static void handle_system_time(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #2
+    uint64_t time_unix_usec = mavlink_msg_system_time_get_time_unix_usec(&msg);
+    uint32_t time_boot_ms = mavlink_msg_system_time_get_time_boot_ms(&msg);
+    nowtime_us = time_boot_ms * 1000;        
+    sys->update_time_offset(nowtime_us, time_unix_usec, allow_time_jumps); // OK -- here we establish a reference between boot time and /absolute time
+}
 
-    case MAVLINK_MSG_ID_PARAM_REQUEST_READ: // #20
-    {
-        const string fullname = "param/request_read/";
-        unsigned int system = mavlink_msg_param_request_read_get_target_system(&msg);
-        unsigned int component = mavlink_msg_param_request_read_get_target_component(&msg);
-        int pidx = mavlink_msg_param_request_read_get_param_index(&msg);
-        char buf[16];
-        mavlink_msg_param_request_read_get_param_id(&msg, buf);
-        string pid = buf;
-        sys->track_generic_timeseries<unsigned int>(fullname + "target_system", system);
-        sys->track_generic_timeseries<unsigned int>(fullname + "target_component", component);
-        sys->track_generic_event<string>(fullname + "param_id", pid);
-        sys->track_generic_timeseries<int>(fullname + "param_index", pidx);
-    }
-        break;
-
-    case MAVLINK_MSG_ID_PARAM_REQUEST_LIST: // #21
-    {
-        const string fullname = "param/request_list/";
-        unsigned int component = mavlink_msg_param_request_list_get_target_component(&msg);
-        unsigned int system = mavlink_msg_param_request_list_get_target_system(&msg);
-        sys->track_generic_timeseries<unsigned int>(fullname + "target_system", system);
-        sys->track_generic_timeseries<unsigned int>(fullname + "target_component", component);
-    }
-        break;
+static void handle_set_mode(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #11
+    const string fullname = "mission/set mode/";
+    unsigned int target = mavlink_msg_set_mode_get_target_system(&msg);
+    unsigned int base = mavlink_msg_set_mode_get_base_mode(&msg);
+    unsigned int custom = mavlink_msg_set_mode_get_custom_mode(&msg);
+    sys->track_generic_timeseries<unsigned int>(fullname + "target", target);
+    sys->track_generic_timeseries<unsigned int>(fullname + "base", base);
+    sys->track_generic_timeseries<unsigned int>(fullname + "custom", custom);
+}
 
-    case MAVLINK_MSG_ID_PARAM_VALUE: // #22
-    {
-        char param_id[17]; param_id[16]=0;
-        mavlink_msg_param_value_get_param_id(&msg, param_id);
-        float param_value = mavlink_msg_param_value_get_param_value(&msg);
-        uint8_t param_type = mavlink_msg_param_value_get_param_type(&msg);
-        uint16_t param_count = mavlink_msg_param_value_get_param_count(&msg);
-        uint16_t param_index = mavlink_msg_param_value_get_param_index(&msg);
-        // --                
-        const string fullname = "param/emit/";
-        sys->track_generic_timeseries<float>(fullname + "value", param_value);
-        sys->track_generic_timeseries<unsigned int>(fullname + "type", param_type);
-        sys->track_generic_timeseries<unsigned int>(fullname + "count", param_count);
-        sys->track_generic_timeseries<unsigned int>(fullname + "index", param_index);
-    }
-        break;
-
-    case MAVLINK_MSG_ID_PARAM_SET: // #23
-    {
-        uint8_t target = mavlink_msg_param_set_get_target_system(&msg);
-        uint8_t component = mavlink_msg_param_set_get_target_component(&msg);
-        char param_id[16];
-        mavlink_msg_param_set_get_param_id(&msg, param_id);
-        float param_value = mavlink_msg_param_set_get_param_value(&msg);
-        uint8_t param_type = mavlink_msg_param_set_get_param_type(&msg);
-        const string fullname = "param/set/";
-        sys->track_generic_timeseries<float>(fullname + "value", param_value);
-        sys->track_generic_timeseries<unsigned int>(fullname + "target system", target);
-        sys->track_generic_timeseries<unsigned int>(fullname + "target component", component);
-        sys->track_generic_timeseries<unsigned int>(fullname + "type", param_type);
-        sys->track_generic_event<string>(fullname + "id", param_id);
-    }
-        break;
-
-    case MAVLINK_MSG_ID_GPS_RAW_INT: // #24
-    {
-        // RAW gps sensor values
-        uint64_t timestamp_usec = mavlink_msg_gps_raw_int_get_time_usec(&msg); // since boot or!! epoch
-        int upd = 0;
-        if (sys->is_absolute_time(timestamp_usec)) {
-            sys->update_time_offset(nowtime_us, timestamp_usec, allow_time_jumps); // OK -- here we establish a reference between boot time and /absolute time
-        } else {
-            upd = sys->update_rel_time(timestamp_usec, allow_time_jumps);
-        }
+static void handle_param_request_read(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #20
+    const string fullname = "param/request_read/";
+    unsigned int system = mavlink_msg_param_request_read_get_target_system(&msg);
+    unsigned int component = mavlink_msg_param_request_read_get_target_component(&msg);
+    int pidx = mavlink_msg_param_request_read_get_param_index(&msg);
+    char buf[16];
+    mavlink_msg_param_request_read_get_param_id(&msg, buf);
+    string pid = buf;
+    sys->track_generic_timeseries<unsigned int>(fullname + "target_system", system);
+    sys->track_generic_timeseries<unsigned int>(fullname + "target_component", component);
+    sys->track_generic_event<string>(fullname + "param_id", pid);
+    sys->track_generic_timeseries<int>(fullname + "param_index", pidx);
+}
 
-        if (0 == upd) {
-            uint8_t fix_type = mavlink_msg_gps_raw_int_get_fix_type(&msg); // 	0-1: no fix, 2: 2D fix, 3: 3D fix
-            double lat = mavlink_msg_gps_raw_int_get_lat(&msg)*1E-7;
-            double lon = mavlink_msg_gps_raw_int_get_lon(&msg)*1E-7;
-            float alt_wgs84_m = mavlink_msg_gps_raw_int_get_alt(&msg)/1000.f;
-            float hdop_m = mavlink_msg_gps_raw_int_get_eph(&msg)/100.f;
-            float vdop_m = mavlink_msg_gps_raw_int_get_epv(&msg)/100.f;
-            float vel_ms = mavlink_msg_gps_raw_int_get_vel(&msg)/100.f;
-            float groundcourse_deg = mavlink_msg_gps_raw_int_get_cog(&msg)/100.f;
-            uint8_t n_sat = mavlink_msg_gps_raw_int_get_satellites_visible(&msg);
-            // --
-            sys->track_gps_status(lat, lon, alt_wgs84_m, hdop_m, vdop_m, vel_ms, groundcourse_deg );
-            sys->track_gps_status(n_sat, fix_type);
-        }  else {
-            ret = upd;
-        }
-    }
-        break;
+static void handle_param_request_list(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #21
+    const string fullname = "param/request_list/";
+    unsigned int component = mavlink_msg_param_request_list_get_target_component(&msg);
+    unsigned int system = mavlink_msg_param_request_list_get_target_system(&msg);
+    sys->track_generic_timeseries<unsigned int>(fullname + "target_system", system);
+    sys->track_generic_timeseries<unsigned int>(fullname + "target_component", component);
+}
 
-    case MAVLINK_MSG_ID_GPS_STATUS: // #25
-    {
-        // GPS status data
-        uint8_t n_sat = mavlink_msg_gps_status_get_satellites_visible(&msg);        
-        uint8_t sat_prn[20]; mavlink_msg_gps_status_get_satellite_prn(&msg, sat_prn);
-        uint8_t sat_used[20]; mavlink_msg_gps_status_get_satellite_prn(&msg,sat_used);
-        uint8_t sat_elev[20]; mavlink_msg_gps_status_get_satellite_elevation(&msg, sat_elev);
-        uint8_t sat_azi[20]; mavlink_msg_gps_status_get_satellite_azimuth(&msg, sat_azi);
-        uint8_t sat_snr[20]; mavlink_msg_gps_status_get_satellite_snr(&msg, sat_snr);                
-        // --
-        const string fullname = "GPS/";
-        for (unsigned int k=0; k<20; k++) {
-            stringstream strnum;
-            strnum << k;
-            sys->track_generic_timeseries<unsigned int>(fullname + "prn_" + strnum.str(), sat_prn[k], "id");
-            sys->track_generic_timeseries<unsigned int>(fullname + "used_" + strnum.str(), sat_used[k]);
-            sys->track_generic_timeseries<unsigned int>(fullname + "elev_" + strnum.str(), sat_elev[k], "0: right on top of receiver, 90: on the horizon");
-            sys->track_generic_timeseries<unsigned int>(fullname + "azi_" + strnum.str(), sat_azi[k], "deg");
-            sys->track_generic_timeseries<unsigned int>(fullname + "snr_" + strnum.str(), sat_snr[k]);
-        }
-        sys->track_gps_status(n_sat);
-    }
-        break;
+static void handle_param_value(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #22
+    char param_id[17]; param_id[16]=0;
+    mavlink_msg_param_value_get_param_id(&msg, param_id);
+    float param_value = mavlink_msg_param_value_get_param_value(&msg);
+    uint8_t param_type = mavlink_msg_param_value_get_param_type(&msg);
+    uint16_t param_count = mavlink_msg_param_value_get_param_count(&msg);
+    uint16_t param_index = mavlink_msg_param_value_get_param_index(&msg);
+    // --                
+    const string fullname = "param/emit/";
+    sys->track_generic_timeseries<float>(fullname + "value", param_value);
+    sys->track_generic_timeseries<unsigned int>(fullname + "type", param_type);
+    sys->track_generic_timeseries<unsigned int>(fullname + "count", param_count);
+    sys->track_generic_timeseries<unsigned int>(fullname + "index", param_index);
+}
 
-    // MAVLINK_MSG_ID_RAW_IMU #26 does not appear
+static void handle_param_set(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #23
+    uint8_t target = mavlink_msg_param_set_get_target_system(&msg);
+    uint8_t component = mavlink_msg_param_set_get_target_component(&msg);
+    char param_id[16];
+    mavlink_msg_param_set_get_param_id(&msg, param_id);
+    float param_value = mavlink_msg_param_set_get_param_value(&msg);
+    uint8_t param_type = mavlink_msg_param_set_get_param_type(&msg);
+    const string fullname = "param/set/";
+    sys->track_generic_timeseries<float>(fullname + "value", param_value);
+    sys->track_generic_timeseries<unsigned int>(fullname + "target system", target);
+    sys->track_generic_timeseries<unsigned int>(fullname + "target component", component);
+    sys->track_generic_timeseries<unsigned int>(fullname + "type", param_type);
+    sys->track_generic_event<string>(fullname + "id", param_id);
+}
 
-    case MAVLINK_MSG_ID_RAW_IMU: // #27
-    {
-        //uint64_t time_unix_or_boot_usec = mavlink_msg_raw_imu_get_time_usec(&msg); // OK
-        int16_t acc_mg[3]; ///< acceleration milli-g x-y-z
-        acc_mg[0] = mavlink_msg_raw_imu_get_xacc(&msg);
-        acc_mg[1] = mavlink_msg_raw_imu_get_yacc(&msg);
-        acc_mg[2] = mavlink_msg_raw_imu_get_zacc(&msg);
-        int16_t gyr_mrs[3]; ///< gyro millirad/sec x-y-z
-        gyr_mrs[0] = mavlink_msg_raw_imu_get_xgyro(&msg);
-        gyr_mrs[1] = mavlink_msg_raw_imu_get_ygyro(&msg);
-        gyr_mrs[2] = mavlink_msg_raw_imu_get_zgyro(&msg);
-        int16_t mag_mT[3]; ///< magnetic field, millitesla x-y-z
-        mag_mT[0] = mavlink_msg_raw_imu_get_xmag(&msg);
-        mag_mT[1] = mavlink_msg_raw_imu_get_ymag(&msg);
-        mag_mT[2] = mavlink_msg_raw_imu_get_zmag(&msg);
-        // --
-        sys->track_imu1(acc_mg, gyr_mrs, mag_mT);
+static void handle_gps_raw_int(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #24
+    // RAW gps sensor values
+    uint64_t timestamp_usec = mavlink_msg_gps_raw_int_get_time_usec(&msg); // since boot or!! epoch
+    int upd = 0;
+    if (sys->is_absolute_time(timestamp_usec)) {
+        sys->update_time_offset(nowtime_us, timestamp_usec, allow_time_jumps); // OK -- here we establish a reference between boot time and /absolute time
+    } else {
+        upd = sys->update_rel_time(timestamp_usec, allow_time_jumps);
     }
-        break;
 
-    case MAVLINK_MSG_ID_SCALED_PRESSURE: // #29
-    {
-        uint32_t time_boot_ms = mavlink_msg_scaled_pressure_get_time_boot_ms(&msg); // OK
-        int16_t temp = mavlink_msg_scaled_pressure_get_temperature(&msg);
-        float press = mavlink_msg_scaled_pressure_get_press_abs(&msg);
-        nowtime_us = time_boot_ms * 1000;
-        int upd = sys->update_rel_time(nowtime_us, allow_time_jumps); // sometimes goes backwards
+    if (0 == upd) {
+        uint8_t fix_type = mavlink_msg_gps_raw_int_get_fix_type(&msg); // 	0-1: no fix, 2: 2D fix, 3: 3D fix
+        double lat = mavlink_msg_gps_raw_int_get_lat(&msg)*1E-7;
+        double lon = mavlink_msg_gps_raw_int_get_lon(&msg)*1E-7;
+        float alt_wgs84_m = mavlink_msg_gps_raw_int_get_alt(&msg)/1000.f;
+        float hdop_m = mavlink_msg_gps_raw_int_get_eph(&msg)/100.f;
+        float vdop_m = mavlink_msg_gps_raw_int_get_epv(&msg)/100.f;
+        float vel_ms = mavlink_msg_gps_raw_int_get_vel(&msg)/100.f;
+        float groundcourse_deg = mavlink_msg_gps_raw_int_get_cog(&msg)/100.f;
+        uint8_t n_sat = mavlink_msg_gps_raw_int_get_satellites_visible(&msg);
         // --
-        if (0 == upd) {
-            sys->track_ambient(temp/100., press);
-        } else {
-            ret = upd;
-        }
+        sys->track_gps_status(lat, lon, alt_wgs84_m, hdop_m, vdop_m, vel_ms, groundcourse_deg );
+        sys->track_gps_status(n_sat, fix_type);
+    }  else {
+        ret = upd;
     }
-        break;
+}
 
-    case MAVLINK_MSG_ID_ATTITUDE: // #30
-    {
-        uint32_t time_boot_ms = mavlink_msg_attitude_get_time_boot_ms(&msg); // OK
-        float rpy_rad[3];
-        rpy_rad[0] = mavlink_msg_attitude_get_roll(&msg);
-        rpy_rad[1] = mavlink_msg_attitude_get_pitch(&msg);
-        rpy_rad[2] = mavlink_msg_attitude_get_yaw(&msg);
-        float speed_rpy_radsec[3];
-        speed_rpy_radsec[0] = mavlink_msg_attitude_get_rollspeed(&msg);
-        speed_rpy_radsec[1] = mavlink_msg_attitude_get_pitchspeed(&msg);
-        speed_rpy_radsec[2] = mavlink_msg_attitude_get_yawspeed(&msg);
-        // update time
-        nowtime_us = time_boot_ms * 1000;
-        int upd = sys->update_rel_time(nowtime_us, allow_time_jumps); // BUG: goes backwards *every* time
-        // --
-        if (0 == upd) {
-            sys->track_paths_attitude(rpy_rad, speed_rpy_radsec);
-        } else {
-            ret = upd;
-        }
+static void handle_gps_status(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #25
+    // GPS status data
+    uint8_t n_sat = mavlink_msg_gps_status_get_satellites_visible(&msg);        
+    uint8_t sat_prn[20]; mavlink_msg_gps_status_get_satellite_prn(&msg, sat_prn);
+    uint8_t sat_used[20]; mavlink_msg_gps_status_get_satellite_prn(&msg,sat_used);
+    uint8_t sat_elev[20]; mavlink_msg_gps_status_get_satellite_elevation(&msg, sat_elev);
+    uint8_t sat_azi[20]; mavlink_msg_gps_status_get_satellite_azimuth(&msg, sat_azi);
+    uint8_t sat_snr[20]; mavlink_msg_gps_status_get_satellite_snr(&msg, sat_snr);                
+    // --
+    const string fullname = "GPS/";
+    for (unsigned int k=0; k<20; k++) {
+        stringstream strnum;
+        strnum << k;
+        sys->track_generic_timeseries<unsigned int>(fullname + "prn_" + strnum.str(), sat_prn[k], "id");
+        sys->track_generic_timeseries<unsigned int>(fullname + "used_" + strnum.str(), sat_used[k]);
+        sys->track_generic_timeseries<unsigned int>(fullname + "elev_" + strnum.str(), sat_elev[k], "0: right on top of receiver, 90: on the horizon");
+        sys->track_generic_timeseries<unsigned int>(fullname + "azi_" + strnum.str(), sat_azi[k], "deg");
+        sys->track_generic_timeseries<unsigned int>(fullname + "snr_" + strnum.str(), sat_snr[k]);
     }
-        break;
+    sys->track_gps_status(n_sat);
+}
 
-    case MAVLINK_MSG_ID_LOCAL_POSITION_NED: // #32
-    {
-        uint32_t time_boot_ms = mavlink_msg_local_position_ned_get_time_boot_ms(&msg);
-        float x = mavlink_msg_local_position_ned_get_x(&msg);
-        float y = mavlink_msg_local_position_ned_get_y(&msg);
-        float z = mavlink_msg_local_position_ned_get_z(&msg);
-        float vx = mavlink_msg_local_position_ned_get_vx(&msg);
-        float vy = mavlink_msg_local_position_ned_get_vy(&msg);
-        float vz = mavlink_msg_local_position_ned_get_vz(&msg);
-        // update time
-        nowtime_us = time_boot_ms * 1000;
-        int upd = sys->update_rel_time(nowtime_us, allow_time_jumps);
-        if (0==upd) {
-            const string fullname = "airstate/local pos ned/";
-            sys->track_generic_timeseries<float>(fullname + "x", x);
-            sys->track_generic_timeseries<float>(fullname + "y", y);
-            sys->track_generic_timeseries<float>(fullname + "z", z);
-            sys->track_generic_timeseries<float>(fullname + "vx", vx);
-            sys->track_generic_timeseries<float>(fullname + "vy", vy);
-            sys->track_generic_timeseries<float>(fullname + "vz", vz);
-        } else {
-            ret = upd;
-        }
-        // --
+// MAVLINK_MSG_ID_RAW_IMU #26 does not appear
+
+static void handle_raw_imu(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #27
+    //uint64_t time_unix_or_boot_usec = mavlink_msg_raw_imu_get_time_usec(&msg); // OK
+    int16_t acc_mg[3]; ///< acceleration milli-g x-y-z
+    acc_mg[0] = mavlink_msg_raw_imu_get_xacc(&msg);
+    acc_mg[1] = mavlink_msg_raw_imu_get_yacc(&msg);
+    acc_mg[2] = mavlink_msg_raw_imu_get_zacc(&msg);
+    int16_t gyr_mrs[3]; ///< gyro millirad/sec x-y-z
+    gyr_mrs[0] = mavlink_msg_raw_imu_get_xgyro(&msg);
+    gyr_mrs[1] = mavlink_msg_raw_imu_get_ygyro(&msg);
+    gyr_mrs[2] = mavlink_msg_raw_imu_get_zgyro(&msg);
+    int16_t mag_mT[3]; ///< magnetic field, millitesla x-y-z
+    mag_mT[0] = mavlink_msg_raw_imu_get_xmag(&msg);
+    mag_mT[1] = mavlink_msg_raw_imu_get_ymag(&msg);
+    mag_mT[2] = mavlink_msg_raw_imu_get_zmag(&msg);
+    // --
+    sys->track_imu1(acc_mg, gyr_mrs, mag_mT);
+}
+
+static void handle_scaled_pressure(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #29
+    uint32_t time_boot_ms = mavlink_msg_scaled_pressure_get_time_boot_ms(&msg); // OK
+    int16_t temp = mavlink_msg_scaled_pressure_get_temperature(&msg);
+    float press = mavlink_msg_scaled_pressure_get_press_abs(&msg);
+    nowtime_us = time_boot_ms * 1000;
+    int upd = sys->update_rel_time(nowtime_us, allow_time_jumps); // sometimes goes backwards
+    // --
+    if (0 == upd) {
+        sys->track_ambient(temp/100., press);
+    } else {
+        ret = upd;
     }
-        break;
+}
 
-    case MAVLINK_MSG_ID_GLOBAL_POSITION_INT: // #33
-    {
-        uint32_t time_boot_ms = mavlink_msg_global_position_int_get_time_boot_ms(&msg);
-        double lat = mavlink_msg_global_position_int_get_lat(&msg)*1E-7;
-        double lon = mavlink_msg_global_position_int_get_lon(&msg)*1E-7;
-        float alt_msl = mavlink_msg_global_position_int_get_alt(&msg)/1000.f;
-        float alt_rel = mavlink_msg_global_position_int_get_relative_alt(&msg)/1000.f;
-        float v_ms[3];
-        v_ms[0] = mavlink_msg_global_position_int_get_vx(&msg)/100.f;
-        v_ms[1] = mavlink_msg_global_position_int_get_vy(&msg)/100.f;
-        v_ms[2] = mavlink_msg_global_position_int_get_vz(&msg)/100.f;
-        float heading_deg = mavlink_msg_global_position_int_get_hdg(&msg)/100.f;
-        // update time
-        nowtime_us = time_boot_ms * 1000;
-        int upd = sys->update_rel_time(nowtime_us, allow_time_jumps);
-        // --
-        if (0==upd) {
-            sys->track_paths(lat, lon, alt_rel, alt_msl, heading_deg);
-            sys->track_paths_speed(v_ms);
-        } else {
-            ret = upd;
-        }
+static void handle_attitude(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #30
+    uint32_t time_boot_ms = mavlink_msg_attitude_get_time_boot_ms(&msg); // OK
+    float rpy_rad[3];
+    rpy_rad[0] = mavlink_msg_attitude_get_roll(&msg);
+    rpy_rad[1] = mavlink_msg_attitude_get_pitch(&msg);
+    rpy_rad[2] = mavlink_msg_attitude_get_yaw(&msg);
+    float speed_rpy_radsec[3];
+    speed_rpy_radsec[0] = mavlink_msg_attitude_get_rollspeed(&msg);
+    speed_rpy_radsec[1] = mavlink_msg_attitude_get_pitchspeed(&msg);
+    speed_rpy_radsec[2] = mavlink_msg_attitude_get_yawspeed(&msg);
+    // update time
+    nowtime_us = time_boot_ms * 1000;
+    int upd = sys->update_rel_time(nowtime_us, allow_time_jumps); // BUG: goes backwards *every* time
+    // --
+    if (0 == upd) {
+        sys->track_paths_attitude(rpy_rad, speed_rpy_radsec);
+    } else {
+        ret = upd;
     }
-        break;
+}
 
-    case MAVLINK_MSG_ID_RC_CHANNELS_SCALED: // #34
-    {
-        uint32_t time_boot_ms = mavlink_msg_rc_channels_scaled_get_time_boot_ms(&msg); // OK
-        /*
-        uint8_t port = mavlink_msg_rc_channels_scaled_get_port(&msg);
-        uint16_t channel[8];
-        channel[0] = mavlink_msg_rc_channels_scaled_get_chan1_scaled(&msg);
-        channel[1] = mavlink_msg_rc_channels_scaled_get_chan2_scaled(&msg);
-        channel[2] = mavlink_msg_rc_channels_scaled_get_chan3_scaled(&msg);
-        channel[3] = mavlink_msg_rc_channels_scaled_get_chan4_scaled(&msg);
-        channel[4] = mavlink_msg_rc_channels_scaled_get_chan5_scaled(&msg);
-        channel[5] = mavlink_msg_rc_channels_scaled_get_chan6_scaled(&msg);
-        channel[6] = mavlink_msg_rc_channels_scaled_get_chan7_scaled(&msg);
-        channel[7] = mavlink_msg_rc_channels_scaled_get_chan8_scaled(&msg);
-        */
-        uint8_t rssi = mavlink_msg_rc_channels_scaled_get_rssi(&msg);
-        // update time
-        nowtime_us = time_boot_ms * 1000;
-
-        int upd = sys->update_rel_time(nowtime_us, allow_time_jumps); // BUG: goes backwards
-        // --
-        if (0 == upd) {
-            sys->track_radio(rssi);
-        } else {
-            ret = upd;
-        }
+static void handle_local_position_ned(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #32
+    uint32_t time_boot_ms = mavlink_msg_local_position_ned_get_time_boot_ms(&msg);
+    float x = mavlink_msg_local_position_ned_get_x(&msg);
+    float y = mavlink_msg_local_position_ned_get_y(&msg);
+    float z = mavlink_msg_local_position_ned_get_z(&msg);
+    float vx = mavlink_msg_local_position_ned_get_vx(&msg);
+    float vy = mavlink_msg_local_position_ned_get_vy(&msg);
+    float vz = mavlink_msg_local_position_ned_get_vz(&msg);
+    // update time
+    nowtime_us = time_boot_ms * 1000;
+    int upd = sys->update_rel_time(nowtime_us, allow_time_jumps);
+    if (0==upd) {
+        const string fullname = "airstate/local pos ned/";
+        sys->track_generic_timeseries<float>(fullname + "x", x);
+        sys->track_generic_timeseries<float>(fullname + "y", y);
+        sys->track_generic_timeseries<float>(fullname + "z", z);
+        sys->track_generic_timeseries<float>(fullname + "vx", vx);
+        sys->track_generic_timeseries<float>(fullname + "vy", vy);
+        sys->track_generic_timeseries<float>(fullname + "vz", vz);
+    } else {
+        ret = upd;
     }
-        break;
+    // --
+}
 
-    case MAVLINK_MSG_ID_RC_CHANNELS_RAW: // #35
-    {
-        uint32_t time_boot_ms = mavlink_msg_rc_channels_raw_get_time_boot_ms(&msg); // OK
-        uint16_t chan_raw[8];
-        chan_raw[0] = mavlink_msg_rc_channels_raw_get_chan1_raw(&msg);
-        chan_raw[1] = mavlink_msg_rc_channels_raw_get_chan2_raw(&msg);
-        chan_raw[2] = mavlink_msg_rc_channels_raw_get_chan3_raw(&msg);
-        chan_raw[3] = mavlink_msg_rc_channels_raw_get_chan4_raw(&msg);
-        chan_raw[4] = mavlink_msg_rc_channels_raw_get_chan5_raw(&msg);
-        chan_raw[5] = mavlink_msg_rc_channels_raw_get_chan6_raw(&msg);
-        chan_raw[6] = mavlink_msg_rc_channels_raw_get_chan7_raw(&msg);
-        chan_raw[7] = mavlink_msg_rc_channels_raw_get_chan8_raw(&msg);
-        // update time
-        nowtime_us = time_boot_ms * 1000;
-        int upd = sys->update_rel_time(nowtime_us, allow_time_jumps);
-        // --
-        if (0 == upd) {
-            sys->track_rc(chan_raw);
-        } else {
-            ret = upd;
-        }
+static void handle_global_position_int(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #33
+    uint32_t time_boot_ms = mavlink_msg_global_position_int_get_time_boot_ms(&msg);
+    double lat = mavlink_msg_global_position_int_get_lat(&msg)*1E-7;
+    double lon = mavlink_msg_global_position_int_get_lon(&msg)*1E-7;
+    float alt_msl = mavlink_msg_global_position_int_get_alt(&msg)/1000.f;
+    float alt_rel = mavlink_msg_global_position_int_get_relative_alt(&msg)/1000.f;
+    float v_ms[3];
+    v_ms[0] = mavlink_msg_global_position_int_get_vx(&msg)/100.f;
+    v_ms[1] = mavlink_msg_global_position_int_get_vy(&msg)/100.f;
+    v_ms[2] = mavlink_msg_global_position_int_get_vz(&msg)/100.f;
+    float heading_deg = mavlink_msg_global_position_int_get_hdg(&msg)/100.f;
+    // update time
+    nowtime_us = time_boot_ms * 1000;
+    int upd = sys->update_rel_time(nowtime_us, allow_time_jumps);
+    // --
+    if (0==upd) {
+        sys->track_paths(lat, lon, alt_rel, alt_msl, heading_deg);
+        sys->track_paths_speed(v_ms);
+    } else {
+        ret = upd;
     }
-        break;
+}
 
-    case MAVLINK_MSG_ID_SERVO_OUTPUT_RAW: // #36
-    {
-        uint32_t time_boot_usec = mavlink_msg_servo_output_raw_get_time_usec(&msg); // OK
-        //uint8_t port = mavlink_msg_servo_output_raw_get_port(&msg);
-        uint16_t servo_raw[8];
-        servo_raw[0] = mavlink_msg_servo_output_raw_get_servo1_raw(&msg);
-        servo_raw[1] = mavlink_msg_servo_output_raw_get_servo2_raw(&msg);
-        servo_raw[2] = mavlink_msg_servo_output_raw_get_servo3_raw(&msg);
-        servo_raw[3] = mavlink_msg_servo_output_raw_get_servo4_raw(&msg);
-        servo_raw[4] = mavlink_msg_servo_output_raw_get_servo5_raw(&msg);
-        servo_raw[5] = mavlink_msg_servo_output_raw_get_servo6_raw(&msg);
-        servo_raw[6] = mavlink_msg_servo_output_raw_get_servo7_raw(&msg);
-        servo_raw[7] = mavlink_msg_servo_output_raw_get_servo8_raw(&msg);
-        // update time        
-        int upd = sys->update_rel_time(time_boot_usec, allow_time_jumps);
-        // --
-        if ( 0 == upd) {
-            sys->track_actuators(servo_raw);
-        } else {
-            ret = upd;
-        }
+static void handle_rc_channels_scaled(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #34
+    uint32_t time_boot_ms = mavlink_msg_rc_channels_scaled_get_time_boot_ms(&msg); // OK
+    /*
+    uint8_t port = mavlink_msg_rc_channels_scaled_get_port(&msg);
+    uint16_t channel[8];
+    channel[0] = mavlink_msg_rc_channels_scaled_get_chan1_scaled(&msg);
+    channel[1] = mavlink_msg_rc_channels_scaled_get_chan2_scaled(&msg);
+    channel[2] = mavlink_msg_rc_channels_scaled_get_chan3_scaled(&msg);
+    channel[3] = mavlink_msg_rc_channels_scaled_get_chan4_scaled(&msg);
+    channel[4] = mavlink_msg_rc_channels_scaled_get_chan5_scaled(&msg);
+    channel[5] = mavlink_msg_rc_channels_scaled_get_chan6_scaled(&msg);
+    channel[6] = mavlink_msg_rc_channels_scaled_get_chan7_scaled(&msg);
+    channel[7] = mavlink_msg_rc_channels_scaled_get_chan8_scaled(&msg);
+    */
+    uint8_t rssi = mavlink_msg_rc_channels_scaled_get_rssi(&msg);
+    // update time
+    nowtime_us = time_boot_ms * 1000;
+
+    int upd = sys->update_rel_time(nowtime_us, allow_time_jumps); // BUG: goes backwards
+    // --
+    if (0 == upd) {
+        sys->track_radio(rssi);
+    } else {
+        ret = upd;
     }
-        break;
+}
 
-    case MAVLINK_MSG_ID_MISSION_ITEM: // #39
-    {
-        uint8_t target_system_id = mavlink_msg_mission_item_get_target_system(&msg);
-        uint8_t target_comp_id = mavlink_msg_mission_item_get_target_component(&msg);
-        uint16_t seq = mavlink_msg_mission_item_get_seq(&msg);
-        uint8_t frame = mavlink_msg_mission_item_get_frame(&msg);
-        uint16_t cmd = mavlink_msg_mission_item_get_command(&msg);
-        uint8_t current = mavlink_msg_mission_item_get_current(&msg);
-        uint8_t autocontinue = mavlink_msg_mission_item_get_autocontinue(&msg);
-        float param1 = mavlink_msg_mission_item_get_param1(&msg);
-        float param2 = mavlink_msg_mission_item_get_param2(&msg);
-        float param3 = mavlink_msg_mission_item_get_param3(&msg);
-        float param4 = mavlink_msg_mission_item_get_param4(&msg);
-        float x = mavlink_msg_mission_item_get_x(&msg);
-        float y = mavlink_msg_mission_item_get_y(&msg);
-        float z = mavlink_msg_mission_item_get_z(&msg);
-        // --
-        sys->track_mission_item(target_system_id, target_comp_id, seq, frame, cmd, current, autocontinue, param1, param2, param3, param4, x, y, z);
+static void handle_rc_channels_raw(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #35
+    uint32_t time_boot_ms = mavlink_msg_rc_channels_raw_get_time_boot_ms(&msg); // OK
+    uint16_t chan_raw[8];
+    chan_raw[0] = mavlink_msg_rc_channels_raw_get_chan1_raw(&msg);
+    chan_raw[1] = mavlink_msg_rc_channels_raw_get_chan2_raw(&msg);
+    chan_raw[2] = mavlink_msg_rc_channels_raw_get_chan3_raw(&msg);
+    chan_raw[3] = mavlink_msg_rc_channels_raw_get_chan4_raw(&msg);
+    chan_raw[4] = mavlink_msg_rc_channels_raw_get_chan5_raw(&msg);
+    chan_raw[5] = mavlink_msg_rc_channels_raw_get_chan6_raw(&msg);
+    chan_raw[6] = mavlink_msg_rc_channels_raw_get_chan7_raw(&msg);
+    chan_raw[7] = mavlink_msg_rc_channels_raw_get_chan8_raw(&msg);
+    // update time
+    nowtime_us = time_boot_ms * 1000;
+    int upd = sys->update_rel_time(nowtime_us, allow_time_jumps);
+    // --
+    if (0 == upd) {
+        sys->track_rc(chan_raw);
+    } else {
+        ret = upd;
     }
-        break;
+}
 
-    case MAVLINK_MSG_ID_MISSION_REQUEST: // #40
-    {
-        uint8_t target_system = mavlink_msg_mission_request_get_target_system(&msg);
-        uint8_t target_comp = mavlink_msg_mission_request_get_target_component(&msg);
-        uint16_t seq = mavlink_msg_mission_request_get_seq(&msg);
-        const string fullname = "mission/request/";
-        sys->track_generic_timeseries<unsigned int>(fullname + "target system", target_system);
-        sys->track_generic_timeseries<unsigned int>(fullname + "target component", target_comp);
-        sys->track_generic_timeseries<unsigned int>(fullname + "seq", seq);
+static void handle_servo_output_raw(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #36
+    uint32_t time_boot_usec = mavlink_msg_servo_output_raw_get_time_usec(&msg); // OK
+    //uint8_t port = mavlink_msg_servo_output_raw_get_port(&msg);
+    uint16_t servo_raw[8];
+    servo_raw[0] = mavlink_msg_servo_output_raw_get_servo1_raw(&msg);
+    servo_raw[1] = mavlink_msg_servo_output_raw_get_servo2_raw(&msg);
+    servo_raw[2] = mavlink_msg_servo_output_raw_get_servo3_raw(&msg);
+    servo_raw[3] = mavlink_msg_servo_output_raw_get_servo4_raw(&msg);
+    servo_raw[4] = mavlink_msg_servo_output_raw_get_servo5_raw(&msg);
+    servo_raw[5] = mavlink_msg_servo_output_raw_get_servo6_raw(&msg);
+    servo_raw[6] = mavlink_msg_servo_output_raw_get_servo7_raw(&msg);
+    servo_raw[7] = mavlink_msg_servo_output_raw_get_servo8_raw(&msg);
+    // update time        
+    int upd = sys->update_rel_time(time_boot_usec, allow_time_jumps);
+    // --
+    if ( 0 == upd) {
+        sys->track_actuators(servo_raw);
+    } else {
+        ret = upd;
     }
-        break;
+}
 
+static void handle_mission_item(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #39
+    uint8_t target_system_id = mavlink_msg_mission_item_get_target_system(&msg);
+    uint8_t target_comp_id = mavlink_msg_mission_item_get_target_component(&msg);
+    uint16_t seq = mavlink_msg_mission_item_get_seq(&msg);
+    uint8_t frame = mavlink_msg_mission_item_get_frame(&msg);
+    uint16_t cmd = mavlink_msg_mission_item_get_command(&msg);
+    uint8_t current = mavlink_msg_mission_item_get_current(&msg);
+    uint8_t autocontinue = mavlink_msg_mission_item_get_autocontinue(&msg);
+    float param1 = mavlink_msg_mission_item_get_param1(&msg);
+    float param2 = mavlink_msg_mission_item_get_param2(&msg);
+    float param3 = mavlink_msg_mission_item_get_param3(&msg);
+    float param4 = mavlink_msg_mission_item_get_param4(&msg);
+    float x = mavlink_msg_mission_item_get_x(&msg);
+    float y = mavlink_msg_mission_item_get_y(&msg);
+    float z = mavlink_msg_mission_item_get_z(&msg);
+    // --
+    sys->track_mission_item(target_system_id, target_comp_id, seq, frame, cmd, current, autocontinue, param1, param2, param3, param4, x, y, z);
+}
 
-    case MAVLINK_MSG_ID_MISSION_CURRENT: // #42
-    {
-        uint16_t seq = mavlink_msg_mission_current_get_seq(&msg);
-        sys->track_mission_current(seq);
-    }
-        break;
+static void handle_mission_request(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #40
+    uint8_t target_system = mavlink_msg_mission_request_get_target_system(&msg);
+    uint8_t target_comp = mavlink_msg_mission_request_get_target_component(&msg);
+    uint16_t seq = mavlink_msg_mission_request_get_seq(&msg);
+    const string fullname = "mission/request/";
+    sys->track_generic_timeseries<unsigned int>(fullname + "target system", target_system);
+    sys->track_generic_timeseries<unsigned int>(fullname + "target component", target_comp);
+    sys->track_generic_timeseries<unsigned int>(fullname + "seq", seq);
+}
 
-    case MAVLINK_MSG_ID_MISSION_COUNT: // #44
-    {
-        uint8_t target_system = mavlink_msg_mission_count_get_target_system(&msg);
-        uint8_t target_comp = mavlink_msg_mission_count_get_target_component(&msg);
-        uint16_t count = mavlink_msg_mission_count_get_count(&msg);
-        const string fullname = "mission/count/";
-        sys->track_generic_timeseries<unsigned int>(fullname + "target system", target_system);
-        sys->track_generic_timeseries<unsigned int>(fullname + "target component", target_comp);
-        sys->track_generic_timeseries<unsigned int>(fullname + "count", count);
-    }
-        break;
+static void handle_mission_current(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #42
+    uint16_t seq = mavlink_msg_mission_current_get_seq(&msg);
+    sys->track_mission_current(seq);
+}
 
-    case MAVLINK_MSG_ID_NAV_CONTROLLER_OUTPUT: // #62
-    {
-        float nav_roll_deg = mavlink_msg_nav_controller_output_get_nav_roll(&msg);
-        float nav_pitch_deg = mavlink_msg_nav_controller_output_get_nav_pitch(&msg);
-        float nav_bear_deg = (float) mavlink_msg_nav_controller_output_get_nav_bearing(&msg);
-        float tar_bear_deg = (float) mavlink_msg_nav_controller_output_get_target_bearing(&msg);
-        float wp_dist_m = (float) mavlink_msg_nav_controller_output_get_wp_dist(&msg);
-        float err_alt_m = mavlink_msg_nav_controller_output_get_alt_error(&msg);
-        float err_airspeed_ms = mavlink_msg_nav_controller_output_get_aspd_error(&msg);
-        float err_xtrack_m = mavlink_msg_nav_controller_output_get_xtrack_error(&msg);
-        // --
-        sys->track_nav(nav_roll_deg, nav_pitch_deg, nav_bear_deg, tar_bear_deg, wp_dist_m, err_alt_m, err_airspeed_ms, err_xtrack_m);
-    }
-        break;
+static void handle_mission_count(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #44
+    uint8_t target_system = mavlink_msg_mission_count_get_target_system(&msg);
+    uint8_t target_comp = mavlink_msg_mission_count_get_target_component(&msg);
+    uint16_t count = mavlink_msg_mission_count_get_count(&msg);
+    const string fullname = "mission/count/";
+    sys->track_generic_timeseries<unsigned int>(fullname + "target system", target_system);
+    sys->track_generic_timeseries<unsigned int>(fullname + "target component", target_comp);
+    sys->track_generic_timeseries<unsigned int>(fullname + "count", count);
+}
 
-    case MAVLINK_MSG_ID_REQUEST_DATA_STREAM: // #66
-    {
-        unsigned int target_system = mavlink_msg_request_data_stream_get_target_system(&msg);
-        unsigned int target_component = mavlink_msg_request_data_stream_get_target_component(&msg);
-        unsigned int req_stream_id = mavlink_msg_request_data_stream_get_req_stream_id(&msg);
-        unsigned int req_msg_rate = mavlink_msg_request_data_stream_get_req_message_rate(&msg);
-        unsigned int start_stop = mavlink_msg_request_data_stream_get_start_stop(&msg);
-        const string fullname = "datastream/request/";
-        sys->track_generic_timeseries<unsigned int>(fullname + "target system", target_system);
-        sys->track_generic_timeseries<unsigned int>(fullname + "target component", target_component);
-        sys->track_generic_timeseries<unsigned int>(fullname + "requested stream id", req_stream_id);
-        sys->track_generic_timeseries<unsigned int>(fullname + "requeted message rate", req_msg_rate);
-        sys->track_generic_timeseries<unsigned int>(fullname + "start stop", start_stop);
-    }
-        break;
-
-    case MAVLINK_MSG_ID_VFR_HUD: // #74
-    {
-        float airspeed_ms = mavlink_msg_vfr_hud_get_airspeed(&msg);
-        float groundspeed_ms = mavlink_msg_vfr_hud_get_groundspeed(&msg);
-        float alt_MSL_m = mavlink_msg_vfr_hud_get_alt(&msg);
-        float climb_ms = mavlink_msg_vfr_hud_get_climb(&msg);
-        uint16_t throttle_percent = mavlink_msg_vfr_hud_get_throttle(&msg);
-        // --
-        sys->track_flightperf(airspeed_ms, groundspeed_ms, alt_MSL_m, climb_ms, (float) throttle_percent);
-    }
-        break;
+static void handle_nav_controller_output(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #62
+    float nav_roll_deg = mavlink_msg_nav_controller_output_get_nav_roll(&msg);
+    float nav_pitch_deg = mavlink_msg_nav_controller_output_get_nav_pitch(&msg);
+    float nav_bear_deg = (float) mavlink_msg_nav_controller_output_get_nav_bearing(&msg);
+    float tar_bear_deg = (float) mavlink_msg_nav_controller_output_get_target_bearing(&msg);
+    float wp_dist_m = (float) mavlink_msg_nav_controller_output_get_wp_dist(&msg);
+    float err_alt_m = mavlink_msg_nav_controller_output_get_alt_error(&msg);
+    float err_airspeed_ms = mavlink_msg_nav_controller_output_get_aspd_error(&msg);
+    float err_xtrack_m = mavlink_msg_nav_controller_output_get_xtrack_error(&msg);
+    // --
+    sys->track_nav(nav_roll_deg, nav_pitch_deg, nav_bear_deg, tar_bear_deg, wp_dist_m, err_alt_m, err_airspeed_ms, err_xtrack_m);
+}
 
-    case MAVLINK_MSG_ID_COMMAND_LONG: // #76
-    {
-        const string fullname = "mission/command_long/";
-        unsigned int target_system = mavlink_msg_command_long_get_target_system(&msg);
-        unsigned int target_component = mavlink_msg_command_long_get_target_component(&msg);
-        unsigned int cmd = mavlink_msg_command_long_get_command(&msg);
-        unsigned int conf = mavlink_msg_command_long_get_confirmation(&msg);
-        float p1 = mavlink_msg_command_long_get_param1(&msg);
-        float p2 = mavlink_msg_command_long_get_param2(&msg);
-        float p3 = mavlink_msg_command_long_get_param3(&msg);
-        float p4 = mavlink_msg_command_long_get_param4(&msg);
-        float p5 = mavlink_msg_command_long_get_param5(&msg);
-        float p6 = mavlink_msg_command_long_get_param6(&msg);
-        float p7 = mavlink_msg_command_long_get_param7(&msg);
-        sys->track_generic_timeseries<unsigned int>(fullname + "target system", target_system);
-        sys->track_generic_timeseries<unsigned int>(fullname + "target component", target_component);
-        sys->track_generic_timeseries<unsigned int>(fullname + "command", cmd, "MAV_CMD enum");
-        sys->track_generic_timeseries<unsigned int>(fullname + "confirmation", conf, "0: first transmission. 1-255: confirm transmissions");
-        sys->track_generic_timeseries<float>(fullname + "param1", p1, "param1 of MAV_CMD enum");
-        sys->track_generic_timeseries<float>(fullname + "param2", p2, "param2 of MAV_CMD enum");
-        sys->track_generic_timeseries<float>(fullname + "param3", p3, "param3 of MAV_CMD enum");
-        sys->track_generic_timeseries<float>(fullname + "param4", p4, "param4 of MAV_CMD enum");
-        sys->track_generic_timeseries<float>(fullname + "param5", p5, "param5 of MAV_CMD enum");
-        sys->track_generic_timeseries<float>(fullname + "param6", p6, "param6 of MAV_CMD enum");
-        sys->track_generic_timeseries<float>(fullname + "param7", p7, "param7 of MAV_CMD enum");
-    }
-        break;
-
-    case MAVLINK_MSG_ID_COMMAND_ACK: // #77
-    {
-        unsigned int cmd = mavlink_msg_command_ack_get_command(&msg);
-        unsigned int res = mavlink_msg_command_ack_get_result(&msg);
-        const string fullname = "mission/command ack/";
-        sys->track_generic_timeseries<unsigned int>(fullname + "command", cmd, "MAV_CMD enum");
-        sys->track_generic_timeseries<unsigned int>(fullname + "result", res, "MAV_RESULT enum");
-    }
-        break;
+static void handle_request_data_stream(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #66
+    unsigned int target_system = mavlink_msg_request_data_stream_get_target_system(&msg);
+    unsigned int target_component = mavlink_msg_request_data_stream_get_target_component(&msg);
+    unsigned int req_stream_id = mavlink_msg_request_data_stream_get_req_stream_id(&msg);
+    unsigned int req_msg_rate = mavlink_msg_request_data_stream_get_req_message_rate(&msg);
+    unsigned int start_stop = mavlink_msg_request_data_stream_get_start_stop(&msg);
+    const string fullname = "datastream/request/";
+    sys->track_generic_timeseries<unsigned int>(fullname + "target system", target_system);
+    sys->track_generic_timeseries<unsigned int>(fullname + "target component", target_component);
+    sys->track_generic_timeseries<unsigned int>(fullname + "requested stream id", req_stream_id);
+    sys->track_generic_timeseries<unsigned int>(fullname + "requeted message rate", req_msg_rate);
+    sys->track_generic_timeseries<unsigned int>(fullname + "start stop", start_stop);
+}
 
-    case MAVLINK_MSG_ID_ATTITUDE_TARGET: // #83
-    {
-        const string fullname = "mission/attitude target/";
-        uint32_t time_boot_ms = mavlink_msg_attitude_target_get_time_boot_ms(&msg);        
-        int upd = sys->update_rel_time(time_boot_ms*1000, allow_time_jumps);
-        if (0 == upd) {
-            uint8_t type_mask = mavlink_msg_attitude_target_get_type_mask(&msg);
-            float q[4];
-            mavlink_msg_attitude_target_get_q(&msg, q);
-            float body_rollrate = mavlink_msg_attitude_target_get_body_roll_rate(&msg);
-            float body_pitchrate = mavlink_msg_attitude_target_get_body_pitch_rate(&msg);
-            float body_yawrate = mavlink_msg_attitude_target_get_body_yaw_rate(&msg);
-            float thrust = mavlink_msg_attitude_target_get_thrust(&msg);
-            sys->track_generic_timeseries<unsigned int>(fullname + "type mask", type_mask, "If any of these bits are set, the corresponding input should be ignored: bit 1: body roll rate, bit 2: body pitch rate, bit 3: body yaw rate. bit 4-bit 7: reserved, bit 8: attitude");
-            sys->track_generic_timeseries<float>(fullname + "attitude/q0", q[0], "w");
-            sys->track_generic_timeseries<float>(fullname + "attitude/q1", q[1], "x");
-            sys->track_generic_timeseries<float>(fullname + "attitude/q2", q[2], "y");
-            sys->track_generic_timeseries<float>(fullname + "attitude/q3", q[3], "z");
-            sys->track_generic_timeseries<float>(fullname + "thrust", thrust, "collective, normalized 0..1");
-            sys->track_generic_timeseries<float>(fullname + "rates/roll", body_rollrate, "rad/s");
-            sys->track_generic_timeseries<float>(fullname + "rates/pitch", body_pitchrate, "rad/s");
-            sys->track_generic_timeseries<float>(fullname + "rates/yaw", body_yawrate, "rad/s");
-        } else {
-            ret = upd;
-        }
+static void handle_vfr_hud(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #74
+    float airspeed_ms = mavlink_msg_vfr_hud_get_airspeed(&msg);
+    float groundspeed_ms = mavlink_msg_vfr_hud_get_groundspeed(&msg);
+    float alt_MSL_m = mavlink_msg_vfr_hud_get_alt(&msg);
+    float climb_ms = mavlink_msg_vfr_hud_get_climb(&msg);
+    uint16_t throttle_percent = mavlink_msg_vfr_hud_get_throttle(&msg);
+    // --
+    sys->track_flightperf(airspeed_ms, groundspeed_ms, alt_MSL_m, climb_ms, (float) throttle_percent);
+}
 
-    }
+static void handle_command_long(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #76
+    const string fullname = "mission/command_long/";
+    unsigned int target_system = mavlink_msg_command_long_get_target_system(&msg);
+    unsigned int target_component = mavlink_msg_command_long_get_target_component(&msg);
+    unsigned int cmd = mavlink_msg_command_long_get_command(&msg);
+    unsigned int conf = mavlink_msg_command_long_get_confirmation(&msg);
+    float p1 = mavlink_msg_command_long_get_param1(&msg);
+    float p2 = mavlink_msg_command_long_get_param2(&msg);
+    float p3 = mavlink_msg_command_long_get_param3(&msg);
+    float p4 = mavlink_msg_command_long_get_param4(&msg);
+    float p5 = mavlink_msg_command_long_get_param5(&msg);
+    float p6 = mavlink_msg_command_long_get_param6(&msg);
+    float p7 = mavlink_msg_command_long_get_param7(&msg);
+    sys->track_generic_timeseries<unsigned int>(fullname + "target system", target_system);
+    sys->track_generic_timeseries<unsigned int>(fullname + "target component", target_component);
+    sys->track_generic_timeseries<unsigned int>(fullname + "command", cmd, "MAV_CMD enum");
+    sys->track_generic_timeseries<unsigned int>(fullname + "confirmation", conf, "0: first transmission. 1-255: confirm transmissions");
+    sys->track_generic_timeseries<float>(fullname + "param1", p1, "param1 of MAV_CMD enum");
+    sys->track_generic_timeseries<float>(fullname + "param2", p2, "param2 of MAV_CMD enum");
+    sys->track_generic_timeseries<float>(fullname + "param3", p3, "param3 of MAV_CMD enum");
+    sys->track_generic_timeseries<float>(fullname + "param4", p4, "param4 of MAV_CMD enum");
+    sys->track_generic_timeseries<float>(fullname + "param5", p5, "param5 of MAV_CMD enum");
+    sys->track_generic_timeseries<float>(fullname + "param6", p6, "param6 of MAV_CMD enum");
+    sys->track_generic_timeseries<float>(fullname + "param7", p7, "param7 of MAV_CMD enum");
+}
 
-    case MAVLINK_MSG_ID_POSITION_TARGET_GLOBAL_INT: // #87
-    {
-        const string fullname = "mission/pos target global int/";
-        uint32_t time_boot_ms = mavlink_msg_position_target_global_int_get_time_boot_ms(&msg);
-
-        int upd = sys->update_rel_time(time_boot_ms * 1000, allow_time_jumps);
-        if (0 == upd) {
-
-            uint8_t frame = mavlink_msg_position_target_global_int_get_coordinate_frame(&msg);
-            uint16_t typemask = mavlink_msg_position_target_global_int_get_type_mask(&msg);
-            int32_t lat = mavlink_msg_position_target_global_int_get_lat_int(&msg);
-            int32_t lon = mavlink_msg_position_target_global_int_get_lon_int(&msg);
-            float alt = mavlink_msg_position_target_global_int_get_alt(&msg);
-            float v[3];
-            v[0] = mavlink_msg_position_target_global_int_get_vx(&msg);
-            v[1] = mavlink_msg_position_target_global_int_get_vy(&msg);
-            v[2] = mavlink_msg_position_target_global_int_get_vz(&msg);
-            float af[3];
-            af[0] = mavlink_msg_position_target_global_int_get_afx(&msg);
-            af[1] = mavlink_msg_position_target_global_int_get_afy(&msg);
-            af[2] = mavlink_msg_position_target_global_int_get_afz(&msg);
-            float yaw = mavlink_msg_position_target_global_int_get_yaw(&msg);
-            float yaw_rate = mavlink_msg_position_target_global_int_get_yaw_rate(&msg);
-
-            sys->track_generic_timeseries<float>(fullname + "type mask", typemask, "Bitmask to indicate which dimensions should be ignored by the vehicle. If bit 10 is set the floats afx afy afz should be interpreted as force instead of acceleration. Mapping: bit 1: x, bit 2: y, bit 3: z, bit 4: vx, bit 5: vy, bit 6: vz, bit 7: ax, bit 8: ay, bit 9: az, bit 10: is force setpoint, bit 11: yaw, bit 12: yaw rate");
-            sys->track_generic_timeseries<float>(fullname + "speed/vx", v[0], "m/s");
-            sys->track_generic_timeseries<float>(fullname + "speed/vy", v[1], "m/s");
-            sys->track_generic_timeseries<float>(fullname + "speed/vz", v[2], "m/s");
-            sys->track_generic_timeseries<float>(fullname + "accel or force/afx", af[0], "m/s/s");
-            sys->track_generic_timeseries<float>(fullname + "accel or force/afy", af[1], "m/s/s");
-            sys->track_generic_timeseries<float>(fullname + "accel or force/afz", af[2], "m/s/s");
-            sys->track_generic_timeseries<float>(fullname + "lat", lat*1E-7, "WGS84 pos in m");
-            sys->track_generic_timeseries<float>(fullname + "lon", lon*1E-7, "WGS84 pos in m");
-            sys->track_generic_timeseries<float>(fullname + "alt", alt, "m AMSL");
-            sys->track_generic_timeseries<float>(fullname + "yaw", yaw, "rad");
-            sys->track_generic_timeseries<float>(fullname + "yaw rate", yaw_rate, "rad/s");
-            sys->track_generic_timeseries<unsigned int>(fullname + "frame", frame, "MAV_FRAME_GLOBAL_INT = 5, MAV_FRAME_GLOBAL_RELATIVE_ALT_INT = 6, MAV_FRAME_GLOBAL_TERRAIN_ALT_INT = 11");
-        }  else {
-            ret = upd;
-        }
+static void handle_command_ack(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #77
+    unsigned int cmd = mavlink_msg_command_ack_get_command(&msg);
+    unsigned int res = mavlink_msg_command_ack_get_result(&msg);
+    const string fullname = "mission/command ack/";
+    sys->track_generic_timeseries<unsigned int>(fullname + "command", cmd, "MAV_CMD enum");
+    sys->track_generic_timeseries<unsigned int>(fullname + "result", res, "MAV_RESULT enum");
+}
+
+static void handle_attitude_target(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #83
+    const string fullname = "mission/attitude target/";
+    uint32_t time_boot_ms = mavlink_msg_attitude_target_get_time_boot_ms(&msg);        
+    int upd = sys->update_rel_time(time_boot_ms*1000, allow_time_jumps);
+    if (0 == upd) {
+        uint8_t type_mask = mavlink_msg_attitude_target_get_type_mask(&msg);
+        float q[4];
+        mavlink_msg_attitude_target_get_q(&msg, q);
+        float body_rollrate = mavlink_msg_attitude_target_get_body_roll_rate(&msg);
+        float body_pitchrate = mavlink_msg_attitude_target_get_body_pitch_rate(&msg);
+        float body_yawrate = mavlink_msg_attitude_target_get_body_yaw_rate(&msg);
+        float thrust = mavlink_msg_attitude_target_get_thrust(&msg);
+        sys->track_generic_timeseries<unsigned int>(fullname + "type mask", type_mask, "If any of these bits are set, the corresponding input should be ignored: bit 1: body roll rate, bit 2: body pitch rate, bit 3: body yaw rate. bit 4-bit 7: reserved, bit 8: attitude");
+        sys->track_generic_timeseries<float>(fullname + "attitude/q0", q[0], "w");
+        sys->track_generic_timeseries<float>(fullname + "attitude/q1", q[1], "x");
+        sys->track_generic_timeseries<float>(fullname + "attitude/q2", q[2], "y");
+        sys->track_generic_timeseries<float>(fullname + "attitude/q3", q[3], "z");
+        sys->track_generic_timeseries<float>(fullname + "thrust", thrust, "collective, normalized 0..1");
+        sys->track_generic_timeseries<float>(fullname + "rates/roll", body_rollrate, "rad/s");
+        sys->track_generic_timeseries<float>(fullname + "rates/pitch", body_pitchrate, "rad/s");
+        sys->track_generic_timeseries<float>(fullname + "rates/yaw", body_yawrate, "rad/s");
+    } else {
+        ret = upd;
     }
+}
 
-    case MAVLINK_MSG_ID_OPTICAL_FLOW: // #100
-    {
-        const string fullname = "optical flow/";
-        const uint64_t time_usec = mavlink_msg_optical_flow_get_time_usec(&msg);
-        int upd = sys->update_rel_time(time_usec, allow_time_jumps); // treat as relative time
-        if (0 == upd) {
-            const float dist = mavlink_msg_optical_flow_get_ground_distance(&msg);
-            const int16_t fx = mavlink_msg_optical_flow_get_flow_x(&msg);
-            const int16_t fy = mavlink_msg_optical_flow_get_flow_y(&msg);
-            const float flow_comp_m_x = mavlink_msg_optical_flow_get_flow_comp_m_x(&msg);
-            const float flow_comp_m_y = mavlink_msg_optical_flow_get_flow_comp_m_y(&msg);
-            uint8_t quality = mavlink_msg_optical_flow_get_quality(&msg);
-
-            sys->track_generic_timeseries<int>(fullname + "quality", quality, "0:bad, 255:best");
-            sys->track_generic_timeseries<float>(fullname + "distance", dist, "m");
-            sys->track_generic_timeseries<int>(fullname + "flow_x", fx, "px*10");
-            sys->track_generic_timeseries<int>(fullname + "flow_y", fy, "px*10");
-            sys->track_generic_timeseries<float>(fullname + "flow_comp_m_x", flow_comp_m_x, "m/s");
-            sys->track_generic_timeseries<float>(fullname + "flow_comp_m_y", flow_comp_m_y, "m/s");
-        } else {
-            ret = upd;
-        }
+static void handle_position_target_global_int(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #87
+    const string fullname = "mission/pos target global int/";
+    uint32_t time_boot_ms = mavlink_msg_position_target_global_int_get_time_boot_ms(&msg);
+
+    int upd = sys->update_rel_time(time_boot_ms * 1000, allow_time_jumps);
+    if (0 == upd) {
+
+        uint8_t frame = mavlink_msg_position_target_global_int_get_coordinate_frame(&msg);
+        uint16_t typemask = mavlink_msg_position_target_global_int_get_type_mask(&msg);
+        int32_t lat = mavlink_msg_position_target_global_int_get_lat_int(&msg);
+        int32_t lon = mavlink_msg_position_target_global_int_get_lon_int(&msg);
+        float alt = mavlink_msg_position_target_global_int_get_alt(&msg);
+        float v[3];
+        v[0] = mavlink_msg_position_target_global_int_get_vx(&msg);
+        v[1] = mavlink_msg_position_target_global_int_get_vy(&msg);
+        v[2] = mavlink_msg_position_target_global_int_get_vz(&msg);
+        float af[3];
+        af[0] = mavlink_msg_position_target_global_int_get_afx(&msg);
+        af[1] = mavlink_msg_position_target_global_int_get_afy(&msg);
+        af[2] = mavlink_msg_position_target_global_int_get_afz(&msg);
+        float yaw = mavlink_msg_position_target_global_int_get_yaw(&msg);
+        float yaw_rate = mavlink_msg_position_target_global_int_get_yaw_rate(&msg);
+
+        sys->track_generic_timeseries<float>(fullname + "type mask", typemask, "Bitmask to indicate which dimensions should be ignored by the vehicle. If bit 10 is set the floats afx afy afz should be interpreted as force instead of acceleration. Mapping: bit 1: x, bit 2: y, bit 3: z, bit 4: vx, bit 5: vy, bit 6: vz, bit 7: ax, bit 8: ay, bit 9: az, bit 10: is force setpoint, bit 11: yaw, bit 12: yaw rate");
+        sys->track_generic_timeseries<float>(fullname + "speed/vx", v[0], "m/s");
+        sys->track_generic_timeseries<float>(fullname + "speed/vy", v[1], "m/s");
+        sys->track_generic_timeseries<float>(fullname + "speed/vz", v[2], "m/s");
+        sys->track_generic_timeseries<float>(fullname + "accel or force/afx", af[0], "m/s/s");
+        sys->track_generic_timeseries<float>(fullname + "accel or force/afy", af[1], "m/s/s");
+        sys->track_generic_timeseries<float>(fullname + "accel or force/afz", af[2], "m/s/s");
+        sys->track_generic_timeseries<float>(fullname + "lat", lat*1E-7, "WGS84 pos in m");
+        sys->track_generic_timeseries<float>(fullname + "lon", lon*1E-7, "WGS84 pos in m");
+        sys->track_generic_timeseries<float>(fullname + "alt", alt, "m AMSL");
+        sys->track_generic_timeseries<float>(fullname + "yaw", yaw, "rad");
+        sys->track_generic_timeseries<float>(fullname + "yaw rate", yaw_rate, "rad/s");
+        sys->track_generic_timeseries<unsigned int>(fullname + "frame", frame, "MAV_FRAME_GLOBAL_INT = 5, MAV_FRAME_GLOBAL_RELATIVE_ALT_INT = 6, MAV_FRAME_GLOBAL_TERRAIN_ALT_INT = 11");
+    }  else {
+        ret = upd;
     }
-        break;
+}
 
-    case MAVLINK_MSG_ID_RADIO_STATUS: // #109
-    {
-        // local
-        uint8_t  rssi = mavlink_msg_radio_status_get_rssi(&msg);
-        uint8_t  noise = mavlink_msg_radio_status_get_noise(&msg);
-        uint16_t rxerr = mavlink_msg_radio_status_get_rxerrors(&msg);
-        uint16_t rxerr_corrected = mavlink_msg_radio_status_get_fixed(&msg);
-        uint8_t  txbuf_percent = mavlink_msg_radio_status_get_txbuf(&msg);
-        // remote
-        uint8_t  rem_rssi = mavlink_msg_radio_status_get_remrssi(&msg);
-        uint8_t  rem_noise = mavlink_msg_radio_status_get_remnoise(&msg);
-        // --
-        sys->track_radio(rssi, noise, rxerr, rxerr_corrected, txbuf_percent, rem_rssi, rem_noise );
+static void handle_optical_flow(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #100
+    const string fullname = "optical flow/";
+    const uint64_t time_usec = mavlink_msg_optical_flow_get_time_usec(&msg);
+    int upd = sys->update_rel_time(time_usec, allow_time_jumps); // treat as relative time
+    if (0 == upd) {
+        const float dist = mavlink_msg_optical_flow_get_ground_distance(&msg);
+        const int16_t fx = mavlink_msg_optical_flow_get_flow_x(&msg);
+        const int16_t fy = mavlink_msg_optical_flow_get_flow_y(&msg);
+        const float flow_comp_m_x = mavlink_msg_optical_flow_get_flow_comp_m_x(&msg);
+        const float flow_comp_m_y = mavlink_msg_optical_flow_get_flow_comp_m_y(&msg);
+        uint8_t quality = mavlink_msg_optical_flow_get_quality(&msg);
+
+        sys->track_generic_timeseries<int>(fullname + "quality", quality, "0:bad, 255:best");
+        sys->track_generic_timeseries<float>(fullname + "distance", dist, "m");
+        sys->track_generic_timeseries<int>(fullname + "flow_x", fx, "px*10");
+        sys->track_generic_timeseries<int>(fullname + "flow_y", fy, "px*10");
+        sys->track_generic_timeseries<float>(fullname + "flow_comp_m_x", flow_comp_m_x, "m/s");
+        sys->track_generic_timeseries<float>(fullname + "flow_comp_m_y", flow_comp_m_y, "m/s");
+    } else {
+        ret = upd;
     }
-        break;
+}
 
-    case MAVLINK_MSG_ID_HIGHRES_IMU: // #105:
-    {
-        uint64_t timestamp_usec = mavlink_msg_highres_imu_get_time_usec(&msg); // since boot or!! epoch
+static void handle_radio_status(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #109
+    // local
+    uint8_t  rssi = mavlink_msg_radio_status_get_rssi(&msg);
+    uint8_t  noise = mavlink_msg_radio_status_get_noise(&msg);
+    uint16_t rxerr = mavlink_msg_radio_status_get_rxerrors(&msg);
+    uint16_t rxerr_corrected = mavlink_msg_radio_status_get_fixed(&msg);
+    uint8_t  txbuf_percent = mavlink_msg_radio_status_get_txbuf(&msg);
+    // remote
+    uint8_t  rem_rssi = mavlink_msg_radio_status_get_remrssi(&msg);
+    uint8_t  rem_noise = mavlink_msg_radio_status_get_remnoise(&msg);
+    // --
+    sys->track_radio(rssi, noise, rxerr, rxerr_corrected, txbuf_percent, rem_rssi, rem_noise );
+}
 
-        int upd = 0;
-        if (sys->is_absolute_time(timestamp_usec)) {
-            sys->update_time_offset(nowtime_us, timestamp_usec, allow_time_jumps); // OK -- here we establish a reference between boot time and /absolute time
-        } else {
-            upd = sys->update_rel_time(timestamp_usec, allow_time_jumps);
-        }
+static void handle_highres_imu(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #105
+    uint64_t timestamp_usec = mavlink_msg_highres_imu_get_time_usec(&msg); // since boot or!! epoch
 
-        if (0 == upd) {
-
-            float acc_mss[3]; ///< acceleration in m/s/s
-            acc_mss[0] = mavlink_msg_highres_imu_get_xacc(&msg);
-            acc_mss[1] = mavlink_msg_highres_imu_get_yacc(&msg);
-            acc_mss[2] = mavlink_msg_highres_imu_get_zacc(&msg);
-            float gyro_rad[3]; ///< gyro in rad/s
-            gyro_rad[0] = mavlink_msg_highres_imu_get_xgyro(&msg);
-            gyro_rad[1] = mavlink_msg_highres_imu_get_ygyro(&msg);
-            gyro_rad[2] = mavlink_msg_highres_imu_get_zgyro(&msg);
-            float mag_gauss[3]; ///< magnetometer in gauss
-            mag_gauss[0] = mavlink_msg_highres_imu_get_xmag(&msg);
-            mag_gauss[1] = mavlink_msg_highres_imu_get_ymag(&msg);
-            mag_gauss[2] = mavlink_msg_highres_imu_get_zmag(&msg);
-            float abs_press_mbar = mavlink_msg_highres_imu_get_abs_pressure(&msg);
-            float diff_press_mbar = mavlink_msg_highres_imu_get_diff_pressure(&msg);
-            float pressure_alt = mavlink_msg_highres_imu_get_pressure_alt(&msg); // units??
-            float temp_degC = mavlink_msg_highres_imu_get_temperature(&msg);
-            uint16_t updated = mavlink_msg_highres_imu_get_fields_updated(&msg);
-            // --
-            if (updated & (1     )) sys->track_imu_highres_acc(acc_mss); // assuming that y and z are also updated...
-            if (updated & (1 << 3)) sys->track_imu_highres_gyr(gyro_rad); // assuming that y and z are also updated...
-            if (updated & (1 << 6)) sys->track_imu_highres_mag(mag_gauss); // assuming that y and z are also updated...
-            if (updated & (1 << 9)) sys->track_imu_highres_pressabs(abs_press_mbar);
-            if (updated & (1 << 10)) sys->track_imu_highres_pressdiff(diff_press_mbar);
-            if (updated & (1 << 11)) sys->track_imu_highres_pressalt(pressure_alt);
-            if (updated & (1 << 12)) sys->track_imu_highres_temp(temp_degC);
-        } else {
-            ret = upd;
-        }
+    int upd = 0;
+    if (sys->is_absolute_time(timestamp_usec)) {
+        sys->update_time_offset(nowtime_us, timestamp_usec, allow_time_jumps); // OK -- here we establish a reference between boot time and /absolute time
+    } else {
+        upd = sys->update_rel_time(timestamp_usec, allow_time_jumps);
     }
-        break;
 
-    case MAVLINK_MSG_ID_SCALED_IMU2: // #116
-    {
-        uint64_t timestamp_usec = mavlink_msg_raw_imu_get_time_usec(&msg); // OK
+    if (0 == upd) {
+
+        float acc_mss[3]; ///< acceleration in m/s/s
+        acc_mss[0] = mavlink_msg_highres_imu_get_xacc(&msg);
+        acc_mss[1] = mavlink_msg_highres_imu_get_yacc(&msg);
+        acc_mss[2] = mavlink_msg_highres_imu_get_zacc(&msg);
+        float gyro_rad[3]; ///< gyro in rad/s
+        gyro_rad[0] = mavlink_msg_highres_imu_get_xgyro(&msg);
+        gyro_rad[1] = mavlink_msg_highres_imu_get_ygyro(&msg);
+        gyro_rad[2] = mavlink_msg_highres_imu_get_zgyro(&msg);
+        float mag_gauss[3]; ///< magnetometer in gauss
+        mag_gauss[0] = mavlink_msg_highres_imu_get_xmag(&msg);
+        mag_gauss[1] = mavlink_msg_highres_imu_get_ymag(&msg);
+        mag_gauss[2] = mavlink_msg_highres_imu_get_zmag(&msg);
+        float abs_press_mbar = mavlink_msg_highres_imu_get_abs_pressure(&msg);
+        float diff_press_mbar = mavlink_msg_highres_imu_get_diff_pressure(&msg);
+        float pressure_alt = mavlink_msg_highres_imu_get_pressure_alt(&msg); // units??
+        float temp_degC = mavlink_msg_highres_imu_get_temperature(&msg);
+        uint16_t updated = mavlink_msg_highres_imu_get_fields_updated(&msg);
+        // --
+        if (updated & (1     )) sys->track_imu_highres_acc(acc_mss); // assuming that y and z are also updated...
+        if (updated & (1 << 3)) sys->track_imu_highres_gyr(gyro_rad); // assuming that y and z are also updated...
+        if (updated & (1 << 6)) sys->track_imu_highres_mag(mag_gauss); // assuming that y and z are also updated...
+        if (updated & (1 << 9)) sys->track_imu_highres_pressabs(abs_press_mbar);
+        if (updated & (1 << 10)) sys->track_imu_highres_pressdiff(diff_press_mbar);
+        if (updated & (1 << 11)) sys->track_imu_highres_pressalt(pressure_alt);
+        if (updated & (1 << 12)) sys->track_imu_highres_temp(temp_degC);
+    } else {
+        ret = upd;
+    }
+}
 
-        int upd = 0;
-        if (sys->is_absolute_time(timestamp_usec)) {
-            sys->update_time_offset(nowtime_us, timestamp_usec, allow_time_jumps); // OK -- here we establish a reference between boot time and /absolute time
-        } else {
-            upd = sys->update_rel_time(timestamp_usec, allow_time_jumps);
-        }
+static void handle_scaled_imu2(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #116
+    uint64_t timestamp_usec = mavlink_msg_raw_imu_get_time_usec(&msg); // OK
 
-        if (0 == upd) {
-            int16_t acc_mg[3]; ///< acceleration milli-g x-y-z
-            acc_mg[0] = mavlink_msg_raw_imu_get_xacc(&msg);
-            acc_mg[1] = mavlink_msg_raw_imu_get_yacc(&msg);
-            acc_mg[2] = mavlink_msg_raw_imu_get_zacc(&msg);
-            int16_t gyr_mrs[3]; ///< gyro millirad/sec x-y-z
-            gyr_mrs[0] = mavlink_msg_raw_imu_get_xgyro(&msg);
-            gyr_mrs[1] = mavlink_msg_raw_imu_get_ygyro(&msg);
-            gyr_mrs[2] = mavlink_msg_raw_imu_get_zgyro(&msg);
-            int16_t mag_mT[3]; ///< magnetic field, millitesla x-y-z
-            mag_mT[0] = mavlink_msg_raw_imu_get_xmag(&msg);
-            mag_mT[1] = mavlink_msg_raw_imu_get_ymag(&msg);
-            mag_mT[2] = mavlink_msg_raw_imu_get_zmag(&msg);
-            // --
-            sys->track_imu2(acc_mg, gyr_mrs, mag_mT);
-        } else {
-            ret = upd;
-        }
+    int upd = 0;
+    if (sys->is_absolute_time(timestamp_usec)) {
+        sys->update_time_offset(nowtime_us, timestamp_usec, allow_time_jumps); // OK -- here we establish a reference between boot time and /absolute time
+    } else {
+        upd = sys->update_rel_time(timestamp_usec, allow_time_jumps);
     }
-        break;
 
-    case MAVLINK_MSG_ID_POWER_STATUS: // #125
-    {
-        uint16_t Vcc = mavlink_msg_power_status_get_Vcc(&msg);
-        uint16_t Vservo = mavlink_msg_power_status_get_Vservo(&msg);
-        uint16_t flags = mavlink_msg_power_status_get_flags(&msg);
+    if (0 == upd) {
+        int16_t acc_mg[3]; ///< acceleration milli-g x-y-z
+        acc_mg[0] = mavlink_msg_raw_imu_get_xacc(&msg);
+        acc_mg[1] = mavlink_msg_raw_imu_get_yacc(&msg);
+        acc_mg[2] = mavlink_msg_raw_imu_get_zacc(&msg);
+        int16_t gyr_mrs[3]; ///< gyro millirad/sec x-y-z
+        gyr_mrs[0] = mavlink_msg_raw_imu_get_xgyro(&msg);
+        gyr_mrs[1] = mavlink_msg_raw_imu_get_ygyro(&msg);
+        gyr_mrs[2] = mavlink_msg_raw_imu_get_zgyro(&msg);
+        int16_t mag_mT[3]; ///< magnetic field, millitesla x-y-z
+        mag_mT[0] = mavlink_msg_raw_imu_get_xmag(&msg);
+        mag_mT[1] = mavlink_msg_raw_imu_get_ymag(&msg);
+        mag_mT[2] = mavlink_msg_raw_imu_get_zmag(&msg);
         // --
-        sys->track_power(Vcc/1000.f, Vservo/1000.f, flags);
+        sys->track_imu2(acc_mg, gyr_mrs, mag_mT);
+    } else {
+        ret = upd;
     }
-        break;
+}
 
+static void handle_power_status(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #125
+    uint16_t Vcc = mavlink_msg_power_status_get_Vcc(&msg);
+    uint16_t Vservo = mavlink_msg_power_status_get_Vservo(&msg);
+    uint16_t flags = mavlink_msg_power_status_get_flags(&msg);
+    // --
+    sys->track_power(Vcc/1000.f, Vservo/1000.f, flags);
+}
 
-    case MAVLINK_MSG_ID_BATTERY_STATUS: // #147
+static void handle_battery_status(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #147
+    unsigned int id = mavlink_msg_battery_status_get_id(&msg);
+    int bat_rem = mavlink_msg_battery_status_get_battery_remaining(&msg);
+    float bat_cur = mavlink_msg_battery_status_get_current_battery(&msg)/100.; // 10mA -> A
+    float bat_cur_consumed = mavlink_msg_battery_status_get_current_consumed(&msg)/1000.; // mAh -> Ah
+    float bat_energy_consumed = mavlink_msg_battery_status_get_energy_consumed(&msg)/100.; // 100J -> J
+    float v[10];
+    // --
+    const string fullname = "power/battery/";
     {
-        unsigned int id = mavlink_msg_battery_status_get_id(&msg);
-        int bat_rem = mavlink_msg_battery_status_get_battery_remaining(&msg);
-        float bat_cur = mavlink_msg_battery_status_get_current_battery(&msg)/100.; // 10mA -> A
-        float bat_cur_consumed = mavlink_msg_battery_status_get_current_consumed(&msg)/1000.; // mAh -> Ah
-        float bat_energy_consumed = mavlink_msg_battery_status_get_energy_consumed(&msg)/100.; // 100J -> J
-        float v[10];
-        // --
-        const string fullname = "power/battery/";
-        {
-            uint16_t u16v[10];
-            mavlink_msg_battery_status_get_voltages(&msg, u16v);
-            for (unsigned int k=0; k<10; k++) {
-                v[k] = ((float) u16v[k]) / 1000.; // mv (uint) -> V (float)
-                stringstream num;
-                num << k;
-                sys->track_generic_timeseries<unsigned int>(fullname + "volts cell " + num.str(), v[k], "V");
-            }
+        uint16_t u16v[10];
+        mavlink_msg_battery_status_get_voltages(&msg, u16v);
+        for (unsigned int k=0; k<10; k++) {
+            v[k] = ((float) u16v[k]) / 1000.; // mv (uint) -> V (float)
+            stringstream num;
+            num << k;
+            sys->track_generic_timeseries<unsigned int>(fullname + "volts cell " + num.str(), v[k], "V");
         }
-        sys->track_generic_timeseries<float>(fullname + "accu id", id);
-        sys->track_generic_timeseries<int>(fullname + "percent remaining", bat_rem, "%");
-        sys->track_generic_timeseries<float>(fullname + "current", bat_cur, "A");
-        sys->track_generic_timeseries<float>(fullname + "current consumed", bat_cur_consumed, "Ah");
-        sys->track_generic_timeseries<float>(fullname + "energy consumed", bat_energy_consumed, "J");
     }
-        break;
+    sys->track_generic_timeseries<float>(fullname + "accu id", id);
+    sys->track_generic_timeseries<int>(fullname + "percent remaining", bat_rem, "%");
+    sys->track_generic_timeseries<float>(fullname + "current", bat_cur, "A");
+    sys->track_generic_timeseries<float>(fullname + "current consumed", bat_cur_consumed, "Ah");
+    sys->track_generic_timeseries<float>(fullname + "energy consumed", bat_energy_consumed, "J");
+}
 
-    case MAVLINK_MSG_ID_STATUSTEXT: // #253
-    {
-        char text[51]; text[50]=0;
-        mavlink_msg_statustext_get_text(&msg, text);
-        uint8_t severity = mavlink_msg_statustext_get_severity(&msg);
-        // --
-        sys->track_statustext(text, severity);
+static void handle_statustext(MavSystem*const sys, const mavlink_message_t & msg, uint64_t & nowtime_us, bool allow_time_jumps, int & ret) { // #253
+    char text[51]; text[50]=0;
+    mavlink_msg_statustext_get_text(&msg, text);
+    uint8_t severity = mavlink_msg_statustext_get_severity(&msg);
+    // --
+    sys->track_statustext(text, severity);
+}
+
+/*
+ * Handlers by message id. Hook more handlers in here, if you write new ones.
+ */
+typedef struct {
+    unsigned int      msgid;
+    mavlink_handler_f func;
+} mavlink_handler_t;
+
+static const mavlink_handler_t mavlink_handlers[] = {
+    {MAVLINK_MSG_ID_HEARTBEAT, &handle_heartbeat},
+    {MAVLINK_MSG_ID_SYS_STATUS, &handle_sys_status},
+    {MAVLINK_MSG_ID_SYSTEM_TIME, &handle_system_time},
+    {MAVLINK_MSG_ID_SET_MODE, &handle_set_mode},
+    {MAVLINK_MSG_ID_PARAM_REQUEST_READ, &handle_param_request_read},
+    {MAVLINK_MSG_ID_PARAM_REQUEST_LIST, &handle_param_request_list},
+    {MAVLINK_MSG_ID_PARAM_VALUE, &handle_param_value},
+    {MAVLINK_MSG_ID_PARAM_SET, &handle_param_set},
+    {MAVLINK_MSG_ID_GPS_RAW_INT, &handle_gps_raw_int},
+    {MAVLINK_MSG_ID_GPS_STATUS, &handle_gps_status},
+    {MAVLINK_MSG_ID_RAW_IMU, &handle_raw_imu},
+    {MAVLINK_MSG_ID_SCALED_PRESSURE, &handle_scaled_pressure},
+    {MAVLINK_MSG_ID_ATTITUDE, &handle_attitude},
+    {MAVLINK_MSG_ID_LOCAL_POSITION_NED, &handle_local_position_ned},
+    {MAVLINK_MSG_ID_GLOBAL_POSITION_INT, &handle_global_position_int},
+    {MAVLINK_MSG_ID_RC_CHANNELS_SCALED, &handle_rc_channels_scaled},
+    {MAVLINK_MSG_ID_RC_CHANNELS_RAW, &handle_rc_channels_raw},
+    {MAVLINK_MSG_ID_SERVO_OUTPUT_RAW, &handle_servo_output_raw},
+    {MAVLINK_MSG_ID_MISSION_ITEM, &handle_mission_item},
+    {MAVLINK_MSG_ID_MISSION_REQUEST, &handle_mission_request},
+    {MAVLINK_MSG_ID_MISSION_CURRENT, &handle_mission_current},
+    {MAVLINK_MSG_ID_MISSION_COUNT, &handle_mission_count},
+    {MAVLINK_MSG_ID_NAV_CONTROLLER_OUTPUT, &handle_nav_controller_output},
+    {MAVLINK_MSG_ID_REQUEST_DATA_STREAM, &handle_request_data_stream},
+    {MAVLINK_MSG_ID_VFR_HUD, &handle_vfr_hud},
+    {MAVLINK_MSG_ID_COMMAND_LONG, &handle_command_long},
+    {MAVLINK_MSG_ID_COMMAND_ACK, &handle_command_ack},
+    {MAVLINK_MSG_ID_ATTITUDE_TARGET, &handle_attitude_target},
+    {MAVLINK_MSG_ID_POSITION_TARGET_GLOBAL_INT, &handle_position_target_global_int},
+    {MAVLINK_MSG_ID_OPTICAL_FLOW, &handle_optical_flow},
+    {MAVLINK_MSG_ID_RADIO_STATUS, &handle_radio_status},
+    {MAVLINK_MSG_ID_HIGHRES_IMU, &handle_highres_imu},
+    {MAVLINK_MSG_ID_SCALED_IMU2, &handle_scaled_imu2},
+    {MAVLINK_MSG_ID_POWER_STATUS, &handle_power_status},
+    {MAVLINK_MSG_ID_BATTERY_STATUS, &handle_battery_status},
+    {MAVLINK_MSG_ID_STATUSTEXT, &handle_statustext},
+};
+
+/**
+ * @return handler for each msgid, NULL for those which are not interpreted
+ */
+static std::vector<mavlink_handler_f> make_mavlink_dispatch(void) {
+    std::vector<mavlink_handler_f> table;
+    for (unsigned int k = 0; k < sizeof(mavlink_handlers) / sizeof(mavlink_handlers[0]); ++k) {
+        const unsigned int msgid = mavlink_handlers[k].msgid;
+        if (msgid >= table.size()) table.resize(msgid + 1, NULL);
+        table[msgid] = mavlink_handlers[k].func;
     }
-        break;
+    return table;
+}
+
+static const std::vector<mavlink_handler_f> mavlink_dispatch = make_mavlink_dispatch();
 
-    default:
-        // unknown        
-        ignored = true;
-        break;
+bool MavlinkScenario::_is_mavlink_selected(unsigned int msgid) {
+    if (!_topic_filter || !_topic_filter->is_active()) return true;
+    if (msgid >= _mavlink_selected.size()) _mavlink_selected.resize(msgid + 1, 0);
+    if (0 == _mavlink_selected[msgid]) {
+        _mavlink_selected[msgid] = _topic_filter->accepts_topic(MavlinkParser::get_msg_name(msgid)) ? 1 : 2;
     }
+    return 1 == _mavlink_selected[msgid];
+}
 
-    // debug:
-    //log(MSG_DBG, stringbuilder() << "Sys=" << (unsigned int)msg.sysid << ", comp=" << (unsigned int)msg.compid);
+int MavlinkScenario::add_mavlink_message(const mavlink_message_t &msg, bool allow_time_jumps) {
+    /**********************************************************
+     * This is a gateway function. It finds the system and
+     * the handler for the message, and keeps statistics
+     * about what was done with it.
+     **********************************************************/
+    int ret = 0;
+
+    /****************************
+     *  ADD/FIND SYSTEM
+     ****************************/
+    MavSystem* const sys = _get_or_add_system_byid(msg.sysid);    
+    if (!sys) return 0; // ignore; internal error because we could neither find nor add system
 
-    // track link stats
     _n_msgs++; // scenario-wide
-    MavSystem::mavlink_parsed_e whatwasdone = MavSystem::MAVLINK_INTERPRETED;
-    if (ignored) {
-        whatwasdone = MavSystem::MAVLINK_UNINTERPRETED;
+    const unsigned int msglen = msg.len + MAVLINK_NUM_NON_PAYLOAD_BYTES;
+    const mavlink_handler_f handler = msg.msgid < mavlink_dispatch.size() ? mavlink_dispatch[msg.msgid] : NULL;
+    if (handler && !_is_mavlink_selected(msg.msgid)) {
+        // the user does not want it. Not decoded, and time does not move on.
+        sys->track_mavlink(msglen, msg.msgid, MavSystem::MAVLINK_DISABLED);
+        return 0;
+    }
+
+    // FIXME: messages have no timestamps in their header...we need to be creative here
+    uint64_t nowtime_us = sys->get_rel_time() + 1; // to preserve order when no time is given  FIXME: estimate from link rate?
+    sys->update_rel_time(nowtime_us, allow_time_jumps); // if someone knows better below, it can update just again
+
+    // that is a boundary that helps analyzing
+    sys->nextmsg();
+
+    if (!handler) {
         _n_ignored++; // scenario-wide
-        ret = 0; // because return value is only to indicate time jumps.
+        sys->track_mavlink(msglen, msg.msgid, MavSystem::MAVLINK_UNINTERPRETED);
+        return 0; // because return value is only to indicate time jumps.
     }
-    sys->track_mavlink(msg.len + MAVLINK_NUM_NON_PAYLOAD_BYTES, msg.msgid, whatwasdone);
+
+    // translate and forward
+    unsigned long long nsec = 0;
+    if (Profiler::Instance().is_enabled()) {
+        const unsigned long long t0 = Profiler::now_nsec();
+        handler(sys, msg, nowtime_us, allow_time_jumps, ret);
+        nsec = Profiler::now_nsec() - t0;
+    } else {
+        handler(sys, msg, nowtime_us, allow_time_jumps, ret);
+    }
+    sys->track_mavlink(msglen, msg.msgid, MavSystem::MAVLINK_INTERPRETED, nsec);
 
     return ret;
 }
@@ -1122,16 +1261,140 @@ void MavlinkScenario::shift_time(double delay_sec) {
     _time_guess_epoch_usec += udelay;
 }
 
+/**
+ * @brief runs one postprocessor of one system in a worker
+ */
+class PostprocessTask : public QRunnable {
+public:
+    PostprocessTask(MavSystem*sys, unsigned int k) : _sys(sys), _k(k) {}
+    void run(void) { _sys->run_postprocessor(_k); }
+private:
+    MavSystem*   _sys;
+    unsigned int _k;
+};
+
 void MavlinkScenario::process(bool calculate_time_offset) {
+    ProfileScope prof("process");
     /* TODO: here is a bug: if we merge other scenarios into this, and if this was empty before,
      * then _time_guess_epoch_usec is 0. This then overwrites the guess of the systems of the scenario,
      * which is being merged in. Result: When no time info was in the data, it looses its time refernce.
      */
+    if (calculate_time_offset) {
+        for (systemlist::iterator it = _seen_systems.begin(); it != _seen_systems.end(); ++it) {
+            it->second->update_time_offset_guess(0, _time_guess_epoch_usec); // for each system take a guess
+        }
+    }
+
+    // compute more data based on the raw data. Postprocessors of one stage are independent
+    // of each other, and systems are independent anyway -> run each stage in parallel.
+    const unsigned int n_pp = MavSystem::get_num_postprocessors();
+    unsigned int n_stages = 0;
+    for (unsigned int k = 0; k < n_pp; k++) {
+        if (MavSystem::get_postprocessor_stage(k) + 1 > n_stages) n_stages = MavSystem::get_postprocessor_stage(k) + 1;
+    }
+    for (unsigned int stage = 0; stage < n_stages; stage++) {
+        seal_data(); // the postprocessors read the imported series, and those of earlier stages, in parallel
+        std::vector<unsigned int> procs;
+        for (unsigned int k = 0; k < n_pp; k++) {
+            if (MavSystem::get_postprocessor_stage(k) == stage) procs.push_back(k);
+        }
+        if (procs.size() * _seen_systems.size() <= 1) {
+            for (systemlist::iterator it = _seen_systems.begin(); it != _seen_systems.end(); ++it) {
+                for (unsigned int j = 0; j < procs.size(); j++) it->second->run_postprocessor(procs[j]);
+            }
+            continue;
+        }
+        const bool shared = procs.size() > 1; // several postprocessors on the same system
+        TaskGroup tasks;
+        for (systemlist::iterator it = _seen_systems.begin(); it != _seen_systems.end(); ++it) {
+            if (shared) it->second->begin_concurrent();
+            for (unsigned int j = 0; j < procs.size(); j++) {
+                tasks.start(new PostprocessTask(it->second, procs[j]));
+            }
+        }
+        tasks.wait();
+        if (shared) {
+            for (systemlist::iterator it = _seen_systems.begin(); it != _seen_systems.end(); ++it) {
+                it->second->end_concurrent();
+            }
+        }
+    }
+
+    if (calculate_time_offset) {
+        for (systemlist::iterator it = _seen_systems.begin(); it != _seen_systems.end(); ++it) {
+            it->second->determine_absolute_time();
+        }
+    }
+    if (_args && !_args->expressions.empty()) apply_expressions(_args->expressions);
+
+    _apply_storage_policy();
+}
+
+void MavlinkScenario::seal_data(void) {
     for (systemlist::iterator it = _seen_systems.begin(); it != _seen_systems.end(); ++it) {
-        if (calculate_time_offset) it->second->update_time_offset_guess(0, _time_guess_epoch_usec); // for each system take a guess
-        it->second->postprocess(); // compute more data based on the raw data...
-        if (calculate_time_offset) it->second->determine_absolute_time();
+        it->second->seal_data();
+    }
+}
+
+void MavlinkScenario::process_cached(void) {
+    // the cache has no derived series of the user, see ScenarioCache::save()
+    if (_args && !_args->expressions.empty()) apply_expressions(_args->expressions);
+    _apply_storage_policy();
+}
+
+/**
+ * @brief runs a query on one system in a worker
+ */
+class SearchTask : public QRunnable {
+public:
+    SearchTask(MavSystem*sys, const ConditionSearch & q, int & found) : _sys(sys), _q(q), _found(found) {}
+    void run(void) { _found = _sys->apply_search(_q); }
+private:
+    MavSystem*             _sys;
+    const ConditionSearch& _q;
+    int &                  _found;
+};
+
+int MavlinkScenario::search(const std::string & query, std::string & error) {
+    ProfileScope prof("search");
+    ConditionSearch q;
+    if (!q.parse(query)) {
+        error = q.get_error();
+        return -1;
+    }
+    std::vector<int> found(_seen_systems.size(), -1);
+    {
+        TaskGroup tasks;
+        unsigned int k = 0;
+        for (systemlist::iterator it = _seen_systems.begin(); it != _seen_systems.end(); ++it, ++k) {
+            tasks.start(new SearchTask(it->second, q, found[k])); // auto-deleted
+        }
+        tasks.wait();
     }
+    int n = 0;
+    unsigned int n_sys = 0;
+    for (unsigned int k = 0; k < found.size(); ++k) {
+        if (found[k] < 0) continue;
+        n += found[k];
+        ++n_sys;
+    }
+    log(MSG_INFO, stringbuilder() << "Search \"" << query << "\": " << n << " times in " << n_sys << " system(s)");
+    return n;
+}
+
+unsigned int MavlinkScenario::apply_expressions(const std::list<std::string> & definitions) {
+    unsigned int n = 0;
+    for (std::list<std::string>::const_iterator d = definitions.begin(); d != definitions.end(); ++d) {
+        Expression e;
+        if (!e.parse(*d)) {
+            log(MSG_ERR, stringbuilder() << "Derived series \"" << *d << "\": " << e.get_error());
+            continue;
+        }
+        for (systemlist::iterator it = _seen_systems.begin(); it != _seen_systems.end(); ++it) {
+            if (it->second->apply_expression(e)) ++n;
+        }
+    }
+    return n;
 }
 
 void MavlinkScenario::dump_overview(void) {
@@ -1151,6 +1414,10 @@ void MavlinkScenario::dump_overview(ostream& ofs) const {
 
     ofs << ss.str();
     ofs << "Processed " << _n_msgs << " messages." << endl;
+    if (Profiler::Instance().is_enabled()) {
+        ofs << endl;
+        Profiler::Instance().dump(ofs);
+    }
 }
 
 const MavSystem *MavlinkScenario::get_system_byid(uint8_t id) const {
@@ -1160,25 +1427,172 @@ const MavSystem *MavlinkScenario::get_system_byid(uint8_t id) const {
     return sys;
 }
 
+unsigned int MavlinkScenario::get_structure_version(void) const {
+    unsigned int v = _seen_systems.size();
+    for (systemlist::const_iterator it = _seen_systems.begin(); it != _seen_systems.end(); ++it) {
+        v += it->second->get_paths_version();
+    }
+    return v;
+}
+
 bool MavlinkScenario::merge_in(const MavlinkScenario & other) {
-    // for each system in there: see if we have it. If so, merge its data in. Else, copy it.
+    return _merge_from_all(std::vector<MavlinkScenario*>(1, const_cast<MavlinkScenario*>(&other)), false);
+}
+
+bool MavlinkScenario::take_in(MavlinkScenario & other) {
+    return _merge_from_all(std::vector<MavlinkScenario*>(1, &other), true);
+}
+
+bool MavlinkScenario::merge_in_all(const std::vector<const MavlinkScenario*> & others) {
+    std::vector<MavlinkScenario*> list;
+    for (std::vector<const MavlinkScenario*>::const_iterator it = others.begin(); it != others.end(); ++it) {
+        list.push_back(const_cast<MavlinkScenario*>(*it)); // not modified without take
+    }
+    return _merge_from_all(list, false);
+}
+
+bool MavlinkScenario::take_in_all(const std::vector<MavlinkScenario*> & others) {
+    return _merge_from_all(others, true);
+}
+
+bool MavlinkScenario::has_fingerprint(const std::string & fp) const {
+    // the segments "fp#k" sort right behind fp, since '#' is before the hex digits
+    const std::set<std::string>::const_iterator it = _fingerprints.lower_bound(fp);
+    if (it == _fingerprints.end()) return false;
+    return *it == fp || it->compare(0, fp.size() + 1, fp + "#") == 0;
+}
+
+bool MavlinkScenario::_merge_from_all(const std::vector<MavlinkScenario*> & others, bool take) {
+    ProfileScope prof("merge", others.size());
+    // for each system in there: see if we have it. If so, merge the data of all others in at once. Else, copy (or move) the first one.
+    std::map<uint8_t, std::vector<MavSystem*> > bysys;
+    for (std::vector<MavlinkScenario*>::const_iterator its = others.begin(); its != others.end(); ++its) {
+        if (!*its || *its == this) continue;
+        _fingerprints.insert((*its)->_fingerprints.begin(), (*its)->_fingerprints.end());
+        for (systemlist::const_iterator ito = (*its)->_seen_systems.begin(); ito != (*its)->_seen_systems.end(); ++ito) {
+            bysys[ito->first].push_back(ito->second);
+        }
+    }
+
     bool success = true;
-    for (systemlist::const_iterator ito = other._seen_systems.begin(); ito != other._seen_systems.end(); ++ito) {
-        systemlist::iterator mine = _seen_systems.find(ito->first);
+    for (std::map<uint8_t, std::vector<MavSystem*> >::iterator itl = bysys.begin(); itl != bysys.end(); ++itl) {
+        std::vector<MavSystem*> & list = itl->second;
+        systemlist::iterator mine = _seen_systems.find(itl->first);
         if (mine == _seen_systems.end()) {
-            // do not have it, take a copy
-            _seen_systems.insert(_seen_systems.begin(), std::pair<uint8_t,MavSystem*>(ito->first,new MavSystem(ito->second))); ///< copy CTOR
+            // do not have it: move it over, or take a copy
+            MavSystem*const sys = take ? list.front() : new MavSystem(list.front()); ///< copy CTOR
+            mine = _seen_systems.insert(std::pair<uint8_t,MavSystem*>(itl->first, sys)).first;
+            list.erase(list.begin());
+            if (list.empty()) continue;
+        }
+        // do have it, merge!
+        bool ok;
+        if (take) {
+            ok = mine->second->take_in_all(list);
         } else {
-            // do have it, merge!
-            if (!mine->second->merge_in(ito->second)) {
-                log(MSG_ERR, stringbuilder() << "ERROR merging two MavSystems");
-                success = false;
-            }
+            ok = mine->second->merge_in_all(std::vector<const MavSystem*>(list.begin(), list.end()));
+        }
+        if (!ok) {
+            log(MSG_ERR, stringbuilder() << "ERROR merging MavSystems");
+            success = false;
+        }
+        if (take) {
+            for (std::vector<MavSystem*>::iterator it = list.begin(); it != list.end(); ++it) delete *it;
+        }
+    }
+    if (take) {
+        for (std::vector<MavlinkScenario*>::const_iterator its = others.begin(); its != others.end(); ++its) {
+            if (*its && *its != this) (*its)->_seen_systems.clear();
         }
     }
+    _apply_storage_policy();
     return success;
 }
 
+void MavlinkScenario::set_memory_budget(size_t bytes, const std::string & scratch_dir) {
+    _mem_budget = bytes;
+    if (scratch_dir != _scratch_dir && _spill_file) {
+        _spill_file->unref();
+        _spill_file = NULL;
+    }
+    _scratch_dir = scratch_dir;
+}
+
+typedef enum {SPILL_RAW_INPUT=0, SPILL_UNVIEWED, SPILL_VIEWED} spill_rank_e;
+
+/**
+ * @brief a time series which could be spilled, and how dispensable it is. Sorts in the
+ * order in which series leave memory: postprocessor inputs which nobody looked at, then
+ * other series nobody looked at, then those viewed longest ago. Largest first within each.
+ */
+class SpillCandidate {
+public:
+    SpillCandidate(DataTimed*d) : data(d), bytes(d->get_bytes()), viewed(d->get_last_viewed()) {
+        rank = viewed > 0 ? SPILL_VIEWED : (d->is_raw_input() ? SPILL_RAW_INPUT : SPILL_UNVIEWED);
+    }
+    bool operator<(const SpillCandidate & other) const {
+        if (rank != other.rank) return rank < other.rank;
+        if (viewed != other.viewed) return viewed < other.viewed;
+        return bytes > other.bytes;
+    }
+    DataTimed*   data;
+    size_t       bytes;
+    unsigned int viewed;
+    spill_rank_e rank;
+};
+
+void MavlinkScenario::_apply_storage_policy(void) {
+    // no more samples are added, except by merging
+    for (systemlist::iterator it = _seen_systems.begin(); it != _seen_systems.end(); ++it) {
+        it->second->shrink_data();
+    }
+    if (_compress_data) {
+        for (systemlist::iterator it = _seen_systems.begin(); it != _seen_systems.end(); ++it) {
+            it->second->compress_data();
+        }
+    }
+    if (_mem_budget == 0) return;
+
+    size_t total = 0;
+    for (systemlist::const_iterator it = _seen_systems.begin(); it != _seen_systems.end(); ++it) {
+        total += it->second->get_data_bytes();
+    }
+    if (total <= _mem_budget) return;
+
+    if (!_spill_file) {
+        _spill_file = SpillFile::create(_scratch_dir);
+        if (!_spill_file) {
+            log(MSG_ERR, stringbuilder() << "ERROR: data takes " << total/(1024*1024) << " MB, but cannot spill to disk");
+            return;
+        }
+    }
+    // what goes first
+    std::vector<SpillCandidate> cand;
+    for (systemlist::iterator it = _seen_systems.begin(); it != _seen_systems.end(); ++it) {
+        it->second->mark_raw_inputs();
+        std::vector<DataTimed*> series;
+        it->second->get_spill_candidates(series);
+        for (std::vector<DataTimed*>::const_iterator its = series.begin(); its != series.end(); ++its) {
+            cand.push_back(SpillCandidate(*its));
+        }
+    }
+    std::sort(cand.begin(), cand.end());
+
+    size_t freed = 0;
+    unsigned int n = 0, n_raw = 0, n_unviewed = 0;
+    const size_t excess = total - _mem_budget;
+    for (std::vector<SpillCandidate>::const_iterator it = cand.begin(); it != cand.end() && freed < excess; ++it) {
+        if (!it->data->spill(*_spill_file)) continue;
+        freed += it->bytes;
+        n++;
+        if (it->rank == SPILL_RAW_INPUT) n_raw++;
+        if (it->rank != SPILL_VIEWED) n_unviewed++;
+    }
+    log(MSG_INFO, stringbuilder() << "Data took " << total/(1024*1024) << " MB of " << _mem_budget/(1024*1024) << " MB budget; "
+        << n << " data items (" << n_raw << " postprocessor inputs, " << n_unviewed << " never viewed) spilled, now "
+        << _spill_file->get_bytes()/(1024*1024) << " MB in " << _spill_file->get_filename());
+}
+
 std::vector<const MavSystem*> MavlinkScenario::getSystems() const {
     std::vector<const MavSystem*> ret;
     for (systemlist::const_iterator it = _seen_systems.begin(); it != _seen_systems.end(); ++it) {
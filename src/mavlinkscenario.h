@@ -27,6 +27,7 @@
 #define MAVLINKSCENARIO_H
 
 #include <map>
+#include <set>
 #include <inttypes.h>
 #include <fstream>
 #include <ostream>
@@ -34,6 +35,7 @@
 #include "mavsystem.h"
 #include "cmdlineargs.h"
 #include "onboarddata.h"
+#include "topicfilter.h"
 #include "logger.h"
 
 class MavlinkScenario
@@ -60,6 +62,50 @@ public:
      */
     bool add_onboard_message(const OnboardData &msg);
 
+    /**
+     * @brief same as add_onboard_message() for each row, but the columns of messages which
+     * are only tracked are appended to their series at once
+     * @param batch from OnboardLogParser::get_batch()
+     */
+    bool add_onboard_batch(const OnboardBatch & batch);
+
+    /**
+     * @brief call this before feeding messages of an onboard log parser, and call
+     * end_onboard_log() before the parser is deleted. The scenario caches information
+     * per OnboardSchema in between.
+     * @param parsername what OnboardLogParser::get_parser_name() says
+     */
+    void begin_onboard_log(const std::string & parsername);
+    void end_onboard_log(void);
+
+    /**
+     * @brief only fields selected by this filter are added by add_onboard_message(), and only
+     * messages selected by it are decoded by add_mavlink_message(). The others are counted as
+     * MavSystem::MAVLINK_DISABLED.
+     * @param filter NULL=all. Must outlive the onboard log.
+     */
+    void set_topic_filter(const TopicFilter*filter) { _topic_filter = filter; _mavlink_selected.clear(); }
+
+    /**
+     * @brief keep time series compressed after process() and merge_in(). Saves lots of
+     * memory for long logs, at the price of slower access. Default is what the command line says.
+     * Unused capacity of the series is given back there in any case, see MavSystem::shrink_data().
+     */
+    void set_compress_data(bool compress) { _compress_data = compress; }
+    bool get_compress_data(void) const { return _compress_data; }
+
+    /**
+     * @brief when the samples take more memory than this after process() and merge_in(),
+     * time series are moved to a file in scratch_dir, from where the OS pages them in
+     * as needed. First those only read by the postprocessors (see Data::set_raw_input()),
+     * then those never plotted, then those plotted longest ago (see Data::mark_viewed()).
+     * Default is what the command line says.
+     * @param bytes 0=no limit
+     * @param scratch_dir empty=system's temp directory
+     */
+    void set_memory_budget(size_t bytes, const std::string & scratch_dir = std::string());
+    size_t get_memory_budget(void) const { return _mem_budget; }
+
     /**
      * XXX! do not use add_mavlink_message and add_mavlink_message in the same scenario. Rather use
      * two distinct scenarios and merge them using merge_in().
@@ -77,6 +123,34 @@ public:
      */
     void process(bool calculate_time_offset = true);
 
+    /**
+     * @brief for a scenario restored by ScenarioCache instead of parsed: the steps of process()
+     * which depend on the settings rather than on the log
+     */
+    void process_cached(void);
+
+    /**
+     * @brief MavSystem::seal_data() for all systems, e.g., after live samples came in and
+     * before they are read
+     */
+    void seal_data(void);
+
+    /**
+     * @brief compute user-defined series in all systems, see MavSystem::apply_expression().
+     * process() does this with those of the CmdlineArgs. In the given order, such that
+     * later definitions can use earlier ones. Malformed definitions are logged and skipped.
+     * @return number of series computed
+     */
+    unsigned int apply_expressions(const std::list<std::string> & definitions);
+
+    /**
+     * @brief find where a query holds in the systems of this scenario, see ConditionSearch.
+     * Systems are searched in parallel, results go into each system, see MavSystem::apply_search().
+     * @param error set if the query is malformed
+     * @return number of intervals found in all systems, -1 if the query is malformed
+     */
+    int search(const std::string & query, std::string & error);
+
     /**
      * @brief get pointer to mavlink system with systemid=id
      * @param id
@@ -84,6 +158,11 @@ public:
      */
     const MavSystem*get_system_byid(uint8_t id) const;
 
+    /**
+     * @brief changes whenever a system or data is added or removed, see MavSystem::get_paths_version()
+     */
+    unsigned int get_structure_version(void) const;
+
     /**
      * @brief merges data from another class instance into this one
      *        Makes a deep copy of all data contained in other
@@ -92,6 +171,24 @@ public:
      */
     bool merge_in(const MavlinkScenario &other);
 
+    /**
+     * @brief same as merge_in(), but consumes other: systems which this does not have
+     *        are moved over, and data which this does not have is taken instead of copied.
+     *        Only overlapping data is merged the usual way. Other is left empty.
+     */
+    bool take_in(MavlinkScenario &other);
+
+    /**
+     * @brief merge_in() for many scenarios at once. Each data item is merged in a single
+     *        pass over the samples of all others, instead of once per scenario.
+     */
+    bool merge_in_all(const std::vector<const MavlinkScenario*> & others);
+
+    /**
+     * @brief take_in() for many scenarios at once, see merge_in_all(). All others are left empty.
+     */
+    bool take_in_all(const std::vector<MavlinkScenario*> & others);
+
     /**
      * @brief shift all data in scenario by specifed amount of seconds. negative will make the data earlier.
      * @param delay
@@ -129,6 +226,19 @@ public:
     std::string getDescription(void) const { return _desc; }
     void setDescription(const std::string & desc) { _desc = desc; }
 
+    /**
+     * @brief content fingerprints of the log files this scenario was made from, see
+     * ScenarioCache::get_fingerprint(). A scenario demultiplexed from a part of a file
+     * has "<fingerprint>#<segment>" instead. Merging unites them.
+     */
+    void add_fingerprint(const std::string & fp) { if (!fp.empty()) _fingerprints.insert(fp); }
+
+    /**
+     * @return true if made from this file, or from a demultiplexed segment of it
+     */
+    bool has_fingerprint(const std::string & fp) const;
+    const std::set<std::string> & get_fingerprints(void) const { return _fingerprints; }
+
     void setDatabaseID(unsigned long long id) { _dbid = id; _havedb = true;}
     bool getDatabaseID(unsigned long long& id) { id = _dbid; return _havedb; }
 
@@ -139,6 +249,43 @@ public:
 private:
 
     MavSystem* _get_or_add_system_byid(uint8_t id);
+    bool _merge_from_all(const std::vector<MavlinkScenario*> & others, bool take);
+
+    /**
+     * @brief compress and/or spill data as configured, after the data has changed
+     */
+    void _apply_storage_policy(void);
+
+    /**
+     * @return true if the topic filter selects this MavLink message. The answer is cached.
+     */
+    bool _is_mavlink_selected(unsigned int msgid);
+
+    /**
+     * @brief what add_onboard_message needs to know about one type of onboard message.
+     * Built on its first sample, so that later samples need no name lookups.
+     */
+    typedef enum {
+        ONBOARD_GENERIC,
+        ONBOARD_PARM,
+        ONBOARD_GPS,
+        ONBOARD_TIME
+    } onboard_msgkind_e;
+
+    typedef struct onboard_schema_info_s {
+        const OnboardSchema*     schema; ///< NULL = not built, yet
+        onboard_msgkind_e        kind;
+        int                      id_sysid; ///< PARM: SYSID_THISMAV
+        int                      id_fix; ///< GPS: fix type
+        int                      id_week_ms; ///< GPS (APM): TimeMS
+        int                      id_week; ///< GPS (APM): Week
+        int                      id_time; ///< GPS: UTC time, TIME: StartTime, others: timestamp
+        std::vector<std::string> fullnames; ///< by field id: full name of the data. Empty=do not track
+        const MavSystem*         handles_sys; ///< system the handles belong to
+        std::vector<DataTimed*>  handles; ///< by field id: the data of handles_sys. NULL=not looked up, yet
+    } onboard_schema_info_t;
+
+    onboard_schema_info_t & _get_onboard_schema_info(const OnboardSchema*schema);
 
     /********************************************
      *  DATA MEMBERS
@@ -156,6 +303,7 @@ private:
     friend class SystemTableViewModel; // FIXME: this avoids that we can compile w/o GUI
     friend class DataTreeViewModel; // FIXME: this avoids that we can compile w/o GUI
 	friend class DBConnector;
+    friend class ScenarioCache;
 
     // #### temps for onboardparser
     int _onboard_sysid;
@@ -178,7 +326,17 @@ private:
     Logger::logchannel _logchannel;
     std::string _name; ///< descriptive name of the scenario
     std::string _desc; ///< comments on the scenario
+    std::set<std::string> _fingerprints; ///< of the source logs
     std::string _last_onboard_parser;
+    std::vector<onboard_schema_info_t> _onboard_schemas; ///< index=schema id
+    OnboardData _onboard_row; ///< add_onboard_batch(): a row handled like a single message
+    std::vector<double> _onboard_times; ///< add_onboard_batch(): time of each row
+    const TopicFilter* _topic_filter;
+    std::vector<char> _mavlink_selected; ///< by msgid: 0=not asked yet, 1=selected, 2=not
+    bool _compress_data; ///< see set_compress_data()
+    size_t _mem_budget; ///< see set_memory_budget(). 0=no limit
+    std::string _scratch_dir;
+    SpillFile* _spill_file; ///< created when needed
 
     // database
     bool _havedb;
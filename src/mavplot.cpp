@@ -22,7 +22,8 @@
  */
 
 #include <vector>
-#include <sstream>
+#include <map>
+#include <float.h>
 #include <QMessageBox>
 #include <qwt_math.h>
 #include <qwt_scale_engine.h>
@@ -36,60 +37,181 @@
 #include <qwt_scale_draw.h>
 #include <qwt_scale_widget.h>
 #include <QTime>
+#include <QDateTime>
 #include <qmath.h>
 #include "mavplot.h"
+#include "resampler.h"
+#include "mavplotcurve.h"
+#include "mavplotevents.h"
 #include "data_timeseries.h"
 #include "data_event.h"
+#include "vec_fun.h"
+#include "dataexport.h"
 #include "dialogdatadetails.h"
+#include "profiler.h"
 
 using namespace std;
 
+#define TICK_CACHE_MAX 1024          ///< labels kept, see HumanReadableTime
+#define MSEC_PER_DAY   86400000LL
+
 /**
- * @brief labels at x axis as human-readable time
+ * @brief labels at x axis as human-readable time. The offset of local time is found once
+ * per visible range, the time of day is then integer arithmetic. Labels are kept by tick
+ * and granularity, so panning only formats the ticks which came into view.
  */
 class HumanReadableTime: public QwtScaleDraw {
 public:
-    HumanReadableTime(): QwtScaleDraw() {  }
+    typedef enum { GRAN_SEC, GRAN_MSEC } granularity_e;
+
+    HumanReadableTime(): QwtScaleDraw(), _lo(0.), _hi(-1.), _offset_ok(false), _offset_ms(0) {  }
+
     // just override the label formatting
-    virtual QwtText label(double v_sec) const {        
-
-        // isolate only hh:mm:ss:zzzz
-        unsigned long epoch_msec = round(v_sec*1000);
-        QDateTime qdt = QDateTime::fromMSecsSinceEpoch(epoch_msec);
-        QTime daytime(qdt.time());
-        return daytime.toString("hh:mm:ss.zzz");
-    }    
+    virtual QwtText label(double v_sec) const {
+        return format(v_sec, _granularity());
+    }
+
+    /**
+     * @brief isolate only hh:mm:ss, or hh:mm:ss.zzz
+     */
+    QString format(double v_sec, granularity_e gran) const {
+        const qint64 epoch_msec = (qint64) floor(v_sec*1000 + .5);
+        const std::pair<qint64, int> key(epoch_msec, (int)gran);
+        std::map<std::pair<qint64, int>, QString>::const_iterator it = _cache.find(key);
+        if (it != _cache.end()) return it->second;
+
+        _update_offset();
+        qint64 ms_of_day;
+        if (_offset_ok && epoch_msec >= (qint64)floor(_lo*1000) && epoch_msec <= (qint64)ceil(_hi*1000)) {
+            ms_of_day = (epoch_msec + _offset_ms) % MSEC_PER_DAY;
+            if (ms_of_day < 0) ms_of_day += MSEC_PER_DAY;
+        } else {
+            ms_of_day = _ms_of_day(epoch_msec); // outside of the view, or a DST change in it
+        }
+        const int h = (int)(ms_of_day/3600000), m = (int)(ms_of_day/60000 % 60), sec = (int)(ms_of_day/1000 % 60);
+        QString txt = QString("%1:%2:%3").arg(h, 2, 10, QChar('0')).arg(m, 2, 10, QChar('0')).arg(sec, 2, 10, QChar('0'));
+        if (gran == GRAN_MSEC) txt += QString(".%1").arg((int)(ms_of_day % 1000), 3, 10, QChar('0'));
+
+        if (_cache.size() >= TICK_CACHE_MAX) _cache.clear();
+        _cache[key] = txt;
+        return txt;
+    }
+
+private:
+    /**
+     * @brief local time of day, the expensive way
+     */
+    static qint64 _ms_of_day(qint64 epoch_msec) {
+        const QDateTime qdt = QDateTime::fromMSecsSinceEpoch(epoch_msec);
+        return QTime(0, 0).msecsTo(qdt.time());
+    }
+
+    /**
+     * @brief local minus UTC, if it is the same all over the visible range
+     */
+    void _update_offset(void) const {
+        const QwtScaleDiv & div = scaleDiv();
+        const double lo = std::min(div.lowerBound(), div.upperBound());
+        const double hi = std::max(div.lowerBound(), div.upperBound());
+        if (lo == _lo && hi == _hi) return;
+        _lo = lo;
+        _hi = hi;
+        const qint64 ms_lo = (qint64) floor(lo*1000), ms_hi = (qint64) ceil(hi*1000);
+        const qint64 off_lo = _utc_offset(ms_lo), off_hi = _utc_offset(ms_hi);
+        _offset_ok = (off_lo == off_hi);
+        _offset_ms = off_lo;
+    }
+
+    static qint64 _utc_offset(qint64 epoch_msec) {
+        qint64 utc = epoch_msec % MSEC_PER_DAY;
+        if (utc < 0) utc += MSEC_PER_DAY;
+        qint64 off = _ms_of_day(epoch_msec) - utc;
+        // the date may differ
+        if (off > MSEC_PER_DAY/2) off -= MSEC_PER_DAY;
+        if (off < -MSEC_PER_DAY/2) off += MSEC_PER_DAY;
+        return off;
+    }
+
+    /**
+     * @brief milliseconds only if the major ticks need them
+     */
+    granularity_e _granularity(void) const {
+        const QList<double> ticks = scaleDiv().ticks(QwtScaleDiv::MajorTick);
+        for (int k = 0; k < ticks.size(); ++k) {
+            const double ms = ticks[k]*1000;
+            if (fabs(ms - 1000*floor(ms/1000 + .5)) > .5) return GRAN_MSEC;
+        }
+        return GRAN_SEC;
+    }
+
+    // see _update_offset()
+    mutable double _lo;
+    mutable double _hi;
+    mutable bool   _offset_ok;
+    mutable qint64 _offset_ms;
+    mutable std::map<std::pair<qint64, int>, QString> _cache;
 };
 
 QString MavPlot::getReadableTime(double timeval) const {
+    const HumanReadableTime * const hrt = dynamic_cast<const HumanReadableTime *>(axisScaleDraw(QwtPlot::xBottom));
+    if (hrt) return hrt->format(timeval, HumanReadableTime::GRAN_MSEC); // markers want all digits
     QwtText txt = axisScaleDraw(QwtPlot::xBottom)->label(timeval);
     return QString(txt.text());
 }
 
+/**
+ * @brief all data in the plot, series first
+ */
+void MavPlot::_get_all_data(std::vector<const Data*> & data) const {
+    for (dataplotmap::const_iterator it_series = _series.begin(); it_series != _series.end(); ++it_series) {
+        if (it_series->first) data.push_back(it_series->first);
+    }
+    for (annotationsmap::const_iterator it_annot = _annotations.begin(); it_annot != _annotations.end(); ++it_annot) {
+        if (it_annot->first) data.push_back(it_annot->first);
+    }
+}
+
 unsigned int MavPlot::exportCsv(const std::string&filename, bool /* onlyview -> ignored for now*/) {
-    unsigned int n_series = 0;
-    //std::ofstream fout(filename.c_str());
+    std::vector<const Data*> data;
+    _get_all_data(data);
+    return DataExport::csv(data, filename);
+}
 
-    for (dataplotmap::iterator it_series = _series.begin(); it_series != _series.end(); ++it_series) {
-        const Data*const d = it_series->first;
-        if (d) {
-            d->export_csv(filename + "_" + d->get_name() + ".csv");
-            n_series++;
-        }
+unsigned int MavPlot::exportColumnar(const std::string&filename) {
+    std::vector<const Data*> data;
+    _get_all_data(data);
+    return DataExport::columnar(data, filename);
+}
+
+unsigned int MavPlot::exportResampled(const std::string&filename, double rate_hz) {
+    std::vector<const Data*> data;
+    _get_all_data(data);
+    Resampler r;
+    for (std::vector<const Data*>::const_iterator it = data.begin(); it != data.end(); ++it) {
+        r.add(*it); // others are skipped
     }
-    for (annotationsmap::iterator it_annot = _annotations.begin(); it_annot != _annotations.end(); ++it_annot) {
-        const Data*const d = it_annot->first;
-        if (d) {
-            d->export_csv(filename + "_" + d->get_name() + ".csv");
-            n_series++;
-        }
+    if (rate_hz > 0.) {
+        r.set_grid_rate(rate_hz);
+    } else {
+        r.set_grid_union();
     }
+    if (!r.run() || !r.export_csv(filename)) return 0;
+    return r.get_num_series();
+}
 
-    //fout.close();
-    return n_series;
+void MavPlot::set_background_render(bool yes) {
+    _background_render = yes;
+    for (dataplotmap::iterator d = _series.begin(); d != _series.end(); ++d) {
+        MavPlotCurve * const c = dynamic_cast<MavPlotCurve * const>(d->second);
+        if (c) c->set_background_render(yes);
+    }
+    replot();
 }
 
 void MavPlot::apply_print_colors(bool yes) {
+    // the renderer draws on its own, the screen needs one replot after the undo
+    const bool autoreplot = autoReplot();
+    setAutoReplot(false);
     if (yes && !_havePrintColors) {
         const QColor printcol = QColor(0,0,0); // default color: black
         /*******************
@@ -160,7 +282,10 @@ void MavPlot::apply_print_colors(bool yes) {
             axisWidget(QwtPlot::yLeft)->setPalette(_pal_axis_screen);
         }
     }
+    const bool undone = _havePrintColors && !yes;
     _havePrintColors = yes;
+    setAutoReplot(autoreplot);
+    if (undone) replot();
 }
 
 void MavPlot::_updateDataBounds () {
@@ -185,6 +310,7 @@ void MavPlot::_updateDataBounds () {
         }
     }
     _databounds = allrect;
+    emit dataChanged();
 }
 
 // for Qwt >= 6.1
@@ -297,7 +423,7 @@ void MavPlot::onRemoveData(const Data *const d) {
     }
 }
 
-MavPlot::MavPlot(QWidget *parent) : QwtPlot(parent), _havePrintColors(false) {
+MavPlot::MavPlot(QWidget *parent) : QwtPlot(parent), _background_render(false), _havePrintColors(false) {
     setAutoReplot(false);
     setTitle("MAV System Data Plot");
     setCanvasBackground(QColor(Qt::darkGray));
@@ -355,15 +481,6 @@ MavPlot::~MavPlot() {
     // TODO: a lot of cleanup!!!
 }
 
-/**
- * @brief function turning any data into double...it may fail.
- */
-template <typename CT>
-bool MavPlot::_convert2double(CT in, double &ret, double scale) {
-    ret = ((double) in)*scale;
-    return true;
-}
-
 QColor MavPlot::_suggestColor(unsigned int plotnumber) {
     const QList<QColor> cols = QList<QColor>() << QColor(Qt::lightGray) << QColor(Qt::red) << QColor(Qt::green) << QColor(Qt::cyan) << QColor(Qt::yellow) << QColor(Qt::magenta);
 
@@ -379,48 +496,20 @@ QColor MavPlot::_suggestColor(unsigned int plotnumber) {
 template <typename ET>
 std::vector<QwtPlotItem*>* MavPlot::_add_data_event(const DataEvent<ET> * data, unsigned int plotnumber /* used for colors etc */) {
 
+    if (!data) return NULL;
+
     vector <QwtPlotItem*> * markers = new vector <QwtPlotItem*>;
     if (!markers) {
         qDebug() << "Error allocating memory for an event series";
         return NULL;
     }
-    const vector<double> vt = data->get_time();
-    const vector<ET>     vd = data->get_data();
 
-    // relative time -> absolute time
-    double t_datastart = data->get_epoch_datastart()/1E6;
-
-    for (unsigned int k=0; k<data->size(); k++) {
-        QwtPlotMarker * d_marker = new QwtPlotMarker();
-        if (!d_marker) {
-            qDebug() << "Error allocating memory for a marker";
-            continue;
-        }
-        d_marker->setLineStyle(QwtPlotMarker::VLine);
-        d_marker->setLabelAlignment(Qt::AlignRight | Qt::AlignBottom);
-        d_marker->setLinePen(QPen(_suggestColor(plotnumber), 0, Qt::DashDotLine));
-        //d_marker->setSymbol( new QwtSymbol(QwtSymbol::Diamond, QColor(Qt::yellow), QColor(Qt::green), QSize(7,7)));
-        d_marker->setValue(vt[k] + t_datastart, 0.0);
-        d_marker->setLabelOrientation(Qt::Vertical);
-        // try to set label from data
-        stringstream ss;
-        ss << vd[k];
-        QString label(ss.str().c_str()); // that relies on QString to be cool and do some clever conversion
-        d_marker->setLabel(QwtText(label));
-        // --
-        QwtPlotItem*item = dynamic_cast<QwtPlotItem*>(d_marker);
-        if (!item) {
-            delete d_marker;
-            return NULL;
-        }
-        markers->push_back(item);
-        d_marker->attach(this);
-        // add legend entry for first
-        if (markers->size()==1) {
-            d_marker->setTitle(QString::fromStdString(data->get_name()));
-            d_marker->setItemAttribute(QwtPlotItem::Legend);
-        }
-    }       
+    // one item for all events, which draws only those in view. See MavPlotEvents.
+    MavPlotEvents * events = new MavPlotEventsT<ET>(QString::fromStdString(data->get_name()), data);
+    events->setLinePen(QPen(_suggestColor(plotnumber), 0, Qt::DashDotLine));
+    events->setItemAttribute(QwtPlotItem::Legend);
+    events->attach(this);
+    markers->push_back(events);
 
     return markers;
 }
@@ -433,22 +522,19 @@ std::vector<QwtPlotItem*>* MavPlot::_add_data_event(const DataEvent<ET> * data,
 template <typename ST>
 QWT_ABSTRACT_SERIESITEM * MavPlot::_add_data_timeseries(const DataTimeseries<ST> * data, unsigned int plotnumber /* used for colors etc */) {
 
+    if (!data) return NULL;
+
     /*
-     * so we have a timeseries of type ST. We need to "translate" it for the plot, and then add it.
-     * One problem is, that Qwt cannot plot double against float...so we need to "convert" every-
-     * thing to double here.
+     * so we have a timeseries of type ST. Qwt cannot plot double against float, but instead of
+     * converting everything to double here, the curve reads the samples from the series as
+     * needed. It draws only what the pixels can show, see MavPlotCurve.
      */
-    QVector<double> xdata, ydata;
-    if (!data2xyvect(data, xdata, ydata)) {
-        return NULL;
-    }
-
-    QwtPlotCurve *curve = new QwtPlotCurve(QString().fromStdString(data->get_name()));
+    MavPlotCurve *curve = new MavPlotCurveT<ST>(QString().fromStdString(data->get_name()), data);
+    curve->set_background_render(_background_render);
     curve->setRenderHint(QwtPlotItem::RenderAntialiased);
     curve->setPen(QPen(_suggestColor(plotnumber))); // FIXME: offer choices
 
     curve->setLegendAttribute(QwtPlotCurve::LegendShowLine);    
-    curve->setSamples(xdata, ydata); // makes a deep copy
     curve->attach(this);
 
     return dynamic_cast<QWT_ABSTRACT_SERIESITEM *>(curve);
@@ -511,26 +597,42 @@ template <typename ST>
 bool MavPlot::data2xyvect(const DataTimeseries<ST> * data, QVector<double> & xdata, QVector<double> & ydata, double scale) {
     if (!data) return false;
 
-    xdata = QVector<double>::fromStdVector(data->get_time());
-    double t_datastart = data->get_epoch_datastart()/1E6;
-    for (QVector<double>::iterator it = xdata.begin(); it != xdata.end(); ++it ) {
-        // relative time -> absolute time
-        *it += t_datastart;
+    if (data->is_compressed() || data->is_spilled()) {
+        // block by block, the series stays compressed or on disk
+        const size_t n = data->size();
+        xdata.resize(n);
+        ydata.resize(n);
+        std::vector<double> time;
+        std::vector<ST> values;
+        size_t k = 0;
+        for (unsigned int b = 0; b < data->get_num_blocks() && k < n; ++b) {
+            data->get_block(b, time, values);
+            const size_t len = std::min(time.size(), n - k);
+            if (len == 0) continue;
+            vec_to_double(&time[0], len, xdata.data() + k, 1., data->get_epoch_datastart()/1E6);
+            vec_to_double(&values[0], len, ydata.data() + k, scale);
+            k += len;
+        }
+        return true;
     }
 
+    const std::vector<double> & time = data->get_time();
+    const std::vector<ST> & values = data->get_data();
+    const size_t n = std::min(time.size(), values.size());
+    xdata.resize(n);
+    ydata.resize(n);
+    if (n == 0) return true;
+
+    // relative time -> absolute time
+    vec_to_double(&time[0], n, xdata.data(), 1., data->get_epoch_datastart()/1E6);
     // data to double
-    for (typename vector<ST>::const_iterator it = data->get_data().begin(); it != data->get_data().end(); ++it) {
-        double ret;
-        if (!_convert2double(*it, ret, scale)) {
-            qDebug() << "ERROR: cannot convert given data type to double";
-            return false;
-        }
-        ydata.push_back(ret);
-    }
+    vec_to_double(&values[0], n, ydata.data(), scale);
     return true;
 }
 
 bool MavPlot::addData(const Data* data) {
+    data->mark_viewed(); // keeps it in memory, see MavlinkScenario::set_memory_budget()
+
     // first check whether we already have it...
     dataplotmap::iterator it = _series.find(data);
     if (it != _series.end()) return true; // have it already
@@ -564,6 +666,24 @@ bool MavPlot::addData(const Data* data) {
     return false;
 }
 
+void MavPlot::replot() {
+    TraceScope trace("replot");
+    QwtPlot::replot();
+}
+
+void MavPlot::dataAppended(bool follow) {
+    const double oldend = _databounds.right();
+    _updateDataBounds();
+    if (follow && !axisAutoScale(QwtPlot::xBottom) && !_series.empty()) {
+        const QwtInterval i = axisInterval(QwtPlot::xBottom);
+        const double shift = _databounds.right() - i.maxValue();
+        if (i.maxValue() >= oldend && shift > 0.) {
+            setAxisScale(QwtPlot::xBottom, i.minValue() + shift, i.maxValue() + shift);
+        }
+    }
+    replot();
+}
+
 void MavPlot::unset_markerData() {
     _data_marker.detach();
     _data_marker_visible = false;
@@ -591,42 +711,26 @@ void MavPlot::rev_markerData(const Data *const d) {
     const QWT_ABSTRACT_SERIESITEM*s = _get_series(d);
     if (s) {
         // it's a series
-        const QwtPlotCurve *curve = dynamic_cast<const QwtPlotCurve *>(s);
-        if (curve) {
-            for (unsigned int k=0; k<curve->dataSize(); k++) {
-                xy = curve->sample(k);
-                double x = xy.x();
-                if (x < markerx) {
-                    found = true;
-                    markerx_next = x;
-                    value = QString::number(xy.y());
-                } else if (x > markerx) {
-                    break;
-                }
-            }
-
+        const MavPlotCurve *curve = dynamic_cast<const MavPlotCurve *>(s);
+        size_t k;
+        if (curve && curve->prev(markerx, k)) {
+            xy = curve->sample(k);
+            found = true;
+            markerx_next = xy.x();
+            value = QString::number(xy.y());
         }
     }
     // annotation
     std::vector<QwtPlotItem*>*v = _get_annotations(d);
     if (v && !found) {
-        // it's an annotation...we have to go through all of them
-        for (std::vector<QwtPlotItem*>::const_iterator it = v->begin(); it != v->end(); ++it) {
-            // only support marker annotations
-            const QwtPlotMarker * m = dynamic_cast<const QwtPlotMarker*>(*it);
-            if (m) {
-                // we only handle vertical markers
-                if (QwtPlotMarker::VLine == m->lineStyle()) {
-                    xy = m->value();
-                    double x = xy.x();
-                    if (x < markerx) {
-                        found = true;
-                        markerx_next = x;
-                        value = m->label().text();
-                    } else if (x > markerx) {
-                        break;
-                    }
-                }
+        // it's an annotation...the event items look it up
+        for (std::vector<QwtPlotItem*>::const_iterator it = v->begin(); it != v->end() && !found; ++it) {
+            const MavPlotEvents * ev = dynamic_cast<const MavPlotEvents*>(*it);
+            size_t k;
+            if (ev && ev->prev(markerx, k)) {
+                found = true;
+                markerx_next = ev->time(k);
+                value = ev->label(k);
             }
         }
     }
@@ -665,6 +769,13 @@ std::vector<QwtPlotItem*>* MavPlot::_get_annotations(const Data * const d) {
     return ret;
 }
 
+bool MavPlot::_visible_argminmax(const MavPlotCurve * curve, size_t & kmin, size_t & kmax) const {
+    const QwtInterval i = axisInterval(QwtPlot::xBottom);
+    if (curve->argminmax(i.minValue(), i.maxValue(), kmin, kmax)) return true;
+    // nothing in view: all of it
+    return curve->argminmax(-DBL_MAX, DBL_MAX, kmin, kmax);
+}
+
 void MavPlot::setmin_markerData(const Data *const d) {
     if (!d || !_data_marker_visible) return;
     const double markerx = _data_marker.xValue();
@@ -685,18 +796,13 @@ void MavPlot::setmin_markerData(const Data *const d) {
     const QWT_ABSTRACT_SERIESITEM*s = _get_series(d);
     if (s) {
         // it's a series
-        const QwtPlotCurve *curve = dynamic_cast<const QwtPlotCurve *>(s);
-        if (curve) {
-            double minval = 0;
-            for (unsigned int k=0; k<curve->dataSize(); k++) {
-                QPointF xy = curve->sample(k);
-                if (k == 0 || (xy.y() < minval)) {
-                    minval = xy.y();
-                    markerx_next = xy.x();
-                    found = true;
-                }
-            }
-            value = QString::number(minval);
+        const MavPlotCurve *curve = dynamic_cast<const MavPlotCurve *>(s);
+        size_t kmin, kmax;
+        if (curve && _visible_argminmax(curve, kmin, kmax)) {
+            xy = curve->sample(kmin);
+            markerx_next = xy.x();
+            value = QString::number(xy.y());
+            found = true;
         }
     }
 #endif
@@ -732,18 +838,13 @@ void MavPlot::setmax_markerData(const Data *const d) {
     const QWT_ABSTRACT_SERIESITEM*s = _get_series(d);
     if (s) {
         // it's a series
-        const QwtPlotCurve *curve = dynamic_cast<const QwtPlotCurve *>(s);
-        if (curve) {
-            double maxval = 0;
-            for (unsigned int k=0; k<curve->dataSize(); k++) {
-                QPointF xy = curve->sample(k);
-                if (k == 0 || (xy.y() > maxval)) {
-                    maxval = xy.y();
-                    markerx_next = xy.x();
-                    found = true;
-                }
-            }
-            value = QString::number(maxval);
+        const MavPlotCurve *curve = dynamic_cast<const MavPlotCurve *>(s);
+        size_t kmin, kmax;
+        if (curve && _visible_argminmax(curve, kmin, kmax)) {
+            xy = curve->sample(kmax);
+            markerx_next = xy.x();
+            value = QString::number(xy.y());
+            found = true;
         }
     }
 #endif
@@ -779,40 +880,26 @@ void MavPlot::fwd_markerData(const Data *const d) {
     const QWT_ABSTRACT_SERIESITEM*s = _get_series(d);
     if (s) {
         // it's a series
-        const QwtPlotCurve *curve = dynamic_cast<const QwtPlotCurve *>(s);
-        if (curve) {
-            for (unsigned int k=0; k<curve->dataSize(); k++) {
-                xy = curve->sample(k);
-                double x = xy.x();
-                if (x > markerx) {
-                    found = true;
-                    markerx_next = x;
-                    value = QString::number(xy.y());
-                    break;
-                }
-            }
-
+        const MavPlotCurve *curve = dynamic_cast<const MavPlotCurve *>(s);
+        size_t k;
+        if (curve && curve->next(markerx, k)) {
+            xy = curve->sample(k);
+            found = true;
+            markerx_next = xy.x();
+            value = QString::number(xy.y());
         }
     }
     // annotation
     std::vector<QwtPlotItem*>*v = _get_annotations(d);
     if (v && !found) {
-        // it's an annotation...we have to go through all of them
-        for (std::vector<QwtPlotItem*>::const_iterator it = v->begin(); it != v->end(); ++it) {
-            // only support marker annotations
-            const QwtPlotMarker * m = dynamic_cast<const QwtPlotMarker*>(*it);
-            if (m) {
-                // we only handle vertical markers
-                if (QwtPlotMarker::VLine == m->lineStyle()) {
-                    xy = m->value();
-                    double x = xy.x();
-                    if (x > markerx) {
-                        found = true;
-                        markerx_next = x;
-                        value = m->label().text();
-                        break;
-                    }
-                }
+        // it's an annotation...the event items look it up
+        for (std::vector<QwtPlotItem*>::const_iterator it = v->begin(); it != v->end() && !found; ++it) {
+            const MavPlotEvents * ev = dynamic_cast<const MavPlotEvents*>(*it);
+            size_t k;
+            if (ev && ev->next(markerx, k)) {
+                found = true;
+                markerx_next = ev->time(k);
+                value = ev->label(k);
             }
         }
     }
@@ -859,18 +946,13 @@ bool MavPlot::set_markerData(const Data *const d, unsigned long idx) {
     // annotation
     std::vector<QwtPlotItem*>*v = _get_annotations(d);
     if (v && !found) {
-        // it's an annotation...we have to go through all of them
-        if (v->size() > idx) {
-            QwtPlotItem*tmp1 = (*v)[idx];
-            const QwtPlotMarker * m = dynamic_cast<const QwtPlotMarker*>(tmp1);
-            if (m) {
-                // we only handle vertical markers
-                if (QwtPlotMarker::VLine == m->lineStyle()) {
-                    xy = m->value();
-                    markerx = xy.x();
-                    found = true;
-                    value = m->label().text();
-                }
+        // it's an annotation...the event items look it up
+        for (std::vector<QwtPlotItem*>::const_iterator it = v->begin(); it != v->end() && !found; ++it) {
+            const MavPlotEvents * ev = dynamic_cast<const MavPlotEvents*>(*it);
+            if (ev && ev->size() > idx) {
+                markerx = ev->time(idx);
+                found = true;
+                value = ev->label(idx);
             }
         }
     }
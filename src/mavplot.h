@@ -38,6 +38,8 @@
 #include "dialogstats.h"
 #include "mavplotdataitemmodel.h"
 
+class MavPlotCurve;
+
 class MavPlot : public QwtPlot
 {
     Q_OBJECT
@@ -64,6 +66,18 @@ public:
      */
     bool addData(const Data*const data);
 
+    /**
+     * @brief the data in the plot got more samples. The curves read them from the series
+     * anyway, so only the bounds are updated and the plot is redrawn.
+     * @param follow if the view shows the end of the data, it moves along with new samples
+     */
+    void dataAppended(bool follow = true);
+
+    /**
+     * @brief QwtPlot's, as an event for the Tracer
+     */
+    virtual void replot();
+
     /**
      * @brief returns the min/max values over all data in the plot
      * @return a rectangle that is a hull over all data series
@@ -90,6 +104,13 @@ public:
         return _series.size();
     }
 
+    /**
+     * @brief whether the given data is plotted as a series
+     */
+    bool hasData(const Data*const data) const {
+        return _series.find(data) != _series.end();
+    }
+
     QString getReadableTime(double timeval) const;
 
     /**
@@ -110,8 +131,8 @@ public:
     bool set_markerData(const Data * const, unsigned long idx); // jump to index of given row
     void fwd_markerData(const Data * const); // forward marker to next data point of given row
     void rev_markerData(const Data * const); // reverse
-    void setmax_markerData(const Data *const d); // set marker to max of current row
-    void setmin_markerData(const Data *const d); // set marker to min of current row
+    void setmax_markerData(const Data *const d); // set marker to max of current row, in view
+    void setmin_markerData(const Data *const d); // set marker to min of current row, in view
     void unset_markerA();
     void unset_markerB();
     void unset_markerData();
@@ -152,8 +173,32 @@ public:
      * @return number of data series written
      */
     unsigned int exportCsv(const std::string& filename, bool onlyview = false);
+
+    /**
+     * @brief write those data rows into one columnar file, see DataExport
+     * @return number of data series written
+     */
+    unsigned int exportColumnar(const std::string& filename);
+
+    /**
+     * @brief write those data rows as one table on a common time grid, see Resampler
+     * @param rate_hz points per second, or 0 for the time stamps of all series
+     * @return number of data series written
+     */
+    unsigned int exportResampled(const std::string& filename, double rate_hz);
+
+    /**
+     * @brief draw timeseries in background threads, so the GUI stays responsive while
+     * panning many long series. See MavPlotCurve.
+     */
+    void set_background_render(bool yes);
+    bool get_background_render(void) const { return _background_render; }
 signals:
-            
+    /**
+     * @brief data was added, removed or appended to, i.e., get_data_bounds() was updated
+     */
+    void dataChanged(void);
+
 private slots:
     void legendClicked(QwtPlotItem*item);
     void legendClickedNew(const QVariant&, int);
@@ -174,7 +219,14 @@ private:
     std::vector<QwtPlotItem*>* _add_data_event(const DataEvent<ET> * data, unsigned int plotnumber);
 
     QWT_ABSTRACT_SERIESITEM *_get_series(const Data * const d);
+
+    /**
+     * @brief samples of the curve with min and max value in the visible x range, or in all
+     * of it if none is visible
+     */
+    bool _visible_argminmax(const MavPlotCurve * curve, size_t & kmin, size_t & kmax) const;
     std::vector<QwtPlotItem*>* _get_annotations(const Data * const d);
+    void _get_all_data(std::vector<const Data*> & data) const;
 
     /**
      * @brief MavPlot::_updateDataBounds
@@ -182,12 +234,6 @@ private:
      */
     void _updateDataBounds ();
 
-    /**
-     * @brief converty "any" data type to double
-     */
-    template <typename CT>
-    static bool _convert2double(CT in, double &ret, double scale=1.);
-
     /**
      * @brief returns a color to be used for each data, based on the sequence number of the plot
      * @param plotnumber
@@ -251,6 +297,9 @@ private:
     QRectF _databounds;
     ///< available color
 
+    // see set_background_render()
+    bool _background_render;
+
     // for print colors
     bool _havePrintColors;
     QColor _col_legend_screen;
@@ -261,6 +310,7 @@ private:
     QStatusBar*_statusbar;
 
     friend class DialogStats;
+    friend class MavPlotOverview;
 };
 
 #endif // MAVPLOT_H
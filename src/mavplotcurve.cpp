@@ -0,0 +1,294 @@
+/**
+ * @file mavplotcurve.cpp
+ * @brief Plot curve of a DataTimeseries, which draws only what can be seen
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <math.h>
+#include <algorithm>
+#include <QPainter>
+#include <QPaintDevice>
+#include <QImage>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThreadPool>
+#include <qwt_painter.h>
+#include <qwt_plot.h>
+#include <qwt_scale_map.h>
+#include "mavplotcurve.h"
+
+#define TILE_PAGES      3       ///< width of an image, in views
+#define TILE_MAX_WIDTH  8192    ///< pixels, limits the memory of an image
+
+/**
+ * @brief everything an image depends on, besides the x range
+ */
+typedef struct {
+    double ppu;             ///< pixels per x unit
+    double ys1, ys2, yp1, yp2;
+    int    top, height;     ///< canvas rows
+    QPen   pen;
+    int    style;
+    double scale;
+    size_t n;               ///< samples, changes when data is loaded
+} tile_key_t;
+
+static bool _same_key(const tile_key_t & a, const tile_key_t & b) {
+    return fabs(a.ppu - b.ppu) <= 1E-9*fabs(a.ppu) && // panning recomputes it
+           a.ys1 == b.ys1 && a.ys2 == b.ys2 && a.yp1 == b.yp1 && a.yp2 == b.yp2 &&
+           a.top == b.top && a.height == b.height && a.pen == b.pen && a.style == b.style &&
+           a.scale == b.scale && a.n == b.n;
+}
+
+/**
+ * @brief the image of a curve, and the one being drawn. Shared by the curve and its jobs,
+ * the last one deletes it.
+ */
+class MavPlotTiles {
+public:
+    explicit MavPlotTiles(const MavPlotCurve * c) : curve(c), refs(1), valid(false), t0(0.), t1(0.),
+        pending(false), pt0(0.), pt1(0.) {}
+
+    void unref(void) {
+        bool last;
+        {
+            QMutexLocker lock(&mutex);
+            last = (--refs == 0);
+        }
+        if (last) delete this;
+    }
+
+    QMutex render_mutex;        ///< held by a job while it draws, such that the curve stays
+    QMutex mutex;               ///< for all below
+    const MavPlotCurve * curve; ///< NULL once the curve is gone
+    int refs;
+
+    // the image which is done
+    bool       valid;
+    tile_key_t key;
+    QImage     image;
+    double     t0, t1;          ///< x range of it
+
+    // the image which is being drawn
+    bool       pending;
+    tile_key_t pkey;
+    double     pt0, pt1;
+};
+
+/**
+ * @brief draws one image of a curve in the global thread pool, then has the plot replot
+ */
+class MavPlotTileJob : public QRunnable {
+public:
+    MavPlotTileJob(MavPlotTiles * tiles, const tile_key_t & key, double t0, double t1, const QwtScaleMap & yMap) :
+        _tiles(tiles), _key(key), _t0(t0), _t1(t1), _yMap(yMap) {}
+
+    void run() {
+        {
+            QMutexLocker rlock(&_tiles->render_mutex);
+            if (_wanted() && _draw()) {
+                QMutexLocker lock(&_tiles->mutex);
+                if (_tiles->curve && _tiles->pending && _same_key(_tiles->pkey, _key) && _tiles->pt0 == _t0) {
+                    _tiles->image = _image;
+                    _tiles->key = _key;
+                    _tiles->t0 = _t0;
+                    _tiles->t1 = _t1;
+                    _tiles->valid = true;
+                    _tiles->pending = false;
+                    QwtPlot*const plot = _tiles->curve->plot();
+                    if (plot) QMetaObject::invokeMethod(plot, "replot", Qt::QueuedConnection);
+                }
+            }
+        }
+        _tiles->unref();
+    }
+
+private:
+    /// @brief false if the curve is gone, or another image is wanted by now
+    bool _wanted(void) const {
+        QMutexLocker lock(&_tiles->mutex);
+        return _tiles->curve && _tiles->pending && _same_key(_tiles->pkey, _key) && _tiles->pt0 == _t0;
+    }
+
+    /// @brief caller holds render_mutex, so the curve cannot go away
+    bool _draw(void) {
+        const MavPlotCurve*const curve = _tiles->curve;
+        const int width = (int) ceil((_t1 - _t0)*_key.ppu);
+        if (width < 1 || _key.height < 1 || curve->dataSize() == 0) return false;
+
+        _image = QImage(width, _key.height, QImage::Format_ARGB32_Premultiplied);
+        _image.fill(0); // transparent
+        QPainter painter(&_image);
+        painter.setRenderHint(QPainter::Antialiasing, curve->testRenderHint(QwtPlotItem::RenderAntialiased));
+        painter.translate(0, -_key.top); // image rows are those of the canvas
+
+        _t1 = _t0 + width/_key.ppu; // whole pixels
+        QwtScaleMap xMap;
+        xMap.setPaintInterval(0, width);
+        xMap.setScaleInterval(_t0, _t1);
+        curve->_drawDirect(&painter, xMap, _yMap, QRectF(0, _key.top, width, _key.height), 0, curve->dataSize() - 1);
+        return true;
+    }
+
+    MavPlotTiles*const _tiles;
+    const tile_key_t   _key;
+    const double       _t0;
+    double             _t1;
+    const QwtScaleMap  _yMap;
+    QImage             _image;
+};
+
+MavPlotCurve::~MavPlotCurve() {
+    set_background_render(false);
+}
+
+void MavPlotCurve::set_background_render(bool yes) {
+    if (yes && !_tiles) {
+        _tiles = new MavPlotTiles(this);
+    } else if (!yes && _tiles) {
+        MavPlotTiles*const t = _tiles;
+        _tiles = NULL;
+        {
+            // waits for a job which is drawing right now
+            QMutexLocker rlock(&t->render_mutex);
+            QMutexLocker lock(&t->mutex);
+            t->curve = NULL;
+        }
+        t->unref();
+    }
+}
+
+void MavPlotCurve::drawSeries(QPainter *painter, const QwtScaleMap &xMap, const QwtScaleMap &yMap,
+                              const QRectF &canvasRect, int from, int to) const {
+    if (!_tiles || !_drawTiled(painter, xMap, yMap, canvasRect, from, to)) {
+        _drawDirect(painter, xMap, yMap, canvasRect, from, to);
+    }
+}
+
+bool MavPlotCurve::_drawTiled(QPainter *painter, const QwtScaleMap &xMap, const QwtScaleMap &yMap,
+                              const QRectF &canvasRect, int from, int to) const {
+    // images only on screen; print and PDF get the real thing
+    const int dev = painter->device() ? painter->device()->devType() : 0;
+    if (dev != QInternal::Widget && dev != QInternal::Pixmap && dev != QInternal::Image) return false;
+    if (painter->combinedTransform().isScaling()) return false; // e.g. MavPlotRenderer, images are for the screen
+    if (!(xMap.p2() > xMap.p1()) || !(xMap.s2() > xMap.s1()) || dataSize() == 0) return false;
+
+    tile_key_t key;
+    key.ppu = (xMap.p2() - xMap.p1()) / (xMap.s2() - xMap.s1());
+    key.ys1 = yMap.s1();
+    key.ys2 = yMap.s2();
+    key.yp1 = yMap.p1();
+    key.yp2 = yMap.p2();
+    key.top = (int) floor(canvasRect.top());
+    key.height = (int) ceil(canvasRect.bottom()) - key.top;
+    key.pen = pen();
+    key.style = style();
+    key.scale = _scale;
+    key.n = dataSize();
+
+    const double vx0 = xMap.s1(), vx1 = xMap.s2();
+    QImage image;
+    double t0 = 0., t1 = 0.;
+    bool have;
+    {
+        QMutexLocker lock(&_tiles->mutex);
+        have = _tiles->valid && _same_key(_tiles->key, key);
+        if (have) {
+            image = _tiles->image; // implicitly shared
+            t0 = _tiles->t0;
+            t1 = _tiles->t1;
+        } else {
+            _tiles->valid = false;
+            _tiles->image = QImage(); // that memory is of no use anymore
+        }
+        const bool covered = have && t0 <= vx0 && t1 >= vx1;
+        const bool coming = _tiles->pending && _same_key(_tiles->pkey, key) && _tiles->pt0 <= vx0 && _tiles->pt1 >= vx1;
+        if (!covered && !coming) {
+            // centered on the view, as wide as allowed
+            const double w = std::min((double)TILE_PAGES*(vx1 - vx0), TILE_MAX_WIDTH/key.ppu);
+            const double margin = 0.5*(w - (vx1 - vx0));
+            _tiles->pending = true;
+            _tiles->pkey = key;
+            _tiles->pt0 = vx0 - margin;
+            _tiles->pt1 = vx1 + margin;
+            _tiles->refs++;
+            QThreadPool::globalInstance()->start(new MavPlotTileJob(_tiles, key, _tiles->pt0, _tiles->pt1, yMap));
+        }
+    }
+    if (!have) return false;
+
+    const double c0 = std::max(vx0, t0), c1 = std::min(vx1, t1);
+    if (!(c1 > c0)) return false;
+
+    // the part we have...
+    const QRectF src((c0 - t0)*key.ppu, 0, (c1 - c0)*key.ppu, image.height());
+    const QRectF dst(xMap.transform(c0), key.top, (c1 - c0)*key.ppu, image.height());
+    painter->drawImage(dst, image, src);
+
+    // ...and the strips which came into view since
+    for (int side = 0; side < 2; ++side) {
+        const double s0 = side ? c1 : vx0;
+        const double s1 = side ? vx1 : c0;
+        if (!(s1 > s0)) continue;
+        QwtScaleMap stripMap(xMap);
+        stripMap.setScaleInterval(s0, s1);
+        stripMap.setPaintInterval(xMap.transform(s0), xMap.transform(s1));
+        painter->save();
+        painter->setClipRect(QRectF(stripMap.p1(), canvasRect.top(), stripMap.p2() - stripMap.p1(), canvasRect.height()), Qt::IntersectClip);
+        _drawDirect(painter, stripMap, yMap, canvasRect, from, to);
+        painter->restore();
+    }
+    return true;
+}
+
+void MavPlotCurve::_drawDirect(QPainter *painter, const QwtScaleMap &xMap, const QwtScaleMap &yMap,
+                               const QRectF &canvasRect, int from, int to) const {
+    const double pixels = fabs(xMap.p2() - xMap.p1());
+    const double x0 = std::min(xMap.s1(), xMap.s2());
+    const double x1 = std::max(xMap.s1(), xMap.s2());
+    if (style() != QwtPlotCurve::Lines || pixels < 1. || !(x1 > x0)) {
+        QwtPlotCurve::drawSeries(painter, xMap, yMap, canvasRect, from, to);
+        return;
+    }
+
+    // as many columns as the device has pixels, which differ from the painter's on paper
+    double device_pixels = pixels*fabs(painter->combinedTransform().m11());
+    const QPaintDevice*const dev = painter->device();
+    if (dev && dev->logicalDpiX() > PRINT_MAX_DPI) device_pixels *= (double)PRINT_MAX_DPI/dev->logicalDpiX();
+
+    // one column more on each side, so the curve enters and leaves the canvas
+    const unsigned int columns = std::max(1u, (unsigned int) ceil(device_pixels));
+    const double dx = (x1 - x0) / columns;
+    QPolygonF points;
+    if (!_summarize(x0 - dx, x1 + dx, columns + 2, points)) {
+        QwtPlotCurve::drawSeries(painter, xMap, yMap, canvasRect, from, to);
+        return;
+    }
+    if (points.empty()) return;
+
+    for (int k = 0; k < points.size(); ++k) {
+        points[k] = QPointF(xMap.transform(points[k].x()), yMap.transform(points[k].y()));
+    }
+    painter->save();
+    painter->setPen(pen());
+    QwtPainter::drawPolyline(painter, points);
+    painter->restore();
+}
@@ -0,0 +1,277 @@
+/**
+ * @file mavplotcurve.h
+ * @brief Plot curve of a DataTimeseries, which draws only what can be seen
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef MAVPLOTCURVE_H
+#define MAVPLOTCURVE_H
+
+#include <vector>
+#include <algorithm>
+#include <math.h>
+#include <QPolygonF>
+#include <qwt_plot_curve.h>
+#include <qwt_series_data.h>
+#include "data_timeseries.h"
+
+#define PRINT_MAX_DPI 300 ///< curves are not decimated finer on paper. The eye cannot tell, the file only grows.
+
+class MavPlotTiles;
+
+/**
+ * @brief The samples of a DataTimeseries as Qwt wants them, read directly from the
+ * series: no copy, and no memory of its own. Time gets the epoch offset of the data,
+ * and values are scaled. Compressed or spilled series stay so (see get_data()).
+ */
+template <typename T>
+class DataSeriesAdapter : public QwtSeriesData<QPointF>
+{
+public:
+    explicit DataSeriesAdapter(const DataTimeseries<T> * data) : _data(data), _scale(1.0) {}
+
+    void set_scale(double scale) { _scale = scale; }
+
+    // implements QwtSeriesData::size()
+    size_t size() const { return _data ? _data->size() : 0; }
+
+    // implements QwtSeriesData::sample()
+    QPointF sample(size_t i) const {
+        double t;
+        T val;
+        if (!_data || !_data->get_data(i, t, val)) return QPointF();
+        return QPointF(t + _data->get_epoch_datastart()/1E6, _scale*val);
+    }
+
+    // implements QwtSeriesData::boundingRect(), from what the series knows anyway
+    QRectF boundingRect() const {
+        if (!_data || _data->size() == 0) return QRectF(1.0, 1.0, -2.0, -2.0); // invalid, as Qwt does it
+        const double offset = _data->get_epoch_datastart()/1E6;
+        const double y0 = _scale*_data->get_min(), y1 = _scale*_data->get_max();
+        return QRectF(_data->get_min_time() + offset, std::min(y0, y1),
+                      _data->get_max_time() - _data->get_min_time(), fabs(y1 - y0));
+    }
+
+private:
+    const DataTimeseries<T> * _data;
+    double _scale;
+};
+
+/**
+ * @brief A curve which, when there are more samples in view than pixel columns, draws
+ * only first/min/max/last of each column. Those come from the pyramid of the series
+ * (DataTimeseries::get_summary()), so each zoom or pan costs O(columns log n) instead of
+ * O(n). The samples of the curve itself stay complete, such that markers see exact values.
+ * They are read from the series itself, see DataSeriesAdapter.
+ *
+ * With background rendering, the curve is drawn into an image a few pages wider than
+ * the view by a thread of the global pool. Replots blit that image, such that panning
+ * costs only the strip which was not in it yet. A new image is made when the view leaves
+ * it, or when zoom, y axis, pen or data changed. Until then the curve is drawn directly.
+ */
+class MavPlotCurve : public QwtPlotCurve
+{
+public:
+    explicit MavPlotCurve(const QString & title) : QwtPlotCurve(title), _scale(1.0), _tiles(NULL) {}
+    ~MavPlotCurve();
+
+    /**
+     * @brief draw into images in a background thread, which are reused while panning
+     */
+    void set_background_render(bool yes);
+    bool get_background_render(void) const { return _tiles != NULL; }
+
+    /**
+     * @brief index of the first sample after x, or the last before x, for stepping a cursor
+     * @param x as in the plot
+     * @return false if there is none
+     */
+    virtual bool next(double x, size_t & k) const = 0;
+    virtual bool prev(double x, size_t & k) const = 0;
+
+    /**
+     * @brief indices of the smallest and the largest sample in [x0, x1]
+     * @return false if there are no samples in there
+     */
+    virtual bool argminmax(double x0, double x1, size_t & kmin, size_t & kmax) const = 0;
+
+    /**
+     * @brief the factor the values are multiplied with when drawn
+     */
+    virtual void set_scale(double scale) { _scale = scale; }
+    double get_scale(void) const { return _scale; }
+
+    /**
+     * @brief coarse polyline through all samples, a few points per column, for MavPlotOverview.
+     * From the pyramid; compressed series only give the value range of each block, and are
+     * not decoded. Blocks of spilled series which would have to be read are left out.
+     */
+    virtual void get_overview(unsigned int columns, QPolygonF & points) const = 0;
+
+protected:
+    // overrides QwtPlotCurve::drawSeries()
+    virtual void drawSeries(QPainter *painter, const QwtScaleMap &xMap, const QwtScaleMap &yMap,
+                            const QRectF &canvasRect, int from, int to) const;
+
+    /**
+     * @brief decimated polyline of the samples in [x0, x1], in plot coordinates
+     * @param columns number of pixel columns
+     * @param points result
+     * @return false if the samples shall be drawn as they are
+     */
+    virtual bool _summarize(double x0, double x1, unsigned int columns, QPolygonF & points) const = 0;
+
+    double _scale;
+
+private:
+    friend class MavPlotTileJob;
+
+    /**
+     * @brief what drawSeries() does without background rendering. Also called by its thread,
+     * so it must not change the curve.
+     */
+    void _drawDirect(QPainter *painter, const QwtScaleMap &xMap, const QwtScaleMap &yMap,
+                     const QRectF &canvasRect, int from, int to) const;
+
+    /**
+     * @brief blit the image, draw what it lacks, and order a new one if needed
+     * @return false if there was no image for this view, so it must be drawn directly
+     */
+    bool _drawTiled(QPainter *painter, const QwtScaleMap &xMap, const QwtScaleMap &yMap,
+                    const QRectF &canvasRect, int from, int to) const;
+
+    MavPlotTiles * _tiles; ///< NULL=no background rendering. Shared with the running job.
+};
+
+template <typename T>
+class MavPlotCurveT : public MavPlotCurve
+{
+public:
+    MavPlotCurveT(const QString & title, const DataTimeseries<T> * data) : MavPlotCurve(title), _data(data) {
+        _adapter = new DataSeriesAdapter<T>(data);
+        setData(_adapter); // curve owns it
+    }
+
+    ~MavPlotCurveT() {
+        set_background_render(false); // before _summarize() is gone
+    }
+
+    void set_scale(double scale) {
+        MavPlotCurve::set_scale(scale);
+        _adapter->set_scale(scale);
+    }
+
+    bool next(double x, size_t & k) const {
+        unsigned int idx;
+        if (!_data || !_data->get_index_after(x - _data->get_epoch_datastart()/1E6, idx)) return false;
+        k = idx;
+        return true;
+    }
+
+    bool prev(double x, size_t & k) const {
+        unsigned int idx;
+        if (!_data || !_data->get_index_before(x - _data->get_epoch_datastart()/1E6, idx)) return false;
+        k = idx;
+        return true;
+    }
+
+    bool argminmax(double x0, double x1, size_t & kmin, size_t & kmax) const {
+        unsigned int imin, imax;
+        const double offset = _data ? _data->get_epoch_datastart()/1E6 : 0.;
+        if (!_data || !_data->get_argminmax(x0 - offset, x1 - offset, imin, imax)) return false;
+        // negative scale swaps them
+        kmin = (_scale < 0.) ? imax : imin;
+        kmax = (_scale < 0.) ? imin : imax;
+        return true;
+    }
+
+    void get_overview(unsigned int columns, QPolygonF & points) const {
+        points.clear();
+        if (!_data || _data->size() == 0 || columns == 0) return;
+        const double offset = _data->get_epoch_datastart()/1E6;
+        if (!_data->is_compressed() && !_data->is_spilled()) {
+            std::vector<typename DataTimeseries<T>::lod_bucket> buckets;
+            if (_data->get_summary(_data->get_min_time(), _data->get_max_time(), columns, buckets)) {
+                _append_buckets(buckets, offset, points);
+            }
+            return;
+        }
+        // value range of each block, from its header
+        const unsigned int nb = _data->get_num_blocks();
+        points.reserve(2*nb);
+        for (unsigned int b = 0; b < nb; ++b) {
+            double tf, tl;
+            T vmin, vmax;
+            if (!_data->get_block_summary(b, tf, tl, vmin, vmax)) continue;
+            const double tm = 0.5*(tf + tl) + offset;
+            points << QPointF(tm, _scale*vmin) << QPointF(tm, _scale*vmax);
+        }
+    }
+
+protected:
+    bool _summarize(double x0, double x1, unsigned int columns, QPolygonF & points) const {
+        if (!_data) return false;
+        const double offset = _data->get_epoch_datastart()/1E6;
+        if (_data->is_compressed() || _data->is_spilled()) {
+            // step signals can be drawn by their changes, which skips the blocks without any
+            std::vector<double> time;
+            std::vector<T> values;
+            if (_data->get_corners(x0 - offset, x1 - offset, 4*columns, time, values)) {
+                points.clear();
+                points.reserve(time.size());
+                for (size_t k = 0; k < time.size(); ++k) {
+                    points << QPointF(time[k] + offset, _scale*values[k]);
+                }
+                return true;
+            }
+        }
+        std::vector<typename DataTimeseries<T>::lod_bucket> buckets; // one per column, not kept: called by two threads
+        if (!_data->get_summary(x0 - offset, x1 - offset, columns, buckets)) return false;
+
+        unsigned long n = 0;
+        for (typename std::vector<typename DataTimeseries<T>::lod_bucket>::const_iterator it = buckets.begin(); it != buckets.end(); ++it) {
+            n += it->n;
+        }
+        if (n <= 4*buckets.size()) return false; // nothing to save
+
+        points.clear();
+        _append_buckets(buckets, offset, points);
+        return true;
+    }
+
+private:
+    void _append_buckets(const std::vector<typename DataTimeseries<T>::lod_bucket> & buckets, double offset, QPolygonF & points) const {
+        points.reserve(points.size() + 4*buckets.size());
+        for (typename std::vector<typename DataTimeseries<T>::lod_bucket>::const_iterator it = buckets.begin(); it != buckets.end(); ++it) {
+            const double tf = it->t_first + offset, tl = it->t_last + offset;
+            points << QPointF(tf, _scale*it->first);
+            if (it->n > 2) {
+                const double tm = 0.5*(tf + tl);
+                points << QPointF(tm, _scale*it->min) << QPointF(tm, _scale*it->max);
+            }
+            if (it->n > 1) points << QPointF(tl, _scale*it->last);
+        }
+    }
+
+    const DataTimeseries<T> * _data;
+    DataSeriesAdapter<T> * _adapter;
+};
+
+#endif // MAVPLOTCURVE_H
@@ -0,0 +1,123 @@
+/**
+ * @file mavplotevents.cpp
+ * @brief Plot item which draws all events of a DataEvent at once
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <math.h>
+#include <QPainter>
+#include <QFontMetrics>
+#include <qwt_painter.h>
+#include <qwt_scale_map.h>
+#if (QWT_VERSION >= QWT_VERSION_CHECK(6,1,0))
+    #include <qwt_graphic.h>
+#endif
+#include "mavplotevents.h"
+
+#define EVENT_LABEL_PAD 2   ///< pixels between line and label, and from the bottom
+
+MavPlotEvents::MavPlotEvents(const QString & title) : QwtPlotItem(QwtText(title)) {
+    setZ(30.); // above curves, as QwtPlotMarker
+}
+
+void MavPlotEvents::setLinePen(const QPen & pen) {
+    if (pen == _pen) return;
+    _pen = pen;
+    #if (QWT_VERSION >= QWT_VERSION_CHECK(6,1,0))
+        legendChanged();
+    #endif
+    itemChanged();
+}
+
+bool MavPlotEvents::next(double x, size_t & k) const {
+    k = _lower_bound(x);
+    while (k < size() && !(time(k) > x)) ++k; // those exactly at x
+    return k < size();
+}
+
+bool MavPlotEvents::prev(double x, size_t & k) const {
+    k = _lower_bound(x);
+    if (k == 0) return false;
+    --k;
+    return true;
+}
+
+void MavPlotEvents::draw(QPainter *painter, const QwtScaleMap &xMap, const QwtScaleMap &/*yMap*/, const QRectF &canvasRect) const {
+    const size_t n = size();
+    if (n == 0) return;
+
+    const double x0 = std::min(xMap.s1(), xMap.s2());
+    const double x1 = std::max(xMap.s1(), xMap.s2());
+    const QFontMetrics fm(painter->font());
+    const double spacing = fm.height(); // labels are vertical, so that is what one needs
+
+    painter->save();
+    painter->setPen(_pen);
+
+    /*
+     * groups of events closer than spacing. Each is drawn when the next one starts,
+     * as a line at its first event and the label of that, plus how many more there are.
+     */
+    size_t first = _lower_bound(x0);
+    double px_first = 0.;
+    size_t in_group = 0;
+    for (size_t k = first; k <= n; ++k) {
+        const bool more = k < n && time(k) <= x1;
+        const double px = more ? xMap.transform(time(k)) : 0.;
+        if (in_group > 0 && (!more || fabs(px - px_first) >= spacing)) {
+            // the group is complete
+            QwtPainter::drawLine(painter, px_first, canvasRect.top(), px_first, canvasRect.bottom());
+            QString txt = label(first);
+            if (in_group > 1) txt += QString(" (+%1)").arg(in_group - 1);
+            painter->save();
+            painter->translate(px_first + EVENT_LABEL_PAD, canvasRect.bottom() - EVENT_LABEL_PAD);
+            painter->rotate(-90.);
+            painter->drawText(QPointF(0., fm.ascent()), txt);
+            painter->restore();
+            in_group = 0;
+        }
+        if (!more) break;
+        if (in_group == 0) {
+            first = k;
+            px_first = px;
+        }
+        in_group++;
+    }
+    painter->restore();
+}
+
+#if (QWT_VERSION < QWT_VERSION_CHECK(6,1,0))
+void MavPlotEvents::drawLegendIdentifier(QPainter *painter, const QRectF &rect) const {
+    painter->save();
+    painter->setPen(_pen);
+    QwtPainter::drawLine(painter, rect.center().x(), rect.top(), rect.center().x(), rect.bottom());
+    painter->restore();
+}
+#else
+QwtGraphic MavPlotEvents::legendIcon(int /*index*/, const QSizeF &size) const {
+    QwtGraphic icon;
+    icon.setDefaultSize(size);
+    if (size.isEmpty()) return icon;
+    QPainter painter(&icon);
+    painter.setPen(_pen);
+    QwtPainter::drawLine(&painter, 0.5*size.width(), 0., 0.5*size.width(), size.height());
+    return icon;
+}
+#endif
@@ -0,0 +1,124 @@
+/**
+ * @file mavplotevents.h
+ * @brief Plot item which draws all events of a DataEvent at once
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef MAVPLOTEVENTS_H
+#define MAVPLOTEVENTS_H
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <QPen>
+#include <QString>
+#include <qwt_plot_item.h>
+#include "qwt_compat.h"
+#include "data_event.h"
+
+/**
+ * @brief All events of one DataEvent as vertical lines with labels, in one plot item.
+ * Replots look only at the events in view. Events which are closer on screen than a line
+ * of text are drawn as one, labelled with the first and the number of others. Labels are
+ * made only for what is drawn.
+ */
+class MavPlotEvents : public QwtPlotItem
+{
+public:
+    explicit MavPlotEvents(const QString & title);
+
+    // overrides QwtPlotItem::rtti()
+    int rtti() const { return QwtPlotItem::Rtti_PlotUserItem + 1; }
+
+    void setLinePen(const QPen & pen);
+    const QPen & linePen(void) const { return _pen; }
+
+    /**
+     * @brief number of events
+     */
+    virtual size_t size(void) const = 0;
+
+    /**
+     * @brief time of event k, as in the plot
+     */
+    virtual double time(size_t k) const = 0;
+
+    /**
+     * @brief label of event k
+     */
+    virtual QString label(size_t k) const = 0;
+
+    /**
+     * @brief index of the first event after x, or the last before x
+     * @return false if there is none
+     */
+    bool next(double x, size_t & k) const;
+    bool prev(double x, size_t & k) const;
+
+    // overrides QwtPlotItem::draw()
+    void draw(QPainter *painter, const QwtScaleMap &xMap, const QwtScaleMap &yMap, const QRectF &canvasRect) const;
+
+#if (QWT_VERSION < QWT_VERSION_CHECK(6,1,0))
+    // overrides QwtLegendItemManager::drawLegendIdentifier()
+    void drawLegendIdentifier(QPainter *painter, const QRectF &rect) const;
+#else
+    // overrides QwtPlotItem::legendIcon()
+    QwtGraphic legendIcon(int index, const QSizeF &size) const;
+#endif
+
+protected:
+    /**
+     * @brief index of the first event at or after time x
+     */
+    virtual size_t _lower_bound(double x) const = 0;
+
+private:
+    QPen _pen;
+};
+
+template <typename ET>
+class MavPlotEventsT : public MavPlotEvents
+{
+public:
+    MavPlotEventsT(const QString & title, const DataEvent<ET> * data) : MavPlotEvents(title), _data(data) {}
+
+    size_t size(void) const { return _data ? _data->size() : 0; }
+
+    double time(size_t k) const { return _data->get_time()[k] + _offset(); }
+
+    QString label(size_t k) const { return _to_label(_data->get_elem(k)); }
+
+protected:
+    size_t _lower_bound(double x) const {
+        if (!_data) return 0;
+        const std::vector<double> & vt = _data->get_time(); // DataEvent keeps that sorted
+        return std::lower_bound(vt.begin(), vt.end(), x - _offset()) - vt.begin();
+    }
+
+private:
+    double _offset(void) const { return _data->get_epoch_datastart()/1E6; }
+
+    static QString _to_label(const std::string & s) { return QString::fromStdString(s); }
+    static QString _to_label(bool b) { return QString::number(b ? 1 : 0); }
+
+    const DataEvent<ET> * _data;
+};
+
+#endif // MAVPLOTEVENTS_H
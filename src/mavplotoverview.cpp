@@ -0,0 +1,181 @@
+/**
+ * @file mavplotoverview.cpp
+ * @brief All curves of a plot in a thin strip at low resolution, for navigating long logs.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <QMouseEvent>
+#include <qwt_scale_widget.h>
+#include "mavplotoverview.h"
+#include "mavplot.h"
+#include "mavplotcurve.h"
+#include "qwt_compat.h"
+
+#define OVERVIEW_HEIGHT 40   ///< pixels
+#define OVERVIEW_CLICK_PX 3  ///< a drag which is shorter is a click
+
+MavPlotOverview::MavPlotOverview(const MavPlot * plot, QWidget * parent) :
+    QWidget(parent), _plot(plot), _stale(true), _x0(0.), _x1(0.), _preview(false),
+    _preview_x0(0.), _preview_x1(0.), _dragging(false), _press_px(0), _drag_px(0)
+{
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+    connect(_plot, SIGNAL(dataChanged()), this, SLOT(onDataChanged()));
+    // the mark follows zoom, pan and scroll bar, whoever moves the view
+    connect(_plot->axisWidget(QwtPlot::xBottom), SIGNAL(scaleDivChanged()), this, SLOT(update()));
+}
+
+QSize MavPlotOverview::sizeHint() const {
+    return QSize(200, OVERVIEW_HEIGHT);
+}
+
+void MavPlotOverview::set_preview(double x0, double x1) {
+    _preview = true;
+    _preview_x0 = x0;
+    _preview_x1 = x1;
+    update();
+}
+
+void MavPlotOverview::clear_preview(void) {
+    if (!_preview) return;
+    _preview = false;
+    update();
+}
+
+void MavPlotOverview::onDataChanged(void) {
+    _stale = true;
+    update();
+}
+
+void MavPlotOverview::resizeEvent(QResizeEvent * event) {
+    QWidget::resizeEvent(event);
+    _stale = true;
+}
+
+double MavPlotOverview::_toX(int px) const {
+    if (width() < 1) return _x0;
+    return _x0 + (px + .5)*(_x1 - _x0)/width();
+}
+
+int MavPlotOverview::_toPx(double x) const {
+    if (!(_x1 > _x0)) return 0;
+    return (int)((x - _x0)/(_x1 - _x0)*width());
+}
+
+void MavPlotOverview::_render(void) {
+    _stale = false;
+    const QRectF & bounds = _plot->get_data_bounds();
+    _x0 = bounds.left();
+    _x1 = bounds.right();
+
+    const int w = std::max(1, width()), h = std::max(1, height());
+    _image = QPixmap(w, h);
+    _image.fill(_plot->canvasBackground().color());
+    if (!(_x1 > _x0)) return;
+
+    QPainter painter(&_image);
+    painter.setRenderHint(QPainter::Antialiasing, false);
+    const double sx = w/(_x1 - _x0);
+    QPolygonF points;
+    for (MavPlot::dataplotmap::const_iterator s = _plot->_series.begin(); s != _plot->_series.end(); ++s) {
+        const MavPlotCurve * const curve = dynamic_cast<const MavPlotCurve *>(s->second);
+        if (!curve || !curve->isVisible()) continue;
+        curve->get_overview((unsigned int)w, points);
+        if (points.empty()) continue;
+
+        // each curve gets the full height, else small signals are flat lines next to large ones
+        double ymin = points[0].y(), ymax = ymin;
+        for (int k = 1; k < points.size(); ++k) {
+            ymin = std::min(ymin, points[k].y());
+            ymax = std::max(ymax, points[k].y());
+        }
+        const double sy = (ymax > ymin) ? (h - 3)/(ymax - ymin) : 0.;
+        const double yc = (ymax > ymin) ? 0. : .5*(h - 3);
+        for (int k = 0; k < points.size(); ++k) {
+            points[k] = QPointF((points[k].x() - _x0)*sx, h - 2 - yc - (points[k].y() - ymin)*sy);
+        }
+        painter.setPen(QPen(curve->pen().color(), 1));
+        painter.drawPolyline(points);
+    }
+}
+
+void MavPlotOverview::paintEvent(QPaintEvent * /*event*/) {
+    if (_stale || _image.size() != size()) _render();
+    QPainter painter(this);
+    painter.drawPixmap(0, 0, _image);
+    if (!(_x1 > _x0)) return;
+
+    // the view, or what it will be
+    double v0, v1;
+    if (_dragging) {
+        v0 = _toX(std::min(_press_px, _drag_px));
+        v1 = _toX(std::max(_press_px, _drag_px));
+    } else if (_preview) {
+        v0 = _preview_x0;
+        v1 = _preview_x1;
+    } else {
+        const QwtInterval i = _plot->axisInterval(QwtPlot::xBottom);
+        v0 = i.minValue();
+        v1 = i.maxValue();
+    }
+    const int p0 = std::max(0, _toPx(v0)), p1 = std::min(width() - 1, std::max(p0 + 1, _toPx(v1)));
+    QColor fill = palette().color(QPalette::Highlight);
+    fill.setAlpha(60);
+    painter.fillRect(QRect(p0, 0, p1 - p0, height()), fill);
+    painter.setPen(palette().color(QPalette::Highlight));
+    painter.drawRect(QRect(p0, 0, p1 - p0, height() - 1));
+}
+
+void MavPlotOverview::mousePressEvent(QMouseEvent * event) {
+    if (event->button() != Qt::LeftButton) {
+        QWidget::mousePressEvent(event);
+        return;
+    }
+    _dragging = true;
+    _press_px = _drag_px = event->pos().x();
+}
+
+void MavPlotOverview::mouseMoveEvent(QMouseEvent * event) {
+    if (!_dragging) return;
+    _drag_px = std::max(0, std::min(width() - 1, event->pos().x()));
+    update();
+}
+
+void MavPlotOverview::mouseReleaseEvent(QMouseEvent * event) {
+    if (!_dragging || event->button() != Qt::LeftButton) return;
+    _dragging = false;
+    _drag_px = std::max(0, std::min(width() - 1, event->pos().x()));
+    update();
+    if (!(_x1 > _x0)) return;
+
+    if (abs(_drag_px - _press_px) < OVERVIEW_CLICK_PX) {
+        // jump there, same zoom
+        const QwtInterval i = _plot->axisInterval(QwtPlot::xBottom);
+        const double half = .5*(i.maxValue() - i.minValue());
+        const double x = _toX(_press_px);
+        emit viewSelected(x - half, x + half);
+    } else {
+        emit viewSelected(_toX(std::min(_press_px, _drag_px)), _toX(std::max(_press_px, _drag_px)));
+    }
+}
@@ -0,0 +1,100 @@
+/**
+ * @file mavplotoverview.h
+ * @brief All curves of a plot in a thin strip at low resolution, for navigating long logs.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+
+#ifndef MAVPLOTOVERVIEW_H
+#define MAVPLOTOVERVIEW_H
+
+#include <QWidget>
+#include <QPixmap>
+
+class MavPlot;
+
+/**
+ * @brief The whole time range of a MavPlot, with the part in view marked. The curves are
+ * drawn once from their summaries (MavPlotCurve::get_overview()), each scaled to the
+ * height of the strip, and kept in an image until the data of the plot changes. Moving
+ * the view only redraws the mark.
+ *
+ * A click centers the view there, dragging selects the part to show. Neither sets the
+ * view itself; see viewSelected().
+ */
+class MavPlotOverview : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit MavPlotOverview(const MavPlot * plot, QWidget * parent = 0);
+
+    QSize sizeHint() const;
+
+    /**
+     * @brief mark [x0, x1] instead of the view, e.g., while the scroll bar is dragged
+     */
+    void set_preview(double x0, double x1);
+    void clear_preview(void);
+
+signals:
+    /**
+     * @brief the user wants to see [x0, x1], in plot coordinates
+     */
+    void viewSelected(double x0, double x1);
+
+protected:
+    void paintEvent(QPaintEvent * event);
+    void resizeEvent(QResizeEvent * event);
+    void mousePressEvent(QMouseEvent * event);
+    void mouseMoveEvent(QMouseEvent * event);
+    void mouseReleaseEvent(QMouseEvent * event);
+
+private slots:
+    void onDataChanged(void);
+
+private:
+    /**
+     * @brief draw the curves into _image
+     */
+    void _render(void);
+
+    /**
+     * @brief pixel column <-> plot x, over the bounds _image was drawn for
+     */
+    double _toX(int px) const;
+    int _toPx(double x) const;
+
+    /****************************************
+     *   DATA MEMBERS
+     ****************************************/
+    const MavPlot * _plot;
+    QPixmap         _image;
+    bool            _stale;    ///< _image must be drawn again
+    double          _x0;       ///< range of _image
+    double          _x1;
+    bool            _preview;  ///< see set_preview()
+    double          _preview_x0;
+    double          _preview_x1;
+    bool            _dragging; ///< mouse button is down
+    int             _press_px;
+    int             _drag_px;
+};
+
+#endif // MAVPLOTOVERVIEW_H
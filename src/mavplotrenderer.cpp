@@ -0,0 +1,104 @@
+/**
+ * @file mavplotrenderer.cpp
+ * @brief Print and export of a MavPlot at the resolution of the paper, with dense curves as image.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <math.h>
+#include <algorithm>
+#include <QPainter>
+#include <QPaintDevice>
+#include <QImage>
+#include <qwt_plot.h>
+#include <qwt_plot_item.h>
+#include "mavplotrenderer.h"
+#include "mavplotcurve.h"
+
+#define RASTER_DENSE_POINTS 200000   ///< more points than this on the canvas are drawn as image
+#define RASTER_MAX_PIXELS   (16<<20) ///< limits the memory of the image
+
+MavPlotRenderer::MavPlotRenderer(raster_e raster, unsigned int dpi) : _raster(raster), _dpi(dpi) {
+    if (_dpi < 1) _dpi = PRINT_MAX_DPI;
+}
+
+bool MavPlotRenderer::parse_raster(const std::string & s, raster_e & raster) {
+    if (s == "never") {
+        raster = RASTER_NEVER;
+    } else if (s == "dense") {
+        raster = RASTER_DENSE;
+    } else if (s == "always") {
+        raster = RASTER_ALWAYS;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool MavPlotRenderer::_is_dense(const QwtPlot * plot, double columns) {
+    // a decimated curve has up to four points per column, see MavPlotCurve
+    const double most = 4.*std::max(1., columns);
+    double n = 0.;
+    const QwtPlotItemList & items = plot->itemList(QwtPlotItem::Rtti_PlotCurve);
+    for (QwtPlotItemList::const_iterator it = items.begin(); it != items.end(); ++it) {
+        const QwtPlotCurve * const c = dynamic_cast<const QwtPlotCurve *>(*it);
+        if (!c || !c->isVisible()) continue;
+        n += std::min((double)c->dataSize(), most);
+    }
+    return n > RASTER_DENSE_POINTS;
+}
+
+void MavPlotRenderer::renderCanvas(const QwtPlot * plot, QPainter * painter, const QRectF & canvasRect,
+                                   const QwtScaleMap * maps) const {
+    const QPaintDevice * const dev = painter->device();
+    const int type = dev ? dev->devType() : 0;
+    const double dpi = dev ? dev->logicalDpiX() : 0.;
+    const QRectF devRect = painter->combinedTransform().mapRect(canvasRect);
+
+    // images are pixels anyway
+    bool raster = (type != QInternal::Image && type != QInternal::Pixmap && type != QInternal::Widget && dpi >= 1.);
+    if (raster) {
+        if (_raster == RASTER_NEVER) {
+            raster = false;
+        } else if (_raster == RASTER_DENSE) {
+            raster = _is_dense(plot, devRect.width()*std::min(1., PRINT_MAX_DPI/dpi));
+        }
+    }
+    const double f = raster ? std::min(1., _dpi/dpi) : 0.; ///< image pixels per device pixel
+    const int w = (int) ceil(devRect.width()*f), h = (int) ceil(devRect.height()*f);
+    if (!raster || w < 1 || h < 1 || w > RASTER_MAX_PIXELS/h) {
+        QwtPlotRenderer::renderCanvas(plot, painter, canvasRect, maps);
+        return;
+    }
+
+    QImage image(w, h, QImage::Format_ARGB32_Premultiplied);
+    image.fill(0); // transparent, the background is up to the flags
+    const int dpm = (int) (std::min(dpi, (double)_dpi)/0.0254);
+    image.setDotsPerMeterX(dpm);
+    image.setDotsPerMeterY(dpm);
+    {
+        // same coordinates as the canvas on the painter, same maps
+        QPainter ip(&image);
+        ip.setRenderHints(painter->renderHints());
+        ip.scale(w/canvasRect.width(), h/canvasRect.height());
+        ip.translate(-canvasRect.left(), -canvasRect.top());
+        QwtPlotRenderer::renderCanvas(plot, &ip, canvasRect, maps);
+    }
+    painter->drawImage(canvasRect, image);
+}
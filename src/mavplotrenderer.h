@@ -0,0 +1,73 @@
+/**
+ * @file mavplotrenderer.h
+ * @brief Print and export of a MavPlot at the resolution of the paper, with dense curves as image.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+
+#ifndef MAVPLOTRENDERER_H
+#define MAVPLOTRENDERER_H
+
+#include <string>
+#include <qwt_plot_renderer.h>
+
+/**
+ * @brief A QwtPlotRenderer for print, PDF, SVG and PS. The curves are decimated anyway
+ * (see MavPlotCurve), to the pixels of the device but at most PRINT_MAX_DPI. Dense canvases
+ * can additionally be drawn into an image of the given resolution, which is put into the
+ * document as one: title, axes, labels and legend stay vectors, but the file does not grow
+ * with the number of curves.
+ */
+class MavPlotRenderer : public QwtPlotRenderer
+{
+public:
+    typedef enum {
+        RASTER_NEVER,  ///< all vectors
+        RASTER_DENSE,  ///< the canvas, if it has many points
+        RASTER_ALWAYS  ///< the canvas
+    } raster_e;
+
+    explicit MavPlotRenderer(raster_e raster = RASTER_DENSE, unsigned int dpi = 300);
+
+    /**
+     * @brief "never", "dense" or "always"
+     * @return false if none of them
+     */
+    static bool parse_raster(const std::string & s, raster_e & raster);
+
+    // overrides QwtPlotRenderer::renderCanvas()
+    void renderCanvas(const QwtPlot * plot, QPainter * painter, const QRectF & canvasRect,
+                      const QwtScaleMap * maps) const;
+
+private:
+    /**
+     * @brief whether the curves would have more than RASTER_DENSE_POINTS points as vectors
+     * @param columns width of the canvas in device pixels
+     */
+    static bool _is_dense(const QwtPlot * plot, double columns);
+
+    /****************************************
+     *   DATA MEMBERS
+     ****************************************/
+    raster_e     _raster;
+    unsigned int _dpi;
+};
+
+#endif // MAVPLOTRENDERER_H
@@ -25,20 +25,32 @@
 #include <iostream>
 #include <cassert>
 #include <sstream>
+#include <iomanip>
 #include <string>
 #include <time.h>
 #include <math.h>
+#include <algorithm>
+#include <set>
+#include <cstring>
+#include <QRegExp>
+#include <QString>
 #include "mavsystem.h"
 #include "mavlink.h"
 #include "stringfun.h"
 #include "datagroup.h"
 #include "data_event.h"
 #include "data_timeseries.h"
+#include "data_cursor.h"
 #include "data_param.h"
 #include "treeitem.h"
 #include "time_fun.h"
 #include "mavsystem_macros.h"
 #include "logger.h"
+#include "profiler.h"
+#include "mavlinkparser.h"
+#include "expression.h"
+#include "resampler.h"
+#include "conditionsearch.h"
 
 using namespace std;
 
@@ -48,6 +60,7 @@ using namespace std;
 
 #define RAD2DEG(x) x*(180./M_PI)
 #define DEG2RAD(x) (x*M_PI/180.)
+#define MAVSYSTEM_TOP_MSGSTATS 5 ///< message types listed in the overview
 
 inline double angle360 (double x) {
     if (isnan(x) || isinf(x)) return x;
@@ -60,6 +73,8 @@ inline double angle360 (double x) {
  *      CLASS FUNCTIONS
  *********************************************/
 
+QAtomicInt MavSystem::_num_slots(0);
+
 void MavSystem::_defaults() {    
     mavtype_str = "unknown";
     aptype_str = "unknown";
@@ -72,12 +87,19 @@ void MavSystem::_defaults() {
     _time_offset_guess_usec = 0;
     _time_maxfwdjump_sec = 100.;
     _time_maxbackjump_sec = 5.;
+    _time_lastjump_sec = 0.;
     _have_time_update = false;
     _mavlink_summary._link_throughput_bytes = 0;
     _mavlink_summary.num_uninterpreted = 0;
     _mavlink_summary.num_received = 0;
     _mavlink_summary.num_interpreted = 0;
+    _mavlink_summary.num_disabled = 0;
     _mavlink_summary.num_error = 0;
+    _paths_version = 0;
+    _pp_from_sec = 0.;
+#ifdef WITH_DATAREGEX
+    _query_version = (unsigned int) -1;
+#endif
 
     stringstream logname;
     logname << "log_mavsystem_" << id;
@@ -85,6 +107,35 @@ void MavSystem::_defaults() {
     deferredLoad = false;        
 }
 
+/**
+ * @return lines about the MavLink message types which took most time to interpret,
+ * or were the most frequent ones if no times were measured
+ */
+std::string MavSystem::_describe_msgstats(void) const {
+    const std::map<unsigned int, mavlink_msgstat_t> & stats = _mavlink_summary.msgstats;
+    bool timed = false;
+    for (std::map<unsigned int, mavlink_msgstat_t>::const_iterator it = stats.begin(); it != stats.end(); ++it) {
+        if (it->second.nsec > 0) timed = true;
+    }
+    std::vector<std::pair<unsigned long long, unsigned int> > order;
+    for (std::map<unsigned int, mavlink_msgstat_t>::const_iterator it = stats.begin(); it != stats.end(); ++it) {
+        order.push_back(std::make_pair(timed ? it->second.nsec : it->second.count, it->first));
+    }
+    std::sort(order.rbegin(), order.rend());
+
+    stringstream ss;
+    if (order.empty()) return ss.str();
+    ss << "   - " << (timed ? "most time spent in:" : "most frequent:");
+    for (unsigned int k = 0; k < order.size() && k < MAVSYSTEM_TOP_MSGSTATS; ++k) {
+        const mavlink_msgstat_t & st = stats.find(order[k].second)->second;
+        ss << " " << MavlinkParser::get_msg_name(order[k].second) << " (" << st.count;
+        if (timed) ss << ", " << fixed << setprecision(1) << st.nsec / 1E6 << " ms";
+        ss << ")";
+    }
+    ss << endl;
+    return ss.str();
+}
+
 string MavSystem::_aptype2str(uint8_t atype) {
     switch (atype) {
     case MAV_AUTOPILOT_GENERIC:
@@ -219,7 +270,18 @@ void MavSystem::get_summary(string &buf) const {
         if (_mavlink_summary.num_uninterpreted > 0) {
             ss << "   - uninterpreted: " << _mavlink_summary.num_uninterpreted << " (IDs: " << set2str(_mavlink_summary.mavlink_msgids_uninterpreted) << ")" << endl;
         }
+        if (_mavlink_summary.num_disabled > 0) {
+            ss << "   - not selected: " << _mavlink_summary.num_disabled << " (IDs: " << set2str(_mavlink_summary.mavlink_msgids_disabled) << ")" << endl;
+        }
         ss << "   - errors: "  << _mavlink_summary.num_error << endl;
+        ss << _describe_msgstats();
+
+        /***************************************/
+        ss << "Memory:" << endl;
+        /***************************************/
+        memuse_t mem;
+        get_memory(mem);
+        ss << "   - " << mem.items << " data items: " << mem.describe() << endl;
     }
 
     buf = ss.str();
@@ -235,110 +297,279 @@ void MavSystem::_log(logmsgtype_e t, const std::string & str) {
  * @param item
  */
 void MavSystem::_data_register_hierarchy(const string &fullname, Data *item) {
+    QMutexLocker lock(_registry_lock);
 
     string fullpath = fullname;
     fullpath = string_trim(fullpath);
-    _data_from_path[fullname] = item; // will add if it doesn't exist yet
+    const int id = _paths.intern(fullname); // will add if it doesn't exist yet
+#ifdef WITH_DATAREGEX
+    if (!_paths.node(id).data) _index_words(id, true);
+#endif
+    _paths.node(id).data = item;
+    _paths_version++;
 
     _log(MSG_INFO, stringbuilder() << " Data: " << fullpath);
 
-    // split path into levels
-    vector<string> path;
-    string_split(fullpath, '/', path);
-    path.pop_back(); // remove basename
-
-    /*****************************************^^*********
-     *  Walk through hierarchy and create if necessary
-     **************************************************/
-    DataGroup*parentgroup=NULL;
-    DataGroup*curgroup=NULL;
-    DataGroup::groupmap*currentGroupMap = &mav_data_groups; // start at top level
-    for (vector<string>::const_iterator itppath = path.begin(); itppath != path.end(); ++itppath) { // walk through path
-        // see if it exists
-        DataGroup::groupmap::iterator itgroup = currentGroupMap->find(*itppath);
-        if (itgroup == currentGroupMap->end()) {
-            // does not exist. create new group and save its ptr
-            curgroup = new DataGroup(*itppath); // create group
-            curgroup->parent = parentgroup;
-            currentGroupMap->insert(currentGroupMap->begin(), DataGroup::groupmap_pair(*itppath, curgroup)); // insert into group list
-        } else {
-            curgroup = itgroup->second;
-        }
-        currentGroupMap = &curgroup->groups; // next level
-        parentgroup = curgroup;
-    }
+    // everything before the basename is the group
+    const size_t basenamestart = fullpath.rfind('/');
+    if (string::npos == basenamestart) return;
+    const int gid = _get_or_add_group(fullpath, basenamestart);
+
     // finally...when we are here the path exists. All we have to do is hook in the data
-    if (!curgroup) return;
+    DataGroup*const curgroup = _paths.node(gid).group;
+    _paths.node(id).parent = gid;
     curgroup->data[item->get_name()] = item;
     item->parent = curgroup; // this line does not permit multi-parent...need to do it for TreeView widget. Trolltech, what are you doing with that TreeView??
 }
 
+/**
+ * @brief find group with the path given by the first len characters of fullpath.
+ * Creates it and its parents if necessary.
+ * @return id of group in _paths
+ */
+int MavSystem::_get_or_add_group(const std::string &fullpath, size_t len) {
+    const int found = _paths.find(fullpath.data(), len);
+    if (found >= 0 && _paths.node(found).group) return found;
+
+    // does not exist. create parents first
+    const size_t namestart = (len > 0) ? fullpath.rfind('/', len - 1) : string::npos;
+    int pid = -1;
+    DataGroup*parentgroup = NULL;
+    DataGroup::groupmap*siblings = &mav_data_groups; // top level
+    if (namestart != string::npos) {
+        pid = _get_or_add_group(fullpath, namestart);
+        parentgroup = _paths.node(pid).group;
+        siblings = &parentgroup->groups;
+    }
+    const size_t offset = (namestart == string::npos) ? 0 : namestart + 1;
+    const string groupname = fullpath.substr(offset, len - offset);
+
+    // create new group and save its ptr
+    DataGroup*const curgroup = new (_arena) DataGroup(groupname);
+    curgroup->parent = parentgroup;
+    siblings->insert(siblings->begin(), DataGroup::groupmap_pair(groupname, curgroup)); // insert into group list
+
+    const int gid = _paths.intern(fullpath.substr(0, len));
+    _paths.node(gid).group = curgroup;
+    _paths.node(gid).parent = pid;
+    return gid;
+}
+
 void MavSystem::_data_cleanup() {
-    // delete all data in _memory_data and delete groups
-    for (data_accessmap::iterator it = _data_from_path.begin(); it != _data_from_path.end(); ++it) {
-        delete it->second;
+    // delete all data and groups. Memory of those from the arena is freed in one go afterwards.
+    QMutexLocker lock(_registry_lock);
+    for (unsigned int id = 0; id < _paths.size(); ++id) {
+        delete _paths.node(id).data;
+        delete _paths.node(id).group;
     }
-    _data_from_path.clear();
+    _paths.clear();
+    _arena.clear();
+    _paths_version++;
+#ifdef WITH_DATAREGEX
+    _word_index.clear();
+#endif
     mav_data_groups.clear();
 }
 
-MavSystem::MavSystem(unsigned int sysid) : id(sysid), mavtype_str("unknown"), aptype_str("unknown"), _time(0.), _time_offset_usec(0) {
+MavSystem::MavSystem(unsigned int sysid) : id(sysid), mavtype_str("unknown"), aptype_str("unknown"),
+    _registry_mutex(QMutex::Recursive), _registry_lock(NULL), _time(0.), _time_offset_usec(0) {
     _defaults();
 }
 
 
 /**
- * @brief hook a data item into a given hierarchy.
- * @param fullpath
- * @param item
+ * @brief remove a data item from the hierarchy, and groups which become empty
+ * @param id of the data in _paths
  */
-void MavSystem::_data_unregister_hierarchy(Data*const src) {
-    // remove data from parent
+void MavSystem::_data_unregister_hierarchy(int id) {
+    Data*const src = _paths.node(id).data;
+    int gid = _paths.node(id).parent;
+#ifdef WITH_DATAREGEX
+    if (src) _index_words(id, false);
+#endif
+    _paths.node(id).data = NULL;
+    _paths_version++;
+    _paths.release(id);
+    if (!src || gid < 0) return;
 
-    DataGroup*parentgroup = src->get_parent();
+    // remove data from parent
+    DataGroup*parentgroup = _paths.node(gid).group;
     if (!parentgroup) return; // now that should never happen. every data should have a parent.
 
     DataGroup::datamap::iterator it = parentgroup->data.find(src->get_name());
     if (it == parentgroup->data.end()) return; // notfound...weird
     parentgroup->data.erase(it);
 
-    // clean hierarchy
-    DataGroup*curgroup = parentgroup;
-    while (curgroup) {
+    // clean hierarchy: remove groups that became empty, bottom-up
+    while (gid >= 0) {
+        DataGroup*const curgroup = _paths.node(gid).group;
+        const int pid = _paths.node(gid).parent;
+        if (!curgroup || !curgroup->groups.empty() || !curgroup->data.empty()) break; // parents are not empty either
         parentgroup = curgroup->parent;
-        // see if group would be empty after removal
-        bool groupempty = (curgroup->groups.empty() && curgroup->data.empty());
-        if (groupempty) {
-            if (parentgroup) {  // parent is another group -> clean parent
-                DataGroup::groupmap::iterator it = parentgroup->groups.find(curgroup->groupname);
-                if (it != parentgroup->groups.end()) parentgroup->groups.erase(it);
-            } else {            // parent is MavSystem -> clean mavsystem
-                DataGroup::groupmap::iterator it = this->mav_data_groups.find(curgroup->groupname);
-                if (it != this->mav_data_groups.end()) this->mav_data_groups.erase(it);
+        if (parentgroup) {  // parent is another group -> clean parent
+            DataGroup::groupmap::iterator itg = parentgroup->groups.find(curgroup->groupname);
+            if (itg != parentgroup->groups.end()) parentgroup->groups.erase(itg);
+        } else {            // parent is MavSystem -> clean mavsystem
+            DataGroup::groupmap::iterator itg = this->mav_data_groups.find(curgroup->groupname);
+            if (itg != this->mav_data_groups.end()) this->mav_data_groups.erase(itg);
+        }
+        // delete group itself
+        delete curgroup;
+        _paths.node(gid).group = NULL;
+        _paths.release(gid);
+        gid = pid;
+    }
+}
+
+#ifdef WITH_DATAREGEX
+static bool is_word_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' ||
+           (unsigned char) c >= 0x80; // non-ASCII is a letter for QRegExp
+}
+
+/**
+ * @brief split into maximal runs of word characters, i.e., what \b separates. No duplicates.
+ */
+void MavSystem::_split_words(const std::string &path, std::vector<std::string> & words) {
+    words.clear();
+    size_t k = 0;
+    while (k < path.size()) {
+        if (!is_word_char(path[k])) { k++; continue; }
+        const size_t start = k;
+        while (k < path.size() && is_word_char(path[k])) k++;
+        const std::string w = path.substr(start, k - start);
+        if (std::find(words.begin(), words.end(), w) == words.end()) words.push_back(w);
+    }
+}
+
+void MavSystem::_index_words(int id, bool add) {
+    std::vector<std::string> words;
+    _split_words(_paths.node(id).path, words);
+    for (std::vector<std::string>::const_iterator it = words.begin(); it != words.end(); ++it) {
+        std::vector<int> & ids = _word_index[*it];
+        if (add) {
+            ids.push_back(id);
+        } else {
+            ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+            if (ids.empty()) _word_index.erase(*it);
+        }
+    }
+}
+
+/**
+ * @brief recognize "\\bword\\b", where word may contain classes like [rR]
+ * @param words all spellings the pattern matches
+ * @return false if pattern is something else
+ */
+bool MavSystem::_parse_word_pattern(const std::string &pattern, std::vector<std::string> & words) {
+    const size_t MAX_SPELLINGS = 64;
+    if (pattern.size() < 5 || pattern.compare(0, 2, "\\b") != 0 || pattern.compare(pattern.size() - 2, 2, "\\b") != 0) return false;
+
+    words.assign(1, std::string());
+    size_t k = 2;
+    const size_t end = pattern.size() - 2;
+    while (k < end) {
+        std::string alternatives;
+        if (pattern[k] == '[') {
+            const size_t close = pattern.find(']', k);
+            if (close == std::string::npos || close >= end || close == k + 1) return false;
+            alternatives = pattern.substr(k + 1, close - k - 1);
+            k = close + 1;
+        } else {
+            alternatives = pattern.substr(k, 1);
+            k++;
+        }
+        for (size_t a = 0; a < alternatives.size(); a++) {
+            if (!is_word_char(alternatives[a]) || (unsigned char) alternatives[a] >= 0x80) return false;
+        }
+        if (words.size() * alternatives.size() > MAX_SPELLINGS) return false;
+        std::vector<std::string> next;
+        for (std::vector<std::string>::const_iterator it = words.begin(); it != words.end(); ++it) {
+            for (size_t a = 0; a < alternatives.size(); a++) {
+                next.push_back(*it + alternatives[a]);
             }
-            // delete group itself
-            delete curgroup;
         }
-        curgroup = parentgroup;
+        words.swap(next);
     }
+    return !words.empty() && !words[0].empty();
 }
 
+Data* MavSystem::_find_data_words(const std::vector<std::string> & words) const {
+    const PathTable::node_t *best = NULL;
+    for (std::vector<std::string>::const_iterator itw = words.begin(); itw != words.end(); ++itw) {
+        word_index_t::const_iterator it = _word_index.find(*itw);
+        if (it == _word_index.end()) continue;
+        for (std::vector<int>::const_iterator itid = it->second.begin(); itid != it->second.end(); ++itid) {
+            const PathTable::node_t & n = _paths.node(*itid);
+            if (n.data && (!best || n.path < best->path)) best = &n;
+        }
+    }
+    return best ? best->data : NULL;
+}
+
+Data* MavSystem::_find_data_scan(const std::string &pattern, bool literal) const {
+    const QRegExp* rx = NULL;
+    if (!literal) {
+        std::map<std::string, QRegExp>::iterator it = _query_regex.find(pattern);
+        if (it == _query_regex.end()) {
+            it = _query_regex.insert(std::make_pair(pattern, QRegExp(QString::fromStdString(pattern)))).first;
+        }
+        rx = &it->second;
+    }
+    const PathTable::node_t *best = NULL;
+    for (unsigned int id = 0; id < _paths.size(); ++id) {
+        const PathTable::node_t & n = _paths.node(id);
+        if (!n.data) continue;
+        if (best && n.path >= best->path) continue;
+        const bool match = literal ? (n.path.find(pattern) != std::string::npos)
+                                   : (rx->indexIn(QString::fromStdString(n.path)) >= 0);
+        if (match) best = &n;
+    }
+    return best ? best->data : NULL;
+}
+
+Data* MavSystem::_find_data_regex(const std::string &pattern) const {
+    QMutexLocker lock(_registry_lock);
+    if (_query_version != _paths_version) {
+        _query_results.clear();
+        _query_version = _paths_version;
+    }
+    std::map<std::string, Data*>::const_iterator it = _query_results.find(pattern);
+    if (it != _query_results.end()) return it->second;
+
+    Data*ret;
+    std::vector<std::string> words;
+    if (_parse_word_pattern(pattern, words)) {
+        ret = _find_data_words(words);
+    } else {
+        const bool literal = (pattern.find_first_of("\\^$.|?*+()[]{}") == std::string::npos);
+        ret = _find_data_scan(pattern, literal);
+    }
+    _query_results[pattern] = ret;
+    return ret;
+}
+#endif
+
 void MavSystem::_del_data(Data*const src) {
     if (!src) return;
+    QMutexLocker lock(_registry_lock);
     const string fullpath = Data::get_fullname(src);
 
-    // remove from map
-    data_accessmap::iterator it1 = _data_from_path.find(fullpath);
-    if (it1 != _data_from_path.end()) _data_from_path.erase(it1);
+    // remove from table and hierarchy
+    const int id = _paths.find(fullpath);
+    if (id >= 0 && _paths.node(id).data == src) {
+        _data_unregister_hierarchy(id);
+    } else if (src->get_parent()) {
+        src->get_parent()->data.erase(src->get_name()); // not found...weird
+    }
 
-    // remove from hierarchy
-    _data_unregister_hierarchy(src);
+    _paths_version++;
 
     // delete the data itself
     delete src; // FIXME: deleting abstract class here...
 }
 
-bool MavSystem::_add_data(const Data*const src) {
+bool MavSystem::_add_data(const Data*const src, bool take) {
     // find data path and register to get it into the hierarchy
     if (!src) return false;
 
@@ -354,14 +585,14 @@ bool MavSystem::_add_data(const Data*const src) {
         } else {
             _del_data(mydata); // drop old, empty data!!
             // since there is nothing now, clone it
-            Data*const copiedData = src->Clone(); ///< call copy CTOR (covariant return)
+            Data*const copiedData = take ? const_cast<Data*>(src)->Take() : src->Clone(); ///< call copy CTOR (covariant return)
             _data_register_hierarchy(fullname, copiedData);
             if (!copiedData) return false;
             return true;
         }
     } else {
-        // does not exist -> take a deep copy and register it
-        Data*const copiedData = src->Clone(); ///< call copy CTOR (covariant return)
+        // does not exist -> take a deep copy (or the samples) and register it
+        Data*const copiedData = take ? const_cast<Data*>(src)->Take() : src->Clone(); ///< call copy CTOR (covariant return)
         if (!copiedData) return false;
         _data_register_hierarchy(fullname, copiedData);
         return true;
@@ -369,7 +600,7 @@ bool MavSystem::_add_data(const Data*const src) {
 }
 
 // DONE
-MavSystem::MavSystem(const MavSystem *other) {
+MavSystem::MavSystem(const MavSystem *other) : _registry_mutex(QMutex::Recursive), _registry_lock(NULL) {
     _defaults(); ///< just to be sure...there must be no uninitialized data
     id = other->id;
     mavtype = other->mavtype;
@@ -387,10 +618,10 @@ MavSystem::MavSystem(const MavSystem *other) {
     _mavlink_summary = other->_mavlink_summary;
 
     // copy data inside, the datagroup is not copied but created with our own functions again
-    for (data_accessmap::const_iterator ito = other->_data_from_path.begin(); ito != other->_data_from_path.end(); ++ito) {
+    for (unsigned int id = 0; id < other->_paths.size(); ++id) {
         // copy each item by copying *Data inside
-        const Data*const data = ito->second;
-        _add_data(data);
+        const Data*const data = other->_paths.node(id).data;
+        if (data) _add_data(data);
     }
 }
 
@@ -562,8 +793,9 @@ void MavSystem::track_ambient(float temp_degC, float press_hPa) {
  * @param data_length length of an incoming packet, inkl. header
  * @param msgid MAVlink message identifier
  * @param whatwasdone to indicate how the caller processed the message; useful to see if MavLogAnalyzer misses messages
+ * @param handler_nsec time it took to interpret the message
  */
-void MavSystem::track_mavlink(unsigned int data_length_bytes, unsigned int msgid, mavlink_parsed_e whatwasdone) {
+void MavSystem::track_mavlink(unsigned int data_length_bytes, unsigned int msgid, mavlink_parsed_e whatwasdone, unsigned long long handler_nsec) {
     MAVSYSTEM_DATA_ITEM_OR_RETURN(DataTimeseries<float>, data_throughput, "radio/throughput", "kbps");
 
     // accumulate amount of sent data between two successive time references
@@ -572,13 +804,22 @@ void MavSystem::track_mavlink(unsigned int data_length_bytes, unsigned int msgid
     // track basic information what was done with the packet
     switch (whatwasdone) {
     case MAVLINK_INTERPRETED:
+    {
         _mavlink_summary.num_interpreted++;
-        _mavlink_summary.mavlink_msgids_interpreted.insert(msgid);
+        mavlink_msgstat_t & stat = _mavlink_summary.msgstats[msgid];
+        if (0 == stat.count) _mavlink_summary.mavlink_msgids_interpreted.insert(msgid);
+        stat.count++;
+        stat.nsec += handler_nsec;
+    }
         break;
     case MAVLINK_UNINTERPRETED:
         _mavlink_summary.num_uninterpreted++;
         _mavlink_summary.mavlink_msgids_uninterpreted.insert(msgid);
         break;
+    case MAVLINK_DISABLED:
+        _mavlink_summary.num_disabled++;
+        _mavlink_summary.mavlink_msgids_disabled.insert(msgid);
+        break;
     case MAVLINK_ERROR:
     default:
         _mavlink_summary.num_error++;
@@ -691,15 +932,16 @@ void MavSystem::track_mission_item(uint8_t target_system_id, uint8_t target_comp
 }
 
 void MavSystem::track_rc(const uint16_t channels[8]) {
+    static const unsigned int first_slot = _new_slots(8);
     DataTimeseries<unsigned int>*const data_chan[] = {
-        MAVSYSTEM_DATA_ITEM_HAVEVAR(DataTimeseries<unsigned int>, "rc/channel_1", "us"),
-        MAVSYSTEM_DATA_ITEM_HAVEVAR(DataTimeseries<unsigned int>, "rc/channel_2", "us"),
-        MAVSYSTEM_DATA_ITEM_HAVEVAR(DataTimeseries<unsigned int>, "rc/channel_3", "us"),
-        MAVSYSTEM_DATA_ITEM_HAVEVAR(DataTimeseries<unsigned int>, "rc/channel_4", "us"),
-        MAVSYSTEM_DATA_ITEM_HAVEVAR(DataTimeseries<unsigned int>, "rc/channel_5", "us"),
-        MAVSYSTEM_DATA_ITEM_HAVEVAR(DataTimeseries<unsigned int>, "rc/channel_6", "us"),
-        MAVSYSTEM_DATA_ITEM_HAVEVAR(DataTimeseries<unsigned int>, "rc/channel_7", "us"),
-        MAVSYSTEM_DATA_ITEM_HAVEVAR(DataTimeseries<unsigned int>, "rc/channel_8", "us")
+        MAVSYSTEM_DATA_ITEM_SLOT(DataTimeseries<unsigned int>, first_slot + 0, "rc/channel_1", "us"),
+        MAVSYSTEM_DATA_ITEM_SLOT(DataTimeseries<unsigned int>, first_slot + 1, "rc/channel_2", "us"),
+        MAVSYSTEM_DATA_ITEM_SLOT(DataTimeseries<unsigned int>, first_slot + 2, "rc/channel_3", "us"),
+        MAVSYSTEM_DATA_ITEM_SLOT(DataTimeseries<unsigned int>, first_slot + 3, "rc/channel_4", "us"),
+        MAVSYSTEM_DATA_ITEM_SLOT(DataTimeseries<unsigned int>, first_slot + 4, "rc/channel_5", "us"),
+        MAVSYSTEM_DATA_ITEM_SLOT(DataTimeseries<unsigned int>, first_slot + 5, "rc/channel_6", "us"),
+        MAVSYSTEM_DATA_ITEM_SLOT(DataTimeseries<unsigned int>, first_slot + 6, "rc/channel_7", "us"),
+        MAVSYSTEM_DATA_ITEM_SLOT(DataTimeseries<unsigned int>, first_slot + 7, "rc/channel_8", "us")
     };
     for (unsigned int k=0; k<8; k++) {
         if (data_chan[k]) data_chan[k]->add_elem(channels[k], _time);
@@ -842,15 +1084,16 @@ void MavSystem::track_imu1(const int16_t acc_mg[], const int16_t gyr_mrs[], cons
 }
 
 void MavSystem::track_actuators(const uint16_t servo_raw[]) {
+    static const unsigned int first_slot = _new_slots(8);
     DataTimeseries<unsigned int>*const data_servo[] = {
-        MAVSYSTEM_DATA_ITEM_HAVEVAR(DataTimeseries<unsigned int>, "actuators/servo_1", "us"),
-        MAVSYSTEM_DATA_ITEM_HAVEVAR(DataTimeseries<unsigned int>, "actuators/servo_2", "us"),
-        MAVSYSTEM_DATA_ITEM_HAVEVAR(DataTimeseries<unsigned int>, "actuators/servo_3", "us"),
-        MAVSYSTEM_DATA_ITEM_HAVEVAR(DataTimeseries<unsigned int>, "actuators/servo_4", "us"),
-        MAVSYSTEM_DATA_ITEM_HAVEVAR(DataTimeseries<unsigned int>, "actuators/servo_5", "us"),
-        MAVSYSTEM_DATA_ITEM_HAVEVAR(DataTimeseries<unsigned int>, "actuators/servo_6", "us"),
-        MAVSYSTEM_DATA_ITEM_HAVEVAR(DataTimeseries<unsigned int>, "actuators/servo_7", "us"),
-        MAVSYSTEM_DATA_ITEM_HAVEVAR(DataTimeseries<unsigned int>, "actuators/servo_8", "us")
+        MAVSYSTEM_DATA_ITEM_SLOT(DataTimeseries<unsigned int>, first_slot + 0, "actuators/servo_1", "us"),
+        MAVSYSTEM_DATA_ITEM_SLOT(DataTimeseries<unsigned int>, first_slot + 1, "actuators/servo_2", "us"),
+        MAVSYSTEM_DATA_ITEM_SLOT(DataTimeseries<unsigned int>, first_slot + 2, "actuators/servo_3", "us"),
+        MAVSYSTEM_DATA_ITEM_SLOT(DataTimeseries<unsigned int>, first_slot + 3, "actuators/servo_4", "us"),
+        MAVSYSTEM_DATA_ITEM_SLOT(DataTimeseries<unsigned int>, first_slot + 4, "actuators/servo_5", "us"),
+        MAVSYSTEM_DATA_ITEM_SLOT(DataTimeseries<unsigned int>, first_slot + 5, "actuators/servo_6", "us"),
+        MAVSYSTEM_DATA_ITEM_SLOT(DataTimeseries<unsigned int>, first_slot + 6, "actuators/servo_7", "us"),
+        MAVSYSTEM_DATA_ITEM_SLOT(DataTimeseries<unsigned int>, first_slot + 7, "actuators/servo_8", "us")
     };
     for (unsigned int k=0; k<8; k++) {
         if (data_servo[k]) data_servo[k]->add_elem(servo_raw[k], _time);
@@ -898,11 +1141,12 @@ void MavSystem::track_power(float Vcc, float Vservo, uint16_t flags) {
 }
 
 void MavSystem::track_system_errors(uint16_t errors_count [4]) {
+    static const unsigned int first_slot = _new_slots(4);
     DataTimeseries<unsigned int>*const data_errors[] = {
-        MAVSYSTEM_DATA_ITEM_HAVEVAR(DataTimeseries<unsigned int>, "system/error count #1", "AP-specific"),
-        MAVSYSTEM_DATA_ITEM_HAVEVAR(DataTimeseries<unsigned int>, "system/error count #2", "AP-specific"),
-        MAVSYSTEM_DATA_ITEM_HAVEVAR(DataTimeseries<unsigned int>, "system/error count #3", "AP-specific"),
-        MAVSYSTEM_DATA_ITEM_HAVEVAR(DataTimeseries<unsigned int>, "system/error count #4", "AP-specific")
+        MAVSYSTEM_DATA_ITEM_SLOT(DataTimeseries<unsigned int>, first_slot + 0, "system/error count #1", "AP-specific"),
+        MAVSYSTEM_DATA_ITEM_SLOT(DataTimeseries<unsigned int>, first_slot + 1, "system/error count #2", "AP-specific"),
+        MAVSYSTEM_DATA_ITEM_SLOT(DataTimeseries<unsigned int>, first_slot + 2, "system/error count #3", "AP-specific"),
+        MAVSYSTEM_DATA_ITEM_SLOT(DataTimeseries<unsigned int>, first_slot + 3, "system/error count #4", "AP-specific")
     };
     for (unsigned int k=0; k<4; k++) {
         data_errors[k]->add_elem(errors_count[k], _time);
@@ -951,6 +1195,31 @@ void MavSystem::track_nav(float nav_roll_deg, float nav_pitch_deg, float nav_bea
     data_err_xtrack->add_elem(err_xtrack_m, _time);
 }
 
+/**
+ * @return index of the first sample later than t. Searches from the back, because
+ * incremental postprocessing only looks at what was appended.
+ */
+template <typename T>
+static unsigned int first_sample_after(const DataTimeseries<T>*d, double t) {
+    const std::vector<double> & times = d->get_time();
+    unsigned int k = d->size();
+    while (k > 0 && times[k-1] > t) --k;
+    return k;
+}
+
+/**
+ * @brief whether a postprocessor can continue its derived series instead of recomputing
+ * it: only if the inputs are still on the same time base and did not change before the
+ * end of what was computed.
+ * @param from_epoch_sec MavSystem::_pp_from_sec; 0=must recompute
+ */
+template <typename T>
+static bool can_resume(const DataTimeseries<T>*out, unsigned long epoch_datastart_usec, double from_epoch_sec) {
+    if (from_epoch_sec <= 0. || out->size() == 0) return false;
+    if (out->get_epoch_datastart() != epoch_datastart_usec) return false;
+    return out->get_max_time() + epoch_datastart_usec/1E6 < from_epoch_sec;
+}
+
 /**
  * @brief POST-PROCESSOR FOR GLIDING PERFORMANCE, position-based
  * computes a/c glide ratio and XXX
@@ -988,11 +1257,31 @@ void MavSystem::_postprocess_glideperf_pos() {
     if (data_x && data_y && data_z) {
         MAVSYSTEM_DATA_ITEM_OR_RETURN(DataTimeseries<float>, data_dist, "glideperf/cum. horz. dist.", "m");
         data_dist->set_type(Data::DATA_DERIVED);
-        float x_pre, y_pre, hdist_pre;
-        for (unsigned k=0; k<data_x->size(); ++k) {
-            double t; float x, y, z;
-            if (data_x->get_data(k, t, x) && data_y->get_data_at_time(t, y) && data_z->get_data_at_time(t, z)) {
-                if (k>0) {
+        float x_pre = 0.f, y_pre = 0.f, hdist_pre = 0.f;
+        unsigned int k0 = 0;
+        if (can_resume(data_dist, data_x->get_epoch_datastart(), _pp_from_sec)) {
+            // positions were only extended (merge_in) -> continue the sum
+            double t;
+            data_dist->get_data(data_dist->size()-1, t, hdist_pre);
+            k0 = first_sample_after(data_x, t);
+            if (k0 == 0 || !data_x->get_data(k0-1, t, x_pre) || !data_y->get_data_at_time(t, y_pre)) {
+                k0 = 0;
+            }
+        }
+        if (k0 == 0) {
+            // recompute, postprocess could be called multiple times
+            hdist_pre = 0.f;
+            data_dist->clear();
+            data_dist->set_epoch_datastart(data_x->get_epoch_datastart());
+        }
+        DataAlignedCursor<float> pos(data_x, k0);
+        pos.add(data_y);
+        pos.add(data_z);
+        while (pos.next()) {
+            if (pos.valid()) {
+                const double t = pos.time();
+                const float x = pos.value(0), y = pos.value(1);
+                if (pos.index()>0) {
                     const float hdist = sqrt(pow(x-x_pre,2) + pow(y-y_pre,2)) + hdist_pre;
                     data_dist->add_elem(hdist, t);
                     hdist_pre = hdist;
@@ -1093,9 +1382,12 @@ void MavSystem::_postprocess_glideperf_vel() {
             // if present, we believe the data
             // fuse to scalar
             MAVSYSTEM_DATA_ITEM_OR_RETURN(DataTimeseries<float>, data_newspeed, "glideperf/groundspeed", "VE and VN");
-            for (unsigned int k=0; k < data_try1->size(); ++k) {
-                double t; float vn, ve;
-                if (data_try1->get_data(k, t, ve) && data_try2->get_data_at_time(t, vn)) {
+            DataAlignedCursor<float> vel(data_try1);
+            vel.add(data_try2);
+            while (vel.next()) {
+                if (vel.valid()) {
+                    const double t = vel.time();
+                    const float ve = vel.value(0), vn = vel.value(1);
                     float total = sqrt(pow(ve,2) + pow(vn,2));
                     data_newspeed->add_elem(total, t);
                 } else {
@@ -1189,10 +1481,11 @@ void MavSystem::_postprocess_glideperf_vel() {
             MAVSYSTEM_DATA_ITEM_OR_RETURN(DataTimeseries<float>, data_windspd, "glideperf/wind speed", "same units as VWE and VWN");
             data_winddir->set_type(Data::DATA_DERIVED);
             data_windspd->set_type(Data::DATA_DERIVED);
+            DataCursor<float> cur_windN(data_windN), cur_yaw(data_yaw), cur_gspeed(data_gspeed);
             for (unsigned int k=0; k < data_windE->size(); ++k) {
                 double t; float wE, wN;
                 data_windE->get_data(k, t, wE); // wind blowing towards east direction
-                data_windN->get_data_at_time(t, wN); // wind blowing towards north direction
+                cur_windN.get_data_at_time(t, wN); // wind blowing towards north direction
 
 #if 0
                 // DEBUG: wind blowing from south to north (180°)
@@ -1206,7 +1499,7 @@ void MavSystem::_postprocess_glideperf_vel() {
                 data_windspd->add_elem(windspd, t);
 
                 // compute moew cool things
-                float yaw; data_yaw->get_data_at_time(t, yaw);
+                float yaw; cur_yaw.get_data_at_time(t, yaw);
                 yaw = DEG2RAD(angle360(yaw));
 
                 // aeronautic: if wind direction is opposite of yaw, then it's tail wind. So flip it.
@@ -1224,7 +1517,7 @@ void MavSystem::_postprocess_glideperf_vel() {
                     // we estimate airspeed...even when there is a sensor. That is a good exercise.
                     MAVSYSTEM_DATA_ITEM_OR_RETURN(DataTimeseries<float>, data_airspeedest, "glideperf/airspeed estimate", "same units as VWE and VWN");
                     data_airspeedest->set_type(Data::DATA_DERIVED);
-                    float airspeed = 0.; data_gspeed->get_data_at_time(t, airspeed);
+                    float airspeed = 0.; cur_gspeed.get_data_at_time(t, airspeed);
                     airspeed += windhd; // compensate with headwind
                     data_airspeedest->add_elem(airspeed, t);
                 }
@@ -1235,25 +1528,26 @@ void MavSystem::_postprocess_glideperf_vel() {
         // where sink is > 0 ...
         float maxratio = 0.;
         float optspeed = 0.;
+        const DataTimeseries<float>*data_speed = data_airspeed;
+        if (!data_speed) {
+            if (have_wind) {
+                MAVSYSTEM_REQUIRE_DATA(DataTimeseries<float>, data_airspeedest, "glideperf/airspeed estimate");
+                data_speed = data_airspeedest;
+            } else {
+                data_speed = data_gspeed;
+            }
+        }
+        DataCursor<float> cur_accx(data_accx), cur_speed(data_speed), cur_pitch(data_pitch), cur_roll(data_roll);
         for (unsigned int k=0; k < data_sink->size(); ++k) {
             double t;
             float sink;            
             if (data_sink->get_data(k, t, sink)) {
                 if (sink > 0.) {
                     float airspeed = 0.f, pitch=0.f, roll=0.f, accx=0.f;
-                    data_accx->get_data_at_time(t, accx);
-                    if (data_airspeed) {
-                        data_airspeed->get_data_at_time(t, airspeed);
-                    } else {
-                        if (have_wind) {
-                            MAVSYSTEM_REQUIRE_DATA(DataTimeseries<float>, data_airspeedest, "glideperf/airspeed estimate");
-                            data_airspeedest->get_data_at_time(t, airspeed);
-                        } else {
-                            data_gspeed->get_data_at_time(t, airspeed);
-                        }
-                    }
-                    data_pitch->get_data_at_time(t, pitch);
-                    data_roll->get_data_at_time(t, roll); // FIXME: check units. Some Autopilots may have scaling
+                    cur_accx.get_data_at_time(t, accx);
+                    cur_speed.get_data_at_time(t, airspeed);
+                    cur_pitch.get_data_at_time(t, pitch);
+                    cur_roll.get_data_at_time(t, roll); // FIXME: check units. Some Autopilots may have scaling
 
                     // detect stationary flight: no kinectic energy being tranformed -> derivative of speed (AccX) close to zero
                     // and around normal attitude and moving ...
@@ -1308,31 +1602,36 @@ void MavSystem::_postprocess_powerstats() {
     data_charge->set_type(Data::DATA_DERIVED);
     data_ccharge->set_type(Data::DATA_DERIVED);
 
-    // at this point, make sure the data we are writing is empty, since postprocess could be called multiple times
-    data_power->clear();
-    data_consumption->clear();
-    data_cconsumption->clear();
-    data_charge->clear();
-    data_ccharge->clear();
-    data_power->set_epoch_datastart(epoch_datastart_usec);
-    data_consumption->set_epoch_datastart(epoch_datastart_usec);
-    data_cconsumption->set_epoch_datastart(epoch_datastart_usec);
-    data_charge->set_epoch_datastart(epoch_datastart_usec);
-    data_ccharge->set_epoch_datastart(epoch_datastart_usec);
+    // if the inputs were only extended (merge_in), continue where we stopped
+    const bool resume = can_resume(data_power, epoch_datastart_usec, _pp_from_sec) &&
+                        can_resume(data_ccharge, epoch_datastart_usec, _pp_from_sec) &&
+                        can_resume(data_cconsumption, epoch_datastart_usec, _pp_from_sec);
+
+    // otherwise, make sure the data we are writing is empty, since postprocess could be called multiple times
+    if (!resume) {
+        data_power->clear();
+        data_consumption->clear();
+        data_cconsumption->clear();
+        data_charge->clear();
+        data_ccharge->clear();
+        data_power->set_epoch_datastart(epoch_datastart_usec);
+        data_consumption->set_epoch_datastart(epoch_datastart_usec);
+        data_cconsumption->set_epoch_datastart(epoch_datastart_usec);
+        data_charge->set_epoch_datastart(epoch_datastart_usec);
+        data_ccharge->set_epoch_datastart(epoch_datastart_usec);
+    }
 
     /*************************************
      *  POWER: TODO: union of samples
      *************************************/
     {
-        for (unsigned int k=0; k < data_battery_volt->size(); ++k) {
-            float volt;
-            double t;
-            if (data_battery_volt->get_data(k, t, volt)) {
-                float amps;
-                if (data_battery_amps->get_data_at_time(t, amps)) {
-                    float power_est_watts = volt*amps;
-                    data_power->add_elem(power_est_watts, t);
-                }
+        const unsigned int k0 = resume ? first_sample_after(data_battery_volt, data_power->get_max_time()) : 0;
+        DataAlignedCursor<float> va(data_battery_volt, k0);
+        va.add(data_battery_amps);
+        while (va.next()) {
+            if (va.valid()) {
+                float power_est_watts = va.value(0)*va.value(1);
+                data_power->add_elem(power_est_watts, va.time());
             }
         }
     }
@@ -1343,7 +1642,15 @@ void MavSystem::_postprocess_powerstats() {
     {
         float ccharge_As=0.f;
         double fa, fb, ta, tb;
-        for (unsigned int k=0; k < data_battery_amps->size(); ++k) {
+        unsigned int k0 = 0;
+        if (resume) {
+            float last, current;
+            data_ccharge->get_data(data_ccharge->size()-1, ta, last);
+            ccharge_As = last*3600.;
+            k0 = first_sample_after(data_battery_amps, ta);
+            if (k0 > 0 && data_battery_amps->get_data(k0-1, ta, current)) fa = current;
+        }
+        for (unsigned int k=k0; k < data_battery_amps->size(); ++k) {
             double t;
             float current;
             if (data_battery_amps->get_data(k,t,current)) {
@@ -1374,7 +1681,15 @@ void MavSystem::_postprocess_powerstats() {
     {
         float cconsumption_Ws=0.f;
         double fa, fb, ta, tb;
-        for (unsigned int k=0; k < data_power->size(); ++k) {
+        unsigned int k0 = 0;
+        if (resume) {
+            float last, power;
+            data_cconsumption->get_data(data_cconsumption->size()-1, ta, last);
+            cconsumption_Ws = last*3600.;
+            k0 = first_sample_after(data_power, ta);
+            if (k0 > 0 && data_power->get_data(k0-1, ta, power)) fa = power;
+        }
+        for (unsigned int k=k0; k < data_power->size(); ++k) {
             double t;
             float power;
             if (data_power->get_data(k,t,power)) {
@@ -1409,17 +1724,25 @@ void MavSystem::_postprocess_powerstats() {
  */
 void MavSystem::_postprocess_bad_timing() {
 
-    // first take a copy of the datamap, and then iterate that copy. This is because
-    // we are appending to the list here, which would otherwise loop infinitely
-    data_accessmap oldmap = _data_from_path;
+    // first take a copy of the data, and then iterate that copy. This is because
+    // we are appending to the table here, which would otherwise loop infinitely
+    std::vector<Data*> olddata;
+    for (unsigned int id = 0; id < _paths.size(); ++id) {
+        if (!_paths.node(id).data) continue;
+        if (!_changed.empty() && _changed.find(_paths.node(id).path) == _changed.end()) continue; // after merge: only new data
+        olddata.push_back(_paths.node(id).data);
+    }
+
+    // fields of one message have one time column. They get the same periodic one, then.
+    std::map<const TimeColumn*, const DataTimed*> fixed;
 
-    for (data_accessmap::const_iterator it = oldmap.begin(); it != oldmap.end(); ++it) {
-        Data*const d = it->second;
+    for (std::vector<Data*>::const_iterator it = olddata.begin(); it != olddata.end(); ++it) {
+        Data*const d = *it;
         if (d) {
             DataTimed*ds = dynamic_cast<DataTimed*>(d);
             if (ds && ds->has_bad_timestamps()) {
-                // create a backup
-                Data*data_orig = ds->Clone();
+                // create a backup. Compressed, since it is only for reference.
+                Data*data_orig = ds->CloneCompressed();
                 if (data_orig) {
                     const std::string bak_name = ds->get_name() + "_orig";
                     data_orig->set_name(bak_name);
@@ -1428,7 +1751,16 @@ void MavSystem::_postprocess_bad_timing() {
                 }
 
                 // re-align timing
+                const TimeColumn*const col = ds->get_time_column();
                 ds->make_periodic();
+                if (col) {
+                    std::map<const TimeColumn*, const DataTimed*>::const_iterator itf = fixed.find(col);
+                    if (itf == fixed.end()) {
+                        fixed[col] = ds;
+                    } else {
+                        ds->share_time_column(itf->second); // checks that they are the same
+                    }
+                }
                 const std::string msg = "fixed timing of " + ds->get_name() + " (made periodic)";
                 Logger::Instance().write(MSG_INFO, msg, _logchannel);
             }
@@ -1487,26 +1819,26 @@ void MavSystem::_postprocess_flightbook() {
     double t_last_landing=0.;
     unsigned int nflights=0;
     double flighttime = 0.;    
-    for (unsigned int k=0; k<data_alt->size(); ++k) {
-        float alt;
-        if (data_alt->get_data(k, t, alt)) {
-            float throttle;
-            if (data_throttle_percent->get_data_at_time(t, throttle)) {
-                // flying == alt > 0 && throttle > 20
-                bool seems_flying = alt > 1. && throttle > 20.f;
-                // FIXME: debounce
-                if (seems_flying && !flying) {
-                    flying = true;
-                    evt_takeofflanding->add_elem("takeoff", t);
-                    nflights++;
-                    if (nflights==1) { t_first_takeoff = t; }
-                    t_takeoff = t;
-                } else if (!seems_flying && flying) {
-                    flying = false;
-                    evt_takeofflanding->add_elem("landing", t);
-                    t_last_landing = t;
-                    flighttime+=(t-t_takeoff);
-                }
+    DataAlignedCursor<float> at(data_alt);
+    at.add(data_throttle_percent);
+    while (at.next()) {
+        if (at.valid()) {
+            t = at.time();
+            const float alt = at.value(0), throttle = at.value(1);
+            // flying == alt > 0 && throttle > 20
+            bool seems_flying = alt > 1. && throttle > 20.f;
+            // FIXME: debounce
+            if (seems_flying && !flying) {
+                flying = true;
+                evt_takeofflanding->add_elem("takeoff", t);
+                nflights++;
+                if (nflights==1) { t_first_takeoff = t; }
+                t_takeoff = t;
+            } else if (!seems_flying && flying) {
+                flying = false;
+                evt_takeofflanding->add_elem("landing", t);
+                t_last_landing = t;
+                flighttime+=(t-t_takeoff);
             }
         }
     }
@@ -1517,13 +1849,233 @@ void MavSystem::_postprocess_flightbook() {
     _log(MSG_INFO, stringbuilder() << " #" << id  << ": postproc/flightbook: DONE.");
 }
 
+/*
+ * Postprocessors with what they read and write. Hook more postprocessing functions
+ * in here, if you write new ones. Earlier ones take precedence over later ones that
+ * read their outputs (or write the same).
+ */
+static const char*const pp_all[] = {"*", NULL};
+static const char*const pp_flightbook_in[] = {"airstate/alt GND", "airstate/throttle", NULL};
+static const char*const pp_flightbook_out[] = {"flightbook/takeoff_landing", "flightbook/number flights", "flightbook/total flight time",
+                                               "flightbook/first takeoff", "flightbook/last landing", NULL};
+static const char*const pp_powerstats_in[] = {"power/battery_voltage", "power/battery_current", NULL};
+static const char*const pp_powerstats_out[] = {"power/power", "power/inst. consumption", "power/inst. charge",
+                                               "power/cum. consumption", "power/cum. charge", NULL};
+static const char*const pp_glideperf_pos_in[] = {"\\bPN\\b", "\\bPE\\b", "\\bPD\\b", NULL};
+static const char*const pp_glideperf_pos_out[] = {"glideperf/cum. horz. dist.", NULL};
+static const char*const pp_glideperf_vel_in[] = {"\\b[rR]oll\\b", "\\bAccX\\b", "\\b[pP]itch\\b", "\\bVWE\\b", "\\bVWN\\b", "\\bYaw\\b",
+                                                 "\\bTrueSpeed\\b", "NKF1/VE", "NKF1/VN", "GPS/Spd", "\\bVD\\b", "GPS/VZ", NULL};
+static const char*const pp_glideperf_vel_out[] = {"glideperf/groundspeed", "glideperf/glide ratio", "glideperf/wind direction",
+                                                  "glideperf/wind speed", "glideperf/relative wind angle", "glideperf/head wind",
+                                                  "glideperf/airspeed estimate", "glideperf/glide ratio 5sec avg", NULL};
+
+const MavSystem::postprocessor_t MavSystem::_postprocessors[] = {
+    {"bad timing",    &MavSystem::_postprocess_bad_timing,    pp_all,               pp_all},
+    {"flightbook",    &MavSystem::_postprocess_flightbook,    pp_flightbook_in,     pp_flightbook_out},
+    {"powerstats",    &MavSystem::_postprocess_powerstats,    pp_powerstats_in,     pp_powerstats_out},
+    {"glideperf pos", &MavSystem::_postprocess_glideperf_pos, pp_glideperf_pos_in,  pp_glideperf_pos_out},
+    {"glideperf vel", &MavSystem::_postprocess_glideperf_vel, pp_glideperf_vel_in,  pp_glideperf_vel_out},
+};
+
+unsigned int MavSystem::get_num_postprocessors(void) {
+    return sizeof(_postprocessors) / sizeof(_postprocessors[0]);
+}
+
+const char* MavSystem::get_postprocessor_name(unsigned int k) {
+    return _postprocessors[k].name;
+}
+
+/**
+ * @brief whether a data name (or pattern) would be found by a get_data() pattern
+ */
+bool MavSystem::_pattern_matches(const char*pattern, const char*name) {
+    if (!strcmp(pattern, "*") || !strcmp(name, "*")) return true;
+    const std::string p(pattern);
+    if (p.find_first_of("\\^$.|?*+()[]{}") == std::string::npos) {
+        return std::string(name).find(p) != std::string::npos;
+    }
+    return QRegExp(QString::fromStdString(p)).indexIn(QString::fromStdString(name)) >= 0;
+}
+
+bool MavSystem::_postprocessors_conflict(const postprocessor_t & earlier, const postprocessor_t & later) {
+    for (const char*const*o = earlier.outputs; *o; ++o) {
+        for (const char*const*i = later.inputs; *i; ++i) {
+            if (_pattern_matches(*i, *o)) return true; // later reads what earlier writes
+        }
+        for (const char*const*o2 = later.outputs; *o2; ++o2) {
+            if (!strcmp(*o, *o2) || !strcmp(*o, "*") || !strcmp(*o2, "*")) return true; // both write
+        }
+    }
+    for (const char*const*o = later.outputs; *o; ++o) {
+        for (const char*const*i = earlier.inputs; *i; ++i) {
+            if (_pattern_matches(*i, *o)) return true; // later would change what earlier reads
+        }
+    }
+    return false;
+}
+
+/**
+ * @return stage of postprocessor k: one after the latest earlier one it conflicts with
+ */
+static QMutex pp_stages_mutex; ///< several importers might ask at the same time
+static std::vector<unsigned int> pp_stages;
+
+unsigned int MavSystem::get_postprocessor_stage(unsigned int k) {
+    QMutexLocker lock(&pp_stages_mutex);
+    std::vector<unsigned int> & stages = pp_stages;
+    if (stages.empty()) {
+        const unsigned int n = get_num_postprocessors();
+        stages.assign(n, 0);
+        for (unsigned int later = 0; later < n; later++) {
+            for (unsigned int earlier = 0; earlier < later; earlier++) {
+                if (_postprocessors_conflict(_postprocessors[earlier], _postprocessors[later]) &&
+                    stages[later] <= stages[earlier]) {
+                    stages[later] = stages[earlier] + 1;
+                }
+            }
+        }
+    }
+    return stages[k];
+}
+
+void MavSystem::run_postprocessor(unsigned int k) {
+    ProfileScope prof(std::string("postprocess/") + _postprocessors[k].name);
+    (this->*_postprocessors[k].func)();
+}
+
+bool MavSystem::apply_expression(const Expression & e) {
+    ProfileScope prof("expression");
+    const std::string outname = EXPRESSION_GROUP + e.get_name();
+    const std::vector<std::string> & inputs = e.get_inputs();
+    Resampler r;
+    for (std::vector<std::string>::const_iterator it = inputs.begin(); it != inputs.end(); ++it) {
+        const Data*const d = _get_data<Data>(*it);
+        if (!d) return false;
+        if (!r.add(d)) {
+            _log(MSG_WARN, stringbuilder() << " #" << id << ": " << outname << ": " << *it << " is no numeric time series");
+            return false;
+        }
+    }
+    if (inputs.empty()) return false; // constant; no times
+
+    DataTimeseries<double>*const out = _get_and_possibly_create_data< DataTimeseries<double> >(outname, e.get_units());
+    if (!out) return false;
+    out->clear();
+    out->set_type(Data::DATA_DERIVED);
+    r.set_grid_union();
+    if (!r.run()) return false;
+
+    std::vector<const double*> columns;
+    for (unsigned int k = 0; k < r.get_num_series(); ++k) {
+        columns.push_back(&r.get_column(k)[0]);
+    }
+    const std::vector<double> & t = r.get_time();
+    std::vector<double> vals(t.size());
+    e.evaluate(columns, t.size(), &vals[0]);
+
+    // relative to the first input, as the postprocessors do
+    const unsigned long epoch_datastart_usec = r.get_data(0)->get_epoch_datastart();
+    const double offset = epoch_datastart_usec / 1E6;
+    out->set_epoch_datastart(epoch_datastart_usec);
+    std::vector<double> times;
+    size_t n = 0;
+    times.reserve(t.size());
+    for (size_t k = 0; k < t.size(); ++k) {
+        if (isnan(vals[k])) continue;
+        vals[n++] = vals[k];
+        times.push_back(t[k] - offset);
+    }
+    if (n > 0) out->add_elems(&vals[0], &times[0], n);
+    return true;
+}
+
+int MavSystem::apply_search(const ConditionSearch & q) {
+    const std::vector<std::string> & paths = q.get_inputs();
+    std::vector<const Data*> inputs;
+    for (std::vector<std::string>::const_iterator it = paths.begin(); it != paths.end(); ++it) {
+        const Data*d = _get_data<Data>(*it);
+#ifdef WITH_DATAREGEX
+        if (!d) d = _get_data<Data>(*it, true);
+#endif
+        if (!d) return -1;
+        inputs.push_back(d);
+    }
+    std::vector<ConditionSearch::interval_t> found;
+    if (!q.search(inputs, found)) {
+        _log(MSG_WARN, stringbuilder() << " #" << id << ": search \"" << q.get_query() << "\": not all are numeric time series");
+        return -1;
+    }
+
+    DataEvent<std::string>*const out = _get_and_possibly_create_data< DataEvent<std::string> >(ConditionSearch::get_result_name(q.get_query()), "");
+    if (!out) return -1;
+    out->clear();
+    out->set_type(Data::DATA_DERIVED);
+    const unsigned long epoch_datastart_usec = inputs[0]->get_epoch_datastart();
+    out->set_epoch_datastart(epoch_datastart_usec);
+    for (std::vector<ConditionSearch::interval_t>::const_iterator it = found.begin(); it != found.end(); ++it) {
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(1) << (it->t_to - it->t_from) << " s";
+        out->add_elem(ss.str(), it->t_from - epoch_datastart_usec / 1E6);
+    }
+    return found.size();
+}
+
 void MavSystem::postprocess() {
-    _postprocess_bad_timing();
-    _postprocess_flightbook();
-    _postprocess_powerstats();    
-    _postprocess_glideperf_pos();
-    _postprocess_glideperf_vel();
-    // hook more postprocessing functions in here, if you write new ones.
+    for (unsigned int k = 0; k < get_num_postprocessors(); k++) {
+        run_postprocessor(k);
+    }
+}
+
+bool MavSystem::_is_postprocessor_output(const std::string & fullname) {
+    for (unsigned int k = 0; k < get_num_postprocessors(); k++) {
+        for (const char*const*o = _postprocessors[k].outputs; *o; ++o) {
+            if (fullname == *o) return true;
+        }
+    }
+    return false;
+}
+
+void MavSystem::_mark_changed(const std::string & fullname, double from_epoch_sec) {
+    std::map<std::string, double>::iterator it = _changed.find(fullname);
+    if (it == _changed.end()) {
+        _changed.insert(std::make_pair(fullname, from_epoch_sec));
+    } else if (from_epoch_sec < it->second) {
+        it->second = from_epoch_sec;
+    }
+}
+
+/**
+ * @param from_epoch_sec returns earliest change of any input
+ * @return true if any input of pp is in _changed
+ */
+bool MavSystem::_postprocessor_affected(const postprocessor_t & pp, double & from_epoch_sec) const {
+    bool affected = false;
+    for (const char*const*i = pp.inputs; *i; ++i) {
+        for (std::map<std::string, double>::const_iterator it = _changed.begin(); it != _changed.end(); ++it) {
+            if (!_pattern_matches(*i, it->first.c_str())) continue;
+            if (!affected || it->second < from_epoch_sec) from_epoch_sec = it->second;
+            affected = true;
+        }
+    }
+    return affected;
+}
+
+void MavSystem::_postprocess_changed(void) {
+    for (unsigned int k = 0; k < get_num_postprocessors(); k++) {
+        const postprocessor_t & pp = _postprocessors[k];
+        double from_epoch_sec = 0.;
+        if (!_postprocessor_affected(pp, from_epoch_sec)) continue;
+
+        _pp_from_sec = from_epoch_sec;
+        run_postprocessor(k);
+        _pp_from_sec = 0.;
+
+        // later ones reading these must recompute, since we do not know what was redone
+        for (const char*const*o = pp.outputs; *o; ++o) {
+            if (strcmp(*o, "*")) _mark_changed(*o, 0.);
+        }
+    }
+    _changed.clear();
 }
 
 int MavSystem::update_rel_time(uint64_t nowtime_relative_usec, bool allowjumps){
@@ -1541,6 +2093,7 @@ int MavSystem::update_rel_time(uint64_t nowtime_relative_usec, bool allowjumps){
     if (diff < -_time_maxbackjump_sec && !allowjumps) {
         _log(MSG_WARN, stringbuilder() << " # " << id << " !!! ignoring timestamp that is too old: -" << diff << " s");
         ret = -1; // backward jump
+        _time_lastjump_sec = diff;
     } else if ((diff > _time_maxfwdjump_sec) && !allowjumps) {
         /* some MavLink tlogs actually *have* huge jumps that are correct. Two reasons:
          *  1. presumably such files just don't start soon after boot, but some time later,
@@ -1549,6 +2102,7 @@ int MavSystem::update_rel_time(uint64_t nowtime_relative_usec, bool allowjumps){
          */
         _log(MSG_WARN, stringbuilder() << " # " << id << " !!! ignoring timestamp that fast-forwarded by " << diff << " s");
         ret = 1; // forward jmp
+        _time_lastjump_sec = diff;
     } else {
         if (cand_time < _time_min) _time_min = cand_time;
         if (cand_time > _time_max) _time_max = cand_time;
@@ -1577,8 +2131,8 @@ unsigned long MavSystem::get_time_active_end_usec() const {
     /******************************************
      *  FIND MAX TIME OF ALL DATA
      ******************************************/
-    for (data_accessmap::const_iterator it = _data_from_path.begin(); it != _data_from_path.end(); ++it) {
-        const Data*const d = it->second;
+    for (unsigned int id = 0; id < _paths.size(); ++id) {
+        const Data*const d = _paths.node(id).data;
         if (d) {
             unsigned long tmax_epoch_usec = d->get_epoch_dataend();
             if (tmax_epoch_usec > tmax) { tmax = tmax_epoch_usec; }
@@ -1604,8 +2158,8 @@ unsigned long MavSystem::get_time_active_begin_usec(void) const {
     /******************************************
      *  FIND MIN TIME OF ALL DATA
      ******************************************/
-    for (data_accessmap::const_iterator it = _data_from_path.begin(); it != _data_from_path.end(); ++it) {
-        const Data*const d = it->second;
+    for (unsigned int id = 0; id < _paths.size(); ++id) {
+        const Data*const d = _paths.node(id).data;
         if (d) {
             unsigned long tmin_epoch_usec = d->get_epoch_datastart();
             if (tmin_epoch_usec < tmin) { tmin = tmin_epoch_usec; }
@@ -1620,24 +2174,162 @@ void MavSystem::get_mavlink_stats(MavSystem::mavlink_summary_t & ret) const {
 
 // DONE
 bool MavSystem::merge_in(const MavSystem * const other) {
-    // copy data inside, the datagroup is not copied but created with our own functions again
+    return _merge_from_all(std::vector<const MavSystem*>(1, other), false);
+}
+
+bool MavSystem::take_in(MavSystem * const other) {
+    return _merge_from_all(std::vector<const MavSystem*>(1, other), true);
+}
+
+bool MavSystem::merge_in_all(const std::vector<const MavSystem*> & others) {
+    return _merge_from_all(others, false);
+}
+
+bool MavSystem::take_in_all(const std::vector<MavSystem*> & others) {
+    return _merge_from_all(std::vector<const MavSystem*>(others.begin(), others.end()), true);
+}
+
+bool MavSystem::_merge_from_all(const std::vector<const MavSystem*> & others, bool take) {
+    /*
+     * collect the sources of each path over all others first, so that every data item
+     * is merged once with all of its sources (k-way) instead of once per other system.
+     * The datagroups are not copied but created with our own functions again.
+     */
+    std::vector<std::string> order; ///< paths in order of first appearance
+    std::map<std::string, std::vector<const Data*> > sources;
+    for (std::vector<const MavSystem*>::const_iterator ito = others.begin(); ito != others.end(); ++ito) {
+        const MavSystem*const other = *ito;
+        if (!other || other == this) continue;
+        for (unsigned int id = 0; id < other->_paths.size(); ++id) {
+            const Data*const data = other->_paths.node(id).data;
+            if (!data) continue;
+            const std::string & fullname = other->_paths.node(id).path;
+            std::vector<const Data*> & list = sources[fullname];
+            if (list.empty()) order.push_back(fullname);
+            list.push_back(data);
+        }
+    }
+
     bool added=false;
-    for (data_accessmap::const_iterator ito = other->_data_from_path.begin(); ito != other->_data_from_path.end(); ++ito) {
-        const Data*const data = ito->second;
-        if (!_add_data(data)) {
-            _log(MSG_WARN, stringbuilder() << "WARNING: skipped data " << data->get_name() << " because it could not be merged");
+    for (std::vector<std::string>::const_iterator itp = order.begin(); itp != order.end(); ++itp) {
+        const std::string & fullname = *itp;
+        std::vector<const Data*> & list = sources[fullname];
+        Data * mydata = _get_data<Data>(fullname);
+        if (_is_postprocessor_output(fullname)) {
+            if (mydata) continue; // ours is extended or recomputed below from the merged inputs
+            list.resize(1); // the others would be recomputed anyway
+        }
+
+        double epoch_start_sec = list.front()->get_epoch_datastart()/1E6; // before data could be taken
+        for (std::vector<const Data*>::const_iterator it = list.begin(); it != list.end(); ++it) {
+            epoch_start_sec = std::min(epoch_start_sec, (*it)->get_epoch_datastart()/1E6);
+        }
+
+        bool ok;
+        if (!mydata || !mydata->is_present()) {
+            // first one makes the item, the rest is merged into it
+            ok = _add_data(list.front(), take);
+            mydata = _get_data<Data>(fullname);
+            if (ok && mydata && list.size() > 1) {
+                ok = mydata->merge_in_all(std::vector<const Data*>(list.begin() + 1, list.end()));
+            }
+        } else {
+            ok = mydata->merge_in_all(list);
+        }
+        if (!ok) {
+            _log(MSG_WARN, stringbuilder() << "WARNING: skipped data " << fullname << " because it could not be merged");
             // return false;
         } else {
             added = true;
+            _mark_changed(fullname, epoch_start_sec);
         }
     }
     if (added) {
-        postprocess();
+        _postprocess_changed();
         determine_absolute_time();
     }
     return true;
 }
 
+unsigned int MavSystem::compress_data(void) {
+    unsigned int n = 0;
+    for (unsigned int id = 0; id < _paths.size(); ++id) {
+        DataTimed*const d = dynamic_cast<DataTimed*>(_paths.node(id).data);
+        if (d && d->compress()) n++;
+    }
+    _log(MSG_INFO, stringbuilder() << "(#" << id << "): " << n << " data items compressed");
+    return n;
+}
+
+size_t MavSystem::get_data_bytes(void) const {
+    size_t n = 0;
+    for (unsigned int id = 0; id < _paths.size(); ++id) {
+        const DataTimed*const d = dynamic_cast<const DataTimed*>(_paths.node(id).data);
+        if (d) n += d->get_bytes();
+    }
+    return n;
+}
+
+void MavSystem::get_memory(memuse_t & m) const {
+    for (unsigned int id = 0; id < _paths.size(); ++id) {
+        const Data*const d = _paths.node(id).data;
+        if (d) d->get_memory(m);
+    }
+}
+
+size_t MavSystem::shrink_data(void) {
+    size_t freed = 0;
+    for (unsigned int id = 0; id < _paths.size(); ++id) {
+        Data*const d = _paths.node(id).data;
+        if (d) freed += d->shrink_to_fit();
+    }
+    if (freed > 0) {
+        _log(MSG_INFO, stringbuilder() << "(#" << id << "): " << memuse_t::format(freed) << " of unused capacity freed");
+    }
+    return freed;
+}
+
+void MavSystem::seal_data(void) {
+    for (unsigned int id = 0; id < _paths.size(); ++id) {
+        DataTimed*const d = dynamic_cast<DataTimed*>(_paths.node(id).data);
+        if (d) d->seal_times();
+    }
+}
+
+void MavSystem::get_all_data(std::vector<const Data*> & out) const {
+    for (unsigned int id = 0; id < _paths.size(); ++id) {
+        const Data*const d = _paths.node(id).data;
+        if (d) out.push_back(d);
+    }
+}
+
+unsigned int MavSystem::mark_raw_inputs(void) {
+    std::set<const Data*> inputs;
+    for (unsigned int k = 0; k < get_num_postprocessors(); k++) {
+        for (const char*const*i = _postprocessors[k].inputs; *i; ++i) {
+            if (!strcmp(*i, "*")) continue;
+            const Data*const d = _get_data<Data>(*i, true); // exactly what the postprocessor gets
+            if (d) inputs.insert(d);
+        }
+    }
+    unsigned int n = 0;
+    for (unsigned int id = 0; id < _paths.size(); ++id) {
+        const PathTable::node_t & node = _paths.node(id);
+        if (!node.data || _is_postprocessor_output(node.path)) continue;
+        const bool raw = inputs.find(node.data) != inputs.end();
+        node.data->set_raw_input(raw);
+        if (raw) n++;
+    }
+    return n;
+}
+
+void MavSystem::get_spill_candidates(std::vector<DataTimed*> & out) {
+    for (unsigned int id = 0; id < _paths.size(); ++id) {
+        DataTimed*const d = dynamic_cast<DataTimed*>(_paths.node(id).data);
+        if (d && d->get_bytes() > 0) out.push_back(d);
+    }
+}
+
 void MavSystem::update_time_offset_guess(uint64_t nowtime_relative_usec, uint64_t epoch_usec) {
     assert(nowtime_relative_usec <= epoch_usec); // FIXME: assert is böse
     if (epoch_usec > 0) {  _time_offset_guess_usec = epoch_usec - nowtime_relative_usec; }
@@ -1687,7 +2379,8 @@ void MavSystem::determine_absolute_time() {
     }    
 
     // apply to all data
-    for (data_accessmap::iterator it = _data_from_path.begin(); it != _data_from_path.end(); ++it) {
-        it->second->set_epoch_datastart(_time_offset_usec);
+    for (unsigned int id = 0; id < _paths.size(); ++id) {
+        Data*const d = _paths.node(id).data;
+        if (d) d->set_epoch_datastart(_time_offset_usec);
     }
 }
@@ -31,11 +31,16 @@
 #include <ostream>
 #include <typeinfo>
 #include <set>
+#include <map>
+#include <QMutex>
+#include <QMutexLocker>
 #include "data_timeseries.h" // FIXME: use data_timed and data_untimed
 #include "data_param.h"
 #include "data_event.h"
 #include "data.h"
 #include "datagroup.h"
+#include "pathtable.h"
+#include "arena.h"
 #include "mavsystem_macros.h"
 #include "debugtype.h"
 #include "logger.h"
@@ -49,6 +54,9 @@
 #define MAVTYPE_INIT 0x0
 #define MAVAPTYPE_INIT 0x0
 
+class Expression;
+class ConditionSearch;
+
 class MavSystem
 {
 private:    
@@ -69,7 +77,24 @@ private:
      * child and finally register "heading" as data in "nav"
      */
     void _data_register_hierarchy(const std::string &fullpath, Data *item);
-    void _data_unregister_hierarchy(Data*const src);
+    void _data_unregister_hierarchy(int id);
+    int _get_or_add_group(const std::string &fullpath, size_t len);
+
+#ifdef WITH_DATAREGEX
+    /**
+     * @brief regex lookup behind _get_data(). Results are memoized until a path is
+     * added or removed. Patterns like "\\bPN\\b" are answered from the word index,
+     * plain strings like "GPS/Spd" by substring search, everything else by a scan
+     * with a cached QRegExp.
+     * @return first matching data in alphabetical order of paths, or NULL
+     */
+    Data* _find_data_regex(const std::string &pattern) const;
+    Data* _find_data_words(const std::vector<std::string> & words) const;
+    Data* _find_data_scan(const std::string &pattern, bool literal) const;
+    static bool _parse_word_pattern(const std::string &pattern, std::vector<std::string> & words);
+    static void _split_words(const std::string &path, std::vector<std::string> & words);
+    void _index_words(int id, bool add);
+#endif
 
     /**
      * @brief compute synthetic data based on raw data: takeoffs, landings, flight time
@@ -82,6 +107,29 @@ private:
 
     void _log(logmsgtype_e t, const std::string & str);
 
+    /**
+     * @brief a postprocessor and the data it reads and writes. Entries are patterns as
+     * for get_data(..., true), "*" means everything. Lists end with NULL.
+     */
+    typedef void (MavSystem::*Postprocess_Function)(void);
+    typedef struct postprocessor_s {
+        const char*          name;
+        Postprocess_Function func;
+        const char*const*    inputs;
+        const char*const*    outputs;
+    } postprocessor_t;
+    static const postprocessor_t _postprocessors[]; ///< in order of precedence. Add new ones here.
+    static bool _postprocessors_conflict(const postprocessor_t & earlier, const postprocessor_t & later);
+    static bool _pattern_matches(const char*pattern, const char*name);
+    static bool _is_postprocessor_output(const std::string & fullname);
+
+    /**
+     * @brief after merge_in(): rerun only those postprocessors whose inputs changed
+     */
+    void _postprocess_changed(void);
+    bool _postprocessor_affected(const postprocessor_t & pp, double & from_epoch_sec) const;
+    void _mark_changed(const std::string & fullname, double from_epoch_sec);
+
 #if 0
     /**
      * @brief shortcut to create new data
@@ -95,9 +143,12 @@ private:
     /**
      * @brief insert data from somwhere else to this; merges src into this, if the data already exists.
      * @param d data to be added
+     * @param take if true, src may be emptied instead of copied (see Data::Take()). This is
+     *        only allowed if src is not const, but it spares us another _add_data().
      * @return true if data was inserted, else false
      */
-    bool _add_data(const Data*const src);
+    bool _add_data(const Data*const src, bool take = false);
+    bool _merge_from_all(const std::vector<const MavSystem*> & others, bool take);
     void _del_data(Data*const src);
 
     void _data_cleanup();   
@@ -108,18 +159,44 @@ private:
      */
     template <typename DT>
     inline DT *_get_and_possibly_create_data(const std::string &fullpath, const std::string & units) {
-        // look in map if exists, else register.
-        data_accessmap::iterator it = _data_from_path.find(fullpath);
-        if (it != _data_from_path.end()) {            
-            DT*ret = dynamic_cast< DT *> (it->second);
+        // look in table if exists, else register.
+        QMutexLocker lock(_registry_lock);
+        const int id = _paths.find(fullpath);
+        if (id >= 0 && _paths.node(id).data) {
+            Data*const d = _paths.node(id).data;
+            DT*ret = dynamic_cast< DT *> (d);
             if (!ret) {
-                std::cerr << "ERROR: type mismatch. Data " << fullpath << " exists with type=" << it->second->get_typename() << ", but asked for a different type" << std::endl;
+                std::cerr << "ERROR: type mismatch. Data " << fullpath << " exists with type=" << d->get_typename() << ", but asked for a different type" << std::endl;
             }
             return ret;
         }
         return _new_data<DT>(fullpath, units);
     }
 
+    /**
+     * @brief same as _get_and_possibly_create_data(), but remembers the result in a slot,
+     * such that later calls only cost an index. Slots are numbered per call site of
+     * MAVSYSTEM_DATA_ITEM (see _new_slots()), and filled per system. They are looked
+     * up again when data was added or removed, since the pointer might be stale.
+     */
+    template <typename DT>
+    inline DT *_get_slot_data(unsigned int slot, const char*fullpath, const char*units) {
+        QMutexLocker lock(_registry_lock);
+        if (slot >= _slots.size()) _slots.resize(slot + 1);
+        slot_t & s = _slots[slot];
+        if (!s.data || s.version != _paths_version) {
+            s.data = _get_and_possibly_create_data<DT>(fullpath, units);
+            s.version = _paths_version;
+        }
+        return static_cast<DT*>(s.data); // only a DT gets in
+    }
+
+    /**
+     * @brief reserve n successive slots for _get_slot_data(), the same for all systems
+     * @return number of first slot
+     */
+    static unsigned int _new_slots(unsigned int n) { return _num_slots.fetchAndAddRelaxed(n); }
+
     /**
      * @brief this internal function returns a ptr to a data item.
      * @return non-const ptr, where data can be modified
@@ -128,21 +205,16 @@ private:
     template <typename DT>
     DT *_get_data(const std::string &fullpath, bool is_regex=false) const {
         // look in map if exists, else register.
+        QMutexLocker lock(_registry_lock);
         if (!is_regex) {
-            data_accessmap::const_iterator it = _data_from_path.find(fullpath);
-            if (it != _data_from_path.end()) {
-                return dynamic_cast< DT *> (it->second);
+            const int id = _paths.find(fullpath);
+            if (id >= 0 && _paths.node(id).data) {
+                return dynamic_cast< DT *> (_paths.node(id).data);
             }
         }
 #ifdef WITH_DATAREGEX
         else {
-            QRegExp rx(QString::fromStdString(fullpath));
-            for (data_accessmap::const_iterator it = _data_from_path.begin(); it != _data_from_path.end(); ++it) {
-                bool match = rx.indexIn(QString::fromStdString(it->first)) >= 0;
-                if (match) {
-                    return dynamic_cast< DT *> (it->second);
-                }
-            }
+            return dynamic_cast< DT *> (_find_data_regex(fullpath));
         }
 #endif
         return NULL;
@@ -164,7 +236,11 @@ private:
             basename = fullname.substr(basenamestart+1);
         }
 
-        T*tmp = new T(basename);
+        T*tmp;
+        {
+            QMutexLocker lock(_registry_lock); // arena is shared by concurrent postprocessors
+            tmp = new (_arena) T(basename);
+        }
         tmp->set_units(units);
         _data_register_hierarchy(fullname, dynamic_cast<Data*>(tmp));
         return tmp;
@@ -176,16 +252,28 @@ public:
      * TYPEDEFS
      **********************/
 
+    /**
+     * @brief what the handler of one MAVLink message type did
+     */
+    typedef struct mavlink_msgstat_s {
+        unsigned long      count; ///< messages handled
+        unsigned long long nsec;  ///< time spent in the handler. Only measured while the Profiler is enabled.
+        mavlink_msgstat_s() : count(0), nsec(0) {}
+    } mavlink_msgstat_t;
+
     /**
      * @brief summarizing information about a mavlink connection
      */
     typedef struct mavlink_summary_s {
-        unsigned long          num_received; ///< total number of incoming messages = sum (recognized + error + uninterpreted)
+        unsigned long          num_received; ///< total number of incoming messages = sum (recognized + error + uninterpreted + disabled)
         unsigned long          num_interpreted; ///< number of messages that MavLogANalyzer did implement
         unsigned long          num_uninterpreted; ///< number of messages that MavLogAnalyzer doesn't implement, i.e., they were parsed but ignored.
+        unsigned long          num_disabled; ///< number of messages which the user did not select, see TopicFilter
         unsigned long          num_error; ///< number of broken messages (e.g., invalid CRC)        
         std::set<unsigned int> mavlink_msgids_interpreted; ///< set of all evaluated MAVLink message IDs
         std::set<unsigned int> mavlink_msgids_uninterpreted; ///< set of all unknown and thusly ignored MAVLink message IDs
+        std::set<unsigned int> mavlink_msgids_disabled; ///< set of all MAVLink message IDs skipped for the user
+        std::map<unsigned int, mavlink_msgstat_t> msgstats; ///< by msgid, for the interpreted ones
         // more internal stuff:
         unsigned int           _link_throughput_bytes; ///< this collects the number of bytes that were sent between two time references; so it is NOT the actual throughput
     } mavlink_summary_t;
@@ -196,6 +284,7 @@ public:
     typedef enum  {
         MAVLINK_INTERPRETED, ///< could be parsed, and was evaluated with track_()
         MAVLINK_UNINTERPRETED, ///< could be parsed, but was NOT processed
+        MAVLINK_DISABLED, ///< could be processed, but the user did not select it
         MAVLINK_ERROR ///< problem parsing
     } mavlink_parsed_e;
 
@@ -207,6 +296,7 @@ public:
     ~MavSystem();
     std::string _mavtype2str(uint8_t mtype);
     std::string _aptype2str(uint8_t atype);
+    std::string _describe_msgstats(void) const;
     void track_system(uint8_t stype, uint8_t status, uint8_t autopilot, uint8_t basemode, uint8_t custmode);
     void track_system_errors(uint16_t errors_count [4]);
     void track_statustext(const char*text, uint8_t severity);
@@ -230,7 +320,7 @@ public:
     void track_radio(uint8_t rssi);
     void track_radio_droprate(float percent);
     void track_nav(float nav_roll_deg, float nav_pitch_deg, float nav_bear_deg, float tar_bear_deg, float wp_dist_m, float err_alt_m, float err_airspeed_ms, float err_xtrack_m);
-    void track_mavlink(unsigned int data_length_bytes, unsigned int msgid, mavlink_parsed_e whatwasdone);
+    void track_mavlink(unsigned int data_length_bytes, unsigned int msgid, mavlink_parsed_e whatwasdone, unsigned long long handler_nsec = 0);
     // FIXME: ugly, but one message can have invalid fields, so we need separate fcns for HIGHRES_IMU:
     void track_imu_highres_acc(const float acc_ms[]);
     void track_imu_highres_gyr(const float gyr_rs[]);
@@ -252,6 +342,13 @@ public:
         return id;
     }
 
+    /**
+     * @brief changes whenever data is added or removed, e.g., to know when a view of the tree is outdated
+     */
+    unsigned int get_paths_version(void) const {
+        return _paths_version;
+    }
+
     /**
      * @brief this function will directly enqueue the data under the given path
      * @param fullname
@@ -260,7 +357,7 @@ public:
      */
     template <typename T1>
     DataTimeseries<T1>* track_generic_timeseries(const std::string & fullname, const T1 & arg_data, const std::string &units = "") {
-        MAVSYSTEM_DATA_ITEM(DataTimeseries<T1>, data, fullname, units);
+        DataTimeseries<T1>*const data = _get_and_possibly_create_data< DataTimeseries<T1> >(fullname, units);
         if (!data) return NULL;
         data->add_elem(arg_data, _time);
         return data;
@@ -268,7 +365,7 @@ public:
 
     template <typename T2>
     DataParam<T2>* track_generic_untimed(const std::string & fullname, const T2 & arg_data, const std::string &units = "") {
-        MAVSYSTEM_DATA_ITEM(DataParam<T2>, data, fullname, units);
+        DataParam<T2>*const data = _get_and_possibly_create_data< DataParam<T2> >(fullname, units);
         if (!data) return NULL;
         data->add_elem(arg_data, _time);
         return data;
@@ -276,12 +373,42 @@ public:
 
     template <typename T3>
     DataEvent<T3>* track_generic_event(const std::string & fullname, const T3 & arg_data, const std::string &units = "") {
-        MAVSYSTEM_DATA_ITEM(DataEvent<T3>, data, fullname, units);
+        DataEvent<T3>*const data = _get_and_possibly_create_data< DataEvent<T3> >(fullname, units);
         if (!data) return NULL;
         data->add_elem(arg_data, _time);
         return data;
     }
 
+    /**
+     * @brief same as above, but for callers which keep the pointer returned by the
+     * first call. This skips building the name and looking it up.
+     * @param data must belong to this system
+     */
+    template <typename T1>
+    void track_generic_timeseries(DataTimeseries<T1>*data, const T1 & arg_data) {
+        data->add_elem(arg_data, _time);
+    }
+
+    template <typename T3>
+    void track_generic_event(DataEvent<T3>*data, const T3 & arg_data) {
+        data->add_elem(arg_data, _time);
+    }
+
+    /**
+     * @brief many samples at once, each with its own time stamp (see get_time()), e.g., for
+     * OnboardLogParser::get_batch(). Series of the same message keep sharing their time column.
+     * @param values n values, converted to T1
+     */
+    template <typename T1, typename S>
+    void track_generic_timeseries(DataTimeseries<T1>*data, const S * values, const double * times, size_t n) {
+        data->add_elems_shared(values, times, n);
+    }
+
+    template <typename T3>
+    void track_generic_event(DataEvent<T3>*data, const T3 * values, const double * times, size_t n) {
+        for (size_t k = 0; k < n; ++k) data->add_elem(values[k], times[k]);
+    }
+
     /**
      * @brief same as _get_data(), but for external use, where
      * the returned pointer is const.
@@ -317,6 +444,35 @@ public:
      */
     void postprocess();    
 
+    /**
+     * @brief for running postprocessors concurrently, see MavlinkScenario::process().
+     * Postprocessors of the same stage (of one or of different systems) are independent
+     * and can run at the same time, but only between begin_concurrent() and end_concurrent().
+     */
+    static unsigned int get_num_postprocessors(void);
+    static unsigned int get_postprocessor_stage(unsigned int k);
+    static const char* get_postprocessor_name(unsigned int k);
+    void run_postprocessor(unsigned int k);
+
+    /**
+     * @brief compute a user-defined series after the postprocessors. Its inputs are brought
+     * onto the union of their time stamps (see Resampler); points where any of them has no
+     * value are left out.
+     * @return false if this system lacks an input (which is common and not logged), or the
+     * output cannot be created. Output is cleared then.
+     */
+    bool apply_expression(const Expression & e);
+
+    /**
+     * @brief run a query on this system and put its result into SEARCH_GROUP, one event
+     * per interval where the query holds, at its start. Paths are looked up as they are,
+     * else as patterns (e.g., "airspeed" finds "airstate/airspeed").
+     * @return number of intervals found, -1 if this system lacks a series of the query
+     */
+    int apply_search(const ConditionSearch & q);
+    void begin_concurrent(void) { _registry_lock = &_registry_mutex; }
+    void end_concurrent(void) { _registry_lock = NULL; }
+
     /**
      * @brief call this to indicate current relative time. all subsequent calls to track_*() will assume this time.
      * @param nowtime_relative_usec current time since system boot (or whatever) in microsecs
@@ -330,6 +486,11 @@ public:
         return ((uint64_t)(_time * 1E6));
     }
 
+    /**
+     * @brief the time the track_*() functions use, in seconds
+     */
+    double get_time(void) const { return _time; }
+
     /**
      * @brief call this before you track any new message.
      */
@@ -371,6 +532,51 @@ public:
      */
     void shift_time(double delay);
 
+    /**
+     * @brief store all time series compressed, see DataTimeseries::compress()
+     * @return number of data items that are compressed now
+     */
+    unsigned int compress_data(void);
+
+    /**
+     * @return approx. memory taken by the samples of all data, see DataTimed::get_bytes()
+     */
+    size_t get_data_bytes(void) const;
+
+    /**
+     * @brief memory of all data of this system, see Data::get_memory()
+     */
+    void get_memory(memuse_t & m) const;
+
+    /**
+     * @brief Data::shrink_to_fit() for all data, e.g., when the import is done
+     * @return bytes freed
+     */
+    size_t shrink_data(void);
+
+    /**
+     * @brief DataTimed::seal_times() for all data: appending stops, readers may follow in parallel
+     */
+    void seal_data(void);
+
+    /**
+     * @brief append all data items of this system to out, in the order they were registered
+     */
+    void get_all_data(std::vector<const Data*> & out) const;
+
+    /**
+     * @brief Data::set_raw_input() for the logged data which the postprocessors read,
+     * e.g., battery voltage and current for the power statistics
+     * @return number of data items marked
+     */
+    unsigned int mark_raw_inputs(void);
+
+    /**
+     * @brief append all time series whose samples still take memory (see DataTimed::get_bytes())
+     * to out, in the order they were registered
+     */
+    void get_spill_candidates(std::vector<DataTimed*> & out);
+
     /**
      * @brief if two successive messages exhibit large differences in their time stamps, they get ignored.
      *        This function can be used to set the margin for the time difference.
@@ -391,6 +597,13 @@ public:
         return _time_maxbackjump_sec;
     }
 
+    /**
+     * @return size of the last time jump which update_rel_time() rejected, in seconds. Negative=backward.
+     */
+    double get_last_timejump(void) const {
+        return _time_lastjump_sec;
+    }
+
     /**
      * @brief returns a textual summary of the system
      * @param buf where to write the text
@@ -422,6 +635,23 @@ public:
      */
     bool merge_in(const MavSystem *const other);
 
+    /**
+     * @brief same as merge_in(), but takes the samples out of other instead of copying them,
+     * where this does not have the data yet. Other is left with empty data items.
+     */
+    bool take_in(MavSystem *const other);
+
+    /**
+     * @brief same as calling merge_in() for each of others, but each data item is
+     * merged only once with the samples of all others, and postprocessing runs once.
+     */
+    bool merge_in_all(const std::vector<const MavSystem*> & others);
+
+    /**
+     * @brief take_in() for many systems in one pass, see merge_in_all()
+     */
+    bool take_in_all(const std::vector<MavSystem*> & others);
+
     /**
      * @brief return information about mavlink and what was ignored by MavLogAnalyzer
      * @param ret reference to variable where information is returned
@@ -447,8 +677,30 @@ private:
      *    DATA MEMBERS
      ********************************************/
     // we need this however: fullpath-to-Data mapping
-    typedef std::map<std::string, Data*> data_accessmap;
-    data_accessmap _data_from_path; ///< all data is stored flat in here, but accessing it should be done via mav_data_groups, where we have associative arrays
+    PathTable _paths; ///< all data and groups by path. Data is stored flat in here, the tree is mav_data_groups
+    Arena     _arena; ///< data items and groups created here live in here. Guarded like _paths.
+    unsigned int _paths_version; ///< incremented whenever data is added or removed
+    mutable QMutex _registry_mutex; ///< guards _paths and the lookup caches...
+    QMutex*        _registry_lock;  ///< ...if this points to it, i.e., while postprocessors run concurrently
+
+    typedef struct slot_s {
+        Data*        data;
+        unsigned int version; ///< _paths_version when data was looked up
+        slot_s() : data(NULL), version(0) {}
+    } slot_t;
+    std::vector<slot_t> _slots; ///< see _get_slot_data()
+    static QAtomicInt   _num_slots;
+
+    // incremental postprocessing
+    std::map<std::string, double> _changed; ///< data changed by merge_in() -> earliest new time (epoch sec, 0=all)
+    double _pp_from_sec; ///< while a postprocessor runs: it may keep what it computed before this epoch time. 0=recompute all
+#ifdef WITH_DATAREGEX
+    typedef std::map<std::string, std::vector<int> > word_index_t;
+    word_index_t _word_index; ///< word of a data path => ids in _paths
+    mutable std::map<std::string, Data*>   _query_results; ///< memoized _find_data_regex()
+    mutable unsigned int                   _query_version; ///< _paths_version the results are for
+    mutable std::map<std::string, QRegExp> _query_regex;   ///< compiled patterns
+#endif
 
 
     double _time; ///< this is a relative time...later we need to call update_time_offset() and apply_time_offset() to establish a binding to absolute time
@@ -457,6 +709,7 @@ private:
     double _time_max;
     double _time_maxfwdjump_sec; ///< how much seconds may pass between two data points to be regarded as connected
     double _time_maxbackjump_sec; ///< same but other direction...must be positive
+    double _time_lastjump_sec; ///< see get_last_timejump()
     bool   _have_time_update;
 
     // more data (time series, ...)
@@ -476,6 +729,7 @@ private:
     unsigned long long _dbid;
     friend class DataTreeViewModel;
     friend class DBConnector;
+    friend class ScenarioCache;
 };
 
 #endif // MAVSYSTEM_H
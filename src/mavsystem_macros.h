@@ -26,12 +26,16 @@
 
 /**
  * Convenience macro as a shorthand for conditionally creating and remembering data. E.g.:
- *   MAVSYSTEM_DATA_ITEM_OR_RETURN(DataTimeseries<float>, data_autopilot_load, "general/autopilot_load");
+ *   MAVSYSTEM_DATA_ITEM(DataTimeseries<float>, data_autopilot_load, "general/autopilot_load", "%");
  * unrolls to:
- *   DataTimeseries<float> *data_autopilot_load = _get_data<DataTimeseries<float> >(string("general/autopilot_load"));
+ *   static const unsigned int data_autopilot_load_slot = _new_slots(1);
+ *   DataTimeseries<float> *const data_autopilot_load = _get_slot_data<DataTimeseries<float> >(data_autopilot_load_slot, "general/autopilot_load", "%");
+ * The path is looked up once per system, afterwards the slot holds the pointer (see MavSystem::_get_slot_data()).
+ * Therefore the path and units must be string literals. Use _get_and_possibly_create_data() for others.
  */
 #define MAVSYSTEM_DATA_ITEM(DTYPE, VARNAME, STR_FULLPATH, STR_UNITS) \
-    DTYPE *const VARNAME = _get_and_possibly_create_data< DTYPE > (std::string( STR_FULLPATH ), std::string (STR_UNITS))
+    static const unsigned int VARNAME##_slot = _new_slots(1); \
+    DTYPE *const VARNAME = _get_slot_data< DTYPE > (VARNAME##_slot, "" STR_FULLPATH, "" STR_UNITS)
 
 /**
  * Even more convenient macro to do MAVSYSTEM_DATA_ITEM or bailout with error msg and return
@@ -42,10 +46,14 @@
         _log(MSG_ERR, stringbuilder() << "(#" << id << ") writing to data " << STR_FULLPATH << " at " << __FILE__ << ":" << __LINE__  << ". Is there a type mismatch?"); \
         return; \
     }
-// FIXME: string could be made static...does it help?
 
-#define MAVSYSTEM_DATA_ITEM_HAVEVAR(DTYPE, STR_FULLPATH, STR_UNITS) \
-    _get_and_possibly_create_data< DTYPE > (std::string( STR_FULLPATH ), std::string (STR_UNITS))
+/**
+ * Same as MAVSYSTEM_DATA_ITEM, as an expression, e.g., for arrays. The slots come from
+ *   static const unsigned int first_slot = _new_slots(n);
+ * and item k takes first_slot + k.
+ */
+#define MAVSYSTEM_DATA_ITEM_SLOT(DTYPE, SLOT, STR_FULLPATH, STR_UNITS) \
+    _get_slot_data< DTYPE > (SLOT, "" STR_FULLPATH, "" STR_UNITS)
 
 /**
  * Convenience macro to get data without knowing units
@@ -0,0 +1,124 @@
+/**
+ * @file memuse.h
+ * @brief Memory accounting of data items, groups and systems.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef MEMUSE_H
+#define MEMUSE_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+/**
+ * @brief bytes taken by data, see Data::get_memory(). Approximate: allocator overhead
+ * is not known, and what several items share is split evenly among them.
+ */
+typedef struct memuse_s {
+    size_t       payload; ///< samples in use
+    size_t       slack;   ///< reserved by containers for more samples, but unused. See Data::shrink_to_fit()
+    size_t       meta;    ///< objects, names, indexes and caches
+    size_t       spilled; ///< samples in a scratch file; not in RAM, not in total()
+    unsigned int items;   ///< number of data items counted
+
+    memuse_s() : payload(0), slack(0), meta(0), spilled(0), items(0) {}
+
+    size_t total(void) const { return payload + slack + meta; }
+
+    memuse_s & operator+=(const memuse_s & o) {
+        payload += o.payload;
+        slack += o.slack;
+        meta += o.meta;
+        spilled += o.spilled;
+        items += o.items;
+        return *this;
+    }
+
+    /**
+     * @brief count the samples of a vector
+     * @param share number of items sharing the vector; each gets its part
+     */
+    template <typename T>
+    void add_samples(const std::vector<T> & v, unsigned int share = 1) {
+        payload += v.size() * sizeof(T) / share;
+        slack += (v.capacity() - v.size()) * sizeof(T) / share;
+    }
+
+    void add_samples(const std::vector<bool> & v, unsigned int share = 1) {
+        payload += v.size() / 8 / share;
+        slack += (v.capacity() - v.size()) / 8 / share;
+    }
+
+    /**
+     * @brief count a vector as metadata, e.g., an index
+     */
+    template <typename T>
+    void add_meta(const std::vector<T> & v) { meta += v.capacity() * sizeof(T); }
+
+    /**
+     * @brief e.g. "12.3 MB"
+     */
+    static std::string format(size_t bytes) {
+        char buf[32];
+        if (bytes < 1024) {
+            snprintf(buf, sizeof(buf), "%u B", (unsigned int) bytes);
+        } else if (bytes < 1024 * 1024) {
+            snprintf(buf, sizeof(buf), "%.1f kB", bytes / 1024.);
+        } else if (bytes < 1024 * 1024 * 1024) {
+            snprintf(buf, sizeof(buf), "%.1f MB", bytes / (1024. * 1024.));
+        } else {
+            snprintf(buf, sizeof(buf), "%.2f GB", bytes / (1024. * 1024. * 1024.));
+        }
+        return buf;
+    }
+
+    /**
+     * @brief e.g. "12.3 MB (samples 10.0 MB, slack 1.0 MB, meta 1.3 MB)"
+     */
+    std::string describe(void) const {
+        std::string s = format(total()) + " (samples " + format(payload) + ", slack " + format(slack) +
+                        ", meta " + format(meta) + ")";
+        if (spilled > 0) s += ", spilled " + format(spilled);
+        return s;
+    }
+} memuse_t;
+
+/**
+ * @brief give back the capacity which a vector does not use. C++98 has no shrink_to_fit().
+ * Vectors with little slack are left alone, since the copy would cost more than it saves.
+ * @return bytes freed
+ */
+template <typename T>
+size_t shrink_vector(std::vector<T> & v) {
+    const size_t slack = v.capacity() - v.size();
+    if (slack == 0 || slack < v.capacity() / 16) return 0;
+    std::vector<T>(v).swap(v);
+    return (slack - (v.capacity() - v.size())) * sizeof(T);
+}
+
+inline size_t shrink_vector(std::vector<bool> & v) {
+    const size_t slack = v.capacity() - v.size();
+    if (slack == 0 || slack < v.capacity() / 16) return 0;
+    std::vector<bool>(v).swap(v);
+    return (slack - (v.capacity() - v.size())) / 8;
+}
+
+#endif // MEMUSE_H
@@ -0,0 +1,157 @@
+/**
+ * @file mpscring.h
+ * @brief Bounded lock-free ring buffer for any number of producer threads and one consumer thread.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef MPSCRING_H
+#define MPSCRING_H
+
+#include <vector>
+#include <QAtomicInt>
+
+/**
+ * @brief Ring of preallocated slots, like SpscRing, but producers may be many threads.
+ * A producer claims a slot by moving the head forward with a compare-and-swap, fills it,
+ * and then publishes it through the sequence number of the slot. Producers never wait
+ * for each other, except when two of them race for the same slot.
+ *
+ * Producer: T*p = begin_push(ticket); if (p) { ...fill *p...; end_push(ticket); }
+ * Consumer: while ((p = begin_pop())) { ...use *p...; end_pop(); }
+ */
+template <typename T>
+class MpscRing
+{
+public:
+    /**
+     * @param capacity number of slots. Rounded up to a power of two.
+     */
+    MpscRing(unsigned int capacity) : _head(0), _tail_cache(0)
+    {
+        unsigned int n = 2;
+        while (n < capacity) n <<= 1;
+        _slots.resize(n);
+        _mask = n - 1;
+        for (unsigned int k = 0; k < n; ++k) {
+            _slots[k].seq.fetchAndStoreRelaxed((int) k);
+        }
+    }
+
+    /****************************************
+     *     PRODUCER SIDE (any thread)
+     ****************************************/
+
+    /**
+     * @param ticket filled in, to be handed to end_push()
+     * @return a claimed slot, or NULL if ring is full
+     */
+    T* begin_push(unsigned int & ticket) {
+        unsigned int pos = (unsigned int) _load_acquire(_head);
+        for (;;) {
+            slot_t & s = _slots[pos & _mask];
+            const int dif = (int) ((unsigned int) _load_acquire(s.seq) - pos);
+            if (dif == 0) {
+                if (_head.testAndSetRelaxed((int) pos, (int) (pos + 1))) {
+                    ticket = pos;
+                    return &s.item;
+                }
+                pos = (unsigned int) _load_acquire(_head);
+            } else if (dif < 0) {
+                return NULL; // consumer has not released this slot yet
+            } else {
+                pos = (unsigned int) _load_acquire(_head); // another producer was faster
+            }
+        }
+    }
+
+    /**
+     * @brief hand the slot from begin_push() over to the consumer
+     */
+    void end_push(unsigned int ticket) {
+        _store_release(_slots[ticket & _mask].seq, (int) (ticket + 1));
+    }
+
+    /****************************************
+     *     CONSUMER SIDE (one thread)
+     ****************************************/
+
+    /**
+     * @return oldest published slot, or NULL if there is none. A slot which was claimed
+     * but not yet published blocks those after it until its producer is done.
+     */
+    T* begin_pop(void) {
+        slot_t & s = _slots[_tail_cache & _mask];
+        if ((unsigned int) _load_acquire(s.seq) != _tail_cache + 1) return NULL;
+        return &s.item;
+    }
+
+    /**
+     * @brief give the slot from begin_pop() back to the producers
+     */
+    void end_pop(void) {
+        _store_release(_slots[_tail_cache & _mask].seq, (int) (_tail_cache + _mask + 1));
+        _tail_cache++;
+    }
+
+    unsigned int capacity(void) const { return _mask + 1; }
+
+private:
+    typedef struct slot_s {
+        QAtomicInt seq;  ///< ==position: free for producer; ==position+1: published for consumer
+        T          item;
+        slot_s() : seq(0) {}
+        slot_s(const slot_s & o) : seq(o.seq), item(o.item) {} // only for resize() in ctor
+    } slot_t;
+
+    static int _load_acquire(QAtomicInt & a) {
+#if (QT_VERSION >= QT_VERSION_CHECK(5,0,0))
+        return a.loadAcquire();
+#else
+        return a.fetchAndAddAcquire(0);
+#endif
+    }
+
+    static void _store_release(QAtomicInt & a, int v) {
+#if (QT_VERSION >= QT_VERSION_CHECK(5,0,0))
+        a.storeRelease(v);
+#else
+        a.fetchAndStoreRelease(v);
+#endif
+    }
+
+    // forbid copies
+    MpscRing(const MpscRing&);
+    MpscRing& operator=(const MpscRing&);
+
+    /****************************************
+     *     DATA MEMBERS
+     ****************************************/
+    std::vector<slot_t> _slots;
+    unsigned int        _mask;
+
+    // shared. Positions count up forever and wrap around; only differences matter.
+    QAtomicInt          _head; ///< next position to be claimed by a producer
+
+    // consumer only
+    char                _pad1[64];
+    unsigned int        _tail_cache;
+};
+
+#endif // MPSCRING_H
@@ -25,3 +25,84 @@
 
 
 
+
+using namespace std;
+
+static const std::string _empty;
+
+unsigned int OnboardSchema::add_field(const std::string & name, fieldkind_e kind) {
+    const int existing = find_field(name, kind);
+    if (existing >= 0) return (unsigned int) existing;
+
+    field_t f;
+    f.name = name;
+    f.kind = kind;
+    _fields.push_back(f);
+    return _fields.size() - 1;
+}
+
+int OnboardSchema::find_field(const std::string & name, fieldkind_e kind) const {
+    for (unsigned int k=0; k<_fields.size(); k++) {
+        if (_fields[k].kind == kind && _fields[k].name == name) return (int) k;
+    }
+    return -1;
+}
+
+void OnboardData::reset(const OnboardSchema*schema) {
+    _valid = false;
+    _nset = 0;
+    _schema = schema;
+    if (!schema) return;
+
+    const unsigned int n = schema->get_num_fields();
+    if (_values.size() < n) {
+        _values.resize(n);
+        _strings.resize(n);
+    }
+}
+
+const std::string & OnboardData::get_message_origname(void) const {
+    return _schema ? _schema->get_message_origname() : _empty;
+}
+
+const std::string & OnboardData::get_message_name(void) const {
+    return _schema ? _schema->get_message_name() : _empty;
+}
+
+void OnboardBatch::reset(const OnboardSchema*schema) {
+    _n = 0;
+    _schema = schema;
+    for (std::vector<column_t>::iterator it = _columns.begin(); it != _columns.end(); ++it) {
+        it->i.clear();
+        it->u.clear();
+        it->f.clear();
+        it->s.clear();
+    }
+    if (schema && _columns.size() < schema->get_num_fields()) _columns.resize(schema->get_num_fields());
+}
+
+void OnboardBatch::get_row(unsigned int row, OnboardData & out) const {
+    out.reset(_schema);
+    if (!_schema || row >= _n) return;
+    for (unsigned int k=0; k<_schema->get_num_fields(); k++) {
+        const column_t & c = _columns[k];
+        switch (_schema->get_field(k).kind) {
+        case OnboardSchema::FIELD_BOOL:
+            out.set_bool(k, c.u[row] != 0);
+            break;
+        case OnboardSchema::FIELD_INT:
+            out.set_int(k, c.i[row]);
+            break;
+        case OnboardSchema::FIELD_UINT:
+            out.set_uint(k, c.u[row]);
+            break;
+        case OnboardSchema::FIELD_FLOAT:
+            out.set_float(k, c.f[row]);
+            break;
+        case OnboardSchema::FIELD_STRING:
+            out.set_string(k, c.s[row].data(), c.s[row].size());
+            break;
+        }
+    }
+    out.set_valid(true);
+}
@@ -26,9 +26,76 @@
 
 #include <inttypes.h>
 #include <string>
-#include <map>
+#include <vector>
 
+/**
+ * @brief describes one type of onboard message: its names and its fields.
+ * Parsers register a schema once per message type (see OnboardLogParser::_new_schema),
+ * and then every sample of that type refers to it. Field ids are dense, starting from zero.
+ */
+class OnboardSchema
+{
+public:
+
+    /**********************************
+     *  TYPES
+     **********************************/
+    typedef enum {
+        FIELD_BOOL,
+        FIELD_INT,
+        FIELD_UINT,
+        FIELD_FLOAT,
+        FIELD_STRING
+    } fieldkind_e;
+
+    typedef struct field_s {
+        std::string name;
+        fieldkind_e kind;
+    } field_t;
+
+    /**********************************
+     *  METHODS
+     **********************************/
+    OnboardSchema(unsigned int id, const std::string & origname, const std::string & readablename) :
+        _id(id), _msgname_orig(origname), _msgname_readable(readablename) {}
+
+    /**
+     * @brief add a field. If a field with same name and kind exists, that one is returned.
+     * @return field id
+     */
+    unsigned int add_field(const std::string & name, fieldkind_e kind);
 
+    /**
+     * @return field id, or -1 if there is no such field
+     */
+    int find_field(const std::string & name, fieldkind_e kind) const;
+
+    /**
+     * @brief unique for all schemas of one parser instance. Can be used as index.
+     */
+    unsigned int get_id(void) const { return _id; }
+
+    const std::string & get_message_origname(void) const { return _msgname_orig; }
+    const std::string & get_message_name(void) const { return _msgname_readable; }
+
+    unsigned int get_num_fields(void) const { return _fields.size(); }
+    const field_t & get_field(unsigned int id) const { return _fields[id]; }
+
+private:
+    /**********************************
+     *  VARIABLES
+     **********************************/
+    unsigned int         _id;
+    std::string          _msgname_orig;  ///< msg name as in the log, e.g. "CTUN"
+    std::string          _msgname_readable; ///< a more readable string, e.g. "Controller Tuning"
+    std::vector<field_t> _fields;
+};
+
+/**
+ * @brief one sample of an onboard message. Values are kept in arrays indexed by the field id
+ * of the schema, so that a parser can reuse the same instance for all messages and
+ * nothing needs to be allocated once the arrays have grown.
+ */
 class OnboardData
 {
 public:
@@ -36,57 +103,130 @@ public:
     /**********************************
      *  TYPES
      **********************************/
-    typedef std::map<std::string, float> floatdata_t;
-    typedef std::map<std::string, int64_t> intdata_t;
-    typedef std::map<std::string, uint64_t>  uintdata_t;
-    typedef std::map<std::string, bool> booldata_t;
-    typedef std::map<std::string, std::string> stringdata_t;
+    typedef union {
+        bool     b;
+        int64_t  i;
+        uint64_t u;
+        float    f;
+    } value_t;
 
     /**********************************
      *  METHODS
      **********************************/
-    OnboardData() : _valid(false) {}
+    OnboardData() : _valid(false), _schema(NULL), _nset(0) {}
+
+    /**
+     * @brief start a new sample of the given type. Previous values are forgotten.
+     */
+    void reset(const OnboardSchema*schema);
 
     /**
      * @brief only if this returns true, this class carries actual data
      * @return
      */
     bool is_valid(void) const { return _valid; }
+    void set_valid(bool valid) { _valid = valid && _schema; }
+
+    /**
+     * @brief what type of message this is. NULL if not known.
+     */
+    const OnboardSchema* get_schema(void) const { return _schema; }
 
     /**
      * @brief returns a string describing the collection of data this class contains
      * @return string
      */
-    std::string get_message_origname(void) const { return _msgname_orig; }
-    std::string get_message_name(void) const { return _msgname_readable; }
+    const std::string & get_message_origname(void) const;
+    const std::string & get_message_name(void) const;
+
+    /**
+     * @brief fields [0, get_num_set()) carry a value. Parsers set fields in ascending id.
+     */
+    unsigned int get_num_set(void) const { return _nset; }
+    bool is_set(int id) const { return id >= 0 && ((unsigned int)id) < _nset; }
+
+    /**
+     * @brief write access for parsers
+     */
+    void set_bool(unsigned int id, bool v) { _values[id].b = v; _mark(id); }
+    void set_int(unsigned int id, int64_t v) { _values[id].i = v; _mark(id); }
+    void set_uint(unsigned int id, uint64_t v) { _values[id].u = v; _mark(id); }
+    void set_float(unsigned int id, float v) { _values[id].f = v; _mark(id); }
+    void set_string(unsigned int id, const char*p, unsigned int len) { _strings[id].assign(p, len); _mark(id); }
 
     /**
-     * @brief access the data
+     * @brief access the data. The kind of the field must match.
      * @return
      */
-    const floatdata_t & get_floatdata(void) const { return _float_data; }
-    const intdata_t & get_intdata(void) const { return _int_data; }
-    const uintdata_t & get_uintdata(void) const { return _uint_data; }
-    const booldata_t & get_booldata(void) const { return _bool_data; }
-    const stringdata_t & get_stringdata(void) const { return _string_data; }
+    bool get_bool(unsigned int id) const { return _values[id].b; }
+    int64_t get_int(unsigned int id) const { return _values[id].i; }
+    uint64_t get_uint(unsigned int id) const { return _values[id].u; }
+    float get_float(unsigned int id) const { return _values[id].f; }
+    const std::string & get_string(unsigned int id) const { return _strings[id]; }
 
+private:
+    void _mark(unsigned int id) { if (id >= _nset) _nset = id + 1; }
 
-public:
     /**********************************
-     *  VARIABLES (that should be private)
+     *  VARIABLES
      **********************************/
-    bool _valid;
+    bool                     _valid;
+    const OnboardSchema*     _schema;
+    unsigned int             _nset;
+    std::vector<value_t>     _values;  ///< numeric fields, by field id
+    std::vector<std::string> _strings; ///< string fields, by field id
+};
+
+/**
+ * @brief a run of samples of one onboard message type, stored column by column, for
+ * OnboardLogParser::get_batch(). Parsers append the values of each field straight to its
+ * column, and the scenario appends whole columns to the series. Every row has all fields
+ * of the schema. Columns keep their memory from one batch to the next.
+ */
+class OnboardBatch
+{
+public:
+    typedef struct column_s {
+        std::vector<int64_t>     i; ///< FIELD_INT
+        std::vector<uint64_t>    u; ///< FIELD_UINT and FIELD_BOOL
+        std::vector<float>       f; ///< FIELD_FLOAT
+        std::vector<std::string> s; ///< FIELD_STRING
+    } column_t;
+
+    OnboardBatch() : _schema(NULL), _n(0) {}
+
+    /**
+     * @brief start a new run of the given type. Previous rows are forgotten.
+     */
+    void reset(const OnboardSchema*schema);
+
+    const OnboardSchema* get_schema(void) const { return _schema; }
+
+    /**
+     * @brief number of rows
+     */
+    unsigned int size(void) const { return _n; }
+
+    /**
+     * @brief for parsers: append one value to each column, then call end_row()
+     */
+    column_t & column(unsigned int id) { return _columns[id]; }
+    void end_row(void) { _n++; }
 
-    std::string  _msgname_orig;  ///< msg name as in the log, e.g. "CTUN"
-    std::string  _msgname_readable; ///< a more readable string, e.g. "Controller Tuning"
+    const column_t & get_column(unsigned int id) const { return _columns[id]; }
 
-    // colums by type. first=col name, second=value
-    floatdata_t  _float_data;
-    intdata_t    _int_data;
-    uintdata_t   _uint_data;
-    booldata_t   _bool_data;
-    stringdata_t _string_data;
+    /**
+     * @brief one row as single sample, e.g., for messages which need to be looked at one by one
+     */
+    void get_row(unsigned int row, OnboardData & out) const;
 
+private:
+    /**********************************
+     *  VARIABLES
+     **********************************/
+    const OnboardSchema*  _schema;
+    unsigned int          _n;
+    std::vector<column_t> _columns; ///< by field id
 };
 
 #endif // ONBOARDDATA_H
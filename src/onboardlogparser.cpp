@@ -23,6 +23,83 @@
 
 #include "onboardlogparser.h"
 
+#define PRESCAN_MAX_ATTEMPTS (64*PRESCAN_HEAD_MESSAGES + PRESCAN_TAIL_BYTES) ///< reads per sample
+
+OnboardLogParser::~OnboardLogParser() {
+    for (std::vector<OnboardSchema*>::iterator it = _schemas.begin(); it != _schemas.end(); ++it) {
+        delete *it;
+    }
+    _schemas.clear();
+}
+
+/**
+ * @brief time since boot of a message, if its schema has a usual time field
+ */
+static bool prescan_time(const OnboardData & d, uint64_t & usec) {
+    const OnboardSchema*const schema = d.get_schema();
+    if (!schema) return false;
+    const std::string & name = schema->get_message_origname();
+    if (name == "GPS" || name == "vehicle_gps_position") return false; // GPS time, not boot time
+    static const char*const usec_fields[] = {"TimeUS", "t", "timestamp", "StartTime", NULL};
+    for (unsigned int k = 0; usec_fields[k]; ++k) {
+        const int id = schema->find_field(usec_fields[k], OnboardSchema::FIELD_UINT);
+        if (d.is_set(id)) {
+            usec = d.get_uint(id);
+            return true;
+        }
+    }
+    const int id = schema->find_field("TimeMS", OnboardSchema::FIELD_UINT);
+    if (d.is_set(id)) {
+        usec = d.get_uint(id) * 1000ULL;
+        return true;
+    }
+    return false;
+}
+
+bool OnboardLogParser::prescan(LogPrescan & info) {
+    if (!valid) return false;
+    info.parser = get_parser_name();
+
+    OnboardData d;
+    for (unsigned int k = 0; k <= PRESCAN_SAMPLES; ++k) {
+        unsigned int limit = PRESCAN_SAMPLE_MESSAGES;
+        if (0 == k) {
+            limit = PRESCAN_HEAD_MESSAGES; // definitions are read on the way
+        } else {
+            uint64_t offset = info.filesize * k / (PRESCAN_SAMPLES + 1);
+            if (k == PRESCAN_SAMPLES) {
+                // last sample: all until the end, for the end time
+                offset = (info.filesize > PRESCAN_TAIL_BYTES) ? info.filesize - PRESCAN_TAIL_BYTES : 0;
+                limit = (unsigned int) -1;
+            }
+            if (!_prescan_seek(offset)) break;
+        }
+        unsigned int attempts = 0; // get_data() also returns false for definitions, or at damaged parts
+        for (unsigned int n = 0; n < limit && attempts < PRESCAN_MAX_ATTEMPTS && has_more_data(); ++attempts) {
+            if (!get_data(d)) continue;
+            ++n;
+            info.add_message(d.get_message_origname());
+            uint64_t t;
+            if (prescan_time(d, t)) info.add_time(t);
+        }
+    }
+
+    // all types registered so far, also if none of their messages was sampled
+    for (std::vector<OnboardSchema*>::const_iterator it = _schemas.begin(); it != _schemas.end(); ++it) {
+        const OnboardSchema*const s = *it;
+        std::vector<std::string> fields;
+        for (unsigned int f = 0; f < s->get_num_fields(); ++f) fields.push_back(s->get_field(f).name);
+        info.add_topic(s->get_message_origname(), fields);
+    }
+    return true;
+}
+
+OnboardSchema* OnboardLogParser::_new_schema(const std::string & msgname) {
+    OnboardSchema*schema = new OnboardSchema(_schemas.size(), msgname, _make_readable_name(msgname));
+    _schemas.push_back(schema);
+    return schema;
+}
+
 /**
  * @brief assign a more readable name to the messages, s.g. "CTUN" becomes "Controller Tuning"
  * @param msgname original name as in log
@@ -26,7 +26,9 @@
 
 #include <string>
 #include "onboarddata.h"
+#include "topicfilter.h"
 #include "logger.h"
+#include "logprescan.h"
 
 #include <vector>
 #include <string>
@@ -46,15 +48,65 @@ public:
      */
     virtual bool Load (std::string filename, Logger::logchannel * ch = NULL) = 0;
 
-    OnboardLogParser() : valid(false) {}
-    virtual ~OnboardLogParser() {}
+    OnboardLogParser() : valid(false), _filter(NULL) {}
+    virtual ~OnboardLogParser();
 
     /**
      * @brief get_data
-     * @return class holding one data item. Use has_more_data before,
-     * to see whether this returs a valid result
+     * @param data is overwritten with the next data item. Pass the same instance on every
+     * call, then nothing has to be allocated. It refers to a schema which is owned by the
+     * parser, so it must not be used after the parser is deleted.
+     * @return true if data holds a valid item. Use has_more_data before.
      */
-    virtual OnboardData get_data(void) = 0;
+    virtual bool get_data(OnboardData & data) = 0;
+
+    /**
+     * @brief instead of get_data(): the next run of messages of the same type, decoded into
+     * columns. Use either this or get_data() for one log.
+     * @param batch is overwritten. Pass the same instance on every call. Like with get_data(),
+     * its schema is owned by the parser.
+     * @param max most rows. 0=as the parser likes
+     * @return true if batch holds at least one row. Use has_more_data before.
+     */
+    virtual bool get_batch(OnboardBatch & batch, unsigned int /*max*/ = 0) { batch.reset(NULL); return false; }
+
+    /**
+     * @return true if get_batch() is implemented
+     */
+    virtual bool supports_batch(void) const { return false; }
+
+    /**
+     * @brief only decode messages selected by this filter. Others are skipped by their
+     * length and get_data() returns false for them. Call before Load().
+     * @param filter NULL=everything. Must outlive the parser.
+     */
+    void set_filter(const TopicFilter*filter) { _filter = filter; }
+
+    /**
+     * @brief only return messages with time stamps in [from_usec, to_usec], in time
+     * since boot. Parsers which can, seek to the window instead of reading everything.
+     * Call after Load() and before the first get_data().
+     * @return false if not supported by this parser
+     */
+    virtual bool set_time_window(uint64_t /*from_usec*/, uint64_t /*to_usec*/) { return false; }
+
+    /**
+     * @brief for logs which are still being written: at the end, has_more_data() says false,
+     * but a message which is only partly there is read again when it is complete. Later calls
+     * of has_more_data() and get_data() return what was appended meanwhile.
+     * Call before Load().
+     * @return false if not supported by this parser
+     */
+    virtual bool set_follow(bool /*yes*/) { return false; }
+
+    /**
+     * @brief quick look at the log instead of reading it: its definitions, the messages
+     * at the beginning, and a few samples further on for the time span and message mix.
+     * Call after Load() instead of get_data(); the parser cannot be used for more afterwards.
+     * @param info filled. info.filesize must be set.
+     * @return false if the log cannot be read
+     */
+    virtual bool prescan(LogPrescan & info);
 
     /**
      * @return  name of the underlying parser
@@ -86,6 +138,29 @@ public:
 
 protected:
     std::string _make_readable_name(std::string msgname);
+
+    /**
+     * @brief register a new message type. Its readable name is made by _make_readable_name().
+     * @return the schema, owned by this class
+     */
+    OnboardSchema* _new_schema(const std::string & msgname);
+
+    /**
+     * @brief whether the message/field shall be decoded, according to filter
+     */
+    bool _wants_topic(const std::string & topic) const { return !_filter || _filter->accepts_topic(topic); }
+    bool _wants_field(const std::string & topic, const std::string & field) const { return !_filter || _filter->accepts_field(topic, field); }
+
+    /**
+     * @brief for prescan(): continue reading at the first message after this file position
+     * @return false if not supported by this parser, or there is no message
+     */
+    virtual bool _prescan_seek(uint64_t /*offset*/) { return false; }
+
+    const TopicFilter* _filter;
+
+private:
+    std::vector<OnboardSchema*> _schemas; ///< index = schema id
 };
 
 #endif // ONBOARDLOGPARSER_H
@@ -23,7 +23,9 @@
  */
 
 #include <iostream>
+#include <cstring>
 #include "stringfun.h"
+#include "filefun.h"
 #include "onboardlogparser_apm.h"
 
 const std::string &OnboardLogParserAPM::get_filename(void) const {
@@ -31,182 +33,347 @@ const std::string &OnboardLogParserAPM::get_filename(void) const {
 }
 
 OnboardLogParserAPM::~OnboardLogParserAPM() {
+    _close();
 }
 
-OnboardLogParserAPM::OnboardLogParserAPM() : _filename(""), _logchannel(NULL) {
-    valid = _parser.init(_filename.c_str());
+OnboardLogParserAPM::OnboardLogParserAPM() : _filename(""), _fp(NULL), _logchannel(NULL), _rpos(0), _rlen(0),
+    _line_rest(NULL), _line_end(NULL) {
+    valid = false;
+}
 
-    if (valid) {
-        _parser.set_enclosed_char(enclosure_char, ENCLOSURE_NONE);
-        _parser.set_field_term_char(field_terminator);
-        _parser.set_line_term_char(line_terminator);
+void OnboardLogParserAPM::_close(void) {
+    if (_fp) {
+        fclose(_fp);
+        _fp = NULL;
     }
+    _rpos = 0;
+    _rlen = 0;
+}
+
+/**
+ * @brief strip blanks (and NUL) from both ends of a token, like string_trim() did
+ */
+OnboardLogParserAPM::token_t OnboardLogParserAPM::_trim(const token_t & t) {
+    token_t r = t;
+    while (r.len > 0 && (isspace((unsigned char)r.p[0]) || r.p[0] == 0)) {
+        r.p++;
+        r.len--;
+    }
+    while (r.len > 0 && (isspace((unsigned char)r.p[r.len-1]) || r.p[r.len-1] == 0)) {
+        r.len--;
+    }
+    return r;
+}
 
+bool OnboardLogParserAPM::_equals(const token_t & t, const char*str) {
+    const unsigned int n = strlen(str);
+    return (t.len == n && 0 == memcmp(t.p, str, n));
 }
 
 /**
- * @brief parse a csv row into a class.
- * @param row data is read from here.
- * @param data class instance. Data is written to here.
- * @return true if parsed, else false
+ * @brief move unread data to the front of _buf and append the next block of the file
+ * @return false if nothing was added
+ */
+bool OnboardLogParserAPM::_fill(void) {
+    if (!_fp) return false;
+
+    const unsigned int remain = _rlen - _rpos;
+    if (_rpos > 0 && remain > 0) {
+        memmove(&_buf[0], &_buf[_rpos], remain);
+    }
+    _rpos = 0;
+    _rlen = remain;
+    if (_buf.size() - _rlen < read_blocksize) {
+        _buf.resize(_rlen + read_blocksize); // a line longer than the block: grow
+    }
+
+    const size_t n = fread(&_buf[_rlen], 1, _buf.size() - _rlen, _fp);
+    _rlen += n;
+    return (n > 0);
+}
+
+/**
+ * @brief find the next line in the buffer and put its first field into _tokens.
+ * The tokens point into _buf, nothing is copied. The other fields follow with _split_line(),
+ * which is not necessary if the line is skipped anyway.
+ * @return false at end of file
+ */
+bool OnboardLogParserAPM::_next_line(void) {
+    _tokens.clear();
+
+    const char*eol = NULL;
+    unsigned int searched = 0;
+    for (;;) {
+        if (_rpos < _rlen) {
+            eol = (const char*) memchr(&_buf[_rpos + searched], line_terminator, _rlen - _rpos - searched);
+            if (eol) break;
+        }
+        searched = _rlen - _rpos;
+        if (!_fill()) break;
+    }
+    if (_rpos >= _rlen) return false;
+
+    const char*begin = &_buf[_rpos];
+    const char*end;
+    if (eol) {
+        end = eol;
+        _rpos = (eol - &_buf[0]) + 1;
+    } else {
+        end = &_buf[0] + _rlen; // last line without terminator
+        _rpos = _rlen;
+    }
+    if (end > begin && *(end-1) == '\r') end--;
+
+    const char*sep = (const char*) memchr(begin, field_terminator, end - begin);
+    token_t t;
+    t.p = begin;
+    t.len = (sep ? sep : end) - begin;
+    _tokens.push_back(t);
+    _line_rest = sep ? sep + 1 : NULL;
+    _line_end = end;
+    return true;
+}
+
+/**
+ * @brief split the rest of the current line into _tokens at field_terminator
+ */
+void OnboardLogParserAPM::_split_line(void) {
+    if (!_line_rest) return;
+    const char*p = _line_rest;
+    for (;;) {
+        const char*sep = (const char*) memchr(p, field_terminator, _line_end - p);
+        token_t t;
+        t.p = p;
+        t.len = (sep ? sep : _line_end) - p;
+        _tokens.push_back(t);
+        if (!sep) break;
+        p = sep + 1;
+    }
+    _line_rest = NULL;
+}
+
+/**
+ * @brief how values of the given APM type are stored
  */
-bool OnboardLogParserAPM::_parse_message(const csv_row & row, OnboardData & ret) {
+OnboardSchema::fieldkind_e OnboardLogParserAPM::_get_field_kind(datatype t) {
+    switch (t) {
+    case 'i': // int32_t
+    case 'h': // int16_t
+    case 'b': // int8_t
+        return OnboardSchema::FIELD_INT;
 
-    string msgname = row[0];
-    string_trim(msgname);
+    case 'I': // uint32_t
+    case 'H': // uint16_t
+    case 'B': // uint8_t
+    case 'Q':
+        return OnboardSchema::FIELD_UINT;
 
-    ret._msgname_orig = msgname; // original name can be used better to compare the message with the spec
-    string_trim(ret._msgname_orig);
-    ret._msgname_readable = _make_readable_name(ret._msgname_orig); // .. but to the user we want to show pretty names
+    case 'L': // uint32_t -> but is given as float
+    case 'E': // uint32_t*100 -> but is given as float
+    case 'e': // int32_t*100 -> but is given as float
+    case 'C': // uint16*100 -> but is given as float
+    case 'c': // int16*100 -> but is given as float
+    case 'f': // float
+        return OnboardSchema::FIELD_FLOAT;
 
-    map<string, lineformat>::const_iterator rit = _formats.find(msgname);
-    if (rit == _formats.end()) return false;
+    case 'M': // mode-string
+    case 'Z': // string
+    case 'N': // char[16]
+    default:
+        // unknown datatypes are mapped as strings
+        return OnboardSchema::FIELD_STRING;
+    }
+}
 
-    /************
-     * FOUND IT!
-     ************/    
+/**
+ * @brief parse the tokens of the current row into a class.
+ * @param fmt what FMT said about this row
+ * @param data class instance. Data is written to here.
+ * @return true if parsed, else false
+ */
+bool OnboardLogParserAPM::_parse_message(const msgformat_t & fmt, OnboardData & ret) {
+    const lineformat & f = fmt.columns;
 
     /*
      * for parameters it is is different: [1]=name, [2]=value. We must not store "name" in
-     * strings and "value" in float, but only in float and use [1] as the name
+     * strings and "value" in float, but only in float and use [1] as the name. Because the
+     * name differs per row, each parameter gets its own schema.
      */
-    const bool is_param = (msgname.compare("PARM")==0);
+    const bool is_param = fmt.is_param;
     unsigned int k0 = is_param ? 2 : 1;
 
-    if (row.size() > 1) {
-        for (unsigned int k=k0; k<row.size(); k++) {
-            const lineformat f = rit->second;
-            unsigned int colidx = k-1;
+    OnboardSchema*schema = fmt.schema;
+    if (is_param) {
+        if (_tokens.size() < 2) {
+            ret.reset(NULL);
+            return false;
+        }
+        const token_t pn = _trim(_tokens[1]);
+        _key.assign(pn.p, pn.len);
+        std::map<std::string, OnboardSchema*>::const_iterator pit = _param_schemas.find(_key);
+        if (pit != _param_schemas.end()) {
+            schema = pit->second;
+        } else {
+            schema = _new_schema(fmt.schema->get_message_origname());
+            _param_schemas[_key] = schema;
+        }
+        // parameter might have more than one value column
+        for (unsigned int k=k0; k<_tokens.size() && k-1 < f.size(); k++) {
+            schema->add_field(_key, _get_field_kind(f[k-1].second));
+        }
+    }
+    ret.reset(schema);
+
+    int64_t ival;
+    double  fval;
+    for (unsigned int k=k0; k<_tokens.size(); k++) {
+        unsigned int colidx = k-1;
+
+        if (colidx >= f.size()) break;
 
-            if (colidx >= f.size()) break;
+        const OnboardSchema::fieldkind_e kind = _get_field_kind(f[colidx].second);
+        const unsigned int id = is_param ? (unsigned int) schema->find_field(_key, kind) : fmt.field_ids[colidx];
+        const token_t & tok = _tokens[k];
 
-            const colformat c = f[colidx];
-            string colname;
-            if (is_param) {
-                colname = row[1];
+        // demux datatype
+        switch (kind) {
+        case OnboardSchema::FIELD_INT:
+            string_to_int64(tok.p, tok.len, ival);
+            ret.set_int(id, (int) ival);
+            break;
+
+        case OnboardSchema::FIELD_UINT:
+            string_to_int64(tok.p, tok.len, ival);
+            if ('Q' == f[colidx].second) {
+                ret.set_uint(id, (u_int64_t) ival);
             } else {
-                colname = c.first;
-            }
-            string_trim(colname);
-
-            // demux datatype
-            switch (c.second) {
-            case 'i': // int32_t
-            case 'h': // int16_t
-            case 'b': // int8_t
-                ret._int_data[colname] = atoi(row[k].c_str());
-                break;
-
-            case 'I': // uint32_t
-            case 'H': // uint16_t
-            case 'B': // uint8_t
-                ret._uint_data[colname] = ((unsigned int) atoll(row[k].c_str()));
-                break;
-
-            case 'L': // uint32_t -> but is given as float
-            case 'E': // uint32_t*100 -> but is given as float
-            case 'e': // int32_t*100 -> but is given as float
-            case 'C': // uint16*100 -> but is given as float
-            case 'c': // int16*100 -> but is given as float
-            case 'f': // float
-                ret._float_data[colname] = atof(row[k].c_str());
-                break;
-
-            case 'Q':
-                ret._uint_data[colname] = ((u_int64_t) atoll(row[k].c_str()));
-                break;
-
-            case 'M': // mode-string
-            case 'Z': // string
-            case 'N': // char[16]
-            default:
-                // unknown datatypes are mapped as strings
-                ret._string_data[colname] = row[k];
-                break;
+                ret.set_uint(id, (unsigned int) ival);
             }
+            break;
+
+        case OnboardSchema::FIELD_FLOAT:
+            string_to_double(tok.p, tok.len, fval);
+            ret.set_float(id, fval);
+            break;
+
+        case OnboardSchema::FIELD_STRING: // fallthrough
+        default:
+            ret.set_string(id, tok.p, tok.len);
+            break;
         }
     }
     return true;
 }
 
-OnboardData OnboardLogParserAPM::get_data(void) {
-    OnboardData ret;
+/**
+ * @brief remember column names and data types given by the FMT line in _tokens.
+ * Everything is trimmed here once, so that the data rows do not need to.
+ */
+void OnboardLogParserAPM::_parse_format(void) {
+    // these rows give column headers and data types. Do not return anything, but store it internally.
+    // a line is formatted as follows
+    // 0 -> FMT
+    // 1 -> message ID
+    // 2 -> message/row length
+    // 3 -> message/row name
+    // 4 -> data types for fields, encoded as format characters:
+    /*
+        +Format characters in the format string for binary log messages
+        + b : int8_t -- OK
+        + B : uint8_t -- OK
+        + h : int16_t -- OK
+        + H : uint16_t -- OK
+        + i : int32_t -- OK
+        + I : uint32_t -- OK
+        + f : float -- OK
+        + N : char[16] -- OK
+        + c : int16_t * 100 -- OK
+        + C : uint16_t * 100 -- OK
+        + e : int32_t * 100 -- OK
+        + E : uint32_t * 100
+        + L : uint32_t latitude/longitude
+        + Z : string (null-terminated?)
+    */
+    // 5+ -> labels for fields
+
+    if (_tokens.size() < 5) return;
+
+    const token_t formats = _trim(_tokens[4]);
+    const token_t rowname = _trim(_tokens[3]);
+
+    const std::string name(rowname.p, rowname.len);
+    msgformat_t mf;
+    mf.is_param = _equals(rowname, "PARM");
+    mf.skip = !_wants_topic(name);
+    mf.schema = mf.skip ? NULL : _new_schema(name); // a redefinition gets a new schema
+    for (unsigned int k=5; k<_tokens.size() && !mf.skip; k++) { // labels of fields in message
+        if (k-5 >= formats.len) break; // more labels than types
+        const token_t colname = _trim(_tokens[k]);
+        const datatype typechar = formats.p[k-5];
+        mf.columns.push_back(make_pair(std::string(colname.p, colname.len), typechar));
+        mf.field_ids.push_back(mf.schema->add_field(mf.columns.back().first, _get_field_kind(typechar)));
+    }
+    _formats[name] = mf;
+}
+
+bool OnboardLogParserAPM::get_data(OnboardData & ret) {
+    ret.reset(NULL);
 
-    csv_row row = _parser.get_row();
-    // now row is a vector<string>
-    if (row.empty()) {
-        return ret;
+    if (!valid || !_next_line()) {
+        return false;
+    }
+    // now _tokens holds the fields of the line
+    if (_tokens.size() == 1 && _trim(_tokens[0]).len == 0) {
+        return false; // empty line
     }
 
     /*
      * first look up the type of data, then use polymorphism
      * to create the right class to return
      */
-    if (row[0].compare("FMT")==0) {
-        // these rows give column headers and data types. Do not return anything, but store it internally.
-        // a line is formatted as follows
-        // 0 -> FMT
-        // 1 -> message ID
-        // 2 -> message/row length
-        // 3 -> message/row name
-        // 4 -> data types for fields, encoded as format characters:
-        /*
-            +Format characters in the format string for binary log messages
-            + b : int8_t -- OK
-            + B : uint8_t -- OK
-            + h : int16_t -- OK
-            + H : uint16_t -- OK
-            + i : int32_t -- OK
-            + I : uint32_t -- OK
-            + f : float -- OK
-            + N : char[16] -- OK
-            + c : int16_t * 100 -- OK
-            + C : uint16_t * 100 -- OK
-            + e : int32_t * 100 -- OK
-            + E : uint32_t * 100
-            + L : uint32_t latitude/longitude
-            + Z : string (null-terminated?)
-        */
-        // 5+ -> labels for fields
-
-        if (row.size() < 5) return ret;
-
-        string formats = row[4];
-        string_trim(formats, true);
-
-        string rowname = row[3];
-        string_trim(rowname);
-        lineformat lf;
-        if (row.size() > 5) { // labels of fields in message
-            for (unsigned int k=5; k<row.size(); k++) {
-                colformat cf;
-                string colname = row[k]; string_trim(colname);
-                const string typespec = formats.substr(k-5,1);
-                const char typechar = typespec.c_str()[0];
-                cf = make_pair(colname, typechar);
-                lf.push_back(cf);
-            }
-        }
-        _formats[rowname] = lf;
-        return ret;
+    if (_equals(_tokens[0], "FMT")) {
+        _split_line();
+        _parse_format();
+        return false;
     } else {
         /*
          * Now all the rest here are rows which are described by FMT.
          * All we do is demux them into vectors of their respective data
          * types and label them according to column names.
          */
-        ret._valid = _parse_message(row, ret);
+        const token_t name = _trim(_tokens[0]);
+        _key.assign(name.p, name.len);
+        std::map<std::string, msgformat_t>::const_iterator rit = _formats.find(_key);
+        if (rit != _formats.end()) {
+            if (rit->second.skip) return false; // not selected: no need to look at the values
+            _split_line();
+            ret.set_valid(_parse_message(rit->second, ret));
+        }
     }
     // -- END
     if (!ret.is_valid()) {
-        std::cerr << "OnboardLogParserAPM: unrecognized data row: " << row[0] << std::endl;
+        std::cerr << "OnboardLogParserAPM: unrecognized data row: " << std::string(_tokens[0].p, _tokens[0].len) << std::endl;
     }
-    return ret;
+    return ret.is_valid();
+}
+
+/**
+ * @brief continue at the first complete line after offset
+ */
+bool OnboardLogParserAPM::_prescan_seek(uint64_t offset) {
+    if (!_fp || !fileSeek(_fp, offset)) return false;
+    _rpos = 0;
+    _rlen = 0;
+    if (offset > 0) {
+        _next_line(); // the rest of a line
+    }
+    return _rpos < _rlen || _fill();
 }
 
 bool OnboardLogParserAPM::has_more_data(void) {
     if (!valid) return false;
-    return _parser.has_more_rows();
+    if (_rpos < _rlen) return true;
+    return _fill();
 }
 
 bool OnboardLogParserAPM::Load (std::string filename, Logger::logchannel * ch) {
@@ -214,12 +381,14 @@ bool OnboardLogParserAPM::Load (std::string filename, Logger::logchannel * ch) {
     _filename = filename;
     _logchannel = ch;
 
-    valid = _parser.init(_filename.c_str());
-
+    _close();
+    _formats.clear();
+    _param_schemas.clear();
+    _fp = fopen(_filename.c_str(), "rb");
+    valid = (_fp != NULL);
     if (valid) {
-        _parser.set_enclosed_char(enclosure_char, ENCLOSURE_NONE);
-        _parser.set_field_term_char(field_terminator);
-        _parser.set_line_term_char(line_terminator);
+        _buf.resize(read_blocksize);
+        _tokens.reserve(32);
     }
     return valid;
 }
@@ -30,7 +30,6 @@
 #include <stdio.h>
 #include <inttypes.h>
 #include <string>
-#include <csv_parser/csv_parser.hpp>
 #include "onboardlogparser.h"
 #include "logger.h"
 
@@ -51,7 +50,7 @@ public:
     bool has_more_data(void);
 
     // implements OnboardLogParser::get_data
-    OnboardData get_data(void);
+    bool get_data(OnboardData & data);
 
     static std::string get_extension(void) { return "log"; }
 
@@ -71,28 +70,69 @@ public:
     static const char enclosure_char   = '"';
     static const char field_terminator = ',';
     static const char line_terminator  = '\n';
+    static const unsigned int read_blocksize = 256*1024;
 
 private:
     /****************************************
      *     METHODS
      ****************************************/    
-    bool _parse_message(const csv_row & row, OnboardData & data);
+    /**
+     * @brief a field of the current line. Points into _buf, valid until next _next_line()
+     */
+    typedef struct {
+        const char*  p;
+        unsigned int len;
+    } token_t;
+
+    void _parse_format(void);
+    bool _fill(void);
+    bool _next_line(void);
+    void _split_line(void);
+    void _close(void);
+    bool _prescan_seek(uint64_t offset); // implement super
+    static token_t _trim(const token_t & t);
+    static bool _equals(const token_t & t, const char*str);
 
     /****************************************
      *     DATA MEMBERS
      ****************************************/
     // general
     std::string _filename;
-    csv_parser  _parser;
+    FILE*       _fp;
     Logger::logchannel*_logchannel;
 
+    // read buffer. Lines are tokenized in place.
+    std::vector<char>    _buf;
+    unsigned int         _rpos; ///< start of unread data in _buf
+    unsigned int         _rlen; ///< end of valid data in _buf
+    std::vector<token_t> _tokens; ///< fields of the current line
+    const char*          _line_rest; ///< not yet split part of current line, NULL=none
+    const char*          _line_end;
+    std::string          _key; ///< reused for looking up _formats
+
     // types
     typedef char datatype;
     typedef std::pair<std::string, datatype> colformat; ///< (column name, data type)
     typedef std::vector<colformat> lineformat; ///< each entry is one column. So this maps index to column format
 
+    /**
+     * @brief everything about a message type that is known from its FMT line. Column names are trimmed already.
+     */
+    typedef struct {
+        lineformat                columns;
+        std::vector<unsigned int> field_ids; ///< column index -> field id in schema
+        OnboardSchema*            schema; ///< NULL if skipped
+        bool                      is_param;
+        bool                      skip; ///< not selected by filter
+    } msgformat_t;
+
+    bool _parse_message(const msgformat_t & fmt, OnboardData & data);
+
+    static OnboardSchema::fieldkind_e _get_field_kind(datatype t);
+
     // hash table for formats
-    std::map<std::string, lineformat> _formats; ///< maps line ID -> lineformat
+    std::map<std::string, msgformat_t> _formats; ///< maps line ID -> format
+    std::map<std::string, OnboardSchema*> _param_schemas; ///< PARM rows: one schema per parameter name
 
 };
 
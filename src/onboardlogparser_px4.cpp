@@ -41,13 +41,19 @@
 #define PX4_HEAD1 0XA3
 #define PX4_HEAD2 0X95
 #define PX4_HEADERLEN 3
+#define PX4_BUFLEN (256*1024) ///< read block size. Must be larger than the longest message (255)
+#define PX4_BUFSLACK 64 ///< longest field. A broken format may read that much beyond the message, which must stay in _buf
+#define PX4_BATCH_MAX 4096 ///< rows of one get_batch(), unless the caller says otherwise
 
 // more types are defined by message FMT itself...
 
 using namespace std;
 
-OnboardLogParserPX4::OnboardLogParserPX4() : _filename(""), _logchannel(NULL), _consumed(0)
+OnboardLogParserPX4::OnboardLogParserPX4() : _filename(""), _logchannel(NULL), _rpos(0), _rlen(0),
+    _in_sync(true), _skipped(0), _n_resyncs(0), _reported(false)
 {
+    _buf.resize(PX4_BUFLEN + PX4_BUFSLACK, 0);
+
     // bootstrap
     _register_fmt(0x80, 89, "FMT", "BBnNZ", "Type,Length,Name,Format,Labels");
 }
@@ -56,15 +62,37 @@ OnboardLogParserPX4::~OnboardLogParserPX4() {
     _filebuf.close();
 }
 
-std::string OnboardLogParserPX4::_filebuf_get_string(unsigned int len) {
-    std::string ret;
-    for (unsigned int k=0; k < len; k++) {
-        int c = _filebuf.sbumpc();
-        if (char_traits<char>::eof() == c) break;
-        ret += (char(c));
-        _consumed++;
+/**
+ * @brief make sure that at least need bytes starting at _rpos are in the buffer.
+ * Reads more from file if needed.
+ * @return false if the file has not enough bytes left
+ */
+bool OnboardLogParserPX4::_fill(unsigned int need) {
+    if (_rlen - _rpos >= need) return true;
+
+    // move rest to front
+    const unsigned int rest = _rlen - _rpos;
+    if (rest > 0 && _rpos > 0) {
+        memmove(&_buf[0], &_buf[_rpos], rest);
+    }
+    _rpos = 0;
+    _rlen = rest;
+    while (_rlen < need) {
+        std::streamsize n = _filebuf.sgetn(&_buf[_rlen], PX4_BUFLEN - _rlen);
+        if (n <= 0) return false;
+        _rlen += n;
+    }
+    return true;
+}
+
+/**
+ * @brief remember that we are not positioned at a message anymore
+ */
+void OnboardLogParserPX4::_lost_sync(void) {
+    if (_in_sync) {
+        _in_sync = false;
+        _n_resyncs++;
     }
-    return ret;
 }
 
 void OnboardLogParserPX4::_log(logmsgtype_e t, const std::string & str) {
@@ -107,237 +135,442 @@ void OnboardLogParserPX4::_register_fmt(int typ, int len, const std::string & na
     }
 
     _log(MSG_DBG, stringbuilder() << "OnboardLogParserPX4::new message type: " << name << ", id=" << typ << ", len=" << len << ", " << format << ", " << fields);
-    _formats.insert(std::make_pair(typ, fmt));
-}
+    fmt.type = typ;
+    fmt.schema = NULL;
+    fmt.skip = false;
+    std::pair<formatmap::iterator, bool> ins = _formats.insert(std::make_pair(typ, fmt));
+    if (!ins.second) return; // known already
+
+    // register schema, so that messages need no string work
+    msgformat & known = ins.first->second;
+    std::string msgname = name;
+    string_trim(msgname); // original name can be used better to compare the message with the spec
+    if (msgname != "FMT" && !_wants_topic(msgname)) {
+        known.skip = true; // only its length is needed
+        return;
+    }
 
-void OnboardLogParserPX4::_parse_message(const msgformat & fmt, OnboardData& ret) {
-    if (fmt.length < PX4_HEADERLEN) {
-        ret._valid = false;
+    // where each field is, so that messages are not checked one by one
+    unsigned int offset = 0;
+    for (unsigned int k=0; k<known.format.size(); k++) {
+        const unsigned int size = _get_field_size(known.format[k].second);
+        if (0 == size) {
+            _log(MSG_ERR, stringbuilder() << "_register_fmt: unknown field type " << known.format[k].second << " in message " << msgname << ", ignoring its messages");
+            known.skip = true;
+            return;
+        }
+        fieldlayout fl;
+        fl.type = known.format[k].second;
+        fl.id = 0;
+        fl.offset = offset;
+        fl.store = true;
+        known.layout.push_back(fl);
+        offset += size;
+    }
+    if ((int)offset != len - PX4_HEADERLEN) {
+        _log(MSG_ERR, stringbuilder() << "_register_fmt: message " << msgname << " is " << len << " bytes, but its fields need " << offset + PX4_HEADERLEN << ", ignoring its messages");
+        known.layout.clear();
+        known.skip = true;
         return;
     }
-    const unsigned int LEN = fmt.length - PX4_HEADERLEN;
 
-    ret._msgname_orig = fmt.name; // original name can be used better to compare the message with the spec
-    string_trim(ret._msgname_orig);
-    ret._msgname_readable = _make_readable_name(ret._msgname_orig); // .. but to the user we want to show pretty names
+    known.schema = _new_schema(msgname);
+    for (unsigned int k=0; k<known.format.size(); k++) {
+        known.layout[k].id = known.schema->add_field(known.format[k].first, _get_field_kind(known.format[k].second));
+        for (unsigned int j=0; j<k; j++) {
+            if (known.layout[j].id == known.layout[k].id) known.layout[j].store = false;
+        }
+    }
+}
+
+/**
+ * @brief bytes of a value of the given PX4 type. 0=unknown. Must match _decode.
+ */
+unsigned int OnboardLogParserPX4::_get_field_size(datatype t) {
+    switch (t) {
+    case 'b': // fallthrough
+    case 'B': // fallthrough
+    case 'M':
+        return 1;
+    case 'h': // fallthrough
+    case 'H': // fallthrough
+    case 'c': // fallthrough
+    case 'C':
+        return 2;
+    case 'i': // fallthrough
+    case 'I': // fallthrough
+    case 'f': // fallthrough
+    case 'L': // fallthrough
+    case 'e': // fallthrough
+    case 'E': // fallthrough
+    case 'n':
+        return 4;
+    case 'q': // fallthrough
+    case 'Q':
+        return 8;
+    case 'N':
+        return 16;
+    case 'Z':
+        return 64;
+    default:
+        return 0;
+    }
+}
 
-    // we later check that we dont actually not read more than rem
-    _filebuf_resetcount();
+/**
+ * @brief how values of the given PX4 type are stored. Must match _parse_message.
+ */
+OnboardSchema::fieldkind_e OnboardLogParserPX4::_get_field_kind(datatype t) {
+    switch (t) {
+    case 'i': // fallthrough
+    case 'h': // fallthrough
+    case 'q': // fallthrough
+    case 'b':
+        return OnboardSchema::FIELD_INT;
+    case 'Q': // fallthrough
+    case 'I': // fallthrough
+    case 'H': // fallthrough
+    case 'M': // fallthrough
+    case 'B':
+        return OnboardSchema::FIELD_UINT;
+    case 'L': // fallthrough
+    case 'E': // fallthrough
+    case 'e': // fallthrough
+    case 'C': // fallthrough
+    case 'c': // fallthrough
+    case 'f':
+        return OnboardSchema::FIELD_FLOAT;
+    default:
+        return OnboardSchema::FIELD_STRING; // also unknown ones, which are never set
+    }
+}
 
-    // all fields
-    for (unsigned f = 0; f < fmt.format.size(); f++) {
-        const std::string fieldlabel = fmt.format[f].first;
-        const char fieldtype = fmt.format[f].second;
+/**
+ * @brief appends the values of a message to the columns of an OnboardBatch. Has the
+ * setters of OnboardData, so that _decode works for both.
+ */
+class BatchColumns {
+public:
+    BatchColumns(OnboardBatch & b) : _b(b) {}
+    void set_int(unsigned int id, int64_t v) { _b.column(id).i.push_back(v); }
+    void set_uint(unsigned int id, uint64_t v) { _b.column(id).u.push_back(v); }
+    void set_float(unsigned int id, float v) { _b.column(id).f.push_back(v); }
+    void set_string(unsigned int id, const char*p, unsigned int len) { _b.column(id).s.push_back(std::string(p, len)); }
+
+private:
+    OnboardBatch & _b;
+};
 
-        // demux into OnboardData: FIXME: check types (could differ from APM)
-        switch (fieldtype) {
+/**
+ * @brief decode the fields of one message into out, by the layout of its format
+ * @param payload fmt.length-PX4_HEADERLEN bytes, which _register_fmt has checked against the layout
+ */
+template <class SINK>
+void OnboardLogParserPX4::_decode(const msgformat & fmt, const char*payload, SINK & out) {
+    for (std::vector<fieldlayout>::const_iterator it = fmt.layout.begin(); it != fmt.layout.end(); ++it) {
+        if (!it->store) continue;
+        const unsigned int id = it->id;
+        const char*p = payload + it->offset;
+
+        // FIXME: check types (could differ from APM)
+        switch (it->type) {
         case 'i': // int32_t - OK
         {
-            int32_t v; _filebuf_get(v);
-            ret._int_data[fieldlabel] = v;
+            int32_t v; _get(p, v);
+            out.set_int(id, v);
         }
             break;
 
         case 'h': // int16_t - OK
         {
-            int16_t v; _filebuf_get(v);
-            ret._int_data[fieldlabel] = v;
+            int16_t v; _get(p, v);
+            out.set_int(id, v);
         }
             break;
 
         case 'Q': // Uint64
         {
-            uint64_t v; _filebuf_get(v);
-            ret._uint_data[fieldlabel] = v;
+            uint64_t v; _get(p, v);
+            out.set_uint(id, v);
         }
             break;
 
         case 'q': //Int64
         {
-            int64_t v; _filebuf_get(v);
-            ret._int_data[fieldlabel] = v;
+            int64_t v; _get(p, v);
+            out.set_int(id, v);
         }
             break;
 
         case 'b': // int8_t - OK
         {
-            int8_t v; _filebuf_get(v);
-            ret._int_data[fieldlabel] = v;
+            int8_t v; _get(p, v);
+            out.set_int(id, v);
         }
             break;
 
         case 'I': // uint32_t - OK
         {
-            uint32_t v; _filebuf_get(v);
-            ret._uint_data[fieldlabel] = v;
+            uint32_t v; _get(p, v);
+            out.set_uint(id, v);
         }
             break;
 
         case 'H': // uint16_t - OK
         {
-            uint16_t v; _filebuf_get(v);
-            ret._uint_data[fieldlabel] = v;
+            uint16_t v; _get(p, v);
+            out.set_uint(id, v);
         }
             break;
 
         case 'M': // mode-string - OK
         case 'B': // uint8_t
         {
-            uint8_t v; _filebuf_get(v);
-            ret._uint_data[fieldlabel] = v;
+            uint8_t v; _get(p, v);
+            out.set_uint(id, v);
         }
             break;
 
         case 'L': // int32_t -> but encodes a float - OK
         {
-            int32_t v; _filebuf_get(v);
+            int32_t v; _get(p, v);
             float vf = v*1E-7;
-            ret._float_data[fieldlabel] = vf;
+            out.set_float(id, vf);
         }
             break;
 
         case 'E': // uint32_t*100 - OK
         {
-            uint32_t v; _filebuf_get(v);
+            uint32_t v; _get(p, v);
             float vf = v*1E-2;
-            ret._float_data[fieldlabel] = vf;
+            out.set_float(id, vf);
         }
             break;
 
         case 'e': // int32_t*100 - OK
         {
-            int32_t v; _filebuf_get(v);
+            int32_t v; _get(p, v);
             float vf = v*1E-2;
-            ret._float_data[fieldlabel] = vf;
+            out.set_float(id, vf);
         }
             break;
 
         case 'C': // uint16*100 - ok
         {
-            uint16_t v; _filebuf_get(v);
+            uint16_t v; _get(p, v);
             float vf = v*1E-2;
-            ret._float_data[fieldlabel] = vf;
+            out.set_float(id, vf);
         }
             break;
 
         case 'c': // int16*100 -> but is given as float - OK
         {
-            int16_t v; _filebuf_get(v);
+            int16_t v; _get(p, v);
             float vf = v*1E-2;
-            ret._float_data[fieldlabel] = vf;
+            out.set_float(id, vf);
         }
             break;
 
         case 'f': // float - OK
         {
-            float v; _filebuf_get(v);
-            ret._float_data[fieldlabel] = v;
+            float v; _get(p, v);
+            out.set_float(id, v);
         }
             break;
 
         case 'Z': // char[64] - OK
-        {
-            std::string s = _filebuf_get_string(64);
-            ret._string_data[fieldlabel] = s;
-        }
+            out.set_string(id, p, 64);
             break;
 
         case 'N': // char[16] - OK
-        {
-            std::string s = _filebuf_get_string(16);
-            ret._string_data[fieldlabel] = s;
-        }
+            out.set_string(id, p, 16);
             break;
 
         case 'n': // char[4] - OK
-        {
-            std::string s = _filebuf_get_string(4);
-            ret._string_data[fieldlabel] = s;
-        }
+            out.set_string(id, p, 4);
             break;
 
         default:
-            // unknown datatypes are ignored...
-            _log(MSG_ERR, stringbuilder() << "OnboardLogParserPX4::_parse_message: unknown field type: "<< fieldtype <<"; rest of this message (" + fmt.name + ") might by garbage ");
-            break;
+            break; // formats with unknown types are skipped by _register_fmt
         }
     }
+}
 
-    if (LEN != _filebuf_getcount()) {
-        ret._valid = false;
-        _log(MSG_ERR, stringbuilder() << "OnboardLogParserPX4::_parse_message: message \"" + fmt.name + "\" inconsistent. Ignoring it.");
-    } else {
-        ret._valid = true;
-    }
+/**
+ * @brief decode one message
+ * @param fmt its format
+ * @param payload points to the payload in the read buffer; fmt.length-PX4_HEADERLEN bytes are available
+ * @param ret data goes here
+ * @return true if the message could be decoded
+ */
+bool OnboardLogParserPX4::_parse_message(const msgformat & fmt, const char*payload, OnboardData& ret) {
+    ret.reset(fmt.schema); // names are in there
+    if (!fmt.schema) return false;
+    _decode(fmt, payload, ret);
+    ret.set_valid(true);
+    return true;
+}
 
+/**
+ * @brief read the next message. Definitions are registered, messages not selected are
+ * jumped over.
+ * @param payload (out) the payload of the message in _buf. Valid until the next read.
+ * @return its format if the message carries data to decode, else NULL
+ */
+const OnboardLogParserPX4::msgformat* OnboardLogParserPX4::_read_message(const char*&payload) {
+    int typ;
+    if (!_get_next_message(typ)) return NULL;
+
+    // see if we know the format and handle it
+    formatmap::const_iterator it = _formats.find(typ);
+    if (it == _formats.end() || it->second.length < PX4_HEADERLEN) {
+        _log(MSG_INFO, stringbuilder() << "OnboardLogParserPX4: unknown message type " << ((int)typ) );
+        // no idea how long it is. scan for next header
+        _skipped += PX4_HEADERLEN;
+        _lost_sync();
+        return NULL;
+    }
+    const msgformat & mfmt = it->second;
+    const unsigned int LEN = mfmt.length - PX4_HEADERLEN;
+    if (!_fill(LEN)) {
+        // truncated at end of file
+        _skipped += PX4_HEADERLEN + (_rlen - _rpos);
+        _rpos = _rlen;
+        return NULL;
+    }
+    const char*p = &_buf[_rpos];
+    // in sync: next message starts right after this one
+    _rpos += LEN;
+    if (mfmt.name == "FMT") {
+        // defines more messages
+        // FMT message is build like follows:
+        int type = (uint8_t) *p++;
+        //_log(MSG_INFO, stringbuilder() << "OnboardLogParserPX4: got FMT (" << type <<")" );
+        int length = (uint8_t) *p++;
+        std::string name = _get_string(p, 4);
+        std::string fmt = _get_string(p, 16);
+        std::string labels = _get_string(p, 64);
+        _register_fmt(type, length, name, fmt, labels);
+        return NULL;
+    }
+    if (mfmt.skip) return NULL; // not selected: just jump over it
+    payload = p;
+    return &mfmt;
 }
 
 // implement OnboardLogParser::get_data
-OnboardData OnboardLogParserPX4::get_data(void) {
-    OnboardData ret;
-    if (!valid) return ret;
+bool OnboardLogParserPX4::get_data(OnboardData & ret) {
+    ret.reset(NULL);
+    if (!valid) return false;
 
-    // 1. try to read next message
-    int typ;
-    if (_get_next_message(typ)) {
-        // see if we know the format and handle it
-
-        formatmap::const_iterator it = _formats.find(typ);
-        if (it != _formats.end()) {
-            if (it->second.name == "FMT") {
-                // defines more messages
-                // FMT message is build like follows:
-                int type = _filebuf.sbumpc();
-                //_log(MSG_INFO, stringbuilder() << "OnboardLogParserPX4: got FMT (" << type <<")" );
-                int length = _filebuf.sbumpc();
-                std::string name = _filebuf_get_string(4);
-                std::string fmt = _filebuf_get_string(16);
-                std::string labels = _filebuf_get_string(64);
-                _register_fmt(type, length, name, fmt, labels);
-            } else {
-                // is a message with data -> parse it
-                //_log(MSG_INFO, stringbuilder() << "OnboardLogParserPX4: got data " << ((int)typ) );
-                _parse_message(it->second,ret);
-            }
-        } else {
-            _log(MSG_INFO, stringbuilder() << "OnboardLogParserPX4: unknown message type " << ((int)typ) );
-        }
+    const char*p;
+    const msgformat*mfmt = _read_message(p);
+    if (mfmt) {
+        // is a message with data -> parse it
+        _parse_message(*mfmt, p, ret);
     }
+    return ret.is_valid();
+}
 
-
-    return ret;
+// implement OnboardLogParser::get_batch
+bool OnboardLogParserPX4::get_batch(OnboardBatch & batch, unsigned int max) {
+    batch.reset(NULL);
+    if (!valid) return false;
+    if (0 == max) max = PX4_BATCH_MAX;
+
+    const char*p;
+    const msgformat*mfmt = _read_message(p);
+    if (!mfmt || !mfmt->schema) return false;
+    batch.reset(mfmt->schema);
+    BatchColumns columns(batch);
+    for (;;) {
+        _decode(*mfmt, p, columns);
+        batch.end_row();
+        if (batch.size() >= max) break;
+
+        // logs mostly have runs of the same message. The run ends at any other header.
+        if (!_in_sync || !_fill(PX4_HEADERLEN)) break;
+        const char*const h = &_buf[_rpos];
+        if (PX4_HEAD1 != (uint8_t)h[0] || PX4_HEAD2 != (uint8_t)h[1] || mfmt->type != (uint8_t)h[2]) break;
+        if (_read_message(p) != mfmt) break; // e.g., truncated
+    }
+    return true;
 }
 
 /**
  * @brief OnboardLogParserPX4::_get_next_message
  * @param ret (out) message type
- * @return true if there is a message (scans entire file). when returned, then filebuf is positioned at first payload byte
+ * @return true if there is a message (scans entire file). when returned, then _rpos is positioned at first payload byte.
+ * As long as the stream is in sync, the header is expected right at _rpos. Otherwise
+ * the buffer is scanned with memchr, and the skipped bytes are counted.
  */
 bool OnboardLogParserPX4::_get_next_message(int&ret) {
     if (!valid) return false;
 
-    bool found = false;
-    for(;;) {
-        ret = _filebuf.sbumpc(); // read current and proceed -> at second header byte now
-        if (PX4_HEAD1 == ret && PX4_HEAD2 == _filebuf.sgetc()) {
-            found = true;
-            break;
+    for (;;) {
+        if (!_fill(PX4_HEADERLEN)) {
+            // rest of file cannot hold a message
+            _skipped += _rlen - _rpos;
+            _rpos = _rlen;
+            if (_skipped > 0 && !_reported) {
+                _reported = true;
+                _log(MSG_WARN, stringbuilder() << "Log is damaged: skipped " << _skipped << " bytes in " << _n_resyncs << " resyncs");
+            }
+            return false;
         }
-        if (char_traits<char>::eof() == ret) break;
+        const char*const p = &_buf[_rpos];
+        if (PX4_HEAD1 == (uint8_t)p[0] && PX4_HEAD2 == (uint8_t)p[1]) break;
+
+        // out of sync: find next candidate
+        _lost_sync();
+        const unsigned int avail = _rlen - _rpos;
+        const char*q = (const char*) memchr(p + 1, PX4_HEAD1, avail - 1);
+        const unsigned int skip = q ? (q - p) : avail;
+        _skipped += skip;
+        _rpos += skip;
     }
-    if (!found) return false;
+    _in_sync = true;
 
     // return type
-    ret = _filebuf.snextc(); // proceed and read -> ptr is now on the type (3rd header field)
-    _filebuf.snextc(); // now points to first payload
+    ret = (uint8_t) _buf[_rpos + 2];
+    _rpos += PX4_HEADERLEN; // now points to first payload
     return true;
 }
 
+/**
+ * @brief go to the first message after offset: a header of a known type, which is
+ * followed by another header. Other A3 95 in the data are passed that way.
+ */
+bool OnboardLogParserPX4::_prescan_seek(uint64_t offset) {
+    if (!valid) return false;
+    if (_filebuf.pubseekpos(offset, ios_base::in) != std::streampos(offset)) return false;
+    _rpos = 0;
+    _rlen = 0;
+    _lost_sync();
+    for (;;) {
+        if (!_fill(PX4_HEADERLEN)) return false;
+        const char*p = &_buf[_rpos];
+        if (PX4_HEAD1 == (uint8_t)p[0] && PX4_HEAD2 == (uint8_t)p[1]) {
+            formatmap::const_iterator it = _formats.find((uint8_t)p[2]);
+            if (it != _formats.end() && it->second.length >= PX4_HEADERLEN) {
+                const unsigned int len = it->second.length;
+                if (!_fill(len + 2)) return false;
+                p = &_buf[_rpos];
+                if (PX4_HEAD1 == (uint8_t)p[len] && PX4_HEAD2 == (uint8_t)p[len + 1]) {
+                    _in_sync = true;
+                    return true;
+                }
+            }
+        }
+        _rpos++;
+    }
+}
+
 // implement OnboardLogParser::has_more_data
 bool OnboardLogParserPX4::has_more_data(void) {
     if (!valid) return false;
 
-    return (_filebuf.sgetc() != std::char_traits<char>::eof());
+    return _fill(1);
 }
 
 bool OnboardLogParserPX4::Load (std::string filename, Logger::logchannel * ch) {
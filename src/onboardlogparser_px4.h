@@ -27,6 +27,8 @@
 #include <string>
 #include <vector>
 #include <fstream>
+#include <string.h>
+#include <inttypes.h>
 #include "onboardlogparser.h"
 #include "logger.h"
 
@@ -37,7 +39,11 @@ public:
     ~OnboardLogParserPX4();
 
     // implement OnboardLogParser::get_data
-    OnboardData get_data(void);
+    bool get_data(OnboardData & data);
+
+    // implement OnboardLogParser::get_batch
+    bool get_batch(OnboardBatch & batch, unsigned int max = 0);
+    bool supports_batch(void) const { return true; }
 
     // implement OnboardLogParser::has_more_data
     bool has_more_data(void);
@@ -52,14 +58,35 @@ public:
     bool Load (std::string filename, Logger::logchannel * ch = NULL);
 
     static OnboardLogParser* make_instance() { return new OnboardLogParserPX4; }
+
+    /**
+     * @brief how many bytes had to be skipped to find the next message. Non-zero means the log is damaged.
+     */
+    uint64_t get_skipped_bytes(void) const { return _skipped; }
+
+    /**
+     * @brief how often the parser lost sync to the message stream
+     */
+    unsigned int get_num_resyncs(void) const { return _n_resyncs; }
+
 private:
     // types
     typedef char datatype;
     typedef std::pair<std::string, datatype> fieldformat; ///< (column name, data type)
     typedef struct {
+        datatype     type;
+        unsigned int id;     // field id in schema
+        unsigned int offset; // in payload
+        bool         store;  // false if a later field has the same id; it would overwrite this one
+    } fieldlayout;
+    typedef struct {
+        int type;
         std::string name;
         int length; // length of this message in bytes, incl. header length
         std::vector<fieldformat> format; // fields in this message
+        std::vector<fieldlayout> layout; // how to decode them, made once by _register_fmt
+        OnboardSchema* schema;
+        bool skip; // not selected by filter, or broken
     } msgformat;
 
     /*******************
@@ -67,38 +94,32 @@ private:
      *******************/
     bool _get_next_message(int &type);
     void _register_fmt(int typ, int len, const std::string & name, const std::string & format, const std::string & fields);    
-    void _parse_message(const msgformat & fmt, OnboardData& ret);
+    const msgformat* _read_message(const char*&payload);
+    bool _parse_message(const msgformat & fmt, const char*payload, OnboardData& ret);
+    template <class SINK>
+    static void _decode(const msgformat & fmt, const char*payload, SINK & out);
+    static unsigned int _get_field_size(datatype t);
     void _log(logmsgtype_e t, const std::string & str);
+    void _lost_sync(void);
+    bool _prescan_seek(uint64_t offset); // implement super
+    static OnboardSchema::fieldkind_e _get_field_kind(datatype t);
 
-    // string reader
-    std::string _filebuf_get_string(unsigned int len);
+    // make sure at least need bytes are in _buf, starting at _rpos
+    bool _fill(unsigned int need);
 
-    // generic type reader
+    // generic type reader. p is advanced.
     template <typename T>
-    void _filebuf_get(T &var) {
+    static void _get(const char*&p, T &var) {
         // FIXME: endianness. assumes all is little
-        const int LEN = sizeof(T);
-        if (LEN <= 0) return;
-
-        char*p = (char*)&var;
-        for (int l=0; l<LEN; l++) {
-            *p++ = (char)_filebuf.sbumpc();
-        }
-
-        // that doesn't work, because filebuf::pubseekoff() is not always seeking
-        //_filebuf.sgetn((char*)&var, LEN);
-        //_filebuf.pubseekoff(LEN, std::ios_base::cur,std::ios_base::in); // consume -> not working. why??!
-        _consumed += LEN;
+        memcpy(&var, p, sizeof(T));
+        p += sizeof(T);
     }
-    // count consumption
-    unsigned int _filebuf_getcount(void) const {
-        return _consumed;
+    // string reader. p is advanced.
+    static std::string _get_string(const char*&p, unsigned int len) {
+        std::string ret(p, len);
+        p += len;
+        return ret;
     }
-    // reset consumption counter
-    void _filebuf_resetcount(void) {
-        _consumed = 0;
-    }
-
 
     /*******************
      * ATTRIBUTES
@@ -106,7 +127,17 @@ private:
     std::string _filename;
     std::filebuf _filebuf;
     Logger::logchannel*_logchannel;
-    unsigned int _consumed;
+
+    // read buffer
+    std::vector<char> _buf;
+    unsigned int _rpos; ///< next byte to be parsed in _buf
+    unsigned int _rlen; ///< valid bytes in _buf
+
+    // resync stats
+    bool         _in_sync;
+    uint64_t     _skipped;
+    unsigned int _n_resyncs;
+    bool         _reported;
 
     // hash table for formats
     typedef std::map<int, msgformat> formatmap;
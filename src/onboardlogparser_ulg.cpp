@@ -24,6 +24,9 @@
 
 #include <iostream>
 #include <cassert>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDataStream>
 #include "stringfun.h"
 #include "onboardlogparser_ulg.h"
 
@@ -55,6 +58,12 @@ typedef struct ulog_message_header_s {
 
 #define ULOG_INCOMPAT_FLAG0_DATA_APPENDED_MASK (1<<0)
 
+// index file: magic, version, then size+mtime of log to detect a stale index
+#define ULOG_INDEX_MAGIC 0x55494458 // "UIDX"
+#define ULOG_INDEX_VERSION 1
+
+#define ULOG_RESYNC_CHAIN 4 ///< that many plausible messages in a row mean we are in sync
+
 #if 0
 /**
  * @brief Message type = INFO
@@ -72,14 +81,107 @@ bool OnboardLogParserULG::Load (std::string filename, Logger::logchannel * ch) {
     // initialize buffer
     _filename = filename;
     _logchannel = ch;
-    _filebuf.open(filename.c_str(), std::ios_base::binary | std::ios_base::in);
-    valid = _filebuf.is_open();
     _state = WAIT_HEADER;
     _buflen = 0;
+    _msg = _buffer;
+    _pos = 0;
     _read_until_file_position = 1ULL << 60; ///< read limit if log contains appended data
+    _data_start = 0;
+    _windowed = false;
+    _index.clear();
+    _index_subs.clear();
+
+    // preferably map the file and read in place. A mapping would not grow with the file.
+    _file.setFileName(QString::fromStdString(filename));
+    if (!_follow && _file.open(QIODevice::ReadOnly) && _file.size() > 0) {
+        _map_len = _file.size();
+        _map = (const char*) _file.map(0, _file.size());
+    }
+    if (_map) {
+        valid = true;
+    } else {
+        _file.close();
+        _map_len = 0;
+        _filebuf.open(filename.c_str(), std::ios_base::binary | std::ios_base::in);
+        valid = _filebuf.is_open();
+    }
+
+    // with an index, time windows can be seeked to. Without, make one while reading.
+    _index_loaded = valid && !_follow && _load_index();
+    _indexing = valid && !_follow && !_index_loaded;
     return valid;
 }
 
+bool OnboardLogParserULG::set_time_window(uint64_t from_usec, uint64_t to_usec) {
+    if (from_usec > to_usec) return false;
+    _windowed = true;
+    _win_from = from_usec;
+    _win_to = to_usec;
+    if (!_index_loaded) {
+        _log(MSG_INFO, stringbuilder() << "No index, yet. Reading entire file for time window");
+    }
+    return true;
+}
+
+/**
+ * @brief consume the next n bytes. If the file is mapped, no copy is made.
+ * @return pointer to the bytes, or NULL if there are not enough
+ */
+const char* OnboardLogParserULG::_read_inplace(unsigned int n) {
+    if (_map) {
+        if (_pos + n > _map_len) return NULL;
+        const char*ret = _map + _pos;
+        _pos += n;
+        return ret;
+    }
+    if (n >= ULOG_BUFLEN) return NULL; // keep one for zero-termination
+    int got = _filebuf.sgetn(_buffer, n);
+    if (got < (int)n) return NULL;
+    return _buffer;
+}
+
+void OnboardLogParserULG::_skip(int64_t n) {
+    if (_map) {
+        if (n < 0 && (uint64_t)(-n) > _pos) {
+            _pos = 0;
+        } else {
+            _pos += n;
+        }
+        if (_pos > _map_len) _pos = _map_len;
+    } else {
+        _filebuf.pubseekoff(n, ios_base::cur, ios_base::in);
+    }
+}
+
+int OnboardLogParserULG::_getc(void) {
+    if (_map) {
+        if (_pos >= _map_len) return char_traits<char>::eof();
+        return (unsigned char) _map[_pos++];
+    }
+    return _filebuf.sbumpc();
+}
+
+bool OnboardLogParserULG::_eof(void) {
+    if (_map) {
+        return _pos >= _map_len || _pos >= _read_until_file_position;
+    }
+    if (_read_until_file_position < (1ULL << 60) && _tell() >= _read_until_file_position) return true;
+    return (_filebuf.sgetc() == std::char_traits<char>::eof());
+}
+
+uint64_t OnboardLogParserULG::_tell(void) {
+    if (_map) return _pos;
+    return (uint64_t) _filebuf.pubseekoff(0, ios_base::cur, ios_base::in);
+}
+
+void OnboardLogParserULG::_seek(uint64_t pos) {
+    if (_map) {
+        _pos = (pos > _map_len) ? _map_len : pos;
+    } else {
+        _filebuf.pubseekpos(pos, ios_base::in);
+    }
+}
+
 
 /**
  * @brief consume format message
@@ -87,16 +189,13 @@ bool OnboardLogParserULG::Load (std::string filename, Logger::logchannel * ch) {
  * @return true on success, else false
  */
 bool OnboardLogParserULG::_get_defs_format(uint16_t siz) {
-    char *format = (char *)_buffer;
-    int n = _filebuf.sgetn(_buffer, siz);
-    if (n < siz) {
+    const char *format = _read_inplace(siz);
+    if (!format) {
         _log(MSG_ERR, stringbuilder() << "Log file incomplete");
         return false;
     }
 
-    format[siz] = 0; // zero-terminate
-
-    string str_format(format);
+    string str_format(format, strnlen(format, siz));
     size_t pos = str_format.find(':');
     if (pos == string::npos) {
         return false;
@@ -117,7 +216,7 @@ bool OnboardLogParserULG::_get_defs_format(uint16_t siz) {
 bool OnboardLogParserULG::_get_defs_param(uint16_t siz) {
     // TODO: not just skip
     //_log(MSG_DBG, stringbuilder() << "PARM ignored");
-    _filebuf.pubseekoff(siz, ios_base::cur, ios_base::in);
+    _skip(siz);
     return true;
 }
 
@@ -134,14 +233,13 @@ bool OnboardLogParserULG::_get_defs_flagbits(uint16_t siz) {
         return false;
     }
 
-    int n = _filebuf.sgetn(_buffer, MSGLEN);
-    if (n < MSGLEN) {
+    const uint8_t *message = (const uint8_t *)_read_inplace(MSGLEN);
+    if (!message) {
         _log(MSG_ERR, stringbuilder() << "Log file incomplete");
         return false;
     }
-
-    uint8_t *message = (uint8_t *)_buffer;
-    uint8_t *incompat_flags = message + 8;
+    _skip(siz - MSGLEN); // newer versions could have more
+    const uint8_t *incompat_flags = message + 8;
 
     // handle & validate the flags
     bool contains_appended_data = incompat_flags[0] & ULOG_INCOMPAT_FLAG0_DATA_APPENDED_MASK;
@@ -182,28 +280,30 @@ bool OnboardLogParserULG::_get_defs_flagbits(uint16_t siz) {
  */
 bool OnboardLogParserULG::_get_defs(void) {
 
-    const ulog_message_header_t*const head = (ulog_message_header_t*) _buffer;
+    ulog_message_header_t head;
     for(;;) {
-        int n = _filebuf.sgetn(_buffer, ULOG_MSG_HEADER_LEN);
-        if (n < ULOG_MSG_HEADER_LEN) return false; // is it?
+        const char*hbuf = _read_inplace(ULOG_MSG_HEADER_LEN);
+        if (!hbuf) return false; // is it?
+        memcpy(&head.msg_size, hbuf, sizeof(head.msg_size)); // FIXME: endianness?
+        head.msg_type = hbuf[2];
 
-        switch (head->msg_type) {
+        switch (head.msg_type) {
         case (int) FLAG_BITS:
-            if (!_get_defs_flagbits(head->msg_size)) return false;
+            if (!_get_defs_flagbits(head.msg_size)) return false;
             break;
 
         case (int) FORMAT:
-            if (!_get_defs_format(head->msg_size)) return false;
+            if (!_get_defs_format(head.msg_size)) return false;
             break;
 
         case (int) PARAMETER:
-            if (!_get_defs_param(head->msg_size)) return false;
+            if (!_get_defs_param(head.msg_size)) return false;
             break;
 
         case (int) ADD_LOGGED_MSG: ///< indicates end of definitions
             _log(MSG_DBG, stringbuilder() << "ADD_LOGGED_MSG");
             // seek back by header length
-            _filebuf.pubseekoff(-ULOG_MSG_HEADER_LEN, ios_base::cur, ios_base::in);
+            _skip(-ULOG_MSG_HEADER_LEN);
             return true;
             break;
 
@@ -211,11 +311,11 @@ bool OnboardLogParserULG::_get_defs(void) {
         case (int) INFO_MULTIPLE: // fallthrough
             //_log(MSG_DBG, stringbuilder() << "INFO");
             // SKIP THESE. FIXME: don't skip.
-            _filebuf.pubseekoff(head->msg_size, ios_base::cur, ios_base::in);
+            _skip(head.msg_size);
             break;
 
         default:
-            _log(MSG_ERR, stringbuilder() << "Unknown message in def section: " << head->msg_type);
+            _log(MSG_ERR, stringbuilder() << "Unknown message in def section: " << head.msg_type);
             return false;
             break;
         }
@@ -236,7 +336,7 @@ bool OnboardLogParserULG::_get_header(void) {
             memccpy(_buffer, _buffer+1, ULOG_HEADER_SIZE - 1, 1); // shift left if necessary
         }
 
-        int c = _filebuf.sbumpc();
+        int c = _getc();
         if (char_traits<char>::eof() == c) return false;
 
         _buffer[_buflen++] = c;
@@ -270,17 +370,33 @@ void OnboardLogParserULG::_log(logmsgtype_e t, const std::string & str) {
  * @return
  */
 bool OnboardLogParserULG::_get_log_message(int&typ) {
-    int n = _filebuf.sgetn(_buffer, ULOG_MSG_HEADER_LEN);
-    if (n < ULOG_MSG_HEADER_LEN) return false;
+    if (_eof()) return false;
+    const uint64_t start = _tell();
+    const char*hbuf = _read_inplace(ULOG_MSG_HEADER_LEN);
+    if (!hbuf) {
+        if (_follow) {
+            _seek(start); // rest is not written, yet
+            _stalled = true;
+        }
+        return false;
+    }
 
-    ulog_message_header_t*head = (ulog_message_header_t*) _buffer;
-    _buflen = head->msg_size; // FIXME: endianness?
-    typ = head->msg_type;
+    uint16_t msg_size;
+    memcpy(&msg_size, hbuf, sizeof(msg_size)); // FIXME: endianness?
+    _buflen = msg_size;
+    typ = (uint8_t) hbuf[2];
     if (_buflen == 0) return false;
 
-    n = _filebuf.sgetn(_buffer, _buflen);
-    if (n < (int)_buflen) return false;
-    _buffer[_buflen] = 0;
+    // payload: pointer into mapping, or copied to _buffer
+    _msg = _read_inplace(_buflen);
+    if (!_msg) {
+        _msg = _buffer;
+        if (_follow) {
+            _seek(start);
+            _stalled = true;
+        }
+        return false;
+    }
 
     //std::cout << "Reading log message " << typ << ": len=" << _buflen << std::endl;
 
@@ -299,6 +415,12 @@ bool OnboardLogParserULG::_get_next_message(int&typ) {
     /* We comsume complete header and defs first... */
     if (_state == WAIT_HEADER) {
         ret = _get_header();
+        if (!ret && _follow) {
+            _seek(0); // not written, yet
+            _buflen = 0;
+            _stalled = true;
+            return false;
+        }
         if (!ret) {
             valid = false;
             return false;
@@ -309,12 +431,24 @@ bool OnboardLogParserULG::_get_next_message(int&typ) {
     }
     if (_state == WAIT_DEFS) {
         ret = _get_defs();
+        if (!ret && _follow) {
+            // not complete, yet. Formats are registered again next time.
+            _seek(0);
+            _buflen = 0;
+            _state = WAIT_HEADER;
+            _stalled = true;
+            return false;
+        }
         if (!ret) {
             valid = false;
             return false;
             _log(MSG_ERR, stringbuilder() << "Cannot read definitions");
         }
         _state = WAIT_DATA;
+        _data_start = _tell();
+        if (_windowed && _index_loaded) {
+            _seek_window();
+        }
     }
 
     /* ... now it is time to consume the data itself and return one msg at a time */
@@ -325,47 +459,41 @@ bool is_padding (const string  & str) {
     return str.substr(0, strlen("_padding")) == "_padding";
 }
 
-#define READ_FUNCTION(funcname, type, target) \
-    static int funcname (const char*const buf, const std::string &nam, OnboardData &data) { \
-        if (!is_padding(nam)) { \
-            data.target [nam] = *((type*)buf); /*FIXME: endianness fails if host=big*/ \
-        } \
+#define READ_FUNCTION(funcname, type, setter) \
+    static int funcname (const char*const buf, unsigned int id, OnboardData &data) { \
+        type v; \
+        memcpy(&v, buf, sizeof(type)); /*FIXME: endianness fails if host=big*/ \
+        data.setter (id, v); \
         return sizeof(type); \
     }
 
-READ_FUNCTION(read_int8,   int8_t,   _int_data)
-READ_FUNCTION(read_uint8,  uint8_t,  _uint_data)
-READ_FUNCTION(read_int16,  int16_t,  _int_data)
-READ_FUNCTION(read_uint16, uint16_t, _uint_data)
-READ_FUNCTION(read_int32,  int32_t,  _int_data)
-READ_FUNCTION(read_uint32, uint32_t, _uint_data)
-READ_FUNCTION(read_int64,  int64_t,  _int_data)
-READ_FUNCTION(read_uint64, uint64_t, _uint_data)
-READ_FUNCTION(read_float,  float,    _float_data)
-READ_FUNCTION(read_double, double,   _float_data)
+READ_FUNCTION(read_uint32, uint32_t, set_uint)
+READ_FUNCTION(read_uint64, uint64_t, set_uint)
 
 /**
- * @brief find read function corresponding to data type
- * @return ptr to function, or NULL if unknown
+ * @brief find field type and its length in bytes
+ * @return type, or FIELD_UNKNOWN
  */
-Read_Field_Function OnboardLogParserULG::_get_field_reader (const std::string & fieldtype) {
+OnboardLogParserULG::fieldtype_e OnboardLogParserULG::_get_field_type (const std::string & fieldtype, unsigned int & size) {
     if (fieldtype == "uint8_t" ||
         fieldtype == "bool" ||
-        fieldtype == "char")
-        return &read_uint8;
-    if (fieldtype == "int8_t") return &read_int8;
-    if (fieldtype == "uint16_t") return &read_uint16;
-    if (fieldtype == "int16_t") return &read_int16;
+        fieldtype == "char") {
+        size = 1; return FIELD_UINT8;
+    }
+    if (fieldtype == "int8_t") { size = 1; return FIELD_INT8; }
+    if (fieldtype == "uint16_t") { size = 2; return FIELD_UINT16; }
+    if (fieldtype == "int16_t") { size = 2; return FIELD_INT16; }
 
-    if (fieldtype == "uint32_t") return &read_uint32;
-    if (fieldtype == "int32_t") return &read_int32;
+    if (fieldtype == "uint32_t") { size = 4; return FIELD_UINT32; }
+    if (fieldtype == "int32_t") { size = 4; return FIELD_INT32; }
 
-    if (fieldtype == "uint64_t") return &read_uint64;
-    if (fieldtype == "int64_t") return &read_int64;
+    if (fieldtype == "uint64_t") { size = 8; return FIELD_UINT64; }
+    if (fieldtype == "int64_t") { size = 8; return FIELD_INT64; }
 
-    if (fieldtype == "float") return &read_float;
-    if (fieldtype == "double") return &read_double;
-    return NULL;
+    if (fieldtype == "float") { size = 4; return FIELD_FLOAT; }
+    if (fieldtype == "double") { size = 8; return FIELD_DOUBLE; }
+    size = 0;
+    return FIELD_UNKNOWN;
 }
 
 template <typename Iter, typename Cont>
@@ -418,9 +546,6 @@ void OnboardLogParserULG::_register_format
         return;
     }
 
-    OnboardData trashdata;
-    char        trashbuf [8];
-
     for (vector<string>::const_iterator it = fields.begin(); it != fields.end(); ++it) {
         const string & fieldspec = *it;        
         /* each <field> is "<fieldtype>(\[array length\])? <fieldname>" */
@@ -452,7 +577,6 @@ void OnboardLogParserULG::_register_format
             /* register field while unrolling arrays, if any */
             for (unsigned int e=0; e<elems;++e) {
                 field_t      field;
-                unsigned int flen = 0;
 
                 if (elems > 1) {
                     stringstream ss;
@@ -465,20 +589,18 @@ void OnboardLogParserULG::_register_format
 
                 // TODO: They also use types that they defined in defs, and furthermore types can be used before they are defined.
 
-                // set up callback and accumulate msg length
-                field.decode = _get_field_reader (fieldtype);
-                if (NULL == field.decode) {
+                // determine type and accumulate msg length
+                field.type = _get_field_type (fieldtype, field.size);
+                if (FIELD_UNKNOWN == field.type) {
                     _log (MSG_ERR, stringbuilder() <<
                           "Unsupported field type '" << fieldtype <<
                           "' in field '" << fieldname << "' in FMT for " << name);
                     return;
                 }
-
-                // dry run to find field length
-                flen = field.decode (trashbuf, field.name, trashdata);
+                field.padding = is_padding(fieldname);
                 fmt.fields.push_back(field);
 
-                fmt.datalen += flen;
+                fmt.datalen += field.size;
             }
         }
     }
@@ -503,33 +625,118 @@ void OnboardLogParserULG::_register_message_id
         }
     } else {
         _message_name [msg_id] = name; // ignore multi_id
+        // compile decoder now, so that data messages need no lookups anymore
+        if (msg_id >= _plans.size()) {
+            _plans.resize(msg_id + 1, NULL);
+        }
+        _plans[msg_id] = _compile_plan(name);
+    }
+}
+
+/**
+ * @brief build decoder for a message from its format
+ * @return new plan, or NULL if there is no format for this message
+ */
+OnboardLogParserULG::decode_plan_t* OnboardLogParserULG::_compile_plan(const std::string & message_name) {
+    format_map_t::const_iterator it_fmt = _formats.find (message_name);
+    if (it_fmt == _formats.end()) return NULL;
+    const format_t & fmt = it_fmt->second;
+
+    decode_plan_t*plan = new decode_plan_t;
+    plan->datalen = fmt.datalen;
+    plan->skip = !_wants_topic (message_name);
+    plan->schema = NULL;
+    if (plan->skip) {
+        _log (MSG_DBG, stringbuilder() << "Not selected: " << message_name);
+        return plan;
+    }
+    plan->schema = _new_schema (message_name);
+
+    unsigned int offset = 0;
+    for (std::vector<field_t>::const_iterator it = fmt.fields.begin(); it != fmt.fields.end(); ++it) {
+        const field_t & f = *it;
+        if (!f.padding && _wants_field (message_name, f.name)) {
+            plan_field_t pf;
+            pf.offset = offset;
+            pf.type = f.type;
+            switch (f.type) {
+            case FIELD_UINT8: // fallthrough
+            case FIELD_UINT16: // fallthrough
+            case FIELD_UINT32: // fallthrough
+            case FIELD_UINT64:
+                pf.id = plan->schema->add_field(f.name, OnboardSchema::FIELD_UINT);
+                break;
+            case FIELD_INT8: // fallthrough
+            case FIELD_INT16: // fallthrough
+            case FIELD_INT32: // fallthrough
+            case FIELD_INT64:
+                pf.id = plan->schema->add_field(f.name, OnboardSchema::FIELD_INT);
+                break;
+            case FIELD_FLOAT: // fallthrough
+            case FIELD_DOUBLE:
+                pf.id = plan->schema->add_field(f.name, OnboardSchema::FIELD_FLOAT);
+                break;
+            default:
+                assert (false); // rejected in _register_format
+                break;
+            }
+            plan->fields.push_back(pf);
+        }
+        offset += f.size;
+    }
+    assert (offset == fmt.datalen);
+    return plan;
+}
+
+/**
+ * @return decode plan for msg_id, or NULL if unknown
+ */
+OnboardLogParserULG::decode_plan_t* OnboardLogParserULG::_get_plan(uint16_t msg_id) {
+    if (msg_id >= _plans.size()) return NULL;
+    decode_plan_t*plan = _plans[msg_id];
+    if (!plan) {
+        // format might have been missing at subscription time; try again
+        name_map_t::const_iterator it_name = _message_name.find (msg_id);
+        if (it_name == _message_name.end()) return NULL;
+        plan = _plans[msg_id] = _compile_plan(it_name->second);
+    }
+    return plan;
+}
+
+OnboardLogParserULG::~OnboardLogParserULG() {
+    if (_map) {
+        _file.unmap((uchar*)_map);
+        _map = NULL;
     }
+    for (std::vector<decode_plan_t*>::iterator it = _plans.begin(); it != _plans.end(); ++it) {
+        delete *it;
+    }
+    _plans.clear();
 }
 
 bool OnboardLogParserULG::_decode_str_msg (uint16_t msglen, OnboardData & ret) {
-    uint8_t lvl = (uint8_t)_buffer[0];
-    int n = read_uint64(_buffer + 1, "timestamp", ret);
-    assert (n==8);
+    static const char*const levels[ULOG_NUM_LEVELS] = {
+        "EMERG", "ALERT", "CRIT", "ERR", "WARN", "NOTICE", "INFO", "DEBUG", "UNKNOWN"
+    };
     const unsigned int STRING_OFF = 9;
-    const unsigned int elems = msglen - STRING_OFF;
-
-    string strlvl = "UNKNOWN";
-    switch (lvl) {
-        case '0': strlvl = "EMERG"; break;
-        case '1': strlvl = "ALERT"; break;
-        case '2': strlvl = "CRIT"; break;
-        case '3': strlvl = "ERR"; break;
-        case '4': strlvl = "WARN"; break;
-        case '5': strlvl = "NOTICE"; break;
-        case '6': strlvl = "INFO"; break;
-        case '7': strlvl = "DEBUG"; break;
-        default: break;
+    if (msglen < STRING_OFF) return false;
+
+    uint8_t lvl = (uint8_t)_msg[0];
+    unsigned int idx = (lvl >= '0' && lvl <= '7') ? (lvl - '0') : (ULOG_NUM_LEVELS - 1);
+    OnboardSchema*schema = _str_schemas[idx];
+    if (!schema) {
+        // field 0 = timestamp, field 1 = text
+        schema = _str_schemas[idx] = _new_schema ("messages");
+        schema->add_field ("timestamp", OnboardSchema::FIELD_UINT);
+        schema->add_field (levels[idx], OnboardSchema::FIELD_STRING);
     }
+    ret.reset(schema);
 
-    ret._msgname_orig = "messages";
-    ret._msgname_readable = _make_readable_name (ret._msgname_orig);
-    ret._string_data [strlvl] = string(_buffer + STRING_OFF, elems);
-    ret._valid = true;
+    int n = read_uint64(_msg + 1, 0, ret);
+    assert (n==8);
+    const unsigned int elems = msglen - STRING_OFF;
+    ret.set_string (1, _msg + STRING_OFF, elems);
+    ret.set_valid(true);
     return true;
 }
 
@@ -538,8 +745,8 @@ bool OnboardLogParserULG::_decode_str_msg (uint16_t msglen, OnboardData & ret) {
  * @return true if successfully parsed, else false
  */
 bool OnboardLogParserULG::_decode_info_msg (uint16_t msglen, OnboardData & ret) {
-    const uint8_t keylen = _buffer[0];
-    string strkey (_buffer+1, keylen);
+    const uint8_t keylen = _msg[0];
+    string strkey (_msg+1, keylen);
 
     size_t pos = strkey.find(' ');
     if (pos == string::npos) {
@@ -556,27 +763,39 @@ bool OnboardLogParserULG::_decode_info_msg (uint16_t msglen, OnboardData & ret)
         return false;
     }
 
-    // good to parse now
-    char*read = _buffer + 1 + keylen;
+    OnboardSchema::fieldkind_e kind;
     if (typname == "char") {
-        assert ((int)elems == msglen - keylen - 1); // not sure about this one. doc does not say what value elems would be carrying
-        ret._string_data [desc] = string(read, elems);
-    } else if (typname == "uint32_t") {
-        for (unsigned int e=0; e<elems; ++e) {
-            read += read_uint32 (read, desc, ret);
-        }
-    } else if (typname == "int32_t") {
-        for (unsigned int e=0; e<elems; ++e) {
-            read += read_uint32 (read, desc, ret);
-        }
+        kind = OnboardSchema::FIELD_STRING;
+    } else if (typname == "uint32_t" || typname == "int32_t") {
+        kind = OnboardSchema::FIELD_UINT;
     } else {
         _log (MSG_ERR, stringbuilder() <<
               "Unsupported type of info message '" << desc << "'");
         return false;
     }
-    ret._msgname_orig = "info";
-    ret._msgname_readable = _make_readable_name (ret._msgname_orig);
-    ret._valid = true;
+
+    // info messages are rare, so one schema per key is fine
+    OnboardSchema*schema;
+    std::map<std::string, OnboardSchema*>::const_iterator it = _info_schemas.find(strkey);
+    if (it != _info_schemas.end()) {
+        schema = it->second;
+    } else {
+        schema = _info_schemas[strkey] = _new_schema ("info");
+        schema->add_field (desc, kind);
+    }
+    ret.reset(schema);
+
+    // good to parse now
+    const char*read = _msg + 1 + keylen;
+    if (kind == OnboardSchema::FIELD_STRING) {
+        assert ((int)elems == msglen - keylen - 1); // not sure about this one. doc does not say what value elems would be carrying
+        ret.set_string (0, read, elems);
+    } else {
+        for (unsigned int e=0; e<elems; ++e) {
+            read += read_uint32 (read, 0, ret);
+        }
+    }
+    ret.set_valid(true);
     return true;
 }
 
@@ -585,81 +804,94 @@ bool OnboardLogParserULG::_decode_info_msg (uint16_t msglen, OnboardData & ret)
  * @return true on success, else false
  */
 bool OnboardLogParserULG::_decode_data_msg(uint16_t msg_id, OnboardData & ret) {
-    name_map_t::const_iterator it_name = _message_name.find (msg_id);
-    if (it_name == _message_name.end()) return false;
+    decode_plan_t*const plan = _get_plan(msg_id);
+    if (!plan || plan->skip) return false;
 
-    // find format spec
-    const std::string & message_name = it_name->second;
-    format_map_t::const_iterator it_fmt = _formats.find (message_name);
-    if (it_fmt == _formats.end()) return false;
-    const format_t & fmt = it_fmt->second;
-
-    // message is already in _buffer
+    // message is already in _msg
     // first two bytes are the msg_id
     const unsigned int DATA_OFF = 2;
-    assert (_buflen == fmt.datalen + DATA_OFF);
-
-    // decode fields one by one
-    char*readptr = _buffer + DATA_OFF; // data starts after msg_id
-    for (std::vector<field_t>::const_iterator it = fmt.fields.begin(); it != fmt.fields.end(); ++it) {
-        const field_t & f = *it;
-        assert (NULL != f.decode);
-        readptr += f.decode (readptr, f.name, ret);
-        assert (readptr <= _buffer + fmt.datalen + DATA_OFF);
+    if (_buflen != (unsigned int)plan->datalen + DATA_OFF) return false;
+    const char*const data = _msg + DATA_OFF;
+
+    // decode fields one by one. FIXME: endianness fails if host=big
+    ret.reset(plan->schema);
+    for (std::vector<plan_field_t>::const_iterator it = plan->fields.begin(); it != plan->fields.end(); ++it) {
+        const plan_field_t & f = *it;
+        const char*const src = data + f.offset;
+        switch (f.type) {
+        case FIELD_UINT8:  { uint8_t v;  memcpy(&v, src, sizeof(v)); ret.set_uint(f.id, v); } break;
+        case FIELD_UINT16: { uint16_t v; memcpy(&v, src, sizeof(v)); ret.set_uint(f.id, v); } break;
+        case FIELD_UINT32: { uint32_t v; memcpy(&v, src, sizeof(v)); ret.set_uint(f.id, v); } break;
+        case FIELD_UINT64: { uint64_t v; memcpy(&v, src, sizeof(v)); ret.set_uint(f.id, v); } break;
+        case FIELD_INT8:   { int8_t v;   memcpy(&v, src, sizeof(v)); ret.set_int(f.id, v); } break;
+        case FIELD_INT16:  { int16_t v;  memcpy(&v, src, sizeof(v)); ret.set_int(f.id, v); } break;
+        case FIELD_INT32:  { int32_t v;  memcpy(&v, src, sizeof(v)); ret.set_int(f.id, v); } break;
+        case FIELD_INT64:  { int64_t v;  memcpy(&v, src, sizeof(v)); ret.set_int(f.id, v); } break;
+        case FIELD_FLOAT:  { float v;    memcpy(&v, src, sizeof(v)); ret.set_float(f.id, v); } break;
+        case FIELD_DOUBLE: { double v;   memcpy(&v, src, sizeof(v)); ret.set_float(f.id, v); } break;
+        default: break;
+        }
     }
-    assert (readptr == _buffer + fmt.datalen + DATA_OFF);
-
-    // set message name et. al
-    ret._msgname_orig = message_name;
-    ret._msgname_readable = _make_readable_name (ret._msgname_orig);
-    ret._valid = true;
 
+    // names and message name are in the schema
+    ret.set_valid(true);
     return true;
 }
 
-OnboardData OnboardLogParserULG::get_data(void) {
-    OnboardData ret;
-    if (!valid) return ret;
+bool OnboardLogParserULG::get_data(OnboardData & ret) {
+    ret.reset(NULL);
+    if (!valid) return false;
 
     int typ;
     if (_get_next_message(typ)) {
 
-        // _buffer now contains the message only
+        // _msg now points to the message only
+
+        if (_indexing) _index_message(typ);
+        if (_windowed) {
+            uint64_t t;
+            if (_get_timestamp(typ, t) && (t < _win_from || t > _win_to)) {
+                return false; // outside of window
+            }
+        }
 
         switch (typ) {
         case (int) ADD_LOGGED_MSG: // 65
-            {
-                string topic_name(_buffer + 3);
-                uint16_t msg_id = ((uint16_t) _buffer[1]) | (((uint16_t) _buffer[2]) << 8);
-                uint8_t  multi_id = (uint8_t) _buffer[0];
-                _register_message_id (topic_name, multi_id, msg_id);
-            }
+            _handle_subscription();
             break;
 
         case (int)DATA: // 68
             {
-                uint16_t msg_id = ((uint16_t) _buffer[0]) | (((uint16_t) _buffer[1]) << 8);
+                const uint8_t*const b = (const uint8_t*) _msg;
+                uint16_t msg_id = ((uint16_t) b[0]) | (((uint16_t) b[1]) << 8);
+                const decode_plan_t*const plan = _get_plan(msg_id);
+                if (plan && plan->skip) break; // not selected
                 if (!_decode_data_msg (msg_id, ret)) {
                     _log (MSG_ERR, stringbuilder() << "Cannot decode message with id " << msg_id);                    
-                    return OnboardData();
+                    ret.reset(NULL);
+                    return false;
                 }
             }
             break;
 
         case (int)INFO:
             {
+                if (!_wants_topic ("info")) break;
                 if (!_decode_info_msg (_buflen, ret)) {
                     _log (MSG_ERR, stringbuilder() << "Cannot decode info message");
-                    return OnboardData();
+                    ret.reset(NULL);
+                    return false;
                 }
             }
             break;
 
         case (int)LOGGING:
             {
+                if (!_wants_topic ("messages")) break;
                 if (!_decode_str_msg (_buflen, ret)) {
                     _log (MSG_ERR, stringbuilder() << "Cannot decode string (logging) message");
-                    return OnboardData();
+                    ret.reset(NULL);
+                    return false;
                 }
             }
             break;
@@ -674,17 +906,280 @@ OnboardData OnboardLogParserULG::get_data(void) {
 
         default:
             _log (MSG_ERR, stringbuilder() << "Unknown message type " << typ);
-            return OnboardData();
+            return false;
             assert (false); // must not happen
             break;
         }
     }
 
-    return ret;
+    return ret.is_valid();
 }
 
 bool OnboardLogParserULG::has_more_data(void) {
     if (!valid) return false;
+    if (_stalled) {
+        _stalled = false; // wait for the writer, then try again
+        return false;
+    }
+
+    const bool more = !_eof();
+    if (!more && _indexing) {
+        // read completely: next time we can seek
+        _indexing = false;
+        if (_save_index()) {
+            _log(MSG_DBG, stringbuilder() << "Wrote index with " << _index.size() << " blocks");
+        }
+    }
+    return more;
+}
+
+/**
+ * @brief register the message subscription which is in _msg
+ */
+void OnboardLogParserULG::_handle_subscription(void) {
+    const uint8_t*const b = (const uint8_t*) _msg;
+    if (_buflen < 3) return;
+    string topic_name(_msg + 3, strnlen(_msg + 3, _buflen - 3));
+    uint16_t msg_id = ((uint16_t) b[1]) | (((uint16_t) b[2]) << 8);
+    uint8_t  multi_id = b[0];
+    _register_message_id (topic_name, multi_id, msg_id);
+}
+
+/**
+ * @brief get time stamp of message in _msg, without decoding it. Every topic
+ * starts with the uint64 "timestamp" field, LOGGING has it after the level.
+ * @return false if the message has no time stamp
+ */
+bool OnboardLogParserULG::_get_timestamp(int typ, uint64_t & t) const {
+    unsigned int off;
+    if (typ == (int)DATA) {
+        off = 2; // after msg_id
+    } else if (typ == (int)LOGGING) {
+        off = 1; // after level
+    } else {
+        return false;
+    }
+    if (_buflen < off + sizeof(t)) return false;
+    memcpy(&t, _msg + off, sizeof(t)); // FIXME: endianness fails if host=big
+    return true;
+}
+
+bool OnboardLogParserULG::prescan(LogPrescan & info) {
+    _indexing = false; // only parts are read
+    if (!OnboardLogParser::prescan(info)) return false;
+    if (_index_loaded && !_index.empty()) {
+        // from an earlier, complete read
+        info.has_time = false;
+        for (std::vector<index_block_t>::const_iterator it = _index.begin(); it != _index.end(); ++it) {
+            info.add_time(it->tmin);
+            info.add_time(it->tmax);
+        }
+        info.time_exact = true;
+    }
+    return true;
+}
+
+/**
+ * @brief whether a message of the data section could start at pos in the mapping
+ * @param next where the message after it starts
+ */
+bool OnboardLogParserULG::_plausible_message(uint64_t pos, uint64_t & next) const {
+    if (pos + ULOG_MSG_HEADER_LEN > _map_len) return false;
+    uint16_t msg_size;
+    memcpy(&msg_size, _map + pos, sizeof(msg_size));
+    const uint8_t typ = _map[pos + 2];
+    if (0 == msg_size) return false;
+    next = pos + ULOG_MSG_HEADER_LEN + msg_size;
+    if (next > _map_len) return false;
+    switch (typ) {
+    case (int)DATA:
+        {
+            // size must match the format of a subscribed message
+            if (msg_size < 2) return false;
+            const uint8_t*const b = (const uint8_t*) (_map + pos + ULOG_MSG_HEADER_LEN);
+            const uint16_t msg_id = ((uint16_t) b[0]) | (((uint16_t) b[1]) << 8);
+            if (msg_id >= _plans.size() || !_plans[msg_id]) return false;
+            return _plans[msg_id]->datalen + 2u == msg_size;
+        }
+    case (int)ADD_LOGGED_MSG:
+    case (int)REMOVE_LOGGED_MSG:
+    case (int)SYNC:
+    case (int)DROPOUT:
+    case (int)LOGGING:
+    case (int)INFO:
+    case (int)INFO_MULTIPLE:
+    case (int)PARAMETER:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief resynchronize at the first position after offset where ULOG_RESYNC_CHAIN plausible
+ * messages follow each other. Needs the mapping.
+ */
+bool OnboardLogParserULG::_prescan_seek(uint64_t offset) {
+    if (!valid || !_map || WAIT_DATA != _state) return false;
+    if (offset < _data_start) offset = _data_start;
+    const uint64_t end = (_read_until_file_position < _map_len) ? _read_until_file_position : _map_len;
+    for (uint64_t pos = offset; pos + ULOG_MSG_HEADER_LEN <= end; ++pos) {
+        uint64_t p = pos, next;
+        unsigned int n = 0;
+        while (n < ULOG_RESYNC_CHAIN && _plausible_message(p, next)) {
+            ++n;
+            p = next;
+            if (p >= end) break; // last messages of the file
+        }
+        if (n == ULOG_RESYNC_CHAIN || (n > 0 && p >= end)) {
+            _seek(pos);
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string OnboardLogParserULG::_index_filename(void) const {
+    return _filename + ".idx";
+}
+
+/**
+ * @brief account message in _msg to the index. A new block starts every
+ * ULOG_INDEX_STRIDE bytes, always at a message boundary.
+ */
+void OnboardLogParserULG::_index_message(int typ) {
+    const uint64_t msg_start = _tell() - ULOG_MSG_HEADER_LEN - _buflen;
+    if (typ == (int)ADD_LOGGED_MSG) {
+        _index_subs.push_back(msg_start);
+        return;
+    }
+    uint64_t t;
+    if (!_get_timestamp(typ, t)) return;
+
+    if (_index.empty() || msg_start >= _index.back().offset + ULOG_INDEX_STRIDE) {
+        index_block_t blk;
+        // first block also covers the untimed messages at the beginning
+        blk.offset = _index.empty() ? _data_start : msg_start;
+        blk.tmin = t;
+        blk.tmax = t;
+        _index.push_back(blk);
+    } else {
+        index_block_t & blk = _index.back();
+        if (t < blk.tmin) blk.tmin = t;
+        if (t > blk.tmax) blk.tmax = t;
+    }
+}
+
+/**
+ * @brief load index of this log file, if there is one and it is still up to date
+ * @return true if index can be used
+ */
+bool OnboardLogParserULG::_load_index(void) {
+    _index.clear();
+    _index_subs.clear();
+
+    QFile f(QString::fromStdString(_index_filename()));
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    QDataStream in(&f);
+
+    const QFileInfo info(QString::fromStdString(_filename));
+    quint32 magic, version, nsubs, nblocks;
+    quint64 logsize;
+    qint64 mtime;
+    in >> magic >> version >> logsize >> mtime;
+    if (in.status() != QDataStream::Ok || magic != ULOG_INDEX_MAGIC || version != ULOG_INDEX_VERSION ||
+        logsize != (quint64)info.size() || mtime != (qint64)info.lastModified().toMSecsSinceEpoch()) {
+        _log(MSG_DBG, stringbuilder() << "Index is stale, ignoring it");
+        return false;
+    }
+
+    in >> nsubs;
+    for (quint32 k = 0; k < nsubs && in.status() == QDataStream::Ok; ++k) {
+        quint64 off;
+        in >> off;
+        _index_subs.push_back(off);
+    }
+    in >> nblocks;
+    for (quint32 k = 0; k < nblocks && in.status() == QDataStream::Ok; ++k) {
+        quint64 off, tmin, tmax;
+        in >> off >> tmin >> tmax;
+        index_block_t blk;
+        blk.offset = off;
+        blk.tmin = tmin;
+        blk.tmax = tmax;
+        _index.push_back(blk);
+    }
+    if (in.status() != QDataStream::Ok || _index.size() != nblocks) {
+        _log(MSG_WARN, stringbuilder() << "Index file is truncated, ignoring it");
+        _index.clear();
+        _index_subs.clear();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief write index next to the log. Failing is not an error, e.g., read-only media.
+ */
+bool OnboardLogParserULG::_save_index(void) const {
+    QFile f(QString::fromStdString(_index_filename()));
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+    QDataStream out(&f);
+
+    const QFileInfo info(QString::fromStdString(_filename));
+    out << (quint32) ULOG_INDEX_MAGIC << (quint32) ULOG_INDEX_VERSION << (quint64) info.size()
+        << (qint64) info.lastModified().toMSecsSinceEpoch();
+    out << (quint32) _index_subs.size();
+    for (std::vector<uint64_t>::const_iterator it = _index_subs.begin(); it != _index_subs.end(); ++it) {
+        out << (quint64) *it;
+    }
+    out << (quint32) _index.size();
+    for (std::vector<index_block_t>::const_iterator it = _index.begin(); it != _index.end(); ++it) {
+        out << (quint64) it->offset << (quint64) it->tmin << (quint64) it->tmax;
+    }
+    return out.status() == QDataStream::Ok;
+}
+
+/**
+ * @brief called right after the definitions: jump to the first block that can
+ * contain the window and set the read limit behind the last one. Subscriptions
+ * before that block are replayed, so that all msg_ids are known.
+ */
+void OnboardLogParserULG::_seek_window(void) {
+    if (_index.empty()) return;
+    if (_data_start != _index.front().offset) { // first block starts at data section
+        _log(MSG_WARN, stringbuilder() << "Index does not match definitions, reading entire file");
+        return;
+    }
+
+    // all blocks before first end before the window
+    size_t first = 0;
+    while (first < _index.size() && _index[first].tmax < _win_from) first++;
+
+    // all blocks from last on start after the window
+    size_t last = _index.size();
+    while (last > first && _index[last-1].tmin > _win_to) last--;
 
-    return (_filebuf.sgetc() != std::char_traits<char>::eof());
+    if (first >= last) {
+        _log(MSG_INFO, stringbuilder() << "Time window: no data in log");
+        _read_until_file_position = _data_start;
+        return;
+    }
+    const uint64_t start = _index[first].offset;
+    const uint64_t end = (last < _index.size()) ? _index[last].offset : _read_until_file_position;
+
+    for (std::vector<uint64_t>::const_iterator it = _index_subs.begin(); it != _index_subs.end() && *it < start; ++it) {
+        int typ;
+        _seek(*it);
+        if (_get_log_message(typ) && typ == (int)ADD_LOGGED_MSG) {
+            _handle_subscription();
+        }
+    }
+
+    _seek(start);
+    if (end < _read_until_file_position) {
+        _read_until_file_position = end;
+    }
+    _log(MSG_INFO, stringbuilder() << "Time window: reading blocks " << first << ".." << last
+         << " of " << _index.size());
 }
@@ -28,15 +28,18 @@
 #include <inttypes.h>
 #include <string>
 #include <map>
+#include <QFile>
 #include "onboardlogparser.h"
 #include "logger.h"
 
 #define ULOG_BUFLEN 2048
+#define ULOG_NUM_LEVELS 9 ///< log levels of LOGGING messages, incl. unknown
+#define ULOG_INDEX_STRIDE (1<<20) ///< bytes of data section per index block
 
 /**
  * @brief callback function pointer for field/type readers
  */
-typedef int (*Read_Field_Function)(const char*const buf, const std::string &name, OnboardData & data);
+typedef int (*Read_Field_Function)(const char*const buf, unsigned int field_id, OnboardData & data);
 
 /**
  * @brief implements a Ulog parser. See https://dev.px4.io/en/log/ulog_file_format.html
@@ -44,9 +47,14 @@ typedef int (*Read_Field_Function)(const char*const buf, const std::string &name
  */
 class OnboardLogParserULG : public OnboardLogParser {
 public:    
+    OnboardLogParserULG() : _logchannel(NULL), _map(NULL), _map_len(0), _pos(0), _msg(NULL),
+        _data_start(0), _indexing(false), _index_loaded(false), _windowed(false), _win_from(0), _win_to(0), _follow(false), _stalled(false) {
+        for (unsigned int k=0; k<ULOG_NUM_LEVELS; k++) _str_schemas[k] = NULL;
+    }
+    ~OnboardLogParserULG();
 
     // implement OnboardLogParser::get_data
-    OnboardData get_data(void);
+    bool get_data(OnboardData & data);
 
     // implement OnboardLogParser::has_more_data
     bool has_more_data(void);
@@ -60,6 +68,15 @@ public:
     // implement super
     bool Load (std::string filename, Logger::logchannel * ch = NULL);
 
+    // implement super. Seeks if the file has an index from an earlier load.
+    bool set_time_window(uint64_t from_usec, uint64_t to_usec);
+
+    // implement super. The time span is exact if there is an index.
+    bool prescan(LogPrescan & info);
+
+    // implement super. The file is read, not mapped then, and not indexed.
+    bool set_follow(bool yes) { _follow = yes; return true; }
+
     static OnboardLogParser* make_instance() { return new OnboardLogParserULG; }
 
 private:
@@ -82,9 +99,20 @@ private:
         LOGGING = 'L' ///< Logged string message
     } ULogMessageType;
 
+    typedef enum {
+        FIELD_UINT8, FIELD_INT8,
+        FIELD_UINT16, FIELD_INT16,
+        FIELD_UINT32, FIELD_INT32,
+        FIELD_UINT64, FIELD_INT64,
+        FIELD_FLOAT, FIELD_DOUBLE,
+        FIELD_UNKNOWN
+    } fieldtype_e;
+
     typedef struct field_s {
         std::string          name;
-        Read_Field_Function  decode; ///< callback to decode field
+        fieldtype_e          type;
+        unsigned int         size;    ///< bytes in the message
+        bool                 padding; ///< not to be decoded
     } field_t;
 
     typedef struct format_s {
@@ -93,7 +121,38 @@ private:
     } format_t;
 
     typedef std::map<std::string, format_t> format_map_t;
-    typedef std::map<uint8_t, std::string>  name_map_t;
+    typedef std::map<uint16_t, std::string>  name_map_t;
+
+    /**
+     * @brief one field of a decode plan. The value is written to field id of the schema.
+     */
+    typedef struct plan_field_s {
+        unsigned int offset; ///< from start of data (after msg_id)
+        fieldtype_e  type;
+        unsigned int id;
+    } plan_field_t;
+
+    /**
+     * @brief precompiled decoder for one msg_id, built once when the message is
+     * subscribed. Padding is already removed, offsets are known and the names
+     * are already in the schema, so that decoding needs no string work.
+     */
+    typedef struct decode_plan_s {
+        uint16_t                  datalen;
+        std::vector<plan_field_t> fields;
+        OnboardSchema*            schema; ///< owned by OnboardLogParser
+        bool                      skip;   ///< not selected by filter: do not decode
+    } decode_plan_t;
+
+    /**
+     * @brief one block of the sparse index: time range of all messages from offset
+     * up to the next block. ULog is only roughly sorted by time, hence min and max.
+     */
+    typedef struct index_block_s {
+        uint64_t offset; ///< file position of first message in block
+        uint64_t tmin;   ///< usec
+        uint64_t tmax;   ///< usec
+    } index_block_t;
 
     /*******************
      * METHODS
@@ -111,26 +170,66 @@ private:
     bool _decode_info_msg(uint16_t msglen, OnboardData & ret);
     bool _decode_str_msg(uint16_t msglen, OnboardData & ret);
     unsigned int _find_array_spec (std::string & fieldtype);
-    Read_Field_Function _get_field_reader (const std::string & fieldtype);
+    fieldtype_e _get_field_type (const std::string & fieldtype, unsigned int & size);
+    decode_plan_t* _get_plan(uint16_t msg_id);
+    decode_plan_t* _compile_plan(const std::string & message_name);
     void _log(logmsgtype_e t, const std::string & str);
+    void _handle_subscription(void);
+    bool _get_timestamp(int typ, uint64_t & t) const;
+    bool _prescan_seek(uint64_t offset); // implement super
+    bool _plausible_message(uint64_t pos, uint64_t & next) const;
+
+    // sparse index (time -> file offset), persisted next to the log
+    std::string _index_filename(void) const;
+    void _index_message(int typ);
+    bool _load_index(void);
+    bool _save_index(void) const;
+    void _seek_window(void);
+
+    // file access. Either in the memory mapping, or through _filebuf
+    const char* _read_inplace(unsigned int n);
+    void _skip(int64_t n);
+    int _getc(void);
+    bool _eof(void);
+    uint64_t _tell(void);
+    void _seek(uint64_t pos);
 
     /*******************
      * ATTRIBUTES
      *******************/
     std::string        _filename;
-    std::filebuf       _filebuf;
+    std::filebuf       _filebuf; ///< fallback, if file cannot be mapped
     Logger::logchannel*_logchannel;
+    QFile              _file;
+    const char*        _map;     ///< entire file, if mapped
+    uint64_t           _map_len;
+    uint64_t           _pos;     ///< read position in _map
 
     typedef enum state_s {WAIT_HEADER, WAIT_DEFS, WAIT_DATA} state_e;
 
-    char         _buffer[ULOG_BUFLEN];
-    unsigned int _buflen;
+    char         _buffer[ULOG_BUFLEN]; ///< only used if not mapped
+    const char*  _msg;    ///< current message w/o header. Points into _map or _buffer
+    unsigned int _buflen; ///< length of _msg
     state_e      _state;
 
     uint64_t     _read_until_file_position; ///< read limit if log contains appended data
 
     format_map_t _formats;
     name_map_t   _message_name;
+    std::vector<decode_plan_t*> _plans; ///< indexed by msg_id. NULL=not compiled, yet
+    std::map<std::string, OnboardSchema*> _info_schemas; ///< INFO messages: one per key
+    OnboardSchema* _str_schemas[ULOG_NUM_LEVELS]; ///< LOGGING messages: one per log level
+
+    uint64_t     _data_start;    ///< file position of first message after definitions
+    std::vector<index_block_t> _index;
+    std::vector<uint64_t> _index_subs; ///< file positions of all ADD_LOGGED_MSG
+    bool         _indexing;      ///< index is built while reading, saved at eof
+    bool         _index_loaded;  ///< index came from file, seeking is possible
+    bool         _windowed;      ///< only return messages within [_win_from, _win_to]
+    uint64_t     _win_from;
+    uint64_t     _win_to;
+    bool         _follow;        ///< see set_follow()
+    bool         _stalled;       ///< follow: last message was incomplete, has_more_data() says no once
 };
 
 #endif // ONBOARDLOGPARSERULG_H
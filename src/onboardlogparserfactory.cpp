@@ -39,11 +39,13 @@ bool OnboardLogParserFactory::Register (const std::string & ext, Create_Parser_F
     return true;
 }
 
-OnboardLogParser* OnboardLogParserFactory::Create (const std::string & file_ext) const {
+OnboardLogParser* OnboardLogParserFactory::Create (const std::string & file_ext, const TopicFilter*filter) const {
     Creator_Map::const_iterator it = _map.find (file_ext);
     if (it != _map.end()) {
         OnboardLogParserFactory::Create_Parser_Function Make_One = it->second;
-        return Make_One();
+        OnboardLogParser*olp = Make_One();
+        if (olp) olp->set_filter(filter);
+        return olp;
     } else {
         return NULL;
     }
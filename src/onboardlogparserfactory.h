@@ -48,9 +48,15 @@ public:
     bool Register (const std::string & ext, Create_Parser_Function func);
 
     /**
+     * @param filter handed to OnboardLogParser::set_filter
      * @return  suitable parser for extension, or NULL
      */
-    OnboardLogParser* Create (const std::string & file_ext) const;
+    OnboardLogParser* Create (const std::string & file_ext, const TopicFilter*filter = NULL) const;
+
+    /**
+     * @return true if Create() would give a parser for this extension
+     */
+    bool Supports (const std::string & file_ext) const { return _map.find(file_ext) != _map.end(); }
 
 private:
     OnboardLogParserFactory();
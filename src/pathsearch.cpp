@@ -0,0 +1,86 @@
+/**
+ * @file pathsearch.cpp
+ * @brief Substring search over many paths, via an index of trigrams
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <ctype.h>
+#include <algorithm>
+#include "pathsearch.h"
+
+void PathSearch::clear(void) {
+    _paths.clear();
+    _lowered.clear();
+    _index.clear();
+}
+
+std::string PathSearch::_lower(const std::string & s) {
+    std::string ret(s);
+    for (std::string::iterator it = ret.begin(); it != ret.end(); ++it) {
+        *it = tolower((unsigned char)*it);
+    }
+    return ret;
+}
+
+unsigned int PathSearch::add(const std::string & path) {
+    const unsigned int id = _paths.size();
+    _paths.push_back(path);
+    _lowered.push_back(_lower(path));
+    const std::string & low = _lowered.back();
+    for (size_t k = 0; k + 3 <= low.size(); ++k) {
+        std::vector<unsigned int> & ids = _index[_trigram(low.data() + k)];
+        if (ids.empty() || ids.back() != id) ids.push_back(id); // once per path
+    }
+    return id;
+}
+
+void PathSearch::find(const std::string & query, std::vector<unsigned int> & ids, unsigned int max) const {
+    ids.clear();
+    const std::string q = _lower(query);
+    if (q.empty()) return;
+
+    if (q.size() < 3) {
+        for (unsigned int id = 0; id < _lowered.size() && ids.size() < max; ++id) {
+            if (_lowered[id].find(q) != std::string::npos) ids.push_back(id);
+        }
+        return;
+    }
+
+    // the shortest list of the trigrams of the query has the fewest candidates
+    std::vector<const std::vector<unsigned int>*> lists;
+    for (size_t k = 0; k + 3 <= q.size(); ++k) {
+        std::map<trigram_t, std::vector<unsigned int> >::const_iterator it = _index.find(_trigram(q.data() + k));
+        if (it == _index.end()) return; // no path has it
+        lists.push_back(&it->second);
+    }
+    const std::vector<unsigned int> * shortest = lists.front();
+    for (size_t k = 1; k < lists.size(); ++k) {
+        if (lists[k]->size() < shortest->size()) shortest = lists[k];
+    }
+
+    for (std::vector<unsigned int>::const_iterator it = shortest->begin(); it != shortest->end() && ids.size() < max; ++it) {
+        bool all = true;
+        for (size_t k = 0; k < lists.size() && all; ++k) {
+            if (lists[k] != shortest) all = std::binary_search(lists[k]->begin(), lists[k]->end(), *it);
+        }
+        // trigrams can be there, but not in a row
+        if (all && _lowered[*it].find(q) != std::string::npos) ids.push_back(*it);
+    }
+}
@@ -0,0 +1,68 @@
+/**
+ * @file pathsearch.h
+ * @brief Substring search over many paths, via an index of trigrams
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef PATHSEARCH_H
+#define PATHSEARCH_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <inttypes.h>
+
+/**
+ * @brief Finds the paths which contain a query, case-insensitive. For each three characters
+ * in a row of any path, the index lists the paths having them. A query then only looks at
+ * the paths which have all of its trigrams. Queries shorter than that scan all paths.
+ */
+class PathSearch
+{
+public:
+    void clear(void);
+
+    /**
+     * @brief add a path, which gets the next id (0, 1, ...)
+     */
+    unsigned int add(const std::string & path);
+
+    /**
+     * @brief ids of the paths containing the query, in ascending order
+     * @param max stop after this many
+     */
+    void find(const std::string & query, std::vector<unsigned int> & ids, unsigned int max = 1000) const;
+
+    unsigned int size(void) const { return _paths.size(); }
+    const std::string & path(unsigned int id) const { return _paths[id]; }
+
+private:
+    typedef uint32_t trigram_t;
+    static std::string _lower(const std::string & s);
+    static trigram_t _trigram(const char*p) {
+        return ((trigram_t)(unsigned char)p[0] << 16) | ((trigram_t)(unsigned char)p[1] << 8) | (unsigned char)p[2];
+    }
+
+    std::vector<std::string> _paths;  ///< as added
+    std::vector<std::string> _lowered;
+    std::map<trigram_t, std::vector<unsigned int> > _index; ///< ids by trigram, ascending
+};
+
+#endif // PATHSEARCH_H
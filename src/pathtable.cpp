@@ -0,0 +1,140 @@
+/**
+ * @file pathtable.cpp
+ * @brief Hash table of interned data/group paths, used by MavSystem
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <cstring>
+#include "pathtable.h"
+
+#define PATHTABLE_INITIAL_SLOTS 256
+
+PathTable::PathTable() : _n_occupied(0) {
+    _slots.assign(PATHTABLE_INITIAL_SLOTS, (int)SLOT_EMPTY);
+}
+
+/**
+ * @brief FNV-1a
+ */
+uint32_t PathTable::_hash(const char*p, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t k = 0; k < len; k++) {
+        h ^= (unsigned char) p[k];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+int PathTable::find(const char*path, size_t len) const {
+    const uint32_t h = _hash(path, len);
+    const unsigned int mask = _slots.size() - 1;
+    for (unsigned int i = h & mask; ; i = (i + 1) & mask) {
+        const int id = _slots[i];
+        if (id == SLOT_EMPTY) return -1;
+        if (id == SLOT_DELETED) continue;
+        const node_t & n = _nodes[id];
+        if (n.hash == h && n.path.size() == len && memcmp(n.path.data(), path, len) == 0) return id;
+    }
+}
+
+int PathTable::intern(const std::string & path) {
+    const int found = find(path);
+    if (found >= 0) return found;
+
+    // keep load (incl. deleted) below 1/2
+    if (2 * (_n_occupied + 1) > _slots.size()) {
+        const unsigned int live = _nodes.size() - _free.size();
+        unsigned int cap = _slots.size();
+        while (4 * (live + 1) > cap) cap *= 2; // after rehash at most 1/4 full
+        _rehash(cap);
+    }
+
+    int id;
+    if (!_free.empty()) {
+        id = _free.back();
+        _free.pop_back();
+    } else {
+        id = _nodes.size();
+        _nodes.push_back(node_t());
+    }
+    node_t & n = _nodes[id];
+    n.path = path;
+    n.hash = _hash(path.data(), path.size());
+    n.data = NULL;
+    n.group = NULL;
+    n.parent = -1;
+    n.used = true;
+
+    const unsigned int mask = _slots.size() - 1;
+    unsigned int i = n.hash & mask;
+    while (_slots[i] >= 0) i = (i + 1) & mask;
+    if (_slots[i] == SLOT_EMPTY) _n_occupied++;
+    _slots[i] = id;
+    return id;
+}
+
+void PathTable::release(int id) {
+    if (id < 0 || id >= (int)_nodes.size()) return;
+    node_t & n = _nodes[id];
+    if (!n.used || n.data || n.group) return;
+
+    const unsigned int mask = _slots.size() - 1;
+    for (unsigned int i = n.hash & mask; _slots[i] != SLOT_EMPTY; i = (i + 1) & mask) {
+        if (_slots[i] == id) {
+            _slots[i] = SLOT_DELETED; // keeps probe chains intact
+            break;
+        }
+    }
+    n.used = false;
+    n.parent = -1;
+    std::string().swap(n.path);
+    _free.push_back(id);
+}
+
+void PathTable::clear(void) {
+    _nodes.clear();
+    _free.clear();
+    _slots.assign(PATHTABLE_INITIAL_SLOTS, (int)SLOT_EMPTY);
+    _n_occupied = 0;
+}
+
+unsigned int PathTable::count_data(void) const {
+    unsigned int n = 0;
+    for (std::vector<node_t>::const_iterator it = _nodes.begin(); it != _nodes.end(); ++it) {
+        if (it->data) n++;
+    }
+    return n;
+}
+
+/**
+ * @brief rebuild slots with given capacity. Drops all deleted markers.
+ */
+void PathTable::_rehash(unsigned int capacity) {
+    _slots.assign(capacity, (int)SLOT_EMPTY);
+    _n_occupied = 0;
+    const unsigned int mask = capacity - 1;
+    for (unsigned int id = 0; id < _nodes.size(); id++) {
+        if (!_nodes[id].used) continue;
+        unsigned int i = _nodes[id].hash & mask;
+        while (_slots[i] != SLOT_EMPTY) i = (i + 1) & mask;
+        _slots[i] = id;
+        _n_occupied++;
+    }
+}
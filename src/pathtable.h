@@ -0,0 +1,106 @@
+/**
+ * @file pathtable.h
+ * @brief Hash table of interned data/group paths, used by MavSystem
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef PATHTABLE_H
+#define PATHTABLE_H
+
+#include <string>
+#include <vector>
+#include <inttypes.h>
+
+class Data;
+class DataGroup;
+
+/**
+ * @brief Every path (of data or of a group) is interned once and gets a small integer
+ * id, which stays valid until it is released. Lookup is an open-addressing hash with
+ * linear probing, so finding or adding a path is O(1) amortized. The hierarchy is kept
+ * as parent ids, such that walking up needs no string work.
+ *
+ * Iterate with: for (unsigned int id=0; id<t.size(); ++id) if (t.node(id).data) ...
+ * Released ids are reused, therefore take a copy if the loop adds paths.
+ */
+class PathTable
+{
+public:
+    typedef struct node_s {
+        std::string path;
+        uint32_t    hash;
+        Data*       data;   ///< data with this path, or NULL
+        DataGroup*  group;  ///< group with this path, or NULL
+        int         parent; ///< id of the group this is in, -1=top level
+        bool        used;   ///< false = released
+    } node_t;
+
+    PathTable();
+
+    /**
+     * @return id of path, or -1 if not interned
+     */
+    int find(const std::string & path) const { return find(path.data(), path.size()); }
+    int find(const char*path, size_t len) const;
+
+    /**
+     * @return id of path. Adds it, if not interned, yet.
+     */
+    int intern(const std::string & path);
+
+    /**
+     * @brief forget the path, if neither data nor group is attached anymore
+     */
+    void release(int id);
+
+    /**
+     * @brief forget all paths. Does not delete data or groups.
+     */
+    void clear(void);
+
+    /**
+     * @return number of ids, including released ones
+     */
+    unsigned int size(void) const { return _nodes.size(); }
+
+    /**
+     * @return number of ids with data attached. O(n).
+     */
+    unsigned int count_data(void) const;
+
+    node_t & node(int id) { return _nodes[id]; }
+    const node_t & node(int id) const { return _nodes[id]; }
+
+private:
+    static uint32_t _hash(const char*p, size_t len);
+    void _rehash(unsigned int capacity);
+
+    enum { SLOT_EMPTY = -1, SLOT_DELETED = -2 };
+
+    /****************************************
+     *     DATA MEMBERS
+     ****************************************/
+    std::vector<node_t> _nodes; ///< index = id
+    std::vector<int>    _free;  ///< released ids
+    std::vector<int>    _slots; ///< node id, or SLOT_*. Size is a power of two.
+    unsigned int        _n_occupied; ///< slots which are not SLOT_EMPTY
+};
+
+#endif // PATHTABLE_H
@@ -0,0 +1,369 @@
+/**
+ * @file profiler.cpp
+ * @brief Timers and counters for the stages of an import, e.g. to find out why a batch run is slow.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <stdio.h>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QThreadStorage>
+#include <QCoreApplication>
+#include "profiler.h"
+#include "taskpool.h"
+
+using namespace std;
+
+#define TRACE_MAX_EVENTS (1u<<20) ///< per thread; about 64 MB each
+
+/// stages in the order of an import; others follow by name
+static const char*const stage_order[] = {
+    "read", "decode", "track", "cache load", "process", "postprocess", "merge", "cache save", "db save", "db load", NULL
+};
+
+typedef std::pair<std::string, Profiler::counter_t> named_counter_t;
+
+static bool slower(const named_counter_t & a, const named_counter_t & b) {
+    return a.second.nsec > b.second.nsec;
+}
+
+/**
+ * @brief stages without parent, in stage_order, each followed by its parts
+ */
+static void sort_stages(const Profiler::counters_t & counters, std::vector<named_counter_t> & rows,
+                        std::vector<bool> & is_part) {
+    // parents: own counter, or else the sum of the parts
+    Profiler::counters_t parents;
+    for (Profiler::counters_t::const_iterator it = counters.begin(); it != counters.end(); ++it) {
+        const std::string::size_type slash = it->first.find('/');
+        if (slash == std::string::npos) {
+            parents[it->first] = it->second;
+        } else {
+            const std::string parent = it->first.substr(0, slash);
+            if (counters.find(parent) == counters.end()) {
+                Profiler::counter_t & p = parents[parent];
+                p.calls += it->second.calls;
+                p.nsec += it->second.nsec;
+                p.items += it->second.items;
+                p.bytes += it->second.bytes;
+            }
+        }
+    }
+
+    std::vector<std::string> order;
+    for (const char*const*s = stage_order; *s; ++s) {
+        if (parents.find(*s) != parents.end()) order.push_back(*s);
+    }
+    for (Profiler::counters_t::const_iterator it = parents.begin(); it != parents.end(); ++it) {
+        if (std::find(order.begin(), order.end(), it->first) == order.end()) order.push_back(it->first);
+    }
+
+    rows.clear();
+    is_part.clear();
+    for (std::vector<std::string>::const_iterator it = order.begin(); it != order.end(); ++it) {
+        rows.push_back(named_counter_t(*it, parents[*it]));
+        is_part.push_back(false);
+        const std::string prefix = *it + "/";
+        std::vector<named_counter_t> parts;
+        for (Profiler::counters_t::const_iterator c = counters.lower_bound(prefix);
+             c != counters.end() && c->first.compare(0, prefix.size(), prefix) == 0; ++c) {
+            parts.push_back(*c);
+        }
+        std::stable_sort(parts.begin(), parts.end(), slower);
+        rows.insert(rows.end(), parts.begin(), parts.end());
+        is_part.insert(is_part.end(), parts.size(), true);
+    }
+}
+
+void Profiler::add(const std::string & stage, unsigned long long nsec, unsigned long long items, unsigned long long bytes) {
+    QMutexLocker lock(&_mutex);
+    count(_counters[stage], nsec, items, bytes);
+}
+
+void Profiler::add(const counters_t & counters) {
+    QMutexLocker lock(&_mutex);
+    for (counters_t::const_iterator it = counters.begin(); it != counters.end(); ++it) {
+        counter_t & c = _counters[it->first];
+        c.calls += it->second.calls;
+        c.nsec += it->second.nsec;
+        c.items += it->second.items;
+        c.bytes += it->second.bytes;
+    }
+}
+
+Profiler::counters_t Profiler::get_counters(void) const {
+    QMutexLocker lock(&_mutex);
+    return _counters;
+}
+
+void Profiler::reset(void) {
+    QMutexLocker lock(&_mutex);
+    _counters.clear();
+}
+
+void Profiler::dump(std::ostream & os) const {
+    std::vector<named_counter_t> rows;
+    std::vector<bool> is_part;
+    sort_stages(get_counters(), rows, is_part);
+    if (rows.empty()) return;
+
+    char line[256];
+    snprintf(line, sizeof(line), "%-32s %10s %12s %12s %10s %10s %12s\n",
+             "stage", "calls", "time [ms]", "items", "MB", "MB/s", "items/s");
+    os << "PROFILE:" << std::endl << line;
+    for (unsigned int k = 0; k < rows.size(); ++k) {
+        const counter_t & c = rows[k].second;
+        const double sec = c.nsec * 1E-9;
+        const double mb = c.bytes / (1024. * 1024.);
+        const std::string name = is_part[k] ? "  " + rows[k].first.substr(rows[k].first.find('/') + 1) : rows[k].first;
+        snprintf(line, sizeof(line), "%-32.32s %10llu %12.1f %12llu %10.1f %10.1f %12.0f\n",
+                 name.c_str(), c.calls, sec * 1E3, c.items, mb,
+                 (sec > 0. && c.bytes) ? mb / sec : 0., (sec > 0.) ? c.items / sec : 0.);
+        os << line;
+    }
+}
+
+/**
+ * @brief names are ours or message names, but might have quotes
+ */
+static std::string json_escape(const std::string & s) {
+    std::string out;
+    for (std::string::const_iterator it = s.begin(); it != s.end(); ++it) {
+        if (*it == '"' || *it == '\\') out += '\\';
+        if ((unsigned char) *it < 0x20) continue;
+        out += *it;
+    }
+    return out;
+}
+
+void Profiler::dump_json(std::ostream & os) const {
+    std::vector<named_counter_t> rows;
+    std::vector<bool> is_part;
+    sort_stages(get_counters(), rows, is_part);
+
+    os << "{\"stages\":[";
+    for (unsigned int k = 0; k < rows.size(); ++k) {
+        const counter_t & c = rows[k].second;
+        char ms[32];
+        snprintf(ms, sizeof(ms), "%.3f", c.nsec * 1E-6);
+        if (k > 0) os << ",";
+        os << "{\"name\":\"" << json_escape(rows[k].first) << "\",\"calls\":" << c.calls << ",\"ms\":" << ms
+           << ",\"items\":" << c.items << ",\"bytes\":" << c.bytes << "}";
+    }
+    os << "]}" << std::endl;
+}
+
+static QElapsedTimer started_clock(void) {
+    QElapsedTimer t;
+    t.start();
+    return t;
+}
+
+unsigned long long Profiler::now_nsec(void) {
+    static const QElapsedTimer clock = started_clock();
+    return (unsigned long long) clock.nsecsElapsed();
+}
+
+/********************************************
+ *  TRACER
+ ********************************************/
+
+typedef struct {
+    std::string        name;
+    unsigned long long start_nsec;
+    unsigned long long dur_nsec;
+    unsigned long long items;
+    unsigned long long bytes;
+} trace_event_t;
+
+struct trace_buffer_s {
+    QMutex                     mutex;
+    unsigned int               tid;         ///< 1, 2, ... in the order the threads started tracing
+    std::string                thread_name;
+    std::vector<trace_event_t> events;
+    unsigned long long         dropped;     ///< beyond TRACE_MAX_EVENTS
+};
+
+/**
+ * @brief what a thread knows about its buffer. The storage deletes this when the thread
+ * ends, but the buffer stays with the Tracer.
+ */
+typedef struct {
+    struct trace_buffer_s * buffer;
+} trace_thread_t;
+
+static QThreadStorage<trace_thread_t*> g_trace_thread;
+
+void Tracer::set_enabled(bool yes) {
+#if (QT_VERSION >= QT_VERSION_CHECK(5,0,0))
+    _enabled.storeRelease(yes ? 1 : 0);
+#else
+    _enabled.fetchAndStoreRelease(yes ? 1 : 0);
+#endif
+}
+
+bool Tracer::is_enabled(void) const {
+#if (QT_VERSION >= QT_VERSION_CHECK(5,0,0))
+    return _enabled.load() != 0;
+#else
+    return (int)_enabled != 0;
+#endif
+}
+
+struct trace_buffer_s * Tracer::_get_buffer(void) {
+    if (g_trace_thread.hasLocalData()) return g_trace_thread.localData()->buffer;
+
+    trace_buffer_s*const b = new trace_buffer_s;
+    b->dropped = 0;
+    const QThread*const self = QThread::currentThread();
+    {
+        QMutexLocker lock(&_mutex);
+        b->tid = _buffers.size() + 1;
+        if (self && !self->objectName().isEmpty()) {
+            b->thread_name = self->objectName().toStdString();
+        } else {
+            char name[32];
+            const bool gui = QCoreApplication::instance() && QCoreApplication::instance()->thread() == self;
+            snprintf(name, sizeof(name), "%s %u", gui ? "main" : (TaskPool::in_worker() ? "worker" : "thread"), b->tid);
+            b->thread_name = name;
+        }
+        _buffers.push_back(b);
+    }
+    trace_thread_t*const t = new trace_thread_t;
+    t->buffer = b;
+    g_trace_thread.setLocalData(t);
+    return b;
+}
+
+void Tracer::add(const std::string & name, unsigned long long start_nsec, unsigned long long dur_nsec,
+                 unsigned long long items, unsigned long long bytes) {
+    if (!is_enabled()) return;
+    trace_buffer_s*const b = _get_buffer();
+    QMutexLocker lock(&b->mutex);
+    if (b->events.size() >= TRACE_MAX_EVENTS) {
+        b->dropped++;
+        return;
+    }
+    trace_event_t e;
+    e.name = name;
+    e.start_nsec = start_nsec;
+    e.dur_nsec = dur_nsec;
+    e.items = items;
+    e.bytes = bytes;
+    b->events.push_back(e);
+}
+
+void Tracer::reset(void) {
+    QMutexLocker lock(&_mutex);
+    for (std::vector<trace_buffer_s*>::const_iterator it = _buffers.begin(); it != _buffers.end(); ++it) {
+        QMutexLocker lockb(&(*it)->mutex);
+        std::vector<trace_event_t>().swap((*it)->events);
+        (*it)->dropped = 0;
+    }
+}
+
+unsigned long long Tracer::get_num_events(void) const {
+    QMutexLocker lock(&_mutex);
+    unsigned long long n = 0;
+    for (std::vector<trace_buffer_s*>::const_iterator it = _buffers.begin(); it != _buffers.end(); ++it) {
+        QMutexLocker lockb(&(*it)->mutex);
+        n += (*it)->events.size();
+    }
+    return n;
+}
+
+void Tracer::dump_json(std::ostream & os) const {
+    std::vector<trace_buffer_s*> buffers;
+    {
+        QMutexLocker lock(&_mutex);
+        buffers = _buffers; // never freed, only added
+    }
+
+    unsigned long long dropped = 0;
+    os << "{\"traceEvents\":[{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"MavLogAnalyzer\"}}";
+    for (std::vector<trace_buffer_s*>::const_iterator it = buffers.begin(); it != buffers.end(); ++it) {
+        const trace_buffer_s & b = **it;
+        QMutexLocker lock(&(*it)->mutex);
+        if (b.events.empty()) continue;
+        dropped += b.dropped;
+        os << ",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << b.tid
+           << ",\"args\":{\"name\":\"" << json_escape(b.thread_name) << "\"}}";
+        for (std::vector<trace_event_t>::const_iterator e = b.events.begin(); e != b.events.end(); ++e) {
+            // category is the stage, as for the Profiler: "decode" for "decode/ATTITUDE"
+            const std::string cat = e->name.substr(0, e->name.find('/'));
+            char times[64];
+            snprintf(times, sizeof(times), "\"ts\":%.3f,\"dur\":%.3f", e->start_nsec * 1E-3, e->dur_nsec * 1E-3);
+            os << ",{\"name\":\"" << json_escape(e->name) << "\",\"cat\":\"" << json_escape(cat) << "\",\"ph\":\"X\","
+               << times << ",\"pid\":1,\"tid\":" << b.tid
+               << ",\"args\":{\"items\":" << e->items << ",\"bytes\":" << e->bytes << "}}";
+        }
+    }
+    os << "],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":" << dropped << "}}" << std::endl;
+}
+
+bool Tracer::write_json(const std::string & filename) const {
+    std::ofstream f(filename.c_str());
+    if (!f.good()) return false;
+    dump_json(f);
+    return f.good();
+}
+
+/********************************************
+ *  SCOPES
+ ********************************************/
+
+ProfileScope::ProfileScope(const char*stage, unsigned long long items, unsigned long long bytes) :
+    _on(Profiler::Instance().is_enabled()), _trace(Tracer::Instance().is_enabled()), _start(0), _items(items), _bytes(bytes) {
+    if (_on || _trace) {
+        _stage = stage; // only now: no string is made while both are off
+        _start = Profiler::now_nsec();
+    }
+}
+
+ProfileScope::ProfileScope(const std::string & stage, unsigned long long items, unsigned long long bytes) :
+    _on(Profiler::Instance().is_enabled()), _trace(Tracer::Instance().is_enabled()), _start(0), _items(items), _bytes(bytes) {
+    if (_on || _trace) {
+        _stage = stage;
+        _start = Profiler::now_nsec();
+    }
+}
+
+ProfileScope::~ProfileScope() {
+    if (!_on && !_trace) return;
+    const unsigned long long dt = Profiler::now_nsec() - _start;
+    if (_on) {
+        Profiler::Instance().add(_stage, dt, _items, _bytes);
+    }
+    if (_trace) {
+        Tracer::Instance().add(_stage, _start, dt, _items, _bytes);
+    }
+}
+
+TraceScope::TraceScope(const char*name) : _name(Tracer::Instance().is_enabled() ? name : NULL), _start(0) {
+    if (_name) _start = Profiler::now_nsec();
+}
+
+TraceScope::~TraceScope() {
+    if (_name) Tracer::Instance().add(_name, _start, Profiler::now_nsec() - _start);
+}
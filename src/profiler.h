@@ -0,0 +1,206 @@
+/**
+ * @file profiler.h
+ * @brief Timers and counters for the stages of an import, e.g. to find out why a batch run is slow.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <string>
+#include <map>
+#include <vector>
+#include <ostream>
+#include <QMutex>
+#include <QAtomicInt>
+
+/**
+ * @brief process-wide sums of time, calls, items and bytes by stage. Stage names are
+ * paths like the data: "decode/ATTITUDE" is a part of "decode". Disabled by default;
+ * then the timers cost one check of a flag.
+ *
+ * Stages so far: read, decode, decode/<message type>, track, process, postprocess/<name>,
+ * merge, cache load, cache save, db save, db load.
+ *
+ * Code with many small steps (one per message) should sum up in a counters_t of its
+ * own and hand it over with add() when done, instead of taking the lock each time.
+ */
+class Profiler {
+public:
+    typedef struct counter_s {
+        unsigned long long calls;
+        unsigned long long nsec;
+        unsigned long long items; ///< e.g. messages
+        unsigned long long bytes;
+        counter_s() : calls(0), nsec(0), items(0), bytes(0) {}
+    } counter_t;
+
+    typedef std::map<std::string, counter_t> counters_t;
+
+    static Profiler& Instance(void) {
+        static Profiler theProfiler;
+        return theProfiler;
+    }
+
+    /**
+     * @brief switch on before the work starts; it is not synchronized
+     */
+    void set_enabled(bool yes) { _enabled = yes; }
+    bool is_enabled(void) const { return _enabled; }
+
+    void add(const std::string & stage, unsigned long long nsec, unsigned long long items = 1, unsigned long long bytes = 0);
+
+    /**
+     * @brief add all counters of a worker at once
+     */
+    void add(const counters_t & counters);
+
+    counters_t get_counters(void) const;
+    void reset(void);
+
+    /**
+     * @brief table: each stage, followed by its parts, the slowest first
+     */
+    void dump(std::ostream & os) const;
+
+    /**
+     * @brief same as JSON object in one line: {"stages":[{"name":..,"calls":..,"ms":..,"items":..,"bytes":..},..]}
+     */
+    void dump_json(std::ostream & os) const;
+
+    /**
+     * @brief monotonic clock
+     */
+    static unsigned long long now_nsec(void);
+
+    static void count(counter_t & c, unsigned long long nsec, unsigned long long items = 1, unsigned long long bytes = 0) {
+        c.calls++;
+        c.nsec += nsec;
+        c.items += items;
+        c.bytes += bytes;
+    }
+
+private:
+    Profiler() : _enabled(false) {}
+    Profiler(const Profiler&);
+    Profiler& operator=(const Profiler&);
+
+    bool           _enabled;
+    mutable QMutex _mutex;
+    counters_t     _counters;
+};
+
+struct trace_buffer_s;
+
+/**
+ * @brief a timeline of the session: each event with its thread, start and duration, written as
+ * Chrome trace JSON (chrome://tracing, ui.perfetto.dev). Where the Profiler tells how long
+ * each stage took in sum, this shows which thread did what when, e.g., who waited for whom.
+ * Every ProfileScope is an event, too, and so is every TraceScope.
+ *
+ * Can be switched on and off at any time. Off, an event costs one atomic load. Each thread
+ * writes into a buffer of its own, whose lock is only contended while dump_json() runs.
+ * At most TRACE_MAX_EVENTS events per thread are kept, later ones are dropped.
+ */
+class Tracer {
+public:
+    static Tracer& Instance(void) {
+        static Tracer theTracer;
+        return theTracer;
+    }
+
+    void set_enabled(bool yes);
+    bool is_enabled(void) const;
+
+    /**
+     * @brief an event of the calling thread
+     * @param start_nsec see Profiler::now_nsec()
+     */
+    void add(const std::string & name, unsigned long long start_nsec, unsigned long long dur_nsec,
+             unsigned long long items = 1, unsigned long long bytes = 0);
+
+    /**
+     * @brief forget all events
+     */
+    void reset(void);
+    unsigned long long get_num_events(void) const;
+
+    /**
+     * @brief {"traceEvents":[{"name":..,"ph":"X","ts":..,"dur":..,"pid":1,"tid":..,"args":{"items":..,"bytes":..}},..]},
+     * times in microseconds, and the name of each thread
+     */
+    void dump_json(std::ostream & os) const;
+
+    /**
+     * @return false if the file cannot be written
+     */
+    bool write_json(const std::string & filename) const;
+
+private:
+    Tracer() : _enabled(0) {}
+    Tracer(const Tracer&);
+    Tracer& operator=(const Tracer&);
+
+    struct trace_buffer_s * _get_buffer(void);
+
+    mutable QAtomicInt _enabled;
+    mutable QMutex     _mutex;   ///< for _buffers
+    std::vector<struct trace_buffer_s*> _buffers; ///< one per thread which ever traced. Kept when it ends
+};
+
+/**
+ * @brief adds the time from construction to destruction to a stage, if the Profiler is
+ * enabled, and it is an event for the Tracer, if that is enabled
+ */
+class ProfileScope {
+public:
+    ProfileScope(const char*stage, unsigned long long items = 1, unsigned long long bytes = 0);
+    ProfileScope(const std::string & stage, unsigned long long items = 1, unsigned long long bytes = 0);
+    ~ProfileScope();
+
+    void set_items(unsigned long long n) { _items = n; }
+    void set_bytes(unsigned long long n) { _bytes = n; }
+
+private:
+    const bool         _on;
+    const bool         _trace;
+    std::string        _stage;
+    unsigned long long _start;
+    unsigned long long _items;
+    unsigned long long _bytes;
+};
+
+/**
+ * @brief an event for the Tracer only, for things the Profiler need not sum up, e.g., a replot
+ */
+class TraceScope {
+public:
+    /**
+     * @param name must outlive the scope, e.g., a literal
+     */
+    explicit TraceScope(const char*name);
+    ~TraceScope();
+
+private:
+    const char*        _name; ///< NULL=tracer was off
+    unsigned long long _start;
+};
+
+#endif // PROFILER_H
@@ -0,0 +1,274 @@
+/**
+ * @file resampler.cpp
+ * @brief Several time series on one common time grid, as dense columns.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+#include <QRunnable>
+#include "resampler.h"
+#include "data_timeseries.h"
+#include "csvwriter.h"
+#include "taskpool.h"
+
+#define RESAMPLE_MAX_POINTS 100000000 ///< refuse grids larger than this
+
+// shorthand for demuxing polymorphic data
+#define TRY_INPUT_DATATIMESERIES(data, typetest) \
+    if (!in) if (const DataTimeseries<typetest>*tmp = dynamic_cast<const DataTimeseries<typetest> *>(data)) { \
+        in = new ResampleInputSeries<typetest>(tmp); \
+    }
+
+/**
+ * @brief access to the samples of one series, whatever its type
+ */
+class ResampleInput {
+public:
+    virtual ~ResampleInput() {}
+    virtual const Data* get_data(void) const = 0;
+    virtual unsigned int size(void) const = 0;
+    virtual double get_min_time(void) const = 0; ///< epoch seconds
+    virtual double get_max_time(void) const = 0;
+
+    /**
+     * @brief append all time stamps, in epoch seconds
+     */
+    virtual void get_times(std::vector<double> & out) const = 0;
+
+    /**
+     * @brief values at grid (sorted) into out, NAN where there are none
+     */
+    virtual void resample(const std::vector<double> & grid, Resampler::interp_e interp, std::vector<double> & out) const = 0;
+};
+
+template <typename T>
+class ResampleInputSeries : public ResampleInput {
+public:
+    ResampleInputSeries(const DataTimeseries<T>*d) : _d(d), _offset(d->get_epoch_datastart() / 1E6) {}
+
+    const Data* get_data(void) const { return _d; }
+    unsigned int size(void) const { return _d->size(); }
+    double get_min_time(void) const { return _d->get_min_time() + _offset; }
+    double get_max_time(void) const { return _d->get_max_time() + _offset; }
+
+    void get_times(std::vector<double> & out) const {
+        std::vector<double> t;
+        std::vector<T> v;
+        for (unsigned int b = 0; b < _d->get_num_blocks(); ++b) {
+            _d->get_block(b, t, v);
+            for (unsigned int i = 0; i < t.size(); ++i) out.push_back(t[i] + _offset);
+        }
+    }
+
+    void resample(const std::vector<double> & grid, Resampler::interp_e interp, std::vector<double> & out) const {
+        out.assign(grid.size(), NAN);
+        if (_d->size() == 0) return;
+        if (!_d->is_sorted()) {
+            // slow path
+            for (size_t g = 0; g < grid.size(); ++g) {
+                T val;
+                if (_d->get_data_at_time(grid[g] - _offset, val)) out[g] = (double) val;
+            }
+            return;
+        }
+
+        // merge: walk along the samples, and fill the grid points up to each of them
+        const size_t n = grid.size();
+        size_t g = std::lower_bound(grid.begin(), grid.end(), get_min_time()) - grid.begin();
+        bool have_prev = false;
+        double t_prev = 0., v_prev = 0.;
+        std::vector<double> t;
+        std::vector<T> v;
+        for (unsigned int b = 0; b < _d->get_num_blocks() && g < n; ++b) {
+            _d->get_block(b, t, v);
+            for (unsigned int i = 0; i < t.size() && g < n; ++i) {
+                const double ts = t[i] + _offset;
+                const double vs = (double) v[i];
+                for (; g < n && grid[g] <= ts; ++g) {
+                    if (grid[g] == ts) {
+                        out[g] = vs;
+                    } else if (have_prev) {
+                        out[g] = _interpolate(interp, t_prev, v_prev, ts, vs, grid[g]);
+                    }
+                }
+                t_prev = ts;
+                v_prev = vs;
+                have_prev = true;
+            }
+        }
+    }
+
+private:
+    /**
+     * @brief value at t, with t_pre < t < t_post
+     */
+    static double _interpolate(Resampler::interp_e interp, double t_pre, double v_pre, double t_post, double v_post, double t) {
+        switch (interp) {
+        case Resampler::INTERP_HOLD:
+            return v_pre;
+        case Resampler::INTERP_NEAREST:
+            return (t - t_pre <= t_post - t) ? v_pre : v_post;
+        case Resampler::INTERP_LINEAR:
+        default:
+            return v_pre + (t - t_pre) * (v_post - v_pre) / (t_post - t_pre);
+        }
+    }
+
+    const DataTimeseries<T>* _d;
+    const double             _offset; ///< from relative time to epoch seconds
+};
+
+/**
+ * @brief computes one column in the pool of Resampler::run()
+ */
+class ResampleJob : public QRunnable {
+public:
+    ResampleJob(const Resampler*r, unsigned int k, std::vector<double> & out) : _r(r), _k(k), _out(out) {}
+    void run() { _r->_inputs[_k]->resample(_r->_time, _r->_interp, _out); }
+private:
+    const Resampler*const _r;
+    const unsigned int    _k;
+    std::vector<double> & _out;
+};
+
+Resampler::Resampler() : _grid(GRID_RATE), _rate_hz(10.), _grid_series(0), _t_from(0.), _t_to(0.), _interp(INTERP_LINEAR) {}
+
+Resampler::~Resampler() {
+    for (std::vector<ResampleInput*>::iterator it = _inputs.begin(); it != _inputs.end(); ++it) {
+        delete *it;
+    }
+}
+
+bool Resampler::add(const Data*d) {
+    ResampleInput*in = NULL;
+    if (d) {
+        TRY_INPUT_DATATIMESERIES(d, int);
+        TRY_INPUT_DATATIMESERIES(d, long);
+        TRY_INPUT_DATATIMESERIES(d, float);
+        TRY_INPUT_DATATIMESERIES(d, double);
+        TRY_INPUT_DATATIMESERIES(d, unsigned int);
+        TRY_INPUT_DATATIMESERIES(d, unsigned long);
+    }
+    if (!in) return false;
+    _inputs.push_back(in);
+    return true;
+}
+
+const Data* Resampler::get_data(unsigned int k) const {
+    return _inputs[k]->get_data();
+}
+
+bool Resampler::_build_grid(void) {
+    _time.clear();
+    switch (_grid) {
+    case GRID_RATE:
+    {
+        double t0 = 0., t1 = 0.;
+        bool any = false;
+        for (std::vector<ResampleInput*>::const_iterator it = _inputs.begin(); it != _inputs.end(); ++it) {
+            if ((*it)->size() == 0) continue;
+            if (!any || (*it)->get_min_time() < t0) t0 = (*it)->get_min_time();
+            if (!any || (*it)->get_max_time() > t1) t1 = (*it)->get_max_time();
+            any = true;
+        }
+        if (!any || !(_rate_hz > 0.)) return false;
+        if (_t_from > 0. && _t_from > t0) t0 = _t_from;
+        if (_t_to > 0. && _t_to < t1) t1 = _t_to;
+        if (t1 < t0) return false;
+        const double n = floor((t1 - t0) * _rate_hz) + 1;
+        if (n > RESAMPLE_MAX_POINTS) return false;
+        _time.resize((size_t) n);
+        for (size_t k = 0; k < _time.size(); ++k) {
+            _time[k] = t0 + k / _rate_hz; // no accumulated error
+        }
+        return true;
+    }
+    case GRID_UNION:
+        for (std::vector<ResampleInput*>::const_iterator it = _inputs.begin(); it != _inputs.end(); ++it) {
+            (*it)->get_times(_time);
+        }
+        std::sort(_time.begin(), _time.end());
+        _time.erase(std::unique(_time.begin(), _time.end()), _time.end());
+        break;
+    case GRID_SERIES:
+        if (_grid_series >= _inputs.size()) return false;
+        _inputs[_grid_series]->get_times(_time);
+        std::sort(_time.begin(), _time.end()); // no-op for the usual, sorted series
+        break;
+    }
+
+    // span
+    if (_t_from > 0.) {
+        _time.erase(_time.begin(), std::lower_bound(_time.begin(), _time.end(), _t_from));
+    }
+    if (_t_to > 0.) {
+        _time.erase(std::upper_bound(_time.begin(), _time.end(), _t_to), _time.end());
+    }
+    return !_time.empty();
+}
+
+bool Resampler::run(unsigned int nthreads) {
+    _columns.clear();
+    if (_inputs.empty() || !_build_grid()) {
+        _time.clear();
+        return false;
+    }
+    _columns.resize(_inputs.size());
+    if (1 == nthreads || _inputs.size() < 2) {
+        for (unsigned int k = 0; k < _inputs.size(); ++k) {
+            _inputs[k]->resample(_time, _interp, _columns[k]);
+        }
+    } else {
+        TaskGroup tasks(nthreads);
+        for (unsigned int k = 0; k < _inputs.size(); ++k) {
+            tasks.start(new ResampleJob(this, k, _columns[k])); // auto-deleted
+        }
+        tasks.wait();
+    }
+    return true;
+}
+
+bool Resampler::export_csv(const std::string & filename, const std::string & sep) const {
+    CsvWriter w(filename);
+    if (!w.is_open()) return false;
+
+    // epoch seconds do not fit into the digits of a cell; times are relative to the first point
+    const double t0 = _time.empty() ? 0. : _time.front();
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.6f", t0);
+    w << "#time since " << buf;
+    for (unsigned int k = 0; k < _inputs.size(); ++k) {
+        const Data*const d = _inputs[k]->get_data();
+        w << sep << Data::get_fullname(d) << "[" << d->get_units() << "]";
+    }
+    w << '\n';
+    for (size_t g = 0; g < _time.size(); ++g) {
+        w << _time[g] - t0;
+        for (unsigned int k = 0; k < _columns.size(); ++k) {
+            w << sep;
+            const double v = _columns[k][g];
+            if (!isnan(v)) w << v;
+        }
+        w << '\n';
+    }
+    return w.close();
+}
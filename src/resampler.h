@@ -0,0 +1,145 @@
+/**
+ * @file resampler.h
+ * @brief Several time series on one common time grid, as dense columns.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <string>
+#include <vector>
+#include "data.h"
+
+class ResampleInput;
+
+/**
+ * @brief Brings numeric time series of any systems or files onto one time grid, e.g., to
+ * compare or export them side by side:
+ *
+ *   Resampler r;
+ *   r.add(data_a); r.add(data_b);
+ *   r.set_grid_rate(10.);
+ *   if (r.run()) { use r.get_time(), r.get_column(0), r.get_column(1) }
+ *
+ * Times are in epoch seconds (relative time plus Data::get_epoch_datastart()), so that
+ * series of different systems line up. Each column is computed in one pass over its
+ * series and the grid, which reads compressed or spilled series block by block without
+ * unpacking them. The columns are computed in parallel.
+ *
+ * Grid points outside of the time span of a series are NAN in its column; there is
+ * no extrapolation.
+ */
+class Resampler
+{
+public:
+    typedef enum {
+        GRID_RATE,   ///< fixed rate, over the union of the time spans
+        GRID_UNION,  ///< every time stamp of any series
+        GRID_SERIES, ///< time stamps of one of the series
+    } grid_e;
+
+    typedef enum {
+        INTERP_LINEAR,  ///< between the samples before and after
+        INTERP_HOLD,    ///< the last sample before (zero-order hold)
+        INTERP_NEAREST, ///< the sample closest in time
+    } interp_e;
+
+    Resampler();
+    ~Resampler();
+
+    /**
+     * @brief add a series. Must not change until run() is done.
+     * @return false if it is no numeric time series. It is not added then.
+     */
+    bool add(const Data*d);
+
+    unsigned int get_num_series(void) const { return _inputs.size(); }
+
+    /**
+     * @brief grid with the given number of points per second. Default is 10Hz.
+     */
+    void set_grid_rate(double hz) { _grid = GRID_RATE; _rate_hz = hz; }
+    void set_grid_union(void) { _grid = GRID_UNION; }
+    void set_grid_series(unsigned int k) { _grid = GRID_SERIES; _grid_series = k; }
+
+    /**
+     * @brief only grid points between these epoch times, in addition to what the grid says.
+     * Both 0=no limit.
+     */
+    void set_span(double t_from, double t_to) { _t_from = t_from; _t_to = t_to; }
+
+    /**
+     * @brief Default is INTERP_LINEAR. Series whose time stamps are not sorted are always
+     * interpolated linearly, see DataTimeseries<T>::get_data_at_time().
+     */
+    void set_interpolation(interp_e interp) { _interp = interp; }
+
+    /**
+     * @brief build the grid and all columns
+     * @param nthreads how many columns are computed at the same time. 0=one per core
+     * @return false if there are no series, or the grid is empty or would be too large
+     */
+    bool run(unsigned int nthreads = 0);
+
+    /**
+     * @brief the grid, in epoch seconds
+     */
+    const std::vector<double> & get_time(void) const { return _time; }
+
+    /**
+     * @brief values of series k at the grid points, NAN where it has none
+     */
+    const std::vector<double> & get_column(unsigned int k) const { return _columns[k]; }
+
+    const Data* get_data(unsigned int k) const;
+
+    /**
+     * @brief one line per grid point, the time followed by all columns. Empty cells where a
+     * series has no value.
+     * @return false if the file cannot be written
+     */
+    bool export_csv(const std::string & filename, const std::string & sep = std::string(",")) const;
+
+private:
+    friend class ResampleJob;
+
+    bool _build_grid(void);
+
+    // forbid copies
+    Resampler(const Resampler&);
+    Resampler& operator=(const Resampler&);
+
+    /****************************************
+     *   DATA MEMBERS
+     ****************************************/
+    std::vector<ResampleInput*> _inputs;
+    grid_e       _grid;
+    double       _rate_hz;
+    unsigned int _grid_series;
+    double       _t_from;
+    double       _t_to;
+    interp_e     _interp;
+
+    std::vector<double>               _time;
+    std::vector<std::vector<double> > _columns;
+};
+
+#endif // RESAMPLER_H
@@ -0,0 +1,619 @@
+/**
+ * @file scenariocache.cpp
+ * @brief Binary cache of processed scenarios, for reopening a log without parsing it again.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDataStream>
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QMutexLocker>
+#include "scenariocache.h"
+#include "spillfile.h"
+#include "data_timeseries.h"
+#include "data_param.h"
+#include "data_event.h"
+#include "expression.h"
+
+using namespace std;
+
+#define SCENARIO_CACHE_MAGIC 0x4D4C4143 // "MLAC"
+#define SCENARIO_CACHE_VERSION 4
+#define SCENARIO_CACHE_SUFFIX ".mlacache"
+#define SCENARIO_CACHE_HASH_BYTES (1024*1024) ///< fingerprint this much from begin and end of the log
+#define SCENARIO_CACHE_HASH_SAMPLES 16 ///< and this many samples in between
+#define SCENARIO_CACHE_HASH_SAMPLE_BYTES (64*1024)
+#define SCENARIO_CACHE_BUFLEN 4096 ///< values written at once
+
+static QByteArray _bytes(const std::string & s) {
+    return QByteArray(s.data(), s.size());
+}
+
+static std::string _string(const QByteArray & b) {
+    return std::string(b.constData(), b.size());
+}
+
+/**
+ * @brief pad file to 8 bytes, so that mapped columns are aligned
+ */
+static bool _align(QFile & f) {
+    static const char zeros[8] = {0};
+    const qint64 pad = (8 - (f.pos() & 7)) & 7;
+    return pad == 0 || f.write(zeros, pad) == pad;
+}
+
+std::string ScenarioCache::get_cache_filename(const std::string & source, const std::string & fingerprint) {
+    const QFileInfo dir(QFileInfo(QString::fromStdString(source)).absolutePath());
+    if (dir.isWritable()) return source + SCENARIO_CACHE_SUFFIX;
+    return _hashed_filename(fingerprint.empty() ? get_fingerprint(source) : fingerprint);
+}
+
+/**
+ * @brief Hashing all of a huge log would take longer than parsing it from the cache, so the
+ * hash is over its size, its beginning, its end and a few samples in between. Log files
+ * of the same size differ in their time stamps right at the start, so this tells them apart.
+ */
+std::string ScenarioCache::get_fingerprint(const std::string & source) {
+    QFile f(QString::fromStdString(source));
+    if (!f.open(QIODevice::ReadOnly)) return std::string();
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    const qint64 size = f.size();
+    hash.addData(reinterpret_cast<const char*>(&size), sizeof(size));
+    std::vector<char> buf(SCENARIO_CACHE_HASH_BYTES);
+    qint64 n = f.read(&buf[0], buf.size());
+    if (n > 0) hash.addData(&buf[0], n);
+    if (size > 2*SCENARIO_CACHE_HASH_BYTES) {
+        // samples from the middle, then the end
+        const qint64 inner = size - 2*SCENARIO_CACHE_HASH_BYTES;
+        for (unsigned int k = 1; k <= SCENARIO_CACHE_HASH_SAMPLES; ++k) {
+            const qint64 pos = SCENARIO_CACHE_HASH_BYTES + inner*k/(SCENARIO_CACHE_HASH_SAMPLES + 1);
+            if (!f.seek(pos)) return std::string();
+            n = f.read(&buf[0], SCENARIO_CACHE_HASH_SAMPLE_BYTES);
+            if (n > 0) hash.addData(&buf[0], n);
+        }
+        if (!f.seek(size - SCENARIO_CACHE_HASH_BYTES)) return std::string();
+        n = f.read(&buf[0], buf.size());
+        if (n > 0) hash.addData(&buf[0], n);
+    } else if (size > SCENARIO_CACHE_HASH_BYTES) {
+        n = f.read(&buf[0], buf.size());
+        if (n > 0) hash.addData(&buf[0], n);
+    }
+    return _string(hash.result().toHex());
+}
+
+/**
+ * @brief name of the cache in the user's cache dir
+ */
+std::string ScenarioCache::_hashed_filename(const std::string & fingerprint) {
+    if (fingerprint.empty()) return std::string();
+    const std::string dir = QDir::homePath().toStdString() + "/.cache/MavLogAnalyzer";
+    QDir().mkpath(QString::fromStdString(dir));
+    return dir + "/" + fingerprint + SCENARIO_CACHE_SUFFIX;
+}
+
+/********************************************
+ *  WRITING
+ ********************************************/
+
+bool ScenarioCache::save(const std::string & source, const info_t & info, const std::vector<MavlinkScenario*> & scenes) {
+    const std::string cachefile = get_cache_filename(source, info.fingerprint);
+    if (cachefile.empty()) return false;
+    const std::string tmpfile = cachefile + ".tmp";
+    QFile f(QString::fromStdString(tmpfile));
+    if (!f.open(QIODevice::ReadWrite | QIODevice::Truncate)) return false;
+
+    QDataStream out(&f);
+    const QFileInfo srcinfo(QString::fromStdString(source));
+    out << (quint32) SCENARIO_CACHE_MAGIC << (quint32) SCENARIO_CACHE_VERSION << (quint64) srcinfo.size()
+        << (qint64) srcinfo.lastModified().toMSecsSinceEpoch() << _bytes(info.fingerprint) << _bytes(info.key)
+        << (quint32) info.n_jumps_fwd << (quint32) info.n_jumps_back;
+    const qint64 pos_index_offset = f.pos();
+    out << (quint64) 0; // patched below
+
+    /*
+     * columns go to the file right away, the index is collected in a second file
+     * and appended at the end. Saves us keeping it in memory.
+     */
+    QFile fidx(QString::fromStdString(tmpfile + "idx"));
+    if (!fidx.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        f.remove();
+        return false;
+    }
+    QDataStream index(&fidx);
+    bool ok = true;
+    index << (quint32) scenes.size();
+    for (std::vector<MavlinkScenario*>::const_iterator its = scenes.begin(); ok && its != scenes.end(); ++its) {
+        const MavlinkScenario & scene = **its;
+        index << _bytes(scene._name) << _bytes(scene._desc) << (quint32) scene._n_msgs << (quint32) scene._n_ignored
+              << (quint64) scene._time_guess_epoch_usec << (quint32) scene._seen_systems.size();
+        for (MavlinkScenario::systemlist::const_iterator it = scene._seen_systems.begin(); ok && it != scene._seen_systems.end(); ++it) {
+            ok = _write_system(f, index, *it->second);
+        }
+    }
+
+    // append index
+    ok = ok && _align(f) && index.status() == QDataStream::Ok;
+    const qint64 index_offset = f.pos();
+    if (ok && fidx.seek(0)) {
+        std::vector<char> buf(1024*1024);
+        qint64 n;
+        while (ok && (n = fidx.read(&buf[0], buf.size())) > 0) {
+            ok = (f.write(&buf[0], n) == n);
+        }
+    }
+    fidx.remove();
+    ok = ok && f.seek(pos_index_offset);
+    out << (quint64) index_offset;
+    ok = ok && out.status() == QDataStream::Ok && f.flush();
+    f.close();
+    if (!ok) {
+        QFile::remove(QString::fromStdString(tmpfile));
+        return false;
+    }
+    QFile::remove(QString::fromStdString(cachefile));
+    return QFile::rename(QString::fromStdString(tmpfile), QString::fromStdString(cachefile));
+}
+
+bool ScenarioCache::_write_system(QFile & f, QDataStream & index, const MavSystem & sys) {
+    index << (quint32) sys.id << (quint32) sys.mavtype << _bytes(sys.mavtype_str) << (quint32) sys.aptype
+          << _bytes(sys.aptype_str) << (quint8) sys.has_been_armed << sys._time << sys._time_min << sys._time_max
+          << (quint8) sys._time_valid << (quint64) sys._time_offset_usec << (quint64) sys._time_offset_guess_usec;
+    index << (quint32) sys._time_offset_raw.size();
+    for (std::vector<MavSystem::timeoffset_pair>::const_iterator it = sys._time_offset_raw.begin(); it != sys._time_offset_raw.end(); ++it) {
+        index << (quint64) it->first << (quint64) it->second;
+    }
+
+    const MavSystem::mavlink_summary_t & sum = sys._mavlink_summary;
+    index << (quint64) sum.num_received << (quint64) sum.num_interpreted << (quint64) sum.num_uninterpreted << (quint64) sum.num_error
+          << (quint32) sum._link_throughput_bytes;
+    index << (quint32) sum.mavlink_msgids_interpreted.size();
+    for (std::set<unsigned int>::const_iterator it = sum.mavlink_msgids_interpreted.begin(); it != sum.mavlink_msgids_interpreted.end(); ++it) {
+        index << (quint32) *it;
+    }
+    index << (quint32) sum.mavlink_msgids_uninterpreted.size();
+    for (std::set<unsigned int>::const_iterator it = sum.mavlink_msgids_uninterpreted.begin(); it != sum.mavlink_msgids_uninterpreted.end(); ++it) {
+        index << (quint32) *it;
+    }
+    index << (quint64) sum.num_disabled << (quint32) sum.mavlink_msgids_disabled.size();
+    for (std::set<unsigned int>::const_iterator it = sum.mavlink_msgids_disabled.begin(); it != sum.mavlink_msgids_disabled.end(); ++it) {
+        index << (quint32) *it;
+    }
+    index << (quint32) sum.msgstats.size();
+    for (std::map<unsigned int, MavSystem::mavlink_msgstat_t>::const_iterator it = sum.msgstats.begin(); it != sum.msgstats.end(); ++it) {
+        index << (quint32) it->first << (quint64) it->second.count << (quint64) it->second.nsec;
+    }
+
+    // data: count first, then each. Not the user's derived series: they follow from the settings, and are
+    // computed again after loading
+    const std::string derived = EXPRESSION_GROUP;
+    std::vector<unsigned int> ids;
+    for (unsigned int id = 0; id < sys._paths.size(); ++id) {
+        if (!sys._paths.node(id).data) continue;
+        if (sys._paths.node(id).path.compare(0, derived.size(), derived) == 0) continue;
+        ids.push_back(id);
+    }
+    index << (quint32) ids.size();
+    for (std::vector<unsigned int>::const_iterator it = ids.begin(); it != ids.end(); ++it) {
+        if (!_write_data(f, index, sys._paths.node(*it).path, sys._paths.node(*it).data)) return false;
+    }
+    return true;
+}
+
+bool ScenarioCache::_write_data(QFile & f, QDataStream & index, const std::string & path, const Data*const d) {
+    // FIXME: use superclasses DataTimed, DataUntimed
+    kind_e kind;
+    if (dynamic_cast<const DataTimeseries<float>*>(d)) kind = KIND_SERIES_FLOAT;
+    else if (dynamic_cast<const DataTimeseries<double>*>(d)) kind = KIND_SERIES_DOUBLE;
+    else if (dynamic_cast<const DataTimeseries<int>*>(d)) kind = KIND_SERIES_INT;
+    else if (dynamic_cast<const DataTimeseries<unsigned int>*>(d)) kind = KIND_SERIES_UINT;
+    else if (dynamic_cast<const DataTimeseries<bool>*>(d)) kind = KIND_SERIES_BOOL;
+    else if (dynamic_cast<const DataParam<float>*>(d)) kind = KIND_PARAM_FLOAT;
+    else if (dynamic_cast<const DataParam<double>*>(d)) kind = KIND_PARAM_DOUBLE;
+    else if (dynamic_cast<const DataParam<int>*>(d)) kind = KIND_PARAM_INT;
+    else if (dynamic_cast<const DataParam<unsigned int>*>(d)) kind = KIND_PARAM_UINT;
+    else if (dynamic_cast<const DataEvent<std::string>*>(d)) kind = KIND_EVENT_STRING;
+    else if (dynamic_cast<const DataEvent<bool>*>(d)) kind = KIND_EVENT_BOOL;
+    else {
+        std::cerr << "Cannot cache data " << path << " of type " << d->get_typename() << std::endl;
+        return false;
+    }
+
+    const DataTimed*const dt = dynamic_cast<const DataTimed*>(d);
+    index << (quint8) kind << _bytes(path) << _bytes(d->get_units()) << (quint8) d->_class
+          << (quint64) d->get_epoch_datastart() << (quint8) d->_valid << (quint8) (dt && dt->has_bad_timestamps());
+
+    switch (kind) {
+    case KIND_SERIES_FLOAT:  return _write_series(f, index, *dynamic_cast<const DataTimeseries<float>*>(d));
+    case KIND_SERIES_DOUBLE: return _write_series(f, index, *dynamic_cast<const DataTimeseries<double>*>(d));
+    case KIND_SERIES_INT:    return _write_series(f, index, *dynamic_cast<const DataTimeseries<int>*>(d));
+    case KIND_SERIES_UINT:   return _write_series(f, index, *dynamic_cast<const DataTimeseries<unsigned int>*>(d));
+    case KIND_SERIES_BOOL:   return _write_series(f, index, *dynamic_cast<const DataTimeseries<bool>*>(d));
+    case KIND_PARAM_FLOAT:   _write_param(index, *dynamic_cast<const DataParam<float>*>(d)); break;
+    case KIND_PARAM_DOUBLE:  _write_param(index, *dynamic_cast<const DataParam<double>*>(d)); break;
+    case KIND_PARAM_INT:     _write_param(index, *dynamic_cast<const DataParam<int>*>(d)); break;
+    case KIND_PARAM_UINT:    _write_param(index, *dynamic_cast<const DataParam<unsigned int>*>(d)); break;
+    case KIND_EVENT_STRING:
+        {
+            const DataEvent<std::string>*const e = dynamic_cast<const DataEvent<std::string>*>(d);
+            const std::vector<double> & times = e->get_time();
+            const std::vector<EventDict::id_t> & ids = e->get_stored();
+            index << (quint32) ids.size();
+            for (unsigned int k = 0; k < ids.size(); ++k) index << times[k] << _bytes(EventDict::lookup(ids[k]));
+        }
+        break;
+    case KIND_EVENT_BOOL:
+        {
+            const DataEvent<bool>*const e = dynamic_cast<const DataEvent<bool>*>(d);
+            const std::vector<double> & times = e->get_time();
+            const std::vector<bool> & data = e->get_stored();
+            index << (quint32) data.size();
+            for (unsigned int k = 0; k < data.size(); ++k) index << times[k] << (quint8) data[k];
+        }
+        break;
+    }
+    return true;
+}
+
+/**
+ * @brief statistics go to the index, samples to the file as two columns. Works with any
+ * storage of the series, since it goes block by block.
+ */
+template <typename T>
+bool ScenarioCache::_write_series(QFile & f, QDataStream & index, const DataTimeseries<T> & ts) {
+    const quint64 n = ts._stored();
+    if (!_align(f)) return false;
+    const quint64 offset = f.pos();
+    index << (quint8) ts._keepitems << (quint32) ts._n << ts._mean << ts._m2 << (double) ts._min << (double) ts._max
+          << ts._min_t << ts._max_t << (quint8) ts._min_valid << (quint8) ts._max_valid << (quint8) ts._sorted
+          << n << offset;
+
+    std::vector<double> time;
+    std::vector<T> data;
+    for (unsigned int b = 0; b < ts.get_num_blocks(); ++b) {
+        ts.get_block(b, time, data);
+        if (time.empty()) continue;
+        const qint64 bytes = time.size()*sizeof(double);
+        if (f.write(reinterpret_cast<const char*>(&time[0]), bytes) != bytes) return false;
+    }
+    T buf[SCENARIO_CACHE_BUFLEN]; // std::vector<bool> has no array inside
+    for (unsigned int b = 0; b < ts.get_num_blocks(); ++b) {
+        ts.get_block(b, time, data);
+        for (size_t lo = 0; lo < data.size(); lo += SCENARIO_CACHE_BUFLEN) {
+            const size_t len = std::min(data.size() - lo, (size_t)SCENARIO_CACHE_BUFLEN);
+            for (size_t k = 0; k < len; ++k) buf[k] = data[lo + k];
+            const qint64 bytes = len*sizeof(T);
+            if (f.write(reinterpret_cast<const char*>(buf), bytes) != bytes) return false;
+        }
+    }
+    return true;
+}
+
+template <typename T>
+void ScenarioCache::_write_param(QDataStream & index, const DataParam<T> & p) {
+    index << (double) p.get_value();
+}
+
+/********************************************
+ *  READING
+ ********************************************/
+
+bool ScenarioCache::load(const std::string & source, info_t & info, std::vector<MavlinkScenario*> & scenes,
+                         const CmdlineArgs*const args) {
+    if (info.fingerprint.empty()) info.fingerprint = get_fingerprint(source);
+    // next to the log wins, then the one in the cache dir
+    const std::string local = source + SCENARIO_CACHE_SUFFIX;
+    if (QFile::exists(QString::fromStdString(local))) {
+        if (_load(local, source, info, scenes, args)) return true;
+    }
+    const std::string hashed = _hashed_filename(info.fingerprint);
+    if (!hashed.empty() && QFile::exists(QString::fromStdString(hashed))) {
+        return _load(hashed, source, info, scenes, args);
+    }
+    return false;
+}
+
+bool ScenarioCache::_load(const std::string & cachefile, const std::string & source, info_t & info,
+                          std::vector<MavlinkScenario*> & scenes, const CmdlineArgs*const args) {
+    QFile f(QString::fromStdString(cachefile));
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    QDataStream in(&f);
+
+    const QFileInfo srcinfo(QString::fromStdString(source));
+    quint32 magic, version, n_jumps_fwd, n_jumps_back;
+    quint64 srcsize, index_offset;
+    qint64 mtime;
+    QByteArray fingerprint, key;
+    in >> magic >> version >> srcsize >> mtime >> fingerprint >> key >> n_jumps_fwd >> n_jumps_back >> index_offset;
+    if (in.status() != QDataStream::Ok || magic != SCENARIO_CACHE_MAGIC || version != SCENARIO_CACHE_VERSION ||
+        srcsize != (quint64)srcinfo.size() || _string(key) != info.key) {
+        return false; // stale, or made with other settings
+    }
+    // a copy of the log, or the same one touched, has another time but the same contents
+    const bool same_time = (mtime == (qint64)srcinfo.lastModified().toMSecsSinceEpoch());
+    if (!same_time && (info.fingerprint.empty() || _string(fingerprint) != info.fingerprint)) {
+        return false;
+    }
+    if (!f.seek(index_offset)) return false;
+
+    // columns stay in the file, and are mapped as they are needed
+    SpillFile*const columns = SpillFile::open(cachefile);
+    if (!columns) return false;
+
+    std::vector<MavlinkScenario*> loaded;
+    quint32 nscenes = 0;
+    in >> nscenes;
+    bool ok = (in.status() == QDataStream::Ok);
+    for (quint32 s = 0; ok && s < nscenes; ++s) {
+        MavlinkScenario*const scene = new MavlinkScenario(args);
+        loaded.push_back(scene);
+        QByteArray name, desc;
+        quint32 n_msgs, n_ignored, nsys;
+        quint64 time_guess;
+        in >> name >> desc >> n_msgs >> n_ignored >> time_guess >> nsys;
+        scene->setName(_string(name));
+        scene->setDescription(_string(desc));
+        scene->_n_msgs = n_msgs;
+        scene->_n_ignored = n_ignored;
+        scene->_time_guess_epoch_usec = time_guess;
+        ok = (in.status() == QDataStream::Ok);
+        for (quint32 k = 0; ok && k < nsys; ++k) {
+            quint32 id;
+            in >> id;
+            MavSystem*const sys = scene->_get_or_add_system_byid(id);
+            ok = sys && _read_system(in, *columns, *sys);
+        }
+    }
+    columns->unref(); // the data we mapped keeps it open
+    if (!ok) {
+        std::cerr << "Cache file " << cachefile << " is broken, ignoring it" << std::endl;
+        for (std::vector<MavlinkScenario*>::iterator it = loaded.begin(); it != loaded.end(); ++it) delete *it;
+        return false;
+    }
+    info.n_jumps_fwd = n_jumps_fwd;
+    info.n_jumps_back = n_jumps_back;
+    scenes.insert(scenes.end(), loaded.begin(), loaded.end());
+    return true;
+}
+
+bool ScenarioCache::_read_system(QDataStream & in, SpillFile & columns, MavSystem & sys) {
+    QByteArray mavtype_str, aptype_str;
+    quint32 mavtype, aptype, nraw;
+    quint8 armed, time_valid;
+    quint64 offset, offset_guess;
+    in >> mavtype >> mavtype_str >> aptype >> aptype_str >> armed >> sys._time >> sys._time_min >> sys._time_max
+       >> time_valid >> offset >> offset_guess >> nraw;
+    sys.mavtype = mavtype;
+    sys.mavtype_str = _string(mavtype_str);
+    sys.aptype = aptype;
+    sys.aptype_str = _string(aptype_str);
+    sys.has_been_armed = armed;
+    sys._time_valid = time_valid;
+    sys._time_offset_usec = offset;
+    sys._time_offset_guess_usec = offset_guess;
+    for (quint32 k = 0; k < nraw && in.status() == QDataStream::Ok; ++k) {
+        quint64 rel, epoch;
+        in >> rel >> epoch;
+        sys._time_offset_raw.push_back(MavSystem::timeoffset_pair(rel, epoch));
+    }
+
+    MavSystem::mavlink_summary_t & sum = sys._mavlink_summary;
+    quint64 num_received, num_interpreted, num_uninterpreted, num_error;
+    quint32 throughput, nids;
+    in >> num_received >> num_interpreted >> num_uninterpreted >> num_error >> throughput;
+    sum.num_received = num_received;
+    sum.num_interpreted = num_interpreted;
+    sum.num_uninterpreted = num_uninterpreted;
+    sum.num_error = num_error;
+    sum._link_throughput_bytes = throughput;
+    in >> nids;
+    for (quint32 k = 0; k < nids && in.status() == QDataStream::Ok; ++k) {
+        quint32 msgid;
+        in >> msgid;
+        sum.mavlink_msgids_interpreted.insert(msgid);
+    }
+    in >> nids;
+    for (quint32 k = 0; k < nids && in.status() == QDataStream::Ok; ++k) {
+        quint32 msgid;
+        in >> msgid;
+        sum.mavlink_msgids_uninterpreted.insert(msgid);
+    }
+    quint64 num_disabled;
+    in >> num_disabled >> nids;
+    sum.num_disabled = num_disabled;
+    for (quint32 k = 0; k < nids && in.status() == QDataStream::Ok; ++k) {
+        quint32 msgid;
+        in >> msgid;
+        sum.mavlink_msgids_disabled.insert(msgid);
+    }
+    in >> nids;
+    for (quint32 k = 0; k < nids && in.status() == QDataStream::Ok; ++k) {
+        quint32 msgid;
+        quint64 count, nsec;
+        in >> msgid >> count >> nsec;
+        MavSystem::mavlink_msgstat_t & stat = sum.msgstats[msgid];
+        stat.count = count;
+        stat.nsec = nsec;
+    }
+
+    quint32 ndata = 0;
+    in >> ndata;
+    for (quint32 k = 0; k < ndata; ++k) {
+        if (in.status() != QDataStream::Ok || !_read_data(in, columns, sys)) return false;
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+bool ScenarioCache::_read_data(QDataStream & in, SpillFile & columns, MavSystem & sys) {
+    quint8 kind, cls, valid, bad_timestamps;
+    QByteArray bpath, bunits;
+    quint64 epoch;
+    in >> kind >> bpath >> bunits >> cls >> epoch >> valid >> bad_timestamps;
+    if (in.status() != QDataStream::Ok) return false;
+    const std::string path = _string(bpath);
+    const std::string units = _string(bunits);
+
+    Data* d = NULL;
+    bool ok = true;
+    switch (kind) {
+    case KIND_SERIES_FLOAT:
+        {
+            DataTimeseries<float>*const ts = sys._get_and_possibly_create_data< DataTimeseries<float> >(path, units);
+            ok = ts && _read_series(in, columns, *ts);
+            d = ts;
+        }
+        break;
+    case KIND_SERIES_DOUBLE:
+        {
+            DataTimeseries<double>*const ts = sys._get_and_possibly_create_data< DataTimeseries<double> >(path, units);
+            ok = ts && _read_series(in, columns, *ts);
+            d = ts;
+        }
+        break;
+    case KIND_SERIES_INT:
+        {
+            DataTimeseries<int>*const ts = sys._get_and_possibly_create_data< DataTimeseries<int> >(path, units);
+            ok = ts && _read_series(in, columns, *ts);
+            d = ts;
+        }
+        break;
+    case KIND_SERIES_UINT:
+        {
+            DataTimeseries<unsigned int>*const ts = sys._get_and_possibly_create_data< DataTimeseries<unsigned int> >(path, units);
+            ok = ts && _read_series(in, columns, *ts);
+            d = ts;
+        }
+        break;
+    case KIND_SERIES_BOOL:
+        {
+            DataTimeseries<bool>*const ts = sys._get_and_possibly_create_data< DataTimeseries<bool> >(path, units);
+            ok = ts && _read_series(in, columns, *ts);
+            d = ts;
+        }
+        break;
+    case KIND_PARAM_FLOAT:
+        {
+            DataParam<float>*const p = sys._get_and_possibly_create_data< DataParam<float> >(path, units);
+            if (p) _read_param(in, *p);
+            d = p;
+        }
+        break;
+    case KIND_PARAM_DOUBLE:
+        {
+            DataParam<double>*const p = sys._get_and_possibly_create_data< DataParam<double> >(path, units);
+            if (p) _read_param(in, *p);
+            d = p;
+        }
+        break;
+    case KIND_PARAM_INT:
+        {
+            DataParam<int>*const p = sys._get_and_possibly_create_data< DataParam<int> >(path, units);
+            if (p) _read_param(in, *p);
+            d = p;
+        }
+        break;
+    case KIND_PARAM_UINT:
+        {
+            DataParam<unsigned int>*const p = sys._get_and_possibly_create_data< DataParam<unsigned int> >(path, units);
+            if (p) _read_param(in, *p);
+            d = p;
+        }
+        break;
+    case KIND_EVENT_STRING:
+        {
+            DataEvent<std::string>*const e = sys._get_and_possibly_create_data< DataEvent<std::string> >(path, units);
+            quint32 n = 0;
+            in >> n;
+            for (quint32 k = 0; e && k < n && in.status() == QDataStream::Ok; ++k) {
+                double t;
+                QByteArray s;
+                in >> t >> s;
+                e->add_elem(_string(s), t);
+            }
+            d = e;
+        }
+        break;
+    case KIND_EVENT_BOOL:
+        {
+            DataEvent<bool>*const e = sys._get_and_possibly_create_data< DataEvent<bool> >(path, units);
+            quint32 n = 0;
+            in >> n;
+            for (quint32 k = 0; e && k < n && in.status() == QDataStream::Ok; ++k) {
+                double t;
+                quint8 b;
+                in >> t >> b;
+                e->add_elem(b != 0, t);
+            }
+            d = e;
+        }
+        break;
+    default:
+        return false; // cannot skip what we do not know
+    }
+    if (!d || !ok) return false;
+
+    d->set_type((Data::data_classifier_e) cls);
+    d->set_epoch_datastart(epoch);
+    d->_valid = valid;
+    DataTimed*const dt = dynamic_cast<DataTimed*>(d);
+    if (dt && bad_timestamps) dt->set_has_bad_timestamps();
+    return true;
+}
+
+/**
+ * @brief restore statistics, and let the samples point into the cache file
+ */
+template <typename T>
+bool ScenarioCache::_read_series(QDataStream & in, SpillFile & columns, DataTimeseries<T> & ts) {
+    quint8 keepitems, min_valid, max_valid, sorted;
+    quint32 nstat;
+    quint64 n, offset;
+    double vmin, vmax;
+    in >> keepitems >> nstat >> ts._mean >> ts._m2 >> vmin >> vmax >> ts._min_t >> ts._max_t
+       >> min_valid >> max_valid >> sorted >> n >> offset;
+    if (in.status() != QDataStream::Ok) return false;
+    ts._keepitems = keepitems;
+    ts._n = nstat;
+    ts._min = (T) vmin;
+    ts._max = (T) vmax;
+    ts._min_valid = min_valid;
+    ts._max_valid = max_valid;
+    ts._sorted = sorted;
+    if (n == 0) return true;
+
+    SpillRegion*const region = columns.map(offset, n*(sizeof(double) + sizeof(T)));
+    if (!region) return false;
+    QMutexLocker lock(&ts._storage_mutex());
+    if (ts._spill()) ts._spill()->unref();
+    ts._spill_n = n;
+    ts._set_spill(region);
+    return true;
+}
+
+template <typename T>
+void ScenarioCache::_read_param(QDataStream & in, DataParam<T> & p) {
+    double v;
+    in >> v;
+    p.add_elem((T) v);
+}
@@ -0,0 +1,123 @@
+/**
+ * @file scenariocache.h
+ * @brief Binary cache of processed scenarios, for reopening a log without parsing it again.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef SCENARIOCACHE_H
+#define SCENARIOCACHE_H
+
+#include <string>
+#include <vector>
+#include "mavlinkscenario.h"
+#include "cmdlineargs.h"
+
+class QFile;
+class QDataStream;
+class SpillFile;
+
+/**
+ * @brief Writes the scenarios made from one log file into a cache file, and reads them
+ * back. Everything is kept: systems, data paths, units, raw/derived, epochs, statistics.
+ * Only the series of the user's expressions are not, since they depend on the settings;
+ * MavlinkScenario::process_cached() computes them again.
+ *
+ * The samples of time series are stored as columns (all time stamps, then all values),
+ * in native byte order. When loading, these columns are not read but mapped (see
+ * SpillFile), so that the OS only reads what is actually looked at. The
+ * description of everything else (the index) is at the end of the file.
+ *
+ * The cache is written next to the log file (<log>.mlacache), or, if that directory is
+ * not writable, into ~/.cache/MavLogAnalyzer, named after the fingerprint of the log's
+ * contents (see get_fingerprint()). It is only used if the log has the same size and either
+ * the same modification time or the same fingerprint as when the cache was written, and if
+ * it was made with the same settings (see info_t::key). Copies and renamed logs therefore
+ * find the cache in ~/.cache/MavLogAnalyzer.
+ */
+class ScenarioCache
+{
+public:
+    typedef struct {
+        std::string  key;          ///< whatever else the result depends on, e.g., import options
+        std::string  fingerprint;  ///< of the log, see get_fingerprint(). load() computes it if empty
+        unsigned int n_jumps_fwd;  ///< time jumps seen while parsing
+        unsigned int n_jumps_back;
+    } info_t;
+
+    /**
+     * @brief load the cached scenarios of the given log file
+     * @param source full path of the log file
+     * @param info key must be set, fingerprint may be; the rest is filled in
+     * @param scenes new scenarios are appended, owned by caller
+     * @param args handed to the new scenarios
+     * @return false if there is no usable cache
+     */
+    static bool load(const std::string & source, info_t & info, std::vector<MavlinkScenario*> & scenes,
+                     const CmdlineArgs*const args);
+
+    /**
+     * @brief write the cache for the given log file. Failing is not an error, e.g., read-only media.
+     * @return true if written
+     */
+    static bool save(const std::string & source, const info_t & info, const std::vector<MavlinkScenario*> & scenes);
+
+    /**
+     * @return where the cache for this log file would be written
+     * @param fingerprint of source, if known
+     */
+    static std::string get_cache_filename(const std::string & source, const std::string & fingerprint = std::string());
+
+    /**
+     * @brief a fast hash of the contents of a log file, which does not depend on its name.
+     * Only parts of it are read, so that this costs few milliseconds even for huge logs.
+     * @return hex string, empty if the file cannot be read
+     */
+    static std::string get_fingerprint(const std::string & source);
+
+private:
+    typedef enum {
+        KIND_SERIES_FLOAT = 1,
+        KIND_SERIES_DOUBLE,
+        KIND_SERIES_INT,
+        KIND_SERIES_UINT,
+        KIND_SERIES_BOOL,
+        KIND_PARAM_FLOAT,
+        KIND_PARAM_DOUBLE,
+        KIND_PARAM_INT,
+        KIND_PARAM_UINT,
+        KIND_EVENT_STRING,
+        KIND_EVENT_BOOL
+    } kind_e;
+
+    static std::string _hashed_filename(const std::string & fingerprint);
+    static bool _load(const std::string & cachefile, const std::string & source, info_t & info,
+                      std::vector<MavlinkScenario*> & scenes, const CmdlineArgs*const args);
+    static bool _write_system(QFile & f, QDataStream & index, const MavSystem & sys);
+    static bool _write_data(QFile & f, QDataStream & index, const std::string & path, const Data*const d);
+    static bool _read_system(QDataStream & in, SpillFile & columns, MavSystem & sys);
+    static bool _read_data(QDataStream & in, SpillFile & columns, MavSystem & sys);
+
+    template <typename T> static bool _write_series(QFile & f, QDataStream & index, const DataTimeseries<T> & ts);
+    template <typename T> static bool _read_series(QDataStream & in, SpillFile & columns, DataTimeseries<T> & ts);
+    template <typename T> static void _write_param(QDataStream & index, const DataParam<T> & p);
+    template <typename T> static void _read_param(QDataStream & in, DataParam<T> & p);
+};
+
+#endif // SCENARIOCACHE_H
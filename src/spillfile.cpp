@@ -0,0 +1,115 @@
+/**
+ * @file spillfile.cpp
+ * @brief Scratch file for samples which do not fit into memory.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <iostream>
+#include <QFile>
+#include <QTemporaryFile>
+#include <QDir>
+#include <QString>
+#include <QMutexLocker>
+#include "spillfile.h"
+
+static QMutex g_total_mutex;
+static size_t g_total_bytes = 0;
+
+SpillFile* SpillFile::create(const std::string & dir) {
+    const QString path = dir.empty() ? QDir::tempPath() : QString::fromStdString(dir);
+    QTemporaryFile*const file = new QTemporaryFile(path + "/mavloganalyzer-spill-XXXXXX");
+    if (!file->open()) {
+        std::cerr << "Cannot create spill file in " << path.toStdString() << std::endl;
+        delete file;
+        return NULL;
+    }
+    return new SpillFile(file, 0);
+}
+
+SpillFile* SpillFile::open(const std::string & filename) {
+    QFile*const file = new QFile(QString::fromStdString(filename));
+    if (!file->open(QIODevice::ReadOnly)) {
+        delete file;
+        return NULL;
+    }
+    return new SpillFile(file, file->size());
+}
+
+SpillFile::SpillFile(QFile * file, size_t size) : _file(file), _size(size), _region_start(size), _ref(1) {
+    _filename = file->fileName().toStdString();
+    if (size == 0) return; // ours
+    QMutexLocker lock(&g_total_mutex);
+    g_total_bytes += size;
+}
+
+SpillFile::~SpillFile() {
+    delete _file; // removes it, if temporary
+    QMutexLocker lock(&g_total_mutex);
+    g_total_bytes -= _size;
+}
+
+void SpillFile::begin_region(void) {
+    QMutexLocker lock(&_mutex);
+    // keep regions aligned for any kind of samples
+    static const char zeros[8] = {0};
+    const size_t pad = (8 - (_size & 7)) & 7;
+    if (pad > 0 && _file->write(zeros, pad) == (qint64)pad) {
+        _size += pad;
+        QMutexLocker lockt(&g_total_mutex);
+        g_total_bytes += pad;
+    }
+    _region_start = _size;
+}
+
+bool SpillFile::write(const void * data, size_t bytes) {
+    QMutexLocker lock(&_mutex);
+    if (_file->write(static_cast<const char*>(data), bytes) != (qint64)bytes) return false;
+    _size += bytes;
+    QMutexLocker lockt(&g_total_mutex);
+    g_total_bytes += bytes;
+    return true;
+}
+
+SpillRegion* SpillFile::map_region(void) {
+    QMutexLocker lock(&_mutex);
+    const size_t bytes = _size - _region_start;
+    if (bytes == 0 || !_file->flush()) return NULL;
+    uchar*const addr = _file->map(_region_start, bytes);
+    if (!addr) return NULL;
+    return new SpillRegion(this, reinterpret_cast<const char*>(addr), bytes);
+}
+
+SpillRegion* SpillFile::map(size_t offset, size_t bytes) {
+    QMutexLocker lock(&_mutex);
+    if (bytes == 0 || offset + bytes > _size) return NULL;
+    uchar*const addr = _file->map(offset, bytes);
+    if (!addr) return NULL;
+    return new SpillRegion(this, reinterpret_cast<const char*>(addr), bytes);
+}
+
+void SpillFile::_unmap(const char * addr) {
+    QMutexLocker lock(&_mutex);
+    _file->unmap(reinterpret_cast<uchar*>(const_cast<char*>(addr)));
+}
+
+size_t SpillFile::get_bytes_total(void) {
+    QMutexLocker lock(&g_total_mutex);
+    return g_total_bytes;
+}
@@ -0,0 +1,147 @@
+/**
+ * @file spillfile.h
+ * @brief Scratch file for samples which do not fit into memory.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef SPILLFILE_H
+#define SPILLFILE_H
+
+#include <string>
+#include <stddef.h>
+#include <QAtomicInt>
+#include <QMutex>
+
+class QFile;
+class SpillRegion;
+
+/**
+ * @brief A temporary file in a scratch directory, which is removed when the last
+ * region in it is gone. Data is appended to it once and then mapped read-only, so the
+ * OS pages it in on demand and can drop the pages again without writing them anywhere.
+ *
+ * Usage: begin_region(), then write() as often as needed, then map_region().
+ * Only one region can be written at a time.
+ *
+ * Existing files (see ScenarioCache) can be opened read-only, and pieces of them mapped.
+ */
+class SpillFile
+{
+public:
+    /**
+     * @param dir where to put the file. Empty = system's temp directory
+     * @return NULL if the file cannot be created
+     */
+    static SpillFile* create(const std::string & dir);
+
+    /**
+     * @brief open an existing file read-only. It is not removed.
+     * @return NULL if it cannot be opened
+     */
+    static SpillFile* open(const std::string & filename);
+
+    SpillFile* ref(void) { _ref.ref(); return this; }
+    void unref(void) { if (!_ref.deref()) delete this; }
+
+    /**
+     * @brief start a new region at the end of the file
+     */
+    void begin_region(void);
+
+    /**
+     * @brief append to the current region
+     * @return false on error, e.g., disk full
+     */
+    bool write(const void * data, size_t bytes);
+
+    /**
+     * @brief map everything written since begin_region()
+     * @return NULL on error. Else the region, which keeps a reference on this file.
+     */
+    SpillRegion* map_region(void);
+
+    /**
+     * @brief map the given bytes of the file
+     * @return NULL on error
+     */
+    SpillRegion* map(size_t offset, size_t bytes);
+
+    /**
+     * @return bytes written to the file so far
+     */
+    size_t get_bytes(void) const { return _size; }
+
+    const std::string & get_filename(void) const { return _filename; }
+
+    /**
+     * @brief total bytes in all spill files of this process
+     */
+    static size_t get_bytes_total(void);
+
+private:
+    friend class SpillRegion;
+    SpillFile(QFile * file, size_t size);
+    ~SpillFile();
+    SpillFile(const SpillFile&);
+    SpillFile& operator=(const SpillFile&);
+
+    void _unmap(const char * addr);
+
+    /****************************************
+     *     DATA MEMBERS
+     ****************************************/
+    QFile*          _file;        ///< a QTemporaryFile, if we created it
+    std::string     _filename;
+    size_t          _size;        ///< bytes written
+    size_t          _region_start;
+    QMutex          _mutex;       ///< guards all of the above
+    QAtomicInt      _ref;
+};
+
+/**
+ * @brief a read-only mapped piece of a SpillFile. Shared by copies of the data living
+ * in there; unmapped when the last one lets go.
+ */
+class SpillRegion
+{
+public:
+    SpillRegion* ref(void) { _ref.ref(); return this; }
+    void unref(void) { if (!_ref.deref()) delete this; }
+
+    const char* data(void) const { return _addr; }
+    size_t size(void) const { return _bytes; }
+
+private:
+    friend class SpillFile;
+    SpillRegion(SpillFile * file, const char * addr, size_t bytes) : _file(file->ref()), _addr(addr), _bytes(bytes), _ref(1) {}
+    ~SpillRegion() { _file->_unmap(_addr); _file->unref(); }
+    SpillRegion(const SpillRegion&);
+    SpillRegion& operator=(const SpillRegion&);
+
+    /****************************************
+     *     DATA MEMBERS
+     ****************************************/
+    SpillFile*  _file;
+    const char* _addr;
+    size_t      _bytes;
+    QAtomicInt  _ref;
+};
+
+#endif // SPILLFILE_H
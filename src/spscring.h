@@ -0,0 +1,185 @@
+/**
+ * @file spscring.h
+ * @brief Bounded lock-free ring buffer for exactly one producer and one consumer thread.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <vector>
+#include <QAtomicInt>
+#include <QThread>
+
+/**
+ * @brief Ring of preallocated slots. The producer writes into a slot in place and then
+ * publishes it, the consumer reads it in place and then releases it. Since slots are
+ * never destroyed, objects keep their memory from one round to the next.
+ *
+ * Producer: T*p = wait_push(); ...fill *p...; end_push(); ... close();
+ * Consumer: while ((p = wait_pop())) { ...use *p...; end_pop(); }
+ *
+ * Each side caches the other side's index and only re-reads it when the ring looks
+ * full (or empty), so in steady state an item costs one atomic store.
+ */
+template <typename T>
+class SpscRing
+{
+public:
+    /**
+     * @param capacity number of slots. Rounded up to a power of two.
+     */
+    SpscRing(unsigned int capacity) : _head(0), _tail(0), _closed(0),
+        _head_cache(0), _tail_seen(0), _tail_cache(0), _head_seen(0)
+    {
+        unsigned int n = 2;
+        while (n < capacity) n <<= 1;
+        _slots.resize(n);
+        _mask = n - 1;
+    }
+
+    /****************************************
+     *     PRODUCER SIDE
+     ****************************************/
+
+    /**
+     * @return next free slot, or NULL if ring is full
+     */
+    T* begin_push(void) {
+        if (_head_cache - _tail_seen > _mask) {
+            _tail_seen = (unsigned int) _load_acquire(_tail);
+            if (_head_cache - _tail_seen > _mask) return NULL;
+        }
+        return &_slots[_head_cache & _mask];
+    }
+
+    /**
+     * @brief blocks until a slot is free
+     */
+    T* wait_push(void) {
+        T* p;
+        while ((p = begin_push()) == NULL) {
+            QThread::yieldCurrentThread();
+        }
+        return p;
+    }
+
+    /**
+     * @brief hand the slot from begin_push()/wait_push() over to the consumer
+     */
+    void end_push(void) {
+        _head_cache++;
+        _store_release(_head, (int) _head_cache);
+    }
+
+    /**
+     * @brief no more items will follow
+     */
+    void close(void) {
+        _store_release(_closed, 1);
+    }
+
+    /****************************************
+     *     CONSUMER SIDE
+     ****************************************/
+
+    /**
+     * @return oldest published slot, or NULL if ring is empty
+     */
+    T* begin_pop(void) {
+        if (_tail_cache == _head_seen) {
+            _head_seen = (unsigned int) _load_acquire(_head);
+            if (_tail_cache == _head_seen) return NULL;
+        }
+        return &_slots[_tail_cache & _mask];
+    }
+
+    /**
+     * @brief blocks until a slot is published
+     * @return the slot, or NULL if the producer has closed the ring and all items were consumed
+     */
+    T* wait_pop(void) {
+        T* p;
+        while ((p = begin_pop()) == NULL) {
+            if (_load_acquire(_closed)) {
+                // producer might have published right before closing
+                return begin_pop();
+            }
+            QThread::yieldCurrentThread();
+        }
+        return p;
+    }
+
+    /**
+     * @brief give the slot from begin_pop()/wait_pop() back to the producer
+     */
+    void end_pop(void) {
+        _tail_cache++;
+        _store_release(_tail, (int) _tail_cache);
+    }
+
+    unsigned int capacity(void) const { return _mask + 1; }
+
+private:
+    static int _load_acquire(QAtomicInt & a) {
+#if (QT_VERSION >= QT_VERSION_CHECK(5,0,0))
+        return a.loadAcquire();
+#else
+        return a.fetchAndAddAcquire(0);
+#endif
+    }
+
+    static void _store_release(QAtomicInt & a, int v) {
+#if (QT_VERSION >= QT_VERSION_CHECK(5,0,0))
+        a.storeRelease(v);
+#else
+        a.fetchAndStoreRelease(v);
+#endif
+    }
+
+    // forbid copies
+    SpscRing(const SpscRing&);
+    SpscRing& operator=(const SpscRing&);
+
+    /****************************************
+     *     DATA MEMBERS
+     ****************************************/
+    std::vector<T> _slots;
+    unsigned int   _mask;
+
+    // shared. Indices count up forever and wrap around; only their difference matters.
+    QAtomicInt     _head; ///< written by producer: number of pushed items
+    char           _pad1[64];
+    QAtomicInt     _tail; ///< written by consumer: number of popped items
+    char           _pad2[64];
+    QAtomicInt     _closed;
+
+    // producer only
+    char           _pad3[64];
+    unsigned int   _head_cache;
+    unsigned int   _tail_seen;
+
+    // consumer only
+    char           _pad4[64];
+    unsigned int   _tail_cache;
+    unsigned int   _head_seen;
+};
+
+#endif // SPSCRING_H
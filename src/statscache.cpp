@@ -0,0 +1,70 @@
+/**
+ * @file statscache.cpp
+ * @brief Statistics of time windows, shared by everything which shows them.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+
+#include <QMutexLocker>
+#include "statscache.h"
+
+#define STATS_CACHE_MAX 4096 ///< remembered windows over all data; then it starts over
+
+StatsCache::cache_key_t StatsCache::_key(const Data*d, double tmin, double tmax) {
+    cache_key_t k;
+    k.id = d->get_id();
+    k.tmin = tmin;
+    k.tmax = tmax;
+    return k;
+}
+
+bool StatsCache::lookup(const Data*d, double tmin, double tmax, bool & ok, Data::data_stats & s) {
+    if (!d) return false;
+    QMutexLocker lock(&_mutex);
+    std::map<cache_key_t, cache_entry_t>::const_iterator it = _entries.find(_key(d, tmin, tmax));
+    if (it == _entries.end()) return false;
+    if (it->second.revision != d->get_revision() || it->second.n != d->size()) return false;
+    ok = it->second.ok;
+    s = it->second.stats;
+    return true;
+}
+
+bool StatsCache::get_stats_timewindow(const Data*d, double tmin, double tmax, Data::data_stats & s) {
+    if (!d) return false;
+    bool ok;
+    if (lookup(d, tmin, tmax, ok, s)) return ok;
+
+    // outside the lock: this is what takes long, and others may compute meanwhile
+    cache_entry_t e;
+    e.revision = d->get_revision();
+    e.n = d->size();
+    e.ok = d->get_stats_timewindow(tmin, tmax, e.stats);
+    s = e.stats;
+
+    QMutexLocker lock(&_mutex);
+    if (_entries.size() >= STATS_CACHE_MAX) _entries.clear();
+    _entries[_key(d, tmin, tmax)] = e;
+    return e.ok;
+}
+
+void StatsCache::clear(void) {
+    QMutexLocker lock(&_mutex);
+    _entries.clear();
+}
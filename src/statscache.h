@@ -0,0 +1,93 @@
+/**
+ * @file statscache.h
+ * @brief Statistics of time windows, shared by everything which shows them.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+
+#ifndef STATSCACHE_H
+#define STATSCACHE_H
+
+#include <map>
+#include <QMutex>
+#include "data.h"
+
+/**
+ * @brief Statistics of data in a time window (Data::get_stats_timewindow()), remembered
+ * for all views: the statistics dialog, and the main window deciding which details to
+ * load. Entries are by Data::get_id(), and are stale once the data got other samples
+ * (Data::get_revision(), or its size). Thread-safe.
+ */
+class StatsCache
+{
+public:
+    static StatsCache& Instance(void) {
+        static StatsCache instance;
+        return instance;
+    }
+
+    /**
+     * @brief from the cache, or computed and remembered
+     * @param tmin window in absolute time, as for Data::get_stats_timewindow()
+     * @return what Data::get_stats_timewindow() says
+     */
+    bool get_stats_timewindow(const Data*d, double tmin, double tmax, Data::data_stats & s);
+
+    /**
+     * @brief only from the cache
+     * @param ok what Data::get_stats_timewindow() said
+     * @return false if not there, or stale
+     */
+    bool lookup(const Data*d, double tmin, double tmax, bool & ok, Data::data_stats & s);
+
+    void clear(void);
+
+private:
+    StatsCache() {}
+    StatsCache(const StatsCache &);
+    StatsCache & operator=(const StatsCache &);
+
+    typedef struct cache_key_s {
+        unsigned int id;
+        double       tmin, tmax;
+        bool operator<(const cache_key_s & o) const {
+            if (id != o.id) return id < o.id;
+            if (tmin != o.tmin) return tmin < o.tmin;
+            return tmax < o.tmax;
+        }
+    } cache_key_t;
+
+    typedef struct {
+        unsigned int     revision;
+        unsigned int     n; ///< samples then; data may grow by loading
+        bool             ok;
+        Data::data_stats stats;
+    } cache_entry_t;
+
+    static cache_key_t _key(const Data*d, double tmin, double tmax);
+
+    /****************************************
+     *   DATA MEMBERS
+     ****************************************/
+    QMutex                   _mutex;
+    std::map<cache_key_t, cache_entry_t> _entries;
+};
+
+#endif // STATSCACHE_H
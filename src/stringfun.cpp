@@ -24,6 +24,9 @@
 #include <sstream>
 #include <algorithm>
 #include <functional>
+#include <cmath>
+#include <cstring>
+#include <limits>
 #include "stringfun.h"
 
 using namespace std;
@@ -75,3 +78,121 @@ void string_oneline(std::string &str) {
         str.erase ( str.find ("\n"), 2 );
     }
 }
+
+static inline bool _isblank(char c) {
+    return (c == ' ' || c == '\t' || c == '\r' || c == '\n');
+}
+
+static inline bool _isdigit(char c) {
+    return (c >= '0' && c <= '9');
+}
+
+bool string_to_int64(const char*p, unsigned int len, int64_t &val) {
+    const char*end = p + len;
+    val = 0;
+    while (p < end && _isblank(*p)) p++;
+    bool neg = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        neg = (*p == '-');
+        p++;
+    }
+    if (p >= end || !_isdigit(*p)) return false;
+    uint64_t v = 0;
+    while (p < end && _isdigit(*p)) {
+        v = v*10 + (*p - '0');
+        p++;
+    }
+    val = neg ? -((int64_t)v) : (int64_t)v;
+    return true;
+}
+
+// powers of ten which are exactly representable as double
+static const double _pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static bool _prefix_nocase(const char*p, const char*end, const char*word) {
+    const unsigned int n = strlen(word);
+    if ((unsigned int)(end - p) < n) return false;
+    for (unsigned int k=0; k<n; k++) {
+        if ((p[k] | 0x20) != word[k]) return false;
+    }
+    return true;
+}
+
+bool string_to_double(const char*p, unsigned int len, double &val) {
+    const char*end = p + len;
+    val = 0.;
+    while (p < end && _isblank(*p)) p++;
+    bool neg = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        neg = (*p == '-');
+        p++;
+    }
+    if (_prefix_nocase(p, end, "nan")) {
+        val = std::numeric_limits<double>::quiet_NaN();
+        return true;
+    }
+    if (_prefix_nocase(p, end, "inf")) {
+        val = neg ? -std::numeric_limits<double>::infinity() : std::numeric_limits<double>::infinity();
+        return true;
+    }
+
+    // mantissa: keep up to 18 significant digits, that is more than a double holds
+    uint64_t mant = 0;
+    int exp10 = 0;
+    bool any = false;
+    while (p < end && _isdigit(*p)) {
+        if (mant < 100000000000000000ULL) {
+            mant = mant*10 + (*p - '0');
+        } else {
+            exp10++;
+        }
+        any = true;
+        p++;
+    }
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && _isdigit(*p)) {
+            if (mant < 100000000000000000ULL) {
+                mant = mant*10 + (*p - '0');
+                exp10--;
+            }
+            any = true;
+            p++;
+        }
+    }
+    if (!any) return false;
+
+    // exponent
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char*q = p + 1;
+        bool eneg = false;
+        if (q < end && (*q == '-' || *q == '+')) {
+            eneg = (*q == '-');
+            q++;
+        }
+        if (q < end && _isdigit(*q)) {
+            int e = 0;
+            while (q < end && _isdigit(*q)) {
+                if (e < 10000) e = e*10 + (*q - '0');
+                q++;
+            }
+            exp10 += eneg ? -e : e;
+        }
+    }
+
+    double v = (double)mant;
+    if (0 == mant) {
+        // nothing to scale
+    } else if (exp10 >= 0 && exp10 <= 22) {
+        v *= _pow10[exp10];
+    } else if (exp10 < 0 && exp10 >= -22) {
+        v /= _pow10[-exp10];
+    } else {
+        v *= pow(10., exp10);
+    }
+    val = neg ? -v : v;
+    return true;
+}
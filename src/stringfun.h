@@ -28,6 +28,7 @@
 #include <string>
 #include <sstream>
 #include <set>
+#include <inttypes.h>
 
 // trim from start
 std::string &string_ltrim(std::string &s, bool linebreak=false);
@@ -44,6 +45,12 @@ std::vector<std::string> & string_split(const std::string &s, char delim, std::v
 // remove all newlines
 void string_oneline(std::string &buf);
 
+// locale-free atoll() on a non-terminated buffer. Leading blanks skipped, stops at first non-digit.
+bool string_to_int64(const char*p, unsigned int len, int64_t &val);
+
+// locale-free atof() on a non-terminated buffer. Understands [+-]digits[.digits][e[+-]digits], nan, inf.
+bool string_to_double(const char*p, unsigned int len, double &val);
+
 // generic ", ".join(std::set< >)
 template <typename T>
 std::string set2str(std::set<T> s) {
@@ -0,0 +1,237 @@
+/**
+ * @file taskpool.cpp
+ * @brief One pool of worker threads for all parallel work, and groups of tasks in it.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <deque>
+#include <QThreadPool>
+#include <QThread>
+#include <QThreadStorage>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include "taskpool.h"
+
+/**
+ * @brief everything of a TaskGroup the runners touch. Freed by whoever lets go last.
+ */
+typedef struct taskgroup_state_s {
+    QMutex                  mutex;
+    QWaitCondition          changed;     ///< a task finished, or a runner quit
+    std::deque<QRunnable*>  pending;     ///< not started yet, in order
+    unsigned int            max_running; ///< runners at most
+    unsigned int            runners;     ///< in the pool, started or not
+    unsigned int            running;     ///< tasks being run by anyone
+    unsigned int            done;
+    unsigned int            total;
+    bool                    canceled;
+    unsigned int            refs;        ///< the group and each runner
+} taskgroup_state_t;
+
+static QThreadStorage<char*> g_worker; ///< set in the threads of the pool
+
+/**
+ * @brief drops a reference
+ * @return true if it was the last one, then the caller deletes the state after unlocking
+ */
+static bool _release(taskgroup_state_t*s) {
+    s->refs--;
+    return (0 == s->refs);
+}
+
+/**
+ * @brief runs the tasks of one group in a worker, one after the other, until the group
+ * has no more. The group may be gone by then.
+ */
+class TaskRunner : public QRunnable {
+public:
+    TaskRunner(taskgroup_state_t*s) : _s(s) {}
+
+    void run() {
+        if (!g_worker.hasLocalData()) g_worker.setLocalData(new char(1));
+        for (;;) {
+            QRunnable*task = NULL;
+            bool last = false;
+            {
+                QMutexLocker lock(&_s->mutex);
+                if (_s->pending.empty() || _s->canceled) {
+                    _s->runners--;
+                    last = _release(_s);
+                    _s->changed.wakeAll();
+                } else {
+                    task = _s->pending.front();
+                    _s->pending.pop_front();
+                    _s->running++;
+                }
+            }
+            if (!task) {
+                if (last) delete _s;
+                return;
+            }
+            const bool del = task->autoDelete(); // the owner may delete it as soon as it is done
+            task->run();
+            if (del) delete task;
+            QMutexLocker lock(&_s->mutex);
+            _s->running--;
+            _s->done++;
+            _s->changed.wakeAll();
+        }
+    }
+
+private:
+    taskgroup_state_t*const _s;
+};
+
+QThreadPool * TaskPool::_pool(void) {
+    return QThreadPool::globalInstance();
+}
+
+void TaskPool::set_max_threads(unsigned int n) {
+    if (n < 1) n = QThread::idealThreadCount();
+    if (n < 1) n = 1;
+    _pool()->setMaxThreadCount(n);
+    // workers stay: they keep their pooled DB connection, see DBConnector
+    _pool()->setExpiryTimeout(-1);
+}
+
+unsigned int TaskPool::get_max_threads(void) {
+    const int n = _pool()->maxThreadCount();
+    return (n < 1) ? 1 : n;
+}
+
+bool TaskPool::in_worker(void) {
+    return g_worker.hasLocalData();
+}
+
+TaskGroup::TaskGroup(unsigned int max_running) : _state(new taskgroup_state_t) {
+    _state->max_running = max_running;
+    _state->runners = 0;
+    _state->running = 0;
+    _state->done = 0;
+    _state->total = 0;
+    _state->canceled = false;
+    _state->refs = 1;
+}
+
+TaskGroup::~TaskGroup() {
+    wait();
+    bool last;
+    {
+        QMutexLocker lock(&_state->mutex);
+        last = _release(_state);
+    }
+    if (last) delete _state;
+}
+
+void TaskGroup::start(QRunnable * task) {
+    if (!task) return;
+    bool more_runners = false;
+    {
+        QMutexLocker lock(&_state->mutex);
+        if (!_state->canceled) {
+            _state->pending.push_back(task);
+            _state->total++;
+            const unsigned int limit = _state->max_running > 0 ? _state->max_running : TaskPool::get_max_threads();
+            if (_state->runners < limit && _state->runners < _state->pending.size() + _state->running) {
+                _state->runners++;
+                _state->refs++;
+                more_runners = true;
+            }
+            task = NULL;
+        }
+    }
+    if (task) {
+        // canceled
+        if (task->autoDelete()) delete task;
+        return;
+    }
+    if (more_runners) {
+        TaskRunner*r = new TaskRunner(_state);
+        r->setAutoDelete(true);
+        TaskPool::_pool()->start(r);
+    }
+}
+
+bool TaskGroup::_run_one(void) {
+    QRunnable*task;
+    {
+        QMutexLocker lock(&_state->mutex);
+        if (_state->pending.empty() || _state->canceled) return false;
+        if (_state->max_running > 0 && _state->running >= _state->max_running) return false;
+        task = _state->pending.front();
+        _state->pending.pop_front();
+        _state->running++;
+    }
+    const bool del = task->autoDelete();
+    task->run();
+    if (del) delete task;
+    QMutexLocker lock(&_state->mutex);
+    _state->running--;
+    _state->done++;
+    _state->changed.wakeAll();
+    return true;
+}
+
+bool TaskGroup::wait(int msecs) {
+    // a worker must not only block here: the tasks might be queued behind itself
+    const bool help = (msecs < 0) || TaskPool::in_worker();
+    for (;;) {
+        if (help) {
+            while (_run_one()) {}
+        }
+        QMutexLocker lock(&_state->mutex);
+        if (0 == _state->running && (_state->pending.empty() || _state->canceled)) return true;
+        if (msecs < 0) {
+            _state->changed.wait(&_state->mutex);
+        } else if (!_state->changed.wait(&_state->mutex, (unsigned long)msecs)) {
+            return false;
+        }
+    }
+}
+
+void TaskGroup::cancel(void) {
+    std::deque<QRunnable*> dropped;
+    {
+        QMutexLocker lock(&_state->mutex);
+        _state->canceled = true;
+        dropped.swap(_state->pending);
+        _state->total -= dropped.size();
+        _state->changed.wakeAll();
+    }
+    for (std::deque<QRunnable*>::iterator it = dropped.begin(); it != dropped.end(); ++it) {
+        if ((*it)->autoDelete()) delete *it;
+    }
+}
+
+bool TaskGroup::is_canceled(void) const {
+    QMutexLocker lock(&_state->mutex);
+    return _state->canceled;
+}
+
+unsigned int TaskGroup::get_done(void) const {
+    QMutexLocker lock(&_state->mutex);
+    return _state->done;
+}
+
+unsigned int TaskGroup::get_total(void) const {
+    QMutexLocker lock(&_state->mutex);
+    return _state->total;
+}
@@ -0,0 +1,149 @@
+/**
+ * @file taskpool.h
+ * @brief One pool of worker threads for all parallel work, and groups of tasks in it.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef TASKPOOL_H
+#define TASKPOOL_H
+
+#include <QRunnable>
+
+class QThreadPool;
+struct taskgroup_state_s;
+
+/**
+ * @brief The worker threads, shared by everything that runs in parallel (import, postprocessing,
+ * statistics, export, DB save, ...). Work is handed to it through a TaskGroup. Jobs which run
+ * at the same time therefore share the cores, instead of each one starting a thread per core.
+ */
+class TaskPool
+{
+public:
+    /**
+     * @brief how many workers there are at most
+     * @param n 0=one per core
+     */
+    static void set_max_threads(unsigned int n);
+    static unsigned int get_max_threads(void);
+
+    /**
+     * @brief whether the calling thread is one of the workers
+     */
+    static bool in_worker(void);
+
+private:
+    static QThreadPool * _pool(void);
+
+    friend class TaskGroup;
+};
+
+/**
+ * @brief Tasks which belong together, e.g., one per file or one per column:
+ *
+ *   TaskGroup g;
+ *   for (...) g.start(new SomeJob(...));
+ *   g.wait();
+ *
+ * Like QThreadPool::start(), a task is deleted after it ran if its autoDelete() is set.
+ * A thread waiting for its group does not block but runs the tasks of the group which have
+ * not started yet. Groups can therefore be nested: a task may make a group of its own and
+ * wait for it, even when all workers are busy, and this does not add threads.
+ */
+class TaskGroup
+{
+public:
+    /**
+     * @param max_running tasks of this group running at the same time, e.g., because each
+     *        needs a DB connection. 1 runs them in order. 0=as many as there are workers
+     */
+    explicit TaskGroup(unsigned int max_running = 0);
+
+    /**
+     * @brief waits for the tasks of the group
+     */
+    ~TaskGroup();
+
+    /**
+     * @brief queue a task. After cancel() it is dropped instead.
+     */
+    void start(QRunnable * task);
+
+    /**
+     * @brief wait until all tasks are done
+     * @param msecs <0: forever, and run tasks in the calling thread meanwhile. Otherwise only
+     *        wait, so that the caller can report progress (e.g., get_done() on a DialogProgressBar)
+     *        and cancel(); except in a worker, which always helps.
+     * @return true if all are done, false on timeout
+     */
+    bool wait(int msecs = -1);
+
+    /**
+     * @brief tasks which have not started yet are dropped, and so are tasks started later.
+     * Running ones finish; long tasks can poll is_canceled().
+     */
+    void cancel(void);
+    bool is_canceled(void) const;
+
+    /**
+     * @brief tasks done, and tasks started in total, except dropped ones
+     */
+    unsigned int get_done(void) const;
+    unsigned int get_total(void) const;
+
+private:
+    TaskGroup(const TaskGroup &);
+    TaskGroup & operator=(const TaskGroup &);
+
+    /**
+     * @brief run the next task not started, in the calling thread
+     * @return false if there is none, or max_running are running already
+     */
+    bool _run_one(void);
+
+    /****************************************
+     *   DATA MEMBERS
+     ****************************************/
+    struct taskgroup_state_s * _state; ///< shared with the runners in the pool, which may outlive this
+};
+
+/**
+ * @brief a task which only deletes an object, so that freeing something huge, e.g., a scenario
+ * with all its data, does not block the caller:
+ *
+ *   group.start(new DeleteTask<MavlinkScenario>(scen));
+ */
+template <class T>
+class DeleteTask : public QRunnable
+{
+public:
+    explicit DeleteTask(T*obj) : _obj(obj) {}
+    ~DeleteTask() { delete _obj; } ///< also if the group was canceled
+
+    void run() {
+        delete _obj;
+        _obj = NULL;
+    }
+
+private:
+    T*_obj;
+};
+
+#endif // TASKPOOL_H
@@ -440,8 +440,13 @@ double get_time_secs(void) {
 
 struct tm epoch_to_tm(double epoch_sec) {
     time_t epoch_sec_t = (time_t) round(epoch_sec);
+    struct tm ret;
+#if defined(WIN32) || defined(__WIN32) || defined(__WIN32__)
     struct tm * ltime = localtime(&epoch_sec_t);///< not thread safe
-    struct tm ret  = *ltime; // deep copy
+    ret  = *ltime; // deep copy
+#else
+    localtime_r(&epoch_sec_t, &ret);
+#endif
     return ret;
 }
 
@@ -513,7 +518,12 @@ string seconds_to_timestr (double sec, bool decimals) {
     double integral;
     double msec = modf(sec,&integral); // split into decimal and integral part
     time_t seconds((time_t) integral);
+#if defined(WIN32) || defined(__WIN32) || defined(__WIN32__)
     tm *p = gmtime(&seconds);
+#else
+    tm tmbuf;
+    tm *p = gmtime_r(&seconds, &tmbuf);
+#endif
 
     stringstream ss;
     ss.precision(3);    
@@ -0,0 +1,96 @@
+/**
+ * @file topicfilter.cpp
+ * @brief Selection of topics (message types) and fields that shall be imported from a log.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include "topicfilter.h"
+#include "stringfun.h"
+
+using namespace std;
+
+bool TopicFilter::parse(const std::string & spec) {
+    vector<string> items;
+    string_split(spec, ',', items);
+
+    vector<entry_t> entries;
+    for (vector<string>::iterator it = items.begin(); it != items.end(); ++it) {
+        string item = *it;
+        string_trim(item);
+        if (item.empty()) continue;
+
+        entry_t e;
+        const size_t dot = item.find('.');
+        if (dot == string::npos) {
+            e.topic = item;
+        } else {
+            e.topic = item.substr(0, dot);
+            e.field = item.substr(dot + 1);
+            if (e.field.empty()) return false;
+        }
+        if (e.topic.empty()) return false;
+        entries.push_back(e);
+    }
+
+    _entries = entries;
+    _spec = spec;
+    return true;
+}
+
+bool TopicFilter::_match(const std::string & pattern, const std::string & name) {
+    if (!pattern.empty() && pattern[pattern.size()-1] == '*') {
+        const size_t n = pattern.size() - 1;
+        return name.compare(0, n, pattern, 0, n) == 0;
+    }
+    return pattern == name;
+}
+
+/**
+ * @brief MavSystem/MavlinkScenario build the time base from these
+ */
+bool TopicFilter::_is_always_kept(const std::string & topic) {
+    return topic == "GPS" || topic == "vehicle_gps_position" || topic == "TIME" || topic == "PARM" ||
+           topic == "HEARTBEAT" || topic == "SYSTEM_TIME" || topic == "GPS_RAW_INT";
+}
+
+bool TopicFilter::_is_timestamp(const std::string & field) {
+    return field == "TimeUS" || field == "TimeMS" || field == "t" || field == "timestamp";
+}
+
+bool TopicFilter::accepts_topic(const std::string & topic) const {
+    if (_entries.empty()) return true;
+    if (_is_always_kept(topic)) return true;
+    for (vector<entry_t>::const_iterator it = _entries.begin(); it != _entries.end(); ++it) {
+        if (_match(it->topic, topic)) return true;
+    }
+    return false;
+}
+
+bool TopicFilter::accepts_field(const std::string & topic, const std::string & field) const {
+    if (_entries.empty()) return true;
+    if (_is_always_kept(topic)) return true;
+    bool topic_seen = false;
+    for (vector<entry_t>::const_iterator it = _entries.begin(); it != _entries.end(); ++it) {
+        if (!_match(it->topic, topic)) continue;
+        topic_seen = true;
+        if (it->field.empty() || _match(it->field, field)) return true;
+    }
+    return topic_seen && _is_timestamp(field);
+}
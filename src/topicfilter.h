@@ -0,0 +1,87 @@
+/**
+ * @file topicfilter.h
+ * @brief Selection of topics (message types) and fields that shall be imported from a log.
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef TOPICFILTER_H
+#define TOPICFILTER_H
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Parsers ask this whether a message type is needed at all, so that unselected
+ * messages can be skipped without decoding them. Names are those in the log, e.g.,
+ * "ATT", "vehicle_attitude" or "RAW_IMU", not the readable names.
+ *
+ * Spec: comma-separated list of "topic" (all fields) or "topic.field". A trailing '*'
+ * matches any suffix, e.g. "vehicle_*" or "ATT.Des*". An empty spec selects everything.
+ *
+ * Messages which the time reconstruction depends on (GPS, TIME, PARM and the MavLink
+ * HEARTBEAT, SYSTEM_TIME, GPS_RAW_INT) are always selected entirely, as are the time
+ * stamp fields of any selected topic.
+ */
+class TopicFilter
+{
+public:
+    TopicFilter() {}
+
+    /**
+     * @brief replace current selection
+     * @return false if spec is malformed. Selection is then unchanged.
+     */
+    bool parse(const std::string & spec);
+
+    /**
+     * @return false if everything is selected
+     */
+    bool is_active(void) const { return !_entries.empty(); }
+
+    /**
+     * @return true if at least one field of this topic is selected
+     */
+    bool accepts_topic(const std::string & topic) const;
+
+    /**
+     * @return true if this field of this topic is selected
+     */
+    bool accepts_field(const std::string & topic, const std::string & field) const;
+
+    /**
+     * @return the spec this was made from
+     */
+    const std::string & get_spec(void) const { return _spec; }
+
+private:
+    typedef struct entry_s {
+        std::string topic;
+        std::string field; ///< empty=all
+    } entry_t;
+
+    static bool _match(const std::string & pattern, const std::string & name);
+    static bool _is_always_kept(const std::string & topic);
+    static bool _is_timestamp(const std::string & field);
+
+    std::string          _spec;
+    std::vector<entry_t> _entries;
+};
+
+#endif // TOPICFILTER_H
@@ -20,3 +20,41 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
     
  */
+
+#include <new>
+#include "treeitem.h"
+#include "arena.h"
+
+/*
+ * Every item is preceded by a header which tells where it lives. The header is one
+ * alignment unit, so that the item itself is aligned as well.
+ */
+namespace {
+    union item_header {
+        Arena* arena; ///< NULL=heap
+        char   pad[Arena::ALIGN];
+    };
+}
+
+void* TreeItem::operator new(size_t size) {
+    item_header*const h = static_cast<item_header*>(::operator new(sizeof(item_header) + size));
+    h->arena = NULL;
+    return h + 1;
+}
+
+void* TreeItem::operator new(size_t size, Arena & arena) {
+    item_header*const h = static_cast<item_header*>(arena.alloc(sizeof(item_header) + size));
+    h->arena = &arena;
+    return h + 1;
+}
+
+void TreeItem::operator delete(void*p) {
+    if (!p) return;
+    item_header*const h = static_cast<item_header*>(p) - 1;
+    if (!h->arena) ::operator delete(h);
+    // else: freed with the arena
+}
+
+void TreeItem::operator delete(void*, Arena &) {
+    // freed with the arena
+}
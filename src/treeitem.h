@@ -24,10 +24,24 @@
 #ifndef TREEITEM_H
 #define TREEITEM_H
 
+#include <stddef.h>
+
+class Arena;
+
 class TreeItem {
 public:        
     virtual ~TreeItem() {} ///< this class is the polymorphic base class, therefore it needs a virtual DTOR
 
+    /**
+     * @brief items live on the heap, or with `new (arena) T(...)` in an Arena. Either
+     * way, `delete` works: it runs the destructor, and heap memory is freed right away,
+     * arena memory with the arena.
+     */
+    static void* operator new(size_t size);
+    static void* operator new(size_t size, Arena & arena);
+    static void operator delete(void*p);
+    static void operator delete(void*p, Arena & arena); ///< only used if a CTOR throws
+
     enum {GROUP, DATA} itemtype;    ///< set in CTOR, which one the implementing class is
 };
 
@@ -0,0 +1,298 @@
+/**
+ * @file vec_fun.cpp
+ * @brief vectorized kernels for reductions and conversions over sample arrays
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include "vec_fun.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define VEC_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VEC_SSE2
+#endif
+
+/*
+ * All kernels: vector loop over the largest multiple of the vector width, then
+ * the scalar template from the header for the rest. Unaligned loads throughout,
+ * std::vector gives no alignment guarantee. Min/max take the new value as the first
+ * operand, so that a NaN sample is ignored like in the scalar code.
+ */
+
+#if defined(VEC_AVX2)
+
+static inline double hsum(__m256d v) {
+    __m128d lo = _mm256_castpd256_pd128(v);
+    __m128d hi = _mm256_extractf128_pd(v, 1);
+    lo = _mm_add_pd(lo, hi);
+    return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+}
+
+double vec_sum(const float*in, size_t n) {
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        const __m256 x = _mm256_loadu_ps(in + k);
+        acc0 = _mm256_add_pd(acc0, _mm256_cvtps_pd(_mm256_castps256_ps128(x)));
+        acc1 = _mm256_add_pd(acc1, _mm256_cvtps_pd(_mm256_extractf128_ps(x, 1)));
+    }
+    return hsum(_mm256_add_pd(acc0, acc1)) + vec_sum<float>(in + k, n - k);
+}
+
+double vec_sum(const double*in, size_t n) {
+    __m256d acc = _mm256_setzero_pd();
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        acc = _mm256_add_pd(acc, _mm256_loadu_pd(in + k));
+    }
+    return hsum(acc) + vec_sum<double>(in + k, n - k);
+}
+
+double vec_sumsq(const float*in, size_t n, double shift) {
+    const __m256d s = _mm256_set1_pd(shift);
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        const __m256 x = _mm256_loadu_ps(in + k);
+        const __m256d a = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(x)), s);
+        const __m256d b = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(x, 1)), s);
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(a, a));
+        acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(b, b));
+    }
+    return hsum(_mm256_add_pd(acc0, acc1)) + vec_sumsq<float>(in + k, n - k, shift);
+}
+
+double vec_sumsq(const double*in, size_t n, double shift) {
+    const __m256d s = _mm256_set1_pd(shift);
+    __m256d acc = _mm256_setzero_pd();
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        const __m256d a = _mm256_sub_pd(_mm256_loadu_pd(in + k), s);
+        acc = _mm256_add_pd(acc, _mm256_mul_pd(a, a));
+    }
+    return hsum(acc) + vec_sumsq<double>(in + k, n - k, shift);
+}
+
+void vec_minmax(const float*in, size_t n, float & mn, float & mx) {
+    if (n == 0) return;
+    __m256 vmn = _mm256_set1_ps(in[0]), vmx = vmn;
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        const __m256 x = _mm256_loadu_ps(in + k);
+        vmn = _mm256_min_ps(x, vmn);
+        vmx = _mm256_max_ps(x, vmx);
+    }
+    float bmn[8], bmx[8];
+    _mm256_storeu_ps(bmn, vmn);
+    _mm256_storeu_ps(bmx, vmx);
+    mn = in[0]; mx = in[0];
+    for (int j = 0; j < 8; ++j) {
+        if (bmn[j] < mn) mn = bmn[j];
+        if (bmx[j] > mx) mx = bmx[j];
+    }
+    for (; k < n; ++k) {
+        if (in[k] < mn) mn = in[k];
+        if (in[k] > mx) mx = in[k];
+    }
+}
+
+void vec_minmax(const double*in, size_t n, double & mn, double & mx) {
+    if (n == 0) return;
+    __m256d vmn = _mm256_set1_pd(in[0]), vmx = vmn;
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        const __m256d x = _mm256_loadu_pd(in + k);
+        vmn = _mm256_min_pd(x, vmn);
+        vmx = _mm256_max_pd(x, vmx);
+    }
+    double bmn[4], bmx[4];
+    _mm256_storeu_pd(bmn, vmn);
+    _mm256_storeu_pd(bmx, vmx);
+    mn = in[0]; mx = in[0];
+    for (int j = 0; j < 4; ++j) {
+        if (bmn[j] < mn) mn = bmn[j];
+        if (bmx[j] > mx) mx = bmx[j];
+    }
+    for (; k < n; ++k) {
+        if (in[k] < mn) mn = in[k];
+        if (in[k] > mx) mx = in[k];
+    }
+}
+
+void vec_to_double(const float*in, size_t n, double*out, double scale, double offset) {
+    const __m256d sc = _mm256_set1_pd(scale), of = _mm256_set1_pd(offset);
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        const __m256 x = _mm256_loadu_ps(in + k);
+        const __m256d a = _mm256_cvtps_pd(_mm256_castps256_ps128(x));
+        const __m256d b = _mm256_cvtps_pd(_mm256_extractf128_ps(x, 1));
+        _mm256_storeu_pd(out + k, _mm256_add_pd(_mm256_mul_pd(a, sc), of));
+        _mm256_storeu_pd(out + k + 4, _mm256_add_pd(_mm256_mul_pd(b, sc), of));
+    }
+    vec_to_double<float>(in + k, n - k, out + k, scale, offset);
+}
+
+void vec_to_double(const double*in, size_t n, double*out, double scale, double offset) {
+    const __m256d sc = _mm256_set1_pd(scale), of = _mm256_set1_pd(offset);
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        _mm256_storeu_pd(out + k, _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(in + k), sc), of));
+    }
+    vec_to_double<double>(in + k, n - k, out + k, scale, offset);
+}
+
+#elif defined(VEC_SSE2)
+
+static inline double hsum(__m128d v) {
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+double vec_sum(const float*in, size_t n) {
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        const __m128 x = _mm_loadu_ps(in + k);
+        acc0 = _mm_add_pd(acc0, _mm_cvtps_pd(x));
+        acc1 = _mm_add_pd(acc1, _mm_cvtps_pd(_mm_movehl_ps(x, x)));
+    }
+    return hsum(_mm_add_pd(acc0, acc1)) + vec_sum<float>(in + k, n - k);
+}
+
+double vec_sum(const double*in, size_t n) {
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        acc0 = _mm_add_pd(acc0, _mm_loadu_pd(in + k));
+        acc1 = _mm_add_pd(acc1, _mm_loadu_pd(in + k + 2));
+    }
+    return hsum(_mm_add_pd(acc0, acc1)) + vec_sum<double>(in + k, n - k);
+}
+
+double vec_sumsq(const float*in, size_t n, double shift) {
+    const __m128d s = _mm_set1_pd(shift);
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        const __m128 x = _mm_loadu_ps(in + k);
+        const __m128d a = _mm_sub_pd(_mm_cvtps_pd(x), s);
+        const __m128d b = _mm_sub_pd(_mm_cvtps_pd(_mm_movehl_ps(x, x)), s);
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(a, a));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(b, b));
+    }
+    return hsum(_mm_add_pd(acc0, acc1)) + vec_sumsq<float>(in + k, n - k, shift);
+}
+
+double vec_sumsq(const double*in, size_t n, double shift) {
+    const __m128d s = _mm_set1_pd(shift);
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        const __m128d a = _mm_sub_pd(_mm_loadu_pd(in + k), s);
+        const __m128d b = _mm_sub_pd(_mm_loadu_pd(in + k + 2), s);
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(a, a));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(b, b));
+    }
+    return hsum(_mm_add_pd(acc0, acc1)) + vec_sumsq<double>(in + k, n - k, shift);
+}
+
+void vec_minmax(const float*in, size_t n, float & mn, float & mx) {
+    if (n == 0) return;
+    __m128 vmn = _mm_set1_ps(in[0]), vmx = vmn;
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        const __m128 x = _mm_loadu_ps(in + k);
+        vmn = _mm_min_ps(x, vmn);
+        vmx = _mm_max_ps(x, vmx);
+    }
+    float bmn[4], bmx[4];
+    _mm_storeu_ps(bmn, vmn);
+    _mm_storeu_ps(bmx, vmx);
+    mn = in[0]; mx = in[0];
+    for (int j = 0; j < 4; ++j) {
+        if (bmn[j] < mn) mn = bmn[j];
+        if (bmx[j] > mx) mx = bmx[j];
+    }
+    for (; k < n; ++k) {
+        if (in[k] < mn) mn = in[k];
+        if (in[k] > mx) mx = in[k];
+    }
+}
+
+void vec_minmax(const double*in, size_t n, double & mn, double & mx) {
+    if (n == 0) return;
+    __m128d vmn = _mm_set1_pd(in[0]), vmx = vmn;
+    size_t k = 0;
+    for (; k + 2 <= n; k += 2) {
+        const __m128d x = _mm_loadu_pd(in + k);
+        vmn = _mm_min_pd(x, vmn);
+        vmx = _mm_max_pd(x, vmx);
+    }
+    double bmn[2], bmx[2];
+    _mm_storeu_pd(bmn, vmn);
+    _mm_storeu_pd(bmx, vmx);
+    mn = in[0]; mx = in[0];
+    for (int j = 0; j < 2; ++j) {
+        if (bmn[j] < mn) mn = bmn[j];
+        if (bmx[j] > mx) mx = bmx[j];
+    }
+    for (; k < n; ++k) {
+        if (in[k] < mn) mn = in[k];
+        if (in[k] > mx) mx = in[k];
+    }
+}
+
+void vec_to_double(const float*in, size_t n, double*out, double scale, double offset) {
+    const __m128d sc = _mm_set1_pd(scale), of = _mm_set1_pd(offset);
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        const __m128 x = _mm_loadu_ps(in + k);
+        _mm_storeu_pd(out + k, _mm_add_pd(_mm_mul_pd(_mm_cvtps_pd(x), sc), of));
+        _mm_storeu_pd(out + k + 2, _mm_add_pd(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(x, x)), sc), of));
+    }
+    vec_to_double<float>(in + k, n - k, out + k, scale, offset);
+}
+
+void vec_to_double(const double*in, size_t n, double*out, double scale, double offset) {
+    const __m128d sc = _mm_set1_pd(scale), of = _mm_set1_pd(offset);
+    size_t k = 0;
+    for (; k + 2 <= n; k += 2) {
+        _mm_storeu_pd(out + k, _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(in + k), sc), of));
+    }
+    vec_to_double<double>(in + k, n - k, out + k, scale, offset);
+}
+
+#else // scalar fallback
+
+double vec_sum(const float*in, size_t n) { return vec_sum<float>(in, n); }
+double vec_sum(const double*in, size_t n) { return vec_sum<double>(in, n); }
+double vec_sumsq(const float*in, size_t n, double shift) { return vec_sumsq<float>(in, n, shift); }
+double vec_sumsq(const double*in, size_t n, double shift) { return vec_sumsq<double>(in, n, shift); }
+void vec_minmax(const float*in, size_t n, float & mn, float & mx) { vec_minmax<float>(in, n, mn, mx); }
+void vec_minmax(const double*in, size_t n, double & mn, double & mx) { vec_minmax<double>(in, n, mn, mx); }
+void vec_to_double(const float*in, size_t n, double*out, double scale, double offset) {
+    vec_to_double<float>(in, n, out, scale, offset);
+}
+void vec_to_double(const double*in, size_t n, double*out, double scale, double offset) {
+    vec_to_double<double>(in, n, out, scale, offset);
+}
+
+#endif
@@ -0,0 +1,87 @@
+/**
+ * @file vec_fun.h
+ * @brief vectorized kernels for reductions and conversions over sample arrays
+ * @author Martin Becker <becker@rcs.ei.tum.de>
+ * @date 10/14/2026
+
+    This file is part of MavLogAnalyzer, Copyright 2026 by Martin Becker.
+
+    MavLogAnalyzer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef VEC_FUN_H
+#define VEC_FUN_H
+
+#include <stddef.h>
+
+/*
+ * float and double have SSE2 (and AVX2, if the compiler is told to use it, e.g. with
+ * -mavx2 or -march=native) implementations in vec_fun.cpp. Everything else uses the
+ * scalar templates below. Sums are always accumulated in double.
+ */
+
+/**
+ * @return sum of in[0..n)
+ */
+double vec_sum(const float*in, size_t n);
+double vec_sum(const double*in, size_t n);
+template <typename T>
+double vec_sum(const T*in, size_t n) {
+    double s = 0.;
+    for (size_t k = 0; k < n; ++k) s += in[k];
+    return s;
+}
+
+/**
+ * @return sum of (in[k]-shift)^2. Pass the mean (or any value near it) as shift to avoid cancellation.
+ */
+double vec_sumsq(const float*in, size_t n, double shift = 0.);
+double vec_sumsq(const double*in, size_t n, double shift = 0.);
+template <typename T>
+double vec_sumsq(const T*in, size_t n, double shift = 0.) {
+    double s = 0.;
+    for (size_t k = 0; k < n; ++k) {
+        const double x = in[k] - shift;
+        s += x*x;
+    }
+    return s;
+}
+
+/**
+ * @brief min and max of in[0..n). Unchanged if n=0. NaN is ignored unless it comes first.
+ */
+void vec_minmax(const float*in, size_t n, float & mn, float & mx);
+void vec_minmax(const double*in, size_t n, double & mn, double & mx);
+template <typename T>
+void vec_minmax(const T*in, size_t n, T & mn, T & mx) {
+    if (n == 0) return;
+    mn = mx = in[0];
+    for (size_t k = 1; k < n; ++k) {
+        if (in[k] < mn) mn = in[k];
+        if (in[k] > mx) mx = in[k];
+    }
+}
+
+/**
+ * @brief out[k] = in[k]*scale + offset, widened to double. in and out must not overlap.
+ */
+void vec_to_double(const float*in, size_t n, double*out, double scale = 1., double offset = 0.);
+void vec_to_double(const double*in, size_t n, double*out, double scale = 1., double offset = 0.);
+template <typename T>
+void vec_to_double(const T*in, size_t n, double*out, double scale = 1., double offset = 0.) {
+    for (size_t k = 0; k < n; ++k) out[k] = ((double)in[k])*scale + offset;
+}
+
+#endif // VEC_FUN_H